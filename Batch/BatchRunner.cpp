@@ -0,0 +1,1034 @@
+// Name: BatchRunner.cpp
+// Description: Streams a calculation script through the calculator.  The
+//				script is read in large blocks and each line is parsed in
+//				place, so there is no limit on line length and no per line
+//				prompt or flush.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "BatchRunner.h"
+#include "SpscRing.h"
+#include "../Engine/AffineScan.h"
+#include "../Engine/FpCheck.h"
+#include "../IO/BufferedIO.h"
+#include "../Metrics/Metrics.h"
+#include "../Parser/ExprCache.h"
+#include "../Parser/LineParser.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define cpu_Relax( ) _mm_pause( )
+#elif defined( __x86_64__ ) || defined( __i386__ )
+#define cpu_Relax( ) __builtin_ia32_pause( )
+#else
+#define cpu_Relax( ) ( (void) 0 )
+#endif
+
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define OPTIMIZE_BLOCK_OPERATIONS	( 1 << 16 )		// Operations optimized at a time in serial runs
+
+// Lines that aren't a plain "(operator) (value)" are compiled as
+// expressions through the cache.  Reports the line if that fails too.
+//	Returns:
+//		The compiled line, or NULL if it did not compile.
+//////////////////////////////////////////////////////////////////////////////
+static const Program* compile_Script_Line( const char* sLine, size_t iLength,
+										   unsigned long long iLineNumber,
+										   Calculator* const m_Calculator,
+										   ExprCache& oCache )
+{
+	CompileError oError;
+	const Program* pProgram = oCache.compile( sLine, iLength, m_Calculator, oError );
+
+	if( pProgram == NULL )
+	{
+		METRIC_COUNT_FAILURE( METRIC_SOURCE_SCRIPT, oError.sMessage );
+		fprintf( stderr, "Line %llu, column %llu: %s.\n", iLineNumber,
+				 (unsigned long long) oError.iPosition + 1, oError.sMessage );
+	}
+
+	return pProgram;
+}
+
+// Turns a compiled line into the operation it applies, so it can be
+// journaled and replayed without the expression.
+static inline void to_Operation( const Program& oProgram, Calculator* const m_Calculator,
+								 Operation& oOperation )
+{
+	oOperation.cOpCode = oProgram.cOperator == BC_ASSIGN ? OP_CODE_SET : (unsigned char) oProgram.cOperator;
+	oOperation.dValue = m_Calculator->evaluate_Program( oProgram );
+}
+
+// Prints the expression cache counters to stderr.
+static void print_Cache_Stats( const ExprCache& oCache )
+{
+	ExprCacheStats oStats = oCache.get_Stats( );
+
+	fprintf( stderr, "expression cache: hits=%llu misses=%llu evictions=%llu failures=%llu "
+					 "entries=%llu bytes=%llu budget=%llu\n",
+			 oStats.iHits, oStats.iMisses, oStats.iEvictions, oStats.iFailures,
+			 (unsigned long long) oStats.iEntries, (unsigned long long) oStats.iBytes,
+			 (unsigned long long) oStats.iBudget );
+}
+
+// The optimizer's buffers and counters for a run.
+struct OptimizeState
+{
+	vector< Operation > vOptimized;
+	vector< Rewrite > vRewrites;
+	vector< unsigned long long > vLines;	// Script line of every pending operation, when reporting
+	unsigned long long iOperations;			// Operations before optimizing
+	unsigned long long iOptimized;			// Operations after optimizing
+	unsigned long long iRewrites;
+	unsigned long long iChanged;			// Rewrites that changed the working value's bits
+};
+
+// Prints whether a rewrite gave the same bits as the original, counting
+// the ones that didn't.
+static void report_Bits( double dOriginal, double dRewritten, OptimizeState& oOptimize )
+{
+	++oOptimize.iRewrites;
+
+	if( memcmp( &dOriginal, &dRewritten, sizeof( double ) ) == 0 )
+		fputs( ": same bits\n", stderr );
+	else
+	{
+		++oOptimize.iChanged;
+		fprintf( stderr, ": changed bits, %.17g instead of %.17g\n", dRewritten, dOriginal );
+	}
+}
+
+// Reports a rewrite of the operation stream on stderr, checked by running
+// the operations it replaced from the working value it actually saw.
+static void report_Rewrite( const vector< Operation >& vOperations, const Rewrite& oRewrite,
+							double dValue, OptimizeState& oOptimize )
+{
+	unsigned long long iFirstLine = oOptimize.vLines[ oRewrite.iFirst ];
+	unsigned long long iLastLine = oOptimize.vLines[ oRewrite.iFirst + oRewrite.iCount - 1 ];
+	double dOriginal = dValue;
+	double dRewritten = oRewrite.bRemoved ? dValue : apply_Pure( oOptimize.vOptimized[ oRewrite.iOutput ], dValue );
+
+	for( size_t i = 0; i < oRewrite.iCount; ++i )
+		dOriginal = apply_Pure( vOperations[ oRewrite.iFirst + i ], dOriginal );
+
+	if( iFirstLine == iLastLine )
+		fprintf( stderr, "optimizer: line %llu: ", iFirstLine );
+	else
+		fprintf( stderr, "optimizer: lines %llu-%llu: ", iFirstLine, iLastLine );
+
+	print_Operations( stderr, &vOperations[ oRewrite.iFirst ], oRewrite.iCount );
+	fputs( " -> ", stderr );
+
+	if( oRewrite.bRemoved )
+		fputs( "nothing", stderr );
+	else
+		print_Operations( stderr, &oOptimize.vOptimized[ oRewrite.iOutput ], 1 );
+
+	fputs( ", ", stderr );
+	print_Rewrite_Kinds( stderr, oRewrite.iKinds, oRewrite.bExact );
+	report_Bits( dOriginal, dRewritten, oOptimize );
+}
+
+// Reports what the optimizer did to an expression line on stderr, checked
+// against the line compiled as written from the current working value.
+static void report_Program_Rewrite( const char* sLine, size_t iLength, unsigned long long iLineNumber,
+									const Program& oProgram, const ProgramRewrite& oRewrite,
+									Calculator* const m_Calculator, OptimizeState& oOptimize )
+{
+	Program oOriginal;
+	CompileError oError;
+
+	if( !compile_Line( sLine, iLength, m_Calculator, oOriginal, oError ) )
+		return;
+
+	fprintf( stderr, "optimizer: line %llu: \"%.*s\", ", iLineNumber, (int) iLength, sLine );
+	print_Rewrite_Kinds( stderr, oRewrite.iKinds, oRewrite.bExact );
+	report_Bits( m_Calculator->evaluate_Program( oOriginal ), m_Calculator->evaluate_Program( oProgram ), oOptimize );
+}
+
+// Evaluates the operations collected so far with the parallel scan
+// evaluator, journals them and writes out their working values.  With the
+// optimizer on they are rewritten first; a run that reports the rewrites
+// is evaluated serially so each can be checked where it applies.
+//////////////////////////////////////////////////////////////////////////////
+static void flush_Pending( AffineScan& oScan, vector< Operation >& vOperations,
+						   vector< double >& vValues, BufferedWriter& oWriter,
+						   const BatchOptions& oOptions,
+						   Calculator* const m_Calculator,
+						   OptimizeState& oOptimize )
+{
+	const vector< Operation >* pRun = &vOperations;
+	size_t iNext = 0;
+
+	if( oOptions.eOptimize != OPTIMIZE_OFF )
+	{
+		optimize_Operations( vOperations.data( ), vOperations.size( ), oOptions.eOptimize,
+							 oOptimize.vOptimized, oOptimize.vRewrites );
+		oOptimize.iOperations += vOperations.size( );
+		oOptimize.iOptimized += oOptimize.vOptimized.size( );
+		pRun = &oOptimize.vOptimized;
+	}
+
+	if( oOptions.bOptimizeReport )
+	{
+		for( size_t i = 0; i <= pRun->size( ); ++i )
+		{
+			for( ; iNext < oOptimize.vRewrites.size( ) && oOptimize.vRewrites[ iNext ].iOutput == i; ++iNext )
+				report_Rewrite( vOperations, oOptimize.vRewrites[ iNext ], m_Calculator->read_Value( ), oOptimize );
+
+			if( i < pRun->size( ) )
+				m_Calculator->apply_Operation( ( *pRun )[ i ] );
+		}
+	}
+	else if( oOptions.bFinalOnly )
+		oScan.evaluate( pRun->data( ), pRun->size( ), m_Calculator );
+	else
+	{
+		vValues.resize( pRun->size( ) );
+		oScan.evaluate_All( pRun->data( ), pRun->size( ), m_Calculator, vValues.data( ) );
+
+		for( size_t i = 0; i < vValues.size( ); ++i )
+		{
+			oWriter.write_Double( vValues[ i ] );
+			oWriter.write_Char( '\n' );
+		}
+	}
+
+	if( oOptions.pJournal != NULL )
+		oOptions.pJournal->append( pRun->data( ), pRun->size( ) );
+
+	vOperations.clear( );
+	oOptimize.vLines.clear( );
+}
+
+// Parses the script up front and evaluates the operation stream with the
+// parallel scan evaluator.  Expressions with a constant operand are folded
+// into plain operations; any other expression, and any line using a
+// variable, is run serially between the parallel runs so the journal
+// records it with the values it saw.  The floating-point exception flags raised on the
+// evaluator's threads are returned in iFpFlags.  Optimized runs go through
+// here too, with the scan kept serial unless bParallel is set, since the
+// optimizer works on the same stream.
+//	Returns:
+//		The number of lines that could not be parsed.
+//////////////////////////////////////////////////////////////////////////////
+static unsigned long long run_Parallel( BufferedReader& oReader,
+										BufferedWriter& oWriter,
+										ExprCache& oCache,
+										const BatchOptions& oOptions,
+										Calculator* const m_Calculator,
+										int& iFpFlags )
+{
+	vector< Operation > vOperations;
+	vector< double > vValues;
+	char* sLine = NULL;
+	size_t iLength = 0;
+	unsigned long long iLineNumber = 0;
+	unsigned long long iErrorCount = 0;
+	Operation oOperation;
+	const Program* pProgram = NULL;
+	ProgramRewrite oRewrite = { 0, true };
+	eLineType eType = LINE_BLANK;
+	AffineScan oScan( oOptions.iThreadCount, oOptions.bParallel ? AFFINE_SCAN_MIN_PARALLEL : SIZE_MAX );
+	OptimizeState oOptimize;
+
+	oOptimize.iOperations = oOptimize.iOptimized = oOptimize.iRewrites = oOptimize.iChanged = 0;
+
+	while( eType != LINE_QUIT && oReader.next_Line( sLine, iLength ) )
+	{
+		++iLineNumber;
+		eType = parse_Line( sLine, iLength, m_Calculator, oOperation );
+		pProgram = NULL;
+
+		if( eType == LINE_INVALID &&
+			( pProgram = compile_Script_Line( sLine, iLength, iLineNumber, m_Calculator, oCache ) ) != NULL )
+			oRewrite = oCache.get_Rewrite( );
+
+		if( eType == LINE_OPERATION && !op_TouchesVar( oOperation.cOpCode ) )
+			vOperations.push_back( oOperation );
+		else if( eType != LINE_OPERATION && eType != LINE_INVALID )
+			continue;
+		else if( eType == LINE_INVALID && pProgram == NULL )
+		{
+			++iErrorCount;
+			continue;
+		}
+		else if( pProgram != NULL && !pProgram->bReadsState )
+		{
+			if( oOptions.bOptimizeReport && oRewrite.iKinds != 0 )
+				report_Program_Rewrite( sLine, iLength, iLineNumber, *pProgram, oRewrite, m_Calculator, oOptimize );
+
+			to_Operation( *pProgram, m_Calculator, oOperation );
+			vOperations.push_back( oOperation );
+		}
+		else
+		{
+			flush_Pending( oScan, vOperations, vValues, oWriter, oOptions, m_Calculator, oOptimize );
+
+			if( pProgram != NULL && oOptions.bOptimizeReport && oRewrite.iKinds != 0 )
+				report_Program_Rewrite( sLine, iLength, iLineNumber, *pProgram, oRewrite, m_Calculator, oOptimize );
+
+			if( pProgram != NULL )
+				to_Operation( *pProgram, m_Calculator, oOperation );
+
+			m_Calculator->apply_Operation( oOperation );
+
+			if( oOptions.pJournal != NULL )
+				oOptions.pJournal->append( oOperation );
+
+			if( !oOptions.bFinalOnly )
+			{
+				oWriter.write_Double( m_Calculator->read_Value( ) );
+				oWriter.write_Char( '\n' );
+			}
+
+			continue;
+		}
+
+		// The line went into vOperations.
+		if( oOptions.bOptimizeReport )
+			oOptimize.vLines.push_back( iLineNumber );
+
+		// Serial runs only need the stream for the optimizer, a block at a time.
+		if( !oOptions.bParallel && vOperations.size( ) >= OPTIMIZE_BLOCK_OPERATIONS )
+			flush_Pending( oScan, vOperations, vValues, oWriter, oOptions, m_Calculator, oOptimize );
+	}
+
+	flush_Pending( oScan, vOperations, vValues, oWriter, oOptions, m_Calculator, oOptimize );
+	iFpFlags = oScan.get_Fp_Flags( );
+
+	if( oOptions.bOptimizeReport )
+		fprintf( stderr, "optimizer: %llu operations rewritten to %llu, %llu rewrites, %llu changed bits\n",
+				 oOptimize.iOperations, oOptimize.iOptimized, oOptimize.iRewrites, oOptimize.iChanged );
+
+	return iErrorCount;
+}
+
+/*********************************************************************\
+ *	Pipelined Mode													 *
+\*********************************************************************/
+
+/////////////
+// Defines //
+/////////////
+#define PIPELINE_SPIN_COUNT		256		// Spins before a waiting stage yields
+#define PIPELINE_RUN_PROGRAM	0		// Op code: run the batch's next program
+
+// A block of raw script text on its way from the reader to the parser.
+struct InputChunk
+{
+	char* pData;
+	size_t iSize;
+};
+
+// Decoded operations on their way from the parser to the evaluator.
+// Lines that read the working value or memory can't be decoded ahead of
+// time; they travel as programs, marked by PIPELINE_RUN_PROGRAM.  The
+// programs stay in the expression cache, pinned there until the batch
+// comes back to the parser.
+struct OperationBatch
+{
+	vector< Operation > vOperations;
+	vector< const Program* > vPrograms;
+	vector< int > vPins;				// ExprCache::pin_Last of every program
+};
+
+// How long a stage spent waiting on its neighbours.  Starved means its
+// input ring was empty, blocked means its output ring was full.
+struct StageStats
+{
+	unsigned long long iItems;
+	unsigned long long iStarved;
+	unsigned long long iBlocked;
+	unsigned long long iStarvedNanoseconds;
+	unsigned long long iBlockedNanoseconds;
+};
+
+// Everything the three stages share.
+struct Pipeline
+{
+	Pipeline( unsigned int iDepth )
+		: oFullChunks( iDepth ), oFreeChunks( iDepth ),
+		  oFullBatches( iDepth ), oFreeBatches( iDepth )
+	{
+		bStop = false;
+		iFpFlags = 0;
+		memset( &oReaderStats, 0, sizeof( oReaderStats ) );
+		memset( &oParserStats, 0, sizeof( oParserStats ) );
+		memset( &oEvaluatorStats, 0, sizeof( oEvaluatorStats ) );
+	}
+
+	SpscRing< InputChunk* > oFullChunks;		// reader -> parser, NULL ends the input
+	SpscRing< InputChunk* > oFreeChunks;		// parser -> reader
+	SpscRing< OperationBatch* > oFullBatches;	// parser -> evaluator, NULL ends the input
+	SpscRing< OperationBatch* > oFreeBatches;	// evaluator -> parser
+	atomic< bool > bStop;						// Parser hit "q", reader can stop early
+	int iFpFlags;								// Floating-point flags the evaluator raised
+	StageStats oReaderStats;
+	StageStats oParserStats;
+	StageStats oEvaluatorStats;
+};
+
+// Pushes onto a ring, waiting while it is full.  Counts the stall.
+//	Returns:
+//		False if bStop was raised while waiting.
+//////////////////////////////////////////////////////////////////////
+template< class T >
+static bool push_Wait( SpscRing< T >& oRing, const T& oValue, StageStats& oStats,
+					   const atomic< bool >* pStop = NULL )
+{
+	chrono::steady_clock::time_point oStart;
+
+	if( oRing.try_Push( oValue ) )
+		return true;
+
+	++oStats.iBlocked;
+	oStart = chrono::steady_clock::now( );
+
+	for( unsigned int iSpins = 0; !oRing.try_Push( oValue ); ++iSpins )
+	{
+		if( pStop != NULL && pStop->load( memory_order_relaxed ) )
+			return false;
+
+		if( iSpins < PIPELINE_SPIN_COUNT )
+			cpu_Relax( );
+		else
+			this_thread::yield( );
+	}
+
+	oStats.iBlockedNanoseconds += (unsigned long long)
+		chrono::duration_cast< chrono::nanoseconds >( chrono::steady_clock::now( ) - oStart ).count( );
+	return true;
+}
+
+// Pops from a ring, waiting while it is empty.  Counts the stall.
+//	Returns:
+//		False if bStop was raised while waiting.
+//////////////////////////////////////////////////////////////////////
+template< class T >
+static bool pop_Wait( SpscRing< T >& oRing, T& oValue, StageStats& oStats, bool bStarved,
+					  const atomic< bool >* pStop = NULL )
+{
+	chrono::steady_clock::time_point oStart;
+
+	if( oRing.try_Pop( oValue ) )
+		return true;
+
+	// Waiting on a free buffer means the next stage is behind: blocked.
+	++( bStarved ? oStats.iStarved : oStats.iBlocked );
+	oStart = chrono::steady_clock::now( );
+
+	for( unsigned int iSpins = 0; !oRing.try_Pop( oValue ); ++iSpins )
+	{
+		if( pStop != NULL && pStop->load( memory_order_relaxed ) )
+			return false;
+
+		if( iSpins < PIPELINE_SPIN_COUNT )
+			cpu_Relax( );
+		else
+			this_thread::yield( );
+	}
+
+	( bStarved ? oStats.iStarvedNanoseconds : oStats.iBlockedNanoseconds ) += (unsigned long long)
+		chrono::duration_cast< chrono::nanoseconds >( chrono::steady_clock::now( ) - oStart ).count( );
+	return true;
+}
+
+// Reader stage: fills free chunks with raw script text.
+static void run_Reader( Pipeline& oPipeline, BufferedReader& oReader )
+{
+	InputChunk* pChunk = NULL;
+
+	while( pop_Wait( oPipeline.oFreeChunks, pChunk, oPipeline.oReaderStats, false, &oPipeline.bStop ) )
+	{
+		pChunk->iSize = oReader.read_Block( pChunk->pData, PIPELINE_READ_SIZE );
+
+		// The parser alone pushes onto oFreeChunks, so the last chunk is
+		// simply dropped.
+		if( pChunk->iSize == 0 )
+			break;
+
+		++oPipeline.oReaderStats.iItems;
+
+		if( !push_Wait( oPipeline.oFullChunks, pChunk, oPipeline.oReaderStats, &oPipeline.bStop ) )
+			return;
+	}
+
+	push_Wait( oPipeline.oFullChunks, (InputChunk*) NULL, oPipeline.oReaderStats, &oPipeline.bStop );
+}
+
+// Releases the programs of a batch the evaluator is done with and empties
+// it for the parser to fill again.
+static void recycle_Batch( OperationBatch* pBatch, ExprCache& oCache )
+{
+	for( size_t i = 0; i < pBatch->vPins.size( ); ++i )
+		oCache.unpin( pBatch->vPins[ i ] );
+
+	pBatch->vOperations.clear( );
+	pBatch->vPrograms.clear( );
+	pBatch->vPins.clear( );
+}
+
+// State the parser keeps between lines.
+struct ParserState
+{
+	OperationBatch* pBatch;
+	unsigned long long iLineNumber;
+	unsigned long long iErrorCount;
+	bool bQuit;
+};
+
+// Parser stage, one line: decodes it into the current batch, handing the
+// batch on once it is full.  Variables are resolved and lines that don't
+// read the calculator's state are folded on pParser, the parser's own
+// calculator, since the evaluator is changing the real one.
+static void parse_Pipeline_Line( char* sLine, size_t iLength, Pipeline& oPipeline, ParserState& oState,
+								 ExprCache& oCache, const BatchOptions& oOptions,
+								 Calculator* const pParser )
+{
+	OperationBatch* pBatch = oState.pBatch;
+	const Program* pProgram = NULL;
+	Operation oOperation;
+
+	++oState.iLineNumber;
+
+	if( iLength > 0 && sLine[ iLength - 1 ] == '\r' )
+		sLine[ --iLength ] = '\0';
+
+	switch( parse_Line( sLine, iLength, pParser, oOperation ) )
+	{
+	case LINE_OPERATION:
+		pBatch->vOperations.push_back( oOperation );
+		break;
+	case LINE_QUIT:
+		oState.bQuit = true;
+		return;
+	case LINE_INVALID:
+		pProgram = compile_Script_Line( sLine, iLength, oState.iLineNumber, pParser, oCache );
+
+		if( pProgram == NULL )
+		{
+			++oState.iErrorCount;
+			return;
+		}
+
+		if( !pProgram->bReadsState )
+			to_Operation( *pProgram, pParser, oOperation );
+		else
+		{
+			oOperation.cOpCode = PIPELINE_RUN_PROGRAM;
+			pBatch->vPrograms.push_back( pProgram );
+			pBatch->vPins.push_back( oCache.pin_Last( ) );
+		}
+
+		pBatch->vOperations.push_back( oOperation );
+		break;
+	case LINE_BLANK:
+	default:
+		return;
+	}
+
+	if( pBatch->vOperations.size( ) >= oOptions.iBatchSize )
+	{
+		++oPipeline.oParserStats.iItems;
+		push_Wait( oPipeline.oFullBatches, pBatch, oPipeline.oParserStats );
+		pop_Wait( oPipeline.oFreeBatches, oState.pBatch, oPipeline.oParserStats, false );
+		recycle_Batch( oState.pBatch, oCache );
+	}
+}
+
+// Parser stage: splits chunks into lines and decodes them.  A line cut in
+// two by a chunk boundary is put back together in sCarry.
+//	Returns:
+//		The number of lines that could not be parsed.
+//////////////////////////////////////////////////////////////////////
+static unsigned long long run_Parser( Pipeline& oPipeline, ExprCache& oCache,
+									  const BatchOptions& oOptions,
+									  Calculator* const pParser )
+{
+	ParserState oState = { NULL, 0, 0, false };
+	InputChunk* pChunk = NULL;
+	string sCarry;
+
+	pop_Wait( oPipeline.oFreeBatches, oState.pBatch, oPipeline.oParserStats, false );
+
+	while( !oState.bQuit && pop_Wait( oPipeline.oFullChunks, pChunk, oPipeline.oParserStats, true ) &&
+		   pChunk != NULL )
+	{
+		char* pStart = pChunk->pData;
+		char* pEnd = pChunk->pData + pChunk->iSize;
+		char* pNewline = NULL;
+
+		while( !oState.bQuit && ( pNewline = (char*) memchr( pStart, '\n', (size_t)( pEnd - pStart ) ) ) != NULL )
+		{
+			*pNewline = '\0';
+
+			if( sCarry.empty( ) )
+				parse_Pipeline_Line( pStart, (size_t)( pNewline - pStart ), oPipeline, oState,
+									 oCache, oOptions, pParser );
+			else
+			{
+				sCarry.append( pStart, (size_t)( pNewline - pStart ) );
+				parse_Pipeline_Line( &sCarry[ 0 ], sCarry.size( ), oPipeline, oState,
+									 oCache, oOptions, pParser );
+				sCarry.clear( );
+			}
+
+			pStart = pNewline + 1;
+		}
+
+		sCarry.append( pStart, (size_t)( pEnd - pStart ) );
+		push_Wait( oPipeline.oFreeChunks, pChunk, oPipeline.oParserStats );
+	}
+
+	// The last line may not end in a newline.
+	if( !oState.bQuit && !sCarry.empty( ) )
+		parse_Pipeline_Line( &sCarry[ 0 ], sCarry.size( ), oPipeline, oState,
+							 oCache, oOptions, pParser );
+
+	if( oState.bQuit )
+		oPipeline.bStop.store( true, memory_order_relaxed );
+
+	if( !oState.pBatch->vOperations.empty( ) )
+	{
+		++oPipeline.oParserStats.iItems;
+		push_Wait( oPipeline.oFullBatches, oState.pBatch, oPipeline.oParserStats );
+	}
+	else
+		oPipeline.oFreeBatches.try_Push( oState.pBatch );
+
+	push_Wait( oPipeline.oFullBatches, (OperationBatch*) NULL, oPipeline.oParserStats );
+
+	return oState.iErrorCount;
+}
+
+// Evaluator stage: applies every batch to the calculator in order.  The
+// floating-point flags it raised are left in the pipeline for the caller.
+static void run_Evaluator( Pipeline& oPipeline, BufferedWriter& oWriter,
+						   const BatchOptions& oOptions,
+						   Calculator* const m_Calculator )
+{
+	OperationBatch* pBatch = NULL;
+
+	clear_Fp_Flags( );
+
+	while( pop_Wait( oPipeline.oFullBatches, pBatch, oPipeline.oEvaluatorStats, true ) && pBatch != NULL )
+	{
+		size_t iProgram = 0;
+
+		for( size_t i = 0; i < pBatch->vOperations.size( ); ++i )
+		{
+			Operation& oOperation = pBatch->vOperations[ i ];
+
+			if( oOperation.cOpCode == PIPELINE_RUN_PROGRAM )
+				to_Operation( *pBatch->vPrograms[ iProgram++ ], m_Calculator, oOperation );
+
+			m_Calculator->apply_Operation( oOperation );
+
+			if( oOptions.pJournal != NULL )
+				oOptions.pJournal->append( oOperation );
+
+			if( !oOptions.bFinalOnly )
+			{
+				oWriter.write_Double( m_Calculator->read_Value( ) );
+				oWriter.write_Char( '\n' );
+			}
+		}
+
+		++oPipeline.oEvaluatorStats.iItems;
+		push_Wait( oPipeline.oFreeBatches, pBatch, oPipeline.oEvaluatorStats );
+	}
+
+	oPipeline.iFpFlags = test_Fp_Flags( );
+}
+
+// Interns oFrom's variables from slot iFirst on into pTo, which must
+// already hold the ones before it, so every name keeps its slot.
+static void copy_Variables( const Calculator& oFrom, Calculator* const pTo, unsigned int iFirst )
+{
+	const VariableTable& oVariables = oFrom.get_Variables( );
+
+	for( unsigned int iSlot = iFirst; iSlot < oVariables.size( ); ++iSlot )
+	{
+		const char* sName = oVariables.get_Name( iSlot );
+
+		pTo->intern_Variable( sName, strlen( sName ) );
+	}
+}
+
+// Prints one stage's stall counters.
+static void print_Stage_Stats( const char* sStage, const char* sItems, const StageStats& oStats )
+{
+	fprintf( stderr, "  %-9s %s=%llu starved=%llu (%.1f ms) blocked=%llu (%.1f ms)\n",
+			 sStage, sItems, oStats.iItems,
+			 oStats.iStarved, oStats.iStarvedNanoseconds / 1e6,
+			 oStats.iBlocked, oStats.iBlockedNanoseconds / 1e6 );
+}
+
+// Runs the script through three threads: a reader filling large buffers,
+// a parser decoding them into batches of operations, and an evaluator
+// applying the batches.  Stages hand buffers on and back through pairs of
+// lock-free rings, so the only thing that ever waits is a stage with
+// nothing to do.  Lines go through the calculator in script order, so the
+// output is the same as run_Serial's.  The floating-point exception
+// flags raised on the evaluator thread are returned in iFpFlags.
+//	Returns:
+//		The number of lines that could not be parsed.
+//////////////////////////////////////////////////////////////////////////////
+static unsigned long long run_Pipelined( BufferedReader& oReader,
+										 BufferedWriter& oWriter,
+										 ExprCache& oCache,
+										 const BatchOptions& oOptions,
+										 Calculator* const m_Calculator,
+										 int& iFpFlags )
+{
+	unsigned int iDepth = oOptions.iPipelineDepth > 1 ? oOptions.iPipelineDepth : 2;
+	Pipeline oPipeline( iDepth );
+	vector< InputChunk > vChunks( iDepth );
+	vector< char > vChunkData( (size_t) iDepth * PIPELINE_READ_SIZE );
+	vector< OperationBatch > vBatches( iDepth );
+	unsigned long long iErrorCount = 0;
+
+	for( unsigned int i = 0; i < iDepth; ++i )
+	{
+		vChunks[ i ].pData = vChunkData.data( ) + (size_t) i * PIPELINE_READ_SIZE;
+		vChunks[ i ].iSize = 0;
+		oPipeline.oFreeChunks.try_Push( &vChunks[ i ] );
+
+		vBatches[ i ].vOperations.reserve( oOptions.iBatchSize );
+		oPipeline.oFreeBatches.try_Push( &vBatches[ i ] );
+	}
+
+	// The parser works on a calculator of its own holding a copy of the
+	// variable names, so slots come out the same as they would in this
+	// one; the evaluator alone touches this one.  Names the script added
+	// are copied back once the threads are done.
+	Calculator oParser;
+	unsigned int iKnownVariables = m_Calculator->get_Variables( ).size( );
+
+	copy_Variables( *m_Calculator, &oParser, VARIABLE_MEMORY_SLOT + 1 );
+
+	thread oReaderThread( run_Reader, ref( oPipeline ), ref( oReader ) );
+	thread oEvaluatorThread( run_Evaluator, ref( oPipeline ), ref( oWriter ),
+							 cref( oOptions ), m_Calculator );
+
+	iErrorCount = run_Parser( oPipeline, oCache, oOptions, &oParser );
+
+	oEvaluatorThread.join( );
+	oReaderThread.join( );
+	iFpFlags = oPipeline.iFpFlags;
+
+	copy_Variables( oParser, m_Calculator, iKnownVariables );
+
+	for( unsigned int i = 0; i < iDepth; ++i )
+		recycle_Batch( &vBatches[ i ], oCache );
+
+	if( oOptions.bPipelineStats )
+	{
+		fprintf( stderr, "pipeline: depth=%u batch=%llu\n", iDepth, (unsigned long long) oOptions.iBatchSize );
+		print_Stage_Stats( "reader", "chunks", oPipeline.oReaderStats );
+		print_Stage_Stats( "parser", "batches", oPipeline.oParserStats );
+		print_Stage_Stats( "evaluator", "batches", oPipeline.oEvaluatorStats );
+	}
+
+	return iErrorCount;
+}
+
+// Applies every line of the script as soon as it is read.
+//	Returns:
+//		The number of lines that could not be parsed.
+//////////////////////////////////////////////////////////////////////////////
+static unsigned long long run_Serial( BufferedReader& oReader,
+									  BufferedWriter& oWriter,
+									  ExprCache& oCache,
+									  const BatchOptions& oOptions,
+									  Calculator* const m_Calculator )
+{
+	char* sLine = NULL;
+	size_t iLength = 0;
+	unsigned long long iLineNumber = 0;
+	unsigned long long iErrorCount = 0;
+	Operation oOperation;
+	const Program* pProgram = NULL;
+	bool bQuit = false;
+
+	while( !bQuit && oReader.next_Line( sLine, iLength ) )
+	{
+		++iLineNumber;
+
+		switch( parse_Line( sLine, iLength, m_Calculator, oOperation ) )
+		{
+		case LINE_OPERATION:
+			m_Calculator->apply_Operation( oOperation );
+
+			if( oOptions.pJournal != NULL )
+				oOptions.pJournal->append( oOperation );
+
+			if( !oOptions.bFinalOnly )
+			{
+				oWriter.write_Double( m_Calculator->read_Value( ) );
+				oWriter.write_Char( '\n' );
+			}
+			break;
+		case LINE_QUIT:
+			bQuit = true;
+			break;
+		case LINE_INVALID:
+			pProgram = compile_Script_Line( sLine, iLength, iLineNumber, m_Calculator, oCache );
+
+			if( pProgram == NULL )
+			{
+				++iErrorCount;
+				break;
+			}
+
+			to_Operation( *pProgram, m_Calculator, oOperation );
+			m_Calculator->apply_Operation( oOperation );
+
+			if( oOptions.pJournal != NULL )
+				oOptions.pJournal->append( oOperation );
+
+			if( !oOptions.bFinalOnly )
+			{
+				oWriter.write_Double( m_Calculator->read_Value( ) );
+				oWriter.write_Char( '\n' );
+			}
+			break;
+		case LINE_BLANK:
+		default:
+			break;
+		}
+	}
+
+	return iErrorCount;
+}
+
+// Goes over a script that raised a floating-point exception again, one
+// line at a time from the value and variables it started with, testing the
+// flags after every line to find the first one that raised it.  Nothing is
+// printed or journaled and parse errors aren't reported a second time.
+// Expressions are compiled again so flags raised while folding constants
+// are seen too.
+//	Parameters:
+//		pScript : FILE - The script, read again from the start.
+//		oFrom : Calculator - The calculator the script ran on, for the
+//							 names of the variables it started with.
+//		dValue : double - Working value to start from.
+//		vRegisters : vector - The register file to start from, by slot,
+//							  the memory first.
+//		iFpFlags : int - Flags the full run raised, for the message if the
+//						 script can't be read again.
+//	Returns:
+//		True if no line raises a flag when run serially, as when a
+//		reordering in the parallel evaluator overflowed.  False, with the
+//		line reported, otherwise.
+//////////////////////////////////////////////////////////////////////////////
+static bool check_Script( FILE* pScript, const BatchOptions& oOptions, const Calculator& oFrom,
+						  double dValue, const vector< double >& vRegisters, int iFpFlags )
+{
+	char* sLine = NULL;
+	size_t iLength = 0;
+	size_t iColumn = 0;
+	unsigned long long iLineNumber = 0;
+	Operation oOperation;
+	CompileError oError;
+	const Program* pProgram = NULL;
+	Calculator oCalculator;
+	eLineType eType = LINE_BLANK;
+
+	if( fseek( pScript, 0, SEEK_SET ) != 0 )
+	{
+		METRIC_COUNT_FAILURE( METRIC_SOURCE_SCRIPT, get_Fp_Error( iFpFlags ) );
+		fprintf( stderr, "Script rejected: %s, and the script can't be read again to find the line.\n",
+				 get_Fp_Error( iFpFlags ) );
+		return false;
+	}
+
+	clearerr( pScript );
+
+	BufferedReader oReader( pScript );
+	ExprCache oCache( oOptions.iCacheBudget );
+
+	// The variables get the slots they had, so every line compiles and
+	// reads the same as it did in the run.
+	for( unsigned int iSlot = VARIABLE_MEMORY_SLOT + 1; iSlot < vRegisters.size( ); ++iSlot )
+	{
+		const char* sName = oFrom.get_Variables( ).get_Name( iSlot );
+
+		oCalculator.intern_Variable( sName, strlen( sName ) );
+	}
+
+	for( unsigned int iSlot = 0; iSlot < vRegisters.size( ); ++iSlot )
+		oCalculator.set_Var( iSlot, vRegisters[ iSlot ] );
+
+	oCalculator.set_Value( dValue );
+	clear_Fp_Flags( );
+
+	while( eType != LINE_QUIT && oReader.next_Line( sLine, iLength ) )
+	{
+		++iLineNumber;
+		eType = parse_Line( sLine, iLength, &oCalculator, oOperation );
+
+		if( eType == LINE_OPERATION )
+			oCalculator.apply_Operation( oOperation );
+		else if( eType != LINE_INVALID )
+			continue;
+		else if( ( pProgram = oCache.compile( sLine, iLength, &oCalculator, oError ) ) == NULL )
+			continue;
+		else
+		{
+			to_Operation( *pProgram, &oCalculator, oOperation );
+			oCalculator.apply_Operation( oOperation );
+		}
+
+		if( ( iFpFlags = test_Fp_Flags( ) ) != 0 )
+		{
+			while( iColumn < iLength && ( sLine[ iColumn ] == ' ' || sLine[ iColumn ] == '\t' ) )
+				++iColumn;
+
+			METRIC_COUNT_FAILURE( METRIC_SOURCE_SCRIPT, get_Fp_Error( iFpFlags ) );
+			fprintf( stderr, "Line %llu, column %llu: %s.\n", iLineNumber,
+					 (unsigned long long) iColumn + 1, get_Fp_Error( iFpFlags ) );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Sets every option to its default, see BatchRunner.h.
+BatchOptions::BatchOptions( )
+{
+	sScriptPath = NULL;
+	bFinalOnly = false;
+	bParallel = false;
+	iThreadCount = 0;
+	iCacheBudget = EXPR_CACHE_DEFAULT_BUDGET;
+	bCacheStats = false;
+	pOutput = NULL;
+	pJournal = NULL;
+	bPipelined = false;
+	iPipelineDepth = PIPELINE_DEFAULT_DEPTH;
+	iBatchSize = PIPELINE_DEFAULT_BATCH;
+	bPipelineStats = false;
+	bChecked = false;
+	eOptimize = OPTIMIZE_OFF;
+	bOptimizeReport = false;
+}
+
+// Runs a calculation script, printing the working value after every
+// applied line, or only once at the end.
+//
+// A checked run clears the floating-point exception flags first and tests
+// them once at the end, so the run itself goes at full speed.  If one was
+// raised, check_Script finds the line; the calculator's value, memory and
+// variables are then put back the way they were and the final value isn't
+// printed, but values printed along the way can't be taken back.  Names
+// the script added stay known, reading 0 as if never stored.
+//	Parameters:
+//		oOptions : BatchOptions - Where to read from and what to print.
+//		m_Calculator : Calculator - Calculator to apply the script to.
+//	Returns:
+//		0 on success, 1 if any line could not be parsed, a checked script
+//		raised a floating-point exception, or the script could not be read.
+//////////////////////////////////////////////////////////////////////////////
+int run_Batch( const BatchOptions& oOptions, Calculator* const m_Calculator )
+{
+	FILE* pScript = stdin;
+	unsigned long long iErrorCount = 0;
+	double dStartValue = m_Calculator->read_Value( );
+	vector< double > vStartRegisters;
+	int iFpFlags = 0;
+	bool bRejected = false;
+
+	if( oOptions.sScriptPath != NULL )
+	{
+		pScript = fopen( oOptions.sScriptPath, "rb" );
+
+		if( pScript == NULL )
+		{
+			fprintf( stderr, "Unable to open script \"%s\".\n", oOptions.sScriptPath );
+			return 1;
+		}
+	}
+
+	BufferedReader oReader( pScript );
+	BufferedWriter oWriter( oOptions.pOutput != NULL ? oOptions.pOutput : stdout );
+	ExprCache oCache( oOptions.iCacheBudget );
+
+	if( oOptions.bChecked )
+	{
+		vStartRegisters.resize( m_Calculator->get_Variables( ).size( ) );
+
+		for( unsigned int iSlot = 0; iSlot < vStartRegisters.size( ); ++iSlot )
+			vStartRegisters[ iSlot ] = m_Calculator->pull_Var( iSlot );
+
+		clear_Fp_Flags( );
+	}
+
+	oCache.set_Optimizer( oOptions.eOptimize );
+
+	if( oOptions.bParallel || oOptions.eOptimize != OPTIMIZE_OFF )
+		iErrorCount = run_Parallel( oReader, oWriter, oCache, oOptions, m_Calculator, iFpFlags );
+	else if( oOptions.bPipelined )
+		iErrorCount = run_Pipelined( oReader, oWriter, oCache, oOptions, m_Calculator, iFpFlags );
+	else
+		iErrorCount = run_Serial( oReader, oWriter, oCache, oOptions, m_Calculator );
+
+	if( oOptions.bChecked )
+		iFpFlags |= test_Fp_Flags( );
+
+	if( oOptions.bChecked && iFpFlags != 0 &&
+		!check_Script( pScript, oOptions, *m_Calculator, dStartValue, vStartRegisters, iFpFlags ) )
+	{
+		for( unsigned int iSlot = 0; iSlot < m_Calculator->get_Variables( ).size( ); ++iSlot )
+			m_Calculator->set_Var( iSlot, iSlot < vStartRegisters.size( ) ? vStartRegisters[ iSlot ] : 0.0 );
+
+		m_Calculator->set_Value( dStartValue );
+		bRejected = true;
+		++iErrorCount;
+	}
+
+	if( oOptions.bCacheStats )
+		print_Cache_Stats( oCache );
+
+	if( oReader.failed( ) )
+	{
+		fprintf( stderr, "Error reading script.\n" );
+		++iErrorCount;
+	}
+
+	if( oOptions.pJournal != NULL && !oOptions.pJournal->commit( ) )
+	{
+		fprintf( stderr, "Journal failed: %s.\n", oOptions.pJournal->get_Error( ) );
+		++iErrorCount;
+	}
+
+	if( oOptions.bFinalOnly && !bRejected )
+	{
+		oWriter.write_Double( m_Calculator->read_Value( ) );
+		oWriter.write_Char( '\n' );
+	}
+
+	oWriter.flush( );
+
+	if( pScript != stdin )
+		fclose( pScript );
+
+	return iErrorCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+#ifndef _BATCHRUNNER_H
+#define _BATCHRUNNER_H
+
+// Name: BatchRunner.h
+// Description: Non-interactive mode that streams a calculation script
+//				through a Calculator without any prompts.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "../Calculator/Calculator.h"
+#include "../Calculator/Optimizer.h"
+#include "../IO/Journal.h"
+#include <cstddef>
+#include <cstdio>
+
+/////////////
+// Defines //
+/////////////
+#define PIPELINE_DEFAULT_DEPTH	8			// Buffers in flight between two stages
+#define PIPELINE_DEFAULT_BATCH	4096		// Operations per batch handed to the evaluator
+#define PIPELINE_READ_SIZE		( 1 << 18 )	// Bytes per buffer handed to the parser
+
+// Options for a batch run.  A default constructed one reads stdin and
+// prints every working value, serially, with nothing extra.
+struct BatchOptions
+{
+	const char* sScriptPath;	// Script to read, NULL for stdin
+	bool bFinalOnly;			// Only print the final working value
+	bool bParallel;				// Evaluate with the parallel scan evaluator
+	unsigned int iThreadCount;	// Threads for the parallel evaluator, 0 for all cores
+	size_t iCacheBudget;		// Memory budget for compiled expressions, in bytes
+	bool bCacheStats;			// Print the expression cache counters when done
+	FILE* pOutput;				// Where to print working values, NULL for stdout
+	Journal* pJournal;			// Journal to record applied operations in, NULL for none
+	bool bPipelined;			// Read, parse and evaluate on three threads
+	unsigned int iPipelineDepth;	// Buffers in flight between pipeline stages
+	size_t iBatchSize;			// Operations per batch between parser and evaluator
+	bool bPipelineStats;		// Print the pipeline stall counters when done
+	bool bChecked;				// Reject the script if it raises a floating-point exception
+	eOptimizeLevel eOptimize;	// Rewrite the script's operations before running them
+	bool bOptimizeReport;		// Print every rewrite and whether it changed the result
+
+	BatchOptions( );
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+int run_Batch( const BatchOptions& oOptions, Calculator* const m_Calculator );
+
+#endif
@@ -0,0 +1,202 @@
+// Name: CellRunner.cpp
+// Description: Streams a cell script into a CellSheet.  Lines are:
+//					(name) = (expression)	- set the formula of a cell
+//					? (name)				- print the value of a cell
+//					q						- stop processing the script
+//				Blank lines and lines starting with '#' are ignored.
+//				Edits are recalculated together when a value is asked
+//				for or the script ends, so a run of edits costs one pass
+//				over what they affect.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "CellRunner.h"
+#include "../Engine/CellSheet.h"
+#include "../IO/BufferedIO.h"
+#include "../Metrics/Metrics.h"
+#include "../Parser/LineParser.h"
+#include "../Parser/Tokenizer.h"
+#include <chrono>
+#include <cstdio>
+
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define CELL_QUERY	'?'
+#define CELL_ASSIGN	'='
+
+// Reports a line that could not be parsed or applied.
+static void report_Line( unsigned long long iLineNumber, const CompileError& oError )
+{
+	METRIC_COUNT_FAILURE( METRIC_SOURCE_SCRIPT, oError.sMessage );
+	fprintf( stderr, "Line %llu, column %llu: %s.\n", iLineNumber,
+			 (unsigned long long) oError.iPosition + 1, oError.sMessage );
+}
+
+// Prints the sheet's counters to stderr.
+static void print_Cell_Stats( const CellSheet& oSheet, double dSeconds )
+{
+	const CellStats& oStats = oSheet.get_Stats( );
+
+	fprintf( stderr, "cells: cells=%llu edits=%llu passes=%llu parallel=%llu evaluated=%llu "
+					 "steals=%llu (%.1f ms recalculating)\n",
+			 (unsigned long long) oSheet.get_Cell_Count( ), oStats.iEdits, oStats.iPasses,
+			 oStats.iParallelPasses, oStats.iEvaluated, oSheet.get_Steals( ), dSeconds * 1000.0 );
+}
+
+// Applies one line of a cell script.
+//	Returns:
+//		LINE_OPERATION if the line edited or printed a cell, otherwise as
+//		parse_Line.  oError is set for LINE_INVALID.
+//////////////////////////////////////////////////////////////////////////////
+static eLineType run_Cell_Line( const char* sLine, size_t iLength, CellSheet& oSheet,
+								BufferedWriter& oWriter, double& dSeconds, CompileError& oError )
+{
+	Tokenizer oTokens( sLine, iLength );
+	Token oName;
+	double dValue = 0.0;
+	size_t iFormula = 0;
+
+	if( oTokens.peek( ).eType == TOKEN_END ||
+		( oTokens.peek( ).eType == TOKEN_OPERATOR && oTokens.peek( ).cOperator == LINE_COMMENT ) )
+		return LINE_BLANK;
+
+	oName = oTokens.peek( );
+	oTokens.advance( );
+
+	if( oName.eType == TOKEN_IDENTIFIER && oName.iLength == 1 && oName.sText[ 0 ] == 'q' &&
+		oTokens.peek( ).eType == TOKEN_END )
+		return LINE_QUIT;
+
+	if( oName.eType == TOKEN_OPERATOR && oName.cOperator == CELL_QUERY )
+	{
+		chrono::steady_clock::time_point oStart = chrono::steady_clock::now( );
+
+		oName = oTokens.peek( );
+		oTokens.advance( );
+		oError.iPosition = oName.iPosition;
+
+		if( oName.eType != TOKEN_IDENTIFIER || oTokens.peek( ).eType != TOKEN_END )
+		{
+			oError.sMessage = "expected a cell name";
+			return LINE_INVALID;
+		}
+
+		if( !oSheet.get_Cell( oName.sText, oName.iLength, dValue ) )
+		{
+			oError.sMessage = "unknown cell";
+			return LINE_INVALID;
+		}
+
+		dSeconds += chrono::duration< double >( chrono::steady_clock::now( ) - oStart ).count( );
+		oWriter.write_Double( dValue );
+		oWriter.write_Char( '\n' );
+		return LINE_OPERATION;
+	}
+
+	if( oName.eType != TOKEN_IDENTIFIER )
+	{
+		oError.iPosition = oName.iPosition;
+		oError.sMessage = "expected a cell name";
+		return LINE_INVALID;
+	}
+
+	if( oTokens.peek( ).eType != TOKEN_OPERATOR || oTokens.peek( ).cOperator != CELL_ASSIGN )
+	{
+		oError.iPosition = oTokens.peek( ).iPosition;
+		oError.sMessage = "expected '='";
+		return LINE_INVALID;
+	}
+
+	iFormula = oTokens.peek( ).iPosition + 1;
+
+	if( !oSheet.set_Cell( oName.sText, oName.iLength, sLine + iFormula, iLength - iFormula, oError ) )
+	{
+		oError.iPosition += iFormula;
+		return LINE_INVALID;
+	}
+
+	return LINE_OPERATION;
+}
+
+// Runs a cell script, printing the value of every cell asked for.
+//	Parameters:
+//		oOptions : BatchOptions - Where to read from and print to, and the
+//				   threads for large recalculations.  The other options
+//				   don't apply.
+//		m_Calculator : Calculator - Holds the cells as variables.
+//		bStats : bool - Print the sheet's counters when done.
+//	Returns:
+//		0 on success, 1 if any line could not be parsed or applied, or the
+//		script could not be read.
+//////////////////////////////////////////////////////////////////////////////
+int run_Cell_Batch( const BatchOptions& oOptions, Calculator* const m_Calculator, bool bStats )
+{
+	FILE* pScript = stdin;
+	char* sLine = NULL;
+	size_t iLength = 0;
+	unsigned long long iLineNumber = 0;
+	unsigned long long iErrorCount = 0;
+	double dSeconds = 0.0;
+	chrono::steady_clock::time_point oStart;
+	CompileError oError;
+	bool bQuit = false;
+
+	if( oOptions.sScriptPath != NULL )
+	{
+		pScript = fopen( oOptions.sScriptPath, "rb" );
+
+		if( pScript == NULL )
+		{
+			fprintf( stderr, "Unable to open script \"%s\".\n", oOptions.sScriptPath );
+			return 1;
+		}
+	}
+
+	CellSheet oSheet( m_Calculator, oOptions.iThreadCount );
+	BufferedReader oReader( pScript );
+	BufferedWriter oWriter( oOptions.pOutput != NULL ? oOptions.pOutput : stdout );
+
+	while( !bQuit && oReader.next_Line( sLine, iLength ) )
+	{
+		++iLineNumber;
+
+		switch( run_Cell_Line( sLine, iLength, oSheet, oWriter, dSeconds, oError ) )
+		{
+		case LINE_QUIT:
+			bQuit = true;
+			break;
+		case LINE_INVALID:
+			report_Line( iLineNumber, oError );
+			++iErrorCount;
+			break;
+		default:
+			break;
+		}
+	}
+
+	if( oReader.failed( ) )
+	{
+		fprintf( stderr, "Error reading script.\n" );
+		++iErrorCount;
+	}
+
+	// Leave the calculator's variables up to date.
+	oStart = chrono::steady_clock::now( );
+	oSheet.recalculate( );
+	dSeconds += chrono::duration< double >( chrono::steady_clock::now( ) - oStart ).count( );
+	oWriter.flush( );
+
+	if( bStats )
+		print_Cell_Stats( oSheet, dSeconds );
+
+	if( pScript != stdin )
+		fclose( pScript );
+
+	return iErrorCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#ifndef _CELLRUNNER_H
+#define _CELLRUNNER_H
+
+// Name: CellRunner.h
+// Description: Cell mode.  Runs a script that defines, edits and reads
+//				the cells of a CellSheet, recalculating only what each
+//				run of edits affected.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "BatchRunner.h"
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+int run_Cell_Batch( const BatchOptions& oOptions, Calculator* const m_Calculator, bool bStats );
+
+#endif
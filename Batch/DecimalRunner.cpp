@@ -0,0 +1,173 @@
+// Name: DecimalRunner.cpp
+// Description: Streams a calculation script through a DecimalCalculator.
+//				Lines are read and parsed in place, like run_Batch's
+//				serial mode, and values are printed in decimal notation.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "DecimalRunner.h"
+#include "../IO/BufferedIO.h"
+#include "../Metrics/Metrics.h"
+#include "../Parser/DecimalParser.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+// Reports a line that could not be parsed or applied.
+static void report_Line( unsigned long long iLineNumber, const CompileError& oError )
+{
+	METRIC_COUNT_FAILURE( METRIC_SOURCE_SCRIPT, oError.sMessage );
+	fprintf( stderr, "Line %llu, column %llu: %s.\n", iLineNumber,
+			 (unsigned long long) oError.iPosition + 1, oError.sMessage );
+}
+
+// Looks up a rounding mode by name: "half-even", "half-up", "half-down",
+// "down", "up", "ceiling" or "floor".
+//	Returns:
+//		False if the name isn't one of them.
+//////////////////////////////////////////////////////////////////////////////
+bool parse_Rounding( const char* sName, eDecimalRounding& eRounding )
+{
+	static const struct
+	{
+		const char* sName;
+		eDecimalRounding eRounding;
+	} aROUNDINGS[] =
+	{
+		{ "half-even", DECIMAL_ROUND_HALF_EVEN },
+		{ "half-up", DECIMAL_ROUND_HALF_UP },
+		{ "half-down", DECIMAL_ROUND_HALF_DOWN },
+		{ "down", DECIMAL_ROUND_DOWN },
+		{ "up", DECIMAL_ROUND_UP },
+		{ "ceiling", DECIMAL_ROUND_CEILING },
+		{ "floor", DECIMAL_ROUND_FLOOR }
+	};
+
+	for( size_t i = 0; i < sizeof( aROUNDINGS ) / sizeof( aROUNDINGS[ 0 ] ); ++i )
+	{
+		if( !strcmp( sName, aROUNDINGS[ i ].sName ) )
+		{
+			eRounding = aROUNDINGS[ i ].eRounding;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Runs a calculation script on the decimal calculator, printing the
+// working value after every applied line, or only once at the end.  An
+// operation that fails is reported and leaves the working value alone.
+//	Parameters:
+//		oOptions : BatchOptions - Where to read from and what to print.  The
+//				   parallel, pipeline, cache and journal options don't apply.
+//		oCalculator : DecimalCalculator - Calculator to apply the script to.
+//	Returns:
+//		0 on success, 1 if any line could not be parsed or applied, or the
+//		script could not be read.
+//////////////////////////////////////////////////////////////////////////////
+int run_Decimal_Batch( const BatchOptions& oOptions, DecimalCalculator& oCalculator )
+{
+	FILE* pScript = stdin;
+	char* sLine = NULL;
+	size_t iLength = 0;
+	unsigned long long iLineNumber = 0;
+	unsigned long long iErrorCount = 0;
+	DecimalStatement oStatement;
+	string sValue;
+	CompileError oError;
+	eDecimalStatus eStatus = DECIMAL_OK;
+	bool bQuit = false;
+
+	if( oOptions.sScriptPath != NULL )
+	{
+		pScript = fopen( oOptions.sScriptPath, "rb" );
+
+		if( pScript == NULL )
+		{
+			fprintf( stderr, "Unable to open script \"%s\".\n", oOptions.sScriptPath );
+			return 1;
+		}
+	}
+
+	BufferedReader oReader( pScript );
+	BufferedWriter oWriter( oOptions.pOutput != NULL ? oOptions.pOutput : stdout );
+
+	while( !bQuit && oReader.next_Line( sLine, iLength ) )
+	{
+		++iLineNumber;
+
+		switch( parse_Decimal_Line( sLine, iLength, oCalculator, oStatement, oError ) )
+		{
+		case LINE_OPERATION:
+			switch( oStatement.cOperator )
+			{
+			case OP_CODE_STORE:
+				oCalculator.store_Mem( );
+				break;
+			case OP_CODE_RESET:
+				oCalculator.clear_Value( );
+				break;
+			case OP_CODE_SET:
+				oCalculator.set_Value( oStatement.oOperand );
+				break;
+			default:
+				eStatus = oCalculator.process_Calculation( oStatement.cOperator, oStatement.oOperand );
+				break;
+			}
+
+			if( eStatus != DECIMAL_OK )
+			{
+				oError.iPosition = (size_t)( (const char*) memchr( sLine, oStatement.cOperator, iLength ) - sLine );
+				oError.sMessage = get_Decimal_Error( eStatus );
+				report_Line( iLineNumber, oError );
+				eStatus = DECIMAL_OK;
+				++iErrorCount;
+			}
+			else if( !oOptions.bFinalOnly )
+			{
+				sValue.clear( );
+				oCalculator.read_Value( ).append_String( sValue );
+				sValue += '\n';
+				oWriter.write( sValue.data( ), sValue.size( ) );
+			}
+			break;
+		case LINE_QUIT:
+			bQuit = true;
+			break;
+		case LINE_INVALID:
+			report_Line( iLineNumber, oError );
+			++iErrorCount;
+			break;
+		case LINE_BLANK:
+		default:
+			break;
+		}
+	}
+
+	if( oReader.failed( ) )
+	{
+		fprintf( stderr, "Error reading script.\n" );
+		++iErrorCount;
+	}
+
+	if( oOptions.bFinalOnly )
+	{
+		sValue.clear( );
+		oCalculator.read_Value( ).append_String( sValue );
+		sValue += '\n';
+		oWriter.write( sValue.data( ), sValue.size( ) );
+	}
+
+	oWriter.flush( );
+
+	if( pScript != stdin )
+		fclose( pScript );
+
+	return iErrorCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+#ifndef _DECIMALRUNNER_H
+#define _DECIMALRUNNER_H
+
+// Name: DecimalRunner.h
+// Description: Batch mode for the decimal calculator.  Runs a script
+//				with arbitrary precision decimal arithmetic and prints
+//				results in decimal notation.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "BatchRunner.h"
+#include "../Calculator/DecimalCalculator.h"
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+int run_Decimal_Batch( const BatchOptions& oOptions, DecimalCalculator& oCalculator );
+bool parse_Rounding( const char* sName, eDecimalRounding& eRounding );
+
+#endif
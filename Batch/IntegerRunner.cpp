@@ -0,0 +1,183 @@
+// Name: IntegerRunner.cpp
+// Description: Streams a calculation script through an IntegerCalculator.
+//				Lines are read and parsed in place, like run_Batch's
+//				serial mode, and values are printed as exact decimals.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "IntegerRunner.h"
+#include "../IO/BufferedIO.h"
+#include "../Metrics/Metrics.h"
+#include "../Parser/IntegerParser.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+// Writes a value in decimal.  64 bit values, the common case, are
+// formatted without going through a string.
+static void write_Integer( BufferedWriter& oWriter, const ExactInteger& oValue )
+{
+	char sDigits[ 24 ];
+	char* pStart = sDigits + sizeof( sDigits );
+	unsigned long long iMagnitude = 0;
+
+	if( !oValue.is_Small( ) )
+	{
+		string sValue = oValue.to_String( );
+
+		oWriter.write( sValue.data( ), sValue.size( ) );
+		return;
+	}
+
+	iMagnitude = oValue.get_Small( ) < 0 ? 0ULL - (unsigned long long) oValue.get_Small( )
+										 : (unsigned long long) oValue.get_Small( );
+
+	do
+	{
+		*--pStart = (char)( '0' + iMagnitude % 10 );
+		iMagnitude /= 10;
+	} while( iMagnitude != 0 );
+
+	if( oValue.get_Small( ) < 0 )
+		*--pStart = '-';
+
+	oWriter.write( pStart, (size_t)( sDigits + sizeof( sDigits ) - pStart ) );
+}
+
+// Reports a line that could not be parsed or applied.
+static void report_Line( unsigned long long iLineNumber, const CompileError& oError )
+{
+	METRIC_COUNT_FAILURE( METRIC_SOURCE_SCRIPT, oError.sMessage );
+	fprintf( stderr, "Line %llu, column %llu: %s.\n", iLineNumber,
+			 (unsigned long long) oError.iPosition + 1, oError.sMessage );
+}
+
+// Looks up a division mode by name: "truncate", "floor" or "exact".
+//	Returns:
+//		False if the name isn't one of them.
+//////////////////////////////////////////////////////////////////////////////
+bool parse_Division( const char* sName, eIntegerDivision& eDivision )
+{
+	if( !strcmp( sName, "truncate" ) )
+		eDivision = INTEGER_DIVISION_TRUNCATE;
+	else if( !strcmp( sName, "floor" ) )
+		eDivision = INTEGER_DIVISION_FLOOR;
+	else if( !strcmp( sName, "exact" ) )
+		eDivision = INTEGER_DIVISION_EXACT;
+	else
+		return false;
+
+	return true;
+}
+
+// Runs a calculation script on the integer calculator, printing the
+// working value after every applied line, or only once at the end.  A
+// division that fails is reported and leaves the working value alone.
+//	Parameters:
+//		oOptions : BatchOptions - Where to read from and what to print.  The
+//				   parallel, pipeline, cache and journal options don't apply.
+//		oCalculator : IntegerCalculator - Calculator to apply the script to.
+//	Returns:
+//		0 on success, 1 if any line could not be parsed or applied, or the
+//		script could not be read.
+//////////////////////////////////////////////////////////////////////////////
+int run_Integer_Batch( const BatchOptions& oOptions, IntegerCalculator& oCalculator )
+{
+	FILE* pScript = stdin;
+	char* sLine = NULL;
+	size_t iLength = 0;
+	unsigned long long iLineNumber = 0;
+	unsigned long long iErrorCount = 0;
+	IntegerStatement oStatement;
+	CompileError oError;
+	eIntegerStatus eStatus = INTEGER_OK;
+	bool bQuit = false;
+
+	if( oOptions.sScriptPath != NULL )
+	{
+		pScript = fopen( oOptions.sScriptPath, "rb" );
+
+		if( pScript == NULL )
+		{
+			fprintf( stderr, "Unable to open script \"%s\".\n", oOptions.sScriptPath );
+			return 1;
+		}
+	}
+
+	BufferedReader oReader( pScript );
+	BufferedWriter oWriter( oOptions.pOutput != NULL ? oOptions.pOutput : stdout );
+
+	while( !bQuit && oReader.next_Line( sLine, iLength ) )
+	{
+		++iLineNumber;
+
+		switch( parse_Integer_Line( sLine, iLength, oCalculator, oStatement, oError ) )
+		{
+		case LINE_OPERATION:
+			switch( oStatement.cOperator )
+			{
+			case OP_CODE_STORE:
+				oCalculator.store_Mem( );
+				break;
+			case OP_CODE_RESET:
+				oCalculator.clear_Value( );
+				break;
+			case OP_CODE_SET:
+				oCalculator.set_Value( oStatement.oOperand );
+				break;
+			default:
+				eStatus = oCalculator.process_Calculation( oStatement.cOperator, oStatement.oOperand );
+				break;
+			}
+
+			if( eStatus != INTEGER_OK )
+			{
+				oError.iPosition = (size_t)( (const char*) memchr( sLine, oStatement.cOperator, iLength ) - sLine );
+				oError.sMessage = get_Integer_Error( eStatus );
+				report_Line( iLineNumber, oError );
+				eStatus = INTEGER_OK;
+				++iErrorCount;
+			}
+			else if( !oOptions.bFinalOnly )
+			{
+				write_Integer( oWriter, oCalculator.read_Value( ) );
+				oWriter.write_Char( '\n' );
+			}
+			break;
+		case LINE_QUIT:
+			bQuit = true;
+			break;
+		case LINE_INVALID:
+			report_Line( iLineNumber, oError );
+			++iErrorCount;
+			break;
+		case LINE_BLANK:
+		default:
+			break;
+		}
+	}
+
+	if( oReader.failed( ) )
+	{
+		fprintf( stderr, "Error reading script.\n" );
+		++iErrorCount;
+	}
+
+	if( oOptions.bFinalOnly )
+	{
+		write_Integer( oWriter, oCalculator.read_Value( ) );
+		oWriter.write_Char( '\n' );
+	}
+
+	oWriter.flush( );
+
+	if( pScript != stdin )
+		fclose( pScript );
+
+	return iErrorCount == 0 ? 0 : 1;
+}
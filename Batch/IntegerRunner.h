@@ -0,0 +1,22 @@
+#ifndef _INTEGERRUNNER_H
+#define _INTEGERRUNNER_H
+
+// Name: IntegerRunner.h
+// Description: Batch mode for the integer calculator.  Runs a script
+//				with exact integer arithmetic and prints exact results.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "BatchRunner.h"
+#include "../Calculator/IntegerCalculator.h"
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+int run_Integer_Batch( const BatchOptions& oOptions, IntegerCalculator& oCalculator );
+bool parse_Division( const char* sName, eIntegerDivision& eDivision );
+
+#endif
@@ -0,0 +1,151 @@
+// Name: MatrixRunner.cpp
+// Description: Streams a calculation script through a MatrixCalculator.
+//				Lines are read and parsed in place, like run_Batch's
+//				serial mode, and each printed matrix is its rows, one per
+//				line, followed by a blank line.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "MatrixRunner.h"
+#include "../IO/BufferedIO.h"
+#include "../IO/MatrixFile.h"
+#include "../Metrics/Metrics.h"
+#include "../Parser/MatrixParser.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+// Reports a line that could not be parsed or applied.
+static void report_Line( unsigned long long iLineNumber, const CompileError& oError )
+{
+	METRIC_COUNT_FAILURE( METRIC_SOURCE_SCRIPT, oError.sMessage );
+	fprintf( stderr, "Line %llu, column %llu: %s.\n", iLineNumber,
+			 (unsigned long long) oError.iPosition + 1, oError.sMessage );
+}
+
+// Writes a matrix a row per line, then a blank line to end it.
+static void write_Matrix( BufferedWriter& oWriter, const Matrix& oValue, string& sText )
+{
+	for( size_t i = 0; i < oValue.get_Rows( ); ++i )
+	{
+		sText.clear( );
+		oValue.append_Row( sText, i );
+		sText += '\n';
+		oWriter.write( sText.data( ), sText.size( ) );
+	}
+
+	oWriter.write( "\n", 1 );
+}
+
+// Runs a calculation script on the matrix calculator, printing the
+// working value after every applied line, or only once at the end.  An
+// operation that fails is reported and leaves the working value alone.
+//	Parameters:
+//		oOptions : BatchOptions - Where to read from and what to print.  The
+//				   parallel, pipeline, cache and journal options don't apply.
+//		oCalculator : MatrixCalculator - Calculator to apply the script to.
+//	Returns:
+//		0 on success, 1 if any line could not be parsed or applied, or the
+//		script could not be read.
+//////////////////////////////////////////////////////////////////////////////
+int run_Matrix_Batch( const BatchOptions& oOptions, MatrixCalculator& oCalculator )
+{
+	FILE* pScript = stdin;
+	char* sLine = NULL;
+	size_t iLength = 0;
+	unsigned long long iLineNumber = 0;
+	unsigned long long iErrorCount = 0;
+	MatrixStatement oStatement;
+	string sText;
+	CompileError oError;
+	eMatrixStatus eStatus = MATRIX_OK;
+	bool bQuit = false;
+
+	if( oOptions.sScriptPath != NULL )
+	{
+		pScript = fopen( oOptions.sScriptPath, "rb" );
+
+		if( pScript == NULL )
+		{
+			fprintf( stderr, "Unable to open script \"%s\".\n", oOptions.sScriptPath );
+			return 1;
+		}
+	}
+
+	BufferedReader oReader( pScript );
+	BufferedWriter oWriter( oOptions.pOutput != NULL ? oOptions.pOutput : stdout );
+
+	while( !bQuit && oReader.next_Line( sLine, iLength ) )
+	{
+		bool bPrint = !oOptions.bFinalOnly;
+
+		++iLineNumber;
+
+		switch( parse_Matrix_Line( sLine, iLength, oCalculator, oStatement, oError ) )
+		{
+		case LINE_OPERATION:
+			switch( oStatement.cOperator )
+			{
+			case OP_CODE_STORE:
+				oCalculator.store_Mem( );
+				break;
+			case OP_CODE_RESET:
+				oCalculator.clear_Value( );
+				break;
+			case OP_CODE_SET:
+				oCalculator.set_Value( oStatement.oOperand );
+				break;
+			case MATRIX_OP_WRITE:
+				eStatus = save_Matrix( oStatement.sPath.c_str( ), oCalculator.read_Value( ) );
+				bPrint = false;
+				break;
+			default:
+				eStatus = oCalculator.process_Calculation( oStatement.cOperator, oStatement.oOperand );
+				break;
+			}
+
+			if( eStatus != MATRIX_OK )
+			{
+				oError.iPosition = (size_t)( (const char*) memchr( sLine, oStatement.cOperator, iLength ) - sLine );
+				oError.sMessage = get_Matrix_Error( eStatus );
+				report_Line( iLineNumber, oError );
+				eStatus = MATRIX_OK;
+				++iErrorCount;
+			}
+			else if( bPrint )
+				write_Matrix( oWriter, oCalculator.read_Value( ), sText );
+			break;
+		case LINE_QUIT:
+			bQuit = true;
+			break;
+		case LINE_INVALID:
+			report_Line( iLineNumber, oError );
+			++iErrorCount;
+			break;
+		case LINE_BLANK:
+		default:
+			break;
+		}
+	}
+
+	if( oReader.failed( ) )
+	{
+		fprintf( stderr, "Error reading script.\n" );
+		++iErrorCount;
+	}
+
+	if( oOptions.bFinalOnly )
+		write_Matrix( oWriter, oCalculator.read_Value( ), sText );
+
+	oWriter.flush( );
+
+	if( pScript != stdin )
+		fclose( pScript );
+
+	return iErrorCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#ifndef _MATRIXRUNNER_H
+#define _MATRIXRUNNER_H
+
+// Name: MatrixRunner.h
+// Description: Batch mode for the matrix calculator.  Runs a script on
+//				matrices and prints each result a row per line.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "BatchRunner.h"
+#include "../Calculator/MatrixCalculator.h"
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+int run_Matrix_Batch( const BatchOptions& oOptions, MatrixCalculator& oCalculator );
+
+#endif
@@ -0,0 +1,178 @@
+// Name: Replay.cpp
+// Description: Script to operation log conversion and log replay.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "Replay.h"
+#include "../IO/BufferedIO.h"
+#include "../IO/OpLog.h"
+#include "../Metrics/Metrics.h"
+#include "../Parser/ExprCompiler.h"
+#include "../Parser/LineParser.h"
+#include <cstdio>
+
+// Turns a compiled line into a log record.  Only lines whose operand is a
+// constant can be stored.
+//	Returns:
+//		False if the line reads the working value or memory.
+//////////////////////////////////////////////////////////////////////////////
+static bool write_Program( const Program& oProgram, Calculator* const m_Calculator,
+						   OpLogWriter& oWriter )
+{
+	Operation oOperation;
+
+	if( oProgram.bReadsState )
+		return false;
+
+	oOperation.cOpCode = oProgram.cOperator == BC_ASSIGN ? OP_CODE_SET : (unsigned char) oProgram.cOperator;
+	oOperation.dValue = m_Calculator->evaluate_Program( oProgram );
+	oWriter.write( oOperation );
+
+	return true;
+}
+
+// Converts a calculation script into a binary operation log.
+//	Parameters:
+//		sScriptPath : String - Script to convert, NULL for stdin.
+//		sLogPath : String - Log file to create.
+//		m_Calculator : Calculator - Calculator object for referencing operands.
+//	Returns:
+//		0 on success, 1 if any line could not be converted.
+//////////////////////////////////////////////////////////////////////////////
+int run_Convert( const char* sScriptPath, const char* sLogPath,
+				 Calculator* const m_Calculator )
+{
+	FILE* pScript = stdin;
+	char* sLine = NULL;
+	size_t iLength = 0;
+	unsigned long long iLineNumber = 0;
+	unsigned long long iErrorCount = 0;
+	Operation oOperation;
+	Program oProgram;
+	CompileError oError;
+	OpLogWriter oWriter;
+	bool bQuit = false;
+
+	if( sScriptPath != NULL && ( pScript = fopen( sScriptPath, "rb" ) ) == NULL )
+	{
+		fprintf( stderr, "Unable to open script \"%s\".\n", sScriptPath );
+		return 1;
+	}
+
+	if( !oWriter.open( sLogPath ) )
+	{
+		fprintf( stderr, "Unable to create log \"%s\".\n", sLogPath );
+
+		if( pScript != stdin )
+			fclose( pScript );
+
+		return 1;
+	}
+
+	BufferedReader oReader( pScript );
+
+	while( !bQuit && oReader.next_Line( sLine, iLength ) )
+	{
+		++iLineNumber;
+
+		switch( parse_Line( sLine, iLength, m_Calculator, oOperation ) )
+		{
+		case LINE_OPERATION:
+			if( op_TouchesVar( oOperation.cOpCode ) )
+			{
+				fprintf( stderr, "Line %llu: variables can't be stored in an operation log.\n", iLineNumber );
+				++iErrorCount;
+				break;
+			}
+
+			oWriter.write( oOperation );
+			break;
+		case LINE_QUIT:
+			bQuit = true;
+			break;
+		case LINE_INVALID:
+			if( !compile_Line( sLine, iLength, m_Calculator, oProgram, oError ) )
+			{
+				METRIC_COUNT_FAILURE( METRIC_SOURCE_SCRIPT, oError.sMessage );
+				fprintf( stderr, "Line %llu, column %llu: %s.\n", iLineNumber,
+						 (unsigned long long) oError.iPosition + 1, oError.sMessage );
+				++iErrorCount;
+			}
+			else if( !write_Program( oProgram, m_Calculator, oWriter ) )
+			{
+				fprintf( stderr, "Line %llu: expressions using \"mem\", \"ans\" or variables can't be stored in an operation log.\n",
+						 iLineNumber );
+				++iErrorCount;
+			}
+			break;
+		case LINE_BLANK:
+		default:
+			break;
+		}
+	}
+
+	if( oReader.failed( ) )
+	{
+		fprintf( stderr, "Error reading script.\n" );
+		++iErrorCount;
+	}
+
+	if( !oWriter.close( ) )
+	{
+		fprintf( stderr, "Error writing log \"%s\".\n", sLogPath );
+		++iErrorCount;
+	}
+
+	if( pScript != stdin )
+		fclose( pScript );
+
+	return iErrorCount == 0 ? 0 : 1;
+}
+
+// Replays a binary operation log, printing the working value after every
+// record, or only once at the end.
+//	Parameters:
+//		sLogPath : String - Log to replay.
+//		bFinalOnly : bool - Only print the final working value.
+//		m_Calculator : Calculator - Calculator to replay the log into.
+//	Returns:
+//		0 on success, 1 if the log could not be opened.
+//////////////////////////////////////////////////////////////////////////////
+int run_Replay( const char* sLogPath, bool bFinalOnly,
+				Calculator* const m_Calculator )
+{
+	OpLogReader oReader;
+	BufferedWriter oWriter( stdout );
+	Operation oOperation;
+
+	if( !oReader.open( sLogPath ) )
+	{
+		fprintf( stderr, "Unable to replay \"%s\": %s.\n", sLogPath, oReader.get_Error( ) );
+		return 1;
+	}
+
+	if( bFinalOnly )
+		oReader.replay( m_Calculator );
+	else
+	{
+		for( unsigned long long i = 0; i < oReader.size( ); ++i )
+		{
+			oReader.get( i, oOperation );
+			m_Calculator->apply_Operation( oOperation );
+			oWriter.write_Double( m_Calculator->read_Value( ) );
+			oWriter.write_Char( '\n' );
+		}
+	}
+
+	if( bFinalOnly )
+	{
+		oWriter.write_Double( m_Calculator->read_Value( ) );
+		oWriter.write_Char( '\n' );
+	}
+
+	oWriter.flush( );
+	return 0;
+}
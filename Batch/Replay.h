@@ -0,0 +1,23 @@
+#ifndef _REPLAY_H
+#define _REPLAY_H
+
+// Name: Replay.h
+// Description: Converts calculation scripts to binary operation logs and
+//				replays those logs through a Calculator.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "../Calculator/Calculator.h"
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+int run_Convert( const char* sScriptPath, const char* sLogPath,
+				 Calculator* const m_Calculator );
+int run_Replay( const char* sLogPath, bool bFinalOnly,
+				Calculator* const m_Calculator );
+
+#endif
@@ -0,0 +1,918 @@
+// Name: ShardRunner.cpp
+// Description: Runs session-tagged lines over worker processes.  The
+//				input is mapped once and shared by every worker, each of
+//				which reads it all and runs only the lines of its own
+//				sessions.  A worker's result table lives in a memfd of its
+//				own, which it grows as sessions arrive; the parent maps
+//				the tables once the workers are done and sorts the
+//				sessions out of them, with no copying through pipes.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "ShardRunner.h"
+
+#ifdef __linux__
+
+#include "../Calculator/Calculator.h"
+#include "../IO/BufferedIO.h"
+#include "../Metrics/Metrics.h"
+#include "../Parser/ExprCache.h"
+#include "../Parser/LineParser.h"
+#include "../Server/Protocol.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define SHARD_NO_RECORD			( ~0ULL )	// A session not yet in the table
+#define SHARD_MAX_TEXT			72			// A session ID, two "%.17g" values and their separators
+#define SHARD_NODE_PATH			"/sys/devices/system/node"
+
+/*********************************************************************\
+ *	Result Table													 *
+\*********************************************************************/
+
+// A session's state as of a checkpoint.
+struct ShardState
+{
+	unsigned long long iEpoch;			// Checkpoint that wrote it, 0 for none
+	double dValue;
+	double dMemory;
+	unsigned long long bClosed;
+};
+
+// A session in the result table.  A checkpoint writes the slot not
+// holding the session's committed state, so one cut short by a crash
+// leaves that state intact.
+struct ShardRecord
+{
+	unsigned long long iSession;
+	ShardState aStates[ 2 ];
+};
+
+// How far a shard had got at a checkpoint.
+struct ShardCheckpoint
+{
+	unsigned long long iOffset;			// Input bytes read
+	unsigned long long iLine;			// Input lines read
+	unsigned long long iRecords;		// Sessions in the table
+	unsigned long long iLines;			// Lines of the shard run
+	unsigned long long iErrors;			// Lines of the shard rejected
+	unsigned long long bVariables;		// Some session used a variable
+	unsigned long long bDone;			// The whole input was read
+};
+
+// Start of a result table; the records follow.  Checkpoint e is written
+// to slot e & 1 and only then committed by setting iEpoch, so the slot
+// iEpoch names is always whole.
+struct ShardHeader
+{
+	unsigned long long iEpoch;			// Last committed checkpoint, 0 for none
+	unsigned long long iReported;		// Input offset past the last error printed
+	ShardCheckpoint aCheckpoints[ 2 ];
+};
+
+// Returns the slot holding a record's state as of checkpoint iEpoch, or
+// -1 if the record had none then.
+static inline int get_Committed_Slot( const ShardRecord& oRecord, unsigned long long iEpoch )
+{
+	int iSlot = -1;
+
+	for( int i = 0; i < 2; ++i )
+	{
+		if( oRecord.aStates[ i ].iEpoch != 0 && oRecord.aStates[ i ].iEpoch <= iEpoch &&
+			( iSlot < 0 || oRecord.aStates[ i ].iEpoch > oRecord.aStates[ iSlot ].iEpoch ) )
+			iSlot = i;
+	}
+
+	return iSlot;
+}
+
+// Returns the table size holding iRecords records.
+static inline size_t get_Table_Size( unsigned long long iRecords )
+{
+	return sizeof( ShardHeader ) + (size_t) iRecords * sizeof( ShardRecord );
+}
+
+// A result table mapped into this process.
+struct ShardTable
+{
+	int iFile;
+	ShardHeader* pHeader;
+	size_t iSize;
+};
+
+// Maps a table at its current size.
+//	Returns:
+//		false if it could not be mapped.
+//////////////////////////////////////////////////////////////////////////////
+static bool map_Table( ShardTable& oTable, int iFile, bool bWritable )
+{
+	struct stat oStat;
+	void* pMapping = NULL;
+
+	oTable.iFile = iFile;
+	oTable.pHeader = NULL;
+	oTable.iSize = 0;
+
+	if( fstat( iFile, &oStat ) != 0 || (size_t) oStat.st_size < sizeof( ShardHeader ) )
+		return false;
+
+	pMapping = mmap( NULL, (size_t) oStat.st_size, bWritable ? PROT_READ | PROT_WRITE : PROT_READ,
+					 MAP_SHARED, iFile, 0 );
+
+	if( pMapping == MAP_FAILED )
+		return false;
+
+	oTable.pHeader = (ShardHeader*) pMapping;
+	oTable.iSize = (size_t) oStat.st_size;
+	return true;
+}
+
+static void unmap_Table( ShardTable& oTable )
+{
+	if( oTable.pHeader != NULL )
+		munmap( oTable.pHeader, oTable.iSize );
+
+	oTable.pHeader = NULL;
+	oTable.iSize = 0;
+}
+
+static inline ShardRecord* get_Records( const ShardTable& oTable )
+{
+	return (ShardRecord*)( oTable.pHeader + 1 );
+}
+
+/*********************************************************************\
+ *	Shard Worker													 *
+\*********************************************************************/
+
+// A session as its worker keeps it.
+struct ShardSession
+{
+	Calculator oCalculator;
+	unsigned long long iRecord;			// Index in the table, SHARD_NO_RECORD if not there yet
+	bool bClosed;						// Ended by "q"
+	bool bDirty;						// Changed since the last checkpoint
+};
+
+// Runs one shard of the input in a worker process.
+class ShardWorker
+{
+public:
+	ShardWorker( const char* pInput, size_t iInputSize, unsigned int iShard, unsigned int iShardCount,
+				 int iTableFile, size_t iCacheBudget );
+	~ShardWorker( );
+
+	int run( );
+
+private:
+	ShardWorker( const ShardWorker& );
+	ShardWorker& operator=( const ShardWorker& );
+
+	void restore( );
+	void run_Line( unsigned long long iSession, const char* sBody, size_t iLength,
+				   unsigned long long iLine, size_t iOffset );
+	void report( unsigned long long iLine, size_t iOffset, unsigned long long iColumn, const char* sMessage );
+	bool checkpoint( size_t iOffset, unsigned long long iLine, bool bDone );
+	bool reserve( unsigned long long iRecords );
+
+	const char* m_pInput;
+	size_t m_iInputSize;
+	unsigned int m_iShard;
+	unsigned int m_iShardCount;
+	ShardTable m_oTable;
+	ExprCache m_oCache;
+	unordered_map< unsigned long long, ShardSession > m_mSessions;
+	vector< pair< const unsigned long long, ShardSession >* > m_vDirty;
+	vector< char > m_vLine;				// The line being run, null terminated
+	ShardCheckpoint m_oProgress;		// Counts since the start of the shard
+};
+
+ShardWorker::ShardWorker( const char* pInput, size_t iInputSize, unsigned int iShard, unsigned int iShardCount,
+						  int iTableFile, size_t iCacheBudget )
+	: m_oCache( iCacheBudget )
+{
+	m_pInput = pInput;
+	m_iInputSize = iInputSize;
+	m_iShard = iShard;
+	m_iShardCount = iShardCount;
+	m_oTable.iFile = iTableFile;
+	m_oTable.pHeader = NULL;
+	m_oTable.iSize = 0;
+	memset( &m_oProgress, 0, sizeof( m_oProgress ) );
+}
+
+ShardWorker::~ShardWorker( )
+{
+	unmap_Table( m_oTable );
+}
+
+// Runs the shard from its last checkpoint to the end of the input and
+// commits the result.
+//	Returns:
+//		The worker's exit status: 0 once the shard is committed, 1 if the
+//		table could not be mapped or grown.
+//////////////////////////////////////////////////////////////////////////////
+int ShardWorker::run( )
+{
+	const char* pCurr = NULL;
+	const char* pEnd = m_pInput + m_iInputSize;
+	unsigned long long iLine = 0;
+	unsigned long long iSinceCheckpoint = 0;
+
+	if( !map_Table( m_oTable, m_oTable.iFile, true ) )
+	{
+		perror( "shard table" );
+		return 1;
+	}
+
+	restore( );
+	pCurr = m_pInput + m_oProgress.iOffset;
+	iLine = m_oProgress.iLine;
+
+	while( pCurr < pEnd )
+	{
+		const char* sLine = pCurr;
+		const char* pLineEnd = (const char*) memchr( pCurr, '\n', (size_t)( pEnd - pCurr ) );
+		size_t iLength = 0;
+		const char* sBody = NULL;
+		size_t iBodyLength = 0;
+		unsigned long long iSession = 0;
+
+		if( pLineEnd == NULL )
+			pLineEnd = pEnd;
+
+		pCurr = pLineEnd < pEnd ? pLineEnd + 1 : pEnd;
+		iLength = (size_t)( pLineEnd - sLine );
+		++iLine;
+
+		if( iLength > 0 && sLine[ iLength - 1 ] == '\r' )
+			--iLength;
+
+		if( parse_Request( sLine, iLength, iSession, sBody, iBodyLength ) )
+		{
+			if( iSession % m_iShardCount != m_iShard )
+				continue;
+
+			run_Line( iSession, sBody, iBodyLength, iLine, (size_t)( sLine - m_pInput ) );
+
+			if( ++iSinceCheckpoint == SHARD_CHECKPOINT_LINES )
+			{
+				if( !checkpoint( (size_t)( pCurr - m_pInput ), iLine, false ) )
+					return 1;
+
+				iSinceCheckpoint = 0;
+			}
+		}
+		else if( iLength > 0 && sLine[ 0 ] != '#' && m_iShard == 0 )
+		{
+			// Every worker sees the line; the first one reports it.
+			++m_oProgress.iErrors;
+			report( iLine, (size_t)( sLine - m_pInput ), 1, "missing session ID" );
+		}
+	}
+
+	return checkpoint( m_iInputSize, iLine, true ) ? 0 : 1;
+}
+
+// Picks up from the table's last checkpoint: reloads every session's
+// value and memory and where in the input the shard had got to.  A shard
+// that used variables starts over, as would a new one.
+void ShardWorker::restore( )
+{
+	const ShardHeader* pHeader = m_oTable.pHeader;
+	const ShardRecord* pRecords = get_Records( m_oTable );
+	const unsigned long long iEpoch = pHeader->iEpoch;
+
+	if( iEpoch == 0 || pHeader->aCheckpoints[ iEpoch & 1 ].bVariables )
+		return;
+
+	m_oProgress = pHeader->aCheckpoints[ iEpoch & 1 ];
+
+	for( unsigned long long i = 0; i < m_oProgress.iRecords; ++i )
+	{
+		const int iSlot = get_Committed_Slot( pRecords[ i ], iEpoch );
+		ShardSession& oSession = m_mSessions[ pRecords[ i ].iSession ];
+
+		oSession.iRecord = i;
+		oSession.bDirty = false;
+		oSession.bClosed = iSlot >= 0 && pRecords[ i ].aStates[ iSlot ].bClosed;
+
+		if( iSlot >= 0 )
+		{
+			oSession.oCalculator.set_Value( pRecords[ i ].aStates[ iSlot ].dValue );
+			oSession.oCalculator.set_Mem( pRecords[ i ].aStates[ iSlot ].dMemory );
+		}
+	}
+}
+
+// Runs a line of the shard in its session, as the daemon would.
+void ShardWorker::run_Line( unsigned long long iSession, const char* sBody, size_t iLength,
+							unsigned long long iLine, size_t iOffset )
+{
+	pair< unordered_map< unsigned long long, ShardSession >::iterator, bool > oFound =
+		m_mSessions.try_emplace( iSession );
+	ShardSession& oSession = oFound.first->second;
+	Calculator* const m_Calculator = &oSession.oCalculator;
+	Operation oOperation;
+	CompileError oError;
+	const Program* pProgram = NULL;
+
+	if( oFound.second )
+	{
+		oSession.iRecord = SHARD_NO_RECORD;
+		oSession.bClosed = false;
+		oSession.bDirty = false;
+	}
+
+	if( oSession.bClosed )
+		return;
+
+	++m_oProgress.iLines;
+	m_vLine.assign( sBody, sBody + iLength );
+	m_vLine.push_back( '\0' );
+
+	switch( parse_Line( m_vLine.data( ), iLength, m_Calculator, oOperation ) )
+	{
+	case LINE_OPERATION:
+		m_Calculator->apply_Operation( oOperation );
+		break;
+	case LINE_QUIT:
+		oSession.bClosed = true;
+		break;
+	case LINE_INVALID:
+		pProgram = m_oCache.compile( m_vLine.data( ), iLength, m_Calculator, oError );
+
+		if( pProgram == NULL )
+		{
+			++m_oProgress.iErrors;
+			report( iLine, iOffset, (unsigned long long)( sBody - ( m_pInput + iOffset ) ) + oError.iPosition + 1,
+					oError.sMessage );
+			break;
+		}
+
+		m_Calculator->execute_Program( *pProgram );
+		break;
+	case LINE_BLANK:
+	default:
+		break;
+	}
+
+	if( m_Calculator->get_Variables( ).size( ) > VARIABLE_MEMORY_SLOT + 1 )
+		m_oProgress.bVariables = true;
+
+	if( !oSession.bDirty )
+	{
+		oSession.bDirty = true;
+		m_vDirty.push_back( &*oFound.first );
+	}
+}
+
+// Prints a rejected line, unless a run of the shard that crashed already
+// printed it.
+void ShardWorker::report( unsigned long long iLine, size_t iOffset, unsigned long long iColumn, const char* sMessage )
+{
+	METRIC_COUNT_FAILURE( METRIC_SOURCE_SCRIPT, sMessage );
+
+	if( iOffset < m_oTable.pHeader->iReported )
+		return;
+
+	fprintf( stderr, "Line %llu, column %llu: %s.\n", iLine, iColumn, sMessage );
+	m_oTable.pHeader->iReported = iOffset + 1;
+}
+
+// Writes every session changed since the last checkpoint to the table,
+// then commits it.  Until the commit, a crash leaves the table as it was
+// at the last one; the signal fences keep the compiler from moving a
+// commit ahead of what it commits.
+//	Parameters:
+//		iOffset : size_t - Input bytes read.
+//		iLine : unsigned long long - Input lines read.
+//		bDone : bool - The whole input was read.
+//	Returns:
+//		false if the table could not be grown.
+//////////////////////////////////////////////////////////////////////////////
+bool ShardWorker::checkpoint( size_t iOffset, unsigned long long iLine, bool bDone )
+{
+	const unsigned long long iCommitted = m_oTable.pHeader->iEpoch;
+	const unsigned long long iEpoch = iCommitted + 1;
+	unsigned long long iRecords = m_oProgress.iRecords;
+
+	for( size_t i = 0; i < m_vDirty.size( ); ++i )
+	{
+		if( m_vDirty[ i ]->second.iRecord == SHARD_NO_RECORD )
+			++iRecords;
+	}
+
+	if( !reserve( iRecords ) )
+		return false;
+
+	for( size_t i = 0; i < m_vDirty.size( ); ++i )
+	{
+		ShardSession& oSession = m_vDirty[ i ]->second;
+		ShardRecord* pRecord = NULL;
+		ShardState* pState = NULL;
+
+		if( oSession.iRecord == SHARD_NO_RECORD )
+		{
+			oSession.iRecord = m_oProgress.iRecords++;
+			pRecord = get_Records( m_oTable ) + oSession.iRecord;
+			memset( pRecord, 0, sizeof( *pRecord ) );
+			pRecord->iSession = m_vDirty[ i ]->first;
+		}
+
+		pRecord = get_Records( m_oTable ) + oSession.iRecord;
+		pState = &pRecord->aStates[ get_Committed_Slot( *pRecord, iCommitted ) == 0 ? 1 : 0 ];
+		pState->dValue = oSession.oCalculator.read_Value( );
+		pState->dMemory = oSession.oCalculator.pull_Mem( );
+		pState->bClosed = oSession.bClosed;
+		atomic_signal_fence( memory_order_release );
+		pState->iEpoch = iEpoch;
+		oSession.bDirty = false;
+	}
+
+	m_vDirty.clear( );
+	m_oProgress.iOffset = iOffset;
+	m_oProgress.iLine = iLine;
+	m_oProgress.bDone = bDone;
+	m_oTable.pHeader->aCheckpoints[ iEpoch & 1 ] = m_oProgress;
+	atomic_signal_fence( memory_order_release );
+	m_oTable.pHeader->iEpoch = iEpoch;
+	return true;
+}
+
+// Grows the table, doubling it, until it has room for iRecords records.
+bool ShardWorker::reserve( unsigned long long iRecords )
+{
+	size_t iSize = m_oTable.iSize;
+	void* pMapping = NULL;
+
+	if( get_Table_Size( iRecords ) <= iSize )
+		return true;
+
+	while( iSize < get_Table_Size( iRecords ) )
+		iSize = get_Table_Size( 2 * ( ( iSize - sizeof( ShardHeader ) ) / sizeof( ShardRecord ) ) + SHARD_INITIAL_RECORDS );
+
+	if( ftruncate( m_oTable.iFile, (off_t) iSize ) != 0 )
+	{
+		perror( "shard table" );
+		return false;
+	}
+
+	pMapping = mremap( m_oTable.pHeader, m_oTable.iSize, iSize, MREMAP_MAYMOVE );
+
+	if( pMapping == MAP_FAILED )
+	{
+		perror( "shard table" );
+		return false;
+	}
+
+	m_oTable.pHeader = (ShardHeader*) pMapping;
+	m_oTable.iSize = iSize;
+	return true;
+}
+
+/*********************************************************************\
+ *	NUMA Nodes														 *
+\*********************************************************************/
+
+// Parses a kernel list like "0-3,8,10-11".
+static void parse_List( const char* sText, vector< unsigned int >& vItems )
+{
+	const char* pCurr = sText;
+
+	while( *pCurr >= '0' && *pCurr <= '9' )
+	{
+		char* pEnd = NULL;
+		unsigned long iFirst = strtoul( pCurr, &pEnd, 10 );
+		unsigned long iLast = iFirst;
+
+		if( *pEnd == '-' )
+			iLast = strtoul( pEnd + 1, &pEnd, 10 );
+
+		for( unsigned long i = iFirst; i <= iLast; ++i )
+			vItems.push_back( (unsigned int) i );
+
+		pCurr = *pEnd == ',' ? pEnd + 1 : pEnd;
+	}
+}
+
+// Reads a one line file of the kernel's.
+static bool read_Line( const char* sPath, char* sLine, size_t iSize )
+{
+	FILE* pFile = fopen( sPath, "r" );
+	bool bRead = false;
+
+	if( pFile == NULL )
+		return false;
+
+	bRead = fgets( sLine, (int) iSize, pFile ) != NULL;
+	fclose( pFile );
+	return bRead;
+}
+
+// Finds the CPUs of every NUMA node that has any.
+//	Returns:
+//		A CPU set per node, or none on a machine with a single node, where
+//		pinning would gain nothing.
+//////////////////////////////////////////////////////////////////////////////
+static vector< cpu_set_t > get_Nodes( )
+{
+	vector< cpu_set_t > vNodes;
+	vector< unsigned int > vIDs;
+	char sLine[ 4096 ];
+	char sPath[ 128 ];
+
+	if( !read_Line( SHARD_NODE_PATH "/online", sLine, sizeof( sLine ) ) )
+		return vNodes;
+
+	parse_List( sLine, vIDs );
+
+	for( size_t i = 0; i < vIDs.size( ); ++i )
+	{
+		vector< unsigned int > vCpus;
+		cpu_set_t oSet;
+
+		snprintf( sPath, sizeof( sPath ), SHARD_NODE_PATH "/node%u/cpulist", vIDs[ i ] );
+
+		if( !read_Line( sPath, sLine, sizeof( sLine ) ) )
+			continue;
+
+		parse_List( sLine, vCpus );
+		CPU_ZERO( &oSet );
+
+		for( size_t j = 0; j < vCpus.size( ); ++j )
+		{
+			if( vCpus[ j ] < CPU_SETSIZE )
+				CPU_SET( vCpus[ j ], &oSet );
+		}
+
+		if( CPU_COUNT( &oSet ) > 0 )
+			vNodes.push_back( oSet );
+	}
+
+	if( vNodes.size( ) < 2 )
+		vNodes.clear( );
+
+	return vNodes;
+}
+
+/*********************************************************************\
+ *	Parent															 *
+\*********************************************************************/
+
+// A shard as the parent tracks it.
+struct ShardProcess
+{
+	pid_t iProcess;						// 0 once done
+	int iTable;
+	unsigned int iRestarts;
+};
+
+// A session's result, read out of a table.
+struct ShardResult
+{
+	unsigned long long iSession;
+	double dValue;
+	double dMemory;
+};
+
+// Forks the worker for a shard, pinned to the CPUs of its node.
+//	Returns:
+//		false if the process could not be started.
+//////////////////////////////////////////////////////////////////////////////
+static bool start_Worker( ShardProcess& oShard, unsigned int iShard, const ShardOptions& oOptions,
+						  unsigned int iShardCount, const char* pInput, size_t iInputSize,
+						  const vector< cpu_set_t >& vNodes )
+{
+	const pid_t iParent = getpid( );
+
+	// Anything buffered would otherwise be written again by the child.
+	fflush( NULL );
+	oShard.iProcess = fork( );
+
+	if( oShard.iProcess < 0 )
+	{
+		perror( "fork" );
+		oShard.iProcess = 0;
+		return false;
+	}
+
+	if( oShard.iProcess == 0 )
+	{
+		// A worker never outlives the run.
+		if( prctl( PR_SET_PDEATHSIG, SIGKILL ) != 0 || getppid( ) != iParent )
+			_exit( 1 );
+
+		if( !vNodes.empty( ) )
+			sched_setaffinity( 0, sizeof( cpu_set_t ), &vNodes[ iShard % vNodes.size( ) ] );
+
+		ShardWorker oWorker( pInput, iInputSize, iShard, iShardCount, oShard.iTable, oOptions.iCacheBudget );
+
+		// _exit, so the parent's buffers and static objects are left alone.
+		_exit( oWorker.run( ) );
+	}
+
+	return true;
+}
+
+// Returns the input lines a restarted worker will skip: those read by
+// its shard's last checkpoint, unless it used variables.
+static unsigned long long get_Resume_Line( int iTable )
+{
+	ShardTable oTable;
+	unsigned long long iLine = 0;
+
+	if( map_Table( oTable, iTable, false ) )
+	{
+		const ShardCheckpoint& oCheckpoint = oTable.pHeader->aCheckpoints[ oTable.pHeader->iEpoch & 1 ];
+
+		if( oTable.pHeader->iEpoch != 0 && !oCheckpoint.bVariables )
+			iLine = oCheckpoint.iLine;
+
+		unmap_Table( oTable );
+	}
+
+	return iLine;
+}
+
+// Waits for every worker, restarting the ones that die.
+//	Returns:
+//		false if a shard died more than SHARD_MAX_RESTARTS times or a
+//		worker could not be started; the others are stopped.
+//////////////////////////////////////////////////////////////////////////////
+static bool wait_Workers( vector< ShardProcess >& vShards, const ShardOptions& oOptions,
+						  const char* pInput, size_t iInputSize, const vector< cpu_set_t >& vNodes )
+{
+	size_t iRunning = 0;
+	bool bFailed = false;
+
+	for( size_t i = 0; i < vShards.size( ) && !bFailed; ++i )
+	{
+		bFailed = !start_Worker( vShards[ i ], (unsigned int) i, oOptions, (unsigned int) vShards.size( ),
+								 pInput, iInputSize, vNodes );
+		iRunning += bFailed ? 0 : 1;
+	}
+
+	while( iRunning > 0 )
+	{
+		int iStatus = 0;
+		pid_t iProcess = waitpid( -1, &iStatus, 0 );
+		size_t iShard = 0;
+
+		if( iProcess < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+
+			perror( "waitpid" );
+			return false;
+		}
+
+		while( iShard < vShards.size( ) && vShards[ iShard ].iProcess != iProcess )
+			++iShard;
+
+		if( iShard == vShards.size( ) )
+			continue;
+
+		vShards[ iShard ].iProcess = 0;
+		--iRunning;
+
+		if( ( WIFEXITED( iStatus ) && WEXITSTATUS( iStatus ) == 0 ) || bFailed )
+			continue;
+
+		if( WIFSIGNALED( iStatus ) )
+			fprintf( stderr, "Shard %llu worker killed by signal %d", (unsigned long long) iShard, WTERMSIG( iStatus ) );
+		else
+			fprintf( stderr, "Shard %llu worker exited with status %d", (unsigned long long) iShard, WEXITSTATUS( iStatus ) );
+
+		if( vShards[ iShard ].iRestarts == SHARD_MAX_RESTARTS )
+		{
+			fprintf( stderr, "; giving up after %u restarts.\n", SHARD_MAX_RESTARTS );
+			bFailed = true;
+
+			for( size_t i = 0; i < vShards.size( ); ++i )
+			{
+				if( vShards[ i ].iProcess != 0 )
+					kill( vShards[ i ].iProcess, SIGKILL );
+			}
+
+			continue;
+		}
+
+		fprintf( stderr, "; restarting it from line %llu.\n", get_Resume_Line( vShards[ iShard ].iTable ) + 1 );
+		++vShards[ iShard ].iRestarts;
+
+		if( start_Worker( vShards[ iShard ], (unsigned int) iShard, oOptions, (unsigned int) vShards.size( ),
+						  pInput, iInputSize, vNodes ) )
+			++iRunning;
+		else
+			bFailed = true;
+	}
+
+	return !bFailed;
+}
+
+// Reads the committed sessions out of every table.
+//	Returns:
+//		The number of rejected lines, or ~0 if a table could not be read.
+//////////////////////////////////////////////////////////////////////////////
+static unsigned long long collect_Results( const vector< ShardProcess >& vShards, vector< ShardResult >& vResults,
+										   bool bStats )
+{
+	unsigned long long iErrors = 0;
+
+	for( size_t i = 0; i < vShards.size( ); ++i )
+	{
+		ShardTable oTable;
+		const ShardRecord* pRecords = NULL;
+		unsigned long long iEpoch = 0;
+
+		if( !map_Table( oTable, vShards[ i ].iTable, false ) )
+		{
+			perror( "shard table" );
+			return ~0ULL;
+		}
+
+		iEpoch = oTable.pHeader->iEpoch;
+		pRecords = get_Records( oTable );
+
+		const ShardCheckpoint& oCheckpoint = oTable.pHeader->aCheckpoints[ iEpoch & 1 ];
+
+		for( unsigned long long j = 0; j < oCheckpoint.iRecords; ++j )
+		{
+			const int iSlot = get_Committed_Slot( pRecords[ j ], iEpoch );
+			ShardResult oResult = { pRecords[ j ].iSession, 0.0, 0.0 };
+
+			if( iSlot >= 0 )
+			{
+				oResult.dValue = pRecords[ j ].aStates[ iSlot ].dValue;
+				oResult.dMemory = pRecords[ j ].aStates[ iSlot ].dMemory;
+			}
+
+			vResults.push_back( oResult );
+		}
+
+		if( bStats )
+			fprintf( stderr, "shard %llu: sessions=%llu lines=%llu errors=%llu restarts=%u checkpoints=%llu\n",
+					 (unsigned long long) i, oCheckpoint.iRecords, oCheckpoint.iLines, oCheckpoint.iErrors,
+					 vShards[ i ].iRestarts, iEpoch );
+
+		iErrors += oCheckpoint.iErrors;
+		unmap_Table( oTable );
+	}
+
+	return iErrors;
+}
+
+// Runs a file of session-tagged lines over worker processes and prints
+// "<session> <value> <memory>" for every session, in order of session ID.
+//	Parameters:
+//		oOptions : ShardOptions - The input, the workers and the output.
+//	Returns:
+//		0 on success, 1 if a line was rejected, the input could not be
+//		read or a shard could not be finished.
+//////////////////////////////////////////////////////////////////////////////
+int run_Sharded( const ShardOptions& oOptions )
+{
+	const vector< cpu_set_t > vNodes = get_Nodes( );
+	unsigned int iWorkerCount = oOptions.iWorkerCount;
+	vector< ShardProcess > vShards;
+	vector< ShardResult > vResults;
+	chrono::steady_clock::time_point oStart = chrono::steady_clock::now( );
+	unsigned long long iErrors = 0;
+	const char* pInput = NULL;
+	size_t iInputSize = 0;
+	const ShardProcess oNoShard = { 0, -1, 0 };
+	struct stat oStat;
+	bool bTables = true;
+	bool bFinished = false;
+	int iInput = open( oOptions.sInputPath, O_RDONLY | O_CLOEXEC );
+
+	if( iInput < 0 || fstat( iInput, &oStat ) != 0 )
+	{
+		fprintf( stderr, "Unable to open input \"%s\".\n", oOptions.sInputPath );
+
+		if( iInput >= 0 )
+			close( iInput );
+
+		return 1;
+	}
+
+	iInputSize = (size_t) oStat.st_size;
+
+	if( iInputSize > 0 )
+	{
+		void* pMapping = mmap( NULL, iInputSize, PROT_READ, MAP_PRIVATE, iInput, 0 );
+
+		if( pMapping == MAP_FAILED )
+		{
+			fprintf( stderr, "Unable to map input \"%s\".\n", oOptions.sInputPath );
+			close( iInput );
+			return 1;
+		}
+
+		madvise( pMapping, iInputSize, MADV_SEQUENTIAL );
+		pInput = (const char*) pMapping;
+	}
+
+	close( iInput );
+
+	if( iWorkerCount == 0 )
+		iWorkerCount = thread::hardware_concurrency( );
+
+	if( iWorkerCount == 0 )
+		iWorkerCount = 1;
+
+	vShards.assign( iWorkerCount, oNoShard );
+
+	for( unsigned int i = 0; i < iWorkerCount && bTables; ++i )
+	{
+		vShards[ i ].iTable = memfd_create( "calc-shard", MFD_CLOEXEC );
+		bTables = vShards[ i ].iTable >= 0 &&
+				  ftruncate( vShards[ i ].iTable, (off_t) get_Table_Size( SHARD_INITIAL_RECORDS ) ) == 0;
+
+		if( !bTables )
+			perror( "shard table" );
+	}
+
+	if( bTables && wait_Workers( vShards, oOptions, pInput, iInputSize, vNodes ) )
+	{
+		iErrors = collect_Results( vShards, vResults, oOptions.bStats );
+		bFinished = iErrors != ~0ULL;
+	}
+
+	if( bFinished )
+	{
+		BufferedWriter oWriter( oOptions.pOutput != NULL ? oOptions.pOutput : stdout );
+		char sText[ SHARD_MAX_TEXT ];
+
+		sort( vResults.begin( ), vResults.end( ), []( const ShardResult& oLeft, const ShardResult& oRight )
+		{
+			return oLeft.iSession < oRight.iSession;
+		} );
+
+		for( size_t i = 0; i < vResults.size( ); ++i )
+		{
+			char* pText = to_chars( sText, sText + SHARD_MAX_TEXT, vResults[ i ].iSession ).ptr;
+
+			*pText++ = ' ';
+			pText = to_chars( pText, sText + SHARD_MAX_TEXT, vResults[ i ].dValue, chars_format::general, 17 ).ptr;
+			*pText++ = ' ';
+			pText = to_chars( pText, sText + SHARD_MAX_TEXT, vResults[ i ].dMemory, chars_format::general, 17 ).ptr;
+			*pText++ = '\n';
+			oWriter.write( sText, (size_t)( pText - sText ) );
+		}
+
+		oWriter.flush( );
+	}
+
+	if( oOptions.bStats )
+		fprintf( stderr, "shard: workers=%u nodes=%llu sessions=%llu (%.1f ms)\n", (unsigned int) vShards.size( ),
+				 (unsigned long long) ( vNodes.empty( ) ? 1 : vNodes.size( ) ), (unsigned long long) vResults.size( ),
+				 chrono::duration< double >( chrono::steady_clock::now( ) - oStart ).count( ) * 1000.0 );
+
+	for( size_t i = 0; i < vShards.size( ); ++i )
+	{
+		if( vShards[ i ].iTable >= 0 )
+			close( vShards[ i ].iTable );
+	}
+
+	if( pInput != NULL )
+		munmap( (void*) pInput, iInputSize );
+
+	return bFinished && iErrors == 0 ? 0 : 1;
+}
+
+#else
+
+// fork, memfd and the NUMA topology in sysfs are Linux only.
+int run_Sharded( const ShardOptions& oOptions )
+{
+	(void) oOptions;
+	fprintf( stderr, "The sharded mode is only available on Linux.\n" );
+	return 1;
+}
+
+#endif
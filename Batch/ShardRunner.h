@@ -0,0 +1,57 @@
+#ifndef _SHARDRUNNER_H
+#define _SHARDRUNNER_H
+
+// Name: ShardRunner.h
+// Description: Sharded mode.  Runs a file of independent calculator
+//				sessions across worker processes and prints each session's
+//				final working value and memory.
+//
+//				Every line is "<session> <line>", as the daemon takes them
+//				(see Protocol.h); blank lines and lines starting with '#'
+//				are skipped.  Sessions are sharded over the workers by
+//				session ID, so each session's lines run in order on one
+//				worker, in a Calculator of its own.  "q" ends a session:
+//				later lines for it are ignored.
+//
+//				Each worker is a process of its own, pinned to the CPUs of
+//				one NUMA node, so its heap and sessions stay local and no
+//				allocator is shared.  Workers write their sessions into a
+//				result table in shared memory, which the parent reads in
+//				place once they are done.  The table is checkpointed every
+//				SHARD_CHECKPOINT_LINES lines of a shard; a worker that
+//				crashes is restarted up to SHARD_MAX_RESTARTS times and
+//				resumes its shard from the last checkpoint.  Variables
+//				aren't kept in the table, so a shard that used them
+//				restarts from its first line instead.  Linux only.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstddef>
+#include <cstdio>
+
+/////////////
+// Defines //
+/////////////
+#define SHARD_CHECKPOINT_LINES		65536		// Lines of a shard between checkpoints
+#define SHARD_MAX_RESTARTS			3			// Restarts of a shard before the run fails
+#define SHARD_INITIAL_RECORDS		4096		// Sessions a result table starts with room for
+
+// Options for a sharded run.
+struct ShardOptions
+{
+	const char* sInputPath;				// Session-tagged lines
+	unsigned int iWorkerCount;			// Worker processes, 0 for one per core
+	size_t iCacheBudget;				// Expression cache budget per worker, in bytes
+	FILE* pOutput;						// NULL for stdout
+	bool bStats;						// Print the per-shard counters to stderr when done
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+int run_Sharded( const ShardOptions& oOptions );
+
+#endif
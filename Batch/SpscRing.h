@@ -0,0 +1,105 @@
+#ifndef _SPSCRING_H
+#define _SPSCRING_H
+
+// Name: SpscRing.h
+// Description: Bounded lock-free queue for exactly one producer thread and
+//				one consumer thread.  Each side owns one index and keeps a
+//				cached copy of the other side's, so it only touches the
+//				other side's cache line when its copy says the ring looks
+//				full (or empty).
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <atomic>
+#include <cstddef>
+
+/////////////
+// Defines //
+/////////////
+#define SPSC_CACHE_LINE 64
+
+///////////////////////////
+// SpscRing Declaration  //
+///////////////////////////
+template< class T >
+class SpscRing
+{
+public:
+	// Capacity is rounded up to a power of two.
+	explicit SpscRing( size_t iCapacity )
+	{
+		size_t iSize = 1;
+
+		while( iSize < iCapacity )
+			iSize <<= 1;
+
+		m_pSlots = new T[ iSize ];
+		m_iMask = iSize - 1;
+		m_iHead.store( 0, std::memory_order_relaxed );
+		m_iTail.store( 0, std::memory_order_relaxed );
+		m_iCachedHead = 0;
+		m_iCachedTail = 0;
+	}
+
+	~SpscRing( )
+	{
+		delete[] m_pSlots;
+	}
+
+	// Producer side.  Returns false if the ring is full.
+	bool try_Push( const T& oValue )
+	{
+		size_t iTail = m_iTail.load( std::memory_order_relaxed );
+
+		if( iTail - m_iCachedHead > m_iMask )
+		{
+			m_iCachedHead = m_iHead.load( std::memory_order_acquire );
+
+			if( iTail - m_iCachedHead > m_iMask )
+				return false;
+		}
+
+		m_pSlots[ iTail & m_iMask ] = oValue;
+		m_iTail.store( iTail + 1, std::memory_order_release );
+		return true;
+	}
+
+	// Consumer side.  Returns false if the ring is empty.
+	bool try_Pop( T& oValue )
+	{
+		size_t iHead = m_iHead.load( std::memory_order_relaxed );
+
+		if( iHead == m_iCachedTail )
+		{
+			m_iCachedTail = m_iTail.load( std::memory_order_acquire );
+
+			if( iHead == m_iCachedTail )
+				return false;
+		}
+
+		oValue = m_pSlots[ iHead & m_iMask ];
+		m_iHead.store( iHead + 1, std::memory_order_release );
+		return true;
+	}
+
+private:
+	SpscRing( const SpscRing& );
+	SpscRing& operator=( const SpscRing& );
+
+	// Written once, read by both sides.
+	T* m_pSlots;
+	size_t m_iMask;
+
+	// Consumer's line.
+	alignas( SPSC_CACHE_LINE ) std::atomic< size_t > m_iHead;
+	size_t m_iCachedTail;
+
+	// Producer's line.
+	alignas( SPSC_CACHE_LINE ) std::atomic< size_t > m_iTail;
+	size_t m_iCachedHead;
+};
+
+#endif
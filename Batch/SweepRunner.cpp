@@ -0,0 +1,425 @@
+// Name: SweepRunner.cpp
+// Description: Runs a parameter sweep over a column of starting values.
+//				The column is cut into pieces of a few thousand values and
+//				every piece is parsed (or generated), swept and formatted
+//				on a work pool, each worker with a CalculatorBank of its
+//				own.  Pieces are handled a round at a time and written out
+//				in order after each round, so the output streams in the
+//				same order as the input however the pieces were scheduled,
+//				and memory stays bounded for any length of column.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "SweepRunner.h"
+#include "../Engine/Sweep.h"
+#include "../Engine/WorkPool.h"
+#include "../IO/BufferedIO.h"
+#include "../Metrics/Metrics.h"
+#include "../Parser/NumberParser.h"
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define SWEEP_CHUNK_BYTES	( 8 << 20 )		// Input text read per round
+#define SWEEP_PIECE_BYTES	( 128 << 10 )	// Input text per piece
+#define SWEEP_PIECE_VALUES	16384			// Generated values per piece
+#define SWEEP_ROUND_PIECES	64				// Generated pieces per round
+#define SWEEP_MAX_TEXT		32				// Room for the longest "%.17g" and its line break
+
+// An input line that isn't a number.  It is swept as NaN so the output
+// still has a row for it.
+struct SweepInputError
+{
+	unsigned long long iLine;			// Within the piece, from 1
+	size_t iColumn;						// From 0
+	const char* sMessage;
+};
+
+// A run of the column handled by one task.
+struct SweepPiece
+{
+	const char* pText;					// Lines to parse, NULL for generated values
+	size_t iTextLength;
+	unsigned long long iFirst;			// Generated: index of the first value
+	size_t iCount;						// Generated: number of values
+	unsigned long long iLines;			// Lines of text in the piece
+	vector< double > vValues;			// Starting values, then results
+	vector< char > vOutput;
+	size_t iOutputLength;
+	vector< SweepInputError > vErrors;
+};
+
+// Parses the starting values of a piece of text, one per line.  Blank
+// lines and lines starting with '#' have no value and no row.
+static void parse_Piece( SweepPiece& oPiece )
+{
+	const char* pCurr = oPiece.pText;
+	const char* pEnd = oPiece.pText + oPiece.iTextLength;
+
+	oPiece.vValues.clear( );
+	oPiece.vErrors.clear( );
+	oPiece.iLines = 0;
+
+	while( pCurr < pEnd )
+	{
+		const char* pStart = pCurr;
+		const char* pLine = pCurr;
+		const char* pLineEnd = (const char*) memchr( pCurr, '\n', (size_t)( pEnd - pCurr ) );
+		NumberResult oResult;
+		double dValue = 0.0;
+
+		if( pLineEnd == NULL )
+			pLineEnd = pEnd;
+
+		pCurr = pLineEnd < pEnd ? pLineEnd + 1 : pEnd;
+		++oPiece.iLines;
+
+		while( pLine < pLineEnd && ( *pLine == ' ' || *pLine == '\t' ) )
+			++pLine;
+
+		while( pLineEnd > pLine && ( pLineEnd[ -1 ] == ' ' || pLineEnd[ -1 ] == '\t' || pLineEnd[ -1 ] == '\r' ) )
+			--pLineEnd;
+
+		if( pLine == pLineEnd || *pLine == '#' )
+			continue;
+
+		oResult = parse_Double( pLine, pLineEnd, dValue );
+
+		if( oResult.eError != NUMBER_OK || oResult.pEnd != pLineEnd )
+		{
+			SweepInputError oError = { oPiece.iLines, (size_t)( oResult.pEnd - pStart ),
+									   oResult.eError != NUMBER_OK ? get_Number_Error( oResult.eError )
+																   : "unexpected text after the number" };
+
+			oPiece.vErrors.push_back( oError );
+			dValue = NAN;
+		}
+
+		oPiece.vValues.push_back( dValue );
+	}
+}
+
+// Generates the starting values of a piece of a range.
+static void generate_Piece( SweepPiece& oPiece, double dStart, double dStep )
+{
+	oPiece.vValues.resize( oPiece.iCount );
+	oPiece.vErrors.clear( );
+	oPiece.iLines = oPiece.iCount;
+
+	for( size_t i = 0; i < oPiece.iCount; ++i )
+		oPiece.vValues[ i ] = dStart + dStep * (double)( oPiece.iFirst + i );
+}
+
+// Formats the results of a piece as BufferedWriter::write_Double would,
+// one per line.  std::to_chars with a precision gives the same text as
+// "%.17g", several times faster than snprintf, which would otherwise be
+// most of the cost of a sweep.
+static void format_Piece( SweepPiece& oPiece )
+{
+	char* pText = NULL;
+
+	if( oPiece.vOutput.size( ) < oPiece.vValues.size( ) * SWEEP_MAX_TEXT )
+		oPiece.vOutput.resize( oPiece.vValues.size( ) * SWEEP_MAX_TEXT );
+
+	pText = oPiece.vOutput.data( );
+
+	for( size_t i = 0; i < oPiece.vValues.size( ); ++i )
+	{
+		pText = to_chars( pText, pText + SWEEP_MAX_TEXT, oPiece.vValues[ i ], chars_format::general, 17 ).ptr;
+		*pText++ = '\n';
+	}
+
+	oPiece.iOutputLength = (size_t)( pText - oPiece.vOutput.data( ) );
+}
+
+// Parses or generates, sweeps and formats the pieces of a round.  A
+// piece's task is its index in the round.
+class SweepRound : public WorkPool::Job
+{
+public:
+	SweepRound( const Sweep& oSweep, const SweepOptions& oOptions,
+				vector< unique_ptr< CalculatorBank > >& vBanks, vector< SweepPiece >& vPieces )
+		: m_oSweep( oSweep ), m_oOptions( oOptions ), m_vBanks( vBanks ), m_vPieces( vPieces ) {}
+
+	void execute( unsigned int iTask, unsigned int iWorker )
+	{
+		SweepPiece& oPiece = m_vPieces[ iTask ];
+
+		if( oPiece.pText != NULL )
+			parse_Piece( oPiece );
+		else
+			generate_Piece( oPiece, m_oOptions.dStart, m_oOptions.dStep );
+
+		m_oSweep.evaluate( *m_vBanks[ iWorker ], oPiece.vValues.data( ), oPiece.vValues.data( ),
+						   oPiece.vValues.size( ) );
+		format_Piece( oPiece );
+	}
+
+private:
+	SweepRound& operator=( const SweepRound& );
+
+	const Sweep& m_oSweep;
+	const SweepOptions& m_oOptions;
+	vector< unique_ptr< CalculatorBank > >& m_vBanks;
+	vector< SweepPiece >& m_vPieces;
+};
+
+// Reads the lines to sweep from the script and the expression.  Nothing
+// is swept unless every line compiles.
+//	Returns:
+//		false if a line was rejected or the script could not be read.
+//////////////////////////////////////////////////////////////////////////////
+static bool load_Sweep( const SweepOptions& oOptions, Calculator* const m_Calculator, Sweep& oSweep )
+{
+	CompileError oError;
+	unsigned long long iLineNumber = 0;
+	char* sLine = NULL;
+	size_t iLength = 0;
+	bool bValid = true;
+	bool bQuit = false;
+
+	if( oOptions.sScriptPath != NULL )
+	{
+		FILE* pScript = fopen( oOptions.sScriptPath, "rb" );
+
+		if( pScript == NULL )
+		{
+			fprintf( stderr, "Unable to open script \"%s\".\n", oOptions.sScriptPath );
+			return false;
+		}
+
+		BufferedReader oReader( pScript );
+
+		while( !bQuit && oReader.next_Line( sLine, iLength ) )
+		{
+			++iLineNumber;
+
+			switch( oSweep.add_Line( sLine, iLength, m_Calculator, oError ) )
+			{
+			case LINE_QUIT:
+				bQuit = true;
+				break;
+			case LINE_INVALID:
+				METRIC_COUNT_FAILURE( METRIC_SOURCE_SCRIPT, oError.sMessage );
+				fprintf( stderr, "Line %llu, column %llu: %s.\n", iLineNumber,
+						 (unsigned long long) oError.iPosition + 1, oError.sMessage );
+				bValid = false;
+				break;
+			default:
+				break;
+			}
+		}
+
+		if( oReader.failed( ) )
+		{
+			fprintf( stderr, "Error reading script.\n" );
+			bValid = false;
+		}
+
+		fclose( pScript );
+	}
+
+	if( oOptions.sExpression != NULL && !bQuit &&
+		oSweep.add_Line( oOptions.sExpression, strlen( oOptions.sExpression ), m_Calculator, oError ) == LINE_INVALID )
+	{
+		METRIC_COUNT_FAILURE( METRIC_SOURCE_SCRIPT, oError.sMessage );
+		fprintf( stderr, "Expression, column %llu: %s.\n",
+				 (unsigned long long) oError.iPosition + 1, oError.sMessage );
+		bValid = false;
+	}
+
+	return bValid;
+}
+
+// Runs a round of pieces on the pool, then writes their results and
+// reports their bad inputs in order.
+//	Parameters:
+//		iLineBase : unsigned long long - Input lines before the round,
+//										 advanced past it.
+//	Returns:
+//		The number of bad inputs in the round.
+//////////////////////////////////////////////////////////////////////////////
+static unsigned long long run_Round( WorkPool& oPool, SweepRound& oRound, vector< SweepPiece >& vPieces,
+									 size_t iPieces, vector< unsigned int >& vTasks,
+									 BufferedWriter& oWriter, unsigned long long& iLineBase,
+									 unsigned long long& iValues )
+{
+	unsigned long long iErrors = 0;
+
+	vTasks.resize( iPieces );
+
+	for( size_t i = 0; i < iPieces; ++i )
+		vTasks[ i ] = (unsigned int) i;
+
+	oPool.run( oRound, vTasks.data( ), iPieces );
+
+	for( size_t i = 0; i < iPieces; ++i )
+	{
+		const SweepPiece& oPiece = vPieces[ i ];
+
+		oWriter.write( oPiece.vOutput.data( ), oPiece.iOutputLength );
+
+		for( size_t j = 0; j < oPiece.vErrors.size( ); ++j )
+		{
+			METRIC_COUNT_FAILURE( METRIC_SOURCE_INPUT, oPiece.vErrors[ j ].sMessage );
+			fprintf( stderr, "Input line %llu, column %llu: %s.\n", iLineBase + oPiece.vErrors[ j ].iLine,
+					 (unsigned long long) oPiece.vErrors[ j ].iColumn + 1, oPiece.vErrors[ j ].sMessage );
+		}
+
+		iErrors += oPiece.vErrors.size( );
+		iLineBase += oPiece.iLines;
+		iValues += oPiece.vValues.size( );
+	}
+
+	return iErrors;
+}
+
+// Sweeps a column of starting values and prints the results, one per
+// line in the order of the inputs.
+//	Parameters:
+//		oOptions : SweepOptions - The lines, the column and the threads.
+//		m_Calculator : Calculator - Compiles the lines.  Its own value
+//									and memory aren't used or changed.
+//	Returns:
+//		0 on success, 1 if a line was rejected, an input wasn't a number
+//		or the input could not be read.
+//////////////////////////////////////////////////////////////////////////////
+int run_Sweep( const SweepOptions& oOptions, Calculator* const m_Calculator )
+{
+	Sweep oSweep;
+	FILE* pInput = stdin;
+	unsigned long long iErrors = 0;
+	unsigned long long iLineBase = 0;
+	unsigned long long iValues = 0;
+	chrono::steady_clock::time_point oStart;
+	vector< SweepPiece > vPieces;
+	vector< unsigned int > vTasks;
+	vector< unique_ptr< CalculatorBank > > vBanks;
+
+	if( !load_Sweep( oOptions, m_Calculator, oSweep ) )
+		return 1;
+
+	if( !oOptions.bRange && oOptions.sInputPath != NULL && strcmp( oOptions.sInputPath, "-" ) )
+	{
+		pInput = fopen( oOptions.sInputPath, "rb" );
+
+		if( pInput == NULL )
+		{
+			fprintf( stderr, "Unable to open input \"%s\".\n", oOptions.sInputPath );
+			return 1;
+		}
+	}
+
+	WorkPool oPool( oOptions.iThreadCount );
+	BufferedWriter oWriter( oOptions.pOutput != NULL ? oOptions.pOutput : stdout );
+	SweepRound oRound( oSweep, oOptions, vBanks, vPieces );
+
+	for( unsigned int i = 0; i < oPool.get_Thread_Count( ); ++i )
+		vBanks.push_back( unique_ptr< CalculatorBank >( new CalculatorBank( SWEEP_BLOCK_LANES ) ) );
+
+	oStart = chrono::steady_clock::now( );
+
+	if( oOptions.bRange )
+	{
+		vPieces.resize( SWEEP_ROUND_PIECES );
+
+		for( unsigned long long iFirst = 0; iFirst < oOptions.iCount; )
+		{
+			size_t iPieces = 0;
+
+			for( ; iPieces < SWEEP_ROUND_PIECES && iFirst < oOptions.iCount; ++iPieces )
+			{
+				vPieces[ iPieces ].pText = NULL;
+				vPieces[ iPieces ].iFirst = iFirst;
+				vPieces[ iPieces ].iCount = (size_t)( oOptions.iCount - iFirst < SWEEP_PIECE_VALUES
+													  ? oOptions.iCount - iFirst : SWEEP_PIECE_VALUES );
+				iFirst += vPieces[ iPieces ].iCount;
+			}
+
+			iErrors += run_Round( oPool, oRound, vPieces, iPieces, vTasks, oWriter, iLineBase, iValues );
+		}
+	}
+	else
+	{
+		vector< char > vText( SWEEP_CHUNK_BYTES );
+		size_t iHave = 0;
+		bool bEnd = false;
+
+		while( !bEnd || iHave > 0 )
+		{
+			size_t iUse = 0;
+			size_t iPieces = 0;
+
+			while( !bEnd && iHave < vText.size( ) )
+			{
+				size_t iRead = fread( vText.data( ) + iHave, 1, vText.size( ) - iHave, pInput );
+
+				bEnd = iRead == 0;
+				iHave += iRead;
+			}
+
+			// A round ends on a line break, unless the input has ended.
+			for( iUse = iHave; !bEnd && iUse > 0 && vText[ iUse - 1 ] != '\n'; --iUse )
+				;
+
+			if( !bEnd && iUse == 0 )
+			{
+				// A single line longer than the buffer.
+				vText.resize( vText.size( ) * 2 );
+				continue;
+			}
+
+			for( size_t iBegin = 0; iBegin < iUse; ++iPieces )
+			{
+				size_t iFinish = iUse - iBegin > SWEEP_PIECE_BYTES ? iBegin + SWEEP_PIECE_BYTES : iUse;
+				const char* pBreak = iFinish < iUse ? (const char*) memchr( vText.data( ) + iFinish, '\n', iUse - iFinish ) : NULL;
+
+				if( pBreak != NULL )
+					iFinish = (size_t)( pBreak - vText.data( ) ) + 1;
+				else
+					iFinish = iUse;
+
+				if( vPieces.size( ) <= iPieces )
+					vPieces.resize( iPieces + 1 );
+
+				vPieces[ iPieces ].pText = vText.data( ) + iBegin;
+				vPieces[ iPieces ].iTextLength = iFinish - iBegin;
+				iBegin = iFinish;
+			}
+
+			iErrors += run_Round( oPool, oRound, vPieces, iPieces, vTasks, oWriter, iLineBase, iValues );
+			memmove( vText.data( ), vText.data( ) + iUse, iHave - iUse );
+			iHave -= iUse;
+		}
+
+		if( ferror( pInput ) )
+		{
+			fprintf( stderr, "Error reading input.\n" );
+			++iErrors;
+		}
+
+		if( pInput != stdin )
+			fclose( pInput );
+	}
+
+	oWriter.flush( );
+
+	if( oOptions.bStats )
+		fprintf( stderr, "sweep: values=%llu lines=%llu threads=%u kernels=%s steals=%llu (%.1f ms sweeping)\n",
+				 iValues, (unsigned long long) oSweep.get_Line_Count( ), oPool.get_Thread_Count( ),
+				 CalculatorBank::get_Kernel_Name( ), oPool.get_Steals( ),
+				 chrono::duration< double >( chrono::steady_clock::now( ) - oStart ).count( ) * 1000.0 );
+
+	return iErrors == 0 ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#ifndef _SWEEPRUNNER_H
+#define _SWEEPRUNNER_H
+
+// Name: SweepRunner.h
+// Description: Sweep mode.  Applies one sequence of calculation lines to
+//				a column of starting values, read from a file or generated
+//				as a range, and prints the column of results in the same
+//				order.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "../Calculator/Calculator.h"
+#include <cstdio>
+
+// What to sweep, over what, and where the results go.
+struct SweepOptions
+{
+	const char* sScriptPath;			// Lines to apply, NULL for none
+	const char* sExpression;			// A line applied after the script's, NULL for none
+	const char* sInputPath;				// Starting values one per line, NULL or "-" for stdin
+	bool bRange;						// Generate the starting values instead of reading them
+	double dStart;						// Range: first value
+	double dStep;						// Range: value i is dStart + dStep * i
+	unsigned long long iCount;			// Range: number of values
+	unsigned int iThreadCount;			// 0 for every core
+	FILE* pOutput;						// NULL for stdout
+	bool bStats;						// Print the counters to stderr when done
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+int run_Sweep( const SweepOptions& oOptions, Calculator* const m_Calculator );
+
+#endif
@@ -0,0 +1,1435 @@
+// Name: CalcBench.cpp
+// Description: Benchmark driver for the calculator core, the parsers, the
+//				ioutil readers and whole batch runs.  Results are written as
+//				JSON (default) or CSV so runs can be compared over time.
+//
+//				Usage: CalcBench [--format json|csv] [--filter text]
+//								 [--min-time seconds] [--large]
+//
+//				--filter only runs benchmarks whose name contains the text,
+//				--large adds the 100M line end-to-end run (~1.6 GB of script
+//				in the temp directory) and the matrix products past the last
+//				level cache.  Matrix products count each multiply and each
+//				add as an operation, so ops_per_sec is FLOP/s.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "../Calculator/Calculator.h"
+#include "../Batch/BatchRunner.h"
+#include "../Batch/IntegerRunner.h"
+#include "../Batch/ShardRunner.h"
+#include "../Batch/DecimalRunner.h"
+#include "../Batch/SweepRunner.h"
+#include "../Calculator/IntegerCalculator.h"
+#include "../Calculator/DecimalCalculator.h"
+#include "../Calculator/ProgramJit.h"
+#include "../Engine/AffineScan.h"
+#include "../Engine/CalculatorBank.h"
+#include "../Engine/CellSheet.h"
+#include "../Engine/MatrixMultiplier.h"
+#include "../Engine/Sweep.h"
+#include "../IO/Journal.h"
+#include "../IO/ioutil.h"
+#include "../Library/CalcApi.h"
+#include "../Parser/ExprCache.h"
+#include "../Parser/LineParser.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+////////////////
+// Namespaces //
+////////////////
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define DEFAULT_MIN_TIME	0.25		// Seconds each benchmark runs for at least
+#define MAX_ITERATIONS		( 1ULL << 40 )
+#define E2E_SMALL_LINES		1000ULL
+#define E2E_MEDIUM_LINES	1000000ULL
+#define E2E_LARGE_LINES		100000000ULL
+#define BANK_LANES			100000
+#define DECIMAL_BENCH_SEED	88172645463325252ULL
+#define VARIABLE_BENCH_NAMES	1000000ULL
+#define CELL_BENCH_DEPTH		1000		// Cells per column of a benchmark sheet
+#define SWEEP_BENCH_VALUES		10000000ULL
+#define SHARD_BENCH_SESSIONS	10000ULL
+#define CAPI_BENCH_OPS			1024		// Operations per calc_Apply_Ops call
+#define MATRIX_BENCH_SEED		2463534242ULL
+
+/*********************************************************************\
+ *	Allocation Counting												 *
+\*********************************************************************/
+
+// Every operator new in the process is counted so benchmarks can report
+// allocations per operation.
+static atomic< unsigned long long > iAllocationCount( 0 );
+
+void* operator new( size_t iSize )
+{
+	void* pMemory = malloc( iSize > 0 ? iSize : 1 );
+
+	if( pMemory == NULL )
+		throw bad_alloc( );
+
+	iAllocationCount.fetch_add( 1, memory_order_relaxed );
+	return pMemory;
+}
+
+void* operator new[]( size_t iSize )
+{
+	return operator new( iSize );
+}
+
+void operator delete( void* pMemory ) noexcept
+{
+	free( pMemory );
+}
+
+void operator delete[]( void* pMemory ) noexcept
+{
+	free( pMemory );
+}
+
+void operator delete( void* pMemory, size_t ) noexcept
+{
+	free( pMemory );
+}
+
+void operator delete[]( void* pMemory, size_t ) noexcept
+{
+	free( pMemory );
+}
+
+/*********************************************************************\
+ *	Harness															 *
+\*********************************************************************/
+
+// Keeps results alive so the compiler can't drop the measured work.
+static volatile double dSink = 0.0;
+
+// Times the measured region of a benchmark and counts its allocations.
+class Measure
+{
+public:
+	Measure( ) : m_dSeconds( 0.0 ), m_iAllocations( 0 ), m_iStartAllocations( 0 ) {}
+
+	void start( )
+	{
+		m_iStartAllocations = iAllocationCount.load( memory_order_relaxed );
+		m_oStart = chrono::steady_clock::now( );
+	}
+
+	void stop( )
+	{
+		chrono::steady_clock::time_point oEnd = chrono::steady_clock::now( );
+
+		m_dSeconds += chrono::duration< double >( oEnd - m_oStart ).count( );
+		m_iAllocations += iAllocationCount.load( memory_order_relaxed ) - m_iStartAllocations;
+	}
+
+	double m_dSeconds;
+	unsigned long long m_iAllocations;
+
+private:
+	unsigned long long m_iStartAllocations;
+	chrono::steady_clock::time_point m_oStart;
+};
+
+// A benchmark runs iIterations operations inside oMeasure.start/stop and
+// returns the number of operations it actually performed.
+typedef function< unsigned long long( unsigned long long iIterations, Measure& oMeasure ) > BenchFunction;
+
+struct Benchmark
+{
+	string sName;
+	BenchFunction fRun;
+	unsigned long long iFixedIterations;	// Run exactly once with this many, 0 to calibrate
+};
+
+struct BenchResult
+{
+	string sName;
+	unsigned long long iOperations;
+	double dSeconds;
+	unsigned long long iAllocations;
+};
+
+// Runs a benchmark, growing the iteration count until it runs for at least
+// dMinTime seconds.
+static BenchResult run_Benchmark( const Benchmark& oBenchmark, double dMinTime )
+{
+	BenchResult oResult;
+	unsigned long long iIterations = oBenchmark.iFixedIterations > 0 ? oBenchmark.iFixedIterations : 1;
+
+	oResult.sName = oBenchmark.sName;
+
+	for( ;; )
+	{
+		Measure oMeasure;
+
+		oResult.iOperations = oBenchmark.fRun( iIterations, oMeasure );
+		oResult.dSeconds = oMeasure.m_dSeconds;
+		oResult.iAllocations = oMeasure.m_iAllocations;
+
+		if( oBenchmark.iFixedIterations > 0 || oResult.dSeconds >= dMinTime || iIterations >= MAX_ITERATIONS )
+			break;
+
+		// Aim a little past the minimum time, growing at most 100x per step.
+		if( oResult.dSeconds <= 0.0 )
+			iIterations *= 100;
+		else
+		{
+			double dScale = ( dMinTime * 1.2 ) / oResult.dSeconds;
+			iIterations = (unsigned long long)( iIterations * ( dScale < 100.0 ? ( dScale > 2.0 ? dScale : 2.0 ) : 100.0 ) );
+		}
+	}
+
+	return oResult;
+}
+
+// Writes the results in the requested format.
+static void print_Results( const vector< BenchResult >& vResults, bool bCSV )
+{
+	if( bCSV )
+		printf( "name,operations,ns_per_op,ops_per_sec,allocs_per_op\n" );
+	else
+		printf( "{\n  \"context\": { \"bank_kernel\": \"%s\", \"matrix_kernel\": \"%s\" },\n  \"benchmarks\": [\n",
+				CalculatorBank::get_Kernel_Name( ), MatrixMultiplier::get_Kernel_Name( ) );
+
+	for( size_t i = 0; i < vResults.size( ); ++i )
+	{
+		const BenchResult& oResult = vResults[ i ];
+		double dOperations = oResult.iOperations > 0 ? (double) oResult.iOperations : 1.0;
+		double dNsPerOp = oResult.dSeconds * 1e9 / dOperations;
+		double dOpsPerSec = oResult.dSeconds > 0.0 ? dOperations / oResult.dSeconds : 0.0;
+		double dAllocsPerOp = (double) oResult.iAllocations / dOperations;
+
+		if( bCSV )
+			printf( "%s,%llu,%.3f,%.1f,%.6f\n", oResult.sName.c_str( ), oResult.iOperations,
+					dNsPerOp, dOpsPerSec, dAllocsPerOp );
+		else
+			printf( "    { \"name\": \"%s\", \"operations\": %llu, \"ns_per_op\": %.3f, "
+					"\"ops_per_sec\": %.1f, \"allocs_per_op\": %.6f }%s\n",
+					oResult.sName.c_str( ), oResult.iOperations, dNsPerOp, dOpsPerSec,
+					dAllocsPerOp, i + 1 < vResults.size( ) ? "," : "" );
+	}
+
+	if( !bCSV )
+		printf( "  ]\n}\n" );
+}
+
+/*********************************************************************\
+ *	Calculator Benchmarks											 *
+\*********************************************************************/
+
+// Calculator::process_Calculation with one operator.  The operand keeps the
+// working value finite for any iteration count.
+static Benchmark bench_Process( char cOperator, double dOperand )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( "calculator/process_Calculation/" ) + cOperator;
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		Calculator oCalculator;
+
+		oCalculator.set_Value( 1.0 );
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+			oCalculator.process_Calculation( cOperator, dOperand );
+
+		oMeasure.stop( );
+		dSink = oCalculator.read_Value( );
+		return iIterations;
+	};
+
+	return oBenchmark;
+}
+
+// IntegerCalculator::process_Calculation with one operator, on the 64 bit
+// fast path.
+static Benchmark bench_Integer_Process( char cOperator, long long iOperand )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( "integer/process_Calculation/" ) + cOperator;
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		IntegerCalculator oCalculator;
+		ExactInteger oOperand( iOperand );
+
+		oCalculator.set_Value( ExactInteger( 1000000007 ) );
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+			oCalculator.process_Calculation( cOperator, oOperand );
+
+		oMeasure.stop( );
+		dSink = oCalculator.read_Value( ).to_Double( );
+		return iIterations;
+	};
+
+	return oBenchmark;
+}
+
+// Builds a decimal from a digit string, like the parser would.
+static BigDecimal make_Decimal( const char* sInteger, const char* sFraction )
+{
+	BigDecimal oValue;
+
+	BigDecimal::parse_Digits( sInteger, strlen( sInteger ), sFraction, strlen( sFraction ), 0, oValue );
+	return oValue;
+}
+
+// DecimalCalculator::process_Calculation with one operator, at the default
+// precision, to compare with the double calculator above.
+static Benchmark bench_Decimal_Process( char cOperator, const char* sInteger, const char* sFraction )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( "decimal/process_Calculation/" ) + cOperator;
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		DecimalContext oContext = { DECIMAL_DEFAULT_PRECISION, DECIMAL_ROUND_HALF_EVEN };
+		DecimalCalculator oCalculator( oContext );
+		BigDecimal oOperand = make_Decimal( sInteger, sFraction );
+
+		oCalculator.set_Value( BigDecimal( 1 ) );
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+			oCalculator.process_Calculation( cOperator, oOperand );
+
+		oMeasure.stop( );
+		dSink = oCalculator.read_Value( ).to_Double( );
+		return iIterations;
+	};
+
+	return oBenchmark;
+}
+
+// One multiplication or division of two iDigits digit decimals, rounded to
+// iDigits digits, to show how the cost grows with the precision.
+static Benchmark bench_Decimal_Kernel( const char* sName, unsigned int iDigits, bool bDivide )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( bDivide ? "decimal/divide/" : "decimal/multiply/" ) + sName;
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		DecimalContext oContext = { iDigits, DECIMAL_ROUND_HALF_EVEN };
+		string sA( iDigits, '0' );
+		string sB( iDigits, '0' );
+		unsigned long long iState = DECIMAL_BENCH_SEED;
+
+		for( unsigned int i = 0; i < iDigits; ++i )
+		{
+			iState ^= iState << 13;
+			iState ^= iState >> 7;
+			iState ^= iState << 17;
+			sA[ i ] = (char)( '0' + iState % 10 );
+			sB[ i ] = (char)( '0' + ( iState >> 8 ) % 10 );
+		}
+
+		sA[ 0 ] = sB[ 0 ] = '7';
+
+		BigDecimal oA = make_Decimal( sA.c_str( ), "" );
+		BigDecimal oB = make_Decimal( "", sB.c_str( ) );
+		BigDecimal oResult;
+
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+		{
+			oResult = oA;
+
+			if( bDivide )
+				oResult.divide( oB, oContext );
+			else
+				oResult.multiply( oB, oContext );
+		}
+
+		oMeasure.stop( );
+		dSink = oResult.to_Double( );
+		return iIterations;
+	};
+
+	return oBenchmark;
+}
+
+// OperandStats over operands of mixed signs and magnitudes, per operand,
+// one at a time as Calculator adds them or in blocks as AffineScan does.
+// The operands are made before the clock starts.
+static Benchmark bench_Operand_Stats( bool bBlock )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = bBlock ? "stats/add_Values/256" : "stats/add";
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		OperandStats oStats;
+		double aOperands[ AFFINE_SCAN_STATS_BLOCK ];
+
+		for( size_t i = 0; i < AFFINE_SCAN_STATS_BLOCK; ++i )
+			aOperands[ i ] = ( i % 3 == 0 ? -1.0 : 1.0 ) * ( 0.5 + i ) * ( i % 5 == 0 ? 1e12 : 1e-3 );
+
+		// Bucket pages are allocated on first use, outside the clock.
+		oStats.add_Values( aOperands, AFFINE_SCAN_STATS_BLOCK );
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+		{
+			if( bBlock )
+				oStats.add_Values( aOperands, AFFINE_SCAN_STATS_BLOCK );
+			else
+				oStats.add( aOperands[ i % AFFINE_SCAN_STATS_BLOCK ] );
+		}
+
+		oMeasure.stop( );
+		dSink = oStats.get_Sum( );
+		return bBlock ? iIterations * AFFINE_SCAN_STATS_BLOCK : iIterations;
+	};
+
+	return oBenchmark;
+}
+
+// Calculator::isValidOperand over a mix of valid and invalid characters.
+static Benchmark bench_Valid_Operand( )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = "calculator/isValidOperand";
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = []( unsigned long long iIterations, Measure& oMeasure )
+	{
+		static const char sCandidates[] = "+-*/x%^ ";
+		Calculator oCalculator;
+		unsigned long long iValid = 0;
+
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+			iValid += oCalculator.isValidOperand( sCandidates[ i & 7 ] );
+
+		oMeasure.stop( );
+		dSink = (double) iValid;
+		return iIterations;
+	};
+
+	return oBenchmark;
+}
+
+// Interns iNames distinct names into a fresh table, per name.  The names
+// are formatted before the clock starts.
+static Benchmark bench_Intern( const char* sName, unsigned long long iNames )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( "calculator/intern_Variable/" ) + sName;
+	oBenchmark.iFixedIterations = 1;
+	oBenchmark.fRun = [=]( unsigned long long, Measure& oMeasure ) -> unsigned long long
+	{
+		vector< char > vNames( (size_t) iNames * 24 );
+		Calculator oCalculator;
+		unsigned long long iSlots = 0;
+
+		for( unsigned long long i = 0; i < iNames; ++i )
+			snprintf( &vNames[ (size_t) i * 24 ], 24, "v%llu", i );
+
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iNames; ++i )
+		{
+			const char* sText = &vNames[ (size_t) i * 24 ];
+			iSlots += oCalculator.intern_Variable( sText, strlen( sText ) );
+		}
+
+		oMeasure.stop( );
+		dSink = (double) iSlots;
+		return iNames;
+	};
+
+	return oBenchmark;
+}
+
+// CalculatorBank broadcast operations, per lane.
+static Benchmark bench_Bank( char cOperator, double dOperand )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( "bank/process_Calculation/" ) + cOperator;
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		CalculatorBank oBank( BANK_LANES );
+
+		oBank.process_Calculation( '+', 1.0 );
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+			oBank.process_Calculation( cOperator, dOperand );
+
+		oMeasure.stop( );
+		dSink = oBank.read_Value( (size_t) 0 );
+		return iIterations * BANK_LANES;
+	};
+
+	return oBenchmark;
+}
+
+// The C library, one call per operation or CAPI_BENCH_OPS operations per
+// call, per operation.
+static Benchmark bench_Api_Apply( bool bArray )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = bArray ? "capi/calc_Apply_Ops/1k" : "capi/calc_Apply";
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		CalcSession* pSession = calc_Create_Session( );
+		CalcOp aOps[ CAPI_BENCH_OPS ];
+		size_t iApplied = 0;
+
+		for( size_t i = 0; i < CAPI_BENCH_OPS; ++i )
+		{
+			aOps[ i ].cOpCode = i % 2 == 0 ? CALC_OP_ADD : CALC_OP_MULTIPLY;
+			memset( aOps[ i ].aReserved, 0, sizeof( aOps[ i ].aReserved ) );
+			aOps[ i ].dValue = i % 2 == 0 ? 1.5 : 0.5;
+		}
+
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+		{
+			if( bArray )
+				calc_Apply_Ops( pSession, aOps, CAPI_BENCH_OPS, &iApplied );
+			else
+				calc_Apply( pSession, aOps[ i % 2 ].cOpCode, aOps[ i % 2 ].dValue );
+		}
+
+		oMeasure.stop( );
+		dSink = calc_Read_Value( pSession );
+		calc_Destroy_Session( pSession );
+		return bArray ? iIterations * CAPI_BENCH_OPS : iIterations;
+	};
+
+	return oBenchmark;
+}
+
+// One sweep line over BANK_LANES starting values, per value.
+static Benchmark bench_Sweep_Evaluate( const char* sName, const char* sLine )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( "bank/sweep/" ) + sName;
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		Calculator oCalculator;
+		Sweep oSweep;
+		CompileError oError;
+		CalculatorBank oBank( SWEEP_BLOCK_LANES );
+		vector< double > vInputs;
+		vector< double > vOutputs;
+
+		oSweep.add_Line( sLine, strlen( sLine ), &oCalculator, oError );
+		vInputs.resize( BANK_LANES );
+		vOutputs.resize( BANK_LANES );
+
+		for( size_t i = 0; i < vInputs.size( ); ++i )
+			vInputs[ i ] = 1.0 + i * 0.001;
+
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+			oSweep.evaluate( oBank, vInputs.data( ), vOutputs.data( ), vOutputs.size( ) );
+
+		oMeasure.stop( );
+		dSink = vOutputs[ 0 ];
+		return iIterations * BANK_LANES;
+	};
+
+	return oBenchmark;
+}
+
+/*********************************************************************\
+ *	Matrix Benchmarks												 *
+\*********************************************************************/
+
+// Fills a matrix with values in [-1, 1) from a xorshift generator.
+static void fill_Matrix( vector< double >& vValues, size_t iCount, unsigned long long iSeed )
+{
+	vValues.resize( iCount );
+
+	for( size_t i = 0; i < iCount; ++i )
+	{
+		iSeed ^= iSeed << 13;
+		iSeed ^= iSeed >> 7;
+		iSeed ^= iSeed << 17;
+		vValues[ i ] = (double)( iSeed >> 11 ) * ( 2.0 / 9007199254740992.0 ) - 1.0;
+	}
+}
+
+// Products of two n x n matrices, per floating point operation (2n^3 per
+// product).  iThreadCount is MatrixMultiplier's; bNaive times the plain
+// triple loop instead, which is what the blocked product is measured
+// against.
+static Benchmark bench_Matrix_Multiply( size_t iSize, unsigned int iThreadCount, bool bNaive )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( bNaive ? "matrix/naive/" : iThreadCount == 1 ? "matrix/multiply_serial/" : "matrix/multiply/" )
+					   + to_string( iSize );
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		MatrixMultiplier oMultiplier( iThreadCount );
+		vector< double > vA;
+		vector< double > vB;
+		vector< double > vC( iSize * iSize );
+
+		fill_Matrix( vA, iSize * iSize, MATRIX_BENCH_SEED );
+		fill_Matrix( vB, iSize * iSize, MATRIX_BENCH_SEED + 1 );
+
+		// The first product starts the pool and sizes the packing buffers.
+		if( !bNaive )
+			oMultiplier.multiply( vA.data( ), vB.data( ), vC.data( ), iSize, iSize, iSize );
+
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+		{
+			if( bNaive )
+				multiply_Naive( vA.data( ), vB.data( ), vC.data( ), iSize, iSize, iSize );
+			else
+				oMultiplier.multiply( vA.data( ), vB.data( ), vC.data( ), iSize, iSize, iSize );
+		}
+
+		oMeasure.stop( );
+		dSink = vC[ 0 ];
+		return iIterations * 2 * iSize * iSize * iSize;
+	};
+
+	return oBenchmark;
+}
+
+/*********************************************************************\
+ *	Cell Benchmarks													 *
+\*********************************************************************/
+
+// A sheet of independent columns.  The top of column g is the input "i<g>"
+// and every cell below it reads the one above and the input, so editing
+// an input dirties exactly one column.
+struct CellModel
+{
+	Calculator oCalculator;
+	CellSheet oSheet;
+
+	CellModel( unsigned int iColumns, unsigned int iDepth, unsigned int iThreadCount )
+		: oSheet( &oCalculator, iThreadCount )
+	{
+		char sName[ 32 ];
+		char sFormula[ 96 ];
+		CompileError oError;
+
+		for( unsigned int g = 0; g < iColumns; ++g )
+		{
+			snprintf( sFormula, sizeof( sFormula ), "%u", g );
+			snprintf( sName, sizeof( sName ), "i%u", g );
+			oSheet.set_Cell( sName, strlen( sName ), sFormula, strlen( sFormula ), oError );
+
+			for( unsigned int d = 0; d < iDepth; ++d )
+			{
+				if( d == 0 )
+					snprintf( sFormula, sizeof( sFormula ), "i%u * 0.5 + 1", g );
+				else
+					snprintf( sFormula, sizeof( sFormula ), "c%u_%u * 0.5 + i%u", g, d - 1, g );
+
+				snprintf( sName, sizeof( sName ), "c%u_%u", g, d );
+				oSheet.set_Cell( sName, strlen( sName ), sFormula, strlen( sFormula ), oError );
+			}
+		}
+	}
+};
+
+// Evaluates a freshly built sheet in one pass, per cell.  With one thread
+// the pass runs serially, otherwise on the work pool.
+static Benchmark bench_Cells_Recalculate( const char* sName, unsigned int iColumns, unsigned int iThreadCount )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( "cells/recalculate_all/" ) + sName;
+	oBenchmark.iFixedIterations = 1;
+	oBenchmark.fRun = [=]( unsigned long long, Measure& oMeasure ) -> unsigned long long
+	{
+		CellModel oModel( iColumns, CELL_BENCH_DEPTH, iThreadCount );
+		size_t iEvaluated = 0;
+
+		oMeasure.start( );
+		iEvaluated = oModel.oSheet.recalculate( );
+		oMeasure.stop( );
+		return iEvaluated;
+	};
+
+	return oBenchmark;
+}
+
+// Edits one input of a sheet and recalculates, per edit.  Every edit
+// dirties one column, so the cost shouldn't depend on the sheet's size.
+static Benchmark bench_Cells_Edit( const char* sName, unsigned int iColumns )
+{
+	Benchmark oBenchmark;
+	shared_ptr< unique_ptr< CellModel > > pModel = make_shared< unique_ptr< CellModel > >( );
+
+	oBenchmark.sName = string( "cells/edit_input/" ) + sName;
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		char sName[ 32 ];
+		char sFormula[ 32 ];
+		CompileError oError;
+
+		// Built once, on first use, and kept for the calibration rounds.
+		if( !*pModel )
+		{
+			pModel->reset( new CellModel( iColumns, CELL_BENCH_DEPTH, 0 ) );
+			( *pModel )->oSheet.recalculate( );
+		}
+
+		CellSheet& oSheet = ( *pModel )->oSheet;
+
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+		{
+			snprintf( sName, sizeof( sName ), "i%u", (unsigned int)( i % iColumns ) );
+			snprintf( sFormula, sizeof( sFormula ), "%u", (unsigned int)( i & 1023 ) );
+			oSheet.set_Cell( sName, strlen( sName ), sFormula, strlen( sFormula ), oError );
+			oSheet.recalculate( );
+		}
+
+		oMeasure.stop( );
+		return iIterations;
+	};
+
+	return oBenchmark;
+}
+
+/*********************************************************************\
+ *	Parser Benchmarks												 *
+\*********************************************************************/
+
+// Parses the same line over and over with the script line parser.
+static Benchmark bench_Parse_Line( const char* sName, const char* sLine )
+{
+	Benchmark oBenchmark;
+	string sText( sLine );
+
+	oBenchmark.sName = string( "parser/parse_Line/" ) + sName;
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		Calculator oCalculator;
+		Operation oOperation;
+		unsigned long long iParsed = 0;
+
+		oCalculator.intern_Variable( "x", 1 );
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+			iParsed += parse_Line( sText.c_str( ), sText.size( ), &oCalculator, oOperation ) == LINE_OPERATION;
+
+		oMeasure.stop( );
+		dSink = oOperation.dValue + (double) iParsed;
+		return iIterations;
+	};
+
+	return oBenchmark;
+}
+
+// Compiles the same expression over and over, with or without the cache.
+static Benchmark bench_Compile( const char* sName, const char* sLine, bool bCached )
+{
+	Benchmark oBenchmark;
+	string sText( sLine );
+
+	oBenchmark.sName = string( bCached ? "parser/cached_compile/" : "parser/compile_Line/" ) + sName;
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		Calculator oCalculator;
+		ExprCache oCache;
+		Program oProgram;
+		CompileError oError;
+		unsigned long long iCompiled = 0;
+
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+		{
+			if( bCached )
+				iCompiled += oCache.compile( sText.c_str( ), sText.size( ), &oCalculator, oError ) != NULL;
+			else
+				iCompiled += compile_Line( sText.c_str( ), sText.size( ), &oCalculator, oProgram, oError );
+		}
+
+		oMeasure.stop( );
+		dSink = (double) iCompiled;
+		return iIterations;
+	};
+
+	return oBenchmark;
+}
+
+// Compiled expression evaluation, natively once the line is hot or on
+// the stack machine only.
+static Benchmark bench_Execute( const char* sName, const char* sLine, bool bJit )
+{
+	Benchmark oBenchmark;
+	string sText( sLine );
+
+	oBenchmark.sName = string( "calculator/execute_Program/" ) + sName + ( bJit ? "" : "_interpreted" );
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		Calculator oCalculator;
+		Program oProgram;
+		CompileError oError;
+		bool bWasEnabled = is_Jit_Enabled( );
+
+		set_Jit_Enabled( bJit && bWasEnabled );
+		compile_Line( sText.c_str( ), sText.size( ), &oCalculator, oProgram, oError );
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+			oCalculator.execute_Program( oProgram );
+
+		oMeasure.stop( );
+		set_Jit_Enabled( bWasEnabled );
+		dSink = oCalculator.read_Value( );
+		return iIterations;
+	};
+
+	return oBenchmark;
+}
+
+/*********************************************************************\
+ *	ioutil Benchmarks												 *
+\*********************************************************************/
+
+// Discards everything written to it, so prompts cost only the stream call.
+class NullBuffer : public streambuf
+{
+protected:
+	int overflow( int c ) { return c; }
+	streamsize xsputn( const char*, streamsize iCount ) { return iCount; }
+};
+
+// Feeds an ioutil reader from an in-memory stream with one input line per
+// iteration.  cin, cout and cerr are redirected for the duration.
+static Benchmark bench_Reader( const char* sName, const char* sInputLine,
+							   function< void( bool& ) > fRead )
+{
+	Benchmark oBenchmark;
+	string sLine( sInputLine );
+
+	oBenchmark.sName = string( "ioutil/" ) + sName;
+	oBenchmark.iFixedIterations = 0;
+	oBenchmark.fRun = [=]( unsigned long long iIterations, Measure& oMeasure )
+	{
+		string sInput;
+		NullBuffer oNull;
+		bool bEOF = false;
+
+		sInput.reserve( (size_t)( iIterations * ( sLine.size( ) + 1 ) ) );
+
+		for( unsigned long long i = 0; i < iIterations; ++i )
+			sInput.append( sLine ).push_back( '\n' );
+
+		istringstream oInput( sInput );
+		streambuf* pOldIn = cin.rdbuf( oInput.rdbuf( ) );
+		streambuf* pOldOut = cout.rdbuf( &oNull );
+		streambuf* pOldErr = cerr.rdbuf( &oNull );
+
+		oMeasure.start( );
+
+		for( unsigned long long i = 0; i < iIterations && !bEOF; ++i )
+			fRead( bEOF );
+
+		oMeasure.stop( );
+
+		cin.rdbuf( pOldIn );
+		cout.rdbuf( pOldOut );
+		cerr.rdbuf( pOldErr );
+		cin.clear( );
+		return iIterations;
+	};
+
+	return oBenchmark;
+}
+
+/*********************************************************************\
+ *	End-to-End Benchmarks											 *
+\*********************************************************************/
+
+// Returns a path for a scratch file in the system temp directory.
+static string get_Temp_Path( const char* sName )
+{
+	const char* sDirectory = getenv( "TMPDIR" );
+
+	if( sDirectory == NULL )
+		sDirectory = getenv( "TEMP" );
+
+	if( sDirectory == NULL )
+		sDirectory = "/tmp";
+
+	return string( sDirectory ) + "/" + sName;
+}
+
+// Writes a synthetic script of plain operations with the odd store and
+// memory reference, from a fixed seed so every run sees the same script.
+static bool write_Script( const string& sPath, unsigned long long iLines )
+{
+	static const char* sLINES[] =
+	{
+		"+ 1.25", "* 1.0001", "- 0.5", "/ 1.0001", "+ 3.75", "* 0.9999", "- 2", "/ 0.9999"
+	};
+	FILE* pFile = fopen( sPath.c_str( ), "wb" );
+	unsigned long long iState = 88172645463325252ULL;
+
+	if( pFile == NULL )
+		return false;
+
+	for( unsigned long long i = 0; i < iLines; ++i )
+	{
+		iState ^= iState << 13;
+		iState ^= iState >> 7;
+		iState ^= iState << 17;
+
+		if( ( iState & 1023 ) == 0 )
+			fputs( "s\n", pFile );
+		else if( ( iState & 1023 ) == 1 )
+			fputs( "+ mem\n", pFile );
+		else
+		{
+			fputs( sLINES[ ( iState >> 10 ) & 7 ], pFile );
+			fputc( '\n', pFile );
+		}
+	}
+
+	return fclose( pFile ) == 0;
+}
+
+// Writes a synthetic script of whole number operations, two lines at a
+// time.  Every "* 3" is followed by "/ 3" so the value stays in 64 bits
+// whichever way '/' rounds.
+static bool write_Integer_Script( const string& sPath, unsigned long long iLines )
+{
+	static const char* sPAIRS[] =
+	{
+		"+ 125\n- 50\n", "+ 7\n- 82\n", "* 3\n/ 3\n", "+ 1000\n- 999\n",
+		"s\n= mem\n", "- 3\n+ 1\n", "* 2\n/ 2\n", "+ 11\n- 12\n"
+	};
+	FILE* pFile = fopen( sPath.c_str( ), "wb" );
+	unsigned long long iState = 88172645463325252ULL;
+
+	if( pFile == NULL )
+		return false;
+
+	for( unsigned long long i = 0; i < iLines; i += 2 )
+	{
+		iState ^= iState << 13;
+		iState ^= iState >> 7;
+		iState ^= iState << 17;
+		fputs( sPAIRS[ ( iState >> 10 ) & 7 ], pFile );
+	}
+
+	return fclose( pFile ) == 0;
+}
+
+// Writes a script that stores to and reads back iVariables variables, a
+// store every fourth line and a read of a random earlier variable on the
+// rest, so a session ends up holding every name.
+static bool write_Variable_Script( const string& sPath, unsigned long long iLines, unsigned long long iVariables )
+{
+	FILE* pFile = fopen( sPath.c_str( ), "wb" );
+	unsigned long long iState = 88172645463325252ULL;
+	unsigned long long iStored = 0;
+
+	if( pFile == NULL )
+		return false;
+
+	fputs( "s v0\n", pFile );
+	++iStored;
+
+	for( unsigned long long i = 1; i < iLines; ++i )
+	{
+		iState ^= iState << 13;
+		iState ^= iState >> 7;
+		iState ^= iState << 17;
+
+		if( ( i & 3 ) == 0 )
+		{
+			fprintf( pFile, "s v%llu\n", iStored % iVariables );
+			++iStored;
+		}
+		else
+			fprintf( pFile, "%c v%llu\n", "+-+-"[ i & 3 ], ( iState >> 8 ) % ( iStored < iVariables ? iStored : iVariables ) );
+	}
+
+	return fclose( pFile ) == 0;
+}
+
+// Writes the lines of write_Script spread over iSessions sessions, for the
+// sharded mode.
+static bool write_Session_Script( const string& sPath, unsigned long long iLines, unsigned long long iSessions )
+{
+	static const char* sLINES[] =
+	{
+		"+ 1.25", "* 1.0001", "- 0.5", "/ 1.0001", "+ 3.75", "* 0.9999", "- 2", "/ 0.9999"
+	};
+	FILE* pFile = fopen( sPath.c_str( ), "wb" );
+	unsigned long long iState = 88172645463325252ULL;
+
+	if( pFile == NULL )
+		return false;
+
+	for( unsigned long long i = 0; i < iLines; ++i )
+	{
+		iState ^= iState << 13;
+		iState ^= iState >> 7;
+		iState ^= iState << 17;
+
+		fprintf( pFile, "%llu %s\n", ( iState >> 20 ) % iSessions, sLINES[ ( iState >> 10 ) & 7 ] );
+	}
+
+	return fclose( pFile ) == 0;
+}
+
+// Runs a script of variable stores and reads through run_Batch, serially or
+// with the parallel evaluator.
+static Benchmark bench_Variable_Batch( const char* sName, unsigned long long iLines, unsigned long long iVariables,
+									   bool bParallel )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( bParallel ? "e2e/batch_parallel_variables/" : "e2e/batch_variables/" ) + sName;
+	oBenchmark.iFixedIterations = 1;
+	oBenchmark.fRun = [=]( unsigned long long, Measure& oMeasure ) -> unsigned long long
+	{
+		string sPath = get_Temp_Path( "calcbench_variables.txt" );
+		Calculator oCalculator;
+#ifdef _WIN32
+		FILE* pNull = fopen( "NUL", "w" );
+#else
+		FILE* pNull = fopen( "/dev/null", "w" );
+#endif
+		BatchOptions oOptions;
+
+		if( pNull == NULL || !write_Variable_Script( sPath, iLines, iVariables ) )
+		{
+			fprintf( stderr, "Unable to write the benchmark script to %s.\n", sPath.c_str( ) );
+			return 0;
+		}
+
+		oOptions.sScriptPath = sPath.c_str( );
+		oOptions.bFinalOnly = true;
+		oOptions.bParallel = bParallel;
+		oOptions.pOutput = pNull;
+		oMeasure.start( );
+		run_Batch( oOptions, &oCalculator );
+		oMeasure.stop( );
+		fclose( pNull );
+		remove( sPath.c_str( ) );
+		return iLines;
+	};
+
+	return oBenchmark;
+}
+
+// Runs the same whole number script through the double calculator and the
+// integer calculator, to compare the two modes end to end.
+static Benchmark bench_Integer_Batch( const char* sName, unsigned long long iLines, bool bInteger )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( bInteger ? "e2e/batch_integer/" : "e2e/batch_integer_as_double/" ) + sName;
+	oBenchmark.iFixedIterations = 1;
+	oBenchmark.fRun = [=]( unsigned long long, Measure& oMeasure ) -> unsigned long long
+	{
+		string sPath = get_Temp_Path( "calcbench_integer.txt" );
+		Calculator oCalculator;
+		IntegerCalculator oIntegerCalculator;
+#ifdef _WIN32
+		FILE* pNull = fopen( "NUL", "w" );
+#else
+		FILE* pNull = fopen( "/dev/null", "w" );
+#endif
+		BatchOptions oOptions;
+
+		if( pNull == NULL || !write_Integer_Script( sPath, iLines ) )
+		{
+			fprintf( stderr, "Unable to write the benchmark script to %s.\n", sPath.c_str( ) );
+			return 0;
+		}
+
+		oOptions.sScriptPath = sPath.c_str( );
+		oOptions.bFinalOnly = true;
+		oOptions.pOutput = pNull;
+		oMeasure.start( );
+
+		if( bInteger )
+			run_Integer_Batch( oOptions, oIntegerCalculator );
+		else
+			run_Batch( oOptions, &oCalculator );
+
+		oMeasure.stop( );
+		fclose( pNull );
+		remove( sPath.c_str( ) );
+		return iLines;
+	};
+
+	return oBenchmark;
+}
+
+// Runs the double script of bench_Batch through the decimal calculator.
+static Benchmark bench_Decimal_Batch( const char* sName, unsigned long long iLines )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( "e2e/batch_decimal/" ) + sName;
+	oBenchmark.iFixedIterations = 1;
+	oBenchmark.fRun = [=]( unsigned long long, Measure& oMeasure ) -> unsigned long long
+	{
+		string sPath = get_Temp_Path( "calcbench_decimal.txt" );
+		DecimalContext oContext = { DECIMAL_DEFAULT_PRECISION, DECIMAL_ROUND_HALF_EVEN };
+		DecimalCalculator oCalculator( oContext );
+#ifdef _WIN32
+		FILE* pNull = fopen( "NUL", "w" );
+#else
+		FILE* pNull = fopen( "/dev/null", "w" );
+#endif
+		BatchOptions oOptions;
+
+		if( pNull == NULL || !write_Script( sPath, iLines ) )
+		{
+			fprintf( stderr, "Unable to write the benchmark script to %s.\n", sPath.c_str( ) );
+			return 0;
+		}
+
+		oOptions.sScriptPath = sPath.c_str( );
+		oOptions.bFinalOnly = true;
+		oOptions.pOutput = pNull;
+		oMeasure.start( );
+		run_Decimal_Batch( oOptions, oCalculator );
+		oMeasure.stop( );
+		fclose( pNull );
+		remove( sPath.c_str( ) );
+		return iLines;
+	};
+
+	return oBenchmark;
+}
+
+// Sweeps an expression over a generated range with run_Sweep, printing
+// every result to the null device.
+static Benchmark bench_Sweep( const char* sName, unsigned long long iCount, unsigned int iThreadCount )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( "e2e/sweep/" ) + sName;
+	oBenchmark.iFixedIterations = 1;
+	oBenchmark.fRun = [=]( unsigned long long, Measure& oMeasure ) -> unsigned long long
+	{
+		Calculator oCalculator;
+#ifdef _WIN32
+		FILE* pNull = fopen( "NUL", "w" );
+#else
+		FILE* pNull = fopen( "/dev/null", "w" );
+#endif
+		SweepOptions oOptions = { NULL, "= (ans + 3) * 0.5 - ans / 4", NULL, true, 0.0, 0.001, iCount,
+								  iThreadCount, pNull, false };
+
+		if( pNull == NULL )
+			return 0;
+
+		oMeasure.start( );
+		run_Sweep( oOptions, &oCalculator );
+		oMeasure.stop( );
+
+		fclose( pNull );
+		return iCount;
+	};
+
+	return oBenchmark;
+}
+
+// Runs a session-tagged script through run_Sharded on iWorkerCount worker
+// processes, printing every session to the null device.
+static Benchmark bench_Shard( const char* sName, unsigned long long iLines, unsigned long long iSessions,
+							  unsigned int iWorkerCount )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( "e2e/shard/" ) + sName;
+	oBenchmark.iFixedIterations = 1;
+	oBenchmark.fRun = [=]( unsigned long long, Measure& oMeasure ) -> unsigned long long
+	{
+		string sPath = get_Temp_Path( "calcbench_sessions.txt" );
+#ifdef _WIN32
+		FILE* pNull = fopen( "NUL", "w" );
+#else
+		FILE* pNull = fopen( "/dev/null", "w" );
+#endif
+		ShardOptions oOptions = { NULL, iWorkerCount, EXPR_CACHE_DEFAULT_BUDGET, pNull, false };
+
+		if( pNull == NULL || !write_Session_Script( sPath, iLines, iSessions ) )
+		{
+			fprintf( stderr, "Unable to write the benchmark script to %s.\n", sPath.c_str( ) );
+			return 0;
+		}
+
+		oOptions.sInputPath = sPath.c_str( );
+		oMeasure.start( );
+		run_Sharded( oOptions );
+		oMeasure.stop( );
+		fclose( pNull );
+		remove( sPath.c_str( ) );
+		return iLines;
+	};
+
+	return oBenchmark;
+}
+
+// Runs a whole script through run_Batch, printing only the final value to
+// the null device.  With bJournal every line is also journaled to a fresh
+// session in the temp directory; with bChecked the run tests for
+// floating-point exceptions.
+static Benchmark bench_Batch( const char* sName, unsigned long long iLines, bool bParallel,
+							  bool bJournal = false, bool bPipelined = false, bool bChecked = false )
+{
+	Benchmark oBenchmark;
+
+	oBenchmark.sName = string( bParallel ? "e2e/batch_parallel" : bPipelined ? "e2e/batch_pipelined" : "e2e/batch" ) +
+					   ( bJournal ? "_journal/" : bChecked ? "_checked/" : "/" ) + sName;
+	oBenchmark.iFixedIterations = 1;
+	oBenchmark.fRun = [=]( unsigned long long, Measure& oMeasure ) -> unsigned long long
+	{
+		string sPath = get_Temp_Path( "calcbench_script.txt" );
+		string sSession = get_Temp_Path( "calcbench_session" );
+		Calculator oCalculator;
+		Journal oJournal;
+#ifdef _WIN32
+		FILE* pNull = fopen( "NUL", "w" );
+#else
+		FILE* pNull = fopen( "/dev/null", "w" );
+#endif
+		BatchOptions oOptions;
+
+		if( pNull == NULL || !write_Script( sPath, iLines ) )
+		{
+			fprintf( stderr, "Unable to write the benchmark script to %s.\n", sPath.c_str( ) );
+			return 0;
+		}
+
+		oOptions.sScriptPath = sPath.c_str( );
+		oOptions.bFinalOnly = true;
+		oOptions.bParallel = bParallel;
+		oOptions.pOutput = pNull;
+		oOptions.bPipelined = bPipelined;
+		oOptions.bChecked = bChecked;
+
+		if( bJournal )
+		{
+			remove( ( sSession + "/journal" ).c_str( ) );
+			remove( ( sSession + "/snapshot" ).c_str( ) );
+
+			if( !oJournal.open( sSession.c_str( ), &oCalculator ) )
+			{
+				fprintf( stderr, "Unable to open the benchmark session %s.\n", sSession.c_str( ) );
+				fclose( pNull );
+				return 0;
+			}
+
+			oOptions.pJournal = &oJournal;
+		}
+
+		oMeasure.start( );
+		run_Batch( oOptions, &oCalculator );
+		oMeasure.stop( );
+
+		if( bJournal )
+		{
+			oJournal.close( );
+			remove( ( sSession + "/journal" ).c_str( ) );
+			remove( ( sSession + "/snapshot" ).c_str( ) );
+			remove( sSession.c_str( ) );
+		}
+
+		fclose( pNull );
+		remove( sPath.c_str( ) );
+		return iLines;
+	};
+
+	return oBenchmark;
+}
+
+//////////
+// Main //
+//////////
+int main( int argc, char* argv[] )
+{
+	vector< Benchmark > vBenchmarks;
+	vector< BenchResult > vResults;
+	const char* sFilter = NULL;
+	double dMinTime = DEFAULT_MIN_TIME;
+	bool bCSV = false;
+	bool bLarge = false;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		if( !strcmp( argv[ i ], "--format" ) && i + 1 < argc )
+			bCSV = !strcmp( argv[ ++i ], "csv" );
+		else if( !strcmp( argv[ i ], "--filter" ) && i + 1 < argc )
+			sFilter = argv[ ++i ];
+		else if( !strcmp( argv[ i ], "--min-time" ) && i + 1 < argc )
+			dMinTime = atof( argv[ ++i ] );
+		else if( !strcmp( argv[ i ], "--large" ) )
+			bLarge = true;
+		else
+		{
+			fprintf( stderr, "Usage: %s [--format json|csv] [--filter text] [--min-time seconds] [--large]\n", argv[ 0 ] );
+			return 1;
+		}
+	}
+
+	vBenchmarks.push_back( bench_Process( '+', 1.0 ) );
+	vBenchmarks.push_back( bench_Process( '-', 1.0 ) );
+	vBenchmarks.push_back( bench_Process( '*', 1.0000001 ) );
+	vBenchmarks.push_back( bench_Process( '/', 1.0000001 ) );
+	vBenchmarks.push_back( bench_Integer_Process( '+', 3 ) );
+	vBenchmarks.push_back( bench_Integer_Process( '*', 1 ) );
+	vBenchmarks.push_back( bench_Integer_Process( '/', 1 ) );
+	vBenchmarks.push_back( bench_Decimal_Process( '+', "1", "" ) );
+	vBenchmarks.push_back( bench_Decimal_Process( '*', "1", "0000001" ) );
+	vBenchmarks.push_back( bench_Decimal_Process( '/', "1", "0000001" ) );
+	vBenchmarks.push_back( bench_Decimal_Kernel( "100", 100, false ) );
+	vBenchmarks.push_back( bench_Decimal_Kernel( "1000", 1000, false ) );
+	vBenchmarks.push_back( bench_Decimal_Kernel( "10000", 10000, false ) );
+	vBenchmarks.push_back( bench_Decimal_Kernel( "100000", 100000, false ) );
+	vBenchmarks.push_back( bench_Decimal_Kernel( "100", 100, true ) );
+	vBenchmarks.push_back( bench_Decimal_Kernel( "1000", 1000, true ) );
+	vBenchmarks.push_back( bench_Decimal_Kernel( "10000", 10000, true ) );
+	vBenchmarks.push_back( bench_Decimal_Kernel( "100000", 100000, true ) );
+	vBenchmarks.push_back( bench_Valid_Operand( ) );
+	vBenchmarks.push_back( bench_Operand_Stats( false ) );
+	vBenchmarks.push_back( bench_Operand_Stats( true ) );
+	vBenchmarks.push_back( bench_Intern( "1M", VARIABLE_BENCH_NAMES ) );
+	vBenchmarks.push_back( bench_Execute( "constant", "+ 2.5", true ) );
+	vBenchmarks.push_back( bench_Execute( "expression", "= (ans + 3) * 0.5 - mem / 4", true ) );
+	vBenchmarks.push_back( bench_Execute( "expression", "= (ans + 3) * 0.5 - mem / 4", false ) );
+	vBenchmarks.push_back( bench_Bank( '+', 1.0 ) );
+	vBenchmarks.push_back( bench_Bank( '/', 1.0000001 ) );
+	vBenchmarks.push_back( bench_Api_Apply( false ) );
+	vBenchmarks.push_back( bench_Api_Apply( true ) );
+	vBenchmarks.push_back( bench_Sweep_Evaluate( "constant", "+ 2.5" ) );
+	vBenchmarks.push_back( bench_Sweep_Evaluate( "expression", "= (ans + 3) * 0.5 - mem / 4" ) );
+	vBenchmarks.push_back( bench_Cells_Recalculate( "1M_serial", 1000, 1 ) );
+	vBenchmarks.push_back( bench_Cells_Recalculate( "1M", 1000, 0 ) );
+	vBenchmarks.push_back( bench_Cells_Edit( "10k", 10 ) );
+	vBenchmarks.push_back( bench_Cells_Edit( "1M", 1000 ) );
+
+	for( size_t iSize = 8; iSize <= 1024; iSize *= 2 )
+	{
+		vBenchmarks.push_back( bench_Matrix_Multiply( iSize, 0, false ) );
+		vBenchmarks.push_back( bench_Matrix_Multiply( iSize, 1, false ) );
+
+		if( iSize <= 512 )
+			vBenchmarks.push_back( bench_Matrix_Multiply( iSize, 1, true ) );
+	}
+
+	vBenchmarks.push_back( bench_Parse_Line( "number", "* 3.14159265358979" ) );
+	vBenchmarks.push_back( bench_Parse_Line( "mem", "+ mem" ) );
+	vBenchmarks.push_back( bench_Parse_Line( "variable", "+ x" ) );
+	vBenchmarks.push_back( bench_Compile( "number", "* 3.14159265358979", false ) );
+	vBenchmarks.push_back( bench_Compile( "expression", "= (ans + 3) * 0.5 - mem / 4", false ) );
+	vBenchmarks.push_back( bench_Compile( "expression", "= (ans + 3) * 0.5 - mem / 4", true ) );
+
+	vBenchmarks.push_back( bench_Reader( "readString", "+ 12.5", []( bool& bEOF )
+	{
+		char sInput[ 32 ];
+		readString( "", sInput, 31, 3, bEOF );
+		dSink = sInput[ 0 ];
+	} ) );
+	vBenchmarks.push_back( bench_Reader( "readChar", "c", []( bool& bEOF )
+	{
+		dSink = readChar( "", bEOF, 2, 'c', 'q' );
+	} ) );
+	vBenchmarks.push_back( bench_Reader( "readInt", "123456", []( bool& bEOF )
+	{
+		dSink = readInt( "", bEOF );
+	} ) );
+
+	vBenchmarks.push_back( bench_Batch( "1k", E2E_SMALL_LINES, false ) );
+	vBenchmarks.push_back( bench_Batch( "1M", E2E_MEDIUM_LINES, false ) );
+	vBenchmarks.push_back( bench_Batch( "1M", E2E_MEDIUM_LINES, true ) );
+	vBenchmarks.push_back( bench_Batch( "1M", E2E_MEDIUM_LINES, false, true ) );
+	vBenchmarks.push_back( bench_Batch( "1M", E2E_MEDIUM_LINES, false, false, true ) );
+	vBenchmarks.push_back( bench_Batch( "1M", E2E_MEDIUM_LINES, false, false, false, true ) );
+	vBenchmarks.push_back( bench_Batch( "1M", E2E_MEDIUM_LINES, true, false, false, true ) );
+	vBenchmarks.push_back( bench_Integer_Batch( "1M", E2E_MEDIUM_LINES, false ) );
+	vBenchmarks.push_back( bench_Integer_Batch( "1M", E2E_MEDIUM_LINES, true ) );
+	vBenchmarks.push_back( bench_Decimal_Batch( "1M", E2E_MEDIUM_LINES ) );
+	vBenchmarks.push_back( bench_Variable_Batch( "4M_1k", 4 * E2E_MEDIUM_LINES, 1000, false ) );
+	vBenchmarks.push_back( bench_Variable_Batch( "4M", 4 * E2E_MEDIUM_LINES, VARIABLE_BENCH_NAMES, false ) );
+	vBenchmarks.push_back( bench_Variable_Batch( "4M", 4 * E2E_MEDIUM_LINES, VARIABLE_BENCH_NAMES, true ) );
+	vBenchmarks.push_back( bench_Sweep( "10M_serial", SWEEP_BENCH_VALUES, 1 ) );
+	vBenchmarks.push_back( bench_Sweep( "10M", SWEEP_BENCH_VALUES, 0 ) );
+	vBenchmarks.push_back( bench_Shard( "1M_10k_serial", E2E_MEDIUM_LINES, SHARD_BENCH_SESSIONS, 1 ) );
+	vBenchmarks.push_back( bench_Shard( "1M_10k", E2E_MEDIUM_LINES, SHARD_BENCH_SESSIONS, 0 ) );
+
+	if( bLarge )
+	{
+		vBenchmarks.push_back( bench_Batch( "100M", E2E_LARGE_LINES, false ) );
+		vBenchmarks.push_back( bench_Batch( "100M", E2E_LARGE_LINES, true ) );
+		vBenchmarks.push_back( bench_Matrix_Multiply( 1024, 1, true ) );
+		vBenchmarks.push_back( bench_Matrix_Multiply( 2048, 0, false ) );
+		vBenchmarks.push_back( bench_Matrix_Multiply( 2048, 1, false ) );
+		vBenchmarks.push_back( bench_Matrix_Multiply( 2048, 1, true ) );
+		vBenchmarks.push_back( bench_Matrix_Multiply( 4096, 0, false ) );
+		vBenchmarks.push_back( bench_Matrix_Multiply( 4096, 1, false ) );
+	}
+
+	for( size_t i = 0; i < vBenchmarks.size( ); ++i )
+	{
+		if( sFilter != NULL && vBenchmarks[ i ].sName.find( sFilter ) == string::npos )
+			continue;
+
+		vResults.push_back( run_Benchmark( vBenchmarks[ i ], dMinTime ) );
+	}
+
+	print_Results( vResults, bCSV );
+	return 0;
+}
@@ -7,9 +7,26 @@
 // Includes //
 //////////////
 #include "Calculator/Calculator.h"
+#include "Calculator/ProgramJit.h"
 #include "IO/ioutil.h"
+#include "Batch/BatchRunner.h"
+#include "Batch/CellRunner.h"
+#include "Batch/IntegerRunner.h"
+#include "Batch/DecimalRunner.h"
+#include "Batch/MatrixRunner.h"
+#include "Batch/Replay.h"
+#include "Batch/ShardRunner.h"
+#include "Batch/SweepRunner.h"
+#include "IO/Journal.h"
+#include "Metrics/Metrics.h"
+#include "Parser/ExprCache.h"
+#include "Parser/LineParser.h"
+#include "Server/CalcClient.h"
+#include "Server/CalcServer.h"
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <string>
 
 ////////////////
 // Namespaces //
@@ -20,47 +37,556 @@ using namespace std;
 /////////////
 // Defines //
 /////////////
-#define MAX_STR_INPUT 20
+#define MAX_STR_INPUT 256
 #define MIN_STR_INPUT 3
-#define MEM_TRIGGER "mem"
-#define MEM_CHECK_SIZE 4
-#define POSSIBLE_INPUT_COUNT 8
+#define POSSIBLE_INPUT_COUNT 10
 
 ///////////////////////////
 // Function Declarations //
 ///////////////////////////
-bool process_Calculation( const char sInput[], 
-						  char& cOperand, double& dValue, 
+bool process_Calculation( const char sInput[],
+						  Program& oProgram,
 						  Calculator* const m_Calculator );
-bool run_menu( Calculator* const m_Calculator );
-bool parse_Calculation( Calculator* const m_Calculator );
+bool run_menu( Calculator* const m_Calculator, Journal* pJournal );
+bool parse_Calculation( Calculator* const m_Calculator, Journal* pJournal );
+void apply_Operation( const Operation& oOperation,
+					  Calculator* const m_Calculator,
+					  Journal* pJournal );
+bool open_Journal( Journal& oJournal, const char* sDirectory, Calculator* const m_Calculator );
+int run_Command_Line( int argc, char* argv[], Calculator* const m_Calculator );
+void print_Usage( const char* sProgram );
 
 
 
 //////////
 // Main //
 //////////
-int main( )
+int main( int argc, char* argv[] )
 {
 	Calculator m_Calculator = Calculator( );
 	bool bFinished			= false;
 
+	// Before anything starts a thread, so SIGUSR1 only reaches the watcher.
+	watch_Metrics_Signal( );
+
+	// "--no-jit" ahead of any mode keeps every program in the interpreter.
+	if( argc > 1 && !strcmp( argv[ 1 ], "--no-jit" ) )
+	{
+		set_Jit_Enabled( false );
+		argv[ 1 ] = argv[ 0 ];
+		++argv;
+		--argc;
+	}
+
+	if( argc > 1 )
+		return run_Command_Line( argc, argv, &m_Calculator );
+
 	while( !bFinished )
-		bFinished = run_menu( &m_Calculator );
+		bFinished = run_menu( &m_Calculator, NULL );
 
 	return 0;
 }
 
+// Restores a journaled session, reporting how it went on stderr.
+//	Returns:
+//		False if the session could not be restored.
+//////////////////////////////////////////////////////////////////////////////
+bool open_Journal( Journal& oJournal, const char* sDirectory, Calculator* const m_Calculator )
+{
+	if( !oJournal.open( sDirectory, m_Calculator ) )
+	{
+		cerr << "Unable to open session \"" << sDirectory << "\": " << oJournal.get_Error( ) << ".\n";
+		return false;
+	}
+
+	if( oJournal.get_Recovered( ) > 0 )
+		cerr << "Restored session \"" << sDirectory << "\", replayed "
+			 << oJournal.get_Recovered( ) << " journaled operations.\n";
+
+	return true;
+}
+
+// Runs one of the non-interactive modes selected on the command line.
+//	Parameters:
+//		argc, argv : Command line arguments passed to main.
+//		m_Calculator : Calculator - Calculator object to run the mode with.
+//	Returns:
+//		The exit code for the program.
+//////////////////////////////////////////////////////////////////////////////
+int run_Command_Line( int argc, char* argv[], Calculator* const m_Calculator )
+{
+	Journal oJournal;
+
+	if( !strcmp( argv[ 1 ], "--journal" ) && argc == 3 )
+	{
+		bool bFinished = false;
+
+		if( !open_Journal( oJournal, argv[ 2 ], m_Calculator ) )
+			return 1;
+
+		while( !bFinished )
+			bFinished = run_menu( m_Calculator, &oJournal );
+
+		return oJournal.close( ) ? 0 : 1;
+	}
+
+	if( !strcmp( argv[ 1 ], "--batch" ) )
+	{
+		BatchOptions oOptions;
+		const char* sJournalPath = NULL;
+		bool bMetrics = false;
+		bool bInteger = false;
+		eIntegerDivision eDivision = INTEGER_DIVISION_TRUNCATE;
+		bool bDecimal = false;
+		DecimalContext oContext = { DECIMAL_DEFAULT_PRECISION, DECIMAL_ROUND_HALF_EVEN };
+		bool bMatrix = false;
+		bool bOperandStats = false;
+		int iResult = 0;
+
+		for( int i = 2; i < argc; ++i )
+		{
+			if( !strcmp( argv[ i ], "--final" ) )
+				oOptions.bFinalOnly = true;
+			else if( !strcmp( argv[ i ], "--parallel" ) )
+				oOptions.bParallel = true;
+			else if( !strcmp( argv[ i ], "--threads" ) && i + 1 < argc )
+				oOptions.iThreadCount = (unsigned int) atoi( argv[ ++i ] );
+			else if( !strcmp( argv[ i ], "--cache-bytes" ) && i + 1 < argc )
+				oOptions.iCacheBudget = (size_t) strtoull( argv[ ++i ], NULL, 10 );
+			else if( !strcmp( argv[ i ], "--cache-stats" ) )
+				oOptions.bCacheStats = true;
+			else if( !strcmp( argv[ i ], "--journal" ) && i + 1 < argc )
+				sJournalPath = argv[ ++i ];
+			else if( !strcmp( argv[ i ], "--pipeline" ) )
+				oOptions.bPipelined = true;
+			else if( !strcmp( argv[ i ], "--pipeline-depth" ) && i + 1 < argc )
+				oOptions.iPipelineDepth = (unsigned int) atoi( argv[ ++i ] );
+			else if( !strcmp( argv[ i ], "--batch-size" ) && i + 1 < argc && atoi( argv[ i + 1 ] ) > 0 )
+				oOptions.iBatchSize = (size_t) atoi( argv[ ++i ] );
+			else if( !strcmp( argv[ i ], "--pipeline-stats" ) )
+				oOptions.bPipelineStats = true;
+			else if( !strcmp( argv[ i ], "--metrics" ) )
+				bMetrics = true;
+			else if( !strcmp( argv[ i ], "--checked" ) )
+				oOptions.bChecked = true;
+			else if( !strcmp( argv[ i ], "--optimize" ) )
+				oOptions.eOptimize = oOptions.eOptimize == OPTIMIZE_FAST_MATH ? OPTIMIZE_FAST_MATH : OPTIMIZE_EXACT;
+			else if( !strcmp( argv[ i ], "--fast-math" ) )
+				oOptions.eOptimize = OPTIMIZE_FAST_MATH;
+			else if( !strcmp( argv[ i ], "--optimize-report" ) )
+				oOptions.bOptimizeReport = true;
+			else if( !strcmp( argv[ i ], "--integer" ) )
+				bInteger = true;
+			else if( !strcmp( argv[ i ], "--division" ) && i + 1 < argc && parse_Division( argv[ i + 1 ], eDivision ) )
+				++i;
+			else if( !strcmp( argv[ i ], "--decimal" ) )
+				bDecimal = true;
+			else if( !strcmp( argv[ i ], "--precision" ) && i + 1 < argc && atoi( argv[ i + 1 ] ) > 0
+					 && atoi( argv[ i + 1 ] ) <= DECIMAL_MAX_PRECISION )
+				oContext.iPrecision = (unsigned int) atoi( argv[ ++i ] );
+			else if( !strcmp( argv[ i ], "--rounding" ) && i + 1 < argc && parse_Rounding( argv[ i + 1 ], oContext.eRounding ) )
+				++i;
+			else if( !strcmp( argv[ i ], "--matrix" ) )
+				bMatrix = true;
+			else if( !strcmp( argv[ i ], "--operand-stats" ) )
+				bOperandStats = true;
+			else if( oOptions.sScriptPath == NULL && argv[ i ][ 0 ] != '-' )
+				oOptions.sScriptPath = argv[ i ];
+			else
+			{
+				print_Usage( argv[ 0 ] );
+				return 1;
+			}
+		}
+
+		if( oOptions.bOptimizeReport && oOptions.eOptimize == OPTIMIZE_OFF )
+			oOptions.eOptimize = OPTIMIZE_EXACT;
+
+		if( oOptions.eOptimize != OPTIMIZE_OFF && ( !oOptions.bFinalOnly || oOptions.bPipelined || bInteger || bDecimal || bMatrix ) )
+		{
+			cerr << "The optimizer merges lines, so it only runs with --final, and not in the\n"
+				 << "pipelined, integer, decimal or matrix modes.\n";
+			return 1;
+		}
+
+		if( oOptions.eOptimize != OPTIMIZE_OFF && oOptions.bChecked )
+		{
+			cerr << "The optimizer drops lines whose result is overwritten, along with any\n"
+				 << "division by zero or overflow in them, so it can't run with --checked.\n";
+			return 1;
+		}
+
+		if( bOperandStats && ( bInteger || bDecimal || bMatrix || oOptions.eOptimize != OPTIMIZE_OFF ) )
+		{
+			cerr << "Operand statistics are kept by the double calculator, and the optimizer\n"
+				 << "would rewrite the operands they count.\n";
+			return 1;
+		}
+
+		if( bMatrix )
+		{
+			if( bInteger || bDecimal || oOptions.bParallel || oOptions.bPipelined || sJournalPath != NULL )
+			{
+				cerr << "The matrix mode runs its script serially on its own and can't be journaled.\n";
+				return 1;
+			}
+
+			MatrixCalculator oCalculator( oOptions.iThreadCount );
+
+			iResult = run_Matrix_Batch( oOptions, oCalculator );
+
+			if( bMetrics )
+				print_Metrics( stderr );
+
+			return iResult;
+		}
+
+		if( bDecimal )
+		{
+			DecimalCalculator oCalculator( oContext );
+
+			if( bInteger || oOptions.bParallel || oOptions.bPipelined || sJournalPath != NULL )
+			{
+				cerr << "The decimal mode runs serially on its own and can't be journaled.\n";
+				return 1;
+			}
+
+			iResult = run_Decimal_Batch( oOptions, oCalculator );
+
+			if( bMetrics )
+				print_Metrics( stderr );
+
+			return iResult;
+		}
+
+		if( bInteger )
+		{
+			IntegerCalculator oCalculator( eDivision );
+
+			if( oOptions.bParallel || oOptions.bPipelined || sJournalPath != NULL )
+			{
+				cerr << "The integer mode runs serially and can't be journaled.\n";
+				return 1;
+			}
+
+			iResult = run_Integer_Batch( oOptions, oCalculator );
+
+			if( bMetrics )
+				print_Metrics( stderr );
+
+			return iResult;
+		}
+
+		if( sJournalPath != NULL && oOptions.bChecked )
+		{
+			cerr << "A checked run can't be journaled: a rejected script would already be recorded.\n";
+			return 1;
+		}
+
+		if( sJournalPath != NULL )
+		{
+			if( !open_Journal( oJournal, sJournalPath, m_Calculator ) )
+				return 1;
+
+			oOptions.pJournal = &oJournal;
+		}
+
+		if( bOperandStats )
+			m_Calculator->enable_Stats( );
+
+		iResult = run_Batch( oOptions, m_Calculator );
+
+		if( bOperandStats )
+			print_Stats( stderr, *m_Calculator->get_Stats( ) );
+
+		if( bMetrics )
+			print_Metrics( stderr );
+
+		return iResult;
+	}
+
+	if( !strcmp( argv[ 1 ], "--cells" ) )
+	{
+		BatchOptions oOptions;
+		bool bStats = false;
+		bool bMetrics = false;
+		int iResult = 0;
+
+		for( int i = 2; i < argc; ++i )
+		{
+			if( !strcmp( argv[ i ], "--threads" ) && i + 1 < argc )
+				oOptions.iThreadCount = (unsigned int) atoi( argv[ ++i ] );
+			else if( !strcmp( argv[ i ], "--cell-stats" ) )
+				bStats = true;
+			else if( !strcmp( argv[ i ], "--metrics" ) )
+				bMetrics = true;
+			else if( oOptions.sScriptPath == NULL && argv[ i ][ 0 ] != '-' )
+				oOptions.sScriptPath = argv[ i ];
+			else
+			{
+				print_Usage( argv[ 0 ] );
+				return 1;
+			}
+		}
+
+		iResult = run_Cell_Batch( oOptions, m_Calculator, bStats );
+
+		if( bMetrics )
+			print_Metrics( stderr );
+
+		return iResult;
+	}
+
+	if( !strcmp( argv[ 1 ], "--sweep" ) )
+	{
+		SweepOptions oOptions = { NULL, NULL, NULL, false, 0.0, 1.0, 0, 0, NULL, false };
+		bool bMetrics = false;
+		int iResult = 0;
+
+		for( int i = 2; i < argc; ++i )
+		{
+			if( !strcmp( argv[ i ], "--expression" ) && i + 1 < argc )
+				oOptions.sExpression = argv[ ++i ];
+			else if( !strcmp( argv[ i ], "--input" ) && i + 1 < argc )
+				oOptions.sInputPath = argv[ ++i ];
+			else if( !strcmp( argv[ i ], "--range" ) && i + 3 < argc )
+			{
+				oOptions.bRange = true;
+				oOptions.dStart = atof( argv[ ++i ] );
+				oOptions.iCount = strtoull( argv[ ++i ], NULL, 10 );
+				oOptions.dStep = atof( argv[ ++i ] );
+			}
+			else if( !strcmp( argv[ i ], "--threads" ) && i + 1 < argc )
+				oOptions.iThreadCount = (unsigned int) atoi( argv[ ++i ] );
+			else if( !strcmp( argv[ i ], "--sweep-stats" ) )
+				oOptions.bStats = true;
+			else if( !strcmp( argv[ i ], "--metrics" ) )
+				bMetrics = true;
+			else if( oOptions.sScriptPath == NULL && argv[ i ][ 0 ] != '-' )
+				oOptions.sScriptPath = argv[ i ];
+			else
+			{
+				print_Usage( argv[ 0 ] );
+				return 1;
+			}
+		}
+
+		if( ( oOptions.sScriptPath == NULL && oOptions.sExpression == NULL ) ||
+			( oOptions.bRange && oOptions.sInputPath != NULL ) )
+		{
+			print_Usage( argv[ 0 ] );
+			return 1;
+		}
+
+		iResult = run_Sweep( oOptions, m_Calculator );
+
+		if( bMetrics )
+			print_Metrics( stderr );
+
+		return iResult;
+	}
+
+	if( !strcmp( argv[ 1 ], "--shard" ) && argc >= 3 )
+	{
+		ShardOptions oOptions = { argv[ 2 ], 0, EXPR_CACHE_DEFAULT_BUDGET, NULL, false };
+
+		for( int i = 3; i < argc; ++i )
+		{
+			if( !strcmp( argv[ i ], "--workers" ) && i + 1 < argc )
+				oOptions.iWorkerCount = (unsigned int) atoi( argv[ ++i ] );
+			else if( !strcmp( argv[ i ], "--cache-bytes" ) && i + 1 < argc )
+				oOptions.iCacheBudget = (size_t) strtoull( argv[ ++i ], NULL, 10 );
+			else if( !strcmp( argv[ i ], "--shard-stats" ) )
+				oOptions.bStats = true;
+			else
+			{
+				print_Usage( argv[ 0 ] );
+				return 1;
+			}
+		}
+
+		return run_Sharded( oOptions );
+	}
+
+	if( !strcmp( argv[ 1 ], "--serve" ) && argc >= 3 )
+	{
+		ServerOptions oOptions = { argv[ 2 ], 0, EXPR_CACHE_DEFAULT_BUDGET };
+
+		for( int i = 3; i < argc; ++i )
+		{
+			if( !strcmp( argv[ i ], "--workers" ) && i + 1 < argc )
+				oOptions.iWorkerCount = (unsigned int) atoi( argv[ ++i ] );
+			else if( !strcmp( argv[ i ], "--cache-bytes" ) && i + 1 < argc )
+				oOptions.iCacheBudget = (size_t) strtoull( argv[ ++i ], NULL, 10 );
+			else
+			{
+				print_Usage( argv[ 0 ] );
+				return 1;
+			}
+		}
+
+		return run_Server( oOptions );
+	}
+
+	if( !strcmp( argv[ 1 ], "--client" ) && ( argc == 3 || argc == 4 ) )
+		return run_Client( argv[ 2 ], argc == 4 ? strtoull( argv[ 3 ], NULL, 10 ) : 1 );
+
+	if( !strcmp( argv[ 1 ], "--metrics" ) && argc == 3 )
+		return run_Metrics_Query( argv[ 2 ] );
+
+	if( !strcmp( argv[ 1 ], "--load" ) && argc >= 3 )
+	{
+		LoadOptions oOptions = { argv[ 2 ], 8, 1000, 1000000 };
+
+		for( int i = 3; i < argc; ++i )
+		{
+			if( !strcmp( argv[ i ], "--connections" ) && i + 1 < argc )
+				oOptions.iConnections = (unsigned int) atoi( argv[ ++i ] );
+			else if( !strcmp( argv[ i ], "--sessions" ) && i + 1 < argc )
+				oOptions.iSessions = strtoull( argv[ ++i ], NULL, 10 );
+			else if( !strcmp( argv[ i ], "--requests" ) && i + 1 < argc )
+				oOptions.iRequests = strtoull( argv[ ++i ], NULL, 10 );
+			else
+			{
+				print_Usage( argv[ 0 ] );
+				return 1;
+			}
+		}
+
+		return run_Load( oOptions );
+	}
+
+	if( !strcmp( argv[ 1 ], "--convert" ) && argc == 4 )
+		return run_Convert( strcmp( argv[ 2 ], "-" ) ? argv[ 2 ] : NULL, argv[ 3 ], m_Calculator );
+
+	if( !strcmp( argv[ 1 ], "--replay" ) && ( argc == 3 || ( argc == 4 && !strcmp( argv[ 3 ], "--final" ) ) ) )
+		return run_Replay( argv[ 2 ], argc == 4, m_Calculator );
+
+	print_Usage( argv[ 0 ] );
+	return 1;
+}
+
+// Prints the command line options to stderr.
+void print_Usage( const char* sProgram )
+{
+	cerr << "Usage:\n"
+		 << "\t" << sProgram << "\n"
+		 << "\t\tRun the interactive calculator.\n"
+		 << "\t" << sProgram << " --journal <session>\n"
+		 << "\t\tRun the interactive calculator, restoring and recording its\n"
+		 << "\t\tstate in the session directory.\n"
+		 << "\t" << sProgram << " --batch [script] [--final] [--parallel [--threads n]]\n"
+		 << "\t\t[--cache-bytes n] [--cache-stats] [--journal session]\n"
+		 << "\t\t[--pipeline [--pipeline-depth n] [--batch-size n] [--pipeline-stats]]\n"
+		 << "\t\t[--checked] [--optimize | --fast-math] [--optimize-report] [--metrics]\n"
+		 << "\t\t[--operand-stats]\n"
+		 << "\t\t[--integer [--division truncate|floor|exact]]\n"
+		 << "\t\t[--decimal [--precision n] [--rounding mode]] [--matrix [--threads n]]\n"
+		 << "\t\tRun a calculation script from a file or stdin, printing the\n"
+		 << "\t\tworking value after every line, or only the final value.\n"
+		 << "\t\t--parallel evaluates the whole script with the parallel\n"
+		 << "\t\tscan evaluator on n threads (default: all cores).\n"
+		 << "\t\tCompiled expressions are cached within --cache-bytes of\n"
+		 << "\t\tmemory; --cache-stats prints the cache counters.\n"
+		 << "\t\t--journal continues the session in the given directory and\n"
+		 << "\t\trecords every applied line in it.\n"
+		 << "\t\t--pipeline reads, parses and evaluates on three threads,\n"
+		 << "\t\twith n buffers in flight between stages and n operations\n"
+		 << "\t\tper batch; --pipeline-stats shows where each stage waited.\n"
+		 << "\t\t--checked rejects the script if any line divides by zero,\n"
+		 << "\t\toverflows or makes a NaN, and names the first such line.\n"
+		 << "\t\tThe check costs nothing per line; only a failing script is\n"
+		 << "\t\trun a second time, serially, to find the line.\n"
+		 << "\t\t--optimize rewrites runs of lines into fewer operations\n"
+		 << "\t\twith the same result bits: lines after a set or reset are\n"
+		 << "\t\tfolded into it, lines a later set or reset overwrites and\n"
+		 << "\t\tidentities like \"* 1\" are dropped, and division by a power\n"
+		 << "\t\tof two becomes multiplication.  --fast-math also combines\n"
+		 << "\t\tchains like \"+ 3\", \"- 1\" and \"* 2\", \"/ 3\" into one\n"
+		 << "\t\toperation, which may round differently.  Expression lines are\n"
+		 << "\t\trewritten the same way.  --optimize-report prints every\n"
+		 << "\t\trewrite and whether it changed the working value's bits.\n"
+		 << "\t\tBoth need --final and can't be combined with --checked.\n"
+		 << "\t\t--metrics prints the instrumentation counters when done.\n"
+		 << "\t\t--operand-stats prints the count, sum, mean, variance, min,\n"
+		 << "\t\tmax and quantiles of the operands applied by operators and\n"
+		 << "\t\tsets.  Sums are exact until read, so every evaluation mode\n"
+		 << "\t\tand thread count gives the same bits.\n"
+		 << "\t\t--integer works in exact integers of any size instead of\n"
+		 << "\t\tdoubles; --division picks whether '/' rounds toward zero\n"
+		 << "\t\t(default), rounds down, or rejects quotients with a remainder.\n"
+		 << "\t\t--decimal works in decimal numbers rounded to n significant\n"
+		 << "\t\tdigits (default: 34) instead of doubles; --rounding is one of\n"
+		 << "\t\thalf-even (default), half-up, half-down, down, up, ceiling\n"
+		 << "\t\tor floor.\n"
+		 << "\t\t--matrix works on matrices of doubles, printed a row per\n"
+		 << "\t\tline and ended by a blank line.  An operand is a number,\n"
+		 << "\t\tmem, ans, a matrix like [1 2; 3 4] or a quoted file name.\n"
+		 << "\t\tFiles are CSV, or the binary format \"w\" writes unless the\n"
+		 << "\t\tname ends in .csv.  + - * / work element by element, with\n"
+		 << "\t\tnumbers used on every element; \"@ b\" is the matrix product,\n"
+		 << "\t\twhich runs on n threads (default: all cores) when large;\n"
+		 << "\t\t\"w \"file\"\" saves the working value.\n"
+		 << "\t" << sProgram << " --cells [script] [--threads n] [--cell-stats] [--metrics]\n"
+		 << "\t\tRun a cell script from a file or stdin.  \"name = expression\"\n"
+		 << "\t\tsets the formula of a cell, which may read other cells by\n"
+		 << "\t\tname, and \"? name\" prints its value.  Only the cells an edit\n"
+		 << "\t\taffects are recalculated, large recalculations on n threads\n"
+		 << "\t\t(default: all cores); --cell-stats prints the sheet's counters.\n"
+		 << "\t" << sProgram << " --sweep [script] [--expression line]\n"
+		 << "\t\t[--input file|- | --range start count step] [--threads n]\n"
+		 << "\t\t[--sweep-stats] [--metrics]\n"
+		 << "\t\tApply the lines of a script, then the expression, to each\n"
+		 << "\t\tstarting value of a column and print the final values in\n"
+		 << "\t\tthe same order.  Values are read one per line from a file\n"
+		 << "\t\tor stdin, or the range start, start + step, ... is used.\n"
+		 << "\t\tEach value starts a new calculator, with memory 0, and\n"
+		 << "\t\tcan be read as \"ans\".  Runs on n threads (default: all\n"
+		 << "\t\tcores); --sweep-stats prints the counters when done.\n"
+		 << "\t" << sProgram << " --shard <input> [--workers n] [--cache-bytes n] [--shard-stats]\n"
+		 << "\t\tRun lines of many sessions, each \"<session> <line>\" as the\n"
+		 << "\t\tdaemon takes them, on n worker processes (default: one per\n"
+		 << "\t\tcore) pinned across the NUMA nodes, and print \"<session>\n"
+		 << "\t\t<value> <memory>\" for every session in order of ID.  \"q\"\n"
+		 << "\t\tends a session.  A worker that crashes is restarted from\n"
+		 << "\t\tits last checkpoint; --shard-stats prints each shard's\n"
+		 << "\t\tcounters (Linux only).\n"
+		 << "\t" << sProgram << " --convert <script|-> <log>\n"
+		 << "\t\tConvert a calculation script to a binary operation log.\n"
+		 << "\t" << sProgram << " --replay <log> [--final]\n"
+		 << "\t\tReplay a binary operation log, printing the working value\n"
+		 << "\t\tafter every operation, or only the final value.\n"
+		 << "\t" << sProgram << " --serve <socket> [--workers n] [--cache-bytes n]\n"
+		 << "\t\tServe calculator sessions over a Unix domain socket until\n"
+		 << "\t\tinterrupted (Linux only).\n"
+		 << "\t" << sProgram << " --client <socket> [session]\n"
+		 << "\t\tSend lines from stdin to a session on the daemon and print\n"
+		 << "\t\tthe answers.\n"
+		 << "\t" << sProgram << " --metrics <socket>\n"
+		 << "\t\tPrint the daemon's instrumentation counters.\n"
+		 << "\t" << sProgram << " --load <socket> [--connections n] [--sessions n] [--requests n]\n"
+		 << "\t\tDrive the daemon with many sessions and report the request\n"
+		 << "\t\trate and latency percentiles.\n"
+		 << "Any mode prints its instrumentation counters to stderr on SIGUSR1.\n"
+		 << "Any mode may be preceded by --no-jit to run compiled lines in the\n"
+		 << "interpreter only, for hosts that forbid executable memory (as does\n"
+		 << "setting CALC_NO_JIT in the environment).\n";
+}
+
 // runs a menu for the user, returns the result
 // to the caller
+//	Parameters:
+//		m_Calculator : Calculator - Calculator object to run the menu with.
+//		pJournal : Journal - Journal to record the session in, or NULL.
 //	Returns:
 //		Returns a boolean value to tell the caller if the user has
 //		ended the program or not.
 /////////////////////////////////////////////////////////////////////
-bool run_menu( Calculator* const m_Calculator )
+bool run_menu( Calculator* const m_Calculator, Journal* pJournal )
 {
 	bool bFinished = false;
 	char cSelection = ' ';
+	Operation oOperation = { 0, 0, 0.0 };
 
 	cout << "Calculator Menu: \n"
 		 << "Current Working Value:\t" << m_Calculator->read_Value( ) << "\n"
@@ -68,23 +594,31 @@ bool run_menu( Calculator* const m_Calculator )
 		 << "\tc). Perform Calculation.\n"
 		 << "\ts). Store Current Working Value.\n" 
 		 << "\tr). Reset Current Working Value.\n"
+		 << "\tm). Show Metrics.\n"
 		 << "\tq). Quit Program.\n\n";
 
-	cSelection = readChar( "Enter a Value: ", bFinished, POSSIBLE_INPUT_COUNT, 'c','C','s','S','r','R','q','Q' );
+	cSelection = readChar( "Enter a Value: ", bFinished, POSSIBLE_INPUT_COUNT, 'c','C','s','S','r','R','m','M','q','Q' );
 
 	switch( cSelection )
 	{
 	case 'C':
 	case 'c':
-		bFinished = parse_Calculation( m_Calculator );
+		bFinished = parse_Calculation( m_Calculator, pJournal );
 		break;
 	case 'S':
 	case 's':
-		m_Calculator->store_Mem( );
+		oOperation.cOpCode = OP_CODE_STORE;
+		apply_Operation( oOperation, m_Calculator, pJournal );
 		break;
 	case 'R':
 	case 'r':
-		m_Calculator->clear_Value( );
+		oOperation.cOpCode = OP_CODE_RESET;
+		apply_Operation( oOperation, m_Calculator, pJournal );
+		break;
+	case 'M':
+	case 'm':
+		print_Metrics( stdout );
+		cout << "\n";
 		break;
 	case 'Q':
 	case 'q':
@@ -96,31 +630,56 @@ bool run_menu( Calculator* const m_Calculator )
 	return bFinished;
 }
 
+// Applies an operation chosen at the menu, recording it in the journal
+// before the menu is shown again.
+//	Parameters:
+//		oOperation : Operation - The operation to apply.
+//		m_Calculator : Calculator - Calculator object to apply it to.
+//		pJournal : Journal - Journal to record it in, or NULL.
+//////////////////////////////////////////////////////////////////////////////
+void apply_Operation( const Operation& oOperation,
+					  Calculator* const m_Calculator,
+					  Journal* pJournal )
+{
+	m_Calculator->apply_Operation( oOperation );
+
+	if( pJournal != NULL )
+	{
+		pJournal->append( oOperation );
+
+		if( !pJournal->commit( ) )
+			cout << "Warning: the session could not be saved (" << pJournal->get_Error( ) << ").\n";
+	}
+}
+
 // Prompts the user for a string input for calculation,
 //	parses the input and performs the calculation.
 //
 //	Parameters:
 //		m_Calculator : Calculator - Calculator object for
 //			referencing operands and calling the process_calculation function.
+//		pJournal : Journal - Journal to record the calculation in, or NULL.
 //	Returns:
 //		Returns whether an end of file was hit or not after prompting the user.
 //////////////////////////////////////////////////////////////////////////////////
-bool parse_Calculation( Calculator* const m_Calculator )
+bool parse_Calculation( Calculator* const m_Calculator, Journal* pJournal )
 {
 	char sInputString[ MAX_STR_INPUT ] = { '\0' };
 	const char* cpAvailableOperations = m_Calculator->get_Available_Ops( );
 	bool bFinished = false;
-	bool bValid = true;
-	char cOperand = 0;
-	double dValue = 0.0;
+	Program oProgram;
 
-	cout << "\n\nSyntax: (operator) (value*)\n"
+	cout << "\n\nSyntax: (operator) (expression*)\n"
+		 << "    or: = (expression*)\n"
+		 << "    or: s (name) to store the working value in a variable\n"
 		 << "Available Operations:\n";
 
 	for( int i = 0; i < MAXIMUM_OPERATIONS; ++i )
 		cout << "\t" << cpAvailableOperations[ i ] << "\n";
 
-	cout << "*Value can be \"mem\" to use the stored value in memory.\n";
+	cout << "*Expressions may use the operations above, parentheses, numbers,\n"
+		 << " \"mem\" for the stored value in memory, \"ans\" for the\n"
+		 << " current working value and the names of stored variables.\n";
 
 	readString( "Please enter a calculation: ",
 				sInputString,
@@ -130,53 +689,52 @@ bool parse_Calculation( Calculator* const m_Calculator )
 
 	if( !bFinished )
 	{
-		if( !process_Calculation( sInputString, cOperand, dValue, m_Calculator ) )
-			cout << "Sorry, but the calculation entered could not be properly parsed. \n\n";
-		else
-			m_Calculator->process_Calculation( cOperand, dValue );
+		Operation oOperation;
+
+		// Plain lines, including "s (name)", are applied as they parse.
+		if( parse_Line( sInputString, strlen( sInputString ), m_Calculator, oOperation ) == LINE_OPERATION )
+			apply_Operation( oOperation, m_Calculator, pJournal );
+		else if( process_Calculation( sInputString, oProgram, m_Calculator ) )
+		{
+			oOperation.cOpCode = oProgram.cOperator == BC_ASSIGN ? OP_CODE_SET : (unsigned char) oProgram.cOperator;
+			oOperation.dValue = m_Calculator->evaluate_Program( oProgram );
+			apply_Operation( oOperation, m_Calculator, pJournal );
+		}
 
 	}
 
 	return bFinished;
 }
 
-// Parses the string input and pulls the desired values to return to the caller.
+// Compiles the string input into a program for the calculator to run.
 //	Parameters:
 //		sInput : String - The input to parse
-//		cOperand : Char - Operand character to return to the caller
-//		dValue : double - The value read in to return to the caller
-//		m_Calculator : Calculator - Calculator object for referencing memory and operands
+//		oProgram : Program - The compiled calculation to return to the caller
+//		m_Calculator : Calculator - Calculator object for referencing operands
 //	Returns: 
 //		True if input is valid, False otherwise
-//		Operand read in : char
-//		Value read in : double
+//		Compiled calculation : Program
 //////////////////////////////////////////////////////////////////////////////////////////////
 bool process_Calculation( const char sInput[],
-						  char& cOperand, 
-						  double& dValue, 
+						  Program& oProgram,
 						  Calculator* const m_Calculator )
 {
-	// Local variables
-	bool bValid = true;
-	char sMemChk[ MEM_CHECK_SIZE ] =
+	CompileError oError;
+	bool bCompiled = false;
+
 	{
-		sInput[2],
-		sInput[3],
-		sInput[4]
-	};
+		METRIC_TIME_SCOPE( METRIC_TIMER_PARSE );
+		bCompiled = compile_Line( sInput, strlen( sInput ), m_Calculator, oProgram, oError );
+	}
 
-	// Check Operand
-	cOperand = sInput[0];
-	bValid &= m_Calculator->isValidOperand( cOperand );
+	if( bCompiled )
+		return true;
 
-	// Ensure space between operand and value.
-	bValid &= sInput[1] == ' ';
+	METRIC_COUNT_FAILURE( METRIC_SOURCE_INTERACTIVE, oError.sMessage );
 
-	// Check value
-	if( !strcmp( sMemChk, MEM_TRIGGER ) )
-		dValue = m_Calculator->pull_Mem( );
-	else
-		dValue = atof( &(sInput[2]) );
+	cout << "Sorry, but the calculation entered could not be properly parsed:\n"
+		 << "\t" << sInput << "\n"
+		 << "\t" << string( oError.iPosition, ' ' ) << "^ " << oError.sMessage << "\n\n";
 
-	return bValid;
+	return false;
 }
\ No newline at end of file
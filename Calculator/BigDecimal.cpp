@@ -0,0 +1,730 @@
+// Name: BigDecimal.cpp
+// Description: Arithmetic, rounding and formatting of BigDecimal.  The
+//				general paths follow the reference algorithms of the General
+//				Decimal Arithmetic specification, so results match Python's
+//				decimal module digit for digit.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "BigDecimal.h"
+#include "DecimalKernels.h"
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define SMALL_MAX_DIGITS	19			// Digits that always fit in an unsigned long long
+
+// Powers of ten that fit in an unsigned long long.
+static const unsigned long long iPOWERS_64[ 20 ] =
+{
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+	1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+	100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+	1000000000000000000ULL, 10000000000000000000ULL
+};
+
+// Returns the number of decimal digits in iValue, 1 for zero.
+static size_t count_Digits_64( unsigned long long iValue )
+{
+	size_t iDigits = 1;
+
+	while( iDigits < 20 && iValue >= iPOWERS_64[ iDigits ] )
+		++iDigits;
+
+	return iDigits;
+}
+
+// Returns true if a result rounded to a whole number of its last kept
+// digit should go up by one.
+//	Parameters:
+//		eRounding : eDecimalRounding - The rounding mode.
+//		bNegative : Boolean - Sign of the result.
+//		bOdd : Boolean - Whether the last kept digit is odd.
+//		iDigit : uint32_t - The first digit dropped.
+//		bRest : Boolean - Whether anything after it was non zero.
+//////////////////////////////////////////////////////////////////////////////
+static bool round_Up( eDecimalRounding eRounding, bool bNegative, bool bOdd, uint32_t iDigit, bool bRest )
+{
+	switch( eRounding )
+	{
+	case DECIMAL_ROUND_HALF_EVEN:
+		return iDigit > 5 || ( iDigit == 5 && ( bRest || bOdd ) );
+	case DECIMAL_ROUND_HALF_UP:
+		return iDigit >= 5;
+	case DECIMAL_ROUND_HALF_DOWN:
+		return iDigit > 5 || ( iDigit == 5 && bRest );
+	case DECIMAL_ROUND_UP:
+		return iDigit != 0 || bRest;
+	case DECIMAL_ROUND_CEILING:
+		return !bNegative && ( iDigit != 0 || bRest );
+	case DECIMAL_ROUND_FLOOR:
+		return bNegative && ( iDigit != 0 || bRest );
+	case DECIMAL_ROUND_DOWN:
+	default:
+		return false;
+	}
+}
+
+// Writes a * 10^iShift to pOut, which needs iA + iShift / 9 + 1 limbs.
+//	Returns:
+//		The length written.
+//////////////////////////////////////////////////////////////////////////////
+static size_t scale_Up( uint32_t* pOut, const uint32_t* pA, size_t iA, unsigned long long iShift )
+{
+	size_t iWhole = (size_t)( iShift / DECIMAL_BASE_DIGITS );
+
+	memset( pOut, 0, iWhole * sizeof( uint32_t ) );
+	pOut[ iWhole + iA ] = multiply_Small( pOut + iWhole, pA, iA, iDECIMAL_POWERS[ iShift % DECIMAL_BASE_DIGITS ], 0 );
+	return iWhole + iA + 1;
+}
+
+/*********************************************************************\
+ *	Constructors													 *
+\*********************************************************************/
+
+BigDecimal::BigDecimal( long long iValue )
+{
+	m_bNegative = false;
+	m_iExponent = 0;
+	m_iLength = 0;
+	store_Small( iValue < 0, iValue < 0 ? 0ULL - (unsigned long long) iValue : (unsigned long long) iValue, 0 );
+}
+
+BigDecimal::BigDecimal( const BigDecimal& oOther )
+{
+	m_bNegative = false;
+	m_iExponent = 0;
+	m_iLength = 0;
+	*this = oOther;
+}
+
+// Copies only the limbs in use, so a value that was once long doesn't
+// drag its old storage along.
+BigDecimal& BigDecimal::operator=( const BigDecimal& oOther )
+{
+	if( this != &oOther )
+	{
+		const uint32_t* pLimbs = oOther.get_Limbs( );
+
+		memcpy( resize_Limbs( oOther.m_iLength ), pLimbs, oOther.m_iLength * sizeof( uint32_t ) );
+		m_bNegative = oOther.m_bNegative;
+		m_iExponent = oOther.m_iExponent;
+	}
+
+	return *this;
+}
+
+/*********************************************************************\
+ *	Storage															 *
+\*********************************************************************/
+
+// Makes room for a coefficient of iLength limbs.  The heap storage is
+// kept when a value shrinks back inline, for the next long result.
+uint32_t* BigDecimal::resize_Limbs( size_t iLength )
+{
+	m_iLength = iLength;
+
+	if( iLength <= DECIMAL_INLINE_LIMBS )
+		return m_aInline;
+
+	if( m_vHeap.size( ) < iLength )
+		m_vHeap.resize( iLength );
+
+	return m_vHeap.data( );
+}
+
+// Returns true, with the coefficient, if it fits in 64 bits.
+bool BigDecimal::get_Small( unsigned long long& iCoefficient ) const
+{
+	switch( m_iLength )
+	{
+	case 0:
+		iCoefficient = 0;
+		return true;
+	case 1:
+		iCoefficient = m_aInline[ 0 ];
+		return true;
+	case 2:
+		iCoefficient = (unsigned long long) m_aInline[ 1 ] * DECIMAL_BASE + m_aInline[ 0 ];
+		return true;
+	default:
+		return false;
+	}
+}
+
+void BigDecimal::store_Zero( bool bNegative, long long iExponent )
+{
+	m_bNegative = bNegative;
+	m_iExponent = iExponent > DECIMAL_MAX_EXPONENT ? DECIMAL_MAX_EXPONENT :
+				  iExponent < -DECIMAL_MAX_EXPONENT ? -DECIMAL_MAX_EXPONENT : iExponent;
+	m_iLength = 0;
+}
+
+eDecimalStatus BigDecimal::store_Small( bool bNegative, unsigned long long iCoefficient, long long iExponent )
+{
+	long long iAdjusted = iExponent + (long long) count_Digits_64( iCoefficient ) - 1;
+	size_t iLength = 0;
+
+	if( iCoefficient == 0 )
+	{
+		store_Zero( bNegative, iExponent );
+		return DECIMAL_OK;
+	}
+
+	if( iAdjusted > DECIMAL_MAX_EXPONENT || iAdjusted < -DECIMAL_MAX_EXPONENT )
+		return DECIMAL_OUT_OF_RANGE;
+
+	while( iCoefficient != 0 )
+	{
+		m_aInline[ iLength++ ] = (uint32_t)( iCoefficient % DECIMAL_BASE );
+		iCoefficient /= DECIMAL_BASE;
+	}
+
+	m_bNegative = bNegative;
+	m_iExponent = iExponent;
+	m_iLength = iLength;
+	return DECIMAL_OK;
+}
+
+// Stores a coefficient as it is.  pLimbs may not be this value's own.
+eDecimalStatus BigDecimal::store_Exact( bool bNegative, const uint32_t* pLimbs, size_t iLength, long long iExponent )
+{
+	long long iAdjusted = 0;
+
+	iLength = trim_Limbs( pLimbs, iLength );
+
+	if( iLength == 0 )
+	{
+		store_Zero( bNegative, iExponent );
+		return DECIMAL_OK;
+	}
+
+	iAdjusted = iExponent + (long long) count_Digits( pLimbs, iLength ) - 1;
+
+	if( iAdjusted > DECIMAL_MAX_EXPONENT || iAdjusted < -DECIMAL_MAX_EXPONENT )
+		return DECIMAL_OUT_OF_RANGE;
+
+	memcpy( resize_Limbs( iLength ), pLimbs, iLength * sizeof( uint32_t ) );
+	m_bNegative = bNegative;
+	m_iExponent = iExponent;
+	return DECIMAL_OK;
+}
+
+// Rounds a coefficient to the context's precision and stores it.
+//	Parameters:
+//		bNegative : Boolean - Sign of the result.
+//		pLimbs, iLength : The exact coefficient, or a truncated one.
+//		iExponent : long long - Power of ten of the coefficient's last digit.
+//		bInexact : Boolean - True if the coefficient was truncated, i.e. the
+//				   exact result is a little larger than it.
+//		oContext : DecimalContext - Precision and rounding.
+//	Returns:
+//		DECIMAL_OK, or DECIMAL_OUT_OF_RANGE with the value unchanged.
+//////////////////////////////////////////////////////////////////////////////
+eDecimalStatus BigDecimal::store_Rounded( bool bNegative, const uint32_t* pLimbs, size_t iLength,
+										  long long iExponent, bool bInexact, const DecimalContext& oContext )
+{
+	static const uint32_t iONE = 1;
+	size_t iDigits = 0;
+	size_t iDrop = 0;
+	uint32_t iDigit = 0;
+	bool bRest = bInexact;
+
+	iLength = trim_Limbs( pLimbs, iLength );
+	iDigits = count_Digits( pLimbs, iLength );
+
+	if( iLength == 0 || ( iDigits <= oContext.iPrecision && !bInexact ) )
+		return store_Exact( bNegative, pLimbs, iLength, iExponent );
+
+	iDrop = iDigits > oContext.iPrecision ? iDigits - oContext.iPrecision : 0;
+
+	// The first digit dropped, and whether any after it is non zero.
+	if( iDrop > 0 )
+	{
+		size_t iLimb = ( iDrop - 1 ) / DECIMAL_BASE_DIGITS;
+		uint32_t iPower = iDECIMAL_POWERS[ ( iDrop - 1 ) % DECIMAL_BASE_DIGITS ];
+
+		iDigit = pLimbs[ iLimb ] / iPower % 10;
+		bRest = bRest || pLimbs[ iLimb ] % iPower != 0;
+
+		for( size_t i = 0; i < iLimb && !bRest; ++i )
+			bRest = pLimbs[ i ] != 0;
+	}
+
+	LimbArena& oArena = get_Limb_Arena( );
+	LimbScope oScope( oArena );
+	size_t iWhole = iDrop / DECIMAL_BASE_DIGITS;
+	size_t iKept = iLength - iWhole;
+	uint32_t* pKept = oArena.allocate( iKept + 1 );
+
+	divide_Small( pKept, pLimbs + iWhole, iKept, iDECIMAL_POWERS[ iDrop % DECIMAL_BASE_DIGITS ] );
+	iKept = trim_Limbs( pKept, iKept );
+
+	if( round_Up( oContext.eRounding, bNegative, iKept > 0 && ( pKept[ 0 ] & 1 ) != 0, iDigit, bRest ) )
+	{
+		pKept[ iKept ] = add_Limbs( pKept, pKept, iKept, &iONE, 1 );
+		iKept = trim_Limbs( pKept, iKept + 1 );
+
+		// 999 rounded up is 1000, a digit too many: keep 100 and a larger
+		// exponent.
+		if( count_Digits( pKept, iKept ) > oContext.iPrecision )
+		{
+			divide_Small( pKept, pKept, iKept, 10 );
+			iKept = trim_Limbs( pKept, iKept );
+			++iDrop;
+		}
+	}
+
+	return store_Exact( bNegative, pKept, iKept, iExponent + (long long) iDrop );
+}
+
+/*********************************************************************\
+ *	Arithmetic														 *
+\*********************************************************************/
+
+// Adds or subtracts another value.
+//	Parameters:
+//		oOther : BigDecimal - The operand.
+//		bSubtract : Boolean - Subtract it instead.
+//		oContext : DecimalContext - Precision and rounding.
+//	Returns:
+//		DECIMAL_OK, or DECIMAL_OUT_OF_RANGE with the value unchanged.
+//////////////////////////////////////////////////////////////////////////////
+eDecimalStatus BigDecimal::add_Value( const BigDecimal& oOther, bool bSubtract, const DecimalContext& oContext )
+{
+	static const uint32_t iONE = 1;
+	bool bOtherNegative = oOther.m_bNegative != bSubtract;
+	long long iExponent = m_iExponent < oOther.m_iExponent ? m_iExponent : oOther.m_iExponent;
+	bool bNegativeZero = oContext.eRounding == DECIMAL_ROUND_FLOOR && m_bNegative != bOtherNegative;
+	unsigned long long iA = 0;
+	unsigned long long iB = 0;
+
+	// Fast path: both coefficients line up in 64 bits and the exact result
+	// needs no rounding.
+	if( m_iLength > 0 && oOther.m_iLength > 0 && get_Small( iA ) && oOther.get_Small( iB ) )
+	{
+		unsigned long long iShift = (unsigned long long)( m_iExponent > oOther.m_iExponent ? m_iExponent - oOther.m_iExponent
+																						  : oOther.m_iExponent - m_iExponent );
+		unsigned long long& iScaled = m_iExponent > oOther.m_iExponent ? iA : iB;
+
+		if( iShift < SMALL_MAX_DIGITS && iScaled <= ~0ULL / iPOWERS_64[ iShift ] )
+		{
+			unsigned long long iResult = 0;
+			bool bNegative = m_bNegative;
+
+			iScaled *= iPOWERS_64[ iShift ];
+
+			if( m_bNegative != bOtherNegative )
+			{
+				if( iA == iB )
+				{
+					store_Zero( bNegativeZero, iExponent );
+					return DECIMAL_OK;
+				}
+
+				iResult = iA > iB ? iA - iB : iB - iA;
+				bNegative = iA > iB ? m_bNegative : bOtherNegative;
+			}
+			else
+				iResult = iA + iB;
+
+			if( ( m_bNegative != bOtherNegative || iResult >= iA ) && count_Digits_64( iResult ) <= oContext.iPrecision )
+				return store_Small( bNegative, iResult, iExponent );
+		}
+	}
+
+	LimbArena& oArena = get_Limb_Arena( );
+	LimbScope oScope( oArena );
+	const uint32_t* pA = get_Limbs( );
+	const uint32_t* pB = oOther.get_Limbs( );
+	size_t iLengthA = m_iLength;
+	size_t iLengthB = oOther.m_iLength;
+
+	if( iLengthA == 0 && iLengthB == 0 )
+	{
+		store_Zero( ( m_bNegative && bOtherNegative ) || bNegativeZero, iExponent );
+		return DECIMAL_OK;
+	}
+
+	// Adding zero only brings the other value's exponent down to the
+	// zero's, but no further than a digit past the precision.
+	if( iLengthA == 0 || iLengthB == 0 )
+	{
+		const uint32_t* pValue = iLengthA == 0 ? pB : pA;
+		size_t iLength = iLengthA == 0 ? iLengthB : iLengthA;
+		long long iValueExponent = iLengthA == 0 ? oOther.m_iExponent : m_iExponent;
+		long long iFloor = iValueExponent - (long long) oContext.iPrecision - 1;
+		long long iTarget = iExponent > iFloor ? iExponent : iFloor;
+		uint32_t* pScaled = oArena.allocate( iLength + (size_t)( iValueExponent - iTarget ) / DECIMAL_BASE_DIGITS + 1 );
+		size_t iScaled = scale_Up( pScaled, pValue, iLength, (unsigned long long)( iValueExponent - iTarget ) );
+
+		return store_Rounded( iLengthA == 0 ? bOtherNegative : m_bNegative, pScaled, iScaled, iTarget, false, oContext );
+	}
+
+	// Line the operands up on the smaller exponent.  An operand wholly
+	// below the last digit the result can keep is replaced by a single
+	// unit just below it, which rounds the same.
+	bool bAHigher = m_iExponent >= oOther.m_iExponent;
+	const uint32_t* pHigh = bAHigher ? pA : pB;
+	const uint32_t* pLow = bAHigher ? pB : pA;
+	size_t iHigh = bAHigher ? iLengthA : iLengthB;
+	size_t iLow = bAHigher ? iLengthB : iLengthA;
+	long long iHighExponent = bAHigher ? m_iExponent : oOther.m_iExponent;
+	long long iLowExponent = bAHigher ? oOther.m_iExponent : m_iExponent;
+	bool bHighNegative = bAHigher ? m_bNegative : bOtherNegative;
+	bool bLowNegative = bAHigher ? bOtherNegative : m_bNegative;
+	long long iHighDigits = (long long) count_Digits( pHigh, iHigh );
+	long long iReach = iHighDigits - (long long) oContext.iPrecision - 2;
+	long long iCutoff = iHighExponent + ( iReach < -1 ? iReach : -1 );
+
+	if( (long long) count_Digits( pLow, iLow ) + iLowExponent - 1 < iCutoff )
+	{
+		pLow = &iONE;
+		iLow = 1;
+		iLowExponent = iCutoff;
+	}
+
+	uint32_t* pScaled = oArena.allocate( iHigh + (size_t)( iHighExponent - iLowExponent ) / DECIMAL_BASE_DIGITS + 1 );
+	size_t iScaled = trim_Limbs( pScaled, scale_Up( pScaled, pHigh, iHigh, (unsigned long long)( iHighExponent - iLowExponent ) ) );
+	size_t iResult = ( iScaled > iLow ? iScaled : iLow ) + 1;
+	uint32_t* pResult = oArena.allocate( iResult );
+	bool bNegative = bHighNegative;
+
+	if( bHighNegative == bLowNegative )
+	{
+		if( iScaled >= iLow )
+			pResult[ iScaled ] = add_Limbs( pResult, pScaled, iScaled, pLow, iLow );
+		else
+			pResult[ iLow ] = add_Limbs( pResult, pLow, iLow, pScaled, iScaled );
+	}
+	else
+	{
+		int iCompare = compare_Limbs( pScaled, iScaled, pLow, iLow );
+
+		if( iCompare == 0 )
+		{
+			store_Zero( bNegativeZero, iExponent );
+			return DECIMAL_OK;
+		}
+
+		memset( pResult, 0, iResult * sizeof( uint32_t ) );
+
+		if( iCompare > 0 )
+			subtract_Limbs( pResult, pScaled, iScaled, pLow, iLow );
+		else
+		{
+			subtract_Limbs( pResult, pLow, iLow, pScaled, iScaled );
+			bNegative = bLowNegative;
+		}
+	}
+
+	return store_Rounded( bNegative, pResult, iResult, iLowExponent, false, oContext );
+}
+
+// Multiplies by another value.
+//	Returns:
+//		DECIMAL_OK, or DECIMAL_OUT_OF_RANGE with the value unchanged.
+//////////////////////////////////////////////////////////////////////////////
+eDecimalStatus BigDecimal::multiply( const BigDecimal& oOther, const DecimalContext& oContext )
+{
+	bool bNegative = m_bNegative != oOther.m_bNegative;
+	long long iExponent = m_iExponent + oOther.m_iExponent;
+	unsigned long long iA = 0;
+	unsigned long long iB = 0;
+
+	if( m_iLength == 0 || oOther.m_iLength == 0 )
+	{
+		store_Zero( bNegative, iExponent );
+		return DECIMAL_OK;
+	}
+
+	if( get_Small( iA ) && oOther.get_Small( iB ) )
+	{
+		unsigned long long iProduct = 0;
+
+#if defined( __GNUC__ ) || defined( __clang__ )
+		bool bOverflow = __builtin_mul_overflow( iA, iB, &iProduct );
+#else
+		bool bOverflow = iA != 0 && iB > ~0ULL / iA;
+
+		iProduct = iA * iB;
+#endif
+
+		if( !bOverflow && count_Digits_64( iProduct ) <= oContext.iPrecision )
+			return store_Small( bNegative, iProduct, iExponent );
+	}
+
+	LimbArena& oArena = get_Limb_Arena( );
+	LimbScope oScope( oArena );
+	uint32_t* pProduct = oArena.allocate( m_iLength + oOther.m_iLength );
+
+	multiply_Limbs( pProduct, get_Limbs( ), m_iLength, oOther.get_Limbs( ), oOther.m_iLength, oArena );
+	return store_Rounded( bNegative, pProduct, m_iLength + oOther.m_iLength, iExponent, false, oContext );
+}
+
+// Divides by another value.  The quotient is worked out to a digit or two
+// past the precision; an exact quotient loses the trailing zeros that
+// division added, down to the difference of the two exponents.
+//	Returns:
+//		DECIMAL_OK, DECIMAL_DIVIDE_BY_ZERO or DECIMAL_OUT_OF_RANGE.  The
+//		value is unchanged on failure.
+//////////////////////////////////////////////////////////////////////////////
+eDecimalStatus BigDecimal::divide( const BigDecimal& oOther, const DecimalContext& oContext )
+{
+	bool bNegative = m_bNegative != oOther.m_bNegative;
+	long long iIdeal = m_iExponent - oOther.m_iExponent;
+
+	if( oOther.m_iLength == 0 )
+		return DECIMAL_DIVIDE_BY_ZERO;
+
+	if( m_iLength == 0 )
+	{
+		store_Zero( bNegative, iIdeal );
+		return DECIMAL_OK;
+	}
+
+	LimbArena& oArena = get_Limb_Arena( );
+	LimbScope oScope( oArena );
+	const uint32_t* pNumerator = get_Limbs( );
+	const uint32_t* pDenominator = oOther.get_Limbs( );
+	size_t iNumerator = m_iLength;
+	size_t iDenominator = oOther.m_iLength;
+	long long iShift = (long long) count_Digits( pDenominator, iDenominator ) -
+					   (long long) count_Digits( pNumerator, iNumerator ) + (long long) oContext.iPrecision + 1;
+	long long iExponent = iIdeal - iShift;
+
+	// Scale whichever side makes the quotient precision + 1 or + 2 digits.
+	if( iShift > 0 )
+	{
+		uint32_t* pScaled = oArena.allocate( iNumerator + (size_t) iShift / DECIMAL_BASE_DIGITS + 1 );
+
+		iNumerator = trim_Limbs( pScaled, scale_Up( pScaled, pNumerator, iNumerator, (unsigned long long) iShift ) );
+		pNumerator = pScaled;
+	}
+	else if( iShift < 0 )
+	{
+		uint32_t* pScaled = oArena.allocate( iDenominator + (size_t)( -iShift ) / DECIMAL_BASE_DIGITS + 1 );
+
+		iDenominator = trim_Limbs( pScaled, scale_Up( pScaled, pDenominator, iDenominator, (unsigned long long)( -iShift ) ) );
+		pDenominator = pScaled;
+	}
+
+	size_t iQuotient = iNumerator - iDenominator + 1;
+	uint32_t* pQuotient = oArena.allocate( iQuotient + 1 );
+	uint32_t* pRemainder = oArena.allocate( iDenominator );
+	bool bInexact = false;
+
+	divide_Limbs( pQuotient, pRemainder, pNumerator, iNumerator, pDenominator, iDenominator, oArena );
+	iQuotient = trim_Limbs( pQuotient, iQuotient );
+	bInexact = trim_Limbs( pRemainder, iDenominator ) > 0;
+
+	if( !bInexact && iExponent < iIdeal )
+	{
+		unsigned long long iZeros = 0;
+		unsigned long long iStrip = 0;
+		size_t iLimb = 0;
+
+		while( pQuotient[ iLimb ] == 0 )
+			++iLimb;
+
+		iZeros = (unsigned long long) iLimb * DECIMAL_BASE_DIGITS;
+
+		for( uint32_t iLow = pQuotient[ iLimb ]; iLow % 10 == 0; iLow /= 10 )
+			++iZeros;
+
+		iStrip = iZeros < (unsigned long long)( iIdeal - iExponent ) ? iZeros : (unsigned long long)( iIdeal - iExponent );
+		pQuotient += iStrip / DECIMAL_BASE_DIGITS;
+		iQuotient -= (size_t)( iStrip / DECIMAL_BASE_DIGITS );
+		divide_Small( pQuotient, pQuotient, iQuotient, iDECIMAL_POWERS[ iStrip % DECIMAL_BASE_DIGITS ] );
+		iExponent += (long long) iStrip;
+	}
+
+	return store_Rounded( bNegative, pQuotient, iQuotient, iExponent, bInexact, oContext );
+}
+
+// Flips the sign.  Zero stays positive.
+void BigDecimal::negate( )
+{
+	m_bNegative = m_iLength > 0 ? !m_bNegative : false;
+}
+
+/*********************************************************************\
+ *	Conversions														 *
+\*********************************************************************/
+
+// Returns the number of digits in the coefficient.
+size_t BigDecimal::get_Digits( ) const
+{
+	return count_Digits( get_Limbs( ), m_iLength );
+}
+
+// Returns the nearest double, for display and comparisons only.
+double BigDecimal::to_Double( ) const
+{
+	return strtod( to_String( ).c_str( ), NULL );
+}
+
+string BigDecimal::to_String( ) const
+{
+	string sOut;
+
+	append_String( sOut );
+	return sOut;
+}
+
+// Appends the value in scientific string form: plain digits with a
+// decimal point when the exponent is zero or negative and the value isn't
+// tiny, and d.dddE+n otherwise.  "1.50" stays "1.50", 10^3 as a
+// coefficient of 1 is "1E+3".
+void BigDecimal::append_String( string& sOut ) const
+{
+	const uint32_t* pLimbs = get_Limbs( );
+	size_t iStart = sOut.size( );
+	size_t iDigits = 0;
+	long long iLeft = 0;
+	long long iDot = 0;
+	char sLimb[ DECIMAL_BASE_DIGITS ];
+
+	if( m_bNegative )
+		sOut.push_back( '-' );
+
+	// The coefficient's digits, then the point and exponent around them.
+	iStart = sOut.size( );
+
+	if( m_iLength == 0 )
+		sOut.push_back( '0' );
+	else
+	{
+		for( uint32_t iTop = pLimbs[ m_iLength - 1 ]; iTop != 0 || sOut.size( ) == iStart; iTop /= 10 )
+			sOut.push_back( (char)( '0' + iTop % 10 ) );
+
+		for( size_t i = iStart, j = sOut.size( ) - 1; i < j; ++i, --j )
+		{
+			char c = sOut[ i ];
+
+			sOut[ i ] = sOut[ j ];
+			sOut[ j ] = c;
+		}
+
+		for( size_t i = m_iLength - 1; i-- > 0; )
+		{
+			uint32_t iLimb = pLimbs[ i ];
+
+			for( int j = DECIMAL_BASE_DIGITS - 1; j >= 0; --j )
+			{
+				sLimb[ j ] = (char)( '0' + iLimb % 10 );
+				iLimb /= 10;
+			}
+
+			sOut.append( sLimb, DECIMAL_BASE_DIGITS );
+		}
+	}
+
+	iDigits = sOut.size( ) - iStart;
+	iLeft = m_iExponent + (long long) iDigits;
+	iDot = m_iExponent <= 0 && iLeft > -6 ? iLeft : 1;
+
+	if( iDot <= 0 )
+	{
+		sOut.insert( iStart, (size_t)( 2 - iDot ), '0' );
+		sOut[ iStart + 1 ] = '.';
+	}
+	else if( iDot >= (long long) iDigits )
+		sOut.append( (size_t)( iDot - (long long) iDigits ), '0' );
+	else
+		sOut.insert( iStart + (size_t) iDot, 1, '.' );
+
+	if( iLeft != iDot )
+	{
+		char sExponent[ 24 ];
+
+		snprintf( sExponent, sizeof( sExponent ), "E%+lld", iLeft - iDot );
+		sOut.append( sExponent );
+	}
+}
+
+// Builds a value from the digits of a decimal number.
+//	Returns:
+//		DECIMAL_OK, or DECIMAL_OUT_OF_RANGE if the exponent is too large.
+//////////////////////////////////////////////////////////////////////////////
+eDecimalStatus BigDecimal::parse_Digits( const char* sInteger, size_t iInteger,
+										 const char* sFraction, size_t iFraction,
+										 long long iExponent, BigDecimal& oValue )
+{
+	// The exponent belongs to the last digit, so 0.000 is 0E-3.
+	iExponent -= (long long) iFraction;
+
+	// Leading zeros don't count toward the length of the coefficient.
+	while( iInteger > 0 && *sInteger == '0' )
+	{
+		++sInteger;
+		--iInteger;
+	}
+
+	while( iInteger == 0 && iFraction > 0 && *sFraction == '0' )
+	{
+		++sFraction;
+		--iFraction;
+	}
+
+	if( iInteger + iFraction <= SMALL_MAX_DIGITS )
+	{
+		unsigned long long iCoefficient = 0;
+
+		for( size_t i = 0; i < iInteger; ++i )
+			iCoefficient = iCoefficient * 10 + (unsigned long long)( sInteger[ i ] - '0' );
+
+		for( size_t i = 0; i < iFraction; ++i )
+			iCoefficient = iCoefficient * 10 + (unsigned long long)( sFraction[ i ] - '0' );
+
+		return oValue.store_Small( false, iCoefficient, iExponent );
+	}
+
+	// Long coefficients are read nine digits at a time from the end.
+	string sDigits( sInteger, iInteger );
+	vector< uint32_t > vLimbs( ( iInteger + iFraction + DECIMAL_BASE_DIGITS - 1 ) / DECIMAL_BASE_DIGITS );
+	size_t iEnd = 0;
+
+	sDigits.append( sFraction, iFraction );
+	iEnd = sDigits.size( );
+
+	for( size_t i = 0; i < vLimbs.size( ); ++i )
+	{
+		size_t iBegin = iEnd > DECIMAL_BASE_DIGITS ? iEnd - DECIMAL_BASE_DIGITS : 0;
+		uint32_t iLimb = 0;
+
+		for( size_t j = iBegin; j < iEnd; ++j )
+			iLimb = iLimb * 10 + (uint32_t)( sDigits[ j ] - '0' );
+
+		vLimbs[ i ] = iLimb;
+		iEnd = iBegin;
+	}
+
+	return oValue.store_Exact( false, vLimbs.data( ), vLimbs.size( ), iExponent );
+}
+
+/*********************************************************************\
+ *	Functions														 *
+\*********************************************************************/
+
+// Returns a description of a failed operation.
+const char* get_Decimal_Error( eDecimalStatus eStatus )
+{
+	switch( eStatus )
+	{
+	case DECIMAL_DIVIDE_BY_ZERO:
+		return "division by zero";
+	case DECIMAL_OUT_OF_RANGE:
+		return "result out of range";
+	case DECIMAL_OK:
+	default:
+		return "no error";
+	}
+}
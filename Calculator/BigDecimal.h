@@ -0,0 +1,150 @@
+#ifndef _BIGDECIMAL_H
+#define _BIGDECIMAL_H
+
+// Name: BigDecimal.h
+// Description: Arbitrary precision decimal value for the calculator's
+//				decimal mode.  A value is a sign, a coefficient of any
+//				length and a power of ten, so 0.1 is exactly 0.1.  Every
+//				result is rounded to the context's precision, in
+//				significant digits, with the context's rounding mode;
+//				results and their formatting follow the General Decimal
+//				Arithmetic specification, the same rules as Python's
+//				decimal module, except that the exponent is limited to
+//				+/-DECIMAL_MAX_EXPONENT and subnormals aren't produced.
+//
+//				Coefficients of up to DECIMAL_INLINE_LIMBS limbs (36
+//				digits, enough for the default precision) are stored in
+//				the value itself; small coefficients are added and
+//				multiplied in 64 bits.  Everything else goes through
+//				DecimalKernels.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+#define DECIMAL_DEFAULT_PRECISION	34				// Significant digits, as IEEE decimal128
+#define DECIMAL_MAX_PRECISION		1000000
+#define DECIMAL_MAX_EXPONENT		999999999LL		// Largest adjusted exponent either way
+#define DECIMAL_INLINE_LIMBS		4
+
+// How a result with more digits than the precision is rounded.
+enum eDecimalRounding
+{
+	DECIMAL_ROUND_HALF_EVEN,		// To nearest, ties to even
+	DECIMAL_ROUND_HALF_UP,			// To nearest, ties away from zero
+	DECIMAL_ROUND_HALF_DOWN,		// To nearest, ties toward zero
+	DECIMAL_ROUND_DOWN,				// Toward zero
+	DECIMAL_ROUND_UP,				// Away from zero
+	DECIMAL_ROUND_CEILING,			// Toward positive infinity
+	DECIMAL_ROUND_FLOOR				// Toward negative infinity
+};
+
+// Outcome of a decimal operation.
+enum eDecimalStatus
+{
+	DECIMAL_OK,
+	DECIMAL_DIVIDE_BY_ZERO,
+	DECIMAL_OUT_OF_RANGE			// The exponent passed DECIMAL_MAX_EXPONENT
+};
+
+// Precision and rounding that results are brought to.
+struct DecimalContext
+{
+	unsigned int iPrecision;		// Significant digits, 1 to DECIMAL_MAX_PRECISION
+	eDecimalRounding eRounding;
+};
+
+/////////////////////////////
+// BigDecimal Declaration  //
+/////////////////////////////
+class BigDecimal
+{
+public:
+	BigDecimal( );
+	explicit BigDecimal( long long iValue );
+	BigDecimal( const BigDecimal& oOther );
+	BigDecimal& operator=( const BigDecimal& oOther );
+
+	// Arithmetic, in place.  On failure the value is left untouched.
+	eDecimalStatus add( const BigDecimal& oOther, const DecimalContext& oContext );
+	eDecimalStatus subtract( const BigDecimal& oOther, const DecimalContext& oContext );
+	eDecimalStatus multiply( const BigDecimal& oOther, const DecimalContext& oContext );
+	eDecimalStatus divide( const BigDecimal& oOther, const DecimalContext& oContext );
+	void negate( );
+
+	bool is_Zero( ) const;
+	size_t get_Digits( ) const;
+	double to_Double( ) const;
+	std::string to_String( ) const;
+	void append_String( std::string& sOut ) const;
+
+	// Builds the value of the digits sInteger.sFraction times 10^iExponent,
+	// exactly.  Either run of digits may be empty.
+	static eDecimalStatus parse_Digits( const char* sInteger, size_t iInteger,
+										const char* sFraction, size_t iFraction,
+										long long iExponent, BigDecimal& oValue );
+
+private:
+	const uint32_t* get_Limbs( ) const;
+	uint32_t* resize_Limbs( size_t iLength );
+	bool get_Small( unsigned long long& iCoefficient ) const;
+	eDecimalStatus add_Value( const BigDecimal& oOther, bool bSubtract, const DecimalContext& oContext );
+	eDecimalStatus store_Small( bool bNegative, unsigned long long iCoefficient, long long iExponent );
+	eDecimalStatus store_Exact( bool bNegative, const uint32_t* pLimbs, size_t iLength, long long iExponent );
+	eDecimalStatus store_Rounded( bool bNegative, const uint32_t* pLimbs, size_t iLength, long long iExponent,
+								  bool bInexact, const DecimalContext& oContext );
+	void store_Zero( bool bNegative, long long iExponent );
+
+	bool m_bNegative;
+	long long m_iExponent;
+	size_t m_iLength;								// Trimmed, 0 for zero
+	uint32_t m_aInline[ DECIMAL_INLINE_LIMBS ];		// The coefficient, if it fits
+	std::vector< uint32_t > m_vHeap;				// Otherwise, least significant limb first
+};
+
+/****\
+ * Fast Paths *
+\****/
+
+inline BigDecimal::BigDecimal( )
+{
+	m_bNegative = false;
+	m_iExponent = 0;
+	m_iLength = 0;
+}
+
+inline const uint32_t* BigDecimal::get_Limbs( ) const
+{
+	return m_iLength <= DECIMAL_INLINE_LIMBS ? m_aInline : m_vHeap.data( );
+}
+
+inline bool BigDecimal::is_Zero( ) const
+{
+	return m_iLength == 0;
+}
+
+inline eDecimalStatus BigDecimal::add( const BigDecimal& oOther, const DecimalContext& oContext )
+{
+	return add_Value( oOther, false, oContext );
+}
+
+inline eDecimalStatus BigDecimal::subtract( const BigDecimal& oOther, const DecimalContext& oContext )
+{
+	return add_Value( oOther, true, oContext );
+}
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+const char* get_Decimal_Error( eDecimalStatus eStatus );
+
+#endif
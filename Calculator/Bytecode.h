@@ -0,0 +1,61 @@
+#ifndef _BYTECODE_H
+#define _BYTECODE_H
+
+// Name: Bytecode.h
+// Description: Compiled form of a calculator expression, run by the
+//				stack machine in Calculator::evaluate_Program.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <memory>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+// Instructions.  Binary operators use their operator character ('+', '-',
+// '*', '/') as their instruction so no translation is needed.
+#define BC_END				0		// Result is on top of the stack
+#define BC_CONST			'c'		// Push the 8 byte double that follows
+#define BC_MEM				'm'		// Push the value held in memory
+#define BC_VAR				'x'		// Push the variable whose 4 byte slot follows
+#define BC_VALUE			'v'		// Push the current working value
+#define BC_NEGATE			'n'		// Negate the top of the stack
+
+#define BC_ASSIGN			'='		// Program::cOperator: result replaces the working value
+#define BYTECODE_MAX_STACK	64		// Deepest stack a program may use
+
+struct JitFunction;
+
+// How a program is run, see ProgramJit.h.  A program is only ever run by
+// one thread at a time, so this needs no locking.
+struct ProgramTier
+{
+	unsigned int iRuns;								// Interpreted runs, up to JIT_HOT_RUNS
+	std::shared_ptr< const JitFunction > pNative;	// Native code once it is hot
+
+	ProgramTier( ) : iRuns( 0 ) {}
+};
+
+/////////////////////////
+// Program Declaration //
+/////////////////////////
+// A compiled calculation line.  The code computes an operand which is then
+// applied to the working value with cOperator, exactly as
+// Calculator::process_Calculation would, or assigned to it for BC_ASSIGN.
+struct Program
+{
+	std::vector< unsigned char > vCode;
+	unsigned int iMaxStack;
+	char cOperator;
+	bool bReadsState;	// Code pushes the working value, memory or a variable
+	unsigned long long iVariableScope;	// VariableTable::get_Id of the slots in the code, 0 if none
+	mutable ProgramTier oTier;			// Reset whenever vCode changes
+
+	Program( ) : iMaxStack( 0 ), cOperator( BC_ASSIGN ), bReadsState( false ), iVariableScope( 0 ) {}
+};
+
+#endif
@@ -2,10 +2,66 @@
 // Includes //
 //////////////
 #include "Calculator.h"
+#include "ProgramJit.h"
+#include "../Metrics/Metrics.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
 
-// Constant, uneditable array of available operations that can
-// be done by this calculator.
-const char Calculator::m_sAvailableOps[ MAXIMUM_OPERATIONS ] = { '+','-','*','/' };
+// The stack machine is kept out of line so there is exactly one copy of
+// each operator's arithmetic, the one get_Swap_Mask asks.
+#if defined( __GNUC__ )
+#define CALC_NOINLINE __attribute__(( noinline ))
+#elif defined( _MSC_VER )
+#define CALC_NOINLINE __declspec( noinline )
+#else
+#define CALC_NOINLINE
+#endif
+
+// The first operators of the registry have counters of their own, in the
+// same order; any added after them are counted together as others.
+static_assert( get_Operator( '+' ).iIndex == METRIC_OP_ADD && get_Operator( '-' ).iIndex == METRIC_OP_SUBTRACT &&
+			   get_Operator( '*' ).iIndex == METRIC_OP_MULTIPLY && get_Operator( '/' ).iIndex == METRIC_OP_DIVIDE,
+			   "operator counters must follow CalculatorOperators" );
+
+template< class OPERATOR >
+static constexpr MetricOperator get_Operator_Metric( )
+{
+	return CalculatorOperators::index_Of< OPERATOR >( ) <= METRIC_OP_DIVIDE ?
+		   (MetricOperator) CalculatorOperators::index_Of< OPERATOR >( ) : METRIC_OP_OTHER;
+}
+
+// Returns the operators the stack machine computes as "right op left", for
+// compile_Native.  Found by running "ans (op) mem" with two NaNs of
+// opposite sign and seeing whose sign comes out.
+unsigned int Calculator::get_Swap_Mask( )
+{
+	static const unsigned int iSwapMask = [ ]( )
+	{
+		Calculator oProbe;
+		Program oProgram;
+		unsigned int iMask = 0;
+		double dResult = 0.0;
+
+		oProgram.vCode.assign( { BC_VALUE, BC_MEM, 0, BC_END } );
+		oProgram.iMaxStack = 2;
+		oProbe.set_Value( std::numeric_limits< double >::quiet_NaN( ) );
+		oProbe.set_Mem( -std::numeric_limits< double >::quiet_NaN( ) );
+
+		for( size_t i = 0; i < CalculatorOperators::iCount; ++i )
+		{
+			oProgram.vCode[ 2 ] = (unsigned char) CalculatorOperators::sSymbols[ i ];
+			dResult = oProbe.interpret_Program( oProgram );
+
+			if( std::signbit( dResult ) )
+				iMask |= 1u << i;
+		}
+
+		return iMask;
+	}( );
+
+	return iSwapMask;
+}
 
 /*********************************************************************\
  *	Constructor/Desctructor											 *
@@ -15,7 +71,7 @@ const char Calculator::m_sAvailableOps[ MAXIMUM_OPERATIONS ] = { '+','-','*','/'
 Calculator::Calculator(void)
 {
 	m_dValue = 0.0f;
-	m_dMemory = 0.0f;
+	m_vRegisters.assign( 1, 0.0 );
 }
 
 
@@ -37,38 +93,185 @@ Calculator::~Calculator(void)
 //////////////////////////////////////////////////////////////////////
 void Calculator::process_Calculation( char cOperator, double dValue )
 {
-	switch( cOperator )
+	METRIC_SAMPLE_SCOPE( METRIC_TIMER_CALCULATION );
+
+	// Each operator's kernel is inlined into its own branch.
+	if( !dispatch_Operator( cOperator, [ this, dValue ]( auto oOperator )
+		{
+			typedef decltype( oOperator ) OPERATOR;
+
+			METRIC_COUNT_OPERATOR( get_Operator_Metric< OPERATOR >( ) );
+
+			if( OPERATOR::iArity == 2 && m_pStats )
+				m_pStats->add( dValue );
+
+			m_dValue = OPERATOR::apply( m_dValue, dValue );
+		} ) )
+		METRIC_COUNT_OPERATOR( METRIC_OP_OTHER );
+}
+
+// Applies a decoded operation to the calculator.  Memory operands are
+// resolved here so that the operation sees the memory at the time it
+// is applied, exactly as the interactive parser would.
+//	Parameters:
+//		oOperation : Operation - The operation to apply.
+//////////////////////////////////////////////////////////////////////
+void Calculator::apply_Operation( const Operation& oOperation )
+{
+	switch( oOperation.cOpCode )
 	{
-	case '+':	
-		m_dValue += dValue;
+	case OP_CODE_STORE:
+		METRIC_COUNT_OPERATOR( METRIC_OP_STORE );
+		store_Mem( );
 		break;
-	case '-':
-		m_dValue -= dValue;
+	case OP_CODE_RESET:
+		METRIC_COUNT_OPERATOR( METRIC_OP_RESET );
+		clear_Value( );
 		break;
-	case '*':
-		m_dValue *= dValue;
+	case OP_CODE_SET:
+		METRIC_COUNT_OPERATOR( METRIC_OP_SET );
+
+		if( m_pStats )
+			m_pStats->add( oOperation.dValue );
+
+		m_dValue = oOperation.dValue;
 		break;
-	case '/':
-		m_dValue /= dValue;
+	case OP_CODE_STORE_VAR:
+		METRIC_COUNT_OPERATOR( METRIC_OP_STORE );
+		store_Var( oOperation.iSlot );
 		break;
 	default:
+		if( op_UsesVar( oOperation.cOpCode ) )
+		{
+			process_Calculation( op_Operator( oOperation.cOpCode ), pull_Var( oOperation.iSlot ) );
+			break;
+		}
+
+		if( op_UsesMem( oOperation.cOpCode ) )
+			METRIC_COUNT_MEM_HIT( );
+
+		process_Calculation( op_Operator( oOperation.cOpCode ),
+							 op_UsesMem( oOperation.cOpCode ) ? m_vRegisters[ VARIABLE_MEMORY_SLOT ] : oOperation.dValue );
 		break;
-	};
+	}
+}
+
+// Runs a compiled program and returns the operand it computes.  A program
+// starts on the stack machine and is compiled to native code once it has
+// run JIT_HOT_RUNS times; both give the same result.
+//	Parameters:
+//		oProgram : Program - The program to run.
+//	Returns:
+//		The operand.
+//////////////////////////////////////////////////////////////////////
+double Calculator::evaluate_Program( const Program& oProgram )
+{
+	const JitFunction* pNative = oProgram.oTier.pNative.get( );
+	NativeProgram pEntry = NULL;
+
+	if( pNative != NULL )
+	{
+		// Variables stored after the program was compiled may not have a
+		// register yet; those runs stay on the stack machine.
+		if( pNative->iRegisters <= m_vRegisters.size( ) )
+		{
+			if( ( pEntry = get_Native_Entry( *pNative ) ) != NULL )
+			{
+				if( pNative->iMemReads != 0 )
+					METRIC_COUNT_MEM_HITS( pNative->iMemReads );
+
+				return pEntry( m_dValue, m_vRegisters.data( ) );
+			}
+
+			oProgram.oTier.pNative.reset( );
+		}
+	}
+	else if( oProgram.oTier.iRuns < JIT_HOT_RUNS && ++oProgram.oTier.iRuns == JIT_HOT_RUNS )
+		oProgram.oTier.pNative = compile_Native( oProgram, get_Swap_Mask( ) );
+
+	return interpret_Program( oProgram );
 }
 
-// Runs through the list of available operands to determine
-// if the passed in operand is valid.
+// Runs a compiled program on the stack machine.  Programs come from the
+// expression compiler, which guarantees they are well formed and fit in
+// BYTECODE_MAX_STACK.
+//	Parameters:
+//		oProgram : Program - The program to run.
+//	Returns:
+//		The value left on top of the stack.
+//////////////////////////////////////////////////////////////////////
+CALC_NOINLINE double Calculator::interpret_Program( const Program& oProgram ) const
+{
+	double aStack[ BYTECODE_MAX_STACK ];
+	double* pTop = aStack - 1;
+	const unsigned char* pCode = oProgram.vCode.data( );
+	unsigned int iSlot = 0;
+
+	for( ;; )
+	{
+		switch( *pCode++ )
+		{
+		case BC_CONST:
+			memcpy( ++pTop, pCode, sizeof( double ) );
+			pCode += sizeof( double );
+			break;
+		case BC_MEM:
+			METRIC_COUNT_MEM_HIT( );
+			*++pTop = m_vRegisters[ VARIABLE_MEMORY_SLOT ];
+			break;
+		case BC_VAR:
+			memcpy( &iSlot, pCode, sizeof( iSlot ) );
+			pCode += sizeof( iSlot );
+			*++pTop = pull_Var( iSlot );
+			break;
+		case BC_VALUE:
+			*++pTop = m_dValue;
+			break;
+		case BC_NEGATE:
+			*pTop = -*pTop;
+			break;
+		default:
+			// Any other instruction is a binary operator.
+			if( !dispatch_Operator( (char) pCode[ -1 ], [ pTop ]( auto oOperator )
+				{
+					pTop[ -1 ] = decltype( oOperator )::apply( pTop[ -1 ], *pTop );
+				} ) )
+				return *pTop;
+
+			--pTop;
+			break;
+		}
+	}
+}
+
+// Runs a compiled program and applies its result to the working value.
+//	Parameters:
+//		oProgram : Program - The program to run.
+//////////////////////////////////////////////////////////////////////
+void Calculator::execute_Program( const Program& oProgram )
+{
+	double dOperand = evaluate_Program( oProgram );
+
+	if( oProgram.cOperator == BC_ASSIGN )
+	{
+		METRIC_COUNT_OPERATOR( METRIC_OP_SET );
+
+		if( m_pStats )
+			m_pStats->add( dOperand );
+
+		m_dValue = dOperand;
+	}
+	else
+		process_Calculation( oProgram.cOperator, dOperand );
+}
+
+// Looks the operand up in the operator registry.
 //	Returns
 //		true if the operand is valid.
 ///////////////////////////////////////////////////////////////////////
-bool Calculator::isValidOperand( char cOperand )
+bool Calculator::isValidOperand( char cOperand ) const
 {
-	bool bValid = false;
-
-	for( int i = 0; i < MAXIMUM_OPERATIONS; ++i )
-		bValid |= m_sAvailableOps[ i ] == cOperand;
-
-	return bValid;
+	return is_Operator( cOperand );
 }
 
 /*********************************************************************\
@@ -78,29 +281,116 @@ bool Calculator::isValidOperand( char cOperand )
 // Stores a value into the calculator's internal "memory"
 void Calculator::store_Mem( )
 {
-	m_dMemory = m_dValue;
+	m_vRegisters[ VARIABLE_MEMORY_SLOT ] = m_dValue;
 }
 
 // Grabs the value from the calculator's internal "memory"
-double Calculator::pull_Mem( )
+double Calculator::pull_Mem( ) const
+{
+	return m_vRegisters[ VARIABLE_MEMORY_SLOT ];
+}
+
+// Sets the calculator's internal "memory" directly, used when restoring
+// a saved session.
+void Calculator::set_Mem( double dMemory )
+{
+	m_vRegisters[ VARIABLE_MEMORY_SLOT ] = dMemory;
+}
+
+// Returns the slot of a variable, creating it if it is new.  Called by
+// parsers, so the register file itself is only grown by store_Var, on
+// the thread that evaluates.
+unsigned int Calculator::intern_Variable( const char* sName, size_t iLength )
+{
+	return m_oVariables.intern( sName, iLength );
+}
+
+// Looks up the slot of an existing variable.
+//	Returns:
+//		False if no variable has the name.
+bool Calculator::find_Variable( const char* sName, size_t iLength, unsigned int& iSlot ) const
+{
+	return m_oVariables.find( sName, iLength, iSlot );
+}
+
+// Stores the current working value into a variable.
+void Calculator::store_Var( unsigned int iSlot )
+{
+	if( iSlot >= m_vRegisters.size( ) )
+		m_vRegisters.resize( (size_t) iSlot + 1, 0.0 );
+
+	m_vRegisters[ iSlot ] = m_dValue;
+}
+
+// Sets a variable directly.  Once fit_Registers has covered the slot
+// this doesn't allocate, so threads may set different variables at once.
+void Calculator::set_Var( unsigned int iSlot, double dValue )
+{
+	if( iSlot >= m_vRegisters.size( ) )
+		m_vRegisters.resize( (size_t) iSlot + 1, 0.0 );
+
+	m_vRegisters[ iSlot ] = dValue;
+}
+
+// Grows the register file to cover every variable interned so far.
+void Calculator::fit_Registers( )
+{
+	if( m_oVariables.size( ) > m_vRegisters.size( ) )
+		m_vRegisters.resize( m_oVariables.size( ), 0.0 );
+}
+
+// Grabs the value of a variable, 0 if it hasn't been stored yet.
+double Calculator::pull_Var( unsigned int iSlot ) const
+{
+	return iSlot < m_vRegisters.size( ) ? m_vRegisters[ iSlot ] : 0.0;
+}
+
+// Returns the names of the calculator's variables.
+const VariableTable& Calculator::get_Variables( ) const
 {
-	return m_dMemory;
+	return m_oVariables;
 }
 
 // Reads the current value being displayed on the calculator
-double Calculator::read_Value( )
+double Calculator::read_Value( ) const
 {
 	return m_dValue;
 }
 
+// Sets the current working value of the calculator directly, used by
+// evaluators that compute the working value outside of the calculator.
+void Calculator::set_Value( double dValue )
+{
+	m_dValue = dValue;
+}
+
 // Clears the current working value of the calculator
 void Calculator::clear_Value( )
 {
 	m_dValue = 0.0f;
 }
 
-// Returns the list of available operands.
-const char* Calculator::get_Available_Ops( )
+// Starts keeping statistics over the operands of every operator and set
+// from here on.  Does nothing if they are already kept.
+void Calculator::enable_Stats( )
+{
+	if( !m_pStats )
+		m_pStats.reset( new OperandStats );
+}
+
+// Returns the operand statistics, NULL unless enable_Stats was called.
+const OperandStats* Calculator::get_Stats( ) const
+{
+	return m_pStats.get( );
+}
+
+OperandStats* Calculator::get_Stats( )
+{
+	return m_pStats.get( );
+}
+
+// Returns the list of available operands, null terminated.
+const char* Calculator::get_Available_Ops( ) const
 {
-	return m_sAvailableOps;
+	return CalculatorOperators::sSymbols;
 }
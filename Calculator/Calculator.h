@@ -6,10 +6,22 @@
 // Written By: James Cot
 //////////////////////////////////////////////////////////////////////
 
+//////////////
+// Includes //
+//////////////
+#include "Operation.h"
+#include "Bytecode.h"
+#include "OperandStats.h"
+#include "OperatorRegistry.h"
+#include "VariableTable.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
 /////////////
 // Defines //
 /////////////
-#define MAXIMUM_OPERATIONS 4
+#define MAXIMUM_OPERATIONS ( (int) CalculatorOperators::iCount )
 
 ////////////////////////////
 // Calculator Declaration //
@@ -22,19 +34,40 @@ public:
 
 	// public use functions
 	void process_Calculation( char cOperator, double dValue );
-	bool isValidOperand( char cOperand );
+	bool isValidOperand( char cOperand ) const;
+	void apply_Operation( const Operation& oOperation );
+	double evaluate_Program( const Program& oProgram );
+	void execute_Program( const Program& oProgram );
 
 	// Getters and setters
-	const char* get_Available_Ops( );
+	const char* get_Available_Ops( ) const;
 	void store_Mem( );
-	double pull_Mem( );
+	double pull_Mem( ) const;
+	void set_Mem( double dMemory );
+	unsigned int intern_Variable( const char* sName, size_t iLength );
+	bool find_Variable( const char* sName, size_t iLength, unsigned int& iSlot ) const;
+	void store_Var( unsigned int iSlot );
+	void set_Var( unsigned int iSlot, double dValue );
+	void fit_Registers( );
+	double pull_Var( unsigned int iSlot ) const;
+	const VariableTable& get_Variables( ) const;
 	void clear_Value( );
-	double read_Value( );
+	double read_Value( ) const;
+	void set_Value( double dValue );
+
+	// Operand statistics
+	void enable_Stats( );
+	const OperandStats* get_Stats( ) const;
+	OperandStats* get_Stats( );
 
 private:
-	double m_dMemory;
 	double m_dValue;
-	static const char m_sAvailableOps[ MAXIMUM_OPERATIONS ];
+	std::vector< double > m_vRegisters;		// By variable slot, the memory first
+	VariableTable m_oVariables;
+	std::unique_ptr< OperandStats > m_pStats;	// NULL until enable_Stats
+
+	double interpret_Program( const Program& oProgram ) const;
+	static unsigned int get_Swap_Mask( );
 
 };
 
@@ -0,0 +1,110 @@
+// Name: DecimalCalculator.cpp
+// Description: Decimal mode calculator, see DecimalCalculator.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "DecimalCalculator.h"
+#include "../Metrics/Metrics.h"
+
+/*********************************************************************\
+ *	Constructor														 *
+\*********************************************************************/
+
+// Starts at zero with zero in memory.
+//	Parameters:
+//		oContext : DecimalContext - Precision and rounding of every result.
+//////////////////////////////////////////////////////////////////////
+DecimalCalculator::DecimalCalculator( const DecimalContext& oContext )
+{
+	m_oContext = oContext;
+}
+
+/*********************************************************************\
+ *	Public Use Functions											 *
+\*********************************************************************/
+
+// Applies an operator and operand to the working value, rounding the
+// result to the context.
+//	Parameters:
+//		cOperator : Char - The operation to perform.
+//		oValue : BigDecimal - The operand.
+//	Returns:
+//		DECIMAL_OK, or why the operation failed.  The working value is
+//		unchanged on failure.
+//////////////////////////////////////////////////////////////////////
+eDecimalStatus DecimalCalculator::process_Calculation( char cOperator, const BigDecimal& oValue )
+{
+	switch( cOperator )
+	{
+	case '+':
+		METRIC_COUNT_OPERATOR( METRIC_OP_ADD );
+		return m_oValue.add( oValue, m_oContext );
+	case '-':
+		METRIC_COUNT_OPERATOR( METRIC_OP_SUBTRACT );
+		return m_oValue.subtract( oValue, m_oContext );
+	case '*':
+		METRIC_COUNT_OPERATOR( METRIC_OP_MULTIPLY );
+		return m_oValue.multiply( oValue, m_oContext );
+	case '/':
+		METRIC_COUNT_OPERATOR( METRIC_OP_DIVIDE );
+		return m_oValue.divide( oValue, m_oContext );
+	default:
+		METRIC_COUNT_OPERATOR( METRIC_OP_OTHER );
+		break;
+	}
+
+	return DECIMAL_OK;
+}
+
+// Returns true if the operator is one this calculator performs.
+bool DecimalCalculator::isValidOperand( char cOperand ) const
+{
+	return cOperand == '+' || cOperand == '-' || cOperand == '*' || cOperand == '/';
+}
+
+/*********************************************************************\
+ *	Getters and Setters  											 *
+\*********************************************************************/
+
+// Returns the precision and rounding results are brought to.
+const DecimalContext& DecimalCalculator::get_Context( ) const
+{
+	return m_oContext;
+}
+
+// Stores the working value into memory.
+void DecimalCalculator::store_Mem( )
+{
+	METRIC_COUNT_OPERATOR( METRIC_OP_STORE );
+	m_oMemory = m_oValue;
+}
+
+// Returns the value held in memory.
+const BigDecimal& DecimalCalculator::pull_Mem( ) const
+{
+	return m_oMemory;
+}
+
+// Resets the working value to zero.
+void DecimalCalculator::clear_Value( )
+{
+	METRIC_COUNT_OPERATOR( METRIC_OP_RESET );
+	m_oValue = BigDecimal( );
+}
+
+// Returns the working value.
+const BigDecimal& DecimalCalculator::read_Value( ) const
+{
+	return m_oValue;
+}
+
+// Replaces the working value.  Like the operand of an operator, it is
+// kept exactly as written.
+void DecimalCalculator::set_Value( const BigDecimal& oValue )
+{
+	METRIC_COUNT_OPERATOR( METRIC_OP_SET );
+	m_oValue = oValue;
+}
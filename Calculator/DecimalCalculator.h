@@ -0,0 +1,43 @@
+#ifndef _DECIMALCALCULATOR_H
+#define _DECIMALCALCULATOR_H
+
+// Name: DecimalCalculator.h
+// Description: Calculator for the decimal mode.  Works like Calculator,
+//				but the working value and memory are BigDecimals, rounded
+//				to a fixed number of significant digits, so ledgers in
+//				cents add up exactly.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "BigDecimal.h"
+
+////////////////////////////////////
+// DecimalCalculator Declaration  //
+////////////////////////////////////
+class DecimalCalculator
+{
+public:
+	explicit DecimalCalculator( const DecimalContext& oContext );
+
+	// public use functions
+	eDecimalStatus process_Calculation( char cOperator, const BigDecimal& oValue );
+	bool isValidOperand( char cOperand ) const;
+
+	// Getters and setters
+	const DecimalContext& get_Context( ) const;
+	void store_Mem( );
+	const BigDecimal& pull_Mem( ) const;
+	void clear_Value( );
+	const BigDecimal& read_Value( ) const;
+	void set_Value( const BigDecimal& oValue );
+
+private:
+	BigDecimal m_oMemory;
+	BigDecimal m_oValue;
+	DecimalContext m_oContext;
+};
+
+#endif
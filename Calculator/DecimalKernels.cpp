@@ -0,0 +1,682 @@
+// Name: DecimalKernels.cpp
+// Description: Base 10^9 magnitude arithmetic for BigDecimal, see
+//				DecimalKernels.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "DecimalKernels.h"
+#include <cstring>
+
+/////////////
+// Defines //
+/////////////
+#define NEWTON_BASE_LIMBS	16		// Reciprocals this short come from long division
+#define MAX_CORRECTIONS		32		// Quotient fix ups before falling back to long division
+
+const uint32_t iDECIMAL_POWERS[ DECIMAL_BASE_DIGITS + 1 ] =
+{
+	1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U, 1000000000U
+};
+
+// A magnitude with a sign, for the Toom-3 interpolation.
+struct SignedLimbs
+{
+	uint32_t* pLimbs;
+	size_t iLength;				// Trimmed
+	bool bNegative;
+};
+
+static void divide_Schoolbook( uint32_t* pQuotient, uint32_t* pRemainder, const uint32_t* pA, size_t iA,
+							   const uint32_t* pB, size_t iB, LimbArena& oArena );
+
+/*********************************************************************\
+ *	Basic Operations												 *
+\*********************************************************************/
+
+size_t trim_Limbs( const uint32_t* pLimbs, size_t iLength )
+{
+	while( iLength > 0 && pLimbs[ iLength - 1 ] == 0 )
+		--iLength;
+
+	return iLength;
+}
+
+size_t count_Digits( const uint32_t* pLimbs, size_t iLength )
+{
+	size_t iDigits = 1;
+
+	if( iLength == 0 )
+		return 1;
+
+	while( iDigits < DECIMAL_BASE_DIGITS && pLimbs[ iLength - 1 ] >= iDECIMAL_POWERS[ iDigits ] )
+		++iDigits;
+
+	return ( iLength - 1 ) * DECIMAL_BASE_DIGITS + iDigits;
+}
+
+int compare_Limbs( const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB )
+{
+	if( iA != iB )
+		return iA < iB ? -1 : 1;
+
+	for( size_t i = iA; i-- > 0; )
+		if( pA[ i ] != pB[ i ] )
+			return pA[ i ] < pB[ i ] ? -1 : 1;
+
+	return 0;
+}
+
+uint32_t add_Limbs( uint32_t* pOut, const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB )
+{
+	uint32_t iCarry = 0;
+	size_t i = 0;
+
+	for( ; i < iB; ++i )
+	{
+		uint32_t iSum = pA[ i ] + pB[ i ] + iCarry;
+
+		iCarry = iSum >= DECIMAL_BASE;
+		pOut[ i ] = iCarry ? iSum - DECIMAL_BASE : iSum;
+	}
+
+	for( ; i < iA && iCarry != 0; ++i )
+	{
+		uint32_t iSum = pA[ i ] + 1;
+
+		iCarry = iSum >= DECIMAL_BASE;
+		pOut[ i ] = iCarry ? 0 : iSum;
+	}
+
+	if( pOut != pA && i < iA )
+		memcpy( pOut + i, pA + i, ( iA - i ) * sizeof( uint32_t ) );
+
+	return iCarry;
+}
+
+void subtract_Limbs( uint32_t* pOut, const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB )
+{
+	uint32_t iBorrow = 0;
+	size_t i = 0;
+
+	for( ; i < iB; ++i )
+	{
+		uint32_t iSubtrahend = pB[ i ] + iBorrow;
+
+		iBorrow = pA[ i ] < iSubtrahend;
+		pOut[ i ] = pA[ i ] + ( iBorrow ? DECIMAL_BASE : 0 ) - iSubtrahend;
+	}
+
+	for( ; i < iA && iBorrow != 0; ++i )
+	{
+		iBorrow = pA[ i ] == 0;
+		pOut[ i ] = iBorrow ? DECIMAL_BASE - 1 : pA[ i ] - 1;
+	}
+
+	if( pOut != pA && i < iA )
+		memcpy( pOut + i, pA + i, ( iA - i ) * sizeof( uint32_t ) );
+}
+
+uint32_t multiply_Small( uint32_t* pOut, const uint32_t* pA, size_t iA, uint32_t iFactor, uint32_t iAddend )
+{
+	unsigned long long iCarry = iAddend;
+
+	for( size_t i = 0; i < iA; ++i )
+	{
+		iCarry += (unsigned long long) pA[ i ] * iFactor;
+		pOut[ i ] = (uint32_t)( iCarry % DECIMAL_BASE );
+		iCarry /= DECIMAL_BASE;
+	}
+
+	return (uint32_t) iCarry;
+}
+
+uint32_t divide_Small( uint32_t* pOut, const uint32_t* pA, size_t iA, uint32_t iDivisor )
+{
+	unsigned long long iRemainder = 0;
+
+	for( size_t i = iA; i-- > 0; )
+	{
+		unsigned long long iCurrent = iRemainder * DECIMAL_BASE + pA[ i ];
+
+		pOut[ i ] = (uint32_t)( iCurrent / iDivisor );
+		iRemainder = iCurrent % iDivisor;
+	}
+
+	return (uint32_t) iRemainder;
+}
+
+/*********************************************************************\
+ *	Multiplication													 *
+\*********************************************************************/
+
+// pOut[0, iA + iB) = a * b, one row per limb of b.  Needs iB >= 1.
+static void multiply_Schoolbook( uint32_t* pOut, const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB )
+{
+	memset( pOut, 0, iA * sizeof( uint32_t ) );
+
+	for( size_t i = 0; i < iB; ++i )
+	{
+		unsigned long long iFactor = pB[ i ];
+		unsigned long long iCarry = 0;
+		uint32_t* pRow = pOut + i;
+
+		for( size_t j = 0; j < iA; ++j )
+		{
+			iCarry += pRow[ j ] + iFactor * pA[ j ];
+			pRow[ j ] = (uint32_t)( iCarry % DECIMAL_BASE );
+			iCarry /= DECIMAL_BASE;
+		}
+
+		pRow[ iA ] = (uint32_t) iCarry;
+	}
+}
+
+// a is at least twice as long as b: multiplies b by a's pieces of b's
+// length, so each product is balanced.
+static void multiply_Unbalanced( uint32_t* pOut, const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB,
+								 LimbArena& oArena )
+{
+	LimbScope oScope( oArena );
+	uint32_t* pPiece = oArena.allocate( 2 * iB );
+
+	memset( pOut, 0, ( iA + iB ) * sizeof( uint32_t ) );
+
+	for( size_t iOffset = 0; iOffset < iA; iOffset += iB )
+	{
+		size_t iLength = iA - iOffset < iB ? iA - iOffset : iB;
+
+		multiply_Limbs( pPiece, pA + iOffset, iLength, pB, iB, oArena );
+		add_Limbs( pOut + iOffset, pOut + iOffset, iA + iB - iOffset, pPiece, trim_Limbs( pPiece, iLength + iB ) );
+	}
+}
+
+// Karatsuba: with a = a1 B^h + a0 and b = b1 B^h + b0,
+// a b = z2 B^2h + ( (a0 + a1)(b0 + b1) - z2 - z0 ) B^h + z0, three
+// half size products instead of four.  Needs iA >= iB >= ceil(iA / 2).
+static void multiply_Karatsuba( uint32_t* pOut, const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB,
+								LimbArena& oArena )
+{
+	LimbScope oScope( oArena );
+	size_t iHalf = ( iA + 1 ) / 2;
+	size_t iHigh = iA + iB - 2 * iHalf;
+	uint32_t* pSumA = oArena.allocate( iHalf + 1 );
+	uint32_t* pSumB = oArena.allocate( iHalf + 1 );
+	uint32_t* pMiddle = oArena.allocate( 2 * iHalf + 2 );
+
+	// z0 and z2 go straight into their places in the output.
+	multiply_Limbs( pOut, pA, iHalf, pB, iHalf, oArena );
+
+	if( iB > iHalf )
+		multiply_Limbs( pOut + 2 * iHalf, pA + iHalf, iA - iHalf, pB + iHalf, iB - iHalf, oArena );
+	else
+		memset( pOut + 2 * iHalf, 0, iHigh * sizeof( uint32_t ) );
+
+	pSumA[ iHalf ] = add_Limbs( pSumA, pA, iHalf, pA + iHalf, iA - iHalf );
+	pSumB[ iHalf ] = add_Limbs( pSumB, pB, iHalf, pB + iHalf, iB - iHalf );
+	multiply_Limbs( pMiddle, pSumA, iHalf + 1, pSumB, iHalf + 1, oArena );
+	subtract_Limbs( pMiddle, pMiddle, 2 * iHalf + 2, pOut, 2 * iHalf );
+	subtract_Limbs( pMiddle, pMiddle, 2 * iHalf + 2, pOut + 2 * iHalf, iHigh );
+	add_Limbs( pOut + iHalf, pOut + iHalf, iA + iB - iHalf, pMiddle, trim_Limbs( pMiddle, 2 * iHalf + 2 ) );
+}
+
+// oOut = x + y, or x - y with bSubtract.  oOut needs room for one limb
+// more than the longer input and may share storage with either.
+static void add_Signed( SignedLimbs& oOut, const SignedLimbs& oX, const SignedLimbs& oY, bool bSubtract )
+{
+	const uint32_t* pX = oX.pLimbs;
+	const uint32_t* pY = oY.pLimbs;
+	size_t iX = oX.iLength;
+	size_t iY = oY.iLength;
+	bool bXNegative = oX.bNegative;
+	bool bYNegative = oY.bNegative != bSubtract;
+	size_t iLength = 0;
+
+	if( bXNegative == bYNegative )
+	{
+		if( iX >= iY )
+			oOut.pLimbs[ iX ] = add_Limbs( oOut.pLimbs, pX, iX, pY, iY );
+		else
+			oOut.pLimbs[ iY ] = add_Limbs( oOut.pLimbs, pY, iY, pX, iX );
+
+		iLength = ( iX >= iY ? iX : iY ) + 1;
+		oOut.bNegative = bXNegative;
+	}
+	else if( compare_Limbs( pX, iX, pY, iY ) >= 0 )
+	{
+		subtract_Limbs( oOut.pLimbs, pX, iX, pY, iY );
+		iLength = iX;
+		oOut.bNegative = bXNegative;
+	}
+	else
+	{
+		subtract_Limbs( oOut.pLimbs, pY, iY, pX, iX );
+		iLength = iY;
+		oOut.bNegative = bYNegative;
+	}
+
+	oOut.iLength = trim_Limbs( oOut.pLimbs, iLength );
+	oOut.bNegative = oOut.bNegative && oOut.iLength > 0;
+}
+
+// oValue /= iDivisor, which must divide it exactly.
+static void divide_Signed_Exact( SignedLimbs& oValue, uint32_t iDivisor )
+{
+	divide_Small( oValue.pLimbs, oValue.pLimbs, oValue.iLength, iDivisor );
+	oValue.iLength = trim_Limbs( oValue.pLimbs, oValue.iLength );
+	oValue.bNegative = oValue.bNegative && oValue.iLength > 0;
+}
+
+// oOut = x * y.  oOut needs room for both lengths together.
+static void multiply_Signed( SignedLimbs& oOut, const SignedLimbs& oX, const SignedLimbs& oY, LimbArena& oArena )
+{
+	if( oX.iLength == 0 || oY.iLength == 0 )
+	{
+		oOut.iLength = 0;
+		oOut.bNegative = false;
+		return;
+	}
+
+	multiply_Limbs( oOut.pLimbs, oX.pLimbs, oX.iLength, oY.pLimbs, oY.iLength, oArena );
+	oOut.iLength = trim_Limbs( oOut.pLimbs, oX.iLength + oY.iLength );
+	oOut.bNegative = oX.bNegative != oY.bNegative;
+}
+
+// Evaluates p(x) = p2 x^2 + p1 x + p0 at 1, -1 and -2.  Each output needs
+// iPiece + 3 limbs.
+static void evaluate_Toom3( const uint32_t* pLimbs, size_t iLength, size_t iPiece, LimbArena& oArena,
+							SignedLimbs& oAtOne, SignedLimbs& oAtMinusOne, SignedLimbs& oAtMinusTwo )
+{
+	size_t iMiddle = iLength > iPiece ? ( iLength - iPiece < iPiece ? iLength - iPiece : iPiece ) : 0;
+	size_t iTop = iLength > 2 * iPiece ? iLength - 2 * iPiece : 0;
+	uint32_t* pLow = const_cast< uint32_t* >( pLimbs );
+	SignedLimbs oP0 = { pLow, trim_Limbs( pLow, iLength < iPiece ? iLength : iPiece ), false };
+	SignedLimbs oP1 = { pLow + iPiece, trim_Limbs( pLow + iPiece, iMiddle ), false };
+	SignedLimbs oP2 = { pLow + 2 * iPiece, trim_Limbs( pLow + 2 * iPiece, iTop ), false };
+	SignedLimbs oEven = { oArena.allocate( iPiece + 3 ), 0, false };
+
+	add_Signed( oEven, oP0, oP2, false );
+	add_Signed( oAtOne, oEven, oP1, false );
+	add_Signed( oAtMinusOne, oEven, oP1, true );
+
+	// p(-2) = 2 ( p(-1) + p2 ) - p0
+	add_Signed( oAtMinusTwo, oAtMinusOne, oP2, false );
+	oAtMinusTwo.pLimbs[ oAtMinusTwo.iLength ] = multiply_Small( oAtMinusTwo.pLimbs, oAtMinusTwo.pLimbs,
+																 oAtMinusTwo.iLength, 2, 0 );
+	oAtMinusTwo.iLength = trim_Limbs( oAtMinusTwo.pLimbs, oAtMinusTwo.iLength + 1 );
+	add_Signed( oAtMinusTwo, oAtMinusTwo, oP0, true );
+}
+
+// Toom-3: splits both operands in three and multiplies the quadratics
+// they make by evaluating at 0, 1, -1, -2 and infinity, five third size
+// products instead of nine.  Interpolation follows Bodrato's sequence.
+// Needs iA >= iB > iA / 2.
+static void multiply_Toom3( uint32_t* pOut, const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB,
+							LimbArena& oArena )
+{
+	LimbScope oScope( oArena );
+	size_t iPiece = ( iA + 2 ) / 3;
+	size_t iTotal = iA + iB;
+	size_t iProduct = 2 * iPiece + 8;
+	SignedLimbs aA[ 3 ];
+	SignedLimbs aB[ 3 ];
+	SignedLimbs oR1 = { oArena.allocate( iProduct ), 0, false };
+	SignedLimbs oRMinus1 = { oArena.allocate( iProduct ), 0, false };
+	SignedLimbs oRMinus2 = { oArena.allocate( iProduct ), 0, false };
+	SignedLimbs oR2 = { oArena.allocate( iProduct ), 0, false };
+	SignedLimbs oR3 = { oArena.allocate( iProduct ), 0, false };
+	SignedLimbs oR0 = { pOut, 0, false };
+	SignedLimbs oRInfinity = { pOut + 4 * iPiece, 0, false };
+
+	for( int i = 0; i < 3; ++i )
+	{
+		SignedLimbs oEmpty = { oArena.allocate( iPiece + 3 ), 0, false };
+		SignedLimbs oOther = { oArena.allocate( iPiece + 3 ), 0, false };
+
+		aA[ i ] = oEmpty;
+		aB[ i ] = oOther;
+	}
+
+	evaluate_Toom3( pA, iA, iPiece, oArena, aA[ 0 ], aA[ 1 ], aA[ 2 ] );
+	evaluate_Toom3( pB, iB, iPiece, oArena, aB[ 0 ], aB[ 1 ], aB[ 2 ] );
+
+	// r(0) and r(infinity) go straight into their places in the output.
+	memset( pOut, 0, iTotal * sizeof( uint32_t ) );
+	multiply_Limbs( pOut, pA, iPiece, pB, iB < iPiece ? iB : iPiece, oArena );
+	oR0.iLength = trim_Limbs( pOut, 2 * iPiece );
+
+	if( iB > 2 * iPiece )
+	{
+		multiply_Limbs( pOut + 4 * iPiece, pA + 2 * iPiece, iA - 2 * iPiece, pB + 2 * iPiece, iB - 2 * iPiece, oArena );
+		oRInfinity.iLength = trim_Limbs( oRInfinity.pLimbs, iTotal - 4 * iPiece );
+	}
+
+	multiply_Signed( oR1, aA[ 0 ], aB[ 0 ], oArena );
+	multiply_Signed( oRMinus1, aA[ 1 ], aB[ 1 ], oArena );
+	multiply_Signed( oRMinus2, aA[ 2 ], aB[ 2 ], oArena );
+
+	// r3 = ( r(-2) - r(1) ) / 3
+	add_Signed( oR3, oRMinus2, oR1, true );
+	divide_Signed_Exact( oR3, 3 );
+	// r1 = ( r(1) - r(-1) ) / 2
+	add_Signed( oR1, oR1, oRMinus1, true );
+	divide_Signed_Exact( oR1, 2 );
+	// r2 = r(-1) - r(0)
+	add_Signed( oR2, oRMinus1, oR0, true );
+	// r3 = ( r2 - r3 ) / 2 + 2 r(infinity)
+	add_Signed( oR3, oR2, oR3, true );
+	divide_Signed_Exact( oR3, 2 );
+	add_Signed( oR3, oR3, oRInfinity, false );
+	add_Signed( oR3, oR3, oRInfinity, false );
+	// r2 = r2 + r1 - r(infinity)
+	add_Signed( oR2, oR2, oR1, false );
+	add_Signed( oR2, oR2, oRInfinity, true );
+	// r1 = r1 - r3
+	add_Signed( oR1, oR1, oR3, true );
+
+	// The three middle coefficients are the true ones now, so none is
+	// negative.
+	add_Limbs( pOut + iPiece, pOut + iPiece, iTotal - iPiece, oR1.pLimbs, oR1.iLength );
+	add_Limbs( pOut + 2 * iPiece, pOut + 2 * iPiece, iTotal - 2 * iPiece, oR2.pLimbs, oR2.iLength );
+	add_Limbs( pOut + 3 * iPiece, pOut + 3 * iPiece, iTotal - 3 * iPiece, oR3.pLimbs, oR3.iLength );
+}
+
+void multiply_Limbs( uint32_t* pOut, const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB,
+					 LimbArena& oArena )
+{
+	size_t iTotal = iA + iB;
+
+	iA = trim_Limbs( pA, iA );
+	iB = trim_Limbs( pB, iB );
+
+	if( iA < iB )
+	{
+		const uint32_t* pSwap = pA;
+		size_t iSwap = iA;
+
+		pA = pB;
+		iA = iB;
+		pB = pSwap;
+		iB = iSwap;
+	}
+
+	if( iB == 0 )
+	{
+		memset( pOut, 0, iTotal * sizeof( uint32_t ) );
+		return;
+	}
+
+	if( iA + iB < iTotal )
+		memset( pOut + iA + iB, 0, ( iTotal - iA - iB ) * sizeof( uint32_t ) );
+
+	if( iB < KARATSUBA_THRESHOLD )
+		multiply_Schoolbook( pOut, pA, iA, pB, iB );
+	else if( iA >= 2 * iB )
+		multiply_Unbalanced( pOut, pA, iA, pB, iB, oArena );
+	else if( iB >= TOOM3_THRESHOLD && 2 * iA < 3 * iB )
+		multiply_Toom3( pOut, pA, iA, pB, iB, oArena );
+	else
+		multiply_Karatsuba( pOut, pA, iA, pB, iB, oArena );
+}
+
+/*********************************************************************\
+ *	Division														 *
+\*********************************************************************/
+
+// Knuth's algorithm D.  Needs iB >= 2, a trimmed b and iA >= iB.
+static void divide_Schoolbook( uint32_t* pQuotient, uint32_t* pRemainder, const uint32_t* pA, size_t iA,
+							   const uint32_t* pB, size_t iB, LimbArena& oArena )
+{
+	LimbScope oScope( oArena );
+	uint32_t iScale = DECIMAL_BASE / ( pB[ iB - 1 ] + 1 );
+	uint32_t* pV = oArena.allocate( iB );
+	uint32_t* pU = oArena.allocate( iA + 1 );
+	unsigned long long iTop = 0;
+	unsigned long long iNext = 0;
+
+	// Scale so the divisor's top limb is at least half the base, which
+	// keeps each estimated quotient limb at most two too large.
+	multiply_Small( pV, pB, iB, iScale, 0 );
+	pU[ iA ] = multiply_Small( pU, pA, iA, iScale, 0 );
+	iTop = pV[ iB - 1 ];
+	iNext = pV[ iB - 2 ];
+
+	for( size_t j = iA - iB + 1; j-- > 0; )
+	{
+		unsigned long long iNumerator = (unsigned long long) pU[ j + iB ] * DECIMAL_BASE + pU[ j + iB - 1 ];
+		unsigned long long iEstimate = iNumerator / iTop;
+		unsigned long long iRest = iNumerator % iTop;
+		unsigned long long iCarry = 0;
+		long long iBorrow = 0;
+		long long iHigh = 0;
+
+		while( iEstimate >= DECIMAL_BASE || iEstimate * iNext > iRest * DECIMAL_BASE + pU[ j + iB - 2 ] )
+		{
+			--iEstimate;
+			iRest += iTop;
+
+			if( iRest >= DECIMAL_BASE )
+				break;
+		}
+
+		for( size_t i = 0; i < iB; ++i )
+		{
+			long long iLimb = 0;
+
+			iCarry += iEstimate * pV[ i ];
+			iLimb = (long long) pU[ i + j ] - (long long)( iCarry % DECIMAL_BASE ) - iBorrow;
+			iCarry /= DECIMAL_BASE;
+			iBorrow = iLimb < 0;
+			pU[ i + j ] = (uint32_t)( iLimb + ( iBorrow ? DECIMAL_BASE : 0 ) );
+		}
+
+		iHigh = (long long) pU[ j + iB ] - (long long) iCarry - iBorrow;
+
+		// Still one too large: add the divisor back.
+		if( iHigh < 0 )
+		{
+			--iEstimate;
+			iHigh += add_Limbs( pU + j, pU + j, iB, pV, iB );
+		}
+
+		pU[ j + iB ] = (uint32_t) iHigh;
+		pQuotient[ j ] = (uint32_t) iEstimate;
+	}
+
+	divide_Small( pRemainder, pU, iB, iScale );
+}
+
+// Finds about B^2n / v for a v of n limbs whose top limb is at least half
+// the base, by one Newton step x' = x + x ( B^2n - v x ) / B^2n from the
+// reciprocal of v's top half.  The result is within a few units; the
+// division that uses it corrects its quotients.
+//	Returns:
+//		The length of the reciprocal written to pX, which needs n + 2 limbs.
+//////////////////////////////////////////////////////////////////////////////
+static size_t find_Reciprocal( uint32_t* pX, const uint32_t* pV, size_t iV, LimbArena& oArena )
+{
+	LimbScope oScope( oArena );
+
+	if( iV <= NEWTON_BASE_LIMBS )
+	{
+		uint32_t* pPower = oArena.allocate_Zeroed( 2 * iV + 1 );
+		uint32_t* pRemainder = oArena.allocate( iV );
+
+		pPower[ 2 * iV ] = 1;
+		divide_Schoolbook( pX, pRemainder, pPower, 2 * iV + 1, pV, iV, oArena );
+		return trim_Limbs( pX, iV + 2 );
+	}
+
+	size_t iHalf = iV / 2 + 1;
+	uint32_t* pHalf = oArena.allocate( iHalf + 2 );
+	size_t iHalfLength = find_Reciprocal( pHalf, pV + iV - iHalf, iHalf, oArena );
+	uint32_t* pProduct = oArena.allocate( iV + iHalfLength );
+	uint32_t* pPower = oArena.allocate_Zeroed( iV + iHalf + 1 );
+	uint32_t* pError = oArena.allocate( iV + iHalf + 3 );
+	size_t iProduct = 0;
+	size_t iError = 0;
+	bool bOver = false;
+
+	// With x = x' B^(n-h), the error term v x scaled down by B^(n-h) is
+	// B^(n+h) - v x', and the step is x' ( B^(n+h) - v x' ) / B^2h.
+	multiply_Limbs( pProduct, pV, iV, pHalf, iHalfLength, oArena );
+	iProduct = trim_Limbs( pProduct, iV + iHalfLength );
+	pPower[ iV + iHalf ] = 1;
+	bOver = compare_Limbs( pProduct, iProduct, pPower, iV + iHalf + 1 ) > 0;
+
+	if( bOver )
+		subtract_Limbs( pError, pProduct, iProduct, pPower, iV + iHalf + 1 );
+	else
+		subtract_Limbs( pError, pPower, iV + iHalf + 1, pProduct, iProduct );
+
+	iError = trim_Limbs( pError, bOver ? iProduct : iV + iHalf + 1 );
+
+	uint32_t* pStep = oArena.allocate( iHalfLength + iError );
+	size_t iStep = 0;
+
+	multiply_Limbs( pStep, pHalf, iHalfLength, pError, iError, oArena );
+	iStep = trim_Limbs( pStep, iHalfLength + iError );
+	iStep = iStep > 2 * iHalf ? iStep - 2 * iHalf : 0;
+
+	memset( pX, 0, ( iV + 2 ) * sizeof( uint32_t ) );
+	memcpy( pX + iV - iHalf, pHalf, iHalfLength * sizeof( uint32_t ) );
+
+	if( bOver )
+		subtract_Limbs( pX, pX, iV + 2, pStep + 2 * iHalf, iStep );
+	else
+		add_Limbs( pX, pX, iV + 2, pStep + 2 * iHalf, iStep );
+
+	return trim_Limbs( pX, iV + 2 );
+}
+
+// Divides a block w < v B^n by the normalized divisor v of n limbs using
+// its reciprocal x: q = floor( floor( w / B^(n-1) ) x / B^(n+1) ) is at
+// most a few units off, and is corrected against the exact remainder.
+// pQuotient gets n + 2 limbs and pRemainder up to n.
+//	Returns:
+//		The length of the remainder.
+//////////////////////////////////////////////////////////////////////////////
+static size_t divide_Block( uint32_t* pQuotient, uint32_t* pRemainder, const uint32_t* pW, size_t iW,
+							const uint32_t* pV, size_t iV, const uint32_t* pX, size_t iX, LimbArena& oArena )
+{
+	LimbScope oScope( oArena );
+	static const uint32_t iONE = 1;
+	size_t iHigh = iW > iV - 1 ? iW - ( iV - 1 ) : 0;
+	uint32_t* pProduct = oArena.allocate( iHigh + iX + iV + 3 );
+	uint32_t* pRest = oArena.allocate( iW + 1 );
+	size_t iEstimate = 0;
+	size_t iProduct = 0;
+	size_t iRest = 0;
+	unsigned int iCorrections = 0;
+
+	memset( pQuotient, 0, ( iV + 2 ) * sizeof( uint32_t ) );
+
+	if( compare_Limbs( pW, iW, pV, iV ) < 0 )
+	{
+		memcpy( pRemainder, pW, iW * sizeof( uint32_t ) );
+		return iW;
+	}
+
+	multiply_Limbs( pProduct, pW + ( iV - 1 ), iHigh, pX, iX, oArena );
+	iProduct = trim_Limbs( pProduct, iHigh + iX );
+	iEstimate = iProduct > iV + 1 ? iProduct - ( iV + 1 ) : 0;
+	memcpy( pQuotient, pProduct + iV + 1, iEstimate * sizeof( uint32_t ) );
+
+	// pProduct = q v, brought down to w or below.
+	multiply_Limbs( pProduct, pQuotient, iEstimate, pV, iV, oArena );
+	iProduct = trim_Limbs( pProduct, iEstimate + iV );
+
+	while( compare_Limbs( pProduct, iProduct, pW, iW ) > 0 && iCorrections++ < MAX_CORRECTIONS )
+	{
+		subtract_Limbs( pQuotient, pQuotient, iV + 2, &iONE, 1 );
+		subtract_Limbs( pProduct, pProduct, iProduct, pV, iV );
+		iProduct = trim_Limbs( pProduct, iProduct );
+	}
+
+	if( iCorrections <= MAX_CORRECTIONS )
+	{
+		subtract_Limbs( pRest, pW, iW, pProduct, iProduct );
+		iRest = trim_Limbs( pRest, iW );
+
+		while( compare_Limbs( pRest, iRest, pV, iV ) >= 0 && iCorrections++ < MAX_CORRECTIONS )
+		{
+			add_Limbs( pQuotient, pQuotient, iV + 2, &iONE, 1 );
+			subtract_Limbs( pRest, pRest, iRest, pV, iV );
+			iRest = trim_Limbs( pRest, iRest );
+		}
+	}
+
+	// The estimate was further off than it can be; don't trust it.
+	if( iCorrections > MAX_CORRECTIONS )
+	{
+		memset( pQuotient, 0, ( iV + 2 ) * sizeof( uint32_t ) );
+		divide_Schoolbook( pQuotient, pRest, pW, iW, pV, iV, oArena );
+		iRest = trim_Limbs( pRest, iV );
+	}
+
+	memcpy( pRemainder, pRest, iRest * sizeof( uint32_t ) );
+	return iRest;
+}
+
+// Divides by multiplying with the divisor's reciprocal, a block of the
+// divisor's length at a time from the top.
+static void divide_Newton( uint32_t* pQuotient, uint32_t* pRemainder, const uint32_t* pA, size_t iA,
+						   const uint32_t* pB, size_t iB, LimbArena& oArena )
+{
+	LimbScope oScope( oArena );
+	uint32_t iScale = DECIMAL_BASE / ( pB[ iB - 1 ] + 1 );
+	uint32_t* pV = oArena.allocate( iB );
+	uint32_t* pU = oArena.allocate( iA + 1 );
+	uint32_t* pX = oArena.allocate( iB + 2 );
+	uint32_t* pW = oArena.allocate( 2 * iB );
+	uint32_t* pBlock = oArena.allocate( iB + 2 );
+	uint32_t* pRest = oArena.allocate( iB );
+	size_t iQuotient = iA - iB + 1;
+	size_t iU = 0;
+	size_t iX = 0;
+	size_t iRest = 0;
+	size_t iOffset = 0;
+
+	multiply_Small( pV, pB, iB, iScale, 0 );
+	pU[ iA ] = multiply_Small( pU, pA, iA, iScale, 0 );
+	iU = trim_Limbs( pU, iA + 1 );
+	iX = find_Reciprocal( pX, pV, iB, oArena );
+	iOffset = iU > 0 ? ( ( iU - 1 ) / iB ) * iB : 0;
+	memset( pQuotient, 0, iQuotient * sizeof( uint32_t ) );
+
+	for( ;; )
+	{
+		size_t iLength = iU - iOffset < iB ? iU - iOffset : iB;
+
+		// w = rest B^n + the next block of u.
+		memcpy( pW, pU + iOffset, iLength * sizeof( uint32_t ) );
+		memset( pW + iLength, 0, ( iB - iLength ) * sizeof( uint32_t ) );
+		memcpy( pW + iB, pRest, iRest * sizeof( uint32_t ) );
+		iRest = divide_Block( pBlock, pRest, pW, trim_Limbs( pW, iB + iRest ), pV, iB, pX, iX, oArena );
+
+		for( size_t i = 0; i < iB && iOffset + i < iQuotient; ++i )
+			pQuotient[ iOffset + i ] = pBlock[ i ];
+
+		if( iOffset == 0 )
+			break;
+
+		iOffset -= iB;
+	}
+
+	memset( pRemainder, 0, iB * sizeof( uint32_t ) );
+	memcpy( pRemainder, pRest, iRest * sizeof( uint32_t ) );
+	divide_Small( pRemainder, pRemainder, iB, iScale );
+}
+
+void divide_Limbs( uint32_t* pQuotient, uint32_t* pRemainder, const uint32_t* pA, size_t iA,
+				   const uint32_t* pB, size_t iB, LimbArena& oArena )
+{
+	if( iB == 1 )
+		pRemainder[ 0 ] = divide_Small( pQuotient, pA, iA, pB[ 0 ] );
+	else if( iB < NEWTON_THRESHOLD || iA - iB + 1 < NEWTON_THRESHOLD )
+		divide_Schoolbook( pQuotient, pRemainder, pA, iA, pB, iB, oArena );
+	else
+		divide_Newton( pQuotient, pRemainder, pA, iA, pB, iB, oArena );
+}
@@ -0,0 +1,77 @@
+#ifndef _DECIMALKERNELS_H
+#define _DECIMALKERNELS_H
+
+// Name: DecimalKernels.h
+// Description: Arithmetic on the magnitudes behind BigDecimal.  A
+//				magnitude is an array of base 10^9 limbs, least significant
+//				first, so rounding to a number of decimal digits never
+//				needs a base conversion.
+//
+//				Multiplication is schoolbook for short operands, Karatsuba
+//				past KARATSUBA_THRESHOLD limbs and Toom-3 past
+//				TOOM3_THRESHOLD.  Division is schoolbook (Knuth's algorithm
+//				D) until both the divisor and the quotient are longer than
+//				NEWTON_THRESHOLD limbs, after which it multiplies by a
+//				reciprocal found with Newton's iteration.  Temporaries come
+//				from the caller's LimbArena.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "LimbArena.h"
+#include <cstddef>
+#include <cstdint>
+
+/////////////
+// Defines //
+/////////////
+#define DECIMAL_BASE			1000000000U
+#define DECIMAL_BASE_DIGITS		9
+#define KARATSUBA_THRESHOLD		40			// Limbs, about 360 digits
+#define TOOM3_THRESHOLD			160			// Limbs, about 1440 digits
+#define NEWTON_THRESHOLD		100			// Limbs, about 900 digits
+
+// Powers of ten that fit in a limb.
+extern const uint32_t iDECIMAL_POWERS[ DECIMAL_BASE_DIGITS + 1 ];
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+
+// Returns the length of the magnitude without its leading zero limbs.
+size_t trim_Limbs( const uint32_t* pLimbs, size_t iLength );
+
+// Returns the number of decimal digits in a trimmed magnitude, 1 for zero.
+size_t count_Digits( const uint32_t* pLimbs, size_t iLength );
+
+// Returns -1, 0 or 1 as a is less than, equal to or greater than b.  Both
+// must be trimmed.
+int compare_Limbs( const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB );
+
+// pOut[0, iA) = a + b, returning the carry out.  Needs iA >= iB; pOut may
+// be a or b.
+uint32_t add_Limbs( uint32_t* pOut, const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB );
+
+// pOut[0, iA) = a - b.  Needs a >= b; pOut may be a or b.
+void subtract_Limbs( uint32_t* pOut, const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB );
+
+// pOut[0, iA) = a * iFactor + iAddend, returning the limb carried out.
+// pOut may be a.
+uint32_t multiply_Small( uint32_t* pOut, const uint32_t* pA, size_t iA, uint32_t iFactor, uint32_t iAddend );
+
+// pOut[0, iA) = a / iDivisor, returning the remainder.  pOut may be a.
+uint32_t divide_Small( uint32_t* pOut, const uint32_t* pA, size_t iA, uint32_t iDivisor );
+
+// pOut[0, iA + iB) = a * b.  pOut must not overlap either input.
+void multiply_Limbs( uint32_t* pOut, const uint32_t* pA, size_t iA, const uint32_t* pB, size_t iB,
+					 LimbArena& oArena );
+
+// pQuotient[0, iA - iB + 1) = a / b and pRemainder[0, iB) = a % b.  b must
+// be trimmed and not zero, and iA >= iB.  The outputs must not overlap the
+// inputs.
+void divide_Limbs( uint32_t* pQuotient, uint32_t* pRemainder, const uint32_t* pA, size_t iA,
+				   const uint32_t* pB, size_t iB, LimbArena& oArena );
+
+#endif
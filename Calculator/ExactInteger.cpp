@@ -0,0 +1,638 @@
+// Name: ExactInteger.cpp
+// Description: Slow paths of ExactInteger: 128 bit arithmetic and the
+//				arbitrary precision magnitudes behind it.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "ExactInteger.h"
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define LIMB_BITS			32
+#define LIMB_BASE			( 1ULL << LIMB_BITS )
+#define DECIMAL_CHUNK		1000000000U		// Largest power of ten in a limb
+#define DECIMAL_CHUNK_DIGITS 9
+#define SMALL_MAX_DIGITS	18				// Digits that always fit in a long long
+
+typedef vector< uint32_t > Limbs;
+
+/*********************************************************************\
+ *	Magnitudes														 *
+\*********************************************************************/
+
+// Drops leading zero limbs.
+static void trim( Limbs& vLimbs )
+{
+	while( !vLimbs.empty( ) && vLimbs.back( ) == 0 )
+		vLimbs.pop_back( );
+}
+
+// Returns -1, 0 or 1 as a is less than, equal to or greater than b.
+static int compare_Magnitudes( const Limbs& vA, const Limbs& vB )
+{
+	if( vA.size( ) != vB.size( ) )
+		return vA.size( ) < vB.size( ) ? -1 : 1;
+
+	for( size_t i = vA.size( ); i-- > 0; )
+		if( vA[ i ] != vB[ i ] )
+			return vA[ i ] < vB[ i ] ? -1 : 1;
+
+	return 0;
+}
+
+// vOut = a + b.  vOut may be either input.
+static void add_Magnitudes( const Limbs& vA, const Limbs& vB, Limbs& vOut )
+{
+	const Limbs& vLong = vA.size( ) >= vB.size( ) ? vA : vB;
+	const Limbs& vShort = vA.size( ) >= vB.size( ) ? vB : vA;
+	Limbs vSum( vLong.size( ) + 1 );
+	unsigned long long iCarry = 0;
+
+	for( size_t i = 0; i < vLong.size( ); ++i )
+	{
+		iCarry += (unsigned long long) vLong[ i ] + ( i < vShort.size( ) ? vShort[ i ] : 0 );
+		vSum[ i ] = (uint32_t) iCarry;
+		iCarry >>= LIMB_BITS;
+	}
+
+	vSum[ vLong.size( ) ] = (uint32_t) iCarry;
+	trim( vSum );
+	vOut.swap( vSum );
+}
+
+// vOut = a - b, for a >= b.  vOut may be either input.
+static void subtract_Magnitudes( const Limbs& vA, const Limbs& vB, Limbs& vOut )
+{
+	Limbs vDifference( vA.size( ) );
+	long long iBorrow = 0;
+
+	for( size_t i = 0; i < vA.size( ); ++i )
+	{
+		long long iLimb = (long long) vA[ i ] - ( i < vB.size( ) ? vB[ i ] : 0 ) - iBorrow;
+
+		iBorrow = iLimb < 0 ? 1 : 0;
+		vDifference[ i ] = (uint32_t)( iLimb + ( iBorrow ? (long long) LIMB_BASE : 0 ) );
+	}
+
+	trim( vDifference );
+	vOut.swap( vDifference );
+}
+
+// vOut = a * b, schoolbook.  vOut may be either input.
+static void multiply_Magnitudes( const Limbs& vA, const Limbs& vB, Limbs& vOut )
+{
+	Limbs vProduct( vA.size( ) + vB.size( ), 0 );
+
+	for( size_t i = 0; i < vA.size( ); ++i )
+	{
+		unsigned long long iCarry = 0;
+
+		for( size_t j = 0; j < vB.size( ); ++j )
+		{
+			iCarry += (unsigned long long) vA[ i ] * vB[ j ] + vProduct[ i + j ];
+			vProduct[ i + j ] = (uint32_t) iCarry;
+			iCarry >>= LIMB_BITS;
+		}
+
+		vProduct[ i + vB.size( ) ] = (uint32_t) iCarry;
+	}
+
+	trim( vProduct );
+	vOut.swap( vProduct );
+}
+
+// vLimbs = vLimbs * iFactor + iAddend.
+static void multiply_Add_Small( Limbs& vLimbs, uint32_t iFactor, uint32_t iAddend )
+{
+	unsigned long long iCarry = iAddend;
+
+	for( size_t i = 0; i < vLimbs.size( ); ++i )
+	{
+		iCarry += (unsigned long long) vLimbs[ i ] * iFactor;
+		vLimbs[ i ] = (uint32_t) iCarry;
+		iCarry >>= LIMB_BITS;
+	}
+
+	if( iCarry != 0 )
+		vLimbs.push_back( (uint32_t) iCarry );
+}
+
+// vLimbs /= iDivisor.
+//	Returns:
+//		The remainder.
+//////////////////////////////////////////////////////////////////////
+static uint32_t divide_Small( Limbs& vLimbs, uint32_t iDivisor )
+{
+	unsigned long long iRemainder = 0;
+
+	for( size_t i = vLimbs.size( ); i-- > 0; )
+	{
+		unsigned long long iPart = ( iRemainder << LIMB_BITS ) | vLimbs[ i ];
+
+		vLimbs[ i ] = (uint32_t)( iPart / iDivisor );
+		iRemainder = iPart % iDivisor;
+	}
+
+	trim( vLimbs );
+	return (uint32_t) iRemainder;
+}
+
+// Returns the number of leading zero bits of a non-zero limb.
+static int count_Leading_Zeros( uint32_t iLimb )
+{
+	int iCount = 0;
+
+	while( !( iLimb & 0x80000000U ) )
+	{
+		iLimb <<= 1;
+		++iCount;
+	}
+
+	return iCount;
+}
+
+// Long division of magnitudes, Knuth's algorithm D.  The divisor must
+// not be zero.
+//	Parameters:
+//		vU : Limbs - The dividend.
+//		vV : Limbs - The divisor.
+//		vQuotient, vRemainder : Limbs - Where to put the results.
+//////////////////////////////////////////////////////////////////////
+static void divide_Magnitudes( const Limbs& vU, const Limbs& vV, Limbs& vQuotient, Limbs& vRemainder )
+{
+	size_t n = vV.size( );
+	size_t m = 0;
+	int iShift = 0;
+
+	if( compare_Magnitudes( vU, vV ) < 0 )
+	{
+		vRemainder = vU;
+		vQuotient.clear( );
+		return;
+	}
+
+	if( n == 1 )
+	{
+		uint32_t iRemainder = 0;
+
+		vQuotient = vU;
+		iRemainder = divide_Small( vQuotient, vV[ 0 ] );
+		vRemainder.assign( iRemainder != 0 ? 1 : 0, iRemainder );
+		return;
+	}
+
+	m = vU.size( ) - n;
+	iShift = count_Leading_Zeros( vV[ n - 1 ] );
+
+	// Normalize so the divisor's top limb has its high bit set.
+	Limbs vNV( n );
+	Limbs vNU( vU.size( ) + 1 );
+
+	for( size_t i = n - 1; i > 0; --i )
+		vNV[ i ] = ( vV[ i ] << iShift ) | ( iShift ? vV[ i - 1 ] >> ( LIMB_BITS - iShift ) : 0 );
+
+	vNV[ 0 ] = vV[ 0 ] << iShift;
+	vNU[ vU.size( ) ] = iShift ? vU[ vU.size( ) - 1 ] >> ( LIMB_BITS - iShift ) : 0;
+
+	for( size_t i = vU.size( ) - 1; i > 0; --i )
+		vNU[ i ] = ( vU[ i ] << iShift ) | ( iShift ? vU[ i - 1 ] >> ( LIMB_BITS - iShift ) : 0 );
+
+	vNU[ 0 ] = vU[ 0 ] << iShift;
+	vQuotient.assign( m + 1, 0 );
+
+	for( size_t j = m + 1; j-- > 0; )
+	{
+		unsigned long long iTop = ( (unsigned long long) vNU[ j + n ] << LIMB_BITS ) | vNU[ j + n - 1 ];
+		unsigned long long iGuess = iTop / vNV[ n - 1 ];
+		unsigned long long iRest = iTop % vNV[ n - 1 ];
+		long long iBorrow = 0;
+		long long iLimb = 0;
+
+		// The guess is at most two too large; this fixes almost every case.
+		while( iGuess >= LIMB_BASE ||
+			   iGuess * vNV[ n - 2 ] > ( ( iRest << LIMB_BITS ) | vNU[ j + n - 2 ] ) )
+		{
+			--iGuess;
+			iRest += vNV[ n - 1 ];
+
+			if( iRest >= LIMB_BASE )
+				break;
+		}
+
+		// Multiply and subtract.
+		for( size_t i = 0; i < n; ++i )
+		{
+			unsigned long long iProduct = iGuess * vNV[ i ];
+
+			iLimb = (long long) vNU[ i + j ] - iBorrow - (long long)( iProduct & 0xFFFFFFFFULL );
+			vNU[ i + j ] = (uint32_t) iLimb;
+			iBorrow = (long long)( iProduct >> LIMB_BITS ) - ( iLimb >> LIMB_BITS );
+		}
+
+		iLimb = (long long) vNU[ j + n ] - iBorrow;
+		vNU[ j + n ] = (uint32_t) iLimb;
+		vQuotient[ j ] = (uint32_t) iGuess;
+
+		// Still one too large: add the divisor back.
+		if( iLimb < 0 )
+		{
+			unsigned long long iCarry = 0;
+
+			--vQuotient[ j ];
+
+			for( size_t i = 0; i < n; ++i )
+			{
+				iCarry += (unsigned long long) vNU[ i + j ] + vNV[ i ];
+				vNU[ i + j ] = (uint32_t) iCarry;
+				iCarry >>= LIMB_BITS;
+			}
+
+			vNU[ j + n ] += (uint32_t) iCarry;
+		}
+	}
+
+	// Undo the normalization on the remainder.
+	vRemainder.assign( n, 0 );
+
+	for( size_t i = 0; i < n; ++i )
+		vRemainder[ i ] = ( vNU[ i ] >> iShift ) | ( iShift ? vNU[ i + 1 ] << ( LIMB_BITS - iShift ) : 0 );
+
+	trim( vQuotient );
+	trim( vRemainder );
+}
+
+/*********************************************************************\
+ *	Representations													 *
+\*********************************************************************/
+
+// Returns the sign and magnitude of the value, whatever its width.
+void ExactInteger::get_Magnitude( bool& bNegative, Limbs& vLimbs ) const
+{
+	vLimbs.clear( );
+
+	if( m_eWidth == WIDTH_BIG )
+	{
+		bNegative = m_bNegative;
+		vLimbs = m_vLimbs;
+		return;
+	}
+
+#if EXACT_HAS_INT128
+	ExactWide iValue = m_eWidth == WIDTH_WIDE ? m_iWide : (ExactWide) m_iSmall;
+	ExactUWide iMagnitude = iValue < 0 ? (ExactUWide) 0 - (ExactUWide) iValue : (ExactUWide) iValue;
+
+	bNegative = iValue < 0;
+#else
+	unsigned long long iMagnitude = m_iSmall < 0 ? 0ULL - (unsigned long long) m_iSmall : (unsigned long long) m_iSmall;
+
+	bNegative = m_iSmall < 0;
+#endif
+
+	while( iMagnitude != 0 )
+	{
+		vLimbs.push_back( (uint32_t) iMagnitude );
+		iMagnitude >>= LIMB_BITS;
+	}
+}
+
+// Takes a sign and magnitude, storing it in the narrowest width it fits.
+// vLimbs is left empty.
+void ExactInteger::set_Magnitude( bool bNegative, Limbs& vLimbs )
+{
+	trim( vLimbs );
+
+	if( vLimbs.size( ) <= 2 )
+	{
+		unsigned long long iMagnitude = 0;
+
+		for( size_t i = vLimbs.size( ); i-- > 0; )
+			iMagnitude = ( iMagnitude << LIMB_BITS ) | vLimbs[ i ];
+
+		if( iMagnitude <= (unsigned long long) LLONG_MAX || ( bNegative && iMagnitude == 1ULL << 63 ) )
+		{
+			m_eWidth = WIDTH_SMALL;
+			m_iSmall = bNegative ? (long long)( 0ULL - iMagnitude ) : (long long) iMagnitude;
+			m_vLimbs.clear( );
+			vLimbs.clear( );
+			return;
+		}
+	}
+
+#if EXACT_HAS_INT128
+	if( vLimbs.size( ) <= 4 )
+	{
+		ExactUWide iMagnitude = 0;
+		ExactUWide iLimit = (ExactUWide) 1 << 127;
+
+		for( size_t i = vLimbs.size( ); i-- > 0; )
+			iMagnitude = ( iMagnitude << LIMB_BITS ) | vLimbs[ i ];
+
+		if( iMagnitude < iLimit || ( bNegative && iMagnitude == iLimit ) )
+		{
+			m_eWidth = WIDTH_WIDE;
+			m_iWide = bNegative ? (ExactWide)( (ExactUWide) 0 - iMagnitude ) : (ExactWide) iMagnitude;
+			m_vLimbs.clear( );
+			vLimbs.clear( );
+			return;
+		}
+	}
+#endif
+
+	m_eWidth = WIDTH_BIG;
+	m_bNegative = bNegative;
+	m_vLimbs.swap( vLimbs );
+	vLimbs.clear( );
+}
+
+#if EXACT_HAS_INT128
+
+// Returns a small or wide value as 128 bits.
+ExactWide ExactInteger::get_Wide( ) const
+{
+	return m_eWidth == WIDTH_WIDE ? m_iWide : (ExactWide) m_iSmall;
+}
+
+// Stores a 128 bit result, narrowing it if it fits in 64 bits.
+void ExactInteger::set_Wide( ExactWide iValue )
+{
+	m_vLimbs.clear( );
+
+	if( iValue >= LLONG_MIN && iValue <= LLONG_MAX )
+	{
+		m_eWidth = WIDTH_SMALL;
+		m_iSmall = (long long) iValue;
+	}
+	else
+	{
+		m_eWidth = WIDTH_WIDE;
+		m_iWide = iValue;
+	}
+}
+
+#endif
+
+/*********************************************************************\
+ *	Slow Paths														 *
+\*********************************************************************/
+
+// Adds or subtracts once the 64 bit result has overflowed.
+void ExactInteger::add_Slow( const ExactInteger& oOther, bool bSubtract )
+{
+	bool bNegative = false;
+	bool bOtherNegative = false;
+	Limbs vLimbs;
+	Limbs vOther;
+
+#if EXACT_HAS_INT128
+	if( m_eWidth != WIDTH_BIG && oOther.m_eWidth != WIDTH_BIG )
+	{
+		ExactWide iResult = 0;
+		bool bOverflow = bSubtract ? __builtin_sub_overflow( get_Wide( ), oOther.get_Wide( ), &iResult )
+								   : __builtin_add_overflow( get_Wide( ), oOther.get_Wide( ), &iResult );
+
+		if( !bOverflow )
+		{
+			set_Wide( iResult );
+			return;
+		}
+	}
+#endif
+
+	get_Magnitude( bNegative, vLimbs );
+	oOther.get_Magnitude( bOtherNegative, vOther );
+	bOtherNegative ^= bSubtract && !vOther.empty( );
+
+	if( bNegative == bOtherNegative )
+		add_Magnitudes( vLimbs, vOther, vLimbs );
+	else if( compare_Magnitudes( vLimbs, vOther ) >= 0 )
+		subtract_Magnitudes( vLimbs, vOther, vLimbs );
+	else
+	{
+		subtract_Magnitudes( vOther, vLimbs, vLimbs );
+		bNegative = bOtherNegative;
+	}
+
+	set_Magnitude( bNegative && !vLimbs.empty( ), vLimbs );
+}
+
+// Multiplies once the 64 bit result has overflowed.
+void ExactInteger::multiply_Slow( const ExactInteger& oOther )
+{
+	bool bNegative = false;
+	bool bOtherNegative = false;
+	Limbs vLimbs;
+	Limbs vOther;
+
+#if EXACT_HAS_INT128
+	if( m_eWidth != WIDTH_BIG && oOther.m_eWidth != WIDTH_BIG )
+	{
+		ExactWide iResult = 0;
+
+		if( !__builtin_mul_overflow( get_Wide( ), oOther.get_Wide( ), &iResult ) )
+		{
+			set_Wide( iResult );
+			return;
+		}
+	}
+#endif
+
+	get_Magnitude( bNegative, vLimbs );
+	oOther.get_Magnitude( bOtherNegative, vOther );
+	multiply_Magnitudes( vLimbs, vOther, vLimbs );
+	set_Magnitude( bNegative != bOtherNegative && !vLimbs.empty( ), vLimbs );
+}
+
+// Divides when either side is wider than 64 bits, the divisor is zero or
+// the quotient overflows.
+eIntegerStatus ExactInteger::divide_Slow( const ExactInteger& oOther, eIntegerDivision eDivision )
+{
+	bool bNegative = false;
+	bool bOtherNegative = false;
+	Limbs vLimbs;
+	Limbs vOther;
+	Limbs vQuotient;
+	Limbs vRemainder;
+
+	if( oOther.is_Zero( ) )
+		return INTEGER_DIVIDE_BY_ZERO;
+
+#if EXACT_HAS_INT128
+	if( m_eWidth != WIDTH_BIG && oOther.m_eWidth != WIDTH_BIG &&
+		!( oOther.get_Wide( ) == -1 && get_Wide( ) == (ExactWide)( (ExactUWide) 1 << 127 ) ) )
+	{
+		ExactWide iQuotient = get_Wide( ) / oOther.get_Wide( );
+		ExactWide iRemainder = get_Wide( ) % oOther.get_Wide( );
+
+		if( iRemainder != 0 )
+		{
+			if( eDivision == INTEGER_DIVISION_EXACT )
+				return INTEGER_INEXACT;
+
+			if( eDivision == INTEGER_DIVISION_FLOOR && ( iRemainder < 0 ) != ( oOther.get_Wide( ) < 0 ) )
+				--iQuotient;
+		}
+
+		set_Wide( iQuotient );
+		return INTEGER_OK;
+	}
+#endif
+
+	get_Magnitude( bNegative, vLimbs );
+	oOther.get_Magnitude( bOtherNegative, vOther );
+	divide_Magnitudes( vLimbs, vOther, vQuotient, vRemainder );
+
+	if( !vRemainder.empty( ) )
+	{
+		if( eDivision == INTEGER_DIVISION_EXACT )
+			return INTEGER_INEXACT;
+
+		// A negative quotient rounds away from zero to get the floor.
+		if( eDivision == INTEGER_DIVISION_FLOOR && bNegative != bOtherNegative )
+		{
+			Limbs vOne( 1, 1 );
+
+			add_Magnitudes( vQuotient, vOne, vQuotient );
+		}
+	}
+
+	set_Magnitude( bNegative != bOtherNegative && !vQuotient.empty( ), vQuotient );
+	return INTEGER_OK;
+}
+
+/*********************************************************************\
+ *	Conversions														 *
+\*********************************************************************/
+
+// Flips the sign.
+void ExactInteger::negate( )
+{
+	ExactInteger oZero;
+
+	oZero.subtract( *this );
+	*this = oZero;
+}
+
+// Returns true if the value is zero.  Zero is always stored small.
+bool ExactInteger::is_Zero( ) const
+{
+	return m_eWidth == WIDTH_SMALL && m_iSmall == 0;
+}
+
+// Returns the nearest double, for printing in the double calculator's
+// format or handing the value to code that works in doubles.
+double ExactInteger::to_Double( ) const
+{
+	double dValue = 0.0;
+
+	if( m_eWidth == WIDTH_SMALL )
+		return (double) m_iSmall;
+
+#if EXACT_HAS_INT128
+	if( m_eWidth == WIDTH_WIDE )
+		return (double) m_iWide;
+#endif
+
+	for( size_t i = m_vLimbs.size( ); i-- > 0; )
+		dValue = dValue * (double) LIMB_BASE + m_vLimbs[ i ];
+
+	return m_bNegative ? -dValue : dValue;
+}
+
+// Returns the value in decimal.
+string ExactInteger::to_String( ) const
+{
+	char sChunk[ 24 ];
+	bool bNegative = false;
+	Limbs vLimbs;
+	vector< uint32_t > vChunks;
+	string sOut;
+
+	if( m_eWidth == WIDTH_SMALL )
+	{
+		snprintf( sChunk, sizeof( sChunk ), "%lld", m_iSmall );
+		return sChunk;
+	}
+
+	// Peel off nine digits at a time, least significant first.
+	get_Magnitude( bNegative, vLimbs );
+
+	while( !vLimbs.empty( ) )
+		vChunks.push_back( divide_Small( vLimbs, DECIMAL_CHUNK ) );
+
+	if( bNegative )
+		sOut.push_back( '-' );
+
+	snprintf( sChunk, sizeof( sChunk ), "%u", vChunks.back( ) );
+	sOut.append( sChunk );
+
+	for( size_t i = vChunks.size( ) - 1; i-- > 0; )
+	{
+		snprintf( sChunk, sizeof( sChunk ), "%09u", vChunks[ i ] );
+		sOut.append( sChunk );
+	}
+
+	return sOut;
+}
+
+// Reads a run of decimal digits, with no sign.  The caller has checked
+// every character is a digit.
+//	Parameters:
+//		sDigits : String - The digits.
+//		iLength : size_t - How many there are, at least one.
+//		oValue : ExactInteger - Where to put the value.
+//////////////////////////////////////////////////////////////////////
+void ExactInteger::parse_Decimal( const char* sDigits, size_t iLength, ExactInteger& oValue )
+{
+	Limbs vLimbs;
+	size_t iChunk = iLength % DECIMAL_CHUNK_DIGITS;
+
+	if( iLength <= SMALL_MAX_DIGITS )
+	{
+		long long iValue = 0;
+
+		for( size_t i = 0; i < iLength; ++i )
+			iValue = iValue * 10 + ( sDigits[ i ] - '0' );
+
+		oValue = ExactInteger( iValue );
+		return;
+	}
+
+	if( iChunk == 0 )
+		iChunk = DECIMAL_CHUNK_DIGITS;
+
+	for( size_t i = 0; i < iLength; iChunk = DECIMAL_CHUNK_DIGITS )
+	{
+		uint32_t iPart = 0;
+		uint32_t iScale = 1;
+
+		for( size_t j = 0; j < iChunk; ++j, ++i )
+		{
+			iPart = iPart * 10 + (uint32_t)( sDigits[ i ] - '0' );
+			iScale *= 10;
+		}
+
+		multiply_Add_Small( vLimbs, iScale, iPart );
+	}
+
+	oValue.set_Magnitude( false, vLimbs );
+}
+
+// Returns a description of a failed operation.
+const char* get_Integer_Error( eIntegerStatus eStatus )
+{
+	switch( eStatus )
+	{
+	case INTEGER_OK:				return "no error";
+	case INTEGER_DIVIDE_BY_ZERO:	return "division by zero";
+	case INTEGER_INEXACT:			return "division has a remainder";
+	default:						return "invalid operation";
+	}
+}
@@ -0,0 +1,248 @@
+#ifndef _EXACTINTEGER_H
+#define _EXACTINTEGER_H
+
+// Name: ExactInteger.h
+// Description: Exact integer value for the calculator's integer mode.
+//				A value normally lives in a plain 64 bit integer and each
+//				operation only checks the compiler's overflow flag.  A
+//				result that overflows is widened to 128 bits, and past that
+//				to an arbitrary precision magnitude; results are narrowed
+//				again as soon as they fit, so a value that briefly grows
+//				large goes back to the fast path.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#include <intrin.h>
+#endif
+
+/////////////
+// Defines //
+/////////////
+#if defined( __SIZEOF_INT128__ )
+#define EXACT_HAS_INT128 1
+typedef __int128 ExactWide;
+typedef unsigned __int128 ExactUWide;
+#else
+#define EXACT_HAS_INT128 0
+#endif
+
+// What '/' does with a quotient that isn't a whole number.
+enum eIntegerDivision
+{
+	INTEGER_DIVISION_TRUNCATE,		// Round toward zero, like C
+	INTEGER_DIVISION_FLOOR,			// Round toward negative infinity
+	INTEGER_DIVISION_EXACT			// Refuse, leaving the value as it was
+};
+
+// Outcome of an integer operation.
+enum eIntegerStatus
+{
+	INTEGER_OK,
+	INTEGER_DIVIDE_BY_ZERO,
+	INTEGER_INEXACT					// Remainder under INTEGER_DIVISION_EXACT
+};
+
+/****\
+ * Overflow Checks *
+\****/
+
+// Each returns true if the result didn't fit, leaving the wrapped result.
+inline bool exact_Add_Overflows( long long iLeft, long long iRight, long long& iResult )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+	return __builtin_add_overflow( iLeft, iRight, &iResult );
+#else
+	iResult = (long long)( (unsigned long long) iLeft + (unsigned long long) iRight );
+	return ( ( iLeft ^ iResult ) & ( iRight ^ iResult ) ) < 0;
+#endif
+}
+
+inline bool exact_Subtract_Overflows( long long iLeft, long long iRight, long long& iResult )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+	return __builtin_sub_overflow( iLeft, iRight, &iResult );
+#else
+	iResult = (long long)( (unsigned long long) iLeft - (unsigned long long) iRight );
+	return ( ( iLeft ^ iRight ) & ( iLeft ^ iResult ) ) < 0;
+#endif
+}
+
+inline bool exact_Multiply_Overflows( long long iLeft, long long iRight, long long& iResult )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+	return __builtin_mul_overflow( iLeft, iRight, &iResult );
+#elif defined( _M_X64 )
+	long long iHigh = 0;
+
+	iResult = _mul128( iLeft, iRight, &iHigh );
+	return iHigh != ( iResult >> 63 );
+#else
+	iResult = (long long)( (unsigned long long) iLeft * (unsigned long long) iRight );
+	return ( iLeft == -1 && iRight == LLONG_MIN ) || ( iRight == -1 && iLeft == LLONG_MIN ) ||
+		   ( iLeft != 0 && iResult / iLeft != iRight );
+#endif
+}
+
+///////////////////////////////
+// ExactInteger Declaration  //
+///////////////////////////////
+class ExactInteger
+{
+public:
+	ExactInteger( );
+	explicit ExactInteger( long long iValue );
+
+	// Arithmetic, in place.  Only divide can fail, and it leaves the value
+	// untouched when it does.
+	void add( const ExactInteger& oOther );
+	void subtract( const ExactInteger& oOther );
+	void multiply( const ExactInteger& oOther );
+	eIntegerStatus divide( const ExactInteger& oOther, eIntegerDivision eDivision );
+	void negate( );
+
+	bool is_Small( ) const;
+	long long get_Small( ) const;
+	bool is_Zero( ) const;
+	double to_Double( ) const;
+	std::string to_String( ) const;
+
+	static void parse_Decimal( const char* sDigits, size_t iLength, ExactInteger& oValue );
+
+private:
+	typedef std::vector< uint32_t > Limbs;
+
+	enum eWidth
+	{
+		WIDTH_SMALL,				// m_iSmall holds the value
+		WIDTH_WIDE,					// m_iWide holds the value
+		WIDTH_BIG					// m_bNegative and m_vLimbs hold the value
+	};
+
+	void add_Slow( const ExactInteger& oOther, bool bSubtract );
+	void multiply_Slow( const ExactInteger& oOther );
+	eIntegerStatus divide_Slow( const ExactInteger& oOther, eIntegerDivision eDivision );
+	void get_Magnitude( bool& bNegative, Limbs& vLimbs ) const;
+	void set_Magnitude( bool bNegative, Limbs& vLimbs );
+#if EXACT_HAS_INT128
+	ExactWide get_Wide( ) const;
+	void set_Wide( ExactWide iValue );
+#endif
+
+	eWidth m_eWidth;
+	long long m_iSmall;
+#if EXACT_HAS_INT128
+	ExactWide m_iWide;
+#endif
+	bool m_bNegative;
+	Limbs m_vLimbs;					// Least significant limb first, no leading zeros
+};
+
+/****\
+ * Fast Paths *
+\****/
+
+inline ExactInteger::ExactInteger( )
+{
+	m_eWidth = WIDTH_SMALL;
+	m_iSmall = 0;
+#if EXACT_HAS_INT128
+	m_iWide = 0;
+#endif
+	m_bNegative = false;
+}
+
+inline ExactInteger::ExactInteger( long long iValue )
+{
+	m_eWidth = WIDTH_SMALL;
+	m_iSmall = iValue;
+#if EXACT_HAS_INT128
+	m_iWide = 0;
+#endif
+	m_bNegative = false;
+}
+
+inline void ExactInteger::add( const ExactInteger& oOther )
+{
+	long long iResult = 0;
+
+	if( m_eWidth == WIDTH_SMALL && oOther.m_eWidth == WIDTH_SMALL &&
+		!exact_Add_Overflows( m_iSmall, oOther.m_iSmall, iResult ) )
+		m_iSmall = iResult;
+	else
+		add_Slow( oOther, false );
+}
+
+inline void ExactInteger::subtract( const ExactInteger& oOther )
+{
+	long long iResult = 0;
+
+	if( m_eWidth == WIDTH_SMALL && oOther.m_eWidth == WIDTH_SMALL &&
+		!exact_Subtract_Overflows( m_iSmall, oOther.m_iSmall, iResult ) )
+		m_iSmall = iResult;
+	else
+		add_Slow( oOther, true );
+}
+
+inline void ExactInteger::multiply( const ExactInteger& oOther )
+{
+	long long iResult = 0;
+
+	if( m_eWidth == WIDTH_SMALL && oOther.m_eWidth == WIDTH_SMALL &&
+		!exact_Multiply_Overflows( m_iSmall, oOther.m_iSmall, iResult ) )
+		m_iSmall = iResult;
+	else
+		multiply_Slow( oOther );
+}
+
+inline eIntegerStatus ExactInteger::divide( const ExactInteger& oOther, eIntegerDivision eDivision )
+{
+	long long iQuotient = 0;
+	long long iRemainder = 0;
+
+	// LLONG_MIN / -1 is the one quotient that overflows.
+	if( m_eWidth != WIDTH_SMALL || oOther.m_eWidth != WIDTH_SMALL || oOther.m_iSmall == 0 ||
+		( oOther.m_iSmall == -1 && m_iSmall == LLONG_MIN ) )
+		return divide_Slow( oOther, eDivision );
+
+	iQuotient = m_iSmall / oOther.m_iSmall;
+	iRemainder = m_iSmall % oOther.m_iSmall;
+
+	if( iRemainder != 0 )
+	{
+		if( eDivision == INTEGER_DIVISION_EXACT )
+			return INTEGER_INEXACT;
+
+		if( eDivision == INTEGER_DIVISION_FLOOR && ( iRemainder < 0 ) != ( oOther.m_iSmall < 0 ) )
+			--iQuotient;
+	}
+
+	m_iSmall = iQuotient;
+	return INTEGER_OK;
+}
+
+inline bool ExactInteger::is_Small( ) const
+{
+	return m_eWidth == WIDTH_SMALL;
+}
+
+inline long long ExactInteger::get_Small( ) const
+{
+	return m_iSmall;
+}
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+const char* get_Integer_Error( eIntegerStatus eStatus );
+
+#endif
@@ -0,0 +1,111 @@
+// Name: IntegerCalculator.cpp
+// Description: Integer mode calculator, see IntegerCalculator.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "IntegerCalculator.h"
+#include "../Metrics/Metrics.h"
+
+/*********************************************************************\
+ *	Constructor														 *
+\*********************************************************************/
+
+// Starts at zero with zero in memory.
+//	Parameters:
+//		eDivision : eIntegerDivision - What '/' does with a remainder.
+//////////////////////////////////////////////////////////////////////
+IntegerCalculator::IntegerCalculator( eIntegerDivision eDivision )
+{
+	m_eDivision = eDivision;
+}
+
+/*********************************************************************\
+ *	Public Use Functions											 *
+\*********************************************************************/
+
+// Applies an operator and operand to the working value.
+//	Parameters:
+//		cOperator : Char - The operation to perform.
+//		oValue : ExactInteger - The operand.
+//	Returns:
+//		INTEGER_OK, or why a division failed.  The working value is
+//		unchanged on failure.
+//////////////////////////////////////////////////////////////////////
+eIntegerStatus IntegerCalculator::process_Calculation( char cOperator, const ExactInteger& oValue )
+{
+	switch( cOperator )
+	{
+	case '+':
+		METRIC_COUNT_OPERATOR( METRIC_OP_ADD );
+		m_oValue.add( oValue );
+		break;
+	case '-':
+		METRIC_COUNT_OPERATOR( METRIC_OP_SUBTRACT );
+		m_oValue.subtract( oValue );
+		break;
+	case '*':
+		METRIC_COUNT_OPERATOR( METRIC_OP_MULTIPLY );
+		m_oValue.multiply( oValue );
+		break;
+	case '/':
+		METRIC_COUNT_OPERATOR( METRIC_OP_DIVIDE );
+		return m_oValue.divide( oValue, m_eDivision );
+	default:
+		METRIC_COUNT_OPERATOR( METRIC_OP_OTHER );
+		break;
+	}
+
+	return INTEGER_OK;
+}
+
+// Returns true if the operator is one this calculator performs.
+bool IntegerCalculator::isValidOperand( char cOperand ) const
+{
+	return cOperand == '+' || cOperand == '-' || cOperand == '*' || cOperand == '/';
+}
+
+/*********************************************************************\
+ *	Getters and Setters  											 *
+\*********************************************************************/
+
+// Returns what '/' does with a remainder.
+eIntegerDivision IntegerCalculator::get_Division( ) const
+{
+	return m_eDivision;
+}
+
+// Stores the working value into memory.
+void IntegerCalculator::store_Mem( )
+{
+	METRIC_COUNT_OPERATOR( METRIC_OP_STORE );
+	m_oMemory = m_oValue;
+}
+
+// Returns the value held in memory.
+const ExactInteger& IntegerCalculator::pull_Mem( ) const
+{
+	return m_oMemory;
+}
+
+// Resets the working value to zero.
+void IntegerCalculator::clear_Value( )
+{
+	METRIC_COUNT_OPERATOR( METRIC_OP_RESET );
+	m_oValue = ExactInteger( );
+}
+
+// Returns the working value.
+const ExactInteger& IntegerCalculator::read_Value( ) const
+{
+	return m_oValue;
+}
+
+// Replaces the working value.
+void IntegerCalculator::set_Value( const ExactInteger& oValue )
+{
+	METRIC_COUNT_OPERATOR( METRIC_OP_SET );
+	m_oValue = oValue;
+}
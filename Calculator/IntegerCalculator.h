@@ -0,0 +1,42 @@
+#ifndef _INTEGERCALCULATOR_H
+#define _INTEGERCALCULATOR_H
+
+// Name: IntegerCalculator.h
+// Description: Calculator for the integer mode.  Works like Calculator,
+//				but the working value and memory are exact integers, so
+//				long integer ledgers never drift.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "ExactInteger.h"
+
+////////////////////////////////////
+// IntegerCalculator Declaration  //
+////////////////////////////////////
+class IntegerCalculator
+{
+public:
+	explicit IntegerCalculator( eIntegerDivision eDivision = INTEGER_DIVISION_TRUNCATE );
+
+	// public use functions
+	eIntegerStatus process_Calculation( char cOperator, const ExactInteger& oValue );
+	bool isValidOperand( char cOperand ) const;
+
+	// Getters and setters
+	eIntegerDivision get_Division( ) const;
+	void store_Mem( );
+	const ExactInteger& pull_Mem( ) const;
+	void clear_Value( );
+	const ExactInteger& read_Value( ) const;
+	void set_Value( const ExactInteger& oValue );
+
+private:
+	ExactInteger m_oMemory;
+	ExactInteger m_oValue;
+	eIntegerDivision m_eDivision;
+};
+
+#endif
@@ -0,0 +1,73 @@
+// Name: LimbArena.cpp
+// Description: Block management for LimbArena, see LimbArena.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "LimbArena.h"
+#include <cstring>
+
+/*********************************************************************\
+ *	Constructor and Destructor										 *
+\*********************************************************************/
+
+LimbArena::LimbArena( )
+{
+	m_iBlock = 0;
+	m_iUsed = 0;
+}
+
+LimbArena::~LimbArena( )
+{
+	for( size_t i = 0; i < m_vBlocks.size( ); ++i )
+		delete[] m_vBlocks[ i ].pLimbs;
+}
+
+/*********************************************************************\
+ *	Public Use Functions											 *
+\*********************************************************************/
+
+// Allocates iLimbs limbs, all zero.
+uint32_t* LimbArena::allocate_Zeroed( size_t iLimbs )
+{
+	uint32_t* pLimbs = allocate( iLimbs );
+
+	memset( pLimbs, 0, iLimbs * sizeof( uint32_t ) );
+	return pLimbs;
+}
+
+// Moves on to the next block, adding one if the next is missing or too
+// small.  Blocks past the current one are free, since a mark can only
+// point at or before it.
+uint32_t* LimbArena::allocate_Slow( size_t iLimbs )
+{
+	size_t iNext = m_vBlocks.empty( ) ? 0 : m_iBlock + 1;
+
+	if( iNext >= m_vBlocks.size( ) || m_vBlocks[ iNext ].iCapacity < iLimbs )
+	{
+		size_t iCapacity = m_vBlocks.empty( ) ? LIMB_ARENA_BLOCK : m_vBlocks[ m_iBlock ].iCapacity * 2;
+		Block oBlock;
+
+		oBlock.iCapacity = iCapacity > iLimbs ? iCapacity : iLimbs;
+		oBlock.pLimbs = new uint32_t[ oBlock.iCapacity ];
+		m_vBlocks.insert( m_vBlocks.begin( ) + iNext, oBlock );
+	}
+
+	m_iBlock = iNext;
+	m_iUsed = iLimbs;
+	return m_vBlocks[ iNext ].pLimbs;
+}
+
+/*********************************************************************\
+ *	Functions														 *
+\*********************************************************************/
+
+// Returns this thread's arena, created on first use.
+LimbArena& get_Limb_Arena( )
+{
+	static thread_local LimbArena oArena;
+
+	return oArena;
+}
@@ -0,0 +1,117 @@
+#ifndef _LIMBARENA_H
+#define _LIMBARENA_H
+
+// Name: LimbArena.h
+// Description: Bump allocator for the scratch limb arrays of the decimal
+//				kernels.  Karatsuba, Toom-3 and Newton division allocate
+//				temporaries at every level of their recursion; taking them
+//				from an arena makes each allocation a pointer bump, and
+//				releasing a scope gives all of them back at once.  Blocks
+//				are kept after a release, so a calculation that has run
+//				once at a given size doesn't allocate again.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+#define LIMB_ARENA_BLOCK	65536		// Limbs in the first block
+
+///////////////////////////
+// LimbArena Declaration //
+///////////////////////////
+class LimbArena
+{
+public:
+	// A point to release back to.
+	struct Mark
+	{
+		size_t iBlock;
+		size_t iUsed;
+	};
+
+	LimbArena( );
+	~LimbArena( );
+
+	uint32_t* allocate( size_t iLimbs );
+	uint32_t* allocate_Zeroed( size_t iLimbs );
+	Mark get_Mark( ) const;
+	void release( const Mark& oMark );
+
+private:
+	LimbArena( const LimbArena& );
+	LimbArena& operator=( const LimbArena& );
+
+	uint32_t* allocate_Slow( size_t iLimbs );
+
+	struct Block
+	{
+		uint32_t* pLimbs;
+		size_t iCapacity;
+	};
+
+	std::vector< Block > m_vBlocks;
+	size_t m_iBlock;				// Block being allocated from
+	size_t m_iUsed;					// Limbs used in that block
+};
+
+// Releases everything allocated in its scope.
+class LimbScope
+{
+public:
+	explicit LimbScope( LimbArena& oArena ) : m_oArena( oArena ), m_oMark( oArena.get_Mark( ) ) {}
+	~LimbScope( ) { m_oArena.release( m_oMark ); }
+
+private:
+	LimbScope( const LimbScope& );
+	LimbScope& operator=( const LimbScope& );
+
+	LimbArena& m_oArena;
+	LimbArena::Mark m_oMark;
+};
+
+/****\
+ * Fast Paths *
+\****/
+
+inline uint32_t* LimbArena::allocate( size_t iLimbs )
+{
+	if( m_iBlock < m_vBlocks.size( ) && m_vBlocks[ m_iBlock ].iCapacity - m_iUsed >= iLimbs )
+	{
+		uint32_t* pLimbs = m_vBlocks[ m_iBlock ].pLimbs + m_iUsed;
+
+		m_iUsed += iLimbs;
+		return pLimbs;
+	}
+
+	return allocate_Slow( iLimbs );
+}
+
+inline LimbArena::Mark LimbArena::get_Mark( ) const
+{
+	Mark oMark = { m_iBlock, m_iUsed };
+
+	return oMark;
+}
+
+inline void LimbArena::release( const Mark& oMark )
+{
+	m_iBlock = oMark.iBlock;
+	m_iUsed = oMark.iUsed;
+}
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+
+// Returns this thread's arena.
+LimbArena& get_Limb_Arena( );
+
+#endif
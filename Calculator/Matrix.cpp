@@ -0,0 +1,215 @@
+// Name: Matrix.cpp
+// Description: Matrix values for the matrix mode, see Matrix.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "Matrix.h"
+#include "OperatorRegistry.h"
+#include <cstdio>
+#include <new>
+
+/*********************************************************************\
+ *	Constructors													 *
+\*********************************************************************/
+
+// Starts as the scalar 0, like a new Calculator.
+Matrix::Matrix( )
+	: m_iRows( 1 ), m_iColumns( 1 ), m_vValues( 1, 0.0 )
+{
+}
+
+// A 1x1 matrix holding dValue.
+Matrix::Matrix( double dValue )
+	: m_iRows( 1 ), m_iColumns( 1 ), m_vValues( 1, dValue )
+{
+}
+
+/*********************************************************************\
+ *	Shape and Elements												 *
+\*********************************************************************/
+
+// Gives the matrix a new shape.  Elements are left in row-major order
+// as they were, and any new ones are zero.
+//	Returns:
+//		MATRIX_TOO_LARGE if the shape has more than MATRIX_MAX_ELEMENTS
+//		elements or can't be allocated; the matrix is unchanged.
+//////////////////////////////////////////////////////////////////////
+eMatrixStatus Matrix::resize( size_t iRows, size_t iColumns )
+{
+	if( iColumns != 0 && (unsigned long long) iRows > MATRIX_MAX_ELEMENTS / iColumns )
+		return MATRIX_TOO_LARGE;
+
+	try
+	{
+		m_vValues.resize( iRows * iColumns );
+	}
+	catch( const std::bad_alloc& )
+	{
+		return MATRIX_TOO_LARGE;
+	}
+
+	m_iRows = iRows;
+	m_iColumns = iColumns;
+	return MATRIX_OK;
+}
+
+size_t Matrix::get_Rows( ) const
+{
+	return m_iRows;
+}
+
+size_t Matrix::get_Columns( ) const
+{
+	return m_iColumns;
+}
+
+// Returns the number of elements.
+size_t Matrix::size( ) const
+{
+	return m_vValues.size( );
+}
+
+// Returns true for a 1x1 matrix, which broadcasts like a number.
+bool Matrix::is_Scalar( ) const
+{
+	return m_iRows == 1 && m_iColumns == 1;
+}
+
+// Returns the elements, row-major.
+double* Matrix::data( )
+{
+	return m_vValues.data( );
+}
+
+const double* Matrix::data( ) const
+{
+	return m_vValues.data( );
+}
+
+double Matrix::at( size_t iRow, size_t iColumn ) const
+{
+	return m_vValues[ iRow * m_iColumns + iColumn ];
+}
+
+/*********************************************************************\
+ *	Element-wise Arithmetic											 *
+\*********************************************************************/
+
+// Applies an operator element by element, with the operator's own scalar
+// kernel, so every element gets the bits Calculator would give it.  Either
+// side may be a scalar, which is used against every element of the other;
+// otherwise the shapes must match.  Unary operators ignore the operand.
+//	Parameters:
+//		cOperator : Char - One of the calculator's operators.
+//		oOperand : Matrix - The right hand side.
+//	Returns:
+//		MATRIX_SHAPE_MISMATCH if the shapes can't be combined, leaving the
+//		matrix unchanged.  Unknown operators are ignored, as they are by
+//		Calculator.
+//////////////////////////////////////////////////////////////////////
+eMatrixStatus Matrix::apply( char cOperator, const Matrix& oOperand )
+{
+	const bool bUnary = get_Operator( cOperator ).iArity == 1;
+
+	if( !is_Operator( cOperator ) )
+		return MATRIX_OK;
+
+	if( !bUnary && !is_Scalar( ) && !oOperand.is_Scalar( ) &&
+		( m_iRows != oOperand.m_iRows || m_iColumns != oOperand.m_iColumns ) )
+		return MATRIX_SHAPE_MISMATCH;
+
+	// A scalar working value takes the shape of the operand.
+	if( !bUnary && is_Scalar( ) && !oOperand.is_Scalar( ) )
+	{
+		const double dValue = m_vValues[ 0 ];
+
+		m_vValues.resize( oOperand.size( ) );
+		m_iRows = oOperand.m_iRows;
+		m_iColumns = oOperand.m_iColumns;
+
+		dispatch_Operator( cOperator, [&]( auto oOperator )
+		{
+			const double* pOperands = oOperand.data( );
+
+			for( size_t i = 0; i < m_vValues.size( ); ++i )
+				m_vValues[ i ] = decltype( oOperator )::apply( dValue, pOperands[ i ] );
+		} );
+
+		return MATRIX_OK;
+	}
+
+	dispatch_Operator( cOperator, [&]( auto oOperator )
+	{
+		double* pValues = m_vValues.data( );
+		const size_t iCount = m_vValues.size( );
+
+		if( bUnary || oOperand.is_Scalar( ) )
+		{
+			const double dOperand = oOperand.m_vValues[ 0 ];
+
+			for( size_t i = 0; i < iCount; ++i )
+				pValues[ i ] = decltype( oOperator )::apply( pValues[ i ], dOperand );
+		}
+		else
+		{
+			const double* pOperands = oOperand.data( );
+
+			for( size_t i = 0; i < iCount; ++i )
+				pValues[ i ] = decltype( oOperator )::apply( pValues[ i ], pOperands[ i ] );
+		}
+	} );
+
+	return MATRIX_OK;
+}
+
+/*********************************************************************\
+ *	Text															 *
+\*********************************************************************/
+
+// Appends a row, its values separated by spaces and written with enough
+// digits to read back the same doubles.  No newline is added.
+void Matrix::append_Row( std::string& sText, size_t iRow ) const
+{
+	char sValue[ 32 ];
+
+	for( size_t i = 0; i < m_iColumns; ++i )
+	{
+		int iLength = snprintf( sValue, sizeof( sValue ), "%.17g", m_vValues[ iRow * m_iColumns + i ] );
+
+		if( i > 0 )
+			sText += ' ';
+
+		if( iLength > 0 )
+			sText.append( sValue, (size_t) iLength );
+	}
+}
+
+/*********************************************************************\
+ *	Functions														 *
+\*********************************************************************/
+
+// Returns a description of a failed operation.
+const char* get_Matrix_Error( eMatrixStatus eStatus )
+{
+	switch( eStatus )
+	{
+	case MATRIX_SHAPE_MISMATCH:
+		return "matrix shapes don't match";
+	case MATRIX_TOO_LARGE:
+		return "matrix too large";
+	case MATRIX_FILE_UNREADABLE:
+		return "unable to read the matrix file";
+	case MATRIX_FILE_UNWRITABLE:
+		return "unable to write the matrix file";
+	case MATRIX_FILE_MALFORMED:
+		return "not a matrix file";
+	case MATRIX_FILE_RAGGED:
+		return "matrix file rows have different lengths";
+	case MATRIX_OK:
+	default:
+		return "no error";
+	}
+}
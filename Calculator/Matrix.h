@@ -0,0 +1,76 @@
+#ifndef _MATRIX_H
+#define _MATRIX_H
+
+// Name: Matrix.h
+// Description: Matrix value for the calculator's matrix mode.  A matrix is
+//				a number of rows and columns and its doubles, row-major.
+//				A 1x1 matrix is a scalar and broadcasts against any shape
+//				in element-wise operations, so the mode starts at 0 like
+//				Calculator and "* 2" doubles every element.
+//
+//				Products are MatrixMultiplier's; files are read and
+//				written by MatrixFile.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+#define MATRIX_MAX_ELEMENTS		( 1ULL << 32 )		// 32 GiB of doubles
+
+// Why a matrix operation failed.
+enum eMatrixStatus
+{
+	MATRIX_OK,
+	MATRIX_SHAPE_MISMATCH,		// Shapes can't be combined by the operator
+	MATRIX_TOO_LARGE,			// More than MATRIX_MAX_ELEMENTS elements
+	MATRIX_FILE_UNREADABLE,		// Couldn't open or read the file
+	MATRIX_FILE_UNWRITABLE,		// Couldn't create or write the file
+	MATRIX_FILE_MALFORMED,		// Not a matrix in either format
+	MATRIX_FILE_RAGGED			// CSV rows of different lengths
+};
+
+/////////////////////////
+// Matrix Declaration  //
+/////////////////////////
+class Matrix
+{
+public:
+	Matrix( );
+	explicit Matrix( double dValue );
+
+	// Shape and elements
+	eMatrixStatus resize( size_t iRows, size_t iColumns );
+	size_t get_Rows( ) const;
+	size_t get_Columns( ) const;
+	size_t size( ) const;
+	bool is_Scalar( ) const;
+	double* data( );
+	const double* data( ) const;
+	double at( size_t iRow, size_t iColumn ) const;
+
+	// Element-wise arithmetic
+	eMatrixStatus apply( char cOperator, const Matrix& oOperand );
+
+	// Text
+	void append_Row( std::string& sText, size_t iRow ) const;
+
+private:
+	size_t m_iRows;
+	size_t m_iColumns;
+	std::vector< double > m_vValues;
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+const char* get_Matrix_Error( eMatrixStatus eStatus );
+
+#endif
@@ -0,0 +1,110 @@
+// Name: MatrixCalculator.cpp
+// Description: Matrix mode calculator, see MatrixCalculator.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "MatrixCalculator.h"
+#include "OperatorRegistry.h"
+#include "../Metrics/Metrics.h"
+#include <utility>
+
+/*********************************************************************\
+ *	Constructor														 *
+\*********************************************************************/
+
+// Starts at the scalar 0 with 0 in memory.
+//	Parameters:
+//		iThreadCount : unsigned int - Workers for large products, 0 for one
+//									  per core.
+//////////////////////////////////////////////////////////////////////
+MatrixCalculator::MatrixCalculator( unsigned int iThreadCount )
+	: m_oMultiplier( iThreadCount )
+{
+}
+
+/*********************************************************************\
+ *	Public Use Functions											 *
+\*********************************************************************/
+
+// Applies an operator and operand to the working value: the calculator's
+// operators element by element, MATRIX_PRODUCT as a matrix product.
+//	Parameters:
+//		cOperator : Char - The operation to perform.
+//		oValue : Matrix - The operand.
+//	Returns:
+//		MATRIX_OK, or why the shapes didn't fit.  The working value is
+//		unchanged on failure.
+//////////////////////////////////////////////////////////////////////
+eMatrixStatus MatrixCalculator::process_Calculation( char cOperator, const Matrix& oValue )
+{
+	eMatrixStatus eStatus = MATRIX_OK;
+
+	if( cOperator != MATRIX_PRODUCT )
+	{
+		const unsigned char iIndex = get_Operator( cOperator ).iIndex;
+
+		METRIC_COUNT_OPERATOR( is_Operator( cOperator ) && iIndex <= METRIC_OP_DIVIDE ? (MetricOperator) iIndex : METRIC_OP_OTHER );
+		return m_oValue.apply( cOperator, oValue );
+	}
+
+	METRIC_COUNT_OPERATOR( METRIC_OP_OTHER );
+
+	if( m_oValue.get_Columns( ) != oValue.get_Rows( ) )
+		return MATRIX_SHAPE_MISMATCH;
+
+	eStatus = m_oProduct.resize( m_oValue.get_Rows( ), oValue.get_Columns( ) );
+
+	if( eStatus != MATRIX_OK )
+		return eStatus;
+
+	m_oMultiplier.multiply( m_oValue.data( ), oValue.data( ), m_oProduct.data( ),
+							m_oValue.get_Rows( ), oValue.get_Columns( ), m_oValue.get_Columns( ) );
+	std::swap( m_oValue, m_oProduct );
+	return MATRIX_OK;
+}
+
+// Returns true if the operator is one this calculator performs.
+bool MatrixCalculator::isValidOperand( char cOperand ) const
+{
+	return cOperand == MATRIX_PRODUCT || get_Operator( cOperand ).iArity == 2;
+}
+
+/*********************************************************************\
+ *	Getters and Setters  											 *
+\*********************************************************************/
+
+// Stores the working value into memory.
+void MatrixCalculator::store_Mem( )
+{
+	METRIC_COUNT_OPERATOR( METRIC_OP_STORE );
+	m_oMemory = m_oValue;
+}
+
+// Returns the matrix held in memory.
+const Matrix& MatrixCalculator::pull_Mem( ) const
+{
+	return m_oMemory;
+}
+
+// Resets the working value to the scalar 0.
+void MatrixCalculator::clear_Value( )
+{
+	METRIC_COUNT_OPERATOR( METRIC_OP_RESET );
+	m_oValue = Matrix( );
+}
+
+// Returns the working value.
+const Matrix& MatrixCalculator::read_Value( ) const
+{
+	return m_oValue;
+}
+
+// Replaces the working value.
+void MatrixCalculator::set_Value( const Matrix& oValue )
+{
+	METRIC_COUNT_OPERATOR( METRIC_OP_SET );
+	m_oValue = oValue;
+}
@@ -0,0 +1,53 @@
+#ifndef _MATRIXCALCULATOR_H
+#define _MATRIXCALCULATOR_H
+
+// Name: MatrixCalculator.h
+// Description: Calculator for the matrix mode.  Works like Calculator,
+//				but the working value and memory are matrices.  The
+//				calculator's operators work element by element, and
+//				MATRIX_PRODUCT multiplies the working value by the operand
+//				as matrices, with MatrixMultiplier.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "Matrix.h"
+#include "../Engine/MatrixMultiplier.h"
+
+/////////////
+// Defines //
+/////////////
+#define MATRIX_PRODUCT '@'		// Matrix product, working value on the left
+
+///////////////////////////////////
+// MatrixCalculator Declaration  //
+///////////////////////////////////
+class MatrixCalculator
+{
+public:
+	explicit MatrixCalculator( unsigned int iThreadCount = 1 );
+
+	// public use functions
+	eMatrixStatus process_Calculation( char cOperator, const Matrix& oValue );
+	bool isValidOperand( char cOperand ) const;
+
+	// Getters and setters
+	void store_Mem( );
+	const Matrix& pull_Mem( ) const;
+	void clear_Value( );
+	const Matrix& read_Value( ) const;
+	void set_Value( const Matrix& oValue );
+
+private:
+	MatrixCalculator( const MatrixCalculator& );
+	MatrixCalculator& operator=( const MatrixCalculator& );
+
+	Matrix m_oMemory;
+	Matrix m_oValue;
+	Matrix m_oProduct;					// Products are built here, then swapped in
+	MatrixMultiplier m_oMultiplier;
+};
+
+#endif
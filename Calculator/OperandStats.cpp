@@ -0,0 +1,661 @@
+// Name: OperandStats.cpp
+// Description: Single pass statistics over a calculator's operands, see
+//				OperandStats.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "OperandStats.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <new>
+
+/////////////
+// Defines //
+/////////////
+#define DIGIT_MASK		0xffffffffULL
+#define FRACTION_MASK	( ( 1ULL << 52 ) - 1 )
+#define HIDDEN_BIT		( 1ULL << 52 )
+#define BUCKET_SHIFT	45						// 52 fraction bits less the 7 kept per page
+#define STATS_LANES		4						// Independent min and max accumulators
+#define STATS_VARIANCE_DIGITS	( 2 * STATS_SUM_DIGITS + 2 )
+
+static_assert( STATS_BUCKET_SLOTS == 1 << ( 52 - BUCKET_SHIFT ), "a page holds the bits below the exponent" );
+static_assert( STATS_VARIANCE_DIGITS >= STATS_SQUARE_DIGITS + 2, "n * squares must fit" );
+
+/*********************************************************************\
+ *	Fixed-point Digits												 *
+\*********************************************************************/
+
+// Adds or subtracts a 64 bit integer shifted left by iPosition bits.  It
+// lands on three digits, each growing by less than 2^33.
+static inline void deposit( int64_t* pDigits, uint64_t iValue, unsigned int iPosition, int64_t iSign )
+{
+	int64_t* pDigit = pDigits + ( iPosition >> 5 );
+	const unsigned int iShift = iPosition & 31;
+	const uint64_t iLow = ( iValue & DIGIT_MASK ) << iShift;
+	const uint64_t iHigh = ( iValue >> 32 ) << iShift;
+
+	pDigit[ 0 ] += iSign * (int64_t)( iLow & DIGIT_MASK );
+	pDigit[ 1 ] += iSign * (int64_t)( ( iLow >> 32 ) + ( iHigh & DIGIT_MASK ) );
+	pDigit[ 2 ] += iSign * (int64_t)( iHigh >> 32 );
+}
+
+// Adds a signed chunk to the digits at iPosition.
+static inline void deposit_Chunk( int64_t* pDigits, int64_t iChunk, unsigned int iPosition )
+{
+	if( iChunk > 0 )
+		deposit( pDigits, (uint64_t) iChunk, iPosition, 1 );
+	else if( iChunk < 0 )
+		deposit( pDigits, (uint64_t) -iChunk, iPosition, -1 );
+}
+
+// Carries every digit into the next, leaving all but the top one in
+// [0, 2^32).  The top digit keeps the sign.
+static void normalize_Digits( int64_t* pDigits, size_t iCount )
+{
+	for( size_t i = 0; i + 1 < iCount; ++i )
+	{
+		pDigits[ i + 1 ] += pDigits[ i ] >> 32;
+		pDigits[ i ] &= (int64_t) DIGIT_MASK;
+	}
+}
+
+// Makes the digits hold the magnitude of their integer.
+//	Returns:
+//		True if the integer was negative.
+static bool take_Magnitude( int64_t* pDigits, size_t iCount )
+{
+	normalize_Digits( pDigits, iCount );
+
+	if( pDigits[ iCount - 1 ] >= 0 )
+		return false;
+
+	for( size_t i = 0; i < iCount; ++i )
+		pDigits[ i ] = -pDigits[ i ];
+
+	normalize_Digits( pDigits, iCount );
+	return true;
+}
+
+// Rounds the integer held in a digit array to 53 significant bits, to
+// nearest with ties to even.  The array is left holding its magnitude.
+//	Parameters:
+//		pDigits : int64_t* - Digits, least significant first.
+//		iCount : size_t - Number of digits.
+//		iExponent : int - Set so the result times 2^iExponent is the
+//						  rounded integer.
+//	Returns:
+//		The rounded integer's leading bits, an integer below 2^53.
+//////////////////////////////////////////////////////////////////////
+static double round_Digits( int64_t* pDigits, size_t iCount, int& iExponent )
+{
+	const bool bNegative = take_Magnitude( pDigits, iCount );
+	size_t iTop = iCount;
+	unsigned int iZeros = 0;
+	uint64_t iMantissa = 0;
+	uint64_t iRest = 0;
+	bool bSticky = false;
+
+	iExponent = 0;
+
+	while( iTop > 0 && pDigits[ iTop - 1 ] == 0 )
+		--iTop;
+
+	if( iTop-- == 0 )
+		return 0.0;
+
+	// The leading 64 bits, from the top digit and the two below it.
+	const uint64_t iHigh = (uint64_t) pDigits[ iTop ];
+	const uint64_t iMiddle = iTop >= 1 ? (uint64_t) pDigits[ iTop - 1 ] : 0;
+	const uint64_t iLow = iTop >= 2 ? (uint64_t) pDigits[ iTop - 2 ] : 0;
+
+	while( ( ( iHigh << iZeros ) & 0x80000000ULL ) == 0 )
+		++iZeros;
+
+	const uint64_t iLeading = ( iHigh << ( 32 + iZeros ) ) | ( iMiddle << iZeros ) | ( iLow >> ( 32 - iZeros ) );
+
+	bSticky = ( iLow & ( ( 1ULL << ( 32 - iZeros ) ) - 1 ) ) != 0;
+
+	for( size_t i = 0; i + 2 < iTop && !bSticky; ++i )
+		bSticky = pDigits[ i ] != 0;
+
+	iMantissa = iLeading >> 11;
+	iRest = iLeading & 0x7ff;
+
+	if( iRest > 0x400 || ( iRest == 0x400 && ( bSticky || ( iMantissa & 1 ) != 0 ) ) )
+		++iMantissa;
+
+	iExponent = (int)( 32 * iTop + 32 - iZeros ) - 53;
+
+	if( iMantissa == ( 1ULL << 53 ) )
+	{
+		iMantissa >>= 1;
+		++iExponent;
+	}
+
+	return bNegative ? -(double) iMantissa : (double) iMantissa;
+}
+
+/*********************************************************************\
+ *	Constructor/Destructor											 *
+\*********************************************************************/
+
+// Starts with no operands.
+OperandStats::OperandStats( )
+{
+	clear( );
+}
+
+OperandStats::~OperandStats( )
+{
+	// Empty
+}
+
+/*********************************************************************\
+ *	Accumulation													 *
+\*********************************************************************/
+
+// Adds one operand.
+void OperandStats::add( double dValue )
+{
+	uint64_t iBits = 0;
+	unsigned int iExponent = 0;
+
+	memcpy( &iBits, &dValue, sizeof( iBits ) );
+	iExponent = (unsigned int)( iBits >> 52 ) & 0x7ff;
+	++m_iCount;
+
+	if( iExponent == 0x7ff )
+	{
+		add_Special( iBits );
+		return;
+	}
+
+	if( dValue < m_dMin )
+		m_dMin = dValue;
+
+	if( dValue > m_dMax )
+		m_dMax = dValue;
+
+	add_Finite( iBits, iExponent );
+}
+
+// Adds a block of operands, the same as adding them one at a time.  The
+// min and max are kept in STATS_LANES independent lanes, which the
+// compiler turns into vector min and max instructions; NaNs fail both
+// comparisons and drop out.
+//	Parameters:
+//		pValues : double* - The operands.
+//		iCount : size_t - Number of operands.
+//////////////////////////////////////////////////////////////////////
+void OperandStats::add_Values( const double* pValues, size_t iCount )
+{
+	double aMin[ STATS_LANES ];
+	double aMax[ STATS_LANES ];
+	size_t i = 0;
+
+	for( size_t j = 0; j < STATS_LANES; ++j )
+	{
+		aMin[ j ] = m_dMin;
+		aMax[ j ] = m_dMax;
+	}
+
+	for( ; i + STATS_LANES <= iCount; i += STATS_LANES )
+	{
+		for( size_t j = 0; j < STATS_LANES; ++j )
+		{
+			aMin[ j ] = pValues[ i + j ] < aMin[ j ] ? pValues[ i + j ] : aMin[ j ];
+			aMax[ j ] = pValues[ i + j ] > aMax[ j ] ? pValues[ i + j ] : aMax[ j ];
+		}
+	}
+
+	for( ; i < iCount; ++i )
+	{
+		aMin[ 0 ] = pValues[ i ] < aMin[ 0 ] ? pValues[ i ] : aMin[ 0 ];
+		aMax[ 0 ] = pValues[ i ] > aMax[ 0 ] ? pValues[ i ] : aMax[ 0 ];
+	}
+
+	for( size_t j = 0; j < STATS_LANES; ++j )
+	{
+		if( aMin[ j ] < m_dMin )
+			m_dMin = aMin[ j ];
+
+		if( aMax[ j ] > m_dMax )
+			m_dMax = aMax[ j ];
+	}
+
+	for( i = 0; i < iCount; ++i )
+	{
+		uint64_t iBits = 0;
+		unsigned int iExponent = 0;
+
+		memcpy( &iBits, pValues + i, sizeof( iBits ) );
+		iExponent = (unsigned int)( iBits >> 52 ) & 0x7ff;
+
+		if( iExponent == 0x7ff )
+		{
+			add_Special( iBits );
+			continue;
+		}
+
+		add_Finite( iBits, iExponent );
+	}
+
+	m_iCount += iCount;
+}
+
+// Adds the operands another accumulator has seen.  Merging is exact, so
+// the order accumulators are merged in doesn't matter.
+void OperandStats::merge( const OperandStats& oOther )
+{
+	fold( );
+	oOther.fold_Into( m_aSum, m_aSquares );
+
+	for( size_t i = 0; i < STATS_SUM_DIGITS; ++i )
+		m_aSum[ i ] += oOther.m_aSum[ i ];
+
+	for( size_t i = 0; i < STATS_SQUARE_DIGITS; ++i )
+		m_aSquares[ i ] += oOther.m_aSquares[ i ];
+
+	normalize_Digits( m_aSum, STATS_SUM_DIGITS );
+	normalize_Digits( m_aSquares, STATS_SQUARE_DIGITS );
+
+	m_iCount += oOther.m_iCount;
+	m_iNaNs += oOther.m_iNaNs;
+	m_iPositiveInfinities += oOther.m_iPositiveInfinities;
+	m_iNegativeInfinities += oOther.m_iNegativeInfinities;
+	m_bBucketsLost = m_bBucketsLost || oOther.m_bBucketsLost;
+
+	if( oOther.m_dMin < m_dMin )
+		m_dMin = oOther.m_dMin;
+
+	if( oOther.m_dMax > m_dMax )
+		m_dMax = oOther.m_dMax;
+
+	for( size_t i = 0; i < STATS_BUCKET_PAGES && !m_bBucketsLost; ++i )
+	{
+		const unsigned long long* pOther = oOther.m_apBuckets[ i ].get( );
+
+		if( pOther == NULL )
+			continue;
+
+		if( !m_apBuckets[ i ] )
+		{
+			m_apBuckets[ i ].reset( new( std::nothrow ) unsigned long long[ STATS_BUCKET_SLOTS ]( ) );
+
+			if( !m_apBuckets[ i ] )
+			{
+				m_bBucketsLost = true;
+				break;
+			}
+		}
+
+		for( size_t j = 0; j < STATS_BUCKET_SLOTS; ++j )
+			m_apBuckets[ i ][ j ] += pOther[ j ];
+	}
+}
+
+// Forgets every operand.
+void OperandStats::clear( )
+{
+	memset( m_aSum, 0, sizeof( m_aSum ) );
+	memset( m_aSquares, 0, sizeof( m_aSquares ) );
+	memset( m_aSumChunks, 0, sizeof( m_aSumChunks ) );
+	memset( m_aSquareChunks, 0, sizeof( m_aSquareChunks ) );
+	m_iLowChunk = STATS_SUM_CHUNKS;
+	m_iHighChunk = 0;
+	m_iCount = 0;
+	m_iNaNs = 0;
+	m_iPositiveInfinities = 0;
+	m_iNegativeInfinities = 0;
+	m_iPending = 0;
+	m_dMin = HUGE_VAL;
+	m_dMax = -HUGE_VAL;
+	m_bBucketsLost = false;
+
+	for( size_t i = 0; i < STATS_BUCKET_PAGES; ++i )
+		m_apBuckets[ i ].reset( );
+}
+
+/*********************************************************************\
+ *	Statistics														 *
+\*********************************************************************/
+
+// Returns the number of operands, NaNs included.
+unsigned long long OperandStats::get_Count( ) const
+{
+	return m_iCount;
+}
+
+// Returns the sum of the operands, correctly rounded.
+double OperandStats::get_Sum( ) const
+{
+	int64_t aDigits[ STATS_SUM_DIGITS ];
+	int iExponent = 0;
+	double dSum = 0.0;
+
+	if( has_Special( ) )
+		return get_Special_Sum( );
+
+	memcpy( aDigits, m_aSum, sizeof( aDigits ) );
+	fold_Into( aDigits, NULL );
+	dSum = round_Digits( aDigits, STATS_SUM_DIGITS, iExponent );
+	return ldexp( dSum, iExponent - 1074 );
+}
+
+// Returns the mean of the operands, NaN if there are none.
+double OperandStats::get_Mean( ) const
+{
+	int64_t aDigits[ STATS_SUM_DIGITS ];
+	int iExponent = 0;
+	double dSum = 0.0;
+
+	if( m_iCount == 0 )
+		return std::numeric_limits< double >::quiet_NaN( );
+
+	if( has_Special( ) )
+		return get_Special_Sum( );
+
+	memcpy( aDigits, m_aSum, sizeof( aDigits ) );
+	fold_Into( aDigits, NULL );
+	dSum = round_Digits( aDigits, STATS_SUM_DIGITS, iExponent );
+	return ldexp( dSum / (double) m_iCount, iExponent - 1074 );
+}
+
+// Returns the sample variance, ( n * sum( x^2 ) - sum( x )^2 ) / ( n ( n - 1 ) ).
+// The numerator is worked out exactly from the digits, so there is no
+// cancellation however large the mean is next to the spread.
+//	Returns:
+//		The variance, NaN for fewer than two operands or any that isn't
+//		finite.
+//////////////////////////////////////////////////////////////////////
+double OperandStats::get_Variance( ) const
+{
+	int64_t aSum[ STATS_SUM_DIGITS ];
+	int64_t aSquares[ STATS_SQUARE_DIGITS ];
+	int64_t aDifference[ STATS_VARIANCE_DIGITS ];
+	const uint64_t iCount = m_iCount;
+	int iExponent = 0;
+	double dDifference = 0.0;
+
+	if( iCount < 2 || has_Special( ) )
+		return std::numeric_limits< double >::quiet_NaN( );
+
+	memcpy( aSum, m_aSum, sizeof( aSum ) );
+	memcpy( aSquares, m_aSquares, sizeof( aSquares ) );
+	memset( aDifference, 0, sizeof( aDifference ) );
+	fold_Into( aSum, aSquares );
+	take_Magnitude( aSum, STATS_SUM_DIGITS );
+	normalize_Digits( aSquares, STATS_SQUARE_DIGITS );
+
+	// n * sum( x^2 ), both are at most 2^32 per digit.
+	for( size_t i = 0; i < STATS_SQUARE_DIGITS; ++i )
+	{
+		const uint64_t iLow = (uint64_t) aSquares[ i ] * ( iCount & DIGIT_MASK );
+		const uint64_t iHigh = (uint64_t) aSquares[ i ] * ( iCount >> 32 );
+
+		aDifference[ i ] += (int64_t)( iLow & DIGIT_MASK );
+		aDifference[ i + 1 ] += (int64_t)( ( iLow >> 32 ) + ( iHigh & DIGIT_MASK ) );
+		aDifference[ i + 2 ] += (int64_t)( iHigh >> 32 );
+	}
+
+	// - sum( x )^2
+	for( size_t i = 0; i < STATS_SUM_DIGITS; ++i )
+	{
+		if( aSum[ i ] == 0 )
+			continue;
+
+		for( size_t j = 0; j < STATS_SUM_DIGITS; ++j )
+		{
+			const uint64_t iProduct = (uint64_t) aSum[ i ] * (uint64_t) aSum[ j ];
+
+			aDifference[ i + j ] -= (int64_t)( iProduct & DIGIT_MASK );
+			aDifference[ i + j + 1 ] -= (int64_t)( iProduct >> 32 );
+		}
+	}
+
+	dDifference = round_Digits( aDifference, STATS_VARIANCE_DIGITS, iExponent );
+	return ldexp( dDifference / (double) iCount / (double)( iCount - 1 ), iExponent - 2148 );
+}
+
+// Returns the smallest operand, NaN if there are none but NaNs.
+double OperandStats::get_Min( ) const
+{
+	if( m_iCount == m_iNaNs )
+		return std::numeric_limits< double >::quiet_NaN( );
+
+	return m_dMin == 0.0 ? 0.0 : m_dMin;
+}
+
+// Returns the largest operand, NaN if there are none but NaNs.
+double OperandStats::get_Max( ) const
+{
+	if( m_iCount == m_iNaNs )
+		return std::numeric_limits< double >::quiet_NaN( );
+
+	return m_dMax == 0.0 ? 0.0 : m_dMax;
+}
+
+// Estimates a quantile from the bucket counts: the middle of the bucket
+// holding the operand of rank dFraction * ( n - 1 ), rounded to the
+// nearest rank, among the n operands that aren't NaN.
+//	Parameters:
+//		dFraction : double - From 0 (the min) to 1 (the max).
+//	Returns:
+//		The quantile, or NaN if there are no operands, dFraction is out of
+//		range, or a bucket page couldn't be allocated.
+//////////////////////////////////////////////////////////////////////
+double OperandStats::get_Quantile( double dFraction ) const
+{
+	const unsigned long long iValues = m_iCount - m_iNaNs;
+	unsigned long long iRank = 0;
+	unsigned long long iSeen = 0;
+
+	if( iValues == 0 || m_bBucketsLost || !( dFraction >= 0.0 && dFraction <= 1.0 ) )
+		return std::numeric_limits< double >::quiet_NaN( );
+
+	iRank = (unsigned long long)( dFraction * (double)( iValues - 1 ) + 0.5 );
+
+	// Negative pages hold their largest magnitudes in their last slots, so
+	// values ascend down the negative pages from the top, then up the
+	// positive ones.
+	for( size_t k = 0; k < STATS_BUCKET_PAGES; ++k )
+	{
+		const bool bNegative = k < STATS_BUCKET_PAGES / 2;
+		const size_t iPage = bNegative ? STATS_BUCKET_PAGES - 1 - k : k - STATS_BUCKET_PAGES / 2;
+		const unsigned long long* pPage = m_apBuckets[ iPage ].get( );
+
+		if( pPage == NULL )
+			continue;
+
+		for( size_t s = 0; s < STATS_BUCKET_SLOTS; ++s )
+		{
+			const size_t iSlot = bNegative ? STATS_BUCKET_SLOTS - 1 - s : s;
+			uint64_t iBits = ( (uint64_t) iPage << 52 ) | ( (uint64_t) iSlot << BUCKET_SHIFT ) | ( 1ULL << ( BUCKET_SHIFT - 1 ) );
+			double dValue = 0.0;
+
+			iSeen += pPage[ iSlot ];
+
+			if( iSeen <= iRank )
+				continue;
+
+			// Zeros share the first slot with the tiniest subnormals.
+			if( ( iPage & 0x7ff ) == 0 && iSlot == 0 )
+				return 0.0;
+
+			if( ( iPage & 0x7ff ) == 0x7ff )
+				return bNegative ? -HUGE_VAL : HUGE_VAL;
+
+			memcpy( &dValue, &iBits, sizeof( dValue ) );
+			dValue = dValue < m_dMin ? m_dMin : dValue;
+			dValue = dValue > m_dMax ? m_dMax : dValue;
+			return dValue == 0.0 ? 0.0 : dValue;
+		}
+	}
+
+	return get_Max( );
+}
+
+/*********************************************************************\
+ *	Functions														 *
+\*********************************************************************/
+
+// Prints every statistic, and the quantiles from 1% to 99%, on two lines.
+void print_Stats( FILE* pOutput, const OperandStats& oStats )
+{
+	static const struct
+	{
+		const char* sName;
+		double dFraction;
+	} aQUANTILES[] =
+	{
+		{ "p1", 0.01 }, { "p10", 0.1 }, { "p25", 0.25 }, { "p50", 0.5 },
+		{ "p75", 0.75 }, { "p90", 0.9 }, { "p99", 0.99 }
+	};
+
+	fprintf( pOutput, "operands: count=%llu sum=%.17g mean=%.17g variance=%.17g min=%.17g max=%.17g\n",
+			 oStats.get_Count( ), oStats.get_Sum( ), oStats.get_Mean( ), oStats.get_Variance( ),
+			 oStats.get_Min( ), oStats.get_Max( ) );
+	fprintf( pOutput, "operands:" );
+
+	for( size_t i = 0; i < sizeof( aQUANTILES ) / sizeof( aQUANTILES[ 0 ] ); ++i )
+		fprintf( pOutput, " %s=%.17g", aQUANTILES[ i ].sName, oStats.get_Quantile( aQUANTILES[ i ].dFraction ) );
+
+	fprintf( pOutput, "\n" );
+}
+
+/*********************************************************************\
+ *	Private Functions												 *
+\*********************************************************************/
+
+// Counts an operand in its bucket, allocating the bucket's page the first
+// time its sign and exponent are seen.
+void OperandStats::add_Bucket( uint64_t iBits )
+{
+	std::unique_ptr< unsigned long long[] >& pPage = m_apBuckets[ iBits >> 52 ];
+
+	if( !pPage )
+	{
+		pPage.reset( new( std::nothrow ) unsigned long long[ STATS_BUCKET_SLOTS ]( ) );
+
+		if( !pPage )
+		{
+			m_bBucketsLost = true;
+			return;
+		}
+	}
+
+	++pPage[ ( iBits >> BUCKET_SHIFT ) & ( STATS_BUCKET_SLOTS - 1 ) ];
+}
+
+// Counts a NaN or an infinity.  Infinities are also a min or max and have
+// buckets of their own.
+void OperandStats::add_Special( uint64_t iBits )
+{
+	if( ( iBits & FRACTION_MASK ) != 0 )
+	{
+		++m_iNaNs;
+		return;
+	}
+
+	if( ( iBits >> 63 ) != 0 )
+	{
+		++m_iNegativeInfinities;
+		m_dMin = -HUGE_VAL;
+	}
+	else
+	{
+		++m_iPositiveInfinities;
+		m_dMax = HUGE_VAL;
+	}
+
+	add_Bucket( iBits );
+}
+
+// Adds a finite operand's mantissa to the chunk for its exponent, and its
+// square's to two square chunks.  The operand is its mantissa times
+// 2^( iPosition - 1074 ), so its square is the mantissa's 106 bit square
+// times 2^( 2 iPosition - 2148 ), split into two halves of 53 bits.
+void OperandStats::add_Finite( uint64_t iBits, unsigned int iExponent )
+{
+	const uint64_t iMantissa = ( iBits & FRACTION_MASK ) | ( iExponent != 0 ? HIDDEN_BIT : 0 );
+	const unsigned int iPosition = iExponent != 0 ? iExponent - 1 : 0;
+	const uint64_t iHigh = iMantissa >> 32;
+	const uint64_t iLow = iMantissa & DIGIT_MASK;
+	const uint64_t iMiddle = 2 * iHigh * iLow;
+	uint64_t iSquareLow = iLow * iLow;
+	uint64_t iSquareHigh = iHigh * iHigh + ( iMiddle >> 32 );
+
+	// The 128 bit square is iSquareHigh * 2^64 + iSquareLow.
+	iSquareLow += iMiddle << 32;
+	iSquareHigh += iSquareLow < ( iMiddle << 32 ) ? 1 : 0;
+
+	m_aSumChunks[ iPosition ] += ( iBits >> 63 ) != 0 ? -(int64_t) iMantissa : (int64_t) iMantissa;
+	m_aSquareChunks[ 2 * iPosition ] += (int64_t)( iSquareLow & ( HIDDEN_BIT | FRACTION_MASK ) );
+	m_aSquareChunks[ 2 * iPosition + 53 ] += (int64_t)( ( iSquareHigh << 11 ) | ( iSquareLow >> 53 ) );
+	m_iLowChunk = iPosition < m_iLowChunk ? iPosition : m_iLowChunk;
+	m_iHighChunk = iPosition > m_iHighChunk ? iPosition : m_iHighChunk;
+
+	add_Bucket( iBits );
+
+	if( ++m_iPending == STATS_FOLD_PERIOD )
+		fold( );
+}
+
+// Adds the chunks in use to a copy of the digits, which are left
+// normalized.  pSquares may be NULL when only the sum is wanted.
+void OperandStats::fold_Into( int64_t* pSum, int64_t* pSquares ) const
+{
+	for( unsigned int i = m_iLowChunk; i <= m_iHighChunk && i < STATS_SUM_CHUNKS; ++i )
+	{
+		deposit_Chunk( pSum, m_aSumChunks[ i ], i );
+
+		if( pSquares != NULL )
+		{
+			deposit_Chunk( pSquares, m_aSquareChunks[ 2 * i ], 2 * i );
+			deposit_Chunk( pSquares, m_aSquareChunks[ 2 * i + 53 ], 2 * i + 53 );
+		}
+	}
+
+	normalize_Digits( pSum, STATS_SUM_DIGITS );
+
+	if( pSquares != NULL )
+		normalize_Digits( pSquares, STATS_SQUARE_DIGITS );
+}
+
+// Folds the chunks into the digits and empties them, so they can take
+// another STATS_FOLD_PERIOD operands.
+void OperandStats::fold( )
+{
+	fold_Into( m_aSum, m_aSquares );
+
+	for( unsigned int i = m_iLowChunk; i <= m_iHighChunk && i < STATS_SUM_CHUNKS; ++i )
+	{
+		m_aSumChunks[ i ] = 0;
+		m_aSquareChunks[ 2 * i ] = 0;
+		m_aSquareChunks[ 2 * i + 53 ] = 0;
+	}
+
+	m_iLowChunk = STATS_SUM_CHUNKS;
+	m_iHighChunk = 0;
+	m_iPending = 0;
+}
+
+// Returns true if any operand was a NaN or an infinity.
+bool OperandStats::has_Special( ) const
+{
+	return m_iNaNs != 0 || m_iPositiveInfinities != 0 || m_iNegativeInfinities != 0;
+}
+
+// Returns what IEEE arithmetic makes of a sum with non-finite operands.
+double OperandStats::get_Special_Sum( ) const
+{
+	if( m_iNaNs != 0 || ( m_iPositiveInfinities != 0 && m_iNegativeInfinities != 0 ) )
+		return std::numeric_limits< double >::quiet_NaN( );
+
+	return m_iPositiveInfinities != 0 ? HUGE_VAL : -HUGE_VAL;
+}
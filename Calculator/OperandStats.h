@@ -0,0 +1,114 @@
+#ifndef _OPERANDSTATS_H
+#define _OPERANDSTATS_H
+
+// Name: OperandStats.h
+// Description: Statistics over the operands a calculator applies, kept in
+//				the same pass as the calculation: count, sum, mean,
+//				variance, min, max and quantiles.
+//
+//				Sums are exact.  Every finite operand, and its square, is
+//				added to a fixed-point integer wide enough to hold any sum
+//				of doubles (and their squares) without rounding, so the
+//				order operands are added in can't change a bit of the
+//				result: accumulators filled on separate threads and merged
+//				in any order give what one serial pass gives.  To keep that
+//				cheap, an operand's mantissa is first added to a 64 bit
+//				chunk for its exponent, which can take STATS_FOLD_PERIOD
+//				of them before the chunks are folded into the digits.  The sum is
+//				rounded once, to nearest, when read; the mean and variance
+//				are divided out of the exact sums, with two or three
+//				roundings.  Kahan or pairwise summation would be cheaper, but
+//				their results depend on how the stream was split.
+//
+//				Quantiles come from counts of operands by their leading
+//				bits (sign, exponent and 7 bits of mantissa), which are as
+//				order independent as the sums.  A quantile is the middle
+//				of the bucket holding it, within 1/256 of the value, and
+//				clamped to [min, max].  Bucket pages are allocated as
+//				operands of new magnitudes arrive.
+//
+//				NaN operands are counted and make the sum, mean and
+//				variance NaN, but are left out of the min, max and
+//				quantiles.  Infinities make the sum and mean infinite (NaN
+//				if both signs were seen) and the variance NaN.  Zeros are
+//				reported as +0.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+/////////////
+// Defines //
+/////////////
+#define STATS_SUM_DIGITS		68			// 32 bit digits of 2^-1074 .. 2^1070, with 2^64 operands of headroom
+#define STATS_SQUARE_DIGITS		134			// Same for squares, 2^-2148 .. 2^2112
+#define STATS_SUM_CHUNKS		2046		// One per exponent, subnormals with the smallest normal
+#define STATS_SQUARE_CHUNKS		( 2 * STATS_SUM_CHUNKS + 53 )	// Squares land in two, 53 bits apart
+#define STATS_FOLD_PERIOD		1024		// 53 bit mantissas a 64 bit chunk can hold
+#define STATS_BUCKET_PAGES		4096		// One per sign and exponent
+#define STATS_BUCKET_SLOTS		128			// Leading mantissa bits per page
+
+//////////////////////////////
+// OperandStats Declaration //
+//////////////////////////////
+class OperandStats
+{
+public:
+	OperandStats( );
+	~OperandStats( );
+
+	void add( double dValue );
+	void add_Values( const double* pValues, size_t iCount );
+	void merge( const OperandStats& oOther );
+	void clear( );
+
+	// Statistics
+	unsigned long long get_Count( ) const;
+	double get_Sum( ) const;
+	double get_Mean( ) const;
+	double get_Variance( ) const;
+	double get_Min( ) const;
+	double get_Max( ) const;
+	double get_Quantile( double dFraction ) const;
+
+private:
+	OperandStats( const OperandStats& );
+	OperandStats& operator=( const OperandStats& );
+
+	void add_Bucket( uint64_t iBits );
+	void add_Special( uint64_t iBits );
+	void add_Finite( uint64_t iBits, unsigned int iExponent );
+	void fold_Into( int64_t* pSum, int64_t* pSquares ) const;
+	void fold( );
+	bool has_Special( ) const;
+	double get_Special_Sum( ) const;
+
+	int64_t m_aSum[ STATS_SUM_DIGITS ];				// Digit i weighs 2^( 32 i - 1074 )
+	int64_t m_aSquares[ STATS_SQUARE_DIGITS ];		// Digit i weighs 2^( 32 i - 2148 )
+	int64_t m_aSumChunks[ STATS_SUM_CHUNKS ];		// Chunk i weighs 2^( i - 1074 )
+	int64_t m_aSquareChunks[ STATS_SQUARE_CHUNKS ];	// Chunk i weighs 2^( i - 2148 )
+	unsigned int m_iLowChunk;						// Sum chunks in use since the last fold
+	unsigned int m_iHighChunk;
+	unsigned long long m_iCount;
+	unsigned long long m_iNaNs;
+	unsigned long long m_iPositiveInfinities;
+	unsigned long long m_iNegativeInfinities;
+	unsigned int m_iPending;						// Operands since the last fold
+	double m_dMin;
+	double m_dMax;
+	bool m_bBucketsLost;							// A bucket page couldn't be allocated
+	std::unique_ptr< unsigned long long[] > m_apBuckets[ STATS_BUCKET_PAGES ];
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+void print_Stats( FILE* pOutput, const OperandStats& oStats );
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef _OPERATION_H
+#define _OPERATION_H
+
+// Name: Operation.h
+// Description: A single decoded calculator operation.  Used wherever
+//				operations are handled as data instead of being applied
+//				directly from user input (scripts, logs, replays).
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+/////////////
+// Defines //
+/////////////
+#define OP_CODE_STORE		's'		// Store working value into memory
+#define OP_CODE_RESET		'r'		// Reset the working value
+#define OP_CODE_SET			'='		// Set the working value to the operand
+#define OP_CODE_STORE_VAR	'v'		// Store working value into variable iSlot
+#define OP_CODE_MEM_FLAG	0x80	// Operand is the value held in memory
+#define OP_CODE_VAR_FLAG	0x40	// With OP_CODE_MEM_FLAG: operand is variable iSlot
+
+///////////////////////////
+// Operation Declaration //
+///////////////////////////
+// cOpCode is either one of the calculator's operators ('+','-','*','/'),
+// optionally or'd with OP_CODE_MEM_FLAG or with both flags, or one of the
+// OP_CODE_* commands.  dValue is only meaningful for operators without a
+// flag and for OP_CODE_SET; iSlot only for variable operands and
+// OP_CODE_STORE_VAR.  Slots belong to the calculator's VariableTable and
+// are never written to operation logs or journals.
+struct Operation
+{
+	unsigned char cOpCode;
+	unsigned int iSlot;
+	double dValue;
+};
+
+// Returns the operator character of an operator's op code, without its
+// flags.
+inline char op_Operator( unsigned char cOpCode )
+{
+	return (char)( cOpCode & ~( OP_CODE_MEM_FLAG | OP_CODE_VAR_FLAG ) );
+}
+
+// Returns true if the op code takes its operand from memory.
+inline bool op_UsesMem( unsigned char cOpCode )
+{
+	return ( cOpCode & ( OP_CODE_MEM_FLAG | OP_CODE_VAR_FLAG ) ) == OP_CODE_MEM_FLAG;
+}
+
+// Returns true if the op code takes its operand from a variable.
+inline bool op_UsesVar( unsigned char cOpCode )
+{
+	return ( cOpCode & ( OP_CODE_MEM_FLAG | OP_CODE_VAR_FLAG ) ) == ( OP_CODE_MEM_FLAG | OP_CODE_VAR_FLAG );
+}
+
+// Returns true if the op code reads or writes a variable.
+inline bool op_TouchesVar( unsigned char cOpCode )
+{
+	return cOpCode == OP_CODE_STORE_VAR || op_UsesVar( cOpCode );
+}
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef _OPERATORREGISTRY_H
+#define _OPERATORREGISTRY_H
+
+// Name: OperatorRegistry.h
+// Description: Every operator of the calculator, defined in one place.
+//				An operator is a struct holding its symbol, its traits and
+//				its kernel, and CalculatorOperators lists them.  All the
+//				rest is derived from the list at compile time: a 256 entry
+//				table indexed by character for validation and traits,
+//				dispatch from a symbol straight to the operator's kernel,
+//				and tables of kernel instances for the batch and SIMD
+//				paths.  Adding an operator to the list adds it to the
+//				calculator, the parsers, the bytecode and the banks, and
+//				costs the existing operators nothing.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+// What the registry knows about a character.  Everything is 0 for a
+// character that isn't an operator.
+struct OperatorInfo
+{
+	unsigned char iArity;			// 2 takes an operand, 1 only acts on the working value
+	unsigned char iIndex;			// Position in CalculatorOperators, for kernel tables
+	unsigned char iPrecedence;		// Binding strength of a binary operator in expressions
+	bool bAffine;					// Applying it with a constant is v -> scale * v + offset
+};
+
+/*********************************************************************\
+ *	Operators														 *
+\*********************************************************************/
+
+// Each operator defines:
+//		cSymbol			- Its character in lines, expressions, op codes and
+//						  bytecode.  Punctuation below '@' that the syntax
+//						  doesn't already use.
+//		iArity			- 2 if it takes an operand, 1 if it doesn't.  A unary
+//						  operator is a line on its own and never appears
+//						  inside expressions.
+//		iPrecedence		- How tightly a binary operator binds in expressions,
+//						  from 1.  0 for a unary operator.
+//		bAffine			- True if v -> apply( v, d ) is affine for any
+//						  constant d.  Affine operators also define get_Map,
+//						  which the parallel scan uses to fold runs of them.
+//						  A scaling map's offset is -0.0, which leaves a
+//						  zero working value's sign alone.
+//		apply			- The kernel, on the working value and the operand.
+//						  Unary operators ignore the operand.
+// The kernels are the exact expressions the calculator has always used,
+// so results don't change by a bit.
+struct OperatorAdd
+{
+	static constexpr char cSymbol = '+';
+	static constexpr unsigned char iArity = 2;
+	static constexpr unsigned char iPrecedence = 1;
+	static constexpr bool bAffine = true;
+
+	static inline double apply( double dValue, double dOperand ) { return dValue + dOperand; }
+	static inline void get_Map( double dOperand, double& dScale, double& dOffset ) { dScale = 1.0; dOffset = dOperand; }
+};
+
+struct OperatorSubtract
+{
+	static constexpr char cSymbol = '-';
+	static constexpr unsigned char iArity = 2;
+	static constexpr unsigned char iPrecedence = 1;
+	static constexpr bool bAffine = true;
+
+	static inline double apply( double dValue, double dOperand ) { return dValue - dOperand; }
+	static inline void get_Map( double dOperand, double& dScale, double& dOffset ) { dScale = 1.0; dOffset = -dOperand; }
+};
+
+struct OperatorMultiply
+{
+	static constexpr char cSymbol = '*';
+	static constexpr unsigned char iArity = 2;
+	static constexpr unsigned char iPrecedence = 2;
+	static constexpr bool bAffine = true;
+
+	static inline double apply( double dValue, double dOperand ) { return dValue * dOperand; }
+	static inline void get_Map( double dOperand, double& dScale, double& dOffset ) { dScale = dOperand; dOffset = -0.0; }
+};
+
+struct OperatorDivide
+{
+	static constexpr char cSymbol = '/';
+	static constexpr unsigned char iArity = 2;
+	static constexpr unsigned char iPrecedence = 2;
+	static constexpr bool bAffine = true;
+
+	static inline double apply( double dValue, double dOperand ) { return dValue / dOperand; }
+	static inline void get_Map( double dOperand, double& dScale, double& dOffset ) { dScale = 1.0 / dOperand; dOffset = -0.0; }
+};
+
+/*********************************************************************\
+ *	Registry														 *
+\*********************************************************************/
+
+// Compile-time operations over a list of operators.
+template< class... OPERATORS >
+struct OperatorList
+{
+	static constexpr size_t iCount = sizeof...( OPERATORS );
+
+	// The symbols in order, null terminated.
+	static constexpr char sSymbols[ iCount + 1 ] = { OPERATORS::cSymbol..., '\0' };
+
+	// Builds the table of traits indexed by character.
+	static constexpr std::array< OperatorInfo, 256 > build_Table( )
+	{
+		std::array< OperatorInfo, 256 > aTable = { };
+		const OperatorInfo aInfo[ iCount ] = { { OPERATORS::iArity, 0, OPERATORS::iPrecedence, OPERATORS::bAffine }... };
+
+		for( size_t i = 0; i < iCount; ++i )
+		{
+			aTable[ (unsigned char) sSymbols[ i ] ] = aInfo[ i ];
+			aTable[ (unsigned char) sSymbols[ i ] ].iIndex = (unsigned char) i;
+		}
+
+		return aTable;
+	}
+
+	// Returns the position of an operator in the list.
+	template< class OPERATOR >
+	static constexpr size_t index_Of( )
+	{
+		const bool aMatch[ iCount ] = { std::is_same< OPERATOR, OPERATORS >::value... };
+		size_t i = 0;
+
+		while( i < iCount && !aMatch[ i ] )
+			++i;
+
+		return i;
+	}
+
+	// Returns true if every symbol is free for an operator and used once.
+	// Op codes keep their flags in the top two bits, so symbols are the
+	// punctuation below '@'.
+	static constexpr bool check_Symbols( )
+	{
+		const char* sTaken = "=#().";
+
+		for( size_t i = 0; i < iCount; ++i )
+		{
+			char cSymbol = sSymbols[ i ];
+
+			if( cSymbol <= ' ' || cSymbol >= '@' || ( cSymbol >= '0' && cSymbol <= '9' ) )
+				return false;
+
+			for( const char* pTaken = sTaken; *pTaken != '\0'; ++pTaken )
+			{
+				if( cSymbol == *pTaken )
+					return false;
+			}
+
+			for( size_t j = 0; j < i; ++j )
+			{
+				if( cSymbol == sSymbols[ j ] )
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Calls oVisitor( OPERATOR( ) ) for the operator with the given symbol,
+	// so the visitor is instantiated with each operator's kernel inline.
+	//	Returns:
+	//		false if cSymbol isn't an operator.
+	template< class VISITOR >
+	static inline bool dispatch( char cSymbol, VISITOR&& oVisitor )
+	{
+		return ( ( cSymbol == OPERATORS::cSymbol && ( oVisitor( OPERATORS( ) ), true ) ) || ... );
+	}
+
+	// Returns KERNEL< OPERATOR >::run for every operator, in list order, so
+	// a kernel table can be indexed by OperatorInfo::iIndex.
+	template< class FUNCTION, template< class > class KERNEL >
+	static constexpr std::array< FUNCTION, iCount > make_Kernels( )
+	{
+		return { { &KERNEL< OPERATORS >::run... } };
+	}
+};
+
+// The calculator's operators.  This is the one place to add one.
+typedef OperatorList< OperatorAdd, OperatorSubtract, OperatorMultiply, OperatorDivide > CalculatorOperators;
+
+static_assert( CalculatorOperators::check_Symbols( ), "operator symbols must be unused punctuation, each used once" );
+
+inline constexpr std::array< OperatorInfo, 256 > aOPERATOR_TABLE = CalculatorOperators::build_Table( );
+
+/*********************************************************************\
+ *	Lookups															 *
+\*********************************************************************/
+
+// Returns the traits of a character, iArity 0 if it isn't an operator.
+constexpr const OperatorInfo& get_Operator( char cSymbol )
+{
+	return aOPERATOR_TABLE[ (unsigned char) cSymbol ];
+}
+
+// Returns true if the character is one of the calculator's operators.
+constexpr bool is_Operator( char cSymbol )
+{
+	return aOPERATOR_TABLE[ (unsigned char) cSymbol ].iArity != 0;
+}
+
+// Runs oVisitor with the operator whose symbol is cSymbol, see
+// OperatorList::dispatch.
+template< class VISITOR >
+inline bool dispatch_Operator( char cSymbol, VISITOR&& oVisitor )
+{
+	return CalculatorOperators::dispatch( cSymbol, static_cast< VISITOR&& >( oVisitor ) );
+}
+
+#endif
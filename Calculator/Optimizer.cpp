@@ -0,0 +1,652 @@
+// Name: Optimizer.cpp
+// Description: Rewrites operation streams and compiled lines, see
+//				Optimizer.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "Optimizer.h"
+#include "OperatorRegistry.h"
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+// A run of input operations that became at most one output operation.
+// Every group with an output owns the next operation of the output, so
+// the last such group owns vOutput.back( ).  Two groups without an output
+// are never next to each other; they are merged instead.
+struct Group
+{
+	size_t iFirst;
+	size_t iCount;
+	bool bOutput;
+	unsigned int iKinds;
+	bool bExact;
+};
+
+// A node of a compiled expression.  Children always come before their
+// parent, as their code does in the bytecode.
+struct ExprNode
+{
+	unsigned char cOpcode;
+	double dValue;			// BC_CONST
+	unsigned int iSlot;		// BC_VAR
+	size_t iLeft;			// Operand of BC_NEGATE, left operand of an operator
+	size_t iRight;
+};
+
+/*********************************************************************\
+ *	Rules															 *
+\*********************************************************************/
+
+// Returns true if an operator is '+' or '-'.
+static inline bool is_Additive( char cOperator )
+{
+	return cOperator == OperatorAdd::cSymbol || cOperator == OperatorSubtract::cSymbol;
+}
+
+// Returns true if "x (operator) dOperand" is x for every x.  x - 0 and
+// x + -0 keep the sign of a zero x, but x + 0 and x - -0 turn -0 into +0,
+// so those two only count under fast-math.
+//	Parameters:
+//		bExact : bool - Set to false if the identity only holds under
+//						fast-math.
+//////////////////////////////////////////////////////////////////////
+static bool is_Identity( char cOperator, double dOperand, eOptimizeLevel eLevel, bool& bExact )
+{
+	bExact = true;
+
+	if( cOperator == OperatorMultiply::cSymbol || cOperator == OperatorDivide::cSymbol )
+		return dOperand == 1.0;
+
+	if( !is_Additive( cOperator ) || dOperand != 0.0 )
+		return false;
+
+	bExact = ( cOperator == OperatorAdd::cSymbol ) == (bool) signbit( dOperand );
+	return bExact || eLevel == OPTIMIZE_FAST_MATH;
+}
+
+// Returns true if "dOperand (operator) x" is x for every x: 1 * x, and
+// -0 + x.  0 + x turns -0 into +0, so it only counts under fast-math.
+static bool is_Left_Identity( char cOperator, double dOperand, eOptimizeLevel eLevel, bool& bExact )
+{
+	bExact = true;
+
+	if( cOperator == OperatorMultiply::cSymbol )
+		return dOperand == 1.0;
+
+	if( cOperator != OperatorAdd::cSymbol || dOperand != 0.0 )
+		return false;
+
+	bExact = signbit( dOperand );
+	return bExact || eLevel == OPTIMIZE_FAST_MATH;
+}
+
+// Returns true if "/ dOperand" may become "* ( 1 / dOperand )".  That is
+// exact when dOperand is a power of two whose reciprocal is representable:
+// both then round the same real quotient.  Under fast-math any finite
+// divisor with a finite, nonzero reciprocal will do.
+static bool may_Reciprocate( double dOperand, eOptimizeLevel eLevel, bool& bExact )
+{
+	unsigned long long iBits = 0;
+	unsigned long long iFraction = 0;
+
+	if( !isfinite( dOperand ) || dOperand == 0.0 || !isfinite( 1.0 / dOperand ) )
+		return false;
+
+	// A power of two has no fraction bits, or a single one if subnormal.
+	memcpy( &iBits, &dOperand, sizeof( double ) );
+	iFraction = iBits & 0x000FFFFFFFFFFFFFULL;
+	bExact = ( iBits & 0x7FF0000000000000ULL ) != 0 ? iFraction == 0 : ( iFraction & ( iFraction - 1 ) ) == 0;
+
+	return bExact || eLevel == OPTIMIZE_FAST_MATH;
+}
+
+// Combines two constant operations applied one after the other into one,
+// reassociating: "+ a", "- b" is "+ ( a - b )" and "* a", "* b" is
+// "* ( a * b )".  Divisions that fast-math left alone don't combine.
+//	Returns:
+//		False if the operations don't combine.
+//////////////////////////////////////////////////////////////////////
+static bool combine( const Operation& oFirst, const Operation& oSecond, Operation& oResult )
+{
+	char cFirst = (char) oFirst.cOpCode;
+	char cSecond = (char) oSecond.cOpCode;
+	double dSum = 0.0;
+
+	oResult.iSlot = 0;
+
+	if( is_Additive( cFirst ) && is_Additive( cSecond ) )
+	{
+		dSum = ( cFirst == OperatorAdd::cSymbol ? oFirst.dValue : -oFirst.dValue )
+			 + ( cSecond == OperatorAdd::cSymbol ? oSecond.dValue : -oSecond.dValue );
+		oResult.cOpCode = (unsigned char)( signbit( dSum ) ? OperatorSubtract::cSymbol : OperatorAdd::cSymbol );
+		oResult.dValue = signbit( dSum ) ? -dSum : dSum;
+		return true;
+	}
+
+	if( cFirst == OperatorMultiply::cSymbol && cSecond == OperatorMultiply::cSymbol )
+	{
+		oResult.cOpCode = (unsigned char) OperatorMultiply::cSymbol;
+		oResult.dValue = oFirst.dValue * oSecond.dValue;
+		return true;
+	}
+
+	return false;
+}
+
+/*********************************************************************\
+ *	Operations														 *
+\*********************************************************************/
+
+// Returns true if an operation only computes the working value from the
+// working value and a constant: no memory, variables or stores.
+bool is_Pure( const Operation& oOperation )
+{
+	return oOperation.cOpCode == OP_CODE_RESET || oOperation.cOpCode == OP_CODE_SET ||
+		   is_Operator( (char) oOperation.cOpCode );
+}
+
+// Applies a pure operation to a value, with the calculator's kernels but
+// without a calculator.
+//	Returns:
+//		The new working value.
+//////////////////////////////////////////////////////////////////////
+double apply_Pure( const Operation& oOperation, double dValue )
+{
+	switch( oOperation.cOpCode )
+	{
+	case OP_CODE_RESET:
+		return 0.0;
+	case OP_CODE_SET:
+		return oOperation.dValue;
+	default:
+		dispatch_Operator( (char) oOperation.cOpCode, [ & ]( auto oOperator )
+		{
+			dValue = decltype( oOperator )::apply( dValue, oOperation.dValue );
+		} );
+		return dValue;
+	}
+}
+
+// Returns the number of groups up to the last one with an output.
+static inline size_t find_Tail( const vector< Group >& vGroups )
+{
+	size_t iTail = vGroups.size( );
+
+	if( iTail > 0 && !vGroups[ iTail - 1 ].bOutput )
+		--iTail;
+
+	return iTail;
+}
+
+// Merges every group after iGroup into it and extends it to input
+// operation iLast.
+static void merge_Groups( vector< Group >& vGroups, size_t iGroup, size_t iLast,
+						  unsigned int iKinds, bool bExact )
+{
+	Group& oGroup = vGroups[ iGroup ];
+
+	for( size_t i = iGroup + 1; i < vGroups.size( ); ++i )
+	{
+		oGroup.iKinds |= vGroups[ i ].iKinds;
+		oGroup.bExact = oGroup.bExact && vGroups[ i ].bExact;
+	}
+
+	oGroup.iCount = iLast + 1 - oGroup.iFirst;
+	oGroup.iKinds |= iKinds;
+	oGroup.bExact = oGroup.bExact && bExact;
+	vGroups.resize( iGroup + 1 );
+}
+
+// Records input operation i as dropped.
+static void push_Removed( vector< Group >& vGroups, size_t i, unsigned int iKinds, bool bExact )
+{
+	Group oGroup = { i, 1, false, iKinds, bExact };
+
+	if( !vGroups.empty( ) && !vGroups.back( ).bOutput )
+		merge_Groups( vGroups, vGroups.size( ) - 1, i, iKinds, bExact );
+	else
+		vGroups.push_back( oGroup );
+}
+
+// Rewrites a stream of operations into a shorter one with the same effect
+// at the given level.  Operations that read or write memory or variables
+// are kept as they are and nothing moves across them.
+//	Parameters:
+//		pInput : Operation* - The operations, in order.
+//		iCount : size_t - Number of operations.
+//		eLevel : eOptimizeLevel - Which rewrites are allowed.
+//		vOutput : vector - Receives the rewritten stream.
+//		vRewrites : vector - Receives the rewrites, in stream order.
+//////////////////////////////////////////////////////////////////////
+void optimize_Operations( const Operation* pInput, size_t iCount, eOptimizeLevel eLevel,
+						  vector< Operation >& vOutput, vector< Rewrite >& vRewrites )
+{
+	vector< Group > vGroups;
+	Operation oCombined;
+	size_t iTail = 0;
+	size_t iOutput = 0;
+	bool bRuleExact = true;
+
+	vOutput.clear( );
+	vRewrites.clear( );
+	vGroups.reserve( iCount );
+
+	if( eLevel == OPTIMIZE_OFF )
+	{
+		vOutput.assign( pInput, pInput + iCount );
+		return;
+	}
+
+	for( size_t i = 0; i < iCount; ++i )
+	{
+		Operation oOperation = pInput[ i ];
+		Group oGroup = { i, 1, true, 0, true };
+		char cOperator = (char) oOperation.cOpCode;
+
+		if( !is_Pure( oOperation ) )
+		{
+			vGroups.push_back( oGroup );
+			vOutput.push_back( oOperation );
+			continue;
+		}
+
+		// A set or reset makes the pure operations before it dead, however
+		// they were rewritten, so the result is exact.
+		if( oOperation.cOpCode == OP_CODE_SET || oOperation.cOpCode == OP_CODE_RESET )
+		{
+			while( !vGroups.empty( ) && ( !vGroups.back( ).bOutput || is_Pure( vOutput.back( ) ) ) )
+			{
+				if( vGroups.back( ).bOutput )
+					vOutput.pop_back( );
+
+				oGroup.iFirst = vGroups.back( ).iFirst;
+				oGroup.iKinds |= vGroups.back( ).iKinds | REWRITE_DEAD;
+				vGroups.pop_back( );
+			}
+
+			oGroup.iCount = i + 1 - oGroup.iFirst;
+			vGroups.push_back( oGroup );
+			vOutput.push_back( oOperation );
+			continue;
+		}
+
+		iTail = find_Tail( vGroups );
+
+		// After a set or reset the working value is known, so the operation
+		// is done now, with the same kernel it would have run with.  Two
+		// NaNs are left alone: which one comes out depends on the compiler.
+		if( iTail > 0 && ( vOutput.back( ).cOpCode == OP_CODE_SET || vOutput.back( ).cOpCode == OP_CODE_RESET ) &&
+			!( isnan( apply_Pure( vOutput.back( ), 0.0 ) ) && isnan( oOperation.dValue ) ) )
+		{
+			vOutput.back( ).dValue = apply_Pure( oOperation, apply_Pure( vOutput.back( ), 0.0 ) );
+			vOutput.back( ).cOpCode = OP_CODE_SET;
+			merge_Groups( vGroups, iTail - 1, i, REWRITE_FOLD, true );
+			continue;
+		}
+
+		if( is_Identity( cOperator, oOperation.dValue, eLevel, bRuleExact ) )
+		{
+			push_Removed( vGroups, i, REWRITE_IDENTITY, bRuleExact );
+			continue;
+		}
+
+		if( cOperator == OperatorDivide::cSymbol && may_Reciprocate( oOperation.dValue, eLevel, bRuleExact ) )
+		{
+			oOperation.cOpCode = (unsigned char) OperatorMultiply::cSymbol;
+			oOperation.dValue = 1.0 / oOperation.dValue;
+			oGroup.iKinds |= REWRITE_RECIPROCAL;
+			oGroup.bExact = bRuleExact;
+		}
+
+		if( eLevel == OPTIMIZE_FAST_MATH && iTail > 0 && combine( vOutput.back( ), oOperation, oCombined ) )
+		{
+			merge_Groups( vGroups, iTail - 1, i, oGroup.iKinds | REWRITE_REASSOCIATE, false );
+
+			if( !is_Identity( (char) oCombined.cOpCode, oCombined.dValue, eLevel, bRuleExact ) )
+			{
+				vOutput.back( ) = oCombined;
+				continue;
+			}
+
+			// The chain cancelled out.
+			vOutput.pop_back( );
+			vGroups.back( ).bOutput = false;
+			vGroups.back( ).iKinds |= REWRITE_IDENTITY;
+
+			if( vGroups.size( ) > 1 && !vGroups[ vGroups.size( ) - 2 ].bOutput )
+				merge_Groups( vGroups, vGroups.size( ) - 2, i, 0, true );
+
+			continue;
+		}
+
+		vGroups.push_back( oGroup );
+		vOutput.push_back( oOperation );
+	}
+
+	for( size_t g = 0; g < vGroups.size( ); ++g )
+	{
+		if( vGroups[ g ].iKinds != 0 )
+		{
+			Rewrite oRewrite = { vGroups[ g ].iFirst, vGroups[ g ].iCount, iOutput, !vGroups[ g ].bOutput,
+								 vGroups[ g ].iKinds, vGroups[ g ].bExact };
+
+			vRewrites.push_back( oRewrite );
+		}
+
+		if( vGroups[ g ].bOutput )
+			++iOutput;
+	}
+}
+
+/*********************************************************************\
+ *	Compiled Lines													 *
+\*********************************************************************/
+
+// Turns a program's bytecode into a tree.
+//	Returns:
+//		False if the code isn't a well formed expression.
+//////////////////////////////////////////////////////////////////////
+static bool decode_Program( const Program& oProgram, vector< ExprNode >& vNodes, size_t& iRoot )
+{
+	const unsigned char* pCode = oProgram.vCode.data( );
+	const unsigned char* pEnd = pCode + oProgram.vCode.size( );
+	vector< size_t > vStack;
+
+	while( pCode < pEnd )
+	{
+		ExprNode oNode = { *pCode++, 0.0, 0, 0, 0 };
+
+		switch( oNode.cOpcode )
+		{
+		case BC_END:
+			if( vStack.size( ) != 1 )
+				return false;
+
+			iRoot = vStack.back( );
+			return true;
+		case BC_CONST:
+			if( (size_t)( pEnd - pCode ) < sizeof( double ) )
+				return false;
+
+			memcpy( &oNode.dValue, pCode, sizeof( double ) );
+			pCode += sizeof( double );
+			break;
+		case BC_VAR:
+			if( (size_t)( pEnd - pCode ) < sizeof( oNode.iSlot ) )
+				return false;
+
+			memcpy( &oNode.iSlot, pCode, sizeof( oNode.iSlot ) );
+			pCode += sizeof( oNode.iSlot );
+			break;
+		case BC_MEM:
+		case BC_VALUE:
+			break;
+		case BC_NEGATE:
+			if( vStack.empty( ) )
+				return false;
+
+			oNode.iLeft = vStack.back( );
+			vStack.pop_back( );
+			break;
+		default:
+			if( !is_Operator( (char) oNode.cOpcode ) || vStack.size( ) < 2 )
+				return false;
+
+			oNode.iRight = vStack.back( );
+			vStack.pop_back( );
+			oNode.iLeft = vStack.back( );
+			vStack.pop_back( );
+			break;
+		}
+
+		vStack.push_back( vNodes.size( ) );
+		vNodes.push_back( oNode );
+	}
+
+	return false;
+}
+
+// Writes the tree under iRoot back out as bytecode.  Each node's operands
+// still come before it and the left operand's before the right's, so
+// emitting the nodes still in use in order gives valid code.
+static void encode_Program( const vector< ExprNode >& vNodes, size_t iRoot, Program& oProgram )
+{
+	vector< bool > vUsed( iRoot + 1, false );
+	unsigned int iDepth = 0;
+
+	vUsed[ iRoot ] = true;
+
+	for( size_t i = iRoot + 1; i-- > 0; )
+	{
+		if( !vUsed[ i ] )
+			continue;
+
+		if( vNodes[ i ].cOpcode == BC_NEGATE )
+			vUsed[ vNodes[ i ].iLeft ] = true;
+		else if( is_Operator( (char) vNodes[ i ].cOpcode ) )
+			vUsed[ vNodes[ i ].iLeft ] = vUsed[ vNodes[ i ].iRight ] = true;
+	}
+
+	oProgram.vCode.clear( );
+	oProgram.iMaxStack = 0;
+	oProgram.bReadsState = false;
+
+	for( size_t i = 0; i <= iRoot; ++i )
+	{
+		const ExprNode& oNode = vNodes[ i ];
+
+		if( !vUsed[ i ] )
+			continue;
+
+		oProgram.vCode.push_back( oNode.cOpcode );
+
+		switch( oNode.cOpcode )
+		{
+		case BC_CONST:
+			oProgram.vCode.insert( oProgram.vCode.end( ), (const unsigned char*) &oNode.dValue,
+								   (const unsigned char*) &oNode.dValue + sizeof( double ) );
+			++iDepth;
+			break;
+		case BC_VAR:
+			oProgram.vCode.insert( oProgram.vCode.end( ), (const unsigned char*) &oNode.iSlot,
+								   (const unsigned char*) &oNode.iSlot + sizeof( oNode.iSlot ) );
+			oProgram.bReadsState = true;
+			++iDepth;
+			break;
+		case BC_MEM:
+		case BC_VALUE:
+			oProgram.bReadsState = true;
+			++iDepth;
+			break;
+		case BC_NEGATE:
+			break;
+		default:
+			--iDepth;
+			break;
+		}
+
+		if( iDepth > oProgram.iMaxStack )
+			oProgram.iMaxStack = iDepth;
+	}
+
+	oProgram.vCode.push_back( BC_END );
+	oProgram.oTier = ProgramTier( );
+}
+
+// Rewrites a compiled line's expression: constant subexpressions are
+// folded, identities and double negations dropped and divisions by
+// constants turned into multiplications, as for operation streams.  Under
+// fast-math, chains like "ans * 2 * 3" are reassociated as well.  The
+// line's own operator is left to optimize_Operations.
+//	Parameters:
+//		oProgram : Program - The compiled line, rewritten in place.
+//		eLevel : eOptimizeLevel - Which rewrites are allowed.
+//	Returns:
+//		What was done; iKinds is 0 and the program untouched if nothing.
+//////////////////////////////////////////////////////////////////////
+ProgramRewrite optimize_Program( Program& oProgram, eOptimizeLevel eLevel )
+{
+	ProgramRewrite oRewrite = { 0, true };
+	vector< ExprNode > vNodes;
+	size_t iRoot = 0;
+	bool bRuleExact = true;
+	Operation oFirst;
+	Operation oSecond;
+	Operation oCombined;
+
+	if( eLevel == OPTIMIZE_OFF || !decode_Program( oProgram, vNodes, iRoot ) )
+		return oRewrite;
+
+	// Operands are done before the nodes that use them, so every rule sees
+	// operands that are already as simple as they get.
+	for( size_t i = 0; i < vNodes.size( ); ++i )
+	{
+		ExprNode& oNode = vNodes[ i ];
+
+		if( oNode.cOpcode == BC_NEGATE )
+		{
+			const ExprNode oOperand = vNodes[ oNode.iLeft ];
+
+			if( oOperand.cOpcode == BC_CONST )
+			{
+				oNode.cOpcode = BC_CONST;
+				oNode.dValue = -oOperand.dValue;
+				oRewrite.iKinds |= REWRITE_FOLD;
+			}
+			else if( oOperand.cOpcode == BC_NEGATE )
+			{
+				oNode = vNodes[ oOperand.iLeft ];
+				oRewrite.iKinds |= REWRITE_IDENTITY;
+			}
+
+			continue;
+		}
+
+		if( !is_Operator( (char) oNode.cOpcode ) )
+			continue;
+
+		const ExprNode oLeft = vNodes[ oNode.iLeft ];
+		ExprNode& oRight = vNodes[ oNode.iRight ];
+		char cOperator = (char) oNode.cOpcode;
+
+		if( oLeft.cOpcode == BC_CONST && oRight.cOpcode == BC_CONST &&
+			!( isnan( oLeft.dValue ) && isnan( oRight.dValue ) ) )
+		{
+			oFirst.cOpCode = oNode.cOpcode;
+			oFirst.dValue = oRight.dValue;
+			oNode.dValue = apply_Pure( oFirst, oLeft.dValue );
+			oNode.cOpcode = BC_CONST;
+			oRewrite.iKinds |= REWRITE_FOLD;
+			continue;
+		}
+
+		if( oLeft.cOpcode == BC_CONST && is_Left_Identity( cOperator, oLeft.dValue, eLevel, bRuleExact ) )
+		{
+			oNode = vNodes[ oNode.iRight ];
+			oRewrite.iKinds |= REWRITE_IDENTITY;
+			oRewrite.bExact = oRewrite.bExact && bRuleExact;
+			continue;
+		}
+
+		if( oRight.cOpcode != BC_CONST )
+			continue;
+
+		if( is_Identity( cOperator, oRight.dValue, eLevel, bRuleExact ) )
+		{
+			oNode = oLeft;
+			oRewrite.iKinds |= REWRITE_IDENTITY;
+			oRewrite.bExact = oRewrite.bExact && bRuleExact;
+			continue;
+		}
+
+		if( cOperator == OperatorDivide::cSymbol && may_Reciprocate( oRight.dValue, eLevel, bRuleExact ) )
+		{
+			oNode.cOpcode = (unsigned char) OperatorMultiply::cSymbol;
+			oRight.dValue = 1.0 / oRight.dValue;
+			oRewrite.iKinds |= REWRITE_RECIPROCAL;
+			oRewrite.bExact = oRewrite.bExact && bRuleExact;
+		}
+
+		if( eLevel != OPTIMIZE_FAST_MATH || !is_Operator( (char) oLeft.cOpcode ) ||
+			vNodes[ oLeft.iRight ].cOpcode != BC_CONST )
+			continue;
+
+		oFirst.cOpCode = oLeft.cOpcode;
+		oFirst.dValue = vNodes[ oLeft.iRight ].dValue;
+		oSecond.cOpCode = oNode.cOpcode;
+		oSecond.dValue = oRight.dValue;
+
+		if( !combine( oFirst, oSecond, oCombined ) )
+			continue;
+
+		oNode.cOpcode = oCombined.cOpCode;
+		oNode.iLeft = oLeft.iLeft;
+		oRight.dValue = oCombined.dValue;
+		oRewrite.iKinds |= REWRITE_REASSOCIATE;
+		oRewrite.bExact = false;
+
+		if( is_Identity( (char) oNode.cOpcode, oRight.dValue, eLevel, bRuleExact ) )
+		{
+			oNode = vNodes[ oNode.iLeft ];
+			oRewrite.iKinds |= REWRITE_IDENTITY;
+		}
+	}
+
+	if( oRewrite.iKinds != 0 )
+		encode_Program( vNodes, iRoot, oProgram );
+
+	return oRewrite;
+}
+
+/*********************************************************************\
+ *	Reporting														 *
+\*********************************************************************/
+
+// Prints operations as script lines, quoted and separated by commas.
+// Only the first OPTIMIZER_REPORT_OPS are shown.
+void print_Operations( FILE* pOutput, const Operation* pOperations, size_t iCount )
+{
+	for( size_t i = 0; i < iCount && i < OPTIMIZER_REPORT_OPS; ++i )
+	{
+		const Operation& oOperation = pOperations[ i ];
+
+		fputs( i > 0 ? ", \"" : "\"", pOutput );
+
+		if( oOperation.cOpCode == OP_CODE_RESET )
+			fputc( 'r', pOutput );
+		else if( oOperation.cOpCode == OP_CODE_STORE )
+			fputc( 's', pOutput );
+		else if( oOperation.cOpCode == OP_CODE_SET || is_Operator( (char) oOperation.cOpCode ) )
+			fprintf( pOutput, "%c %.17g", (char) oOperation.cOpCode, oOperation.dValue );
+		else
+			fprintf( pOutput, "%c %s", op_Operator( oOperation.cOpCode ), op_UsesMem( oOperation.cOpCode ) ? "mem" : "(variable)" );
+
+		fputc( '"', pOutput );
+	}
+
+	if( iCount > OPTIMIZER_REPORT_OPS )
+		fprintf( pOutput, " and %llu more", (unsigned long long)( iCount - OPTIMIZER_REPORT_OPS ) );
+}
+
+// Prints what a rewrite did, e.g. "fold, identity (exact)".
+void print_Rewrite_Kinds( FILE* pOutput, unsigned int iKinds, bool bExact )
+{
+	static const char* const aNAMES[ ] = { "fold", "dead", "identity", "reciprocal", "reassociate" };
+	const char* sSeparator = "";
+
+	for( unsigned int i = 0; i < sizeof( aNAMES ) / sizeof( aNAMES[ 0 ] ); ++i )
+	{
+		if( iKinds & ( 1u << i ) )
+		{
+			fprintf( pOutput, "%s%s", sSeparator, aNAMES[ i ] );
+			sSeparator = ", ";
+		}
+	}
+
+	fputs( bExact ? " (exact)" : " (fast-math)", pOutput );
+}
@@ -0,0 +1,84 @@
+#ifndef _OPTIMIZER_H
+#define _OPTIMIZER_H
+
+// Name: Optimizer.h
+// Description: Rewrites operation streams and compiled lines into cheaper
+//				equivalents before they are run.
+//
+//				At OPTIMIZE_EXACT only rewrites that give the same bits for
+//				every working value are made: operations after a set or
+//				reset are folded into it, operations a later set or reset
+//				overwrites are dropped, identities ("* 1", "- 0", ...) are
+//				dropped and division by a power of two becomes
+//				multiplication by its exact reciprocal.  Compiled lines
+//				also get constant subexpressions folded.
+//
+//				OPTIMIZE_FAST_MATH also divides by any constant through
+//				its rounded reciprocal and reassociates chains, so
+//				"+ a", "- b" becomes "+ (a - b)" and "* a", "* b" becomes
+//				"* (a * b)".  These round differently from running the
+//				operations one by one.
+//
+//				Every rewrite is returned to the caller with what it did
+//				and whether it is exact, so a run can be audited.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "Operation.h"
+#include "Bytecode.h"
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+#define REWRITE_FOLD			0x01	// Folded into a known working value or a constant
+#define REWRITE_DEAD			0x02	// Overwritten by a later set or reset, dropped
+#define REWRITE_IDENTITY		0x04	// Left its operand unchanged, dropped
+#define REWRITE_RECIPROCAL		0x08	// Division by a constant made a multiplication
+#define REWRITE_REASSOCIATE		0x10	// Chain of constant operations combined
+#define OPTIMIZER_REPORT_OPS	4		// Operations print_Operations shows before eliding
+
+// How far the optimizer may go.
+enum eOptimizeLevel
+{
+	OPTIMIZE_OFF,			// Run everything as written
+	OPTIMIZE_EXACT,			// Only rewrites that never change a bit
+	OPTIMIZE_FAST_MATH		// Also rewrites that may round differently
+};
+
+// A rewrite of an operation stream: iCount operations of the input from
+// iFirst were replaced by operation iOutput of the output, or by nothing.
+struct Rewrite
+{
+	size_t iFirst;
+	size_t iCount;
+	size_t iOutput;
+	bool bRemoved;			// Replaced by nothing; iOutput is where it would be
+	unsigned int iKinds;	// REWRITE_* flags
+	bool bExact;			// Same bits as the original for every working value
+};
+
+// What optimize_Program did to a compiled line.  iKinds is 0 if nothing.
+struct ProgramRewrite
+{
+	unsigned int iKinds;
+	bool bExact;
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+bool is_Pure( const Operation& oOperation );
+double apply_Pure( const Operation& oOperation, double dValue );
+void optimize_Operations( const Operation* pInput, size_t iCount, eOptimizeLevel eLevel,
+						  std::vector< Operation >& vOutput, std::vector< Rewrite >& vRewrites );
+ProgramRewrite optimize_Program( Program& oProgram, eOptimizeLevel eLevel );
+void print_Operations( FILE* pOutput, const Operation* pOperations, size_t iCount );
+void print_Rewrite_Kinds( FILE* pOutput, unsigned int iKinds, bool bExact );
+
+#endif
@@ -0,0 +1,457 @@
+//////////////
+// Includes //
+//////////////
+#include "ProgramJit.h"
+#include "OperatorRegistry.h"
+#include "VariableTable.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if CALC_JIT
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#endif
+
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define JIT_CODE_ALIGN		16		// Functions start on a fetch block
+
+// Returns whether the JIT may compile anything.  Off if CALC_NO_JIT is set
+// to anything, so embedders on hardened hosts needn't change code.
+static atomic< bool >& get_Enabled_Flag( )
+{
+	static atomic< bool > bEnabled( CALC_JIT && ( getenv( "CALC_NO_JIT" ) == NULL || *getenv( "CALC_NO_JIT" ) == '\0' ) );
+
+	return bEnabled;
+}
+
+/*********************************************************************\
+ *	Switch															 *
+\*********************************************************************/
+
+// Returns true if hot programs are compiled to native code.
+bool is_Jit_Enabled( )
+{
+	return get_Enabled_Flag( ).load( memory_order_relaxed );
+}
+
+// Turns the JIT on or off.  Programs already compiled keep running
+// natively; nothing new is compiled while it is off.
+void set_Jit_Enabled( bool bEnabled )
+{
+	get_Enabled_Flag( ).store( CALC_JIT && bEnabled, memory_order_relaxed );
+}
+
+#if CALC_JIT
+
+/*********************************************************************\
+ *	Code Memory														 *
+\*********************************************************************/
+
+// Pages reserved for code.  Code is appended while they are writable and
+// sealed a page range at a time.
+struct JitChunk
+{
+	unsigned char* pBase;
+	size_t iSize;
+
+	JitChunk( unsigned char* pMemory, size_t iBytes ) : pBase( pMemory ), iSize( iBytes ) {}
+	~JitChunk( );
+
+private:
+	JitChunk( const JitChunk& );
+	JitChunk& operator=( const JitChunk& );
+};
+
+static size_t get_Page_Size( )
+{
+#ifdef _WIN32
+	SYSTEM_INFO oInfo;
+
+	GetSystemInfo( &oInfo );
+	return oInfo.dwPageSize;
+#else
+	long iPageSize = sysconf( _SC_PAGESIZE );
+
+	return iPageSize > 0 ? (size_t) iPageSize : 4096;
+#endif
+}
+
+// Maps writable, not executable, pages.
+static unsigned char* map_Pages( size_t iBytes )
+{
+#ifdef _WIN32
+	return (unsigned char*) VirtualAlloc( NULL, iBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+#else
+	void* pMemory = mmap( NULL, iBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+	return pMemory != MAP_FAILED ? (unsigned char*) pMemory : NULL;
+#endif
+}
+
+// Makes pages executable and read only.
+//	Returns:
+//		False if the host refuses, as hardened ones may.
+static bool seal_Pages( unsigned char* pStart, size_t iBytes )
+{
+#ifdef _WIN32
+	DWORD iOld = 0;
+
+	if( !VirtualProtect( pStart, iBytes, PAGE_EXECUTE_READ, &iOld ) )
+		return false;
+
+	FlushInstructionCache( GetCurrentProcess( ), pStart, iBytes );
+	return true;
+#else
+	return mprotect( pStart, iBytes, PROT_READ | PROT_EXEC ) == 0;
+#endif
+}
+
+JitChunk::~JitChunk( )
+{
+#ifdef _WIN32
+	VirtualFree( pBase, 0, MEM_RELEASE );
+#else
+	munmap( pBase, iSize );
+#endif
+}
+
+// The chunk being written.  Functions written since the last seal share
+// the pending generation and become callable together.
+static mutex s_oLock;
+static shared_ptr< JitChunk > s_pChunk;
+static size_t s_iWritten = 0;				// Bytes of s_pChunk in use
+static size_t s_iSealed = 0;				// Bytes of s_pChunk sealed, whole pages
+static unsigned long long s_iPending = 1;	// Generation of the unsealed code
+static atomic< unsigned long long > s_iSealedGeneration( 0 );
+
+static inline size_t round_Up( size_t iValue, size_t iMultiple )
+{
+	return ( iValue + iMultiple - 1 ) / iMultiple * iMultiple;
+}
+
+// Seals the code written since the last seal.  The rest of the page it
+// ends on is given up, so later code starts on a writable page.  Must be
+// called with s_oLock held.
+//	Returns:
+//		False if the pages could not be made executable; the JIT is then
+//		turned off.
+static bool seal_Pending( )
+{
+	size_t iEnd = 0;
+
+	if( s_pChunk == NULL || s_iWritten == s_iSealed )
+		return true;
+
+	iEnd = round_Up( s_iWritten, get_Page_Size( ) );
+
+	if( !seal_Pages( s_pChunk->pBase + s_iSealed, iEnd - s_iSealed ) )
+	{
+		set_Jit_Enabled( false );
+		return false;
+	}
+
+	s_iWritten = s_iSealed = iEnd;
+	s_iSealedGeneration.store( s_iPending++, memory_order_release );
+	return true;
+}
+
+// Copies a function's code into the pending pages.
+//	Returns:
+//		False if no memory could be had for it.
+static bool place_Code( const vector< unsigned char >& vCode, JitFunction& oFunction )
+{
+	lock_guard< mutex > oLock( s_oLock );
+	unsigned char* pMemory = NULL;
+	size_t iSize = 0;
+
+	if( s_pChunk == NULL || s_iWritten + vCode.size( ) > s_pChunk->iSize )
+	{
+		// Whatever is pending in the old chunk must stay reachable.
+		if( !seal_Pending( ) )
+			return false;
+
+		iSize = round_Up( vCode.size( ) > JIT_CHUNK_BYTES ? vCode.size( ) : JIT_CHUNK_BYTES, get_Page_Size( ) );
+
+		if( ( pMemory = map_Pages( iSize ) ) == NULL )
+			return false;
+
+		s_pChunk = make_shared< JitChunk >( pMemory, iSize );
+		s_iWritten = s_iSealed = 0;
+	}
+
+	memcpy( s_pChunk->pBase + s_iWritten, vCode.data( ), vCode.size( ) );
+	oFunction.pEntry = reinterpret_cast< NativeProgram >( s_pChunk->pBase + s_iWritten );
+	oFunction.iGeneration = s_iPending;
+	oFunction.pChunk = s_pChunk;
+	s_iWritten = round_Up( s_iWritten + vCode.size( ), JIT_CODE_ALIGN );
+
+	if( s_iWritten > s_pChunk->iSize )
+		s_iWritten = s_pChunk->iSize;
+
+	return true;
+}
+
+/*********************************************************************\
+ *	Emitter															 *
+\*********************************************************************/
+
+// Registers.  The working value arrives in xmm0 and the result leaves in
+// it.  The expression stack lives in xmm1 upward, with one more register
+// kept for scratch.  Windows keeps xmm6 and above for the caller.
+#ifdef _WIN32
+#define JIT_REGISTERS_BASE	2		// rdx, the second argument
+#define JIT_STACK_REGISTERS	4		// xmm1 - xmm4
+#else
+#define JIT_REGISTERS_BASE	7		// rdi, the first integer argument
+#define JIT_STACK_REGISTERS	14		// xmm1 - xmm14
+#endif
+#define JIT_SCRATCH			( JIT_STACK_REGISTERS + 1 )
+
+// Opcodes after 0F of the SSE2 forms of the operators.  Operators without
+// one keep their programs in the interpreter.
+template< class OPERATOR > struct SseForm { static constexpr unsigned char cOpcode = 0; };
+template<> struct SseForm< OperatorAdd > { static constexpr unsigned char cOpcode = 0x58; };		// addsd
+template<> struct SseForm< OperatorSubtract > { static constexpr unsigned char cOpcode = 0x5C; };	// subsd
+template<> struct SseForm< OperatorMultiply > { static constexpr unsigned char cOpcode = 0x59; };	// mulsd
+template<> struct SseForm< OperatorDivide > { static constexpr unsigned char cOpcode = 0x5E; };		// divsd
+
+#define SSE_PREFIX_SCALAR	0xF2	// sd forms
+#define SSE_PREFIX_PACKED	0x66	// pd forms and movq
+#define SSE_MOVAPD			0x28
+#define SSE_XORPD			0x57
+#define SSE_MOVSD_LOAD		0x10
+#define SSE_MOVQ_FROM_GPR	0x6E
+
+// Appends an SSE instruction on xmm registers, or on xmm iReg and a
+// [base + disp32] operand when bMemory is set.
+static void emit_Sse( vector< unsigned char >& vCode, unsigned char cPrefix, unsigned char cOpcode,
+					  unsigned int iReg, unsigned int iRm, bool bMemory = false, int iDisplacement = 0 )
+{
+	unsigned char cRex = (unsigned char)( 0x40 | ( iReg >= 8 ? 0x04 : 0 ) | ( iRm >= 8 ? 0x01 : 0 ) );
+
+	vCode.push_back( cPrefix );
+
+	if( cRex != 0x40 )
+		vCode.push_back( cRex );
+
+	vCode.push_back( 0x0F );
+	vCode.push_back( cOpcode );
+	vCode.push_back( (unsigned char)( ( bMemory ? 0x80 : 0xC0 ) | ( ( iReg & 7 ) << 3 ) | ( iRm & 7 ) ) );
+
+	if( bMemory )
+	{
+		for( int i = 0; i < 4; ++i )
+			vCode.push_back( (unsigned char)( (unsigned int) iDisplacement >> ( 8 * i ) ) );
+	}
+}
+
+// Appends mov rax, imm64 and movq xmm iReg, rax.
+static void emit_Bits( vector< unsigned char >& vCode, unsigned int iReg, unsigned long long iBits )
+{
+	vCode.push_back( 0x48 );
+	vCode.push_back( 0xB8 );
+
+	for( int i = 0; i < 8; ++i )
+		vCode.push_back( (unsigned char)( iBits >> ( 8 * i ) ) );
+
+	vCode.push_back( SSE_PREFIX_PACKED );
+	vCode.push_back( (unsigned char)( 0x48 | ( iReg >= 8 ? 0x04 : 0 ) ) );
+	vCode.push_back( 0x0F );
+	vCode.push_back( SSE_MOVQ_FROM_GPR );
+	vCode.push_back( (unsigned char)( 0xC0 | ( ( iReg & 7 ) << 3 ) ) );
+}
+
+// Translates a program into machine code.  Stack slots are renamed onto
+// registers, so either operand's register can take a result.
+//	Parameters:
+//		iSwapMask : unsigned int - Operators whose result goes in the right
+//								   operand's register, see compile_Native.
+//	Returns:
+//		False if the program uses something there is no native form of.
+static bool emit_Program( const Program& oProgram, unsigned int iSwapMask,
+						  vector< unsigned char >& vCode, JitFunction& oFunction )
+{
+	const unsigned char* pCode = oProgram.vCode.data( );
+	const unsigned char* pEnd = pCode + oProgram.vCode.size( );
+	unsigned int aStack[ JIT_STACK_REGISTERS ];	// Register of each slot
+	unsigned int aFree[ JIT_STACK_REGISTERS ];		// Unused registers
+	unsigned int iFree = JIT_STACK_REGISTERS;
+	unsigned int iDepth = 0;
+	unsigned int iSlot = 0;
+	unsigned int iLeft = 0;
+	unsigned int iRight = 0;
+	unsigned char cOpcode = 0;
+	unsigned int iIndex = 0;
+	double dConstant = 0.0;
+	unsigned long long iBits = 0;
+
+	if( oProgram.iMaxStack == 0 || oProgram.iMaxStack > JIT_STACK_REGISTERS )
+		return false;
+
+	for( unsigned int i = 0; i < JIT_STACK_REGISTERS; ++i )
+		aFree[ i ] = JIT_STACK_REGISTERS - i;
+
+	oFunction.iRegisters = VARIABLE_MEMORY_SLOT + 1;
+	oFunction.iMemReads = 0;
+
+	while( pCode < pEnd )
+	{
+		switch( *pCode++ )
+		{
+		case BC_CONST:
+			memcpy( &dConstant, pCode, sizeof( double ) );
+			memcpy( &iBits, &dConstant, sizeof( double ) );
+			pCode += sizeof( double );
+			emit_Bits( vCode, aStack[ iDepth++ ] = aFree[ --iFree ], iBits );
+			break;
+		case BC_MEM:
+			++oFunction.iMemReads;
+			emit_Sse( vCode, SSE_PREFIX_SCALAR, SSE_MOVSD_LOAD, aStack[ iDepth++ ] = aFree[ --iFree ], JIT_REGISTERS_BASE, true,
+					  VARIABLE_MEMORY_SLOT * (int) sizeof( double ) );
+			break;
+		case BC_VAR:
+			memcpy( &iSlot, pCode, sizeof( iSlot ) );
+			pCode += sizeof( iSlot );
+
+			if( iSlot >= ( 1u << 28 ) )
+				return false;
+
+			if( iSlot >= oFunction.iRegisters )
+				oFunction.iRegisters = (size_t) iSlot + 1;
+
+			emit_Sse( vCode, SSE_PREFIX_SCALAR, SSE_MOVSD_LOAD, aStack[ iDepth++ ] = aFree[ --iFree ], JIT_REGISTERS_BASE, true,
+					  (int)( iSlot * sizeof( double ) ) );
+			break;
+		case BC_VALUE:
+			emit_Sse( vCode, SSE_PREFIX_PACKED, SSE_MOVAPD, aStack[ iDepth++ ] = aFree[ --iFree ], 0 );
+			break;
+		case BC_NEGATE:
+			// Flip the sign bit, as -x does.
+			if( iDepth < 1 )
+				return false;
+
+			emit_Bits( vCode, JIT_SCRATCH, 0x8000000000000000ULL );
+			emit_Sse( vCode, SSE_PREFIX_PACKED, SSE_XORPD, aStack[ iDepth - 1 ], JIT_SCRATCH );
+			break;
+		case BC_END:
+			if( iDepth != 1 )
+				return false;
+
+			emit_Sse( vCode, SSE_PREFIX_PACKED, SSE_MOVAPD, 0, aStack[ 0 ] );
+			vCode.push_back( 0xC3 );	// ret
+			return true;
+		default:
+			cOpcode = 0;
+			dispatch_Operator( (char) pCode[ -1 ], [ & ]( auto oOperator )
+			{
+				cOpcode = SseForm< decltype( oOperator ) >::cOpcode;
+			} );
+
+			if( cOpcode == 0 || iDepth < 2 )
+				return false;
+
+			iLeft = aStack[ iDepth - 2 ];
+			iRight = aStack[ iDepth - 1 ];
+			iIndex = get_Operator( (char) pCode[ -1 ] ).iIndex;
+
+			if( iSwapMask & ( 1u << iIndex ) )
+			{
+				emit_Sse( vCode, SSE_PREFIX_SCALAR, cOpcode, iRight, iLeft );
+				aStack[ iDepth - 2 ] = iRight;
+				aFree[ iFree++ ] = iLeft;
+			}
+			else
+			{
+				emit_Sse( vCode, SSE_PREFIX_SCALAR, cOpcode, iLeft, iRight );
+				aFree[ iFree++ ] = iRight;
+			}
+
+			--iDepth;
+			break;
+		}
+	}
+
+	return false;
+}
+
+#else
+
+struct JitChunk
+{
+};
+
+#endif // CALC_JIT
+
+/*********************************************************************\
+ *	Public Use Functions											 *
+\*********************************************************************/
+
+// Compiles a program to native code.
+//	Parameters:
+//		oProgram : Program - A program from the expression compiler.
+//		iSwapMask : unsigned int - Bit OperatorInfo::iIndex is set for each
+//								   operator the interpreter computes as
+//								   "right op left".  The compiler may
+//								   swap the operands of + and *, which only
+//								   shows in which NaN is passed on when
+//								   both are NaN; matching it keeps the two
+//								   tiers identical to the bit.
+//	Returns:
+//		The function, or NULL if the JIT is off or can't compile it.
+//////////////////////////////////////////////////////////////////////
+shared_ptr< const JitFunction > compile_Native( const Program& oProgram, unsigned int iSwapMask )
+{
+#if CALC_JIT
+	shared_ptr< JitFunction > pFunction;
+	vector< unsigned char > vCode;
+
+	if( !is_Jit_Enabled( ) )
+		return NULL;
+
+	pFunction = make_shared< JitFunction >( );
+	vCode.reserve( oProgram.vCode.size( ) * 2 + 8 );
+
+	if( !emit_Program( oProgram, iSwapMask, vCode, *pFunction ) || !place_Code( vCode, *pFunction ) )
+		return NULL;
+
+	return pFunction;
+#else
+	(void) oProgram;
+	(void) iSwapMask;
+	return NULL;
+#endif
+}
+
+// Returns a compiled function's entry, making its code executable first
+// if it is the first to need it.
+//	Returns:
+//		NULL if the code can never run; the program must stay interpreted.
+//////////////////////////////////////////////////////////////////////
+NativeProgram get_Native_Entry( const JitFunction& oFunction )
+{
+#if CALC_JIT
+	if( oFunction.iGeneration > s_iSealedGeneration.load( memory_order_acquire ) )
+	{
+		lock_guard< mutex > oLock( s_oLock );
+
+		if( oFunction.iGeneration > s_iSealedGeneration.load( memory_order_relaxed ) && !seal_Pending( ) )
+			return NULL;
+	}
+
+	return oFunction.pEntry;
+#else
+	(void) oFunction;
+	return NULL;
+#endif
+}
@@ -0,0 +1,70 @@
+#ifndef _PROGRAMJIT_H
+#define _PROGRAMJIT_H
+
+// Name: ProgramJit.h
+// Description: Native x86-64 code for hot compiled lines.  Programs start
+//				in the stack machine of Calculator::evaluate_Program; one
+//				that runs JIT_HOT_RUNS times is translated into a function
+//				that keeps the working value and the expression stack in
+//				SSE registers and is called directly from then on.  Every
+//				instruction maps to the scalar SSE2 instruction the
+//				interpreter's own arithmetic compiles to, so both tiers
+//				give the same bits.
+//
+//				Code is written into pages that are only writable, and
+//				pages are made executable (and never writable again) the
+//				first time code on them is needed, so no page is ever both
+//				writable and executable.  Hosts that refuse executable
+//				memory altogether can turn the JIT off with
+//				set_Jit_Enabled, the CALC_NO_JIT environment variable or
+//				by building with CALC_JIT defined to 0; programs then stay
+//				in the interpreter.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "Bytecode.h"
+#include <cstddef>
+#include <memory>
+
+/////////////
+// Defines //
+/////////////
+#ifndef CALC_JIT
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#define CALC_JIT 1
+#else
+#define CALC_JIT 0
+#endif
+#endif
+
+#define JIT_HOT_RUNS		128				// Interpreted runs before a program is compiled
+#define JIT_CHUNK_BYTES		( 256 << 10 )	// Code memory is reserved this much at a time
+
+// The native form of a program: returns the operand the program computes.
+typedef double ( *NativeProgram )( double dValue, const double* pRegisters );
+
+struct JitChunk;
+
+// A compiled program.  It may only be called once get_Native_Entry has
+// returned its entry, with a register file of at least iRegisters slots.
+struct JitFunction
+{
+	NativeProgram pEntry;
+	unsigned long long iGeneration;		// Seal that makes it executable
+	size_t iRegisters;					// Register file slots the code reads
+	unsigned int iMemReads;				// "mem" reads, for the metrics
+	std::shared_ptr< JitChunk > pChunk;	// Keeps the code mapped
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+bool is_Jit_Enabled( );
+void set_Jit_Enabled( bool bEnabled );
+std::shared_ptr< const JitFunction > compile_Native( const Program& oProgram, unsigned int iSwapMask );
+NativeProgram get_Native_Entry( const JitFunction& oFunction );
+
+#endif
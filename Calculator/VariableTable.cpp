@@ -0,0 +1,187 @@
+// Name: VariableTable.cpp
+// Description: Name interning for the calculator's variables, see
+//				VariableTable.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "VariableTable.h"
+#include <atomic>
+#include <cstring>
+
+/////////////
+// Defines //
+/////////////
+#define FNV_OFFSET_BASIS	2166136261U
+#define FNV_PRIME			16777619U
+
+// Hands out table ids, so compiled code can tell which table its slots
+// came from.
+static std::atomic< unsigned long long > iNextId( 1 );
+
+static inline uint32_t hash_Name( const char* sName, size_t iLength )
+{
+	uint32_t iHash = FNV_OFFSET_BASIS;
+
+	for( size_t i = 0; i < iLength; ++i )
+	{
+		iHash ^= (unsigned char) sName[ i ];
+		iHash *= FNV_PRIME;
+	}
+
+	return iHash;
+}
+
+/*********************************************************************\
+ *	Constructor and Destructor										 *
+\*********************************************************************/
+
+// Creates a table holding only the memory.
+VariableTable::VariableTable( )
+{
+	m_vIndex.assign( VARIABLE_MIN_INDEX, 0 );
+	m_pFree = NULL;
+	m_iFreeBytes = 0;
+	m_iId = iNextId.fetch_add( 1, std::memory_order_relaxed );
+
+	intern( VARIABLE_MEMORY_NAME, sizeof( VARIABLE_MEMORY_NAME ) - 1 );
+}
+
+VariableTable::~VariableTable( )
+{
+	for( size_t i = 0; i < m_vBlocks.size( ); ++i )
+		delete[] m_vBlocks[ i ];
+}
+
+/*********************************************************************\
+ *	Public Use Functions											 *
+\*********************************************************************/
+
+// Returns the slot of a name, giving it the next free slot if it is new.
+//	Parameters:
+//		sName : String - The name, not NUL terminated.
+//		iLength : size_t - Length of the name.
+//	Returns:
+//		The name's slot.
+//////////////////////////////////////////////////////////////////////
+unsigned int VariableTable::intern( const char* sName, size_t iLength )
+{
+	uint32_t iHash = hash_Name( sName, iLength );
+	size_t iMask = m_vIndex.size( ) - 1;
+	size_t iBucket = iHash & iMask;
+	Name oName;
+
+	for( ; m_vIndex[ iBucket ] != 0; iBucket = ( iBucket + 1 ) & iMask )
+	{
+		const Name& oEntry = m_vNames[ m_vIndex[ iBucket ] - 1 ];
+
+		if( oEntry.iHash == iHash && oEntry.iLength == iLength && !memcmp( oEntry.sText, sName, iLength ) )
+			return m_vIndex[ iBucket ] - 1;
+	}
+
+	oName.sText = store_Name( sName, iLength );
+	oName.iLength = (uint32_t) iLength;
+	oName.iHash = iHash;
+	m_vNames.push_back( oName );
+	m_vIndex[ iBucket ] = (uint32_t) m_vNames.size( );
+
+	// Keep the index at most half full.
+	if( m_vNames.size( ) * 2 > m_vIndex.size( ) )
+		grow_Index( );
+
+	return (unsigned int)( m_vNames.size( ) - 1 );
+}
+
+// Looks a name up without adding it.
+//	Returns:
+//		False if the name has no slot.
+//////////////////////////////////////////////////////////////////////
+bool VariableTable::find( const char* sName, size_t iLength, unsigned int& iSlot ) const
+{
+	uint32_t iHash = hash_Name( sName, iLength );
+	size_t iMask = m_vIndex.size( ) - 1;
+
+	for( size_t iBucket = iHash & iMask; m_vIndex[ iBucket ] != 0; iBucket = ( iBucket + 1 ) & iMask )
+	{
+		const Name& oEntry = m_vNames[ m_vIndex[ iBucket ] - 1 ];
+
+		if( oEntry.iHash == iHash && oEntry.iLength == iLength && !memcmp( oEntry.sText, sName, iLength ) )
+		{
+			iSlot = m_vIndex[ iBucket ] - 1;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Returns the name of a slot.
+const char* VariableTable::get_Name( unsigned int iSlot ) const
+{
+	return m_vNames[ iSlot ].sText;
+}
+
+// Returns the number of slots handed out, including the memory's.
+unsigned int VariableTable::size( ) const
+{
+	return (unsigned int) m_vNames.size( );
+}
+
+// Returns the id that sets this table apart from every other one in the
+// process, for caches of compiled code.
+unsigned long long VariableTable::get_Id( ) const
+{
+	return m_iId;
+}
+
+/*********************************************************************\
+ *	Private Functions												 *
+\*********************************************************************/
+
+// Copies a name into the current block, starting a new one when it is
+// full.  Names longer than a block get a block of their own.
+const char* VariableTable::store_Name( const char* sName, size_t iLength )
+{
+	char* pText = NULL;
+
+	if( iLength + 1 > m_iFreeBytes )
+	{
+		size_t iBlockSize = m_vBlocks.empty( ) ? VARIABLE_FIRST_BLOCK : VARIABLE_NAME_BLOCK;
+
+		if( iLength + 1 > iBlockSize )
+			iBlockSize = iLength + 1;
+
+		m_vBlocks.push_back( new char[ iBlockSize ] );
+		m_pFree = m_vBlocks.back( );
+		m_iFreeBytes = iBlockSize;
+	}
+
+	pText = m_pFree;
+	memcpy( pText, sName, iLength );
+	pText[ iLength ] = '\0';
+	m_pFree += iLength + 1;
+	m_iFreeBytes -= iLength + 1;
+
+	return pText;
+}
+
+// Doubles the index, placing every slot again from its saved hash.
+void VariableTable::grow_Index( )
+{
+	std::vector< uint32_t > vIndex( m_vIndex.size( ) * 2, 0 );
+	size_t iMask = vIndex.size( ) - 1;
+
+	for( size_t i = 0; i < m_vNames.size( ); ++i )
+	{
+		size_t iBucket = m_vNames[ i ].iHash & iMask;
+
+		while( vIndex[ iBucket ] != 0 )
+			iBucket = ( iBucket + 1 ) & iMask;
+
+		vIndex[ iBucket ] = (uint32_t)( i + 1 );
+	}
+
+	m_vIndex.swap( vIndex );
+}
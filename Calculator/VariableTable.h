@@ -0,0 +1,71 @@
+#ifndef _VARIABLETABLE_H
+#define _VARIABLETABLE_H
+
+// Name: VariableTable.h
+// Description: Interns variable names into dense slot numbers.  Parsers
+//				resolve a name once, when a line is parsed, and the code
+//				they produce carries only the slot, so evaluation indexes
+//				the calculator's register file directly and never looks at
+//				a name.  Slot 0 is the memory, named "mem".
+//
+//				Names are copied into large blocks that are never freed or
+//				moved until the table is destroyed, so a name costs its
+//				length plus a few bytes of index, and a table can hold
+//				millions of them without an allocation per name.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+#define VARIABLE_MEMORY_SLOT	0
+#define VARIABLE_MEMORY_NAME	"mem"
+#define VARIABLE_NAME_BLOCK		65536		// Bytes per block of name storage
+#define VARIABLE_FIRST_BLOCK	256			// Bytes of the first block, so a table of few names stays small
+#define VARIABLE_MIN_INDEX		64			// Smallest hash index, a power of two
+
+///////////////////////////////
+// VariableTable Declaration //
+///////////////////////////////
+class VariableTable
+{
+public:
+	VariableTable( );
+	~VariableTable( );
+
+	unsigned int intern( const char* sName, size_t iLength );
+	bool find( const char* sName, size_t iLength, unsigned int& iSlot ) const;
+	const char* get_Name( unsigned int iSlot ) const;
+	unsigned int size( ) const;
+	unsigned long long get_Id( ) const;
+
+private:
+	VariableTable( const VariableTable& );
+	VariableTable& operator=( const VariableTable& );
+
+	struct Name
+	{
+		const char* sText;			// Points into a block, NUL terminated
+		uint32_t iLength;
+		uint32_t iHash;
+	};
+
+	const char* store_Name( const char* sName, size_t iLength );
+	void grow_Index( );
+
+	std::vector< Name > m_vNames;			// By slot
+	std::vector< uint32_t > m_vIndex;		// Open addressing, slot + 1, 0 if empty
+	std::vector< char* > m_vBlocks;
+	char* m_pFree;							// Next free byte in the last block
+	size_t m_iFreeBytes;
+	unsigned long long m_iId;
+};
+
+#endif
@@ -0,0 +1,364 @@
+//////////////
+// Includes //
+//////////////
+#include "AffineScan.h"
+#include "FpCheck.h"
+#include <cfloat>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Returns gamma(k) = k*u / (1 - k*u), the usual bound on the relative error
+// of k roundings.
+static double gamma_Bound( double dRoundings )
+{
+	double dKU = dRoundings * ( DBL_EPSILON / 2.0 );
+
+	return dKU < 1.0 ? dKU / ( 1.0 - dKU ) : HUGE_VAL;
+}
+
+// Returns true if the operation cannot be folded into an affine map.
+static inline bool breaks_Chain( const Operation& oOperation )
+{
+	if( oOperation.cOpCode == OP_CODE_STORE || op_UsesMem( oOperation.cOpCode ) ||
+		op_TouchesVar( oOperation.cOpCode ) )
+		return true;
+
+	if( !is_Operator( (char) oOperation.cOpCode ) )
+		return false;
+
+	if( !get_Operator( (char) oOperation.cOpCode ).bAffine )
+		return true;
+
+	AffineMap oMap = AffineScan::to_Map( oOperation );
+
+	return oMap.dScale == 0.0 || !isfinite( oMap.dScale ) || !isfinite( oMap.dOffset );
+}
+
+// Returns true if the calculator would count the operation's dValue in its
+// operand statistics: the operand of a binary operator, or a set.
+static inline bool has_Operand( const Operation& oOperation )
+{
+	return oOperation.cOpCode == OP_CODE_SET ||
+		   ( is_Operator( (char) oOperation.cOpCode ) && get_Operator( (char) oOperation.cOpCode ).iArity == 2 );
+}
+
+/*********************************************************************\
+ *	Constructor														 *
+\*********************************************************************/
+
+// Creates a scan evaluator.
+//	Parameters:
+//		iThreadCount : unsigned int - Threads to use, 0 for one per core.
+//		iMinParallelLength : size_t - Runs shorter than this are evaluated
+//									  serially.
+//////////////////////////////////////////////////////////////////////
+AffineScan::AffineScan( unsigned int iThreadCount, size_t iMinParallelLength )
+{
+	if( iThreadCount == 0 )
+		iThreadCount = thread::hardware_concurrency( );
+
+	m_iThreadCount = iThreadCount > 0 ? iThreadCount : 1;
+	m_iMinParallelLength = iMinParallelLength > m_iThreadCount ? iMinParallelLength : m_iThreadCount;
+	m_dErrorBound = 0.0;
+	m_iFpFlags = 0;
+}
+
+/*********************************************************************\
+ *	Affine Maps														 *
+\*********************************************************************/
+
+// Returns the map an operation applies to the working value.  Operations
+// that break the chain are never passed in here.  Offsets that would be
+// zero are -0.0, as x + -0.0 is x even for a negative zero.
+AffineMap AffineScan::to_Map( const Operation& oOperation )
+{
+	AffineMap oMap = { 1.0, -0.0, false };
+
+	switch( oOperation.cOpCode )
+	{
+	case OP_CODE_RESET:
+		oMap.dScale = 0.0;
+		oMap.dOffset = 0.0;
+		oMap.bConstant = true;
+		break;
+	case OP_CODE_SET:
+		oMap.dScale = 0.0;
+		oMap.dOffset = oOperation.dValue;
+		oMap.bConstant = true;
+		break;
+	default:
+		dispatch_Operator( (char) oOperation.cOpCode, [ & ]( auto oOperator )
+		{
+			typedef decltype( oOperator ) OPERATOR;
+
+			if constexpr( OPERATOR::bAffine )
+				OPERATOR::get_Map( oOperation.dValue, oMap.dScale, oMap.dOffset );
+		} );
+		break;
+	}
+
+	return oMap;
+}
+
+// Returns the map that applies oFirst, then oSecond.  A constant map
+// (a reset or set) discards everything before it, even infinities and NaNs.
+// Any other map keeps its input, even when its scale is zero.
+AffineMap AffineScan::compose( const AffineMap& oFirst, const AffineMap& oSecond )
+{
+	if( oSecond.bConstant )
+		return oSecond;
+
+	AffineMap oResult = { 0.0, oSecond.dScale * oFirst.dOffset + oSecond.dOffset, oFirst.bConstant };
+
+	if( !oFirst.bConstant )
+		oResult.dScale = oSecond.dScale * oFirst.dScale;
+
+	return oResult;
+}
+
+// Applies a map to a working value.
+double AffineScan::apply( const AffineMap& oMap, double dValue )
+{
+	return oMap.bConstant ? oMap.dOffset : oMap.dScale * dValue + oMap.dOffset;
+}
+
+/*********************************************************************\
+ *	Public Use Functions											 *
+\*********************************************************************/
+
+// Applies a stream of operations to the calculator.
+//	Parameters:
+//		pOperations : Operation* - The operations to apply, in order.
+//		iCount : size_t - Number of operations.
+//		m_Calculator : Calculator - Calculator to apply them to.
+//////////////////////////////////////////////////////////////////////
+void AffineScan::evaluate( const Operation* pOperations, size_t iCount,
+						   Calculator* const m_Calculator )
+{
+	evaluate_Stream( pOperations, iCount, m_Calculator, NULL );
+}
+
+// Applies a stream of operations to the calculator and records the working
+// value after every operation.  Intermediate values are filled in by a
+// second parallel pass that replays each chunk serially from its start
+// value, so they carry the error of the chunk start values only.
+//	Parameters:
+//		pValues : double* - Receives iCount working values.
+//////////////////////////////////////////////////////////////////////
+void AffineScan::evaluate_All( const Operation* pOperations, size_t iCount,
+							   Calculator* const m_Calculator, double* pValues )
+{
+	evaluate_Stream( pOperations, iCount, m_Calculator, pValues );
+}
+
+// Returns the error bound of the last evaluation, see the class notes.
+double AffineScan::get_Error_Bound( ) const
+{
+	return m_dErrorBound;
+}
+
+// Returns the floating-point exception flags raised on worker threads by
+// every evaluation so far, see the class notes.
+int AffineScan::get_Fp_Flags( ) const
+{
+	return m_iFpFlags;
+}
+
+// Returns the number of threads used for parallel runs.
+unsigned int AffineScan::get_Thread_Count( ) const
+{
+	return m_iThreadCount;
+}
+
+/*********************************************************************\
+ *	Private Functions												 *
+\*********************************************************************/
+
+// Splits the stream at operations that break the chain.
+void AffineScan::evaluate_Stream( const Operation* pOperations, size_t iCount,
+								  Calculator* const m_Calculator, double* pValues )
+{
+	size_t iRunStart = 0;
+	double dOperand = 0.0;
+
+	m_dErrorBound = 0.0;
+
+	for( size_t i = 0; i < iCount; ++i )
+	{
+		if( !breaks_Chain( pOperations[ i ] ) )
+			continue;
+
+		evaluate_Run( pOperations + iRunStart, i - iRunStart, m_Calculator,
+					  pValues != NULL ? pValues + iRunStart : NULL );
+
+		// Carry the bound through the serial operation.
+		if( op_UsesMem( pOperations[ i ].cOpCode ) || op_UsesVar( pOperations[ i ].cOpCode ) )
+		{
+			dOperand = fabs( op_UsesMem( pOperations[ i ].cOpCode ) ? m_Calculator->pull_Mem( )
+																	 : m_Calculator->pull_Var( pOperations[ i ].iSlot ) );
+
+			if( op_Operator( pOperations[ i ].cOpCode ) == '*' )
+				m_dErrorBound *= dOperand;
+			else if( op_Operator( pOperations[ i ].cOpCode ) == '/' )
+				m_dErrorBound /= dOperand;
+		}
+		else if( is_Operator( (char) pOperations[ i ].cOpCode ) && m_dErrorBound != 0.0 )
+			m_dErrorBound *= fabs( to_Map( pOperations[ i ] ).dScale );
+
+		m_Calculator->apply_Operation( pOperations[ i ] );
+
+		if( pValues != NULL )
+			pValues[ i ] = m_Calculator->read_Value( );
+
+		iRunStart = i + 1;
+	}
+
+	evaluate_Run( pOperations + iRunStart, iCount - iRunStart, m_Calculator,
+				  pValues != NULL ? pValues + iRunStart : NULL );
+}
+
+// Evaluates a run of affine operations, in parallel if it is long enough.
+void AffineScan::evaluate_Run( const Operation* pOperations, size_t iCount,
+							   Calculator* const m_Calculator, double* pValues )
+{
+	if( iCount < m_iMinParallelLength || m_iThreadCount == 1 )
+	{
+		for( size_t i = 0; i < iCount; ++i )
+		{
+			m_Calculator->apply_Operation( pOperations[ i ] );
+
+			if( pValues != NULL )
+				pValues[ i ] = m_Calculator->read_Value( );
+		}
+
+		return;
+	}
+
+	const unsigned int iChunkCount = m_iThreadCount;
+	const size_t iChunkSize = ( iCount + iChunkCount - 1 ) / iChunkCount;
+	vector< AffineMap > vMaps( iChunkCount );
+	vector< AffineMap > vAbsMaps( iChunkCount );
+	vector< double > vStartValues( iChunkCount );
+	vector< int > vFpFlags( iChunkCount, 0 );
+	vector< unique_ptr< OperandStats > > vStats( iChunkCount );
+	OperandStats* pStats = m_Calculator->get_Stats( );
+	vector< thread > vThreads;
+	AffineMap oAbsTotal = { 1.0, 0.0, false };
+	double dValue = m_Calculator->read_Value( );
+	double dStartMagnitude = fabs( dValue );
+
+	// Pass 1: reduce every chunk to a single map, and the same map over
+	// absolute values for the error bound.  Operand statistics are kept per
+	// chunk and merged after, which is exact, so they don't depend on the
+	// number of chunks.
+	for( unsigned int t = 0; t < iChunkCount; ++t )
+	{
+		if( pStats != NULL )
+			vStats[ t ].reset( new OperandStats );
+
+		vThreads.push_back( thread( [=, &vMaps, &vAbsMaps, &vFpFlags, &vStats]( )
+		{
+			clear_Fp_Flags( );
+
+			size_t iBegin = t * iChunkSize;
+			size_t iEnd = iBegin + iChunkSize < iCount ? iBegin + iChunkSize : iCount;
+			AffineMap oMap = { 1.0, -0.0, false };
+			AffineMap oAbsMap = { 1.0, 0.0, false };
+
+			for( size_t i = iBegin; i < iEnd; ++i )
+			{
+				AffineMap oStep = to_Map( pOperations[ i ] );
+				AffineMap oAbsStep = { fabs( oStep.dScale ), fabs( oStep.dOffset ), oStep.bConstant };
+
+				oMap = compose( oMap, oStep );
+				oAbsMap = compose( oAbsMap, oAbsStep );
+			}
+
+			if( vStats[ t ] )
+			{
+				double aOperands[ AFFINE_SCAN_STATS_BLOCK ];
+				size_t iOperands = 0;
+
+				for( size_t i = iBegin; i < iEnd; ++i )
+				{
+					if( !has_Operand( pOperations[ i ] ) )
+						continue;
+
+					aOperands[ iOperands++ ] = pOperations[ i ].dValue;
+
+					if( iOperands == AFFINE_SCAN_STATS_BLOCK )
+					{
+						vStats[ t ]->add_Values( aOperands, iOperands );
+						iOperands = 0;
+					}
+				}
+
+				vStats[ t ]->add_Values( aOperands, iOperands );
+			}
+
+			vMaps[ t ] = oMap;
+			vAbsMaps[ t ] = oAbsMap;
+			vFpFlags[ t ] |= test_Fp_Flags( );
+		} ) );
+	}
+
+	for( unsigned int t = 0; t < iChunkCount; ++t )
+		vThreads[ t ].join( );
+
+	vThreads.clear( );
+
+	for( unsigned int t = 0; t < iChunkCount && pStats != NULL; ++t )
+		pStats->merge( *vStats[ t ] );
+
+	// Combine: walk the chunk maps to get every chunk's start value.
+	for( unsigned int t = 0; t < iChunkCount; ++t )
+	{
+		vStartValues[ t ] = dValue;
+		dValue = apply( vMaps[ t ], dValue );
+		oAbsTotal = compose( oAbsTotal, vAbsMaps[ t ] );
+	}
+
+	m_dErrorBound = m_dErrorBound * oAbsTotal.dScale
+				  + gamma_Bound( 3.0 * (double) iCount )
+				  * ( oAbsTotal.dScale * dStartMagnitude + oAbsTotal.dOffset );
+
+	// Pass 2: replay every chunk serially from its start value.
+	if( pValues != NULL )
+	{
+		for( unsigned int t = 0; t < iChunkCount; ++t )
+		{
+			vThreads.push_back( thread( [=, &vStartValues, &vFpFlags]( )
+			{
+				clear_Fp_Flags( );
+
+				size_t iBegin = t * iChunkSize;
+				size_t iEnd = iBegin + iChunkSize < iCount ? iBegin + iChunkSize : iCount;
+				Calculator oChunk;
+
+				oChunk.set_Value( vStartValues[ t ] );
+
+				for( size_t i = iBegin; i < iEnd; ++i )
+				{
+					oChunk.apply_Operation( pOperations[ i ] );
+					pValues[ i ] = oChunk.read_Value( );
+				}
+
+				vFpFlags[ t ] |= test_Fp_Flags( );
+			} ) );
+		}
+
+		for( unsigned int t = 0; t < iChunkCount; ++t )
+			vThreads[ t ].join( );
+
+		dValue = pValues[ iCount - 1 ];
+	}
+
+	for( unsigned int t = 0; t < iChunkCount; ++t )
+		m_iFpFlags |= vFpFlags[ t ];
+
+	m_Calculator->set_Value( dValue );
+}
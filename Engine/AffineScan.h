@@ -0,0 +1,96 @@
+#ifndef _AFFINESCAN_H
+#define _AFFINESCAN_H
+
+// Name: AffineScan.h
+// Description: Parallel evaluator for long operation streams.  Every
+//				affine operator ('+', '-', '*', '/') with a constant, every
+//				reset and set maps the working value as x -> a*x + b.
+//				Composing those maps is associative, so a stream can be split into chunks that
+//				are each reduced to one map on their own thread.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "../Calculator/Calculator.h"
+#include <cstddef>
+
+/////////////
+// Defines //
+/////////////
+#define AFFINE_SCAN_MIN_PARALLEL ( 1 << 16 )	// Shorter runs are evaluated serially
+#define AFFINE_SCAN_STATS_BLOCK	256			// Operands gathered per OperandStats::add_Values
+
+// x -> dScale * x + dOffset, or x -> dOffset if bConstant
+struct AffineMap
+{
+	double dScale;
+	double dOffset;
+	bool bConstant;		// A reset or set: the working value is discarded
+};
+
+/////////////////////////////
+// AffineScan Declaration  //
+/////////////////////////////
+// Floating-point tolerance:
+//	Runs of at least AFFINE_SCAN_MIN_PARALLEL operations are evaluated by
+//	composing maps, which rounds in a different order than the serial loop
+//	and turns '/ v' into '* (1/v)'.  For such a run of n operations starting
+//	from x0, the difference from the serial result is bounded by
+//		gamma(3n) * ( |A| * |x0| + |B| ),	gamma(k) = k*u / (1 - k*u)
+//	where u = DBL_EPSILON / 2 and (|A|, |B|) is the composition of the maps
+//	with every coefficient replaced by its absolute value.  get_Error_Bound
+//	returns this bound for the last evaluation, accumulated over all of its
+//	parallel runs.  Shorter runs are evaluated serially and are exact.
+//
+//	Serial fallback:
+//	Stores and "mem" and variable operands are not affine in the working
+//	value, so they split the stream.  They are applied serially through the Calculator and
+//	the runs between them are evaluated in parallel when they are long enough.
+//	Operators whose map has a zero or non-finite coefficient ('* 0', '/ inf',
+//	'+ nan', ...) split it too: the composed map can't give the NaN or the
+//	signed zero the serial loop gets from them, so they are applied serially.
+//	The bound treats memory and variable operands as exact.
+//
+//	Operand statistics:
+//	If the calculator keeps them, every operand is counted once, whether its
+//	run was evaluated serially or in parallel.
+//
+//	Floating-point exceptions:
+//	Flags raised on the worker threads are collected when they finish and
+//	returned by get_Fp_Flags, since they would otherwise be lost with the
+//	thread.  Composing maps can overflow where the serial loop doesn't, so
+//	a raised flag only says the stream needs checking serially.
+class AffineScan
+{
+public:
+	AffineScan( unsigned int iThreadCount = 0,
+				size_t iMinParallelLength = AFFINE_SCAN_MIN_PARALLEL );
+
+	void evaluate( const Operation* pOperations, size_t iCount,
+				   Calculator* const m_Calculator );
+	void evaluate_All( const Operation* pOperations, size_t iCount,
+					   Calculator* const m_Calculator, double* pValues );
+
+	double get_Error_Bound( ) const;
+	unsigned int get_Thread_Count( ) const;
+	int get_Fp_Flags( ) const;
+
+	static AffineMap to_Map( const Operation& oOperation );
+	static AffineMap compose( const AffineMap& oFirst, const AffineMap& oSecond );
+	static double apply( const AffineMap& oMap, double dValue );
+
+private:
+	void evaluate_Stream( const Operation* pOperations, size_t iCount,
+						  Calculator* const m_Calculator, double* pValues );
+	void evaluate_Run( const Operation* pOperations, size_t iCount,
+					   Calculator* const m_Calculator, double* pValues );
+
+	unsigned int m_iThreadCount;
+	size_t m_iMinParallelLength;
+	double m_dErrorBound;
+	int m_iFpFlags;
+};
+
+#endif
@@ -0,0 +1,706 @@
+//////////////
+// Includes //
+//////////////
+#include "CalculatorBank.h"
+#include "../Calculator/OperatorRegistry.h"
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#define BANK_HAS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only let a function use AVX intrinsics when it is compiled
+// for that instruction set, so the SIMD kernels are tagged one by one and
+// the rest of the program stays baseline x86.
+#if defined( __GNUC__ )
+#define BANK_TARGET_AVX2	__attribute__(( target( "avx2" ) ))
+#define BANK_TARGET_AVX512	__attribute__(( target( "avx512f" ) ))
+#else
+#define BANK_TARGET_AVX2
+#define BANK_TARGET_AVX512
+#endif
+
+/*********************************************************************\
+ *	Kernels															 *
+\*********************************************************************/
+
+// Signatures shared by every kernel set.
+typedef void ( *BroadcastKernel )( double* pValues, double dOperand, size_t iCount );
+typedef void ( *LaneKernel )( double* pValues, const double* pOperands, size_t iCount );
+typedef void ( *FillKernel )( double* pDest, double dValue, size_t iCount );
+typedef void ( *NegateKernel )( double* pValues, size_t iCount );
+
+// Operator kernels are indexed by OperatorInfo::iIndex.
+struct BankKernels
+{
+	std::array< BroadcastKernel, CalculatorOperators::iCount > aBroadcast;
+	std::array< LaneKernel, CalculatorOperators::iCount > aLanes;
+	LaneKernel pCopy;					// pValues = pOperands
+	FillKernel pFill;
+	NegateKernel pNegate;
+	eBankKernel eKernel;
+	const char* sName;
+};
+
+// Index of an operator in the kernel tables, -1 if it isn't one.
+static inline int get_Operator_Index( char cOperator )
+{
+	return is_Operator( cOperator ) ? get_Operator( cOperator ).iIndex : -1;
+}
+
+// Operators that have an instruction of their own.  The SIMD kernels of any
+// other operator run its scalar kernel on every lane.
+template< class OPERATOR > struct VectorForm { static constexpr bool bExists = false; };
+template<> struct VectorForm< OperatorAdd > { static constexpr bool bExists = true; };
+template<> struct VectorForm< OperatorSubtract > { static constexpr bool bExists = true; };
+template<> struct VectorForm< OperatorMultiply > { static constexpr bool bExists = true; };
+template<> struct VectorForm< OperatorDivide > { static constexpr bool bExists = true; };
+
+// Scalar kernels, the operators' own, the same as
+// Calculator::process_Calculation.
+template< class OPERATOR >
+struct BroadcastScalar
+{
+	static void run( double* pValues, double dOperand, size_t iCount )
+	{
+		for( size_t i = 0; i < iCount; ++i )
+			pValues[ i ] = OPERATOR::apply( pValues[ i ], dOperand );
+	}
+};
+
+template< class OPERATOR >
+struct LanesScalar
+{
+	static void run( double* pValues, const double* pOperands, size_t iCount )
+	{
+		for( size_t i = 0; i < iCount; ++i )
+			pValues[ i ] = OPERATOR::apply( pValues[ i ], pOperands[ i ] );
+	}
+};
+
+static void copy_Scalar( double* pDest, const double* pSource, size_t iCount )
+{
+	memcpy( pDest, pSource, iCount * sizeof( double ) );
+}
+
+static void fill_Scalar( double* pDest, double dValue, size_t iCount )
+{
+	for( size_t i = 0; i < iCount; ++i )
+		pDest[ i ] = dValue;
+}
+
+static void negate_Scalar( double* pValues, size_t iCount )
+{
+	for( size_t i = 0; i < iCount; ++i )
+		pValues[ i ] = -pValues[ i ];
+}
+
+static const BankKernels oSCALAR_KERNELS =
+{
+	CalculatorOperators::make_Kernels< BroadcastKernel, BroadcastScalar >( ),
+	CalculatorOperators::make_Kernels< LaneKernel, LanesScalar >( ),
+	copy_Scalar,
+	fill_Scalar,
+	negate_Scalar,
+	BANK_KERNEL_SCALAR,
+	"scalar"
+};
+
+#ifdef BANK_HAS_X86
+
+// AVX2 kernels, 4 lanes per instruction.  The bank's own arrays are
+// aligned; operands passed in by the caller may not be.
+template< class OPERATOR > BANK_TARGET_AVX2 static inline __m256d apply_Avx2( __m256d vValue, __m256d vOperand );
+template<> BANK_TARGET_AVX2 inline __m256d apply_Avx2< OperatorAdd >( __m256d vValue, __m256d vOperand ) { return _mm256_add_pd( vValue, vOperand ); }
+template<> BANK_TARGET_AVX2 inline __m256d apply_Avx2< OperatorSubtract >( __m256d vValue, __m256d vOperand ) { return _mm256_sub_pd( vValue, vOperand ); }
+template<> BANK_TARGET_AVX2 inline __m256d apply_Avx2< OperatorMultiply >( __m256d vValue, __m256d vOperand ) { return _mm256_mul_pd( vValue, vOperand ); }
+template<> BANK_TARGET_AVX2 inline __m256d apply_Avx2< OperatorDivide >( __m256d vValue, __m256d vOperand ) { return _mm256_div_pd( vValue, vOperand ); }
+
+template< class OPERATOR >
+struct BroadcastAvx2
+{
+	BANK_TARGET_AVX2
+	static void run( double* pValues, double dOperand, size_t iCount )
+	{
+		size_t i = 0;
+
+		if constexpr( VectorForm< OPERATOR >::bExists )
+		{
+			__m256d vOperand = _mm256_set1_pd( dOperand );
+
+			for( ; i + 4 <= iCount; i += 4 )
+				_mm256_store_pd( pValues + i, apply_Avx2< OPERATOR >( _mm256_load_pd( pValues + i ), vOperand ) );
+		}
+
+		for( ; i < iCount; ++i )
+			pValues[ i ] = OPERATOR::apply( pValues[ i ], dOperand );
+	}
+};
+
+template< class OPERATOR >
+struct LanesAvx2
+{
+	BANK_TARGET_AVX2
+	static void run( double* pValues, const double* pOperands, size_t iCount )
+	{
+		size_t i = 0;
+
+		if constexpr( VectorForm< OPERATOR >::bExists )
+		{
+			for( ; i + 4 <= iCount; i += 4 )
+				_mm256_store_pd( pValues + i, apply_Avx2< OPERATOR >( _mm256_load_pd( pValues + i ),
+																	  _mm256_loadu_pd( pOperands + i ) ) );
+		}
+
+		for( ; i < iCount; ++i )
+			pValues[ i ] = OPERATOR::apply( pValues[ i ], pOperands[ i ] );
+	}
+};
+
+BANK_TARGET_AVX2
+static void copy_Avx2( double* pDest, const double* pSource, size_t iCount )
+{
+	size_t i = 0;
+
+	for( ; i + 4 <= iCount; i += 4 )
+		_mm256_storeu_pd( pDest + i, _mm256_loadu_pd( pSource + i ) );
+
+	for( ; i < iCount; ++i )
+		pDest[ i ] = pSource[ i ];
+}
+
+BANK_TARGET_AVX2
+static void fill_Avx2( double* pDest, double dValue, size_t iCount )
+{
+	__m256d vValue = _mm256_set1_pd( dValue );
+	size_t i = 0;
+
+	for( ; i + 4 <= iCount; i += 4 )
+		_mm256_storeu_pd( pDest + i, vValue );
+
+	for( ; i < iCount; ++i )
+		pDest[ i ] = dValue;
+}
+
+// Negation only flips the sign bit, as the scalar -x does, so NaNs and
+// zeroes come out the same.
+BANK_TARGET_AVX2
+static void negate_Avx2( double* pValues, size_t iCount )
+{
+	__m256d vSign = _mm256_set1_pd( -0.0 );
+	size_t i = 0;
+
+	for( ; i + 4 <= iCount; i += 4 )
+		_mm256_store_pd( pValues + i, _mm256_xor_pd( _mm256_load_pd( pValues + i ), vSign ) );
+
+	for( ; i < iCount; ++i )
+		pValues[ i ] = -pValues[ i ];
+}
+
+static const BankKernels oAVX2_KERNELS =
+{
+	CalculatorOperators::make_Kernels< BroadcastKernel, BroadcastAvx2 >( ),
+	CalculatorOperators::make_Kernels< LaneKernel, LanesAvx2 >( ),
+	copy_Avx2,
+	fill_Avx2,
+	negate_Avx2,
+	BANK_KERNEL_AVX2,
+	"avx2"
+};
+
+// AVX-512 kernels, 8 lanes per instruction.
+template< class OPERATOR > BANK_TARGET_AVX512 static inline __m512d apply_Avx512( __m512d vValue, __m512d vOperand );
+template<> BANK_TARGET_AVX512 inline __m512d apply_Avx512< OperatorAdd >( __m512d vValue, __m512d vOperand ) { return _mm512_add_pd( vValue, vOperand ); }
+template<> BANK_TARGET_AVX512 inline __m512d apply_Avx512< OperatorSubtract >( __m512d vValue, __m512d vOperand ) { return _mm512_sub_pd( vValue, vOperand ); }
+template<> BANK_TARGET_AVX512 inline __m512d apply_Avx512< OperatorMultiply >( __m512d vValue, __m512d vOperand ) { return _mm512_mul_pd( vValue, vOperand ); }
+template<> BANK_TARGET_AVX512 inline __m512d apply_Avx512< OperatorDivide >( __m512d vValue, __m512d vOperand ) { return _mm512_div_pd( vValue, vOperand ); }
+
+template< class OPERATOR >
+struct BroadcastAvx512
+{
+	BANK_TARGET_AVX512
+	static void run( double* pValues, double dOperand, size_t iCount )
+	{
+		size_t i = 0;
+
+		if constexpr( VectorForm< OPERATOR >::bExists )
+		{
+			__m512d vOperand = _mm512_set1_pd( dOperand );
+
+			for( ; i + 8 <= iCount; i += 8 )
+				_mm512_store_pd( pValues + i, apply_Avx512< OPERATOR >( _mm512_load_pd( pValues + i ), vOperand ) );
+		}
+
+		for( ; i < iCount; ++i )
+			pValues[ i ] = OPERATOR::apply( pValues[ i ], dOperand );
+	}
+};
+
+template< class OPERATOR >
+struct LanesAvx512
+{
+	BANK_TARGET_AVX512
+	static void run( double* pValues, const double* pOperands, size_t iCount )
+	{
+		size_t i = 0;
+
+		if constexpr( VectorForm< OPERATOR >::bExists )
+		{
+			for( ; i + 8 <= iCount; i += 8 )
+				_mm512_store_pd( pValues + i, apply_Avx512< OPERATOR >( _mm512_load_pd( pValues + i ),
+																		_mm512_loadu_pd( pOperands + i ) ) );
+		}
+
+		for( ; i < iCount; ++i )
+			pValues[ i ] = OPERATOR::apply( pValues[ i ], pOperands[ i ] );
+	}
+};
+
+BANK_TARGET_AVX512
+static void copy_Avx512( double* pDest, const double* pSource, size_t iCount )
+{
+	size_t i = 0;
+
+	for( ; i + 8 <= iCount; i += 8 )
+		_mm512_storeu_pd( pDest + i, _mm512_loadu_pd( pSource + i ) );
+
+	for( ; i < iCount; ++i )
+		pDest[ i ] = pSource[ i ];
+}
+
+BANK_TARGET_AVX512
+static void fill_Avx512( double* pDest, double dValue, size_t iCount )
+{
+	__m512d vValue = _mm512_set1_pd( dValue );
+	size_t i = 0;
+
+	for( ; i + 8 <= iCount; i += 8 )
+		_mm512_storeu_pd( pDest + i, vValue );
+
+	for( ; i < iCount; ++i )
+		pDest[ i ] = dValue;
+}
+
+// The double form of xor needs AVX-512DQ, so the sign is flipped in the
+// integer domain.
+BANK_TARGET_AVX512
+static void negate_Avx512( double* pValues, size_t iCount )
+{
+	__m512i vSign = _mm512_set1_epi64( (long long) 0x8000000000000000ULL );
+	size_t i = 0;
+
+	for( ; i + 8 <= iCount; i += 8 )
+		_mm512_store_pd( pValues + i, _mm512_castsi512_pd(
+			_mm512_xor_si512( _mm512_castpd_si512( _mm512_load_pd( pValues + i ) ), vSign ) ) );
+
+	for( ; i < iCount; ++i )
+		pValues[ i ] = -pValues[ i ];
+}
+
+static const BankKernels oAVX512_KERNELS =
+{
+	CalculatorOperators::make_Kernels< BroadcastKernel, BroadcastAvx512 >( ),
+	CalculatorOperators::make_Kernels< LaneKernel, LanesAvx512 >( ),
+	copy_Avx512,
+	fill_Avx512,
+	negate_Avx512,
+	BANK_KERNEL_AVX512,
+	"avx512"
+};
+
+#endif // BANK_HAS_X86
+
+/*********************************************************************\
+ *	CPU Detection													 *
+\*********************************************************************/
+
+// Returns true if the CPU (and OS) can run the given kernel set.
+static bool cpu_Supports( eBankKernel eKernel )
+{
+	switch( eKernel )
+	{
+	case BANK_KERNEL_SCALAR:
+		return true;
+#ifdef BANK_HAS_X86
+#if defined( __GNUC__ )
+	case BANK_KERNEL_AVX2:
+		return __builtin_cpu_supports( "avx2" ) != 0;
+	case BANK_KERNEL_AVX512:
+		return __builtin_cpu_supports( "avx512f" ) != 0;
+#elif defined( _MSC_VER )
+	case BANK_KERNEL_AVX2:
+	case BANK_KERNEL_AVX512:
+	{
+		int aInfo[ 4 ];
+		bool bOSSaves = false;
+
+		// The OS has to save the wide registers (XCR0) for either set.
+		__cpuid( aInfo, 1 );
+
+		if( !( aInfo[ 2 ] & ( 1 << 27 ) ) )
+			return false;
+
+		unsigned long long iXCR0 = _xgetbv( 0 );
+		__cpuidex( aInfo, 7, 0 );
+
+		if( eKernel == BANK_KERNEL_AVX2 )
+			bOSSaves = ( iXCR0 & 0x6 ) == 0x6 && ( aInfo[ 1 ] & ( 1 << 5 ) );
+		else
+			bOSSaves = ( iXCR0 & 0xE6 ) == 0xE6 && ( aInfo[ 1 ] & ( 1 << 16 ) );
+
+		return bOSSaves;
+	}
+#endif
+#endif
+	default:
+		return false;
+	}
+}
+
+// Returns the kernel table for a set the CPU supports.
+static const BankKernels* get_Kernel_Table( eBankKernel eKernel )
+{
+	switch( eKernel )
+	{
+#ifdef BANK_HAS_X86
+	case BANK_KERNEL_AVX512:
+		return &oAVX512_KERNELS;
+	case BANK_KERNEL_AVX2:
+		return &oAVX2_KERNELS;
+#endif
+	default:
+		return &oSCALAR_KERNELS;
+	}
+}
+
+// Picks the best kernel set once, the first time a bank needs it.
+static const BankKernels* detect_Kernels( )
+{
+	if( cpu_Supports( BANK_KERNEL_AVX512 ) )
+		return get_Kernel_Table( BANK_KERNEL_AVX512 );
+
+	if( cpu_Supports( BANK_KERNEL_AVX2 ) )
+		return get_Kernel_Table( BANK_KERNEL_AVX2 );
+
+	return &oSCALAR_KERNELS;
+}
+
+static const BankKernels* pKernels = detect_Kernels( );
+
+// Allocates an array of doubles aligned to BANK_ALIGNMENT.
+static double* allocate_Lanes( size_t iLanes )
+{
+	size_t iBytes = ( iLanes > 0 ? iLanes : 1 ) * sizeof( double );
+	void* pMemory = NULL;
+
+#ifdef _MSC_VER
+	pMemory = _aligned_malloc( iBytes, BANK_ALIGNMENT );
+#else
+	if( posix_memalign( &pMemory, BANK_ALIGNMENT, iBytes ) != 0 )
+		pMemory = NULL;
+#endif
+
+	return (double*) pMemory;
+}
+
+// Frees an array from allocate_Lanes.
+static void free_Lanes( double* pLanes )
+{
+#ifdef _MSC_VER
+	_aligned_free( pLanes );
+#else
+	free( pLanes );
+#endif
+}
+
+/*********************************************************************\
+ *	Constructor/Destructor											 *
+\*********************************************************************/
+
+// Creates a bank of calculators, all starting at 0 like a new Calculator.
+//	Parameters:
+//		iLanes : size_t - Number of calculators in the bank.
+//////////////////////////////////////////////////////////////////////
+CalculatorBank::CalculatorBank( size_t iLanes )
+{
+	m_iLanes = iLanes;
+	m_iStride = ( iLanes + BANK_ALIGNMENT / sizeof( double ) - 1 ) & ~( BANK_ALIGNMENT / sizeof( double ) - 1 );
+	m_pStack = NULL;
+	m_iStackDepth = 0;
+	m_pValues = allocate_Lanes( iLanes );
+	m_pMemory = allocate_Lanes( iLanes );
+
+	if( m_pValues == NULL || m_pMemory == NULL )
+	{
+		free_Lanes( m_pValues );
+		free_Lanes( m_pMemory );
+		m_pValues = m_pMemory = NULL;
+		m_iLanes = 0;
+		return;
+	}
+
+	pKernels->pFill( m_pValues, 0.0, m_iLanes );
+	pKernels->pFill( m_pMemory, 0.0, m_iLanes );
+}
+
+CalculatorBank::~CalculatorBank( )
+{
+	free_Lanes( m_pValues );
+	free_Lanes( m_pMemory );
+	free_Lanes( m_pStack );
+}
+
+/*********************************************************************\
+ *	Calculations													 *
+\*********************************************************************/
+
+// Returns the number of calculators in the bank.
+size_t CalculatorBank::size( ) const
+{
+	return m_iLanes;
+}
+
+// Applies the same operator and value to every lane.  Unknown operators
+// are ignored, as they are by Calculator.
+void CalculatorBank::process_Calculation( char cOperator, double dValue )
+{
+	int iIndex = get_Operator_Index( cOperator );
+
+	if( iIndex >= 0 )
+		pKernels->aBroadcast[ iIndex ]( m_pValues, dValue, m_iLanes );
+}
+
+// Applies an operator to every lane with a value per lane.
+//	Parameters:
+//		pValues : double* - size( ) operands, lane i uses pValues[ i ].
+//////////////////////////////////////////////////////////////////////
+void CalculatorBank::process_Calculation( char cOperator, const double* pValues )
+{
+	int iIndex = get_Operator_Index( cOperator );
+
+	if( iIndex >= 0 )
+		pKernels->aLanes[ iIndex ]( m_pValues, pValues, m_iLanes );
+}
+
+// Applies an operator to every lane using each lane's own memory.
+void CalculatorBank::process_Calculation_Mem( char cOperator )
+{
+	process_Calculation( cOperator, m_pMemory );
+}
+
+// Applies a decoded operation to every lane, as
+// Calculator::apply_Operation.  Operations on variables are ignored.
+void CalculatorBank::apply_Operation( const Operation& oOperation )
+{
+	switch( oOperation.cOpCode )
+	{
+	case OP_CODE_STORE:
+		store_Mem( );
+		break;
+	case OP_CODE_RESET:
+		clear_Value( );
+		break;
+	case OP_CODE_SET:
+		pKernels->pFill( m_pValues, oOperation.dValue, m_iLanes );
+		break;
+	default:
+		if( op_TouchesVar( oOperation.cOpCode ) )
+			break;
+
+		if( op_UsesMem( oOperation.cOpCode ) )
+			process_Calculation_Mem( op_Operator( oOperation.cOpCode ) );
+		else
+			process_Calculation( op_Operator( oOperation.cOpCode ), oOperation.dValue );
+		break;
+	}
+}
+
+// Runs a compiled line on every lane, as Calculator::execute_Program.
+// Each instruction is one kernel call over all the lanes, so a lane sees
+// exactly the operations the stack machine would apply to it.  A program
+// that reads a variable sees 0 for it.
+//	Parameters:
+//		oProgram : Program - The program to run.
+//////////////////////////////////////////////////////////////////////
+void CalculatorBank::execute_Program( const Program& oProgram )
+{
+	const unsigned char* pCode = oProgram.vCode.data( );
+	size_t iTop = 0;	// Slots in use
+	double dConstant = 0.0;
+	int iIndex = 0;
+
+	reserve_Stack( oProgram.iMaxStack );
+
+	for( ;; )
+	{
+		switch( *pCode++ )
+		{
+		case BC_CONST:
+			memcpy( &dConstant, pCode, sizeof( double ) );
+			pCode += sizeof( double );
+
+			// A constant that is the right operand of the next instruction
+			// is broadcast into the slot below, rather than filled into a
+			// slot of its own and read back.
+			if( iTop > 0 && ( iIndex = get_Operator_Index( (char) *pCode ) ) >= 0 )
+			{
+				pKernels->aBroadcast[ iIndex ]( get_Slot( iTop - 1 ), dConstant, m_iLanes );
+				++pCode;
+			}
+			else
+				pKernels->pFill( get_Slot( iTop++ ), dConstant, m_iLanes );
+			break;
+		case BC_MEM:
+			pKernels->pCopy( get_Slot( iTop++ ), m_pMemory, m_iLanes );
+			break;
+		case BC_VAR:
+			pCode += sizeof( unsigned int );
+			pKernels->pFill( get_Slot( iTop++ ), 0.0, m_iLanes );
+			break;
+		case BC_VALUE:
+			pKernels->pCopy( get_Slot( iTop++ ), m_pValues, m_iLanes );
+			break;
+		case BC_NEGATE:
+			pKernels->pNegate( get_Slot( iTop - 1 ), m_iLanes );
+			break;
+		default:
+			// Any other instruction is a binary operator, until BC_END.
+			if( ( iIndex = get_Operator_Index( (char) pCode[ -1 ] ) ) >= 0 )
+			{
+				pKernels->aLanes[ iIndex ]( get_Slot( iTop - 2 ), get_Slot( iTop - 1 ), m_iLanes );
+				--iTop;
+				break;
+			}
+
+			if( oProgram.cOperator == BC_ASSIGN )
+				pKernels->pCopy( m_pValues, get_Slot( iTop - 1 ), m_iLanes );
+			else
+				process_Calculation( oProgram.cOperator, get_Slot( iTop - 1 ) );
+			return;
+		}
+	}
+}
+
+// Returns the lanes of an expression stack slot.
+inline double* CalculatorBank::get_Slot( size_t iSlot )
+{
+	return m_pStack + iSlot * m_iStride;
+}
+
+// Makes room for an expression stack iDepth slots deep.  Every slot
+// starts on a cache line, so the kernels can use aligned loads on it.
+void CalculatorBank::reserve_Stack( size_t iDepth )
+{
+	double* pStack = NULL;
+
+	if( iDepth <= m_iStackDepth )
+		return;
+
+	if( ( pStack = allocate_Lanes( iDepth * m_iStride ) ) == NULL )
+		throw std::bad_alloc( );
+
+	free_Lanes( m_pStack );
+	m_pStack = pStack;
+	m_iStackDepth = iDepth;
+}
+
+/*********************************************************************\
+ *	Getters and Setters  											 *
+\*********************************************************************/
+
+// Stores every lane's working value into its memory.
+void CalculatorBank::store_Mem( )
+{
+	pKernels->pCopy( m_pMemory, m_pValues, m_iLanes );
+}
+
+// Copies every lane's memory out to pMemory.
+void CalculatorBank::pull_Mem( double* pMemory ) const
+{
+	pKernels->pCopy( pMemory, m_pMemory, m_iLanes );
+}
+
+// Clears every lane's working value.
+void CalculatorBank::clear_Value( )
+{
+	pKernels->pFill( m_pValues, 0.0, m_iLanes );
+}
+
+// Clears every lane's memory.
+void CalculatorBank::clear_Mem( )
+{
+	pKernels->pFill( m_pMemory, 0.0, m_iLanes );
+}
+
+// Copies every lane's working value out to pValues.
+void CalculatorBank::read_Value( double* pValues ) const
+{
+	pKernels->pCopy( pValues, m_pValues, m_iLanes );
+}
+
+// Sets every lane's working value from pValues.
+void CalculatorBank::set_Value( const double* pValues )
+{
+	pKernels->pCopy( m_pValues, pValues, m_iLanes );
+}
+
+// Reads a single lane's working value.
+double CalculatorBank::read_Value( size_t iLane ) const
+{
+	return m_pValues[ iLane ];
+}
+
+// Reads a single lane's memory.
+double CalculatorBank::pull_Mem( size_t iLane ) const
+{
+	return m_pMemory[ iLane ];
+}
+
+// Sets a single lane's working value.
+void CalculatorBank::set_Value( size_t iLane, double dValue )
+{
+	m_pValues[ iLane ] = dValue;
+}
+
+/*********************************************************************\
+ *	Kernel Selection												 *
+\*********************************************************************/
+
+// Forces a kernel set, for testing and benchmarking.
+//	Returns:
+//		false if the CPU can't run the requested set, which leaves the
+//		current selection alone.
+//////////////////////////////////////////////////////////////////////
+bool CalculatorBank::select_Kernels( eBankKernel eKernel )
+{
+	if( eKernel == BANK_KERNEL_BEST )
+	{
+		pKernels = detect_Kernels( );
+		return true;
+	}
+
+	if( !cpu_Supports( eKernel ) )
+		return false;
+
+	pKernels = get_Kernel_Table( eKernel );
+	return true;
+}
+
+// Returns the kernel set in use.
+eBankKernel CalculatorBank::get_Kernel( )
+{
+	return pKernels->eKernel;
+}
+
+// Returns the name of the kernel set in use.
+const char* CalculatorBank::get_Kernel_Name( )
+{
+	return pKernels->sName;
+}
@@ -0,0 +1,95 @@
+#ifndef _CALCULATORBANK_H
+#define _CALCULATORBANK_H
+
+// Name: CalculatorBank.h
+// Description: Many independent calculators stored as contiguous arrays
+//				of working values and memory registers (one "lane" per
+//				calculator).  Operations are applied to every lane at once
+//				with SIMD kernels picked at runtime from what the CPU
+//				supports.  Every lane gives bit for bit the same results as
+//				a Calculator fed the same operations.
+//
+//				Whole operations and compiled expression lines can be run
+//				on every lane as well.  Expressions are evaluated one
+//				instruction at a time over all the lanes, with a stack slot
+//				per lane kept in the bank, so each instruction is a single
+//				vectorized loop.  The bank has no variables; lines that
+//				read or store one must not be given to it.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "../Calculator/Bytecode.h"
+#include "../Calculator/Operation.h"
+#include <cstddef>
+
+/////////////
+// Defines //
+/////////////
+#define BANK_ALIGNMENT 64	// Arrays are aligned to a cache line
+
+// Kernel sets, in order of preference.
+enum eBankKernel
+{
+	BANK_KERNEL_SCALAR,
+	BANK_KERNEL_AVX2,
+	BANK_KERNEL_AVX512,
+	BANK_KERNEL_BEST		// Best set the CPU supports
+};
+
+////////////////////////////////
+// CalculatorBank Declaration //
+////////////////////////////////
+class CalculatorBank
+{
+public:
+	CalculatorBank( size_t iLanes );
+	~CalculatorBank( );
+
+	size_t size( ) const;
+
+	// Calculations on every lane
+	void process_Calculation( char cOperator, double dValue );
+	void process_Calculation( char cOperator, const double* pValues );
+	void process_Calculation_Mem( char cOperator );
+	void apply_Operation( const Operation& oOperation );
+	void execute_Program( const Program& oProgram );
+
+	// Bulk getters and setters
+	void store_Mem( );
+	void pull_Mem( double* pMemory ) const;
+	void clear_Value( );
+	void clear_Mem( );
+	void read_Value( double* pValues ) const;
+	void set_Value( const double* pValues );
+
+	// Single lane access
+	double read_Value( size_t iLane ) const;
+	double pull_Mem( size_t iLane ) const;
+	void set_Value( size_t iLane, double dValue );
+
+	// Kernel selection
+	static bool select_Kernels( eBankKernel eKernel );
+	static eBankKernel get_Kernel( );
+	static const char* get_Kernel_Name( );
+
+private:
+	CalculatorBank( const CalculatorBank& );
+	CalculatorBank& operator=( const CalculatorBank& );
+
+	double* get_Slot( size_t iSlot );
+	void reserve_Stack( size_t iDepth );
+
+	double* m_pValues;
+	double* m_pMemory;
+	size_t m_iLanes;
+
+	// Expression stack, iStackDepth slots of m_iStride doubles each
+	double* m_pStack;
+	size_t m_iStackDepth;
+	size_t m_iStride;
+};
+
+#endif
@@ -0,0 +1,469 @@
+// Name: CellSheet.cpp
+// Description: Dependency tracking and incremental recalculation of
+//				cells, see CellSheet.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "CellSheet.h"
+#include "../Parser/Tokenizer.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define VALUE_NAME "ans"
+
+// Collects the slots a compiled formula reads, sorted and each once.
+static void read_Inputs( const Program& oProgram, vector< unsigned int >& vInputs )
+{
+	const unsigned char* pCode = oProgram.vCode.data( );
+	unsigned int iSlot = 0;
+
+	vInputs.clear( );
+
+	for( ;; )
+	{
+		switch( *pCode++ )
+		{
+		case BC_CONST:
+			pCode += sizeof( double );
+			break;
+		case BC_VAR:
+			memcpy( &iSlot, pCode, sizeof( iSlot ) );
+			pCode += sizeof( iSlot );
+			vInputs.push_back( iSlot );
+			break;
+		case BC_END:
+			sort( vInputs.begin( ), vInputs.end( ) );
+			vInputs.erase( unique( vInputs.begin( ), vInputs.end( ) ), vInputs.end( ) );
+			return;
+		default:
+			break;
+		}
+	}
+}
+
+// Evaluates the cells of a pass on the work pool.  A cell's task is its
+// order in the pass; finishing it releases every dependent whose last
+// input it was.
+class CellSheet::Pass : public WorkPool::Job
+{
+public:
+	explicit Pass( CellSheet& oSheet ) : m_oSheet( oSheet ) {}
+
+	void execute( unsigned int iTask, unsigned int iWorker )
+	{
+		unsigned int iSlot = m_oSheet.m_vAffected[ iTask ];
+		const vector< unsigned int >& vDependents = m_oSheet.m_vCells[ iSlot ].vDependents;
+
+		m_oSheet.evaluate_Cell( iSlot );
+
+		for( size_t i = 0; i < vDependents.size( ); ++i )
+		{
+			const Mark& oMark = m_oSheet.m_vMarks[ vDependents[ i ] ];
+
+			if( oMark.iMark == m_oSheet.m_iMark &&
+				m_oSheet.m_pPending[ oMark.iOrder ].fetch_sub( 1, memory_order_acq_rel ) == 1 )
+				m_oSheet.m_oPool.spawn( iWorker, oMark.iOrder );
+		}
+	}
+
+private:
+	CellSheet& m_oSheet;
+};
+
+/*********************************************************************\
+ *	Constructor														 *
+\*********************************************************************/
+
+// Creates an empty sheet over a calculator's variables.
+//	Parameters:
+//		m_Calculator : Calculator - Holds the cells' names and values.
+//		iThreadCount : unsigned int - Threads for large passes, 0 for one
+//									  per core.
+//		iMinParallel : size_t - Passes with fewer cells run serially.
+//////////////////////////////////////////////////////////////////////
+CellSheet::CellSheet( Calculator* const m_Calculator, unsigned int iThreadCount, size_t iMinParallel )
+	: m_oPool( iThreadCount )
+{
+	this->m_Calculator = m_Calculator;
+	m_iMinParallel = iMinParallel;
+	m_iCellCount = 0;
+	m_iMark = 0;
+	m_iPendingCapacity = 0;
+	memset( &m_oStats, 0, sizeof( m_oStats ) );
+}
+
+/*********************************************************************\
+ *	Public Use Functions											 *
+\*********************************************************************/
+
+// Sets the formula of a cell, creating the cell if it is new.  The cell
+// and everything downstream of it are recalculated by the next pass.
+//	Parameters:
+//		sName : String - Name of the cell, not NUL terminated.
+//		iNameLength : size_t - Length of the name.
+//		sFormula : String - Expression for the cell's value.
+//		iLength : size_t - Length of the formula.
+//		oError : CompileError - Filled in on failure, with a position in
+//								the formula.
+//	Returns:
+//		False if the formula doesn't compile or would close a cycle, in
+//		which case the cell keeps its old formula.
+//////////////////////////////////////////////////////////////////////
+bool CellSheet::set_Cell( const char* sName, size_t iNameLength,
+						  const char* sFormula, size_t iLength, CompileError& oError )
+{
+	Program oProgram;
+	vector< unsigned int > vInputs;
+	unsigned int iSlot = 0;
+
+	oError.iPosition = 0;
+
+	if( iNameLength == sizeof( VALUE_NAME ) - 1 && !memcmp( sName, VALUE_NAME, iNameLength ) )
+	{
+		oError.sMessage = "ans can't be a cell";
+		return false;
+	}
+
+	iSlot = m_Calculator->intern_Variable( sName, iNameLength );
+
+	if( iSlot == VARIABLE_MEMORY_SLOT )
+	{
+		oError.sMessage = "mem can't be a cell";
+		return false;
+	}
+
+	if( !intern_Names( sFormula, iLength, oError ) ||
+		!compile_Expression( sFormula, iLength, m_Calculator, oProgram, oError ) )
+		return false;
+
+	read_Inputs( oProgram, vInputs );
+
+	if( m_vCells.size( ) <= iSlot )
+		m_vCells.resize( (size_t) iSlot + 1 );
+
+	if( !vInputs.empty( ) && m_vCells.size( ) <= vInputs.back( ) )
+		m_vCells.resize( (size_t) vInputs.back( ) + 1 );
+
+	m_vMarks.resize( m_vCells.size( ) );
+
+	// Formulas that read the same cells as before can't make a cycle.
+	if( vInputs != m_vCells[ iSlot ].vInputs )
+	{
+		if( binary_search( vInputs.begin( ), vInputs.end( ), iSlot ) || reaches_Any( iSlot, vInputs ) )
+		{
+			oError.sMessage = "circular reference";
+			return false;
+		}
+
+		link_Inputs( iSlot, vInputs );
+	}
+
+	Cell& oCell = m_vCells[ iSlot ];
+
+	oCell.oProgram.vCode.swap( oProgram.vCode );
+	oCell.oProgram.iMaxStack = oProgram.iMaxStack;
+	oCell.oProgram.bReadsState = oProgram.bReadsState;
+	oCell.oProgram.iVariableScope = oProgram.iVariableScope;
+	oCell.oProgram.oTier = ProgramTier( );
+
+	if( !oCell.bDefined )
+	{
+		oCell.bDefined = true;
+		++m_iCellCount;
+	}
+
+	if( !oCell.bEdited )
+	{
+		oCell.bEdited = true;
+		m_vEdited.push_back( iSlot );
+	}
+
+	++m_oStats.iEdits;
+	return true;
+}
+
+// Reads a cell, recalculating first if anything was edited.
+//	Returns:
+//		False if there is no cell by that name.
+//////////////////////////////////////////////////////////////////////
+bool CellSheet::get_Cell( const char* sName, size_t iLength, double& dValue )
+{
+	unsigned int iSlot = 0;
+
+	if( !m_Calculator->find_Variable( sName, iLength, iSlot ) || iSlot >= m_vCells.size( ) ||
+		!m_vCells[ iSlot ].bDefined )
+		return false;
+
+	recalculate( );
+	dValue = m_Calculator->pull_Var( iSlot );
+	return true;
+}
+
+// Brings every cell up to date.  Only the cells edited since the last
+// pass and the cells downstream of them are evaluated, each once and
+// after all of its inputs.
+//	Returns:
+//		The number of cells evaluated.
+//////////////////////////////////////////////////////////////////////
+size_t CellSheet::recalculate( )
+{
+	if( m_vEdited.empty( ) )
+		return 0;
+
+	next_Mark( );
+	m_vAffected.clear( );
+	m_vStack.clear( );
+
+	// Everything downstream of an edit, in no particular order.
+	for( size_t i = 0; i < m_vEdited.size( ); ++i )
+	{
+		m_vCells[ m_vEdited[ i ] ].bEdited = false;
+
+		if( m_vMarks[ m_vEdited[ i ] ].iMark == m_iMark )
+			continue;
+
+		m_vMarks[ m_vEdited[ i ] ].iMark = m_iMark;
+		m_vMarks[ m_vEdited[ i ] ].iOrder = (unsigned int) m_vAffected.size( );
+		m_vAffected.push_back( m_vEdited[ i ] );
+		m_vStack.push_back( m_vEdited[ i ] );
+
+		while( !m_vStack.empty( ) )
+		{
+			const vector< unsigned int >& vDependents = m_vCells[ m_vStack.back( ) ].vDependents;
+
+			m_vStack.pop_back( );
+
+			for( size_t j = 0; j < vDependents.size( ); ++j )
+			{
+				Mark& oMark = m_vMarks[ vDependents[ j ] ];
+
+				if( oMark.iMark == m_iMark )
+					continue;
+
+				oMark.iMark = m_iMark;
+				oMark.iOrder = (unsigned int) m_vAffected.size( );
+				m_vAffected.push_back( vDependents[ j ] );
+				m_vStack.push_back( vDependents[ j ] );
+			}
+		}
+	}
+
+	m_vEdited.clear( );
+
+	if( m_iPendingCapacity < m_vAffected.size( ) )
+	{
+		m_iPendingCapacity = max( m_vAffected.size( ), m_iPendingCapacity * 2 );
+		m_pPending.reset( new atomic< unsigned int >[ m_iPendingCapacity ] );
+	}
+
+	// A cell waits on its inputs that are part of this pass.
+	m_vReady.clear( );
+
+	for( size_t i = 0; i < m_vAffected.size( ); ++i )
+	{
+		const Cell& oCell = m_vCells[ m_vAffected[ i ] ];
+		unsigned int iWaiting = 0;
+
+		for( size_t j = 0; j < oCell.vInputs.size( ); ++j )
+			iWaiting += m_vMarks[ oCell.vInputs[ j ] ].iMark == m_iMark;
+
+		m_pPending[ i ].store( iWaiting, memory_order_relaxed );
+
+		if( iWaiting == 0 )
+			m_vReady.push_back( (unsigned int) i );
+	}
+
+	// Workers store to different slots, which mustn't move under them.
+	m_Calculator->fit_Registers( );
+
+	if( m_vAffected.size( ) >= m_iMinParallel && m_oPool.get_Thread_Count( ) > 1 )
+	{
+		Pass oPass( *this );
+
+		m_oPool.run( oPass, m_vReady.data( ), m_vReady.size( ) );
+		++m_oStats.iParallelPasses;
+	}
+	else
+		run_Serial( );
+
+	++m_oStats.iPasses;
+	m_oStats.iEvaluated += m_vAffected.size( );
+	return m_vAffected.size( );
+}
+
+// Returns the number of cells with a formula.
+size_t CellSheet::get_Cell_Count( ) const
+{
+	return m_iCellCount;
+}
+
+// Returns the sheet's counters.
+const CellStats& CellSheet::get_Stats( ) const
+{
+	return m_oStats;
+}
+
+// Returns the number of cells one pool thread took from another.
+unsigned long long CellSheet::get_Steals( ) const
+{
+	return m_oPool.get_Steals( );
+}
+
+/*********************************************************************\
+ *	Private Functions												 *
+\*********************************************************************/
+
+// Interns every name a formula reads, so it compiles even if it reads
+// cells that haven't been defined yet.  Tokenizing errors are left for
+// the compiler to report.
+//	Returns:
+//		False if the formula reads "ans", which isn't part of the graph.
+//////////////////////////////////////////////////////////////////////
+bool CellSheet::intern_Names( const char* sFormula, size_t iLength, CompileError& oError )
+{
+	Tokenizer oTokens( sFormula, iLength );
+
+	for( ; oTokens.peek( ).eType != TOKEN_END && oTokens.peek( ).eType != TOKEN_INVALID; oTokens.advance( ) )
+	{
+		const Token& oToken = oTokens.peek( );
+
+		if( oToken.eType != TOKEN_IDENTIFIER )
+			continue;
+
+		if( oToken.iLength == sizeof( VALUE_NAME ) - 1 && !memcmp( oToken.sText, VALUE_NAME, oToken.iLength ) )
+		{
+			oError.iPosition = oToken.iPosition;
+			oError.sMessage = "a cell can't read ans";
+			return false;
+		}
+
+		m_Calculator->intern_Variable( oToken.sText, oToken.iLength );
+	}
+
+	return true;
+}
+
+// Returns true if any of the target slots is downstream of a cell, in
+// which case making the cell read them would close a cycle.
+bool CellSheet::reaches_Any( unsigned int iFrom, const vector< unsigned int >& vTargets )
+{
+	if( vTargets.empty( ) || m_vCells[ iFrom ].vDependents.empty( ) )
+		return false;
+
+	next_Mark( );
+	m_vStack.clear( );
+	m_vStack.push_back( iFrom );
+	m_vMarks[ iFrom ].iMark = m_iMark;
+
+	while( !m_vStack.empty( ) )
+	{
+		const vector< unsigned int >& vDependents = m_vCells[ m_vStack.back( ) ].vDependents;
+
+		m_vStack.pop_back( );
+
+		for( size_t i = 0; i < vDependents.size( ); ++i )
+		{
+			if( m_vMarks[ vDependents[ i ] ].iMark != m_iMark )
+			{
+				m_vMarks[ vDependents[ i ] ].iMark = m_iMark;
+				m_vStack.push_back( vDependents[ i ] );
+			}
+		}
+	}
+
+	for( size_t i = 0; i < vTargets.size( ); ++i )
+	{
+		if( m_vMarks[ vTargets[ i ] ].iMark == m_iMark )
+			return true;
+	}
+
+	return false;
+}
+
+// Replaces a cell's inputs, moving it between the dependent lists of the
+// inputs it gained and lost.  Both lists are sorted, so one merge finds
+// the difference.
+void CellSheet::link_Inputs( unsigned int iSlot, const vector< unsigned int >& vInputs )
+{
+	vector< unsigned int >& vOld = m_vCells[ iSlot ].vInputs;
+	size_t iOld = 0;
+	size_t iNew = 0;
+
+	while( iOld < vOld.size( ) || iNew < vInputs.size( ) )
+	{
+		if( iNew == vInputs.size( ) || ( iOld < vOld.size( ) && vOld[ iOld ] < vInputs[ iNew ] ) )
+		{
+			vector< unsigned int >& vDependents = m_vCells[ vOld[ iOld++ ] ].vDependents;
+
+			*find( vDependents.begin( ), vDependents.end( ), iSlot ) = vDependents.back( );
+			vDependents.pop_back( );
+		}
+		else if( iOld == vOld.size( ) || vInputs[ iNew ] < vOld[ iOld ] )
+			m_vCells[ vInputs[ iNew++ ] ].vDependents.push_back( iSlot );
+		else
+		{
+			++iOld;
+			++iNew;
+		}
+	}
+
+	vOld = vInputs;
+}
+
+// Starts a new pass or search.  Marks are 32 bits to keep them small, so
+// when they wrap every cell's mark is cleared and counting starts over.
+unsigned int CellSheet::next_Mark( )
+{
+	if( ++m_iMark == 0 )
+	{
+		for( size_t i = 0; i < m_vMarks.size( ); ++i )
+			m_vMarks[ i ].iMark = 0;
+
+		m_iMark = 1;
+	}
+
+	return m_iMark;
+}
+
+// Evaluates a cell's formula into its variable.
+inline void CellSheet::evaluate_Cell( unsigned int iSlot )
+{
+	m_Calculator->set_Var( iSlot, m_Calculator->evaluate_Program( m_vCells[ iSlot ].oProgram ) );
+}
+
+// Evaluates the current pass on this thread, taking ready cells newest
+// first so a chain is followed to its end while it is in cache.
+void CellSheet::run_Serial( )
+{
+	while( !m_vReady.empty( ) )
+	{
+		unsigned int iSlot = m_vAffected[ m_vReady.back( ) ];
+		const vector< unsigned int >& vDependents = m_vCells[ iSlot ].vDependents;
+
+		evaluate_Cell( iSlot );
+		m_vReady.pop_back( );
+
+		for( size_t i = 0; i < vDependents.size( ); ++i )
+		{
+			const Mark& oMark = m_vMarks[ vDependents[ i ] ];
+			unsigned int iWaiting = 0;
+
+			if( oMark.iMark != m_iMark )
+				continue;
+
+			iWaiting = m_pPending[ oMark.iOrder ].load( memory_order_relaxed ) - 1;
+			m_pPending[ oMark.iOrder ].store( iWaiting, memory_order_relaxed );
+
+			if( iWaiting == 0 )
+				m_vReady.push_back( oMark.iOrder );
+		}
+	}
+}
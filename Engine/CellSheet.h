@@ -0,0 +1,120 @@
+#ifndef _CELLSHEET_H
+#define _CELLSHEET_H
+
+// Name: CellSheet.h
+// Description: Spreadsheet-style cells on top of a Calculator.  A cell is
+//				a variable of the calculator whose value is defined by an
+//				expression over other cells, so its value lives in the
+//				calculator's register file and any line or expression can
+//				read it by name.
+//
+//				The sheet keeps the dependency graph between cells.  Edits
+//				only mark cells; recalculate then visits the cells
+//				downstream of everything edited since the last pass and
+//				evaluates just those, each after all of its inputs.  The
+//				work per pass is proportional to the edited cells and their
+//				dependents, not to the size of the sheet.  Passes of at
+//				least iMinParallel cells are evaluated on a work-stealing
+//				pool, so independent parts of the graph run side by side.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "../Calculator/Calculator.h"
+#include "../Parser/ExprCompiler.h"
+#include "WorkPool.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+#define CELL_SHEET_MIN_PARALLEL 4096	// Smaller passes are evaluated on the calling thread
+
+// Counters over the life of a sheet.
+struct CellStats
+{
+	unsigned long long iEdits;			// Formulas set
+	unsigned long long iPasses;			// Recalculations with anything to do
+	unsigned long long iEvaluated;		// Cells evaluated over every pass
+	unsigned long long iParallelPasses;	// Passes run on the pool
+};
+
+/////////////////////////////
+// CellSheet Declaration   //
+/////////////////////////////
+// Cell formulas are expressions as compile_Expression takes them.  They
+// may read other cells, "mem" and plain variables, but not "ans", and a
+// formula that would make a cell depend on itself is rejected.  A name
+// that isn't a cell yet reads as the variable's value, 0 unless stored.
+class CellSheet
+{
+public:
+	CellSheet( Calculator* const m_Calculator, unsigned int iThreadCount = 0,
+			   size_t iMinParallel = CELL_SHEET_MIN_PARALLEL );
+
+	bool set_Cell( const char* sName, size_t iNameLength,
+				   const char* sFormula, size_t iLength, CompileError& oError );
+	bool get_Cell( const char* sName, size_t iLength, double& dValue );
+	size_t recalculate( );
+
+	size_t get_Cell_Count( ) const;
+	const CellStats& get_Stats( ) const;
+	unsigned long long get_Steals( ) const;
+
+private:
+	CellSheet( const CellSheet& );
+	CellSheet& operator=( const CellSheet& );
+
+	class Pass;
+
+	struct Cell
+	{
+		Program oProgram;
+		std::vector< unsigned int > vInputs;		// Slots the formula reads, sorted, each once
+		std::vector< unsigned int > vDependents;	// Cells whose formulas read this one
+		bool bDefined;
+		bool bEdited;								// Waiting for the next pass
+
+		Cell( ) : bDefined( false ), bEdited( false ) {}
+	};
+
+	// Where a pass or search has been.  Kept apart from the cells, since
+	// every edge visited reads one and a cell is two cache lines.
+	struct Mark
+	{
+		unsigned int iMark;							// Last pass or search that reached the cell
+		unsigned int iOrder;						// Index in the current pass
+	};
+
+	bool intern_Names( const char* sFormula, size_t iLength, CompileError& oError );
+	bool reaches_Any( unsigned int iFrom, const std::vector< unsigned int >& vTargets );
+	void link_Inputs( unsigned int iSlot, const std::vector< unsigned int >& vInputs );
+	unsigned int next_Mark( );
+	void evaluate_Cell( unsigned int iSlot );
+	void run_Serial( );
+
+	Calculator* m_Calculator;
+	WorkPool m_oPool;
+	size_t m_iMinParallel;
+	std::vector< Cell > m_vCells;				// By variable slot
+	std::vector< Mark > m_vMarks;				// By variable slot
+	size_t m_iCellCount;
+	std::vector< unsigned int > m_vEdited;
+
+	// Scratch space of the current pass or search.
+	unsigned int m_iMark;
+	std::vector< unsigned int > m_vAffected;	// Cells of the pass, by order
+	std::vector< unsigned int > m_vReady;		// Orders whose inputs are all done
+	std::vector< unsigned int > m_vStack;
+	std::unique_ptr< std::atomic< unsigned int >[] > m_pPending;	// Inputs left, by order
+	size_t m_iPendingCapacity;
+
+	CellStats m_oStats;
+};
+
+#endif
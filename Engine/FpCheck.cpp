@@ -0,0 +1,45 @@
+// Name: FpCheck.cpp
+// Description: Clears, tests and describes the floating-point exception
+//				flags of the calling thread.  Kept out of line so the
+//				compiler can't move arithmetic across the tests.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "FpCheck.h"
+
+#if defined( _MSC_VER )
+#pragma fenv_access( on )
+#endif
+
+// Clears the calling thread's checked flags.
+void clear_Fp_Flags( )
+{
+	feclearexcept( FP_CHECK_FLAGS );
+}
+
+// Returns the checked flags raised on the calling thread since they were
+// last cleared, 0 if none were.
+int test_Fp_Flags( )
+{
+	return fetestexcept( FP_CHECK_FLAGS );
+}
+
+// Returns a message for a set of raised flags, naming the one that says
+// the most about the operation: a division by zero, then an invalid
+// operation (such as 0/0 or inf - inf), then an overflow.
+const char* get_Fp_Error( int iFlags )
+{
+	if( iFlags & FE_DIVBYZERO )
+		return "division by zero";
+
+	if( iFlags & FE_INVALID )
+		return "invalid operation";
+
+	if( iFlags & FE_OVERFLOW )
+		return "result out of range";
+
+	return "no floating-point exception";
+}
@@ -0,0 +1,36 @@
+#ifndef _FPCHECK_H
+#define _FPCHECK_H
+
+// Name: FpCheck.h
+// Description: Sticky floating-point exception flags, for checked batch
+//				runs.  The flags are cleared once before a run and tested
+//				once after it, so the run itself carries no extra branch
+//				per operation; only a run that raised one is gone over
+//				again to find the operation responsible.
+//
+//				The flags belong to the thread that raised them.  Code
+//				that evaluates on other threads collects theirs with
+//				test_Fp_Flags before the thread ends.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cfenv>
+
+/////////////
+// Defines //
+/////////////
+// Flags that make a checked run fail.  Inexact and underflow results are
+// ordinary for doubles and aren't reported.
+#define FP_CHECK_FLAGS	( FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW )
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+void clear_Fp_Flags( );
+int test_Fp_Flags( );
+const char* get_Fp_Error( int iFlags );
+
+#endif
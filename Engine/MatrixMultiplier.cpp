@@ -0,0 +1,695 @@
+// Name: MatrixMultiplier.cpp
+// Description: Packed, blocked matrix product, see MatrixMultiplier.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "MatrixMultiplier.h"
+#include "WorkPool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#define MATRIX_HAS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// As in CalculatorBank, only the SIMD kernels are compiled for their
+// instruction sets.
+#if defined( __GNUC__ )
+#define MATRIX_TARGET_AVX2		__attribute__(( target( "avx2,fma" ) ))
+#define MATRIX_TARGET_AVX512	__attribute__(( target( "avx512f" ) ))
+#else
+#define MATRIX_TARGET_AVX2
+#define MATRIX_TARGET_AVX512
+#endif
+
+////////////////
+// Namespaces //
+////////////////
+using namespace std;
+
+/*********************************************************************\
+ *	Micro-kernels													 *
+\*********************************************************************/
+
+// Multiplies a packed panel of A by a packed panel of B into a
+// GEMM_MR x iNR tile of C.  pA holds iDepth columns of GEMM_MR values and
+// pB iDepth rows of iNR values, both aligned to GEMM_ALIGNMENT.  The tile
+// is stored into C, or added to it with bAccumulate, iStride apart.
+typedef void ( *MicroKernel )( size_t iDepth, const double* pA, const double* pB,
+							   double* pC, size_t iStride, bool bAccumulate );
+
+struct MatrixKernels
+{
+	MicroKernel pKernel;
+	size_t iNR;					// Columns of a tile
+	eMatrixKernel eKernel;
+	const char* sName;
+};
+
+// Plain C++, 6x8.
+static void kernel_Scalar( size_t iDepth, const double* pA, const double* pB,
+						   double* pC, size_t iStride, bool bAccumulate )
+{
+	double aSum[ GEMM_MR ][ 8 ] = {};
+
+	for( size_t p = 0; p < iDepth; ++p, pA += GEMM_MR, pB += 8 )
+	{
+		for( size_t i = 0; i < GEMM_MR; ++i )
+		{
+			for( size_t j = 0; j < 8; ++j )
+				aSum[ i ][ j ] += pA[ i ] * pB[ j ];
+		}
+	}
+
+	for( size_t i = 0; i < GEMM_MR; ++i, pC += iStride )
+	{
+		for( size_t j = 0; j < 8; ++j )
+			pC[ j ] = bAccumulate ? pC[ j ] + aSum[ i ][ j ] : aSum[ i ][ j ];
+	}
+}
+
+static const MatrixKernels oSCALAR_KERNELS = { kernel_Scalar, 8, MATRIX_KERNEL_SCALAR, "scalar" };
+
+#ifdef MATRIX_HAS_X86
+
+// Starts loading a tile of C, which is only touched after the whole
+// panel has been multiplied, so its misses overlap the arithmetic.
+static inline void prefetch_Tile( const double* pC, size_t iStride, size_t iWidth )
+{
+	for( size_t i = 0; i < GEMM_MR; ++i, pC += iStride )
+	{
+		_mm_prefetch( (const char*) pC, _MM_HINT_T0 );
+		_mm_prefetch( (const char*)( pC + iWidth - 1 ), _MM_HINT_T0 );
+	}
+}
+
+// AVX2 and FMA, 6x8: twelve accumulators, two loads of B and a broadcast
+// of A fill the sixteen registers.
+MATRIX_TARGET_AVX2
+static inline void update_Row_Avx2( const double* pA, __m256d vB0, __m256d vB1, __m256d& vC0, __m256d& vC1 )
+{
+	const __m256d vA = _mm256_broadcast_sd( pA );
+
+	vC0 = _mm256_fmadd_pd( vA, vB0, vC0 );
+	vC1 = _mm256_fmadd_pd( vA, vB1, vC1 );
+}
+
+MATRIX_TARGET_AVX2
+static inline void store_Row_Avx2( double* pC, __m256d vC0, __m256d vC1, bool bAccumulate )
+{
+	if( bAccumulate )
+	{
+		vC0 = _mm256_add_pd( _mm256_loadu_pd( pC ), vC0 );
+		vC1 = _mm256_add_pd( _mm256_loadu_pd( pC + 4 ), vC1 );
+	}
+
+	_mm256_storeu_pd( pC, vC0 );
+	_mm256_storeu_pd( pC + 4, vC1 );
+}
+
+MATRIX_TARGET_AVX2
+static void kernel_Avx2( size_t iDepth, const double* pA, const double* pB,
+						 double* pC, size_t iStride, bool bAccumulate )
+{
+	__m256d vC00 = _mm256_setzero_pd( ), vC01 = vC00, vC10 = vC00, vC11 = vC00, vC20 = vC00, vC21 = vC00;
+	__m256d vC30 = vC00, vC31 = vC00, vC40 = vC00, vC41 = vC00, vC50 = vC00, vC51 = vC00;
+
+	prefetch_Tile( pC, iStride, 8 );
+
+	for( size_t p = 0; p < iDepth; ++p, pA += GEMM_MR, pB += 8 )
+	{
+		const __m256d vB0 = _mm256_load_pd( pB );
+		const __m256d vB1 = _mm256_load_pd( pB + 4 );
+
+		update_Row_Avx2( pA, vB0, vB1, vC00, vC01 );
+		update_Row_Avx2( pA + 1, vB0, vB1, vC10, vC11 );
+		update_Row_Avx2( pA + 2, vB0, vB1, vC20, vC21 );
+		update_Row_Avx2( pA + 3, vB0, vB1, vC30, vC31 );
+		update_Row_Avx2( pA + 4, vB0, vB1, vC40, vC41 );
+		update_Row_Avx2( pA + 5, vB0, vB1, vC50, vC51 );
+	}
+
+	store_Row_Avx2( pC, vC00, vC01, bAccumulate );
+	store_Row_Avx2( pC + iStride, vC10, vC11, bAccumulate );
+	store_Row_Avx2( pC + 2 * iStride, vC20, vC21, bAccumulate );
+	store_Row_Avx2( pC + 3 * iStride, vC30, vC31, bAccumulate );
+	store_Row_Avx2( pC + 4 * iStride, vC40, vC41, bAccumulate );
+	store_Row_Avx2( pC + 5 * iStride, vC50, vC51, bAccumulate );
+}
+
+static const MatrixKernels oAVX2_KERNELS = { kernel_Avx2, 8, MATRIX_KERNEL_AVX2, "avx2" };
+
+// AVX-512, 6x16, the same shape with registers twice as wide.
+MATRIX_TARGET_AVX512
+static inline void update_Row_Avx512( const double* pA, __m512d vB0, __m512d vB1, __m512d& vC0, __m512d& vC1 )
+{
+	const __m512d vA = _mm512_set1_pd( *pA );
+
+	vC0 = _mm512_fmadd_pd( vA, vB0, vC0 );
+	vC1 = _mm512_fmadd_pd( vA, vB1, vC1 );
+}
+
+MATRIX_TARGET_AVX512
+static inline void store_Row_Avx512( double* pC, __m512d vC0, __m512d vC1, bool bAccumulate )
+{
+	if( bAccumulate )
+	{
+		vC0 = _mm512_add_pd( _mm512_loadu_pd( pC ), vC0 );
+		vC1 = _mm512_add_pd( _mm512_loadu_pd( pC + 8 ), vC1 );
+	}
+
+	_mm512_storeu_pd( pC, vC0 );
+	_mm512_storeu_pd( pC + 8, vC1 );
+}
+
+MATRIX_TARGET_AVX512
+static void kernel_Avx512( size_t iDepth, const double* pA, const double* pB,
+						   double* pC, size_t iStride, bool bAccumulate )
+{
+	__m512d vC00 = _mm512_setzero_pd( ), vC01 = vC00, vC10 = vC00, vC11 = vC00, vC20 = vC00, vC21 = vC00;
+	__m512d vC30 = vC00, vC31 = vC00, vC40 = vC00, vC41 = vC00, vC50 = vC00, vC51 = vC00;
+
+	prefetch_Tile( pC, iStride, 16 );
+
+	for( size_t p = 0; p < iDepth; ++p, pA += GEMM_MR, pB += 16 )
+	{
+		const __m512d vB0 = _mm512_load_pd( pB );
+		const __m512d vB1 = _mm512_load_pd( pB + 8 );
+
+		update_Row_Avx512( pA, vB0, vB1, vC00, vC01 );
+		update_Row_Avx512( pA + 1, vB0, vB1, vC10, vC11 );
+		update_Row_Avx512( pA + 2, vB0, vB1, vC20, vC21 );
+		update_Row_Avx512( pA + 3, vB0, vB1, vC30, vC31 );
+		update_Row_Avx512( pA + 4, vB0, vB1, vC40, vC41 );
+		update_Row_Avx512( pA + 5, vB0, vB1, vC50, vC51 );
+	}
+
+	store_Row_Avx512( pC, vC00, vC01, bAccumulate );
+	store_Row_Avx512( pC + iStride, vC10, vC11, bAccumulate );
+	store_Row_Avx512( pC + 2 * iStride, vC20, vC21, bAccumulate );
+	store_Row_Avx512( pC + 3 * iStride, vC30, vC31, bAccumulate );
+	store_Row_Avx512( pC + 4 * iStride, vC40, vC41, bAccumulate );
+	store_Row_Avx512( pC + 5 * iStride, vC50, vC51, bAccumulate );
+}
+
+static const MatrixKernels oAVX512_KERNELS = { kernel_Avx512, 16, MATRIX_KERNEL_AVX512, "avx512" };
+
+#endif
+
+/*********************************************************************\
+ *	CPU Detection													 *
+\*********************************************************************/
+
+// Returns true if the CPU (and OS) can run the given kernel set.
+static bool cpu_Supports( eMatrixKernel eKernel )
+{
+	switch( eKernel )
+	{
+	case MATRIX_KERNEL_SCALAR:
+		return true;
+#ifdef MATRIX_HAS_X86
+#if defined( __GNUC__ )
+	case MATRIX_KERNEL_AVX2:
+		return __builtin_cpu_supports( "avx2" ) != 0 && __builtin_cpu_supports( "fma" ) != 0;
+	case MATRIX_KERNEL_AVX512:
+		return __builtin_cpu_supports( "avx512f" ) != 0;
+#elif defined( _MSC_VER )
+	case MATRIX_KERNEL_AVX2:
+	case MATRIX_KERNEL_AVX512:
+	{
+		int aInfo[ 4 ];
+
+		// The OS has to save the wide registers (XCR0) for either set.
+		__cpuid( aInfo, 1 );
+
+		if( !( aInfo[ 2 ] & ( 1 << 27 ) ) || !( aInfo[ 2 ] & ( 1 << 12 ) ) )
+			return false;
+
+		unsigned long long iXCR0 = _xgetbv( 0 );
+		__cpuidex( aInfo, 7, 0 );
+
+		if( eKernel == MATRIX_KERNEL_AVX2 )
+			return ( iXCR0 & 0x6 ) == 0x6 && ( aInfo[ 1 ] & ( 1 << 5 ) );
+
+		return ( iXCR0 & 0xE6 ) == 0xE6 && ( aInfo[ 1 ] & ( 1 << 16 ) );
+	}
+#endif
+#endif
+	default:
+		return false;
+	}
+}
+
+// Returns the kernel set for a set the CPU supports.
+static const MatrixKernels* get_Kernel_Table( eMatrixKernel eKernel )
+{
+	switch( eKernel )
+	{
+#ifdef MATRIX_HAS_X86
+	case MATRIX_KERNEL_AVX512:
+		return &oAVX512_KERNELS;
+	case MATRIX_KERNEL_AVX2:
+		return &oAVX2_KERNELS;
+#endif
+	default:
+		return &oSCALAR_KERNELS;
+	}
+}
+
+// Picks the best kernel set once, at startup.
+static const MatrixKernels* detect_Kernels( )
+{
+	if( cpu_Supports( MATRIX_KERNEL_AVX512 ) )
+		return get_Kernel_Table( MATRIX_KERNEL_AVX512 );
+
+	if( cpu_Supports( MATRIX_KERNEL_AVX2 ) )
+		return get_Kernel_Table( MATRIX_KERNEL_AVX2 );
+
+	return &oSCALAR_KERNELS;
+}
+
+static const MatrixKernels* pKernels = detect_Kernels( );
+
+/*********************************************************************\
+ *	Packing															 *
+\*********************************************************************/
+
+// Packs iRows rows of an iDepth deep slice of A into panels of GEMM_MR
+// rows, each stored column by column.  The last panel is padded with
+// zeros.
+//	Parameters:
+//		pA : double* - The first element of the slice.
+//		iStride : size_t - Distance between rows of A.
+//////////////////////////////////////////////////////////////////////
+static void pack_A( const double* pA, size_t iStride, size_t iRows, size_t iDepth, double* pPacked )
+{
+	for( size_t i = 0; i < iRows; i += GEMM_MR, pPacked += GEMM_MR * iDepth )
+	{
+		for( size_t r = 0; r < GEMM_MR; ++r )
+		{
+			if( i + r < iRows )
+			{
+				const double* pRow = pA + ( i + r ) * iStride;
+
+				for( size_t p = 0; p < iDepth; ++p )
+					pPacked[ p * GEMM_MR + r ] = pRow[ p ];
+			}
+			else
+			{
+				for( size_t p = 0; p < iDepth; ++p )
+					pPacked[ p * GEMM_MR + r ] = 0.0;
+			}
+		}
+	}
+}
+
+// Packs iPanels panels of iNR columns of an iDepth deep slice of B, each
+// stored row by row.  Columns past iColumns are zeros.
+//	Parameters:
+//		pB : double* - The first element of the slice.
+//		iStride : size_t - Distance between rows of B.
+//////////////////////////////////////////////////////////////////////
+static void pack_B( const double* pB, size_t iStride, size_t iDepth, size_t iColumns,
+					size_t iPanels, size_t iNR, double* pPacked )
+{
+	for( size_t j = 0; j < iPanels; ++j )
+	{
+		const size_t iFirst = j * iNR;
+		const size_t iWidth = min( iNR, iColumns - iFirst );
+
+		for( size_t p = 0; p < iDepth; ++p, pPacked += iNR )
+		{
+			memcpy( pPacked, pB + p * iStride + iFirst, iWidth * sizeof( double ) );
+
+			for( size_t c = iWidth; c < iNR; ++c )
+				pPacked[ c ] = 0.0;
+		}
+	}
+}
+
+/*********************************************************************\
+ *	Blocks															 *
+\*********************************************************************/
+
+// One packed slice of B, iThickness rows from iLayer by iWidth columns
+// from iColumn, and how its work is split into tasks.
+struct ProductStep
+{
+	const double* pA;
+	const double* pB;
+	double* pC;
+	size_t iRows;
+	size_t iColumns;
+	size_t iDepth;
+	size_t iColumn;
+	size_t iWidth;
+	size_t iLayer;
+	size_t iThickness;
+	bool bAccumulate;				// Add to C, for every slice but the first
+	size_t iPanels;					// Panels of B in the slice
+	size_t iTaskPanels;				// Panels per task
+	size_t iColumnTasks;
+	double* pPackedB;
+	const MatrixKernels* pKernels;
+};
+
+// Packs panels [iFirst, iFirst + iCount) of the step's slice of B.
+static void pack_Step( const ProductStep& oStep, size_t iFirst, size_t iCount )
+{
+	const size_t iNR = oStep.pKernels->iNR;
+
+	pack_B( oStep.pB + oStep.iLayer * oStep.iColumns + oStep.iColumn + iFirst * iNR, oStep.iColumns,
+			oStep.iThickness, oStep.iWidth - iFirst * iNR, iCount, iNR,
+			oStep.pPackedB + iFirst * iNR * oStep.iThickness );
+}
+
+// Packs up to GEMM_MC rows of A from iRow and multiplies them by panels
+// [iFirst, iFirst + iCount) of the packed slice of B.  Tiles on the edges
+// of C are computed whole into a buffer and only their part of C is
+// written.
+//////////////////////////////////////////////////////////////////////
+static void multiply_Block( const ProductStep& oStep, size_t iRow, size_t iFirst, size_t iCount, double* pPackedA )
+{
+	const size_t iNR = oStep.pKernels->iNR;
+	const size_t iRows = min( (size_t) GEMM_MC, oStep.iRows - iRow );
+	alignas( GEMM_ALIGNMENT ) double aTile[ GEMM_MR * GEMM_MAX_NR ];
+
+	pack_A( oStep.pA + iRow * oStep.iDepth + oStep.iLayer, oStep.iDepth, iRows, oStep.iThickness, pPackedA );
+
+	for( size_t j = iFirst; j < iFirst + iCount; ++j )
+	{
+		const size_t iColumn = oStep.iColumn + j * iNR;
+		const size_t iTileColumns = min( iNR, oStep.iColumn + oStep.iWidth - iColumn );
+		const double* pPanelB = oStep.pPackedB + j * iNR * oStep.iThickness;
+
+		for( size_t i = 0; i < iRows; i += GEMM_MR )
+		{
+			const size_t iTileRows = min( (size_t) GEMM_MR, iRows - i );
+			const double* pPanelA = pPackedA + i * oStep.iThickness;
+			double* pTile = oStep.pC + ( iRow + i ) * oStep.iColumns + iColumn;
+
+			if( iTileRows == GEMM_MR && iTileColumns == iNR )
+			{
+				oStep.pKernels->pKernel( oStep.iThickness, pPanelA, pPanelB, pTile, oStep.iColumns, oStep.bAccumulate );
+				continue;
+			}
+
+			oStep.pKernels->pKernel( oStep.iThickness, pPanelA, pPanelB, aTile, iNR, false );
+
+			for( size_t r = 0; r < iTileRows; ++r )
+			{
+				double* pRow = pTile + r * oStep.iColumns;
+
+				for( size_t c = 0; c < iTileColumns; ++c )
+					pRow[ c ] = oStep.bAccumulate ? pRow[ c ] + aTile[ r * iNR + c ] : aTile[ r * iNR + c ];
+			}
+		}
+	}
+}
+
+// Packs the step's slice of B, a run of panels per task.
+class PackJob : public WorkPool::Job
+{
+public:
+	explicit PackJob( const ProductStep& oStep ) : m_oStep( oStep ) {}
+
+	void execute( unsigned int iTask, unsigned int )
+	{
+		const size_t iFirst = iTask * m_oStep.iTaskPanels;
+
+		pack_Step( m_oStep, iFirst, min( m_oStep.iTaskPanels, m_oStep.iPanels - iFirst ) );
+	}
+
+private:
+	const ProductStep& m_oStep;
+};
+
+// Multiplies a block of rows of A by a run of panels of B per task, into
+// the worker's own packed A.
+class BlockJob : public WorkPool::Job
+{
+public:
+	BlockJob( const ProductStep& oStep, double* const* pPackedA ) : m_oStep( oStep ), m_pPackedA( pPackedA ) {}
+
+	void execute( unsigned int iTask, unsigned int iWorker )
+	{
+		const size_t iFirst = ( iTask % m_oStep.iColumnTasks ) * m_oStep.iTaskPanels;
+
+		multiply_Block( m_oStep, ( iTask / m_oStep.iColumnTasks ) * GEMM_MC, iFirst,
+						min( m_oStep.iTaskPanels, m_oStep.iPanels - iFirst ), m_pPackedA[ iWorker ] );
+	}
+
+private:
+	const ProductStep& m_oStep;
+	double* const* m_pPackedA;
+};
+
+// Allocates an array of doubles aligned to GEMM_ALIGNMENT.
+static double* allocate_Doubles( size_t iCount )
+{
+	size_t iBytes = ( iCount > 0 ? iCount : 1 ) * sizeof( double );
+	void* pMemory = NULL;
+
+#ifdef _MSC_VER
+	pMemory = _aligned_malloc( iBytes, GEMM_ALIGNMENT );
+#else
+	if( posix_memalign( &pMemory, GEMM_ALIGNMENT, iBytes ) != 0 )
+		pMemory = NULL;
+#endif
+
+	if( pMemory == NULL )
+		throw std::bad_alloc( );
+
+	return (double*) pMemory;
+}
+
+// Frees an array from allocate_Doubles.
+static void free_Doubles( double* pDoubles )
+{
+#ifdef _MSC_VER
+	_aligned_free( pDoubles );
+#else
+	free( pDoubles );
+#endif
+}
+
+/*********************************************************************\
+ *	Constructor/Destructor											 *
+\*********************************************************************/
+
+// Sets up a multiplier.  Threads are only started by the first product
+// large enough to use them.
+//	Parameters:
+//		iThreadCount : unsigned int - Workers for large products, 0 for one
+//									  per core, 1 to always run serially.
+//////////////////////////////////////////////////////////////////////
+MatrixMultiplier::MatrixMultiplier( unsigned int iThreadCount )
+{
+	m_iThreadCount = iThreadCount;
+	m_pPackedB = NULL;
+	m_iPackedBSize = 0;
+}
+
+MatrixMultiplier::~MatrixMultiplier( )
+{
+	free_Doubles( m_pPackedB );
+
+	for( size_t i = 0; i < m_vPackedA.size( ); ++i )
+		free_Doubles( m_vPackedA[ i ] );
+}
+
+/*********************************************************************\
+ *	Products														 *
+\*********************************************************************/
+
+// Computes C = A * B.  A is iRows x iDepth, B is iDepth x iColumns and C
+// is iRows x iColumns, each row-major with no gaps between rows.
+//	Parameters:
+//		pC : double* - The result, which must not overlap A or B.
+//////////////////////////////////////////////////////////////////////
+void MatrixMultiplier::multiply( const double* pA, const double* pB, double* pC,
+								 size_t iRows, size_t iColumns, size_t iDepth )
+{
+	const MatrixKernels* pSet = pKernels;
+	const size_t iNR = pSet->iNR;
+	const size_t iBlocks = ( iRows + GEMM_MC - 1 ) / GEMM_MC;
+	WorkPool* pPool = NULL;
+	size_t iWorkers = 1;
+	ProductStep oStep;
+
+	if( iRows == 0 || iColumns == 0 )
+		return;
+
+	if( iDepth == 0 )
+	{
+		fill( pC, pC + iRows * iColumns, 0.0 );
+		return;
+	}
+
+	if( m_iThreadCount != 1 && (double) iRows * (double) iColumns * (double) iDepth >= (double) GEMM_PARALLEL_WORK )
+	{
+		if( !m_pPool )
+			m_pPool.reset( new WorkPool( m_iThreadCount ) );
+
+		if( m_pPool->get_Thread_Count( ) > 1 )
+		{
+			pPool = m_pPool.get( );
+			iWorkers = pPool->get_Thread_Count( );
+		}
+	}
+
+	if( m_vPackedA.size( ) < iWorkers )
+	{
+		m_vPackedA.resize( iWorkers, NULL );
+		m_vPackedASize.resize( iWorkers, 0 );
+	}
+
+	for( size_t i = 0; i < iWorkers; ++i )
+		reserve( m_vPackedA[ i ], m_vPackedASize[ i ], (size_t) GEMM_MC * GEMM_KC );
+
+	reserve( m_pPackedB, m_iPackedBSize, (size_t) GEMM_KC * ( ( min( (size_t) GEMM_NC, iColumns ) + iNR - 1 ) / iNR ) * iNR );
+
+	oStep.pA = pA;
+	oStep.pB = pB;
+	oStep.pC = pC;
+	oStep.iRows = iRows;
+	oStep.iColumns = iColumns;
+	oStep.iDepth = iDepth;
+	oStep.pPackedB = m_pPackedB;
+	oStep.pKernels = pSet;
+
+	for( oStep.iColumn = 0; oStep.iColumn < iColumns; oStep.iColumn += GEMM_NC )
+	{
+		oStep.iWidth = min( (size_t) GEMM_NC, iColumns - oStep.iColumn );
+		oStep.iPanels = ( oStep.iWidth + iNR - 1 ) / iNR;
+
+		// Enough tasks for every worker to take a few, but none so narrow
+		// that packing its block of A costs more than a sliver of the work.
+		oStep.iColumnTasks = min( oStep.iPanels, ( 4 * iWorkers + iBlocks - 1 ) / iBlocks );
+		oStep.iTaskPanels = max( ( oStep.iPanels + oStep.iColumnTasks - 1 ) / oStep.iColumnTasks,
+								 ( (size_t) GEMM_TASK_COLUMNS + iNR - 1 ) / iNR );
+		oStep.iColumnTasks = ( oStep.iPanels + oStep.iTaskPanels - 1 ) / oStep.iTaskPanels;
+
+		for( oStep.iLayer = 0; oStep.iLayer < iDepth; oStep.iLayer += GEMM_KC )
+		{
+			oStep.iThickness = min( (size_t) GEMM_KC, iDepth - oStep.iLayer );
+			oStep.bAccumulate = oStep.iLayer > 0;
+
+			if( pPool == NULL )
+			{
+				pack_Step( oStep, 0, oStep.iPanels );
+
+				for( size_t i = 0; i < iBlocks; ++i )
+					multiply_Block( oStep, i * GEMM_MC, 0, oStep.iPanels, m_vPackedA[ 0 ] );
+
+				continue;
+			}
+
+			PackJob oPack( oStep );
+			BlockJob oBlocks( oStep, m_vPackedA.data( ) );
+
+			m_vTasks.resize( iBlocks * oStep.iColumnTasks );
+
+			for( size_t i = 0; i < m_vTasks.size( ); ++i )
+				m_vTasks[ i ] = (unsigned int) i;
+
+			pPool->run( oPack, m_vTasks.data( ), oStep.iColumnTasks );
+			pPool->run( oBlocks, m_vTasks.data( ), iBlocks * oStep.iColumnTasks );
+		}
+	}
+}
+
+// Returns the number of workers large products are split over.
+unsigned int MatrixMultiplier::get_Thread_Count( ) const
+{
+	if( m_pPool )
+		return m_pPool->get_Thread_Count( );
+
+	return m_iThreadCount;
+}
+
+// Makes sure a packing buffer holds at least iSize doubles.
+double* MatrixMultiplier::reserve( double*& pBuffer, size_t& iCapacity, size_t iSize )
+{
+	if( iCapacity < iSize )
+	{
+		free_Doubles( pBuffer );
+		pBuffer = NULL;
+		iCapacity = 0;
+
+		pBuffer = allocate_Doubles( iSize );
+		iCapacity = iSize;
+	}
+
+	return pBuffer;
+}
+
+/*********************************************************************\
+ *	Kernel Selection												 *
+\*********************************************************************/
+
+// Forces a kernel set, for testing and benchmarking.
+//	Returns:
+//		false if the CPU can't run the requested set, which leaves the
+//		current selection alone.
+//////////////////////////////////////////////////////////////////////
+bool MatrixMultiplier::select_Kernels( eMatrixKernel eKernel )
+{
+	if( eKernel == MATRIX_KERNEL_BEST )
+	{
+		pKernels = detect_Kernels( );
+		return true;
+	}
+
+	if( !cpu_Supports( eKernel ) )
+		return false;
+
+	pKernels = get_Kernel_Table( eKernel );
+	return true;
+}
+
+// Returns the kernel set in use.
+eMatrixKernel MatrixMultiplier::get_Kernel( )
+{
+	return pKernels->eKernel;
+}
+
+// Returns the name of the kernel set in use.
+const char* MatrixMultiplier::get_Kernel_Name( )
+{
+	return pKernels->sName;
+}
+
+/*********************************************************************\
+ *	Functions														 *
+\*********************************************************************/
+
+// The textbook triple loop, one dot product per element of C, for the
+// benchmarks to measure the blocked product against.  Arguments as
+// MatrixMultiplier::multiply.
+//////////////////////////////////////////////////////////////////////
+void multiply_Naive( const double* pA, const double* pB, double* pC,
+					 size_t iRows, size_t iColumns, size_t iDepth )
+{
+	for( size_t i = 0; i < iRows; ++i )
+	{
+		for( size_t j = 0; j < iColumns; ++j )
+		{
+			double dSum = 0.0;
+
+			for( size_t k = 0; k < iDepth; ++k )
+				dSum += pA[ i * iDepth + k ] * pB[ k * iColumns + j ];
+
+			pC[ i * iColumns + j ] = dSum;
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef _MATRIXMULTIPLIER_H
+#define _MATRIXMULTIPLIER_H
+
+// Name: MatrixMultiplier.h
+// Description: Matrix product for the matrix mode, C = A * B with all
+//				three row-major.  The loops are the ones of Goto and van de
+//				Geijn, "Anatomy of High-Performance Matrix Multiplication"
+//				(2008): B is packed GEMM_KC rows by GEMM_NC columns at a
+//				time into panels GEMM_NR wide, which stay in the last level
+//				cache, A is packed GEMM_MC rows at a time into panels
+//				GEMM_MR tall, which stay in L2, and a micro-kernel keeps a
+//				GEMM_MR x GEMM_NR tile of C in registers while it streams
+//				one panel of each through L1.
+//
+//				Micro-kernels are picked at runtime from what the CPU
+//				supports, as CalculatorBank picks its kernels: 6x16 tiles
+//				with AVX-512, 6x8 with AVX2 and FMA, and plain C++ 6x8 tiles
+//				everywhere else.  Products of more than GEMM_PARALLEL_WORK
+//				multiply-adds are split by blocks of rows and columns over
+//				a WorkPool.  Every element is summed in the same order
+//				however the work is split, so the result doesn't depend on
+//				the number of threads; it does depend on the kernel set,
+//				since the SIMD kernels fuse each multiply-add.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+#define GEMM_MR					6			// Rows of a micro-kernel tile
+#define GEMM_MAX_NR				16			// Widest micro-kernel tile
+#define GEMM_KC					256			// Depth of a packed block
+#define GEMM_MC					96			// Rows of A packed at a time, a multiple of GEMM_MR
+#define GEMM_NC					4096		// Columns of B packed at a time
+#define GEMM_TASK_COLUMNS		64			// Fewest columns of a parallel task
+#define GEMM_PARALLEL_WORK		( 1ULL << 21 )	// Multiply-adds before threads are used
+#define GEMM_ALIGNMENT			64
+
+// Micro-kernel sets, in order of preference.
+enum eMatrixKernel
+{
+	MATRIX_KERNEL_SCALAR,
+	MATRIX_KERNEL_AVX2,
+	MATRIX_KERNEL_AVX512,
+	MATRIX_KERNEL_BEST		// Best set the CPU supports
+};
+
+class WorkPool;
+
+//////////////////////////////////
+// MatrixMultiplier Declaration //
+//////////////////////////////////
+// Keeps the packing buffers and the threads of a run of products, so
+// multiplying in a loop doesn't allocate.
+class MatrixMultiplier
+{
+public:
+	explicit MatrixMultiplier( unsigned int iThreadCount = 1 );
+	~MatrixMultiplier( );
+
+	void multiply( const double* pA, const double* pB, double* pC,
+				   size_t iRows, size_t iColumns, size_t iDepth );
+	unsigned int get_Thread_Count( ) const;
+
+	// Kernel selection
+	static bool select_Kernels( eMatrixKernel eKernel );
+	static eMatrixKernel get_Kernel( );
+	static const char* get_Kernel_Name( );
+
+private:
+	MatrixMultiplier( const MatrixMultiplier& );
+	MatrixMultiplier& operator=( const MatrixMultiplier& );
+
+	double* reserve( double*& pBuffer, size_t& iCapacity, size_t iSize );
+
+	unsigned int m_iThreadCount;
+	std::unique_ptr< WorkPool > m_pPool;		// Started by the first large product
+	double* m_pPackedB;
+	size_t m_iPackedBSize;
+	std::vector< double* > m_vPackedA;			// One block per worker
+	std::vector< size_t > m_vPackedASize;
+	std::vector< unsigned int > m_vTasks;
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+void multiply_Naive( const double* pA, const double* pB, double* pC,
+					 size_t iRows, size_t iColumns, size_t iDepth );
+
+#endif
@@ -0,0 +1,145 @@
+// Name: Sweep.cpp
+// Description: Compiling the lines of a parameter sweep and running them
+//				over blocks of starting values, see Sweep.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "Sweep.h"
+#include <algorithm>
+
+using namespace std;
+
+/*********************************************************************\
+ *	Constructor														 *
+\*********************************************************************/
+
+Sweep::Sweep( )
+{
+}
+
+/*********************************************************************\
+ *	Lines															 *
+\*********************************************************************/
+
+// Adds a line to the end of the sweep.  Plain operations are kept as they
+// are; anything else is compiled as an expression.  An expression that
+// doesn't read the lane gives every lane the same operand, so it is
+// evaluated once here and kept as an operation.
+//	Parameters:
+//		sLine, iLength : const char* - The line, not null terminated.
+//		m_Calculator : Calculator - Compiles the line and evaluates
+//									constant expressions.
+//		oError : CompileError - Receives why the line was rejected.
+//	Returns:
+//		LINE_OPERATION if the line was added, otherwise as parse_Line.
+//		oError is set for LINE_INVALID.
+//////////////////////////////////////////////////////////////////////
+eLineType Sweep::add_Line( const char* sLine, size_t iLength, Calculator* const m_Calculator,
+						   CompileError& oError )
+{
+	Step oStep;
+	Program oProgram;
+	eLineType eType = parse_Line( sLine, iLength, m_Calculator, oStep.oOperation );
+	bool bVariables = false;
+
+	oStep.iProgram = -1;
+
+	if( eType == LINE_INVALID )
+	{
+		if( !compile_Line( sLine, iLength, m_Calculator, oProgram, oError ) )
+			return LINE_INVALID;
+
+		bVariables = oProgram.iVariableScope != 0;
+	}
+	else if( eType == LINE_OPERATION )
+		bVariables = op_TouchesVar( oStep.oOperation.cOpCode );
+	else
+		return eType;
+
+	if( bVariables )
+	{
+		oError.iPosition = 0;
+
+		while( oError.iPosition < iLength && ( sLine[ oError.iPosition ] == ' ' || sLine[ oError.iPosition ] == '\t' ) )
+			++oError.iPosition;
+
+		oError.sMessage = "a sweep can't use variables";
+		return LINE_INVALID;
+	}
+
+	if( !oProgram.vCode.empty( ) && !oProgram.bReadsState )
+	{
+		oStep.oOperation.cOpCode = oProgram.cOperator == BC_ASSIGN ? OP_CODE_SET : (unsigned char) oProgram.cOperator;
+		oStep.oOperation.dValue = m_Calculator->evaluate_Program( oProgram );
+	}
+	else if( !oProgram.vCode.empty( ) )
+	{
+		oStep.iProgram = (int) m_vPrograms.size( );
+		m_vPrograms.push_back( oProgram );
+	}
+
+	m_vSteps.push_back( oStep );
+	return LINE_OPERATION;
+}
+
+// Returns the number of lines in the sweep.
+size_t Sweep::get_Line_Count( ) const
+{
+	return m_vSteps.size( );
+}
+
+/*********************************************************************\
+ *	Evaluation														 *
+\*********************************************************************/
+
+// Sweeps a run of starting values, a bank's worth at a time.
+//	Parameters:
+//		oBank : CalculatorBank - Lanes to work in, owned by the caller.
+//		pInputs : double* - iCount starting values.
+//		pOutputs : double* - Receives the iCount final working values.  May
+//							 be pInputs.
+//////////////////////////////////////////////////////////////////////
+void Sweep::evaluate( CalculatorBank& oBank, const double* pInputs, double* pOutputs, size_t iCount ) const
+{
+	size_t iLanes = oBank.size( );
+	size_t i = 0;
+
+	if( iLanes == 0 )
+		return;
+
+	for( ; i + iLanes <= iCount; i += iLanes )
+	{
+		oBank.set_Value( pInputs + i );
+		run_Block( oBank );
+		oBank.read_Value( pOutputs + i );
+	}
+
+	if( i < iCount )
+	{
+		// The last block is padded out to the bank's size.
+		vector< double > vBlock( iLanes, 0.0 );
+
+		copy( pInputs + i, pInputs + iCount, vBlock.begin( ) );
+		oBank.set_Value( vBlock.data( ) );
+		run_Block( oBank );
+		oBank.read_Value( vBlock.data( ) );
+		copy( vBlock.begin( ), vBlock.begin( ) + ( iCount - i ), pOutputs + i );
+	}
+}
+
+// Runs every line over the bank, whose working values are already set.
+void Sweep::run_Block( CalculatorBank& oBank ) const
+{
+	oBank.clear_Mem( );
+
+	for( size_t i = 0; i < m_vSteps.size( ); ++i )
+	{
+		if( m_vSteps[ i ].iProgram < 0 )
+			oBank.apply_Operation( m_vSteps[ i ].oOperation );
+		else
+			oBank.execute_Program( m_vPrograms[ m_vSteps[ i ].iProgram ] );
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef _SWEEP_H
+#define _SWEEP_H
+
+// Name: Sweep.h
+// Description: A parameter sweep: one sequence of calculation lines
+//				applied to many starting values.  Every starting value is a
+//				lane of a CalculatorBank, so a block of values is run one
+//				line at a time with vectorized kernels, and each output is
+//				bit for bit what a Calculator would give starting from that
+//				value.  Evaluation is const, so threads can sweep different
+//				blocks of the same Sweep with banks of their own.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "../Calculator/Calculator.h"
+#include "../Parser/ExprCompiler.h"
+#include "../Parser/LineParser.h"
+#include "CalculatorBank.h"
+#include <cstddef>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+// Lanes a bank sweeps at once.  The working values, memory and a few
+// expression stack slots of a block fit in the L2 cache together.
+#define SWEEP_BLOCK_LANES 1024
+
+/////////////////////////
+// Sweep Declaration   //
+/////////////////////////
+// Lines are those of a calculation script: "(operator) (value)", "s",
+// "r", "q" and compiled expressions, where "ans" is the lane's working
+// value and "mem" its memory.  A lane starts like a new calculator whose
+// working value was set to the starting value.  Lines that read or store
+// a named variable are rejected, since lanes have no variables.
+class Sweep
+{
+public:
+	Sweep( );
+
+	eLineType add_Line( const char* sLine, size_t iLength, Calculator* const m_Calculator,
+						CompileError& oError );
+	size_t get_Line_Count( ) const;
+
+	void evaluate( CalculatorBank& oBank, const double* pInputs, double* pOutputs, size_t iCount ) const;
+
+private:
+	// A line is either a plain operation or a program that reads the lane.
+	struct Step
+	{
+		Operation oOperation;
+		int iProgram;				// Index into m_vPrograms, -1 for an operation
+	};
+
+	void run_Block( CalculatorBank& oBank ) const;
+
+	std::vector< Step > m_vSteps;
+	std::vector< Program > m_vPrograms;
+};
+
+#endif
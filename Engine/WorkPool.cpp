@@ -0,0 +1,304 @@
+// Name: WorkPool.cpp
+// Description: Work-stealing thread pool, see WorkPool.h.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "WorkPool.h"
+
+using namespace std;
+
+/*********************************************************************\
+ *	Constructor and Destructor										 *
+\*********************************************************************/
+
+// Starts the pool's threads, which sleep until the first run.
+//	Parameters:
+//		iThreadCount : unsigned int - Workers including the caller of run,
+//									  0 for one per core.
+//////////////////////////////////////////////////////////////////////
+WorkPool::WorkPool( unsigned int iThreadCount )
+{
+	if( iThreadCount == 0 )
+		iThreadCount = thread::hardware_concurrency( );
+
+	if( iThreadCount == 0 )
+		iThreadCount = 1;
+
+	m_pJob = NULL;
+	m_iOutstanding.store( 0, memory_order_relaxed );
+	m_iBusy.store( 0, memory_order_relaxed );
+	m_iGeneration = 0;
+	m_bStop = false;
+
+	for( unsigned int i = 0; i < iThreadCount; ++i )
+	{
+		Worker* pWorker = new Worker;
+
+		pWorker->iTop.store( 0, memory_order_relaxed );
+		pWorker->iBottom.store( 0, memory_order_relaxed );
+		pWorker->iSteals = 0;
+		pWorker->iRandom = 2463534242U + i * 2654435761U;
+		m_vWorkers.push_back( pWorker );
+	}
+
+	for( unsigned int i = 1; i < iThreadCount; ++i )
+		m_vThreads.push_back( thread( &WorkPool::run_Thread, this, i ) );
+}
+
+WorkPool::~WorkPool( )
+{
+	{
+		lock_guard< mutex > oLock( m_oLock );
+		m_bStop = true;
+	}
+
+	m_oWake.notify_all( );
+
+	for( size_t i = 0; i < m_vThreads.size( ); ++i )
+		m_vThreads[ i ].join( );
+
+	for( size_t i = 0; i < m_vWorkers.size( ); ++i )
+		delete m_vWorkers[ i ];
+}
+
+/*********************************************************************\
+ *	Public Use Functions											 *
+\*********************************************************************/
+
+// Runs a job from its first tasks until no task is left, returning once
+// every worker is done with it.
+//	Parameters:
+//		oJob : Job - What to do with each task.
+//		pTasks : unsigned int* - Tasks to start with, spread over the workers.
+//		iCount : size_t - Number of starting tasks.
+//////////////////////////////////////////////////////////////////////
+void WorkPool::run( Job& oJob, const unsigned int* pTasks, size_t iCount )
+{
+	if( iCount == 0 )
+		return;
+
+	// The pool's threads are asleep, so their deques can be filled from
+	// here; waking them under the lock publishes the tasks.
+	for( size_t i = 0; i < m_vWorkers.size( ); ++i )
+	{
+		m_vWorkers[ i ]->iTop.store( 0, memory_order_relaxed );
+		m_vWorkers[ i ]->iBottom.store( 0, memory_order_relaxed );
+		m_vWorkers[ i ]->vOverflow.clear( );
+	}
+
+	for( size_t i = 0; i < iCount; ++i )
+		push( *m_vWorkers[ i % m_vWorkers.size( ) ], pTasks[ i ] );
+
+	m_pJob = &oJob;
+	m_iOutstanding.store( iCount, memory_order_relaxed );
+
+	if( !m_vThreads.empty( ) )
+	{
+		{
+			lock_guard< mutex > oLock( m_oLock );
+			m_iBusy.store( (unsigned int) m_vThreads.size( ), memory_order_relaxed );
+			++m_iGeneration;
+		}
+
+		m_oWake.notify_all( );
+	}
+
+	work( 0 );
+
+	// The others may still be between their last task and noticing the
+	// run is over; their deques can't be reset until they have.
+	while( m_iBusy.load( memory_order_acquire ) != 0 )
+		this_thread::yield( );
+
+	m_pJob = NULL;
+}
+
+// Adds a task to the current run.  Only a job's execute may call this,
+// with the worker it was called on.
+void WorkPool::spawn( unsigned int iWorker, unsigned int iTask )
+{
+	m_iOutstanding.fetch_add( 1, memory_order_relaxed );
+	push( *m_vWorkers[ iWorker ], iTask );
+}
+
+// Returns the number of workers, including the caller of run.
+unsigned int WorkPool::get_Thread_Count( ) const
+{
+	return (unsigned int) m_vWorkers.size( );
+}
+
+// Returns the number of tasks taken from another worker's deque, over
+// every run so far.
+unsigned long long WorkPool::get_Steals( ) const
+{
+	unsigned long long iSteals = 0;
+
+	for( size_t i = 0; i < m_vWorkers.size( ); ++i )
+		iSteals += m_vWorkers[ i ]->iSteals;
+
+	return iSteals;
+}
+
+/*********************************************************************\
+ *	Private Functions												 *
+\*********************************************************************/
+
+// Body of the pool's threads: sleep until a run starts, work it, repeat.
+void WorkPool::run_Thread( unsigned int iWorker )
+{
+	unsigned long long iSeen = 0;
+
+	for( ;; )
+	{
+		{
+			unique_lock< mutex > oLock( m_oLock );
+
+			m_oWake.wait( oLock, [&]( ) { return m_bStop || m_iGeneration != iSeen; } );
+
+			if( m_bStop )
+				return;
+
+			iSeen = m_iGeneration;
+		}
+
+		work( iWorker );
+		m_iBusy.fetch_sub( 1, memory_order_release );
+	}
+}
+
+// Takes or steals tasks until the run has none left.
+void WorkPool::work( unsigned int iWorker )
+{
+	Worker& oWorker = *m_vWorkers[ iWorker ];
+	unsigned int iTask = 0;
+	unsigned int iIdle = 0;
+
+	while( m_iOutstanding.load( memory_order_acquire ) != 0 )
+	{
+		if( take( oWorker, iTask ) || steal_Any( iWorker, iTask ) )
+		{
+			m_pJob->execute( iTask, iWorker );
+			m_iOutstanding.fetch_sub( 1, memory_order_acq_rel );
+			iIdle = 0;
+		}
+		else if( ++iIdle > WORK_SPIN_LIMIT )
+			this_thread::yield( );
+	}
+}
+
+// Owner side: pushes a task at the bottom, or onto the overflow list when
+// the deque is full.
+void WorkPool::push( Worker& oWorker, unsigned int iTask )
+{
+	long long iBottom = oWorker.iBottom.load( memory_order_relaxed );
+	long long iTop = oWorker.iTop.load( memory_order_acquire );
+
+	if( iBottom - iTop >= WORK_DEQUE_CAPACITY )
+	{
+		oWorker.vOverflow.push_back( iTask );
+		return;
+	}
+
+	// A release store rather than the paper's release fence and relaxed
+	// store: the same on x86, and visible to ThreadSanitizer.
+	oWorker.aTasks[ iBottom & ( WORK_DEQUE_CAPACITY - 1 ) ].store( iTask, memory_order_relaxed );
+	oWorker.iBottom.store( iBottom + 1, memory_order_release );
+}
+
+// Owner side: takes the newest task from the bottom of the deque.  When
+// the deque runs dry, overflowed tasks are moved back into it so thieves
+// can see them again.
+//	Returns:
+//		False if the worker has no tasks left.
+//////////////////////////////////////////////////////////////////////
+bool WorkPool::take( Worker& oWorker, unsigned int& iTask )
+{
+	long long iBottom = oWorker.iBottom.load( memory_order_relaxed ) - 1;
+	long long iTop = 0;
+	bool bTaken = true;
+
+	oWorker.iBottom.store( iBottom, memory_order_relaxed );
+	atomic_thread_fence( memory_order_seq_cst );
+	iTop = oWorker.iTop.load( memory_order_relaxed );
+
+	if( iTop > iBottom )
+	{
+		oWorker.iBottom.store( iBottom + 1, memory_order_relaxed );
+
+		if( oWorker.vOverflow.empty( ) )
+			return false;
+
+		iTask = oWorker.vOverflow.back( );
+		oWorker.vOverflow.pop_back( );
+
+		for( size_t i = 0; i < WORK_DEQUE_CAPACITY && !oWorker.vOverflow.empty( ); ++i )
+		{
+			push( oWorker, oWorker.vOverflow.back( ) );
+			oWorker.vOverflow.pop_back( );
+		}
+
+		return true;
+	}
+
+	iTask = oWorker.aTasks[ iBottom & ( WORK_DEQUE_CAPACITY - 1 ) ].load( memory_order_relaxed );
+
+	// The last task: race the thieves for it.
+	if( iTop == iBottom )
+	{
+		bTaken = oWorker.iTop.compare_exchange_strong( iTop, iTop + 1, memory_order_seq_cst, memory_order_relaxed );
+		oWorker.iBottom.store( iBottom + 1, memory_order_relaxed );
+	}
+
+	return bTaken;
+}
+
+// Thief side: takes the oldest task from another worker's deque.
+//	Returns:
+//		False if the deque was empty or another worker got there first.
+//////////////////////////////////////////////////////////////////////
+bool WorkPool::steal( Worker& oVictim, unsigned int& iTask )
+{
+	long long iTop = oVictim.iTop.load( memory_order_acquire );
+	long long iBottom = 0;
+
+	atomic_thread_fence( memory_order_seq_cst );
+	iBottom = oVictim.iBottom.load( memory_order_acquire );
+
+	if( iTop >= iBottom )
+		return false;
+
+	iTask = oVictim.aTasks[ iTop & ( WORK_DEQUE_CAPACITY - 1 ) ].load( memory_order_relaxed );
+	return oVictim.iTop.compare_exchange_strong( iTop, iTop + 1, memory_order_seq_cst, memory_order_relaxed );
+}
+
+// Tries every other worker once, starting from a random one.
+bool WorkPool::steal_Any( unsigned int iWorker, unsigned int& iTask )
+{
+	Worker& oWorker = *m_vWorkers[ iWorker ];
+	size_t iCount = m_vWorkers.size( );
+	size_t iStart = 0;
+
+	if( iCount < 2 )
+		return false;
+
+	oWorker.iRandom ^= oWorker.iRandom << 13;
+	oWorker.iRandom ^= oWorker.iRandom >> 17;
+	oWorker.iRandom ^= oWorker.iRandom << 5;
+	iStart = oWorker.iRandom % iCount;
+
+	for( size_t i = 0; i < iCount; ++i )
+	{
+		size_t iVictim = ( iStart + i ) % iCount;
+
+		if( iVictim != iWorker && steal( *m_vWorkers[ iVictim ], iTask ) )
+		{
+			++oWorker.iSteals;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,99 @@
+#ifndef _WORKPOOL_H
+#define _WORKPOOL_H
+
+// Name: WorkPool.h
+// Description: Persistent work-stealing thread pool for task graphs that
+//				are only known as they unfold.  Every worker owns a deque
+//				of task numbers: it pushes and takes at the bottom, newest
+//				first, and idle workers steal the oldest task from the top
+//				of someone else's.  The deques are the Chase-Lev deque with
+//				the memory orders of Le, Pop, Cohen and Zappa Nardelli,
+//				"Correct and Efficient Work-Stealing for Weak Memory
+//				Models" (2013).
+//
+//				A deque holds WORK_DEQUE_CAPACITY tasks.  Tasks pushed past
+//				that wait on a private overflow list and move back into the
+//				deque whenever it runs dry, so the deque never resizes and
+//				thieves always have up to that many tasks to pick from.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+#define WORK_DEQUE_CAPACITY		4096		// Stealable tasks per worker, a power of two
+#define WORK_SPIN_LIMIT			64			// Failed steal rounds before a worker yields
+#define WORK_CACHE_LINE			64
+
+/////////////////////////////
+// WorkPool Declaration    //
+/////////////////////////////
+// The thread that calls run is worker 0 and works alongside the pool's
+// threads until every task, including the ones spawned on the way, is
+// done.  Only one run may be in progress at a time.
+class WorkPool
+{
+public:
+	// The work of one run.  execute is called once per task on some worker
+	// and may add tasks with WorkPool::spawn, passing its own iWorker.
+	class Job
+	{
+	public:
+		virtual ~Job( ) {}
+		virtual void execute( unsigned int iTask, unsigned int iWorker ) = 0;
+	};
+
+	explicit WorkPool( unsigned int iThreadCount = 0 );
+	~WorkPool( );
+
+	void run( Job& oJob, const unsigned int* pTasks, size_t iCount );
+	void spawn( unsigned int iWorker, unsigned int iTask );
+
+	unsigned int get_Thread_Count( ) const;
+	unsigned long long get_Steals( ) const;
+
+private:
+	WorkPool( const WorkPool& );
+	WorkPool& operator=( const WorkPool& );
+
+	struct alignas( WORK_CACHE_LINE ) Worker
+	{
+		std::atomic< long long > iTop;					// Thieves take here
+		alignas( WORK_CACHE_LINE ) std::atomic< long long > iBottom;	// The owner works here
+		std::vector< unsigned int > vOverflow;			// Owner only
+		unsigned long long iSteals;
+		unsigned int iRandom;
+		std::atomic< unsigned int > aTasks[ WORK_DEQUE_CAPACITY ];
+	};
+
+	void run_Thread( unsigned int iWorker );
+	void work( unsigned int iWorker );
+	void push( Worker& oWorker, unsigned int iTask );
+	bool take( Worker& oWorker, unsigned int& iTask );
+	bool steal( Worker& oVictim, unsigned int& iTask );
+	bool steal_Any( unsigned int iWorker, unsigned int& iTask );
+
+	std::vector< Worker* > m_vWorkers;
+	std::vector< std::thread > m_vThreads;
+	Job* m_pJob;
+	std::atomic< size_t > m_iOutstanding;		// Tasks spawned but not finished
+	std::atomic< unsigned int > m_iBusy;		// Pool threads still in the current run
+
+	// Wakes the pool's threads for a run.
+	std::mutex m_oLock;
+	std::condition_variable m_oWake;
+	unsigned long long m_iGeneration;
+	bool m_bStop;
+};
+
+#endif
@@ -0,0 +1,255 @@
+// Name: BufferedIO.cpp
+// Description: Implementation of the block buffered reader and writer.
+// Written By: James Coté
+/////////////////////////////////////////////////////////////////////////////
+
+// INCLUDES
+#include <cstdlib>
+#include <cstring>
+#include "BufferedIO.h"
+
+// CONSTANTS
+const char cNEWLINE = '\n';
+const char cCARRIAGE_RETURN = '\r';
+const char cNULL_CHAR = '\0';
+const size_t iMAX_DOUBLE_TEXT = 32;	// "%.17g" never needs more than this
+
+/*************************************************************************\
+ *  BufferedReader                                                       *
+\*************************************************************************/
+
+// Name: BufferedReader
+// Description: Creates a reader over an already opened file.  The reader
+//              does not take ownership of the file.
+// Parameters: pFile - the file to read from.
+//             iBufferSize - initial size of the block buffer in bytes.
+/////////////////////////////////////////////////////////////////////////////
+BufferedReader::BufferedReader( FILE* pFile, size_t iBufferSize )
+{
+    m_pFile = pFile;
+    m_iCapacity = iBufferSize > 0 ? iBufferSize : BUFFERED_IO_DEFAULT_SIZE;
+
+    // One extra byte so the last line can always be null terminated.
+    m_pBuffer = (char*) malloc( m_iCapacity + 1 );
+    m_iStart = 0;
+    m_iEnd = 0;
+    m_bEOF = false;
+    m_bFailed = ( m_pBuffer == NULL );
+}
+
+BufferedReader::~BufferedReader( )
+{
+    free( m_pBuffer );
+}
+
+// Name: refill
+// Description: Moves any partial line to the front of the buffer and reads
+//              the next block behind it.  If the partial line already fills
+//              the buffer, the buffer is doubled first.
+// Return Value: true if any new data was read.
+/////////////////////////////////////////////////////////////////////////////
+bool BufferedReader::refill( )
+{
+    size_t iRemaining = m_iEnd - m_iStart;
+    size_t iRead = 0;
+
+    if( m_bEOF || m_bFailed )
+	return false;
+
+    if( m_iStart > 0 )
+    {
+	memmove( m_pBuffer, m_pBuffer + m_iStart, iRemaining );
+	m_iStart = 0;
+	m_iEnd = iRemaining;
+    }
+
+    if( m_iEnd == m_iCapacity )
+    {
+	char* pGrown = (char*) realloc( m_pBuffer, ( m_iCapacity * 2 ) + 1 );
+
+	if( pGrown == NULL )
+	{
+	    m_bFailed = true;
+	    return false;
+	}
+
+	m_pBuffer = pGrown;
+	m_iCapacity *= 2;
+    }
+
+    iRead = fread( m_pBuffer + m_iEnd, 1, m_iCapacity - m_iEnd, m_pFile );
+    m_iEnd += iRead;
+
+    if( iRead == 0 )
+    {
+	m_bEOF = true;
+	m_bFailed = ( ferror( m_pFile ) != 0 );
+    }
+
+    return iRead > 0;
+}
+
+// Name: next_Line
+// Description: Hands out the next line of input in place.
+// Parameters: sLine - set to the start of the line.
+//             iLength - set to the length of the line, without the newline.
+// Return Value: false once the input is exhausted.
+/////////////////////////////////////////////////////////////////////////////
+bool BufferedReader::next_Line( char*& sLine, size_t& iLength )
+{
+    char* pNewline = NULL;
+    size_t iSearched = 0;
+
+    for( ;; )
+    {
+	pNewline = (char*) memchr( m_pBuffer + m_iStart + iSearched, cNEWLINE,
+				   m_iEnd - m_iStart - iSearched );
+
+	if( pNewline != NULL )
+	    break;
+
+	// Don't search the same bytes again after a refill.
+	iSearched = m_iEnd - m_iStart;
+
+	if( !refill( ) )
+	{
+	    // Out of input, hand out whatever is left as the last line.
+	    if( m_iEnd == m_iStart )
+		return false;
+
+	    pNewline = m_pBuffer + m_iEnd;
+	    break;
+	}
+    }
+
+    sLine = m_pBuffer + m_iStart;
+    iLength = (size_t)( pNewline - sLine );
+    m_iStart = ( pNewline - m_pBuffer ) + ( pNewline == m_pBuffer + m_iEnd ? 0 : 1 );
+
+    if( iLength > 0 && sLine[ iLength - 1 ] == cCARRIAGE_RETURN )
+	--iLength;
+
+    sLine[ iLength ] = cNULL_CHAR;
+
+    return true;
+}
+
+// Name: read_Block
+// Description: Copies raw buffered bytes out of the reader, for callers that
+//              do their own line splitting.  Must not be mixed with next_Line.
+// Parameters: pDest - destination buffer.
+//             iMaxLength - maximum number of bytes to copy.
+// Return Value: the number of bytes copied, 0 once the input is exhausted.
+/////////////////////////////////////////////////////////////////////////////
+size_t BufferedReader::read_Block( char* pDest, size_t iMaxLength )
+{
+    size_t iCopied = 0;
+
+    if( m_iStart == m_iEnd )
+    {
+	m_iStart = m_iEnd = 0;
+
+	if( !refill( ) )
+	    return 0;
+    }
+
+    iCopied = m_iEnd - m_iStart;
+
+    if( iCopied > iMaxLength )
+	iCopied = iMaxLength;
+
+    memcpy( pDest, m_pBuffer + m_iStart, iCopied );
+    m_iStart += iCopied;
+
+    return iCopied;
+}
+
+// Returns true if reading stopped because of an error rather than the end
+// of the input.
+bool BufferedReader::failed( ) const
+{
+    return m_bFailed;
+}
+
+/*************************************************************************\
+ *  BufferedWriter                                                       *
+\*************************************************************************/
+
+// Name: BufferedWriter
+// Description: Creates a writer over an already opened file.  The writer
+//              does not take ownership of the file.
+/////////////////////////////////////////////////////////////////////////////
+BufferedWriter::BufferedWriter( FILE* pFile, size_t iBufferSize )
+{
+    m_pFile = pFile;
+    m_iCapacity = iBufferSize > iMAX_DOUBLE_TEXT ? iBufferSize : BUFFERED_IO_DEFAULT_SIZE;
+    m_pBuffer = (char*) malloc( m_iCapacity );
+    m_iLength = 0;
+
+    if( m_pBuffer == NULL )
+	m_iCapacity = 0;
+}
+
+BufferedWriter::~BufferedWriter( )
+{
+    flush( );
+    free( m_pBuffer );
+}
+
+// Appends raw bytes to the output.
+void BufferedWriter::write( const char* pData, size_t iLength )
+{
+    if( m_iLength + iLength > m_iCapacity )
+    {
+	flush( );
+
+	// Too big to ever fit, write it straight through.
+	if( iLength > m_iCapacity )
+	{
+	    fwrite( pData, 1, iLength, m_pFile );
+	    return;
+	}
+    }
+
+    memcpy( m_pBuffer + m_iLength, pData, iLength );
+    m_iLength += iLength;
+}
+
+// Appends a single character to the output.
+void BufferedWriter::write_Char( char cValue )
+{
+    if( m_iLength == m_iCapacity )
+    {
+	flush( );
+
+	if( m_iCapacity == 0 )
+	{
+	    fputc( cValue, m_pFile );
+	    return;
+	}
+    }
+
+    m_pBuffer[ m_iLength++ ] = cValue;
+}
+
+// Appends a double with enough digits to round trip exactly.
+void BufferedWriter::write_Double( double dValue )
+{
+    char sText[ iMAX_DOUBLE_TEXT ];
+    int iLength = snprintf( sText, iMAX_DOUBLE_TEXT, "%.17g", dValue );
+
+    if( iLength > 0 )
+	write( sText, (size_t) iLength );
+}
+
+// Writes out everything buffered so far.
+void BufferedWriter::flush( )
+{
+    if( m_iLength > 0 )
+    {
+	fwrite( m_pBuffer, 1, m_iLength, m_pFile );
+	m_iLength = 0;
+    }
+
+    fflush( m_pFile );
+}
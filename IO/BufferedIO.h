@@ -0,0 +1,75 @@
+// Name: BufferedIO.h
+// Description: Block buffered readers and writers for non-interactive
+//              input and output.  Lines are handed out in place from a
+//              large buffer instead of being copied out one getline at a
+//              time.
+// Written By: James Coté
+///////////////////////////////////////////////////////////////////////////
+
+// DEFINES
+#ifndef BUFFEREDIO_H
+#define BUFFEREDIO_H
+
+#define BUFFERED_IO_DEFAULT_SIZE ( 1 << 20 )	// 1 MiB blocks
+
+// INCLUDES
+#include <cstddef>
+#include <cstdio>
+
+// CLASS DECLARATIONS:
+
+// Reads a file one line at a time through a large block buffer.  Lines are
+// returned as pointers into the buffer, null terminated with the newline
+// (and any carriage return) stripped.  A returned line is valid until the
+// next call to next_Line.  Lines longer than the buffer grow the buffer, so
+// there is no limit on line length.
+class BufferedReader
+{
+public:
+    BufferedReader( FILE* pFile, size_t iBufferSize = BUFFERED_IO_DEFAULT_SIZE );
+    ~BufferedReader( );
+
+    bool next_Line( char*& sLine, size_t& iLength );
+    size_t read_Block( char* pDest, size_t iMaxLength );
+    bool failed( ) const;
+
+private:
+    BufferedReader( const BufferedReader& );
+    BufferedReader& operator=( const BufferedReader& );
+
+    bool refill( );
+
+    FILE* m_pFile;
+    char* m_pBuffer;
+    size_t m_iCapacity;
+    size_t m_iStart;
+    size_t m_iEnd;
+    bool m_bEOF;
+    bool m_bFailed;
+};
+
+// Collects output in a large block buffer and writes it out in one call
+// when the buffer fills up or when flushed.
+class BufferedWriter
+{
+public:
+    BufferedWriter( FILE* pFile, size_t iBufferSize = BUFFERED_IO_DEFAULT_SIZE );
+    ~BufferedWriter( );
+
+    void write( const char* pData, size_t iLength );
+    void write_Char( char cValue );
+    void write_Double( double dValue );
+    void flush( );
+
+private:
+    BufferedWriter( const BufferedWriter& );
+    BufferedWriter& operator=( const BufferedWriter& );
+
+    FILE* m_pFile;
+    char* m_pBuffer;
+    size_t m_iCapacity;
+    size_t m_iLength;
+};
+
+// End of our define.
+#endif
@@ -0,0 +1,719 @@
+// Name: Journal.cpp
+// Description: Write-ahead journal and snapshots for a Calculator session.
+// Written By: James Coté
+/////////////////////////////////////////////////////////////////////////////
+
+// INCLUDES
+#include "Journal.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// CONSTANTS
+const size_t iMAGIC_SIZE = 4;
+const char* const sSNAPSHOT_FILE = "/snapshot";
+const char* const sJOURNAL_FILE = "/journal";
+const char* const sTEMP_SUFFIX = ".tmp";
+
+/*************************************************************************\
+ *  File Helpers                                                         *
+\*************************************************************************/
+
+// Name: open_File
+// Description: Opens a file for reading and writing, creating it if needed.
+// Return Value: The descriptor, or -1 on failure.
+/////////////////////////////////////////////////////////////////////////////
+static int open_File( const string& sPath, bool bTruncate )
+{
+#ifdef _WIN32
+    return _open( sPath.c_str( ), _O_RDWR | _O_CREAT | _O_BINARY | ( bTruncate ? _O_TRUNC : 0 ),
+		  _S_IREAD | _S_IWRITE );
+#else
+    return ::open( sPath.c_str( ), O_RDWR | O_CREAT | ( bTruncate ? O_TRUNC : 0 ), 0644 );
+#endif
+}
+
+static void close_File( int iFile )
+{
+#ifdef _WIN32
+    _close( iFile );
+#else
+    ::close( iFile );
+#endif
+}
+
+// Name: write_All
+// Description: Writes the whole buffer, retrying short writes.
+/////////////////////////////////////////////////////////////////////////////
+static bool write_All( int iFile, const unsigned char* pData, size_t iSize )
+{
+    while( iSize > 0 )
+    {
+#ifdef _WIN32
+	int iWritten = _write( iFile, pData, (unsigned int) iSize );
+#else
+	ssize_t iWritten = ::write( iFile, pData, iSize );
+
+	if( iWritten < 0 && errno == EINTR )
+	    continue;
+#endif
+	if( iWritten <= 0 )
+	    return false;
+
+	pData += iWritten;
+	iSize -= (size_t) iWritten;
+    }
+
+    return true;
+}
+
+// Name: read_Some
+// Description: Reads up to iSize bytes.
+// Return Value: Bytes read, 0 at end of file or on error.
+/////////////////////////////////////////////////////////////////////////////
+static size_t read_Some( int iFile, unsigned char* pData, size_t iSize )
+{
+#ifdef _WIN32
+    int iRead = _read( iFile, pData, (unsigned int) iSize );
+#else
+    ssize_t iRead = 0;
+
+    do
+	iRead = ::read( iFile, pData, iSize );
+    while( iRead < 0 && errno == EINTR );
+#endif
+
+    return iRead > 0 ? (size_t) iRead : 0;
+}
+
+// Name: sync_Data
+// Description: Forces written data to stable storage.  Metadata that isn't
+//              needed to read the data back (timestamps) is skipped where
+//              the platform allows it.
+/////////////////////////////////////////////////////////////////////////////
+static bool sync_Data( int iFile )
+{
+#if defined( _WIN32 )
+    return _commit( iFile ) == 0;
+#elif defined( __APPLE__ )
+    return fsync( iFile ) == 0;
+#else
+    return fdatasync( iFile ) == 0;
+#endif
+}
+
+// Name: sync_Directory
+// Description: Makes renames inside a directory durable.
+/////////////////////////////////////////////////////////////////////////////
+static bool sync_Directory( const string& sDirectory )
+{
+#ifdef _WIN32
+    // MoveFileEx with MOVEFILE_WRITE_THROUGH already flushed the rename.
+    (void) sDirectory;
+    return true;
+#else
+    int iDirectory = ::open( sDirectory.c_str( ), O_RDONLY );
+    bool bSuccess = false;
+
+    if( iDirectory < 0 )
+	return false;
+
+    bSuccess = ( fsync( iDirectory ) == 0 );
+    ::close( iDirectory );
+
+    return bSuccess;
+#endif
+}
+
+// Name: replace_File
+// Description: Atomically moves a file over another one.
+/////////////////////////////////////////////////////////////////////////////
+static bool replace_File( const string& sFrom, const string& sTo )
+{
+#ifdef _WIN32
+    return MoveFileExA( sFrom.c_str( ), sTo.c_str( ),
+			MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) != 0;
+#else
+    return rename( sFrom.c_str( ), sTo.c_str( ) ) == 0;
+#endif
+}
+
+static bool make_Directory( const string& sDirectory )
+{
+#ifdef _WIN32
+    return _mkdir( sDirectory.c_str( ) ) == 0 || errno == EEXIST;
+#else
+    return mkdir( sDirectory.c_str( ), 0755 ) == 0 || errno == EEXIST;
+#endif
+}
+
+static bool truncate_File( int iFile, unsigned long long iSize )
+{
+#ifdef _WIN32
+    return _chsize_s( iFile, (long long) iSize ) == 0 &&
+	   _lseeki64( iFile, 0, SEEK_END ) >= 0;
+#else
+    return ftruncate( iFile, (off_t) iSize ) == 0 &&
+	   lseek( iFile, 0, SEEK_END ) >= 0;
+#endif
+}
+
+// Name: mix
+// Description: One round of a 64 bit multiply-xorshift hash.  Used for the
+//              snapshot check and the journal salt, which only need to
+//              catch torn and stale data, not tampering.
+/////////////////////////////////////////////////////////////////////////////
+static inline unsigned long long mix( unsigned long long iHash, unsigned long long iValue )
+{
+    iHash = ( iHash ^ iValue ) * 0xFF51AFD7ED558CCDULL;
+    return iHash ^ ( iHash >> 32 );
+}
+
+static inline unsigned long long get_Bits( double dValue )
+{
+    unsigned long long iBits = 0;
+
+    memcpy( &iBits, &dValue, sizeof( double ) );
+    return iBits;
+}
+
+// Name: build_Header
+// Description: Fills in a journal header.  Like the op log, fields are
+//              copied in host order, which is little endian everywhere we
+//              build.
+/////////////////////////////////////////////////////////////////////////////
+static void build_Header( unsigned char* pHeader, const char* sMagic,
+			  unsigned long long iGeneration )
+{
+    unsigned int iVersion = JOURNAL_VERSION;
+
+    memcpy( pHeader, sMagic, iMAGIC_SIZE );
+    memcpy( pHeader + 4, &iVersion, sizeof( iVersion ) );
+    memcpy( pHeader + 8, &iGeneration, sizeof( iGeneration ) );
+}
+
+static bool check_Header( const unsigned char* pHeader, const char* sMagic,
+			  unsigned long long& iGeneration )
+{
+    unsigned int iVersion = 0;
+
+    memcpy( &iVersion, pHeader + 4, sizeof( iVersion ) );
+    memcpy( &iGeneration, pHeader + 8, sizeof( iGeneration ) );
+
+    return memcmp( pHeader, sMagic, iMAGIC_SIZE ) == 0 && iVersion == JOURNAL_VERSION;
+}
+
+// Returns the salt that ties journal records to their generation.
+static unsigned long long get_Salt( unsigned long long iGeneration )
+{
+    return mix( mix( 0x9E3779B97F4A7C15ULL, iGeneration ), 0 );
+}
+
+/*************************************************************************\
+ *  Constructor / Destructor                                             *
+\*************************************************************************/
+
+// Name: Journal
+// Parameters: iSyncMilliseconds - Longest time appended records may sit
+//                                 in the OS cache before an fdatasync.
+//             iSnapshotInterval - Records between automatic snapshots.
+/////////////////////////////////////////////////////////////////////////////
+Journal::Journal( unsigned int iSyncMilliseconds, unsigned long long iSnapshotInterval )
+{
+    m_pCalculator = NULL;
+    m_iFile = -1;
+    m_iGeneration = 0;
+    m_iSalt = get_Salt( 0 );
+    m_iSequence = 0;
+    m_iRecovered = 0;
+    m_iSnapshotInterval = iSnapshotInterval > 0 ? iSnapshotInterval : 1;
+    m_oSyncInterval = chrono::milliseconds( iSyncMilliseconds > 0 ? iSyncMilliseconds : 1 );
+    m_iBuffered = 0;
+    m_pFilling = m_aBuffers[ 0 ];
+    m_pPending = NULL;
+    m_iPendingSize = 0;
+    m_iSyncRequested = 0;
+    m_iSyncCompleted = 0;
+    m_bDirty = false;
+    m_bStop = false;
+    m_sError = NULL;
+}
+
+Journal::~Journal( )
+{
+    close( );
+}
+
+/*************************************************************************\
+ *  Public Use Functions                                                 *
+\*************************************************************************/
+
+// Name: open
+// Description: Opens (or creates) a session directory and restores the
+//              calculator to the last recorded state: the snapshot, then
+//              every intact journal record after it.
+// Parameters: sDirectory - Session directory.
+//             m_Calculator - Calculator to restore and record.
+// Return Value: false if the session could not be restored; see get_Error.
+/////////////////////////////////////////////////////////////////////////////
+bool Journal::open( const char* sDirectory, Calculator* const m_Calculator )
+{
+    close( );
+
+    m_pCalculator = m_Calculator;
+    m_sDirectory = sDirectory;
+    m_iGeneration = 0;
+    m_iSequence = 0;
+    m_iRecovered = 0;
+    m_iBuffered = 0;
+    m_pFilling = m_aBuffers[ 0 ];
+    m_pPending = NULL;
+    m_iSyncRequested = m_iSyncCompleted = 0;
+    m_bDirty = false;
+    m_bStop = false;
+    m_sError = NULL;
+
+    if( !make_Directory( m_sDirectory ) )
+	return fail( "unable to create the session directory" );
+
+    if( !recover( ) )
+    {
+	if( m_iFile >= 0 )
+	{
+	    close_File( m_iFile );
+	    m_iFile = -1;
+	}
+
+	return false;
+    }
+
+    m_oLastSync = chrono::steady_clock::now( );
+    m_oWriter = thread( &Journal::run_Writer, this );
+
+    // Keep the next restart as short as this one.
+    if( m_iSequence >= m_iSnapshotInterval )
+	return snapshot( );
+
+    return true;
+}
+
+// Name: commit
+// Description: Hands off buffered records and waits for them to reach
+//              stable storage.
+// Return Value: false if the journal has failed.
+/////////////////////////////////////////////////////////////////////////////
+bool Journal::commit( )
+{
+    unsigned long long iTicket = 0;
+
+    if( !m_oWriter.joinable( ) )
+	return get_Error( ) == NULL;
+
+    if( m_iBuffered > 0 )
+	write_Group( );
+
+    unique_lock< mutex > oLock( m_oLock );
+
+    iTicket = ++m_iSyncRequested;
+    m_oWake.notify_one( );
+    m_oDone.wait( oLock, [ this, iTicket ] { return m_iSyncCompleted >= iTicket; } );
+
+    return m_sError == NULL;
+}
+
+// Name: snapshot
+// Description: Saves the calculator's state as a new snapshot and starts
+//              an empty journal after it.  The snapshot is durable before
+//              the old journal is dropped, so a crash in between only
+//              leaves a stale journal that recovery ignores.
+// Return Value: false if the journal has failed.
+/////////////////////////////////////////////////////////////////////////////
+bool Journal::snapshot( )
+{
+    if( !m_oWriter.joinable( ) || !commit( ) )
+	return false;
+
+    // The writer is idle and clean after a commit; holding the lock keeps
+    // it off the journal while the files are swapped.
+    lock_guard< mutex > oLock( m_oLock );
+
+    ++m_iGeneration;
+    m_iSalt = get_Salt( m_iGeneration );
+
+    if( !write_Snapshot( ) )
+	return fail( "error writing the snapshot" );
+
+    return start_Journal( );
+}
+
+// Name: close
+// Description: Commits anything outstanding, stops the writer and closes
+//              the journal.
+// Return Value: false if the journal has failed.
+/////////////////////////////////////////////////////////////////////////////
+bool Journal::close( )
+{
+    bool bSuccess = commit( );
+
+    if( m_oWriter.joinable( ) )
+    {
+	{
+	    lock_guard< mutex > oLock( m_oLock );
+	    m_bStop = true;
+	}
+
+	m_oWake.notify_one( );
+	m_oWriter.join( );
+    }
+
+    if( m_iFile >= 0 )
+    {
+	close_File( m_iFile );
+	m_iFile = -1;
+    }
+
+    return bSuccess;
+}
+
+// Name: append
+// Description: Records a run of operations that were just applied to the
+//              calculator together, such as one evaluated by AffineScan.
+//              The calculator only matches the journal at the end of the
+//              run, so no snapshot is taken before then.  The run must not
+//              use variables, whose values are read at append time.
+/////////////////////////////////////////////////////////////////////////////
+void Journal::append( const Operation* pOperations, size_t iCount )
+{
+    for( size_t i = 0; i < iCount; ++i )
+    {
+	encode_Record( m_pFilling + m_iBuffered * JOURNAL_RECORD_SIZE, pOperations[ i ], m_iSequence++ );
+
+	if( ++m_iBuffered == JOURNAL_GROUP_RECORDS )
+	    write_Group( );
+    }
+
+    if( m_iSequence >= m_iSnapshotInterval )
+	snapshot( );
+}
+
+// Name: append_Variable
+// Description: Records an operation on a variable as one without it.  A
+//              store into a variable leaves nothing to record; an operand
+//              read from one is recorded as the value it had, which it
+//              still has right after the operation was applied.
+/////////////////////////////////////////////////////////////////////////////
+void Journal::append_Variable( const Operation& oOperation )
+{
+    Operation oResolved;
+
+    if( oOperation.cOpCode == OP_CODE_STORE_VAR )
+	return;
+
+    oResolved.cOpCode = (unsigned char) op_Operator( oOperation.cOpCode );
+    oResolved.iSlot = 0;
+    oResolved.dValue = m_pCalculator->pull_Var( oOperation.iSlot );
+    append( oResolved );
+}
+
+// Returns why the journal failed, or NULL if it hasn't.
+const char* Journal::get_Error( ) const
+{
+    lock_guard< mutex > oLock( m_oLock );
+
+    return m_sError;
+}
+
+// Returns the number of journal records replayed by open.
+unsigned long long Journal::get_Recovered( ) const
+{
+    return m_iRecovered;
+}
+
+/*************************************************************************\
+ *  Private Functions                                                    *
+\*************************************************************************/
+
+// Name: write_Group
+// Description: Hands the filling buffer to the writer thread and switches
+//              to the other one, waiting first if the writer hasn't
+//              finished with it yet.
+/////////////////////////////////////////////////////////////////////////////
+void Journal::write_Group( )
+{
+    unique_lock< mutex > oLock( m_oLock );
+
+    m_oDone.wait( oLock, [ this ] { return m_pPending == NULL; } );
+
+    m_pPending = m_pFilling;
+    m_iPendingSize = m_iBuffered * JOURNAL_RECORD_SIZE;
+    m_pFilling = m_pFilling == m_aBuffers[ 0 ] ? m_aBuffers[ 1 ] : m_aBuffers[ 0 ];
+    m_iBuffered = 0;
+
+    m_oWake.notify_one( );
+}
+
+// Name: end_Group
+// Description: Hands off a full buffer from single appends, where the
+//              calculator always matches the journal, and folds the journal
+//              into a snapshot once it reaches the snapshot interval.
+/////////////////////////////////////////////////////////////////////////////
+void Journal::end_Group( )
+{
+    if( m_iSequence >= m_iSnapshotInterval )
+	snapshot( );
+    else
+	write_Group( );
+}
+
+// Name: run_Writer
+// Description: Writer thread.  Writes each buffer it is handed and syncs
+//              when a commit asks for it, or once written data has waited
+//              a full sync interval.  Many appends share one fdatasync.
+/////////////////////////////////////////////////////////////////////////////
+void Journal::run_Writer( )
+{
+    unique_lock< mutex > oLock( m_oLock );
+
+    while( true )
+    {
+	m_oWake.wait_for( oLock, m_oSyncInterval, [ this ]
+	{
+	    return m_bStop || m_pPending != NULL || m_iSyncRequested != m_iSyncCompleted;
+	} );
+
+	unsigned char* pData = m_pPending;
+	size_t iSize = m_iPendingSize;
+	unsigned long long iTicket = m_iSyncRequested;
+	bool bSync = iTicket != m_iSyncCompleted ||
+		     ( m_bDirty && chrono::steady_clock::now( ) - m_oLastSync >= m_oSyncInterval );
+	bool bHealthy = m_sError == NULL;
+	const char* sError = NULL;
+
+	if( pData == NULL && !bSync )
+	{
+	    if( m_bStop )
+		break;
+
+	    continue;
+	}
+
+	oLock.unlock( );
+
+	if( bHealthy && pData != NULL && !write_All( m_iFile, pData, iSize ) )
+	    sError = "error writing the journal";
+
+	if( bHealthy && sError == NULL && bSync && !sync_Data( m_iFile ) )
+	    sError = "error syncing the journal";
+
+	oLock.lock( );
+
+	if( sError != NULL )
+	    fail( sError );
+
+	m_bDirty = ( m_bDirty || pData != NULL ) && !bSync;
+
+	if( pData != NULL )
+	    m_pPending = NULL;
+
+	if( bSync )
+	{
+	    m_oLastSync = chrono::steady_clock::now( );
+	    m_iSyncCompleted = iTicket;
+	}
+
+	m_oDone.notify_all( );
+    }
+}
+// Name: recover
+// Description: Loads the snapshot, then replays the journal if it belongs
+//              to that snapshot.  A torn tail is cut off so new records
+//              follow the last intact one.
+/////////////////////////////////////////////////////////////////////////////
+bool Journal::recover( )
+{
+    unsigned char aSnapshot[ SNAPSHOT_SIZE ];
+    unsigned long long iJournalGeneration = 0;
+    string sJournalPath = m_sDirectory + sJOURNAL_FILE;
+    int iFile = open_File( m_sDirectory + sSNAPSHOT_FILE, false );
+    bool bIntact = true;
+    size_t iRead = 0;
+
+    if( iFile < 0 )
+	return fail( "unable to open the snapshot" );
+
+    iRead = read_Some( iFile, aSnapshot, SNAPSHOT_SIZE );
+    close_File( iFile );
+
+    m_pCalculator->set_Value( 0.0 );
+    m_pCalculator->set_Mem( 0.0 );
+
+    // An empty snapshot is a new session.
+    if( iRead > 0 )
+    {
+	double dValue = 0.0, dMemory = 0.0;
+	unsigned long long iCheck = 0;
+
+	if( iRead != SNAPSHOT_SIZE || !check_Header( aSnapshot, SNAPSHOT_MAGIC, m_iGeneration ) )
+	    return fail( "the snapshot is damaged" );
+
+	memcpy( &dValue, aSnapshot + 16, sizeof( double ) );
+	memcpy( &dMemory, aSnapshot + 24, sizeof( double ) );
+	memcpy( &iCheck, aSnapshot + 32, sizeof( iCheck ) );
+
+	if( iCheck != mix( mix( mix( 0, m_iGeneration ), get_Bits( dValue ) ), get_Bits( dMemory ) ) )
+	    return fail( "the snapshot is damaged" );
+
+	m_pCalculator->set_Value( dValue );
+	m_pCalculator->set_Mem( dMemory );
+    }
+
+    m_iSalt = get_Salt( m_iGeneration );
+
+    m_iFile = open_File( sJournalPath, false );
+
+    if( m_iFile < 0 )
+	return fail( "unable to open the journal" );
+
+    if( read_Some( m_iFile, m_aBuffers[ 0 ], JOURNAL_HEADER_SIZE ) != JOURNAL_HEADER_SIZE ||
+	!check_Header( m_aBuffers[ 0 ], JOURNAL_MAGIC, iJournalGeneration ) ||
+	iJournalGeneration < m_iGeneration )
+    {
+	// Missing, never finished, or already folded into the snapshot.
+	close_File( m_iFile );
+	m_iFile = -1;
+	return start_Journal( );
+    }
+
+    if( iJournalGeneration > m_iGeneration )
+    {
+	close_File( m_iFile );
+	m_iFile = -1;
+	return fail( "the journal is newer than the snapshot" );
+    }
+
+    // Read whole groups; a partial record at the end is simply dropped.
+    while( bIntact && ( iRead = read_Some( m_iFile, m_aBuffers[ 0 ], sizeof( m_aBuffers[ 0 ] ) ) ) > 0 )
+    {
+	for( size_t i = 0; i + JOURNAL_RECORD_SIZE <= iRead; i += JOURNAL_RECORD_SIZE )
+	{
+	    const unsigned char* pRecord = m_aBuffers[ 0 ] + i;
+	    Operation oOperation;
+	    unsigned long long iBits = 0;
+	    unsigned int iCheck = 0;
+
+	    memcpy( &iCheck, pRecord + 4, sizeof( iCheck ) );
+	    memcpy( &iBits, pRecord + 8, sizeof( iBits ) );
+
+	    if( iCheck != record_Check( m_iSalt, m_iSequence, pRecord[ 0 ], iBits ) )
+	    {
+		bIntact = false;
+		break;
+	    }
+
+	    oOperation.cOpCode = pRecord[ 0 ];
+	    memcpy( &oOperation.dValue, &iBits, sizeof( double ) );
+	    m_pCalculator->apply_Operation( oOperation );
+	    ++m_iSequence;
+	}
+
+	if( iRead % JOURNAL_RECORD_SIZE != 0 )
+	    bIntact = false;
+    }
+
+    m_iRecovered = m_iSequence;
+
+    if( !truncate_File( m_iFile, JOURNAL_HEADER_SIZE + m_iSequence * JOURNAL_RECORD_SIZE ) )
+	return fail( "unable to repair the journal" );
+
+    return true;
+}
+
+// Name: write_Snapshot
+// Description: Writes the calculator's state to a temporary file, syncs it
+//              and renames it over the current snapshot.
+/////////////////////////////////////////////////////////////////////////////
+bool Journal::write_Snapshot( )
+{
+    unsigned char aSnapshot[ SNAPSHOT_SIZE ];
+    string sPath = m_sDirectory + sSNAPSHOT_FILE;
+    string sTempPath = sPath + sTEMP_SUFFIX;
+    double dValue = m_pCalculator->read_Value( );
+    double dMemory = m_pCalculator->pull_Mem( );
+    unsigned long long iCheck = mix( mix( mix( 0, m_iGeneration ), get_Bits( dValue ) ), get_Bits( dMemory ) );
+    int iFile = open_File( sTempPath, true );
+    bool bSuccess = false;
+
+    if( iFile < 0 )
+	return false;
+
+    build_Header( aSnapshot, SNAPSHOT_MAGIC, m_iGeneration );
+    memcpy( aSnapshot + 16, &dValue, sizeof( double ) );
+    memcpy( aSnapshot + 24, &dMemory, sizeof( double ) );
+    memcpy( aSnapshot + 32, &iCheck, sizeof( iCheck ) );
+
+    bSuccess = write_All( iFile, aSnapshot, SNAPSHOT_SIZE ) && sync_Data( iFile );
+    close_File( iFile );
+
+    return bSuccess && replace_File( sTempPath, sPath ) && sync_Directory( m_sDirectory );
+}
+
+// Name: start_Journal
+// Description: Replaces the journal with an empty one for the current
+//              generation and opens it for appending.
+/////////////////////////////////////////////////////////////////////////////
+bool Journal::start_Journal( )
+{
+    unsigned char aHeader[ JOURNAL_HEADER_SIZE ];
+    string sPath = m_sDirectory + sJOURNAL_FILE;
+    string sTempPath = sPath + sTEMP_SUFFIX;
+    int iFile = open_File( sTempPath, true );
+
+    if( m_iFile >= 0 )
+    {
+	close_File( m_iFile );
+	m_iFile = -1;
+    }
+
+    if( iFile < 0 )
+	return fail( "unable to create the journal" );
+
+    build_Header( aHeader, JOURNAL_MAGIC, m_iGeneration );
+
+    if( !write_All( iFile, aHeader, JOURNAL_HEADER_SIZE ) || !sync_Data( iFile ) )
+    {
+	close_File( iFile );
+	return fail( "unable to create the journal" );
+    }
+
+    if( !replace_File( sTempPath, sPath ) || !sync_Directory( m_sDirectory ) )
+    {
+	close_File( iFile );
+	return fail( "unable to create the journal" );
+    }
+
+    m_iFile = iFile;
+    m_iSequence = 0;
+
+    return true;
+}
+
+bool Journal::fail( const char* sError )
+{
+    if( m_sError == NULL )
+	m_sError = sError;
+
+    return false;
+}
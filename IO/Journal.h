@@ -0,0 +1,169 @@
+// Name: Journal.h
+// Description: Crash-safe persistence for a Calculator session.
+//
+//              A session directory holds two files:
+//                  snapshot:  the working value and memory at some point,
+//                             tagged with a generation number.
+//                  journal:   every operation applied since that snapshot,
+//                             in order, tagged with the same generation.
+//
+//              Layout (little endian):
+//                  snapshot:  char[4] magic "CSNP"
+//                             uint32  version (JOURNAL_VERSION)
+//                             uint64  generation
+//                             double  working value
+//                             double  memory
+//                             uint64  check
+//                  journal:   char[4] magic "CJNL"
+//                             uint32  version (JOURNAL_VERSION)
+//                             uint64  generation
+//                  records:   uint8   op code (Operation::cOpCode)
+//                             uint8   reserved[3]
+//                             uint32  check
+//                             double  operand
+//
+//              Each record's check covers its generation and position, so
+//              a torn or stale tail is detected and cut off on recovery.
+//
+//              Appends only encode into a buffer.  Full buffers are handed
+//              to a writer thread, which writes them while the next one
+//              fills and runs fdatasync at most once per sync interval, or
+//              when commit( ) asks for it (group commit).
+//              Every snapshot interval records the journal is folded into
+//              a new snapshot and started over, so recovery never replays
+//              more than one interval no matter how long the session is.
+//
+//              Variables aren't kept: stores to them aren't recorded, and
+//              an operand read from one is recorded as its value, so the
+//              working value and memory still recover exactly.
+// Written By: James Coté
+///////////////////////////////////////////////////////////////////////////
+
+// DEFINES
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#define JOURNAL_MAGIC                       "CJNL"
+#define SNAPSHOT_MAGIC                      "CSNP"
+#define JOURNAL_VERSION                     1
+#define JOURNAL_HEADER_SIZE                 16
+#define JOURNAL_RECORD_SIZE                 16
+#define SNAPSHOT_SIZE                       40
+#define JOURNAL_GROUP_RECORDS               4096            // Records handed off per write( )
+#define JOURNAL_DEFAULT_SYNC_MS             10              // Longest gap between fdatasyncs
+#define JOURNAL_DEFAULT_SNAPSHOT_INTERVAL   ( 1ULL << 20 )  // Records between snapshots
+
+// INCLUDES
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "../Calculator/Calculator.h"
+
+// CLASS DECLARATIONS:
+
+// Records the operations applied to one Calculator and restores it.
+class Journal
+{
+public:
+    Journal( unsigned int iSyncMilliseconds = JOURNAL_DEFAULT_SYNC_MS,
+	     unsigned long long iSnapshotInterval = JOURNAL_DEFAULT_SNAPSHOT_INTERVAL );
+    ~Journal( );
+
+    bool open( const char* sDirectory, Calculator* const m_Calculator );
+    bool commit( );
+    bool snapshot( );
+    bool close( );
+
+    void append( const Operation* pOperations, size_t iCount );
+    const char* get_Error( ) const;
+    unsigned long long get_Recovered( ) const;
+
+    // Records an operation that was just applied to the calculator.
+    inline void append( const Operation& oOperation )
+    {
+	unsigned char* pRecord = m_pFilling + m_iBuffered * JOURNAL_RECORD_SIZE;
+
+	if( op_TouchesVar( oOperation.cOpCode ) )
+	{
+	    append_Variable( oOperation );
+	    return;
+	}
+
+	encode_Record( pRecord, oOperation, m_iSequence++ );
+
+	if( ++m_iBuffered == JOURNAL_GROUP_RECORDS )
+	    end_Group( );
+    }
+
+private:
+    Journal( const Journal& );
+    Journal& operator=( const Journal& );
+
+    // A record's check: one multiply over its operand, position and the
+    // generation's salt.  Enough to catch torn and stale records.
+    static inline unsigned int record_Check( unsigned long long iSalt, unsigned long long iSequence,
+					     unsigned char cOpCode, unsigned long long iBits )
+    {
+	unsigned long long iHash = ( iBits ^ iSalt ^ ( iSequence * 0x9E3779B97F4A7C15ULL ) ) * 0xFF51AFD7ED558CCDULL;
+
+	return (unsigned int)( iHash >> 32 ) ^ cOpCode;
+    }
+
+    inline void encode_Record( unsigned char* pRecord, const Operation& oOperation,
+			       unsigned long long iSequence ) const
+    {
+	unsigned long long iBits = 0;
+	unsigned int iCheck = 0;
+
+	memcpy( &iBits, &oOperation.dValue, sizeof( double ) );
+	iCheck = record_Check( m_iSalt, iSequence, oOperation.cOpCode, iBits );
+
+	pRecord[ 0 ] = oOperation.cOpCode;
+	pRecord[ 1 ] = pRecord[ 2 ] = pRecord[ 3 ] = 0;
+	memcpy( pRecord + 4, &iCheck, sizeof( iCheck ) );
+	memcpy( pRecord + 8, &iBits, sizeof( iBits ) );
+    }
+
+    void append_Variable( const Operation& oOperation );
+    void write_Group( );
+    void end_Group( );
+    void run_Writer( );
+    bool recover( );
+    bool write_Snapshot( );
+    bool start_Journal( );
+    bool fail( const char* sError );
+
+    Calculator* m_pCalculator;
+    std::string m_sDirectory;
+    int m_iFile;
+    unsigned long long m_iGeneration;
+    unsigned long long m_iSalt;
+    unsigned long long m_iSequence;
+    unsigned long long m_iRecovered;
+    unsigned long long m_iSnapshotInterval;
+    std::chrono::steady_clock::duration m_oSyncInterval;
+    size_t m_iBuffered;
+    unsigned char* m_pFilling;
+
+    // Shared with the writer thread, guarded by m_oLock.
+    std::thread m_oWriter;
+    mutable std::mutex m_oLock;
+    std::condition_variable m_oWake;
+    std::condition_variable m_oDone;
+    unsigned char* m_pPending;
+    size_t m_iPendingSize;
+    unsigned long long m_iSyncRequested;
+    unsigned long long m_iSyncCompleted;
+    std::chrono::steady_clock::time_point m_oLastSync;
+    bool m_bDirty;
+    bool m_bStop;
+    const char* m_sError;
+
+    unsigned char m_aBuffers[ 2 ][ JOURNAL_GROUP_RECORDS * JOURNAL_RECORD_SIZE ];
+};
+
+// End of our define.
+#endif
@@ -0,0 +1,257 @@
+// Name: MatrixFile.cpp
+// Description: CSV and binary matrix files, see MatrixFile.h.
+// Written By: James Coté
+/////////////////////////////////////////////////////////////////////////////
+
+// INCLUDES
+#include "MatrixFile.h"
+#include "BufferedIO.h"
+#include "../Parser/NumberParser.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// CONSTANTS
+const size_t iMAGIC_SIZE = 4;
+const char sUTF8_BOM[] = "\xEF\xBB\xBF";
+
+// Name: write_Le32 / write_Le64 / read_Le32 / read_Le64
+// Description: Header integers are little endian regardless of the host.
+/////////////////////////////////////////////////////////////////////////////
+static void write_Le32( unsigned char* pDest, unsigned long iValue )
+{
+    for( int i = 0; i < 4; ++i )
+	pDest[ i ] = (unsigned char)( iValue >> ( 8 * i ) );
+}
+
+static void write_Le64( unsigned char* pDest, unsigned long long iValue )
+{
+    for( int i = 0; i < 8; ++i )
+	pDest[ i ] = (unsigned char)( iValue >> ( 8 * i ) );
+}
+
+static unsigned long read_Le32( const unsigned char* pSource )
+{
+    unsigned long iValue = 0;
+
+    for( int i = 3; i >= 0; --i )
+	iValue = ( iValue << 8 ) | pSource[ i ];
+
+    return iValue;
+}
+
+static unsigned long long read_Le64( const unsigned char* pSource )
+{
+    unsigned long long iValue = 0;
+
+    for( int i = 7; i >= 0; --i )
+	iValue = ( iValue << 8 ) | pSource[ i ];
+
+    return iValue;
+}
+
+static inline bool is_Blank( char c )
+{
+    return c == ' ' || c == '\t';
+}
+
+// Name: load_Binary
+// Description: Reads the rest of a binary matrix, after its magic.
+/////////////////////////////////////////////////////////////////////////////
+static eMatrixStatus load_Binary( FILE* pFile, Matrix& oMatrix )
+{
+    unsigned char aHeader[ MATRIX_FILE_HEADER_SIZE ];
+    unsigned long long iRows = 0;
+    unsigned long long iColumns = 0;
+    eMatrixStatus eStatus = MATRIX_OK;
+
+    if( fread( aHeader + iMAGIC_SIZE, 1, MATRIX_FILE_HEADER_SIZE - iMAGIC_SIZE, pFile ) !=
+	MATRIX_FILE_HEADER_SIZE - iMAGIC_SIZE )
+	return MATRIX_FILE_MALFORMED;
+
+    iRows = read_Le64( aHeader + 8 );
+    iColumns = read_Le64( aHeader + 16 );
+
+    if( read_Le32( aHeader + 4 ) != MATRIX_FILE_VERSION || iRows == 0 || iColumns == 0 )
+	return MATRIX_FILE_MALFORMED;
+
+    if( iRows > MATRIX_MAX_ELEMENTS / iColumns )
+	return MATRIX_TOO_LARGE;
+
+    eStatus = oMatrix.resize( (size_t) iRows, (size_t) iColumns );
+
+    if( eStatus != MATRIX_OK )
+	return eStatus;
+
+    if( fread( oMatrix.data( ), sizeof( double ), oMatrix.size( ), pFile ) != oMatrix.size( ) )
+	return ferror( pFile ) ? MATRIX_FILE_UNREADABLE : MATRIX_FILE_MALFORMED;
+
+    return MATRIX_OK;
+}
+
+// Name: load_Csv
+// Description: Reads a CSV matrix from the start of the file.
+/////////////////////////////////////////////////////////////////////////////
+static eMatrixStatus load_Csv( FILE* pFile, Matrix& oMatrix )
+{
+    BufferedReader oReader( pFile );
+    std::vector< double > vValues;
+    size_t iRows = 0;
+    size_t iColumns = 0;
+    char* sLine = NULL;
+    size_t iLength = 0;
+    eMatrixStatus eStatus = MATRIX_OK;
+
+    while( oReader.next_Line( sLine, iLength ) )
+    {
+	const char* pCurr = sLine;
+	const char* pEnd = sLine + iLength;
+	size_t iCount = 0;
+
+	// Spreadsheets like to start their CSV with a byte order mark.
+	if( iRows == 0 && iLength >= 3 && !memcmp( sLine, sUTF8_BOM, 3 ) )
+	    pCurr += 3;
+
+	while( pCurr < pEnd && is_Blank( *pCurr ) )
+	    ++pCurr;
+
+	if( pCurr == pEnd )
+	    continue;
+
+	for( ;; )
+	{
+	    double dValue = 0.0;
+	    NumberResult oNumber;
+
+	    while( pCurr < pEnd && is_Blank( *pCurr ) )
+		++pCurr;
+
+	    oNumber = parse_Double( pCurr, pEnd, dValue );
+
+	    if( oNumber.eError != NUMBER_OK )
+		return MATRIX_FILE_MALFORMED;
+
+	    vValues.push_back( dValue );
+	    ++iCount;
+
+	    for( pCurr = oNumber.pEnd; pCurr < pEnd && is_Blank( *pCurr ); ++pCurr )
+		;
+
+	    if( pCurr == pEnd )
+		break;
+
+	    if( *pCurr++ != ',' )
+		return MATRIX_FILE_MALFORMED;
+	}
+
+	if( iRows == 0 )
+	    iColumns = iCount;
+	else if( iCount != iColumns )
+	    return MATRIX_FILE_RAGGED;
+
+	++iRows;
+    }
+
+    if( oReader.failed( ) )
+	return MATRIX_FILE_UNREADABLE;
+
+    if( iRows == 0 )
+	return MATRIX_FILE_MALFORMED;
+
+    eStatus = oMatrix.resize( iRows, iColumns );
+
+    if( eStatus == MATRIX_OK )
+	memcpy( oMatrix.data( ), vValues.data( ), vValues.size( ) * sizeof( double ) );
+
+    return eStatus;
+}
+
+// Name: load_Matrix
+// Description: Reads a matrix from a CSV or binary file, whichever it is.
+// Return Value: MATRIX_OK, or why the file couldn't be read.  oMatrix is
+//               only changed on success.
+/////////////////////////////////////////////////////////////////////////////
+eMatrixStatus load_Matrix( const char* sPath, Matrix& oMatrix )
+{
+    FILE* pFile = fopen( sPath, "rb" );
+    char aMagic[ iMAGIC_SIZE ];
+    Matrix oLoaded;
+    eMatrixStatus eStatus = MATRIX_OK;
+
+    if( pFile == NULL )
+	return MATRIX_FILE_UNREADABLE;
+
+    if( fread( aMagic, 1, iMAGIC_SIZE, pFile ) == iMAGIC_SIZE && !memcmp( aMagic, MATRIX_FILE_MAGIC, iMAGIC_SIZE ) )
+	eStatus = load_Binary( pFile, oLoaded );
+    else if( fseek( pFile, 0, SEEK_SET ) != 0 )
+	eStatus = MATRIX_FILE_UNREADABLE;
+    else
+	eStatus = load_Csv( pFile, oLoaded );
+
+    fclose( pFile );
+
+    if( eStatus == MATRIX_OK )
+	std::swap( oMatrix, oLoaded );
+
+    return eStatus;
+}
+
+// Name: save_Matrix
+// Description: Writes a matrix as CSV if the path ends in
+//              MATRIX_FILE_CSV, and in the binary layout otherwise.
+// Return Value: MATRIX_OK, or MATRIX_FILE_UNWRITABLE if anything failed to
+//               reach the file.
+/////////////////////////////////////////////////////////////////////////////
+eMatrixStatus save_Matrix( const char* sPath, const Matrix& oMatrix )
+{
+    const size_t iPathLength = strlen( sPath );
+    const size_t iCsvLength = sizeof( MATRIX_FILE_CSV ) - 1;
+    FILE* pFile = fopen( sPath, "wb" );
+    bool bSuccess = true;
+
+    if( pFile == NULL )
+	return MATRIX_FILE_UNWRITABLE;
+
+    if( iPathLength >= iCsvLength && !strcmp( sPath + iPathLength - iCsvLength, MATRIX_FILE_CSV ) )
+    {
+	BufferedWriter oWriter( pFile );
+	std::string sRow;
+
+	for( size_t i = 0; i < oMatrix.get_Rows( ); ++i )
+	{
+	    sRow.clear( );
+	    oMatrix.append_Row( sRow, i );
+
+	    // append_Row separates values with spaces.
+	    for( size_t j = 0; j < sRow.size( ); ++j )
+	    {
+		if( sRow[ j ] == ' ' )
+		    sRow[ j ] = ',';
+	    }
+
+	    sRow += '\n';
+	    oWriter.write( sRow.data( ), sRow.size( ) );
+	}
+
+	oWriter.flush( );
+    }
+    else
+    {
+	unsigned char aHeader[ MATRIX_FILE_HEADER_SIZE ];
+
+	memcpy( aHeader, MATRIX_FILE_MAGIC, iMAGIC_SIZE );
+	write_Le32( aHeader + 4, MATRIX_FILE_VERSION );
+	write_Le64( aHeader + 8, oMatrix.get_Rows( ) );
+	write_Le64( aHeader + 16, oMatrix.get_Columns( ) );
+
+	bSuccess = fwrite( aHeader, 1, MATRIX_FILE_HEADER_SIZE, pFile ) == MATRIX_FILE_HEADER_SIZE &&
+		   fwrite( oMatrix.data( ), sizeof( double ), oMatrix.size( ), pFile ) == oMatrix.size( );
+    }
+
+    bSuccess = !ferror( pFile ) && bSuccess;
+    bSuccess = fclose( pFile ) == 0 && bSuccess;
+
+    return bSuccess ? MATRIX_OK : MATRIX_FILE_UNWRITABLE;
+}
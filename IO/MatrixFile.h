@@ -0,0 +1,40 @@
+// Name: MatrixFile.h
+// Description: Reads and writes matrices for the matrix mode, as CSV text
+//              or in a binary layout that loads without parsing.
+//
+//              CSV: one row per line, values separated by commas, with
+//              blanks allowed around them.  Blank lines are skipped and
+//              every row must have the same number of values.
+//
+//              Binary layout (little endian):
+//                  header:  char[4] magic "CMAT"
+//                           uint32  version (MATRIX_FILE_VERSION)
+//                           uint64  rows
+//                           uint64  columns
+//                  values:  rows * columns doubles (IEEE 754 binary64),
+//                           row-major
+//
+//              A file is read as binary if it starts with the magic and as
+//              CSV otherwise.  Values are copied in host order, which is
+//              little endian everywhere we build.
+// Written By: James Coté
+///////////////////////////////////////////////////////////////////////////
+
+// DEFINES
+#ifndef MATRIXFILE_H
+#define MATRIXFILE_H
+
+#define MATRIX_FILE_MAGIC       "CMAT"
+#define MATRIX_FILE_VERSION     1
+#define MATRIX_FILE_HEADER_SIZE 24
+#define MATRIX_FILE_CSV         ".csv"  // Extension save_Matrix writes as CSV
+
+// INCLUDES
+#include "../Calculator/Matrix.h"
+
+// FUNCTION DECLARATIONS:
+eMatrixStatus load_Matrix( const char* sPath, Matrix& oMatrix );
+eMatrixStatus save_Matrix( const char* sPath, const Matrix& oMatrix );
+
+// End of our define.
+#endif
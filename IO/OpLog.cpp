@@ -0,0 +1,333 @@
+// Name: OpLog.cpp
+// Description: Writer and memory-mapped reader for binary operation logs.
+// Written By: James Coté
+/////////////////////////////////////////////////////////////////////////////
+
+// INCLUDES
+#include "OpLog.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// CONSTANTS
+const size_t iMAGIC_SIZE = 4;
+
+// Name: write_Le32 / write_Le64
+// Description: Store integers little endian regardless of the host.
+/////////////////////////////////////////////////////////////////////////////
+static void write_Le32( unsigned char* pDest, unsigned long iValue )
+{
+    for( int i = 0; i < 4; ++i )
+	pDest[ i ] = (unsigned char)( iValue >> ( 8 * i ) );
+}
+
+static void write_Le64( unsigned char* pDest, unsigned long long iValue )
+{
+    for( int i = 0; i < 8; ++i )
+	pDest[ i ] = (unsigned char)( iValue >> ( 8 * i ) );
+}
+
+static unsigned long read_Le32( const unsigned char* pSource )
+{
+    unsigned long iValue = 0;
+
+    for( int i = 3; i >= 0; --i )
+	iValue = ( iValue << 8 ) | pSource[ i ];
+
+    return iValue;
+}
+
+static unsigned long long read_Le64( const unsigned char* pSource )
+{
+    unsigned long long iValue = 0;
+
+    for( int i = 7; i >= 0; --i )
+	iValue = ( iValue << 8 ) | pSource[ i ];
+
+    return iValue;
+}
+
+// Name: build_Header
+// Description: Fills in a log header for the given record count.
+/////////////////////////////////////////////////////////////////////////////
+static void build_Header( unsigned char* pHeader, unsigned long long iCount )
+{
+    memcpy( pHeader, OPLOG_MAGIC, iMAGIC_SIZE );
+    write_Le32( pHeader + 4, OPLOG_VERSION );
+    write_Le64( pHeader + 8, iCount );
+}
+
+/*************************************************************************\
+ *  OpLogWriter                                                          *
+\*************************************************************************/
+
+OpLogWriter::OpLogWriter( )
+{
+    m_pFile = NULL;
+    m_pWriter = NULL;
+    m_iCount = 0;
+}
+
+OpLogWriter::~OpLogWriter( )
+{
+    close( );
+}
+
+// Name: open
+// Description: Creates (or truncates) a log and writes a placeholder header.
+// Return Value: false if the file couldn't be created.
+/////////////////////////////////////////////////////////////////////////////
+bool OpLogWriter::open( const char* sPath )
+{
+    unsigned char aHeader[ OPLOG_HEADER_SIZE ];
+
+    close( );
+    m_pFile = fopen( sPath, "wb" );
+
+    if( m_pFile == NULL )
+	return false;
+
+    m_pWriter = new BufferedWriter( m_pFile );
+    m_iCount = 0;
+
+    build_Header( aHeader, 0 );
+    m_pWriter->write( (const char*) aHeader, OPLOG_HEADER_SIZE );
+
+    return true;
+}
+
+// Name: write
+// Description: Appends one record to the log.
+/////////////////////////////////////////////////////////////////////////////
+void OpLogWriter::write( const Operation& oOperation )
+{
+    unsigned char aRecord[ OPLOG_RECORD_SIZE ];
+    unsigned long long iBits = 0;
+
+    // Store the double's bits little endian like the header.
+    memcpy( &iBits, &oOperation.dValue, sizeof( double ) );
+    aRecord[ 0 ] = oOperation.cOpCode;
+    write_Le64( aRecord + 1, iBits );
+
+    m_pWriter->write( (const char*) aRecord, OPLOG_RECORD_SIZE );
+    ++m_iCount;
+}
+
+// Name: close
+// Description: Flushes the records and fills in the header's record count.
+// Return Value: false if anything failed to reach the file.
+/////////////////////////////////////////////////////////////////////////////
+bool OpLogWriter::close( )
+{
+    unsigned char aHeader[ OPLOG_HEADER_SIZE ];
+    bool bSuccess = true;
+
+    if( m_pFile == NULL )
+	return true;
+
+    delete m_pWriter;
+    m_pWriter = NULL;
+
+    build_Header( aHeader, m_iCount );
+    bSuccess = ( fseek( m_pFile, 0, SEEK_SET ) == 0 ) &&
+	       ( fwrite( aHeader, 1, OPLOG_HEADER_SIZE, m_pFile ) == OPLOG_HEADER_SIZE ) &&
+	       !ferror( m_pFile );
+    bSuccess &= ( fclose( m_pFile ) == 0 );
+    m_pFile = NULL;
+
+    return bSuccess;
+}
+
+// Returns the number of records written so far.
+unsigned long long OpLogWriter::get_Count( ) const
+{
+    return m_iCount;
+}
+
+/*************************************************************************\
+ *  OpLogReader                                                          *
+\*************************************************************************/
+
+OpLogReader::OpLogReader( )
+{
+    m_pMapping = NULL;
+    m_pRecords = NULL;
+    m_iMappedSize = 0;
+    m_iCount = 0;
+    m_sError = NULL;
+#ifdef _WIN32
+    m_hFile = INVALID_HANDLE_VALUE;
+    m_hMapping = NULL;
+#else
+    m_iFile = -1;
+#endif
+}
+
+OpLogReader::~OpLogReader( )
+{
+    close( );
+}
+
+// Records why open failed and releases anything it acquired.
+bool OpLogReader::fail( const char* sError )
+{
+    close( );
+    m_sError = sError;
+    return false;
+}
+
+// Name: open
+// Description: Maps a log into memory and validates its header.
+// Return Value: false if the log can't be used, see get_Error.
+/////////////////////////////////////////////////////////////////////////////
+bool OpLogReader::open( const char* sPath )
+{
+    unsigned long long iFileSize = 0;
+
+    close( );
+
+#ifdef _WIN32
+    LARGE_INTEGER oSize;
+
+    m_hFile = CreateFileA( sPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+			   FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+    if( m_hFile == INVALID_HANDLE_VALUE || !GetFileSizeEx( m_hFile, &oSize ) )
+	return fail( "unable to open the log" );
+
+    iFileSize = (unsigned long long) oSize.QuadPart;
+
+    if( iFileSize < OPLOG_HEADER_SIZE )
+	return fail( "log is too short for its header" );
+
+    m_hMapping = CreateFileMappingA( m_hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+
+    if( m_hMapping == NULL )
+	return fail( "unable to map the log" );
+
+    m_pMapping = (const unsigned char*) MapViewOfFile( m_hMapping, FILE_MAP_READ, 0, 0, 0 );
+
+    if( m_pMapping == NULL )
+	return fail( "unable to map the log" );
+#else
+    struct stat oStat;
+    void* pMapping = NULL;
+
+    m_iFile = ::open( sPath, O_RDONLY );
+
+    if( m_iFile < 0 || fstat( m_iFile, &oStat ) != 0 )
+	return fail( "unable to open the log" );
+
+    iFileSize = (unsigned long long) oStat.st_size;
+
+    if( iFileSize < OPLOG_HEADER_SIZE )
+	return fail( "log is too short for its header" );
+
+    pMapping = mmap( NULL, (size_t) iFileSize, PROT_READ, MAP_SHARED, m_iFile, 0 );
+
+    if( pMapping == MAP_FAILED )
+	return fail( "unable to map the log" );
+
+    m_pMapping = (const unsigned char*) pMapping;
+    madvise( pMapping, (size_t) iFileSize, MADV_SEQUENTIAL );
+#endif
+
+    m_iMappedSize = (size_t) iFileSize;
+
+    if( memcmp( m_pMapping, OPLOG_MAGIC, iMAGIC_SIZE ) != 0 )
+	return fail( "not an operation log" );
+
+    if( read_Le32( m_pMapping + 4 ) != OPLOG_VERSION )
+	return fail( "unsupported log version" );
+
+    m_iCount = read_Le64( m_pMapping + 8 );
+
+    // A log that wasn't closed has a short count; never read past the end.
+    if( m_iCount > ( iFileSize - OPLOG_HEADER_SIZE ) / OPLOG_RECORD_SIZE )
+	return fail( "log is shorter than its record count" );
+
+    m_pRecords = m_pMapping + OPLOG_HEADER_SIZE;
+    return true;
+}
+
+// Name: close
+// Description: Unmaps the log.
+/////////////////////////////////////////////////////////////////////////////
+void OpLogReader::close( )
+{
+#ifdef _WIN32
+    if( m_pMapping != NULL )
+	UnmapViewOfFile( m_pMapping );
+
+    if( m_hMapping != NULL )
+	CloseHandle( m_hMapping );
+
+    if( m_hFile != INVALID_HANDLE_VALUE )
+	CloseHandle( m_hFile );
+
+    m_hFile = INVALID_HANDLE_VALUE;
+    m_hMapping = NULL;
+#else
+    if( m_pMapping != NULL )
+	munmap( (void*) m_pMapping, m_iMappedSize );
+
+    if( m_iFile >= 0 )
+	::close( m_iFile );
+
+    m_iFile = -1;
+#endif
+
+    m_pMapping = NULL;
+    m_pRecords = NULL;
+    m_iMappedSize = 0;
+    m_iCount = 0;
+}
+
+// Returns why the last open failed.
+const char* OpLogReader::get_Error( ) const
+{
+    return m_sError;
+}
+
+// Returns the number of records in the log.
+unsigned long long OpLogReader::size( ) const
+{
+    return m_iCount;
+}
+
+// Name: replay
+// Description: Applies every record in the log to a calculator.
+/////////////////////////////////////////////////////////////////////////////
+void OpLogReader::replay( Calculator* const m_Calculator ) const
+{
+    Operation oOperation;
+
+    for( unsigned long long i = 0; i < m_iCount; ++i )
+    {
+	get( i, oOperation );
+	m_Calculator->apply_Operation( oOperation );
+    }
+}
+
+// Name: replay
+// Description: Applies every record in the log to a calculator, recording
+//              the working value after each one.
+// Parameters: pValues - receives size( ) working values.
+/////////////////////////////////////////////////////////////////////////////
+void OpLogReader::replay( Calculator* const m_Calculator, double* pValues ) const
+{
+    Operation oOperation;
+
+    for( unsigned long long i = 0; i < m_iCount; ++i )
+    {
+	get( i, oOperation );
+	m_Calculator->apply_Operation( oOperation );
+	pValues[ i ] = m_Calculator->read_Value( );
+    }
+}
@@ -0,0 +1,102 @@
+// Name: OpLog.h
+// Description: Compact binary log of calculator operations.
+//
+//              Layout (little endian):
+//                  header:  char[4] magic "COPL"
+//                           uint32  version (OPLOG_VERSION)
+//                           uint64  record count
+//                  records: uint8   op code (Operation::cOpCode)
+//                           double  operand (IEEE 754 binary64)
+//
+//              Records are packed, 9 bytes each, with no padding.  The
+//              reader maps the file into memory and decodes records in
+//              place, so replaying a log never copies or parses it.  The
+//              in-place decode assumes a little endian host, which every
+//              platform we build for is.
+// Written By: James Coté
+///////////////////////////////////////////////////////////////////////////
+
+// DEFINES
+#ifndef OPLOG_H
+#define OPLOG_H
+
+#define OPLOG_MAGIC         "COPL"
+#define OPLOG_VERSION       1
+#define OPLOG_HEADER_SIZE   16
+#define OPLOG_RECORD_SIZE   9
+
+// INCLUDES
+#include <cstddef>
+#include <cstring>
+#include "BufferedIO.h"
+#include "../Calculator/Calculator.h"
+
+// CLASS DECLARATIONS:
+
+// Appends operations to a new log file.  The record count in the header is
+// filled in when the log is closed.
+class OpLogWriter
+{
+public:
+    OpLogWriter( );
+    ~OpLogWriter( );
+
+    bool open( const char* sPath );
+    void write( const Operation& oOperation );
+    bool close( );
+    unsigned long long get_Count( ) const;
+
+private:
+    OpLogWriter( const OpLogWriter& );
+    OpLogWriter& operator=( const OpLogWriter& );
+
+    FILE* m_pFile;
+    BufferedWriter* m_pWriter;
+    unsigned long long m_iCount;
+};
+
+// Maps an existing log into memory for reading.
+class OpLogReader
+{
+public:
+    OpLogReader( );
+    ~OpLogReader( );
+
+    bool open( const char* sPath );
+    void close( );
+    const char* get_Error( ) const;
+
+    unsigned long long size( ) const;
+    void replay( Calculator* const m_Calculator ) const;
+    void replay( Calculator* const m_Calculator, double* pValues ) const;
+
+    // Decodes record i straight from the mapping.
+    inline void get( unsigned long long i, Operation& oOperation ) const
+    {
+        const unsigned char* pRecord = m_pRecords + i * OPLOG_RECORD_SIZE;
+
+        oOperation.cOpCode = pRecord[ 0 ];
+        memcpy( &oOperation.dValue, pRecord + 1, sizeof( double ) );
+    }
+
+private:
+    OpLogReader( const OpLogReader& );
+    OpLogReader& operator=( const OpLogReader& );
+
+    bool fail( const char* sError );
+
+    const unsigned char* m_pMapping;
+    const unsigned char* m_pRecords;
+    size_t m_iMappedSize;
+    unsigned long long m_iCount;
+    const char* m_sError;
+#ifdef _WIN32
+    void* m_hFile;
+    void* m_hMapping;
+#else
+    int m_iFile;
+#endif
+};
+
+// End of our define.
+#endif
@@ -8,8 +8,11 @@
 #include <iostream>
 #include <stdlib.h>
 #include <climits>
+#include <cstring>
 #include <vector>
 #include "ioutil.h"
+#include "../Parser/NumberParser.h"
+#include "../Metrics/Metrics.h"
 
 // NAMESPACES
 using namespace std;
@@ -56,39 +59,53 @@ void clearString( char str[], int maxlen )
 
 // Description: reads in a long integer as required by our readInt function
 // Method: Get a line from the user, determine if we triggered an end of file,
-//         convert to a long int via strtol and finally set a boolean to see
-//         if the long integer can be properly converted to a regular integer.
+//         convert to a long long via parse_Integer and finally set a boolean
+//         to see if the value can be properly converted to a regular integer.
 // Parameters: cInput - reference to the input array that is used to read in
 //                      an integer.
 //             bEOF - end of file flag, set if we get and eof.
 //             bWrongInput - boolean to determine whether the integer entered
 //                           was wrong or not.  Passed as reference to use
 //                           for loop conditional.
+//             iErrorColumn - set to the column the input went wrong at.
+//             sError - set to why the input was wrong.
 // Return Value: returns the integer read in.  Return value will be different
 //               if the user enters an integer outside the bounds of an int,
 //               however, in that case, we ask them for a new input.
 /////////////////////////////////////////////////////////////////////////////
-int Get_int( char cInput[], bool &bWrongInput, bool &bEOF )
+int Get_int( char cInput[], bool &bWrongInput, bool &bEOF,
+	     size_t &iErrorColumn, const char* &sError )
 {
     // Local Variables
-    long int liVar = 0;
-    char *cpEndPtr = NULL;
+    long long liVar = 0;
+    const char* cpEnd = NULL;
+    NumberResult oResult;
 
     // Get a line of input from user to parse
     cin.getline( cInput, CHAR_MAX, cNEWLINE );
     bEOF = cin.eof(); 
+    cpEnd = cInput + strlen( cInput );
 
-    // Attempt to convert the input to a long int
-    liVar = strtol( cInput, &cpEndPtr, 0 );
+    // Attempt to convert the input, base taken from the prefix like strtol
+    oResult = parse_Integer( cInput, cpEnd, liVar, 0 );
+    sError = get_Number_Error( oResult.eError );
+
+    if( oResult.eError == NUMBER_OK && oResult.pEnd != cpEnd )
+	sError = "unexpected character";
+    else if( oResult.eError == NUMBER_OK && ( liVar > INT_MAX || liVar < INT_MIN ) )
+    {
+	oResult.eError = NUMBER_OUT_OF_RANGE;
+	oResult.pEnd = cInput;
+	sError = get_Number_Error( oResult.eError );
+    }
+
+    iErrorColumn = (size_t)( oResult.pEnd - cInput ) + 1;
 
     // Set our wrong input flag to determine if the integer read in is correct.
-    bWrongInput = ( ( cin.fail() || 
-		      ( (*cpEndPtr) != '\0' ) || 
-		      ( ( cInput[ 0 ] == cWHITESPACE ) ||
-			( cInput[ 0 ] == (*cpEndPtr) ) ) || 
-		      ( ( ( liVar > INT_MAX ) ||
-			  ( liVar < INT_MIN ) ) ) ) && 
-		    !bEOF );
+    bWrongInput = ( cin.fail() || 
+		    ( oResult.eError != NUMBER_OK ) ||
+		    ( oResult.pEnd != cpEnd ) ) && 
+		  !bEOF;
 
     // return our int value
     return (int)liVar;
@@ -112,20 +129,26 @@ int readInt( const char prompt[], bool &eof )
     char cInputString[ CHAR_MAX ] = {};
     bool bWrongInput = true;
     int iReturnValue;
+    size_t iErrorColumn = 0;
+    const char* sError = NULL;
+    METRIC_TIME_SCOPE( METRIC_TIMER_READ );
 
     // Output our prompt message to prompt the user to enter an integer.
     cout << prompt << endl;
 
     // read in the next int value
-    iReturnValue = Get_int( cInputString, bWrongInput, eof );
+    iReturnValue = Get_int( cInputString, bWrongInput, eof, iErrorColumn, sError );
     
     // While we don't have the input we want, re-prompt the user.
     while( bWrongInput )
     {
+	METRIC_COUNT_FAILURE( METRIC_SOURCE_INPUT, sError );
+
 	// Output an error message:
 	cout << "I'm sorry, '" << cInputString;
 	cout << ( cin.fail() ? "..." : "" ) << "' isn't what I'm ";
-	cout << "looking for.  Please try again.  " << endl << endl;
+	cout << "looking for (" << sError << " at column " << iErrorColumn << ").";
+	cout << "  Please try again.  " << endl << endl;
 	cout << prompt << endl;
 
 	// If we're in the fail state, clear it
@@ -139,7 +162,7 @@ int readInt( const char prompt[], bool &eof )
 	}
 	
 	// read in another int value.
-	iReturnValue = Get_int( cInputString, bWrongInput, eof );
+	iReturnValue = Get_int( cInputString, bWrongInput, eof, iErrorColumn, sError );
     }
     
     // If we're leaving because of end of file, clear fail flags.
@@ -171,7 +194,7 @@ int readInt( const char prompt[], bool &eof )
 bool readBool( const char prompt[], bool &eof )
 {
     // Create variables
-    bool bReturn;
+    bool bReturn = false;
     char cInput = '\0';
 
     // grab a character from the user, ensure it's a y or an n
@@ -189,12 +212,15 @@ bool readBool( const char prompt[], bool &eof )
 	    bReturn = true;  
 	    break;
 	default:      
+	    METRIC_COUNT_FAILURE( METRIC_SOURCE_INPUT, "expected y or n" );
+
 	    // Prompt error message and request new input.
 	    cerr << "I'm sorry, '" << cInput;
 	    cerr << "' was not the answer we were looking for.";
 	    cerr << "  Please try again." << endl << endl;
 	    cerr << prompt << endl;
 	    cInput = readChar( prompt, eof, 2, 'y', 'n' );
+	    bReturn = ( !eof && cInput == 'y' );
 	    break;
 	}
     }
@@ -226,6 +252,7 @@ char readChar( const char prompt[], bool &eof, int iVarArgCount, ... )
     char cInput[ iCHAR_MAX_LENGTH ] = { };
     vector< char > cCompareList;
     bool bSuccess = false;
+    METRIC_TIME_SCOPE( METRIC_TIMER_READ );
 
     // if there's variable arguments, store them in a character array
     if( iVarArgCount > 0 )
@@ -254,6 +281,8 @@ char readChar( const char prompt[], bool &eof, int iVarArgCount, ... )
     {
 		if( cInput[ iCHAR_MAX_LENGTH - 1 ] != cNULL_CHAR )
 		{
+			METRIC_COUNT_FAILURE( METRIC_SOURCE_INPUT, "expected one character" );
+
 			// Error, output a message and re-prompt
 			cerr << "I'm sorry, the format needs to contain a character ";
 			cerr << "followed by a newline.  Please try again." << endl;
@@ -277,6 +306,8 @@ char readChar( const char prompt[], bool &eof, int iVarArgCount, ... )
 			// If not successful, let the user know.
 			if( !bSuccess )
 			{
+				METRIC_COUNT_FAILURE( METRIC_SOURCE_INPUT, "unexpected character" );
+
 				cerr << "I'm sorry, I'm looking for one of the following";
 				cerr << " characters: ";
 		
@@ -349,6 +380,7 @@ void readString( const char prompt[], char str[], int maxlen, int minlen, bool &
 {
     // Initialize our success flag
     bool bSuccess = false;
+    METRIC_TIME_SCOPE( METRIC_TIMER_READ );
 
     // Ensure our str c-string is nullified.  Don't assume it is.
     clearString( str, maxlen );
@@ -369,6 +401,8 @@ void readString( const char prompt[], char str[], int maxlen, int minlen, bool &
 	// at least the minimum length.
 	if( ( minlen != 0 ) && ( str[ minlen - 1 ] == '\0' ) )
 	{
+	    METRIC_COUNT_FAILURE( METRIC_SOURCE_INPUT, "string too short" );
+
 	    // Output an error message to let the user know that what they
 	    // entered was too short of a string.
 	    cerr << "I'm sorry, the minimum length of the string must be ";
@@ -378,6 +412,8 @@ void readString( const char prompt[], char str[], int maxlen, int minlen, bool &
 	}
 	else if( cin.fail() )  // Entered fail state (input > maxlength)
 	{
+	    METRIC_COUNT_FAILURE( METRIC_SOURCE_INPUT, "string too long" );
+
 	    cerr << "I'm sorry, but the string you entered was too long.";
 	    cerr << "  Please keep it at a maximum length of " << maxlen;
 	    cerr << ".  Thank you." << endl << endl << prompt << endl;
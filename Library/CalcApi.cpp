@@ -0,0 +1,329 @@
+// Name: CalcApi.cpp
+// Description: The C interface of the calculator library, see CalcApi.h.
+//				Every call is a thin wrapper around a Calculator; no C++
+//				exception ever crosses the interface.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "CalcApi.h"
+#include "../Calculator/Calculator.h"
+#include "../Parser/ExprCache.h"
+#include "../Parser/LineParser.h"
+#include <cmath>
+#include <new>
+
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define CALC_SESSION_CACHE_BUDGET ( 256 << 10 )	// Compiled lines kept per session
+
+// The op codes are the calculator's own, so operations pass straight
+// through.
+static_assert( is_Operator( CALC_OP_ADD ) && is_Operator( CALC_OP_SUBTRACT ) &&
+			   is_Operator( CALC_OP_MULTIPLY ) && is_Operator( CALC_OP_DIVIDE ) &&
+			   CALC_OP_SET == OP_CODE_SET && CALC_OP_STORE == OP_CODE_STORE &&
+			   CALC_OP_RESET == OP_CODE_RESET && CALC_OP_MEM == OP_CODE_MEM_FLAG,
+			   "CalcApi.h op codes must match Operation.h" );
+static_assert( sizeof( CalcOp ) == 16, "CalcOp is part of the ABI" );
+
+// A session: a calculator and the lines it has compiled.
+struct CalcSession
+{
+	Calculator oCalculator;
+	ExprCache oCache;
+
+	CalcSession( ) : oCache( CALC_SESSION_CACHE_BUDGET ) {}
+};
+
+// Returns true if an op code is one of those in CalcApi.h, or an operator
+// the calculator has gained since.  Variable operations exist only within
+// the calculator, so they don't pass.
+static inline bool is_Valid_Op_Code( unsigned char cOpCode )
+{
+	if( is_Operator( (char)( cOpCode & ~CALC_OP_MEM ) ) )
+		return true;
+
+	switch( cOpCode )
+	{
+	case CALC_OP_SET:
+	case CALC_OP_STORE:
+	case CALC_OP_RESET:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*********************************************************************\
+ *	Library															 *
+\*********************************************************************/
+
+// Returns the CALC_API_VERSION the library was built with.
+unsigned int calc_Get_Version( void )
+{
+	return CALC_API_VERSION;
+}
+
+// Returns a description of a status, for error messages.
+const char* calc_Get_Status_Message( eCalcStatus eStatus )
+{
+	switch( eStatus )
+	{
+	case CALC_OK:				return "no error";
+	case CALC_ERROR_ARGUMENT:	return "invalid argument";
+	case CALC_ERROR_OP_CODE:	return "unknown op code";
+	case CALC_ERROR_LINE:		return "invalid line";
+	case CALC_ERROR_MEMORY:		return "out of memory";
+	default:					return "unknown status";
+	}
+}
+
+/*********************************************************************\
+ *	Sessions														 *
+\*********************************************************************/
+
+// Creates a session, starting at 0 with nothing in memory.
+//	Returns:
+//		The session, or NULL if out of memory.
+//////////////////////////////////////////////////////////////////////
+CalcSession* calc_Create_Session( void )
+{
+	return new( nothrow ) CalcSession;
+}
+
+// Destroys a session.  NULL is ignored.
+void calc_Destroy_Session( CalcSession* pSession )
+{
+	delete pSession;
+}
+
+/*********************************************************************\
+ *	Calculations													 *
+\*********************************************************************/
+
+// Applies one operation to the session.
+//	Parameters:
+//		cOpCode : unsigned char - One of the CALC_OP_* op codes.
+//		dValue : double - Its operand, if it takes one.
+//	Returns:
+//		CALC_OK, or CALC_ERROR_OP_CODE and nothing is applied.
+//////////////////////////////////////////////////////////////////////
+eCalcStatus calc_Apply( CalcSession* pSession, unsigned char cOpCode, double dValue )
+{
+	Operation oOperation;
+
+	if( pSession == NULL )
+		return CALC_ERROR_ARGUMENT;
+
+	if( !is_Valid_Op_Code( cOpCode ) )
+		return CALC_ERROR_OP_CODE;
+
+	oOperation.cOpCode = cOpCode;
+	oOperation.iSlot = 0;
+	oOperation.dValue = dValue;
+	pSession->oCalculator.apply_Operation( oOperation );
+	return CALC_OK;
+}
+
+// Applies an array of operations in order, stopping at the first one
+// with an unknown op code.
+//	Parameters:
+//		pOps : CalcOp* - The operations, may be NULL if iCount is 0.
+//		iCount : size_t - Number of operations.
+//		pApplied : size_t* - Receives how many were applied, unless NULL.
+//	Returns:
+//		CALC_OK if all of them were applied, otherwise why not.
+//////////////////////////////////////////////////////////////////////
+eCalcStatus calc_Apply_Ops( CalcSession* pSession, const CalcOp* pOps, size_t iCount,
+							size_t* pApplied )
+{
+	eCalcStatus eStatus = CALC_OK;
+	Operation oOperation;
+	size_t i = 0;
+
+	if( pSession == NULL || ( pOps == NULL && iCount > 0 ) )
+		eStatus = CALC_ERROR_ARGUMENT;
+	else
+	{
+		oOperation.iSlot = 0;
+
+		for( ; i < iCount; ++i )
+		{
+			if( !is_Valid_Op_Code( pOps[ i ].cOpCode ) )
+			{
+				eStatus = CALC_ERROR_OP_CODE;
+				break;
+			}
+
+			oOperation.cOpCode = pOps[ i ].cOpCode;
+			oOperation.dValue = pOps[ i ].dValue;
+			pSession->oCalculator.apply_Operation( oOperation );
+		}
+	}
+
+	if( pApplied != NULL )
+		*pApplied = i;
+
+	return eStatus;
+}
+
+// Applies a line in the script syntax, including expressions and
+// variables.  Blank lines, comments and "q" do nothing.
+//	Parameters:
+//		sLine, iLength : const char* - The line, not null terminated.
+//		pError : CalcLineError* - Receives why the line was rejected, unless
+//								  NULL.
+//	Returns:
+//		CALC_OK, or CALC_ERROR_LINE and nothing is applied.
+//////////////////////////////////////////////////////////////////////
+eCalcStatus calc_Apply_Line( CalcSession* pSession, const char* sLine, size_t iLength,
+							 CalcLineError* pError )
+{
+	Operation oOperation;
+	CompileError oError;
+	const Program* pProgram = NULL;
+
+	if( pSession == NULL || ( sLine == NULL && iLength > 0 ) )
+		return CALC_ERROR_ARGUMENT;
+
+	try
+	{
+		switch( parse_Line( sLine, iLength, &pSession->oCalculator, oOperation ) )
+		{
+		case LINE_OPERATION:
+			pSession->oCalculator.apply_Operation( oOperation );
+			return CALC_OK;
+		case LINE_INVALID:
+			break;
+		default:
+			return CALC_OK;
+		}
+
+		if( ( pProgram = pSession->oCache.compile( sLine, iLength, &pSession->oCalculator, oError ) ) == NULL )
+		{
+			if( pError != NULL )
+			{
+				pError->iColumn = oError.iPosition + 1;
+				pError->sMessage = oError.sMessage;
+			}
+
+			return CALC_ERROR_LINE;
+		}
+
+		pSession->oCalculator.execute_Program( *pProgram );
+	}
+	catch( const bad_alloc& )
+	{
+		return CALC_ERROR_MEMORY;
+	}
+
+	return CALC_OK;
+}
+
+/*********************************************************************\
+ *	Getters and Setters  											 *
+\*********************************************************************/
+
+// Returns the session's working value, NaN for a NULL session.
+double calc_Read_Value( const CalcSession* pSession )
+{
+	return pSession != NULL ? pSession->oCalculator.read_Value( ) : NAN;
+}
+
+// Sets the session's working value.
+void calc_Set_Value( CalcSession* pSession, double dValue )
+{
+	if( pSession != NULL )
+		pSession->oCalculator.set_Value( dValue );
+}
+
+// Resets the session's working value to 0.
+void calc_Clear_Value( CalcSession* pSession )
+{
+	if( pSession != NULL )
+		pSession->oCalculator.clear_Value( );
+}
+
+// Returns the value in the session's memory, NaN for a NULL session.
+double calc_Pull_Mem( const CalcSession* pSession )
+{
+	return pSession != NULL ? pSession->oCalculator.pull_Mem( ) : NAN;
+}
+
+// Sets the session's memory directly.
+void calc_Set_Mem( CalcSession* pSession, double dMemory )
+{
+	if( pSession != NULL )
+		pSession->oCalculator.set_Mem( dMemory );
+}
+
+// Stores the session's working value into its memory.
+void calc_Store_Mem( CalcSession* pSession )
+{
+	if( pSession != NULL )
+		pSession->oCalculator.store_Mem( );
+}
+
+/*********************************************************************\
+ *	Operand Statistics												 *
+\*********************************************************************/
+
+// Starts keeping statistics over the operands the session applies from
+// here on.  Calling it again keeps the statistics already gathered.
+//	Returns:
+//		CALC_OK, or CALC_ERROR_MEMORY.
+//////////////////////////////////////////////////////////////////////
+eCalcStatus calc_Enable_Stats( CalcSession* pSession )
+{
+	if( pSession == NULL )
+		return CALC_ERROR_ARGUMENT;
+
+	try
+	{
+		pSession->oCalculator.enable_Stats( );
+	}
+	catch( const bad_alloc& )
+	{
+		return CALC_ERROR_MEMORY;
+	}
+
+	return CALC_OK;
+}
+
+// Reads the operand statistics.
+//	Parameters:
+//		pStats : CalcStats* - Receives the statistics.
+//	Returns:
+//		CALC_OK, or CALC_ERROR_ARGUMENT if either pointer is NULL or the
+//		session doesn't keep statistics.
+//////////////////////////////////////////////////////////////////////
+eCalcStatus calc_Read_Stats( const CalcSession* pSession, CalcStats* pStats )
+{
+	const OperandStats* pOperandStats = pSession != NULL ? pSession->oCalculator.get_Stats( ) : NULL;
+
+	if( pOperandStats == NULL || pStats == NULL )
+		return CALC_ERROR_ARGUMENT;
+
+	pStats->iCount = pOperandStats->get_Count( );
+	pStats->dSum = pOperandStats->get_Sum( );
+	pStats->dMean = pOperandStats->get_Mean( );
+	pStats->dVariance = pOperandStats->get_Variance( );
+	pStats->dMin = pOperandStats->get_Min( );
+	pStats->dMax = pOperandStats->get_Max( );
+	return CALC_OK;
+}
+
+// Returns an operand quantile, dFraction from 0 to 1, within 1/256 of
+// the exact one.  NaN if the session doesn't keep statistics, has no
+// operands yet or dFraction is out of range.
+double calc_Read_Quantile( const CalcSession* pSession, double dFraction )
+{
+	const OperandStats* pOperandStats = pSession != NULL ? pSession->oCalculator.get_Stats( ) : NULL;
+
+	return pOperandStats != NULL ? pOperandStats->get_Quantile( dFraction ) : NAN;
+}
@@ -0,0 +1,146 @@
+#ifndef _CALCAPI_H
+#define _CALCAPI_H
+
+// Name: CalcApi.h
+// Description: C interface to the calculator, for programs that link it
+//				in as a library instead of running the executable.  A
+//				session is one Calculator: a working value and a memory
+//				register.  Operations are applied one at a time or as an
+//				array in one call, and lines in the script syntax can be
+//				applied as well.
+//
+//				The interface is plain C and stable: sessions are opaque,
+//				the structures below only ever grow at the end, and op
+//				codes keep their values.  Applying operations and reading
+//				or setting the value and memory never allocate; only
+//				creating a session and compiling a new expression line do.
+//				A session may be used from one thread at a time; separate
+//				sessions are independent.
+//
+//				A session can also keep statistics over the operands it
+//				applies (see OperandStats.h).  With them on, an operand of
+//				a magnitude not seen before allocates 1 KB for its quantile
+//				counts.
+//
+//				Lines applied often are compiled to native code.  On hosts
+//				that forbid executable memory, set CALC_NO_JIT in the
+//				environment to keep them interpreted.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <stddef.h>
+
+/////////////
+// Defines //
+/////////////
+#define CALC_API_VERSION	2		// 2 added the operand statistics
+
+// Builds of the library export its functions; a program using the
+// Windows DLL defines CALC_SHARED to import them.
+#if defined( _WIN32 )
+#if defined( CALC_BUILDING )
+#define CALC_API __declspec( dllexport )
+#elif defined( CALC_SHARED )
+#define CALC_API __declspec( dllimport )
+#else
+#define CALC_API
+#endif
+#elif defined( __GNUC__ )
+#define CALC_API __attribute__(( visibility( "default" ) ))
+#else
+#define CALC_API
+#endif
+
+// Op codes, the same as the calculator's operation logs.  An operator may
+// be or'd with CALC_OP_MEM to use the value in memory as its operand.
+#define CALC_OP_ADD			'+'
+#define CALC_OP_SUBTRACT	'-'
+#define CALC_OP_MULTIPLY	'*'
+#define CALC_OP_DIVIDE		'/'
+#define CALC_OP_SET			'='		// Set the working value to the operand
+#define CALC_OP_STORE		's'		// Store the working value into memory
+#define CALC_OP_RESET		'r'		// Reset the working value to 0
+#define CALC_OP_MEM			0x80	// Operand is the value held in memory
+
+// Results of the calls that can fail.
+typedef enum eCalcStatus
+{
+	CALC_OK = 0,
+	CALC_ERROR_ARGUMENT,		// A NULL session or array
+	CALC_ERROR_OP_CODE,			// Not one of the op codes above
+	CALC_ERROR_LINE,			// A line that could not be parsed
+	CALC_ERROR_MEMORY			// Out of memory
+} eCalcStatus;
+
+// An operation: an op code and its operand, 16 bytes.  dValue is ignored
+// by the op codes that take none.
+typedef struct CalcOp
+{
+	unsigned char cOpCode;
+	unsigned char aReserved[ 7 ];	// Set to 0
+	double dValue;
+} CalcOp;
+
+// Where and why a line was rejected.  sMessage is a static string.
+typedef struct CalcLineError
+{
+	size_t iColumn;					// From 1
+	const char* sMessage;
+} CalcLineError;
+
+// Statistics over the operands a session has applied, from
+// calc_Read_Stats.  Statistics that don't exist yet are NaN.
+typedef struct CalcStats
+{
+	unsigned long long iCount;		// Operands of operators and sets, NaNs included
+	double dSum;					// Correctly rounded
+	double dMean;
+	double dVariance;				// Sample variance, over n - 1
+	double dMin;
+	double dMax;
+} CalcStats;
+
+typedef struct CalcSession CalcSession;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+CALC_API unsigned int calc_Get_Version( void );
+CALC_API const char* calc_Get_Status_Message( eCalcStatus eStatus );
+
+// Sessions
+CALC_API CalcSession* calc_Create_Session( void );
+CALC_API void calc_Destroy_Session( CalcSession* pSession );
+
+// Calculations
+CALC_API eCalcStatus calc_Apply( CalcSession* pSession, unsigned char cOpCode, double dValue );
+CALC_API eCalcStatus calc_Apply_Ops( CalcSession* pSession, const CalcOp* pOps, size_t iCount,
+									 size_t* pApplied );
+CALC_API eCalcStatus calc_Apply_Line( CalcSession* pSession, const char* sLine, size_t iLength,
+									  CalcLineError* pError );
+
+// Getters and setters
+CALC_API double calc_Read_Value( const CalcSession* pSession );
+CALC_API void calc_Set_Value( CalcSession* pSession, double dValue );
+CALC_API void calc_Clear_Value( CalcSession* pSession );
+CALC_API double calc_Pull_Mem( const CalcSession* pSession );
+CALC_API void calc_Set_Mem( CalcSession* pSession, double dMemory );
+CALC_API void calc_Store_Mem( CalcSession* pSession );
+
+// Operand statistics, since version 2
+CALC_API eCalcStatus calc_Enable_Stats( CalcSession* pSession );
+CALC_API eCalcStatus calc_Read_Stats( const CalcSession* pSession, CalcStats* pStats );
+CALC_API double calc_Read_Quantile( const CalcSession* pSession, double dFraction );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
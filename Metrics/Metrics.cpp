@@ -0,0 +1,440 @@
+// Name: Metrics.cpp
+// Description: Thread registry, histogram buckets and the text dump for
+//				the hot path instrumentation.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <csignal>
+#include <pthread.h>
+#endif
+
+using namespace std;
+
+// Names used in the dump, indexed by the enums in Metrics.h.
+static const char* sOPERATOR_NAMES[ METRIC_OP_COUNT ] =
+{
+	"+", "-", "*", "/", "=", "store", "reset", "other"
+};
+
+static const char* sSOURCE_NAMES[ METRIC_SOURCE_COUNT ] =
+{
+	"interactive", "input", "script", "server"
+};
+
+static const char* sTIMER_NAMES[ METRIC_TIMER_COUNT ] =
+{
+	"calculation", "parse", "read"
+};
+
+static const char* sQUANTILES[] = { "0.5", "0.9", "0.99", "0.999" };
+static const double dQUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+#if CALC_METRICS
+
+/*********************************************************************\
+ *	Thread Registry													 *
+\*********************************************************************/
+
+thread_local ThreadMetrics* t_pMetrics = NULL;
+
+// Every live thread's block, plus the totals of threads that have exited.
+struct MetricsRegistry
+{
+	mutex oLock;
+	ThreadMetrics* pThreads;
+	ThreadMetrics* pRetired;
+};
+
+static MetricsRegistry& get_Registry( )
+{
+	static MetricsRegistry oRegistry = { { }, NULL, NULL };
+
+	return oRegistry;
+}
+
+// Adds to a failure's count.  Failures are rare, so a linear search is
+// fine; once every slot is taken, new reasons share the last one.
+static void add_Failure( ThreadMetrics* pMetrics, unsigned int iSource, const char* sReason,
+						 unsigned long long iCount )
+{
+	MetricFailure* pSlot = &pMetrics->aFailures[ METRICS_MAX_FAILURES - 1 ];
+
+	for( size_t i = 0; i < METRICS_MAX_FAILURES; ++i )
+	{
+		MetricFailure& oFailure = pMetrics->aFailures[ i ];
+		const char* sSeen = oFailure.sReason.load( memory_order_relaxed );
+
+		if( sSeen == NULL )
+		{
+			// Publish the source before the reason that makes the slot visible.
+			oFailure.iSource = iSource;
+			oFailure.sReason.store( i + 1 < METRICS_MAX_FAILURES ? sReason : "other", memory_order_release );
+			pSlot = &oFailure;
+			break;
+		}
+
+		if( sSeen == sReason && oFailure.iSource == iSource )
+		{
+			pSlot = &oFailure;
+			break;
+		}
+	}
+
+	bump( pSlot->iCount, iCount );
+}
+
+// Adds a block's counts into another.  Only called under the registry lock.
+static void merge_Metrics( ThreadMetrics& oInto, const ThreadMetrics& oFrom )
+{
+	for( size_t i = 0; i < METRIC_OP_COUNT; ++i )
+		bump( oInto.aOperations[ i ], oFrom.aOperations[ i ].load( memory_order_relaxed ) );
+
+	bump( oInto.iMemHits, oFrom.iMemHits.load( memory_order_relaxed ) );
+
+	for( size_t t = 0; t < METRIC_TIMER_COUNT; ++t )
+		for( size_t b = 0; b < METRICS_BUCKET_COUNT; ++b )
+			bump( oInto.aHistograms[ t ][ b ], oFrom.aHistograms[ t ][ b ].load( memory_order_relaxed ) );
+
+	for( size_t f = 0; f < METRICS_MAX_FAILURES; ++f )
+	{
+		const char* sReason = oFrom.aFailures[ f ].sReason.load( memory_order_acquire );
+
+		if( sReason != NULL )
+			add_Failure( &oInto, oFrom.aFailures[ f ].iSource, sReason,
+						 oFrom.aFailures[ f ].iCount.load( memory_order_relaxed ) );
+	}
+}
+
+// Folds a thread's block into the retired totals when the thread exits.
+struct ThreadMetricsOwner
+{
+	~ThreadMetricsOwner( )
+	{
+		MetricsRegistry& oRegistry = get_Registry( );
+		ThreadMetrics* pMetrics = t_pMetrics;
+
+		if( pMetrics == NULL )
+			return;
+
+		lock_guard< mutex > oLock( oRegistry.oLock );
+
+		for( ThreadMetrics** ppLink = &oRegistry.pThreads; *ppLink != NULL; ppLink = &( *ppLink )->pNext )
+			if( *ppLink == pMetrics )
+			{
+				*ppLink = pMetrics->pNext;
+				break;
+			}
+
+		if( oRegistry.pRetired == NULL )
+			oRegistry.pRetired = new ThreadMetrics( );
+
+		merge_Metrics( *oRegistry.pRetired, *pMetrics );
+		t_pMetrics = NULL;
+		delete pMetrics;
+	}
+};
+
+static thread_local ThreadMetricsOwner t_oOwner;
+
+// Creates the calling thread's block the first time it counts anything.
+ThreadMetrics* register_Metrics_Thread( )
+{
+	MetricsRegistry& oRegistry = get_Registry( );
+	ThreadMetrics* pMetrics = new ThreadMetrics( );
+
+	// Touching the owner makes sure its destructor runs at thread exit.
+	(void) &t_oOwner;
+
+	{
+		lock_guard< mutex > oLock( oRegistry.oLock );
+
+		pMetrics->pNext = oRegistry.pThreads;
+		oRegistry.pThreads = pMetrics;
+	}
+
+	t_pMetrics = pMetrics;
+	return pMetrics;
+}
+
+// Counts a parse failure.
+void record_Failure( ThreadMetrics* pMetrics, MetricSource eSource, const char* sReason )
+{
+	add_Failure( pMetrics, (unsigned int) eSource, sReason, 1 );
+}
+
+/*********************************************************************\
+ *	Histograms														 *
+\*********************************************************************/
+
+// Returns floor(log2(iValue)) for a non-zero value.
+static inline unsigned int get_Exponent( unsigned long long iValue )
+{
+	unsigned int iExponent = 0;
+
+	while( iValue >>= 1 )
+		++iExponent;
+
+	return iExponent;
+}
+
+// Maps a latency to its bucket: exact below 2^5ns, then 32 buckets per
+// power of two, so every bucket is within about 3% of its values.
+size_t get_Metrics_Bucket( unsigned long long iNanoseconds )
+{
+	unsigned int iExponent = 0;
+
+	if( iNanoseconds < ( 1ULL << METRICS_SUB_BUCKET_BITS ) )
+		return (size_t) iNanoseconds;
+
+	iExponent = get_Exponent( iNanoseconds );
+
+	if( iExponent > METRICS_MAX_EXPONENT )
+		return METRICS_BUCKET_COUNT - 1;
+
+	return ( (size_t)( iExponent - METRICS_SUB_BUCKET_BITS + 1 ) << METRICS_SUB_BUCKET_BITS ) +
+		   (size_t)( ( iNanoseconds >> ( iExponent - METRICS_SUB_BUCKET_BITS ) ) & ( ( 1 << METRICS_SUB_BUCKET_BITS ) - 1 ) );
+}
+
+// Returns the highest latency that falls in a bucket.
+static unsigned long long get_Bucket_Value( size_t iBucket )
+{
+	unsigned int iShift = 0;
+	unsigned long long iBase = 0;
+
+	if( iBucket < ( 1 << METRICS_SUB_BUCKET_BITS ) )
+		return iBucket;
+
+	iShift = (unsigned int)( iBucket >> METRICS_SUB_BUCKET_BITS ) - 1;
+	iBase = ( 1ULL << METRICS_SUB_BUCKET_BITS ) + ( iBucket & ( ( 1 << METRICS_SUB_BUCKET_BITS ) - 1 ) );
+
+	return ( ( iBase + 1 ) << iShift ) - 1;
+}
+
+/*********************************************************************\
+ *	Dump															 *
+\*********************************************************************/
+
+// A parse failure total, for sorting.
+struct FailureTotal
+{
+	unsigned int iSource;
+	const char* sReason;
+	unsigned long long iCount;
+
+	bool operator<( const FailureTotal& oOther ) const
+	{
+		if( iSource != oOther.iSource )
+			return iSource < oOther.iSource;
+
+		return strcmp( sReason, oOther.sReason ) < 0;
+	}
+};
+
+static void append_Line( string& sOut, const char* sFormat, ... )
+{
+	char sLine[ 512 ];
+	va_list vArguments;
+	int iLength = 0;
+
+	va_start( vArguments, sFormat );
+	iLength = vsnprintf( sLine, sizeof( sLine ), sFormat, vArguments );
+	va_end( vArguments );
+
+	if( iLength > 0 )
+		sOut.append( sLine, min( (size_t) iLength, sizeof( sLine ) - 1 ) );
+}
+
+// Sums every thread's block and appends the result, see Metrics.h.
+//	Parameters:
+//		sOut : String - Where to append the metrics.
+//////////////////////////////////////////////////////////////////////
+void append_Metrics( string& sOut )
+{
+	MetricsRegistry& oRegistry = get_Registry( );
+	ThreadMetrics* pTotal = new ThreadMetrics( );
+	vector< FailureTotal > vFailures;
+
+	{
+		lock_guard< mutex > oLock( oRegistry.oLock );
+
+		for( ThreadMetrics* pThread = oRegistry.pThreads; pThread != NULL; pThread = pThread->pNext )
+			merge_Metrics( *pTotal, *pThread );
+
+		if( oRegistry.pRetired != NULL )
+			merge_Metrics( *pTotal, *oRegistry.pRetired );
+	}
+
+	append_Line( sOut, "# calc metrics %d\n", METRICS_FORMAT_VERSION );
+
+	for( size_t i = 0; i < METRIC_OP_COUNT; ++i )
+		append_Line( sOut, "operations{op=\"%s\"} %llu\n", sOPERATOR_NAMES[ i ],
+					 pTotal->aOperations[ i ].load( memory_order_relaxed ) );
+
+	append_Line( sOut, "mem_hits %llu\n", pTotal->iMemHits.load( memory_order_relaxed ) );
+
+	for( size_t f = 0; f < METRICS_MAX_FAILURES; ++f )
+	{
+		FailureTotal oFailure = { pTotal->aFailures[ f ].iSource, pTotal->aFailures[ f ].sReason.load( memory_order_relaxed ),
+								  pTotal->aFailures[ f ].iCount.load( memory_order_relaxed ) };
+
+		if( oFailure.sReason != NULL )
+			vFailures.push_back( oFailure );
+	}
+
+	sort( vFailures.begin( ), vFailures.end( ) );
+
+	// The same reason can be spelled out in more than one place.
+	for( size_t f = 1; f < vFailures.size( ); )
+	{
+		if( vFailures[ f - 1 ].iSource == vFailures[ f ].iSource &&
+			!strcmp( vFailures[ f - 1 ].sReason, vFailures[ f ].sReason ) )
+		{
+			vFailures[ f - 1 ].iCount += vFailures[ f ].iCount;
+			vFailures.erase( vFailures.begin( ) + f );
+		}
+		else
+			++f;
+	}
+
+	for( size_t f = 0; f < vFailures.size( ); ++f )
+		append_Line( sOut, "parse_failures{source=\"%s\",reason=\"%s\"} %llu\n",
+					 sSOURCE_NAMES[ vFailures[ f ].iSource ], vFailures[ f ].sReason, vFailures[ f ].iCount );
+
+	for( size_t t = 0; t < METRIC_TIMER_COUNT; ++t )
+	{
+		const MetricCounter* pBuckets = pTotal->aHistograms[ t ];
+		unsigned long long iCount = 0;
+		unsigned long long iMax = 0;
+
+		for( size_t b = 0; b < METRICS_BUCKET_COUNT; ++b )
+		{
+			unsigned long long iBucket = pBuckets[ b ].load( memory_order_relaxed );
+
+			iCount += iBucket;
+
+			if( iBucket > 0 )
+				iMax = get_Bucket_Value( b );
+		}
+
+		for( size_t q = 0; q < sizeof( dQUANTILES ) / sizeof( dQUANTILES[ 0 ] ); ++q )
+		{
+			unsigned long long iRank = (unsigned long long)( dQUANTILES[ q ] * (double) iCount + 0.5 );
+			unsigned long long iSeen = 0;
+			unsigned long long iValue = 0;
+
+			for( size_t b = 0; b < METRICS_BUCKET_COUNT && iCount > 0; ++b )
+			{
+				iSeen += pBuckets[ b ].load( memory_order_relaxed );
+
+				if( iSeen >= iRank && iSeen > 0 )
+				{
+					iValue = get_Bucket_Value( b );
+					break;
+				}
+			}
+
+			append_Line( sOut, "latency_ns{path=\"%s\",quantile=\"%s\"} %llu\n", sTIMER_NAMES[ t ], sQUANTILES[ q ], iValue );
+		}
+
+		append_Line( sOut, "latency_ns_count{path=\"%s\"} %llu\n", sTIMER_NAMES[ t ], iCount );
+		append_Line( sOut, "latency_ns_max{path=\"%s\"} %llu\n", sTIMER_NAMES[ t ], iMax );
+	}
+
+	delete pTotal;
+}
+
+#else
+
+// Instrumentation is compiled out; the dump only says so.
+void append_Metrics( string& sOut )
+{
+	(void) sOPERATOR_NAMES;
+	(void) sSOURCE_NAMES;
+	(void) sTIMER_NAMES;
+	(void) sQUANTILES;
+	(void) dQUANTILES;
+
+	sOut.append( "# calc metrics disabled\n" );
+}
+
+#endif
+
+// Writes the metrics to a file in one go.
+void print_Metrics( FILE* pFile )
+{
+	string sOut;
+
+	append_Metrics( sOut );
+	fwrite( sOut.data( ), 1, sOut.size( ), pFile );
+	fflush( pFile );
+}
+
+#ifdef __linux__
+
+// Waits for SIGUSR1 and dumps the metrics each time it arrives.  Dumping
+// from a thread rather than a handler keeps it free to lock and allocate.
+static void run_Signal_Watcher( sigset_t oSignals )
+{
+	int iSignal = 0;
+
+	while( sigwait( &oSignals, &iSignal ) == 0 )
+		print_Metrics( stderr );
+}
+
+// Blocks SIGUSR1 in the calling thread, and so in every thread it starts
+// later, and hands it to a watcher thread.  The watcher blocks every
+// signal, so signals other modes handle never land on it.
+//	Returns:
+//		False if the watcher could not be started.
+//////////////////////////////////////////////////////////////////////
+bool watch_Metrics_Signal( )
+{
+	sigset_t oSignals;
+	sigset_t oAll;
+	sigset_t oPrevious;
+	bool bStarted = true;
+
+	sigemptyset( &oSignals );
+	sigaddset( &oSignals, SIGUSR1 );
+	sigfillset( &oAll );
+
+	if( pthread_sigmask( SIG_BLOCK, &oAll, &oPrevious ) != 0 )
+		return false;
+
+	try
+	{
+		thread( run_Signal_Watcher, oSignals ).detach( );
+	}
+	catch( const system_error& )
+	{
+		bStarted = false;
+	}
+
+	sigaddset( &oPrevious, SIGUSR1 );
+	pthread_sigmask( SIG_SETMASK, &oPrevious, NULL );
+
+	return bStarted;
+}
+
+#else
+
+// There is no SIGUSR1 to watch for.
+bool watch_Metrics_Signal( )
+{
+	return false;
+}
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef _METRICS_H
+#define _METRICS_H
+
+// Name: Metrics.h
+// Description: Hot path instrumentation: per operator counts, memory
+//				reads, parse failures by reason and latency histograms.
+//
+//				Every thread counts into its own cache line aligned block,
+//				so counting is a plain increment with no locked
+//				instruction and no sharing.  Blocks are only summed when
+//				the metrics are dumped, on SIGUSR1 or when asked for.
+//
+//				Build with CALC_METRICS defined to 0 and the hooks below
+//				compile to nothing.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstdio>
+#include <string>
+
+/////////////
+// Defines //
+/////////////
+#ifndef CALC_METRICS
+#define CALC_METRICS 1
+#endif
+
+#define METRICS_FORMAT_VERSION	1
+#define METRICS_SAMPLE_PERIOD	64		// Time one in this many calculations, a power of two
+
+// Operations counted per operator.
+enum MetricOperator
+{
+	METRIC_OP_ADD,
+	METRIC_OP_SUBTRACT,
+	METRIC_OP_MULTIPLY,
+	METRIC_OP_DIVIDE,
+	METRIC_OP_SET,
+	METRIC_OP_STORE,
+	METRIC_OP_RESET,
+	METRIC_OP_OTHER,
+	METRIC_OP_COUNT
+};
+
+// Where a parse failure came from.
+enum MetricSource
+{
+	METRIC_SOURCE_INTERACTIVE,		// The calculation prompt
+	METRIC_SOURCE_INPUT,			// The ioutil readers
+	METRIC_SOURCE_SCRIPT,			// Batch scripts and conversions
+	METRIC_SOURCE_SERVER,			// Daemon requests
+	METRIC_SOURCE_COUNT
+};
+
+// Paths with a latency histogram.
+enum MetricTimer
+{
+	METRIC_TIMER_CALCULATION,		// Calculator::process_Calculation, sampled
+	METRIC_TIMER_PARSE,				// Compiling a line typed at the prompt
+	METRIC_TIMER_READ,				// The ioutil readers, waiting on the user included
+	METRIC_TIMER_COUNT
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+
+// Appends every metric to sOut in the stable text format:
+//	# calc metrics <version>
+//	operations{op="<name>"} <count>
+//	mem_hits <count>
+//	parse_failures{source="<source>",reason="<reason>"} <count>
+//	latency_ns{path="<path>",quantile="<q>"} <nanoseconds>
+//	latency_ns_count{path="<path>"} <count>
+//	latency_ns_max{path="<path>"} <nanoseconds>
+// One metric per line, always in this order.
+void append_Metrics( std::string& sOut );
+void print_Metrics( FILE* pFile );
+
+// Dumps the metrics to stderr whenever the process gets SIGUSR1.  Must be
+// called before any other thread is started.
+bool watch_Metrics_Signal( );
+
+#if CALC_METRICS
+
+//////////////
+// Includes //
+//////////////
+#include <atomic>
+#include <chrono>
+
+/////////////
+// Defines //
+/////////////
+#define METRICS_CACHE_LINE			64
+#define METRICS_MAX_FAILURES		32		// Distinct reasons tracked per thread
+#define METRICS_SUB_BUCKET_BITS		5		// Histogram precision, about 3%
+#define METRICS_MAX_EXPONENT		40		// Latencies are capped at 2^40ns, ~18 minutes
+#define METRICS_BUCKET_COUNT		( ( METRICS_MAX_EXPONENT - METRICS_SUB_BUCKET_BITS + 2 ) << METRICS_SUB_BUCKET_BITS )
+
+// A counter only its own thread writes.  Relaxed loads and stores keep the
+// dump's reads well defined without making the increment a locked one.
+typedef std::atomic< unsigned long long > MetricCounter;
+
+inline void bump( MetricCounter& oCounter, unsigned long long iAmount = 1 )
+{
+	oCounter.store( oCounter.load( std::memory_order_relaxed ) + iAmount, std::memory_order_relaxed );
+}
+
+// A parse failure reason seen by this thread.  Reasons are string
+// literals, so the pointer identifies them.
+struct MetricFailure
+{
+	std::atomic< const char* > sReason;
+	unsigned int iSource;
+	MetricCounter iCount;
+};
+
+// One thread's metrics.  The counters touched on every operation come
+// first so they share a line.
+struct alignas( METRICS_CACHE_LINE ) ThreadMetrics
+{
+	MetricCounter aOperations[ METRIC_OP_COUNT ];
+	MetricCounter iMemHits;
+	unsigned long long iSampleTick;
+	MetricCounter aHistograms[ METRIC_TIMER_COUNT ][ METRICS_BUCKET_COUNT ];
+	MetricFailure aFailures[ METRICS_MAX_FAILURES ];
+	ThreadMetrics* pNext;
+};
+
+extern thread_local ThreadMetrics* t_pMetrics;
+
+ThreadMetrics* register_Metrics_Thread( );
+void record_Failure( ThreadMetrics* pMetrics, MetricSource eSource, const char* sReason );
+size_t get_Metrics_Bucket( unsigned long long iNanoseconds );
+
+// Returns this thread's block, creating it on first use.
+inline ThreadMetrics* get_Thread_Metrics( )
+{
+	ThreadMetrics* pMetrics = t_pMetrics;
+
+	return pMetrics != NULL ? pMetrics : register_Metrics_Thread( );
+}
+
+inline void count_Operator( MetricOperator eOperator )
+{
+	bump( get_Thread_Metrics( )->aOperations[ eOperator ] );
+}
+
+inline void count_Mem_Hit( unsigned long long iCount = 1 )
+{
+	bump( get_Thread_Metrics( )->iMemHits, iCount );
+}
+
+inline void count_Failure( MetricSource eSource, const char* sReason )
+{
+	record_Failure( get_Thread_Metrics( ), eSource, sReason );
+}
+
+// Times its scope into a histogram, or one in iPeriod of its scopes.
+class MetricScope
+{
+public:
+	MetricScope( MetricTimer eTimer, unsigned long long iPeriod )
+	{
+		m_pMetrics = get_Thread_Metrics( );
+		m_eTimer = eTimer;
+		m_bTiming = ( m_pMetrics->iSampleTick++ & ( iPeriod - 1 ) ) == 0;
+
+		if( m_bTiming )
+			m_oStart = std::chrono::steady_clock::now( );
+	}
+
+	~MetricScope( )
+	{
+		if( m_bTiming )
+		{
+			long long iElapsed = (long long) std::chrono::duration_cast< std::chrono::nanoseconds >(
+									 std::chrono::steady_clock::now( ) - m_oStart ).count( );
+
+			bump( m_pMetrics->aHistograms[ m_eTimer ][ get_Metrics_Bucket( iElapsed > 0 ? (unsigned long long) iElapsed : 0 ) ] );
+		}
+	}
+
+private:
+	MetricScope( const MetricScope& );
+	MetricScope& operator=( const MetricScope& );
+
+	ThreadMetrics* m_pMetrics;
+	MetricTimer m_eTimer;
+	bool m_bTiming;
+	std::chrono::steady_clock::time_point m_oStart;
+};
+
+#define METRIC_COUNT_OPERATOR( eOperator )			count_Operator( eOperator )
+#define METRIC_COUNT_MEM_HIT( )						count_Mem_Hit( )
+#define METRIC_COUNT_MEM_HITS( iCount )				count_Mem_Hit( iCount )
+#define METRIC_COUNT_FAILURE( eSource, sReason )	count_Failure( eSource, sReason )
+#define METRIC_TIME_SCOPE( eTimer )					MetricScope oMetricScope( eTimer, 1 )
+#define METRIC_SAMPLE_SCOPE( eTimer )				MetricScope oMetricScope( eTimer, METRICS_SAMPLE_PERIOD )
+
+#else
+
+#define METRIC_COUNT_OPERATOR( eOperator )			( (void) 0 )
+#define METRIC_COUNT_MEM_HIT( )						( (void) 0 )
+#define METRIC_COUNT_MEM_HITS( iCount )				( (void) 0 )
+#define METRIC_COUNT_FAILURE( eSource, sReason )	( (void) 0 )
+#define METRIC_TIME_SCOPE( eTimer )					( (void) 0 )
+#define METRIC_SAMPLE_SCOPE( eTimer )				( (void) 0 )
+
+#endif
+
+#endif
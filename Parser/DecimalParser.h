@@ -0,0 +1,36 @@
+#ifndef _DECIMALPARSER_H
+#define _DECIMALPARSER_H
+
+// Name: DecimalParser.h
+// Description: Script lines for the decimal mode.  The syntax is the same
+//				as LineParser and ExprCompiler accept; numbers may have
+//				any number of digits and are kept exactly as written, and
+//				expressions are evaluated with BigDecimal as the line is
+//				parsed, each step rounded to the calculator's context.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "LineParser.h"
+#include "ExprCompiler.h"
+#include "../Calculator/DecimalCalculator.h"
+#include <cstddef>
+
+// A decimal script line with its operand worked out.
+struct DecimalStatement
+{
+	char cOperator;				// An operator, '=', OP_CODE_STORE or OP_CODE_RESET
+	BigDecimal oOperand;		// Only meaningful for operators and '='
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+eLineType parse_Decimal_Line( const char* sLine, size_t iLength,
+							  const DecimalCalculator& oCalculator,
+							  DecimalStatement& oStatement,
+							  CompileError& oError );
+
+#endif
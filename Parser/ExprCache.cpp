@@ -0,0 +1,383 @@
+//////////////
+// Includes //
+//////////////
+#include "ExprCache.h"
+
+/////////////
+// Defines //
+/////////////
+#define NO_ENTRY			-1
+#define INITIAL_BUCKETS		64
+#define FNV_OFFSET_BASIS	14695981039346656037ULL
+#define FNV_PRIME			1099511628211ULL
+
+// FNV-1a hash of the normalized key.
+static unsigned long long hash_Key( const std::string& sKey )
+{
+	unsigned long long iHash = FNV_OFFSET_BASIS;
+
+	for( size_t i = 0; i < sKey.size( ); ++i )
+	{
+		iHash ^= (unsigned char) sKey[ i ];
+		iHash *= FNV_PRIME;
+	}
+
+	return iHash;
+}
+
+/*********************************************************************\
+ *	Constructor														 *
+\*********************************************************************/
+
+// Creates an empty cache.
+//	Parameters:
+//		iBudgetBytes : size_t - Memory the entries may hold before the least
+//								recently used ones are evicted.
+//////////////////////////////////////////////////////////////////////
+ExprCache::ExprCache( size_t iBudgetBytes )
+{
+	m_iBudget = iBudgetBytes;
+	m_eOptimize = OPTIMIZE_OFF;
+	m_oRewrite.iKinds = 0;
+	m_oRewrite.bExact = true;
+	m_iHits = m_iMisses = m_iEvictions = m_iFailures = 0;
+	clear( );
+}
+
+/*********************************************************************\
+ *	Public Use Functions											 *
+\*********************************************************************/
+
+// Returns the compiled form of a calculation line, compiling it only if it
+// isn't already cached.
+//	Parameters:
+//		sLine : String - The line to compile.
+//		iLength : size_t - Length of the line.
+//		m_Calculator : Calculator - Calculator object for referencing operands.
+//		oError : CompileError - Where and why compiling failed.
+//	Returns:
+//		The compiled program, valid until the next call on the cache
+//		unless it is pinned with pin_Last, or NULL if the line does not
+//		compile.
+//////////////////////////////////////////////////////////////////////
+const Program* ExprCache::compile( const char* sLine, size_t iLength,
+								   Calculator* const m_Calculator,
+								   CompileError& oError )
+{
+	unsigned long long iHash = 0;
+	int iEntry = NO_ENTRY;
+	Program oProgram;
+
+	m_oRewrite.iKinds = 0;
+	m_oRewrite.bExact = true;
+	normalize( sLine, iLength );
+	iHash = hash_Key( m_sScratch );
+	iEntry = find( iHash );
+
+	// Variable slots are only good for the calculator they were compiled
+	// against; a line from another one is compiled again in its place.  A
+	// pinned entry is still in use, so it is only taken out of lookups.
+	if( iEntry != NO_ENTRY && m_oEntries[ iEntry ].oProgram.iVariableScope != 0 &&
+		m_oEntries[ iEntry ].oProgram.iVariableScope != m_Calculator->get_Variables( ).get_Id( ) )
+	{
+		if( m_oEntries[ iEntry ].iPins == 0 )
+			evict( iEntry );
+		else
+			retire( iEntry );
+
+		iEntry = NO_ENTRY;
+	}
+
+	if( iEntry != NO_ENTRY )
+	{
+		++m_iHits;
+
+		if( iEntry != m_iHead )
+		{
+			unlink( iEntry );
+			push_Front( iEntry );
+		}
+
+		m_iLast = iEntry;
+		return &m_oEntries[ iEntry ].oProgram;
+	}
+
+	++m_iMisses;
+
+	// Compile the original text so error positions match what was typed.
+	if( !compile_Line( sLine, iLength, m_Calculator, oProgram, oError ) )
+	{
+		++m_iFailures;
+		m_iLast = NO_ENTRY;
+		return NULL;
+	}
+
+	if( m_eOptimize != OPTIMIZE_OFF )
+		m_oRewrite = optimize_Program( oProgram, m_eOptimize );
+
+	if( m_vFree.empty( ) )
+	{
+		m_oEntries.push_back( Entry( ) );
+		iEntry = (int) m_oEntries.size( ) - 1;
+	}
+	else
+	{
+		iEntry = m_vFree.back( );
+		m_vFree.pop_back( );
+	}
+
+	Entry& oEntry = m_oEntries[ iEntry ];
+	oEntry.sKey = m_sScratch;
+	oEntry.iHash = iHash;
+	oEntry.oProgram.vCode.swap( oProgram.vCode );
+	oEntry.oProgram.iMaxStack = oProgram.iMaxStack;
+	oEntry.oProgram.cOperator = oProgram.cOperator;
+	oEntry.oProgram.bReadsState = oProgram.bReadsState;
+	oEntry.oProgram.iVariableScope = oProgram.iVariableScope;
+	oEntry.oProgram.oTier = ProgramTier( );
+	oEntry.iBytes = sizeof( Entry ) + sizeof( int ) + oEntry.sKey.capacity( )
+				  + oEntry.oProgram.vCode.capacity( );
+	oEntry.iPins = 0;
+	oEntry.bRetired = false;
+
+	if( ++m_iEntryCount > m_vBuckets.size( ) )
+		grow_Buckets( );
+
+	size_t iBucket = (size_t)( iHash & ( m_vBuckets.size( ) - 1 ) );
+	oEntry.iBucketNext = m_vBuckets[ iBucket ];
+	m_vBuckets[ iBucket ] = iEntry;
+	m_iBytes += oEntry.iBytes;
+	push_Front( iEntry );
+
+	// Always keep the entry just added, even if it alone is over budget.
+	trim( iEntry );
+
+	m_iLast = iEntry;
+	return &m_oEntries[ iEntry ].oProgram;
+}
+
+// Pins the entry the last call to compile returned, so its program keeps
+// its place and its code until it is unpinned, even if the cache goes
+// over budget.  Pins are counted.  The calculator and optimizer level
+// must not change while anything is pinned.
+//	Returns:
+//		The pin, to hand back to unpin.
+//////////////////////////////////////////////////////////////////////
+int ExprCache::pin_Last( )
+{
+	++m_oEntries[ m_iLast ].iPins;
+	return m_iLast;
+}
+
+// Releases a pin from pin_Last.  The entry is evicted as usual from then
+// on, once it is least recently used, or right away if a line from
+// another calculator replaced it while it was pinned.
+void ExprCache::unpin( int iPin )
+{
+	if( --m_oEntries[ iPin ].iPins == 0 && m_oEntries[ iPin ].bRetired )
+		evict( iPin );
+}
+
+// Drops every entry.  Counters are kept.
+void ExprCache::clear( )
+{
+	m_oEntries.clear( );
+	m_vFree.clear( );
+	m_vBuckets.assign( INITIAL_BUCKETS, NO_ENTRY );
+	m_iHead = m_iTail = m_iLast = NO_ENTRY;
+	m_iEntryCount = 0;
+	m_iBytes = 0;
+}
+
+// Changes the memory budget, evicting entries if it shrank.
+void ExprCache::set_Budget( size_t iBudgetBytes )
+{
+	m_iBudget = iBudgetBytes;
+	trim( NO_ENTRY );
+}
+
+// Sets how far lines are optimized when they are compiled.  Lines already
+// in the cache were compiled at the old level, so they are dropped.
+void ExprCache::set_Optimizer( eOptimizeLevel eLevel )
+{
+	if( eLevel != m_eOptimize )
+		clear( );
+
+	m_eOptimize = eLevel;
+}
+
+// Returns what the optimizer did to the line the last call to compile
+// returned.  iKinds is 0 if the line came from the cache or wasn't
+// rewritten.
+ProgramRewrite ExprCache::get_Rewrite( ) const
+{
+	return m_oRewrite;
+}
+
+// Returns the cache counters.
+ExprCacheStats ExprCache::get_Stats( ) const
+{
+	ExprCacheStats oStats;
+
+	oStats.iHits = m_iHits;
+	oStats.iMisses = m_iMisses;
+	oStats.iEvictions = m_iEvictions;
+	oStats.iFailures = m_iFailures;
+	oStats.iEntries = m_iEntryCount;
+	oStats.iBytes = m_iBytes + m_vBuckets.capacity( ) * sizeof( int );
+	oStats.iBudget = m_iBudget;
+
+	return oStats;
+}
+
+/*********************************************************************\
+ *	Private Functions												 *
+\*********************************************************************/
+
+// Copies the line into the scratch key with leading and trailing
+// whitespace removed and every run of whitespace turned into one space.
+void ExprCache::normalize( const char* sLine, size_t iLength )
+{
+	bool bPendingSpace = false;
+
+	m_sScratch.clear( );
+
+	for( size_t i = 0; i < iLength; ++i )
+	{
+		char c = sLine[ i ];
+
+		if( c == ' ' || c == '\t' )
+		{
+			bPendingSpace = !m_sScratch.empty( );
+			continue;
+		}
+
+		if( bPendingSpace )
+		{
+			m_sScratch.push_back( ' ' );
+			bPendingSpace = false;
+		}
+
+		m_sScratch.push_back( c );
+	}
+}
+
+// Finds the entry holding the scratch key, NO_ENTRY if there is none.
+int ExprCache::find( unsigned long long iHash ) const
+{
+	int iEntry = m_vBuckets[ (size_t)( iHash & ( m_vBuckets.size( ) - 1 ) ) ];
+
+	while( iEntry != NO_ENTRY )
+	{
+		const Entry& oEntry = m_oEntries[ iEntry ];
+
+		if( oEntry.iHash == iHash && oEntry.sKey == m_sScratch )
+			return iEntry;
+
+		iEntry = oEntry.iBucketNext;
+	}
+
+	return NO_ENTRY;
+}
+
+// Removes an entry from the recently used list.
+void ExprCache::unlink( int iEntry )
+{
+	Entry& oEntry = m_oEntries[ iEntry ];
+
+	if( oEntry.iPrev != NO_ENTRY )
+		m_oEntries[ oEntry.iPrev ].iNext = oEntry.iNext;
+	else
+		m_iHead = oEntry.iNext;
+
+	if( oEntry.iNext != NO_ENTRY )
+		m_oEntries[ oEntry.iNext ].iPrev = oEntry.iPrev;
+	else
+		m_iTail = oEntry.iPrev;
+}
+
+// Makes an entry the most recently used.
+void ExprCache::push_Front( int iEntry )
+{
+	Entry& oEntry = m_oEntries[ iEntry ];
+
+	oEntry.iPrev = NO_ENTRY;
+	oEntry.iNext = m_iHead;
+
+	if( m_iHead != NO_ENTRY )
+		m_oEntries[ m_iHead ].iPrev = iEntry;
+	else
+		m_iTail = iEntry;
+
+	m_iHead = iEntry;
+}
+
+// Removes an entry from its bucket, so lookups no longer find it.
+void ExprCache::unlink_Bucket( int iEntry )
+{
+	int* pLink = &m_vBuckets[ (size_t)( m_oEntries[ iEntry ].iHash & ( m_vBuckets.size( ) - 1 ) ) ];
+
+	while( *pLink != iEntry )
+		pLink = &m_oEntries[ *pLink ].iBucketNext;
+
+	*pLink = m_oEntries[ iEntry ].iBucketNext;
+}
+
+// Takes a pinned entry out of lookups and the recently used list, keeping
+// its program until the last pin is released.
+void ExprCache::retire( int iEntry )
+{
+	unlink_Bucket( iEntry );
+	unlink( iEntry );
+	m_oEntries[ iEntry ].bRetired = true;
+}
+
+// Removes an entry from the cache and frees its memory.
+void ExprCache::evict( int iEntry )
+{
+	Entry& oEntry = m_oEntries[ iEntry ];
+
+	if( !oEntry.bRetired )
+	{
+		unlink_Bucket( iEntry );
+		unlink( iEntry );
+	}
+
+	m_iBytes -= oEntry.iBytes;
+	--m_iEntryCount;
+	++m_iEvictions;
+	std::string( ).swap( oEntry.sKey );
+	std::vector< unsigned char >( ).swap( oEntry.oProgram.vCode );
+	m_vFree.push_back( iEntry );
+}
+
+// Evicts the least recently used entries until the cache is back within
+// its budget.  Pinned entries and iKeep are passed over.
+void ExprCache::trim( int iKeep )
+{
+	int iEntry = m_iTail;
+
+	while( m_iBytes > m_iBudget && iEntry != NO_ENTRY )
+	{
+		int iPrev = m_oEntries[ iEntry ].iPrev;
+
+		if( iEntry != iKeep && m_oEntries[ iEntry ].iPins == 0 )
+			evict( iEntry );
+
+		iEntry = iPrev;
+	}
+}
+
+// Doubles the bucket array, rehashing with the stored hashes.
+void ExprCache::grow_Buckets( )
+{
+	m_vBuckets.assign( m_vBuckets.size( ) * 2, NO_ENTRY );
+
+	for( int iEntry = m_iHead; iEntry != NO_ENTRY; iEntry = m_oEntries[ iEntry ].iNext )
+	{
+		size_t iBucket = (size_t)( m_oEntries[ iEntry ].iHash & ( m_vBuckets.size( ) - 1 ) );
+
+		m_oEntries[ iEntry ].iBucketNext = m_vBuckets[ iBucket ];
+		m_vBuckets[ iBucket ] = iEntry;
+	}
+}
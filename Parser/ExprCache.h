@@ -0,0 +1,105 @@
+#ifndef _EXPRCACHE_H
+#define _EXPRCACHE_H
+
+// Name: ExprCache.h
+// Description: Bounded LRU cache of compiled calculation lines, keyed by
+//				the whitespace-normalized source text.  Repeated lines skip
+//				tokenizing and parsing completely.  Lines may be run
+//				through the optimizer as they are compiled.
+//
+//				Entries never move, so a program can be handed to another
+//				thread as a pointer; pinning its entry keeps it from being
+//				evicted or reused until the other thread is done with it.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "ExprCompiler.h"
+#include "../Calculator/Optimizer.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+#define EXPR_CACHE_DEFAULT_BUDGET ( 16 << 20 )	// 16 MiB
+
+// Counters reported by the cache.
+struct ExprCacheStats
+{
+	unsigned long long iHits;
+	unsigned long long iMisses;
+	unsigned long long iEvictions;
+	unsigned long long iFailures;	// Misses that did not compile
+	size_t iEntries;
+	size_t iBytes;					// Estimated memory held by the entries
+	size_t iBudget;
+};
+
+///////////////////////////
+// ExprCache Declaration //
+///////////////////////////
+class ExprCache
+{
+public:
+	ExprCache( size_t iBudgetBytes = EXPR_CACHE_DEFAULT_BUDGET );
+
+	const Program* compile( const char* sLine, size_t iLength,
+							Calculator* const m_Calculator,
+							CompileError& oError );
+
+	int pin_Last( );
+	void unpin( int iPin );
+
+	void clear( );
+	void set_Budget( size_t iBudgetBytes );
+	void set_Optimizer( eOptimizeLevel eLevel );
+	ProgramRewrite get_Rewrite( ) const;
+	ExprCacheStats get_Stats( ) const;
+
+private:
+	struct Entry
+	{
+		std::string sKey;
+		unsigned long long iHash;
+		Program oProgram;
+		int iBucketNext;	// Next entry in the same bucket
+		int iPrev;			// Toward most recently used
+		int iNext;			// Toward least recently used
+		size_t iBytes;
+		unsigned int iPins;	// Entry may not be evicted while non-zero
+		bool bRetired;		// Out of lookups and the LRU list, evicted when unpinned
+	};
+
+	void normalize( const char* sLine, size_t iLength );
+	int find( unsigned long long iHash ) const;
+	void unlink( int iEntry );
+	void push_Front( int iEntry );
+	void unlink_Bucket( int iEntry );
+	void retire( int iEntry );
+	void evict( int iEntry );
+	void trim( int iKeep );
+	void grow_Buckets( );
+
+	std::deque< Entry > m_oEntries;		// Never reallocated, so programs stay put
+	std::vector< int > m_vBuckets;
+	std::vector< int > m_vFree;
+	std::string m_sScratch;
+	int m_iHead;
+	int m_iTail;
+	int m_iLast;					// Entry the last call to compile returned
+	size_t m_iEntryCount;
+	size_t m_iBytes;
+	size_t m_iBudget;
+	eOptimizeLevel m_eOptimize;
+	ProgramRewrite m_oRewrite;		// What the optimizer did to the last line compiled
+	unsigned long long m_iHits;
+	unsigned long long m_iMisses;
+	unsigned long long m_iEvictions;
+	unsigned long long m_iFailures;
+};
+
+#endif
@@ -0,0 +1,315 @@
+//////////////
+// Includes //
+//////////////
+#include "ExprCompiler.h"
+#include "Tokenizer.h"
+#include <cstring>
+
+/////////////
+// Defines //
+/////////////
+#define MEM_TRIGGER		"mem"
+#define VALUE_TRIGGER	"ans"
+
+// Holds the state of a single compile.
+struct CompileState
+{
+	Tokenizer* pTokens;
+	Calculator* m_Calculator;
+	Program* pProgram;
+	CompileError* pError;
+	unsigned int iDepth;		// Current stack depth of the emitted code
+	unsigned int iNesting;		// Current recursion depth
+};
+
+static bool parse_Expression( CompileState& oState, int iMinPrecedence );
+
+// Returns the binding strength of a binary operator, 0 if the character
+// isn't one of the calculator's binary operators.
+static inline int get_Precedence( char cOperator )
+{
+	return get_Operator( cOperator ).iPrecedence;
+}
+
+// Records the first error of a compile.
+static bool fail( CompileState& oState, size_t iPosition, const char* sMessage )
+{
+	oState.pError->iPosition = iPosition;
+	oState.pError->sMessage = sMessage;
+	return false;
+}
+
+// Tracks the stack depth of the emitted code.
+static bool push_Stack( CompileState& oState )
+{
+	if( ++oState.iDepth > BYTECODE_MAX_STACK )
+		return fail( oState, oState.pTokens->peek( ).iPosition, "expression is too complex" );
+
+	if( oState.iDepth > oState.pProgram->iMaxStack )
+		oState.pProgram->iMaxStack = oState.iDepth;
+
+	return true;
+}
+
+// Emits an instruction that pushes a constant.
+static bool emit_Constant( CompileState& oState, double dValue )
+{
+	unsigned char aBytes[ sizeof( double ) ];
+
+	memcpy( aBytes, &dValue, sizeof( double ) );
+	oState.pProgram->vCode.push_back( BC_CONST );
+	oState.pProgram->vCode.insert( oState.pProgram->vCode.end( ), aBytes, aBytes + sizeof( double ) );
+
+	return push_Stack( oState );
+}
+
+// Emits an instruction that pushes a variable.  The name must already
+// have been stored to, so a misspelt name is an error rather than a zero.
+static bool emit_Variable( CompileState& oState, const Token& oToken )
+{
+	unsigned int iSlot = 0;
+	unsigned char aBytes[ sizeof( iSlot ) ];
+
+	if( !oState.m_Calculator->find_Variable( oToken.sText, oToken.iLength, iSlot ) )
+		return fail( oState, oToken.iPosition, "unknown name" );
+
+	memcpy( aBytes, &iSlot, sizeof( iSlot ) );
+	oState.pProgram->vCode.push_back( BC_VAR );
+	oState.pProgram->vCode.insert( oState.pProgram->vCode.end( ), aBytes, aBytes + sizeof( iSlot ) );
+	oState.pProgram->iVariableScope = oState.m_Calculator->get_Variables( ).get_Id( );
+
+	return true;
+}
+
+// primary := number | "mem" | "ans" | name | '(' expression ')'
+static bool parse_Primary( CompileState& oState )
+{
+	const Token oToken = oState.pTokens->peek( );
+
+	switch( oToken.eType )
+	{
+	case TOKEN_NUMBER:
+		oState.pTokens->advance( );
+		return emit_Constant( oState, oToken.dValue );
+	case TOKEN_IDENTIFIER:
+		oState.pTokens->advance( );
+
+		if( oToken.iLength == 3 && !strncmp( oToken.sText, MEM_TRIGGER, 3 ) )
+			oState.pProgram->vCode.push_back( BC_MEM );
+		else if( oToken.iLength == 3 && !strncmp( oToken.sText, VALUE_TRIGGER, 3 ) )
+			oState.pProgram->vCode.push_back( BC_VALUE );
+		else if( !emit_Variable( oState, oToken ) )
+			return false;
+
+		oState.pProgram->bReadsState = true;
+		return push_Stack( oState );
+	case TOKEN_LEFT_PAREN:
+		oState.pTokens->advance( );
+
+		if( !parse_Expression( oState, 1 ) )
+			return false;
+
+		if( oState.pTokens->peek( ).eType != TOKEN_RIGHT_PAREN )
+			return fail( oState, oState.pTokens->peek( ).iPosition, "expected ')'" );
+
+		oState.pTokens->advance( );
+		return true;
+	case TOKEN_END:
+		return fail( oState, oToken.iPosition, "expected a value" );
+	case TOKEN_INVALID:
+		return fail( oState, oToken.iPosition, oToken.sError );
+	default:
+		return fail( oState, oToken.iPosition, "unexpected character" );
+	}
+}
+
+// unary := [ '-' | '+' ] primary.  One sign per operand, as in a number,
+// so "--5" is an error; "-(-5)" isn't.
+static bool parse_Unary( CompileState& oState )
+{
+	const Token& oToken = oState.pTokens->peek( );
+	bool bResult = false;
+	bool bNegate = false;
+
+	if( ++oState.iNesting > EXPR_MAX_NESTING )
+		return fail( oState, oToken.iPosition, "expression is nested too deeply" );
+
+	if( oToken.eType == TOKEN_OPERATOR && ( oToken.cOperator == '-' || oToken.cOperator == '+' ) )
+	{
+		bNegate = oToken.cOperator == '-';
+		oState.pTokens->advance( );
+
+		const Token& oNext = oState.pTokens->peek( );
+
+		if( oNext.eType == TOKEN_OPERATOR && ( oNext.cOperator == '-' || oNext.cOperator == '+' ) )
+			return fail( oState, oNext.iPosition, "only one sign is allowed" );
+	}
+
+	bResult = parse_Primary( oState );
+
+	if( bResult && bNegate )
+		oState.pProgram->vCode.push_back( BC_NEGATE );
+
+	--oState.iNesting;
+	return bResult;
+}
+
+// expression := unary ( operator expression )*, where each operator binds
+// at least as tightly as iMinPrecedence.  All operators are left
+// associative.
+static bool parse_Expression( CompileState& oState, int iMinPrecedence )
+{
+	if( !parse_Unary( oState ) )
+		return false;
+
+	for( ;; )
+	{
+		const Token& oToken = oState.pTokens->peek( );
+		int iPrecedence = 0;
+		char cOperator = 0;
+
+		if( oToken.eType == TOKEN_INVALID )
+			return fail( oState, oToken.iPosition, oToken.sError );
+
+		if( oToken.eType != TOKEN_OPERATOR )
+			return true;
+
+		cOperator = oToken.cOperator;
+		iPrecedence = get_Precedence( cOperator );
+
+		if( iPrecedence == 0 )
+			return fail( oState, oToken.iPosition, "unknown operator" );
+
+		if( iPrecedence < iMinPrecedence )
+			return true;
+
+		oState.pTokens->advance( );
+
+		if( !parse_Expression( oState, iPrecedence + 1 ) )
+			return false;
+
+		oState.pProgram->vCode.push_back( (unsigned char) cOperator );
+		--oState.iDepth;
+	}
+}
+
+// Compiles an expression on its own.  The program assigns the result.
+//	Parameters:
+//		sExpression : String - The expression to compile.
+//		iLength : size_t - Length of the expression.
+//		m_Calculator : Calculator - Calculator object for referencing operands.
+//		oProgram : Program - The compiled program to return to the caller.
+//		oError : CompileError - Where and why compiling failed.
+//	Returns:
+//		True if the expression compiled.
+//////////////////////////////////////////////////////////////////////////
+bool compile_Expression( const char* sExpression, size_t iLength,
+						 Calculator* const m_Calculator,
+						 Program& oProgram, CompileError& oError )
+{
+	Tokenizer oTokens( sExpression, iLength );
+	CompileState oState = { &oTokens, m_Calculator, &oProgram, &oError, 0, 0 };
+
+	oProgram.vCode.clear( );
+	oProgram.iMaxStack = 0;
+	oProgram.cOperator = BC_ASSIGN;
+	oProgram.bReadsState = false;
+	oProgram.iVariableScope = 0;
+	oProgram.oTier = ProgramTier( );
+
+	if( !parse_Expression( oState, 1 ) )
+		return false;
+
+	if( oTokens.peek( ).eType == TOKEN_RIGHT_PAREN )
+		return fail( oState, oTokens.peek( ).iPosition, "unmatched ')'" );
+
+	if( oTokens.peek( ).eType != TOKEN_END )
+		return fail( oState, oTokens.peek( ).iPosition, "expected an operator" );
+
+	oProgram.vCode.push_back( BC_END );
+	return true;
+}
+
+// Compiles a calculation line, either "(operator) (expression)" or
+// "= (expression)".
+//	Parameters:
+//		sLine : String - The line to compile.
+//		iLength : size_t - Length of the line.
+//		m_Calculator : Calculator - Calculator object for referencing operands.
+//		oProgram : Program - The compiled program to return to the caller.
+//		oError : CompileError - Where and why compiling failed.
+//	Returns:
+//		True if the line compiled.
+//////////////////////////////////////////////////////////////////////////
+bool compile_Line( const char* sLine, size_t iLength,
+				   Calculator* const m_Calculator,
+				   Program& oProgram, CompileError& oError )
+{
+	size_t iStart = 0;
+	char cOperator = 0;
+
+	while( iStart < iLength && ( sLine[ iStart ] == ' ' || sLine[ iStart ] == '\t' ) )
+		++iStart;
+
+	if( iStart == iLength )
+	{
+		oError.iPosition = iStart;
+		oError.sMessage = "expected an operator";
+		return false;
+	}
+
+	cOperator = sLine[ iStart ];
+
+	// "s (name)" is only read by parse_Line; it gets here if the name isn't
+	// one.
+	if( ( cOperator == 's' || cOperator == 'S' ) && iStart + 1 < iLength &&
+		( sLine[ iStart + 1 ] == ' ' || sLine[ iStart + 1 ] == '\t' ) )
+	{
+		oError.iPosition = iStart + 1;
+
+		while( oError.iPosition < iLength && ( sLine[ oError.iPosition ] == ' ' || sLine[ oError.iPosition ] == '\t' ) )
+			++oError.iPosition;
+
+		oError.sMessage = "expected a variable name";
+		return false;
+	}
+
+	if( cOperator != BC_ASSIGN && !m_Calculator->isValidOperand( cOperator ) )
+	{
+		oError.iPosition = iStart;
+		oError.sMessage = "unknown operator";
+		return false;
+	}
+
+	// A unary operator is a line on its own, which parse_Line reads.
+	if( get_Operator( cOperator ).iArity == 1 )
+	{
+		oError.iPosition = iStart + 1;
+
+		while( oError.iPosition < iLength && ( sLine[ oError.iPosition ] == ' ' || sLine[ oError.iPosition ] == '\t' ) )
+			++oError.iPosition;
+
+		oError.sMessage = "the operator takes no operand";
+		return false;
+	}
+
+	// Keep the original "(operator) (value)" form: a space must follow.
+	if( cOperator != BC_ASSIGN && iStart + 1 < iLength &&
+		sLine[ iStart + 1 ] != ' ' && sLine[ iStart + 1 ] != '\t' )
+	{
+		oError.iPosition = iStart + 1;
+		oError.sMessage = "expected a space after the operator";
+		return false;
+	}
+
+	++iStart;
+
+	if( !compile_Expression( sLine + iStart, iLength - iStart, m_Calculator, oProgram, oError ) )
+	{
+		oError.iPosition += iStart;
+		return false;
+	}
+
+	oProgram.cOperator = cOperator;
+	return true;
+}
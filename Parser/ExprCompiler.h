@@ -0,0 +1,48 @@
+#ifndef _EXPRCOMPILER_H
+#define _EXPRCOMPILER_H
+
+// Name: ExprCompiler.h
+// Description: Precedence climbing parser that compiles calculation lines
+//				into bytecode for Calculator::execute_Program.
+//
+//				Line syntax:
+//					(operator) (expression)	- apply operator with the expression
+//					= (expression)			- replace the working value
+//				Expressions may use the calculator's operators, parentheses,
+//				unary minus, numbers, "mem" for the value in memory, "ans"
+//				for the current working value and the names of variables
+//				stored with "s (name)".  Names are resolved to slots when
+//				the line is compiled.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "../Calculator/Calculator.h"
+#include "../Calculator/Bytecode.h"
+#include <cstddef>
+
+/////////////
+// Defines //
+/////////////
+#define EXPR_MAX_NESTING 256	// Deepest parenthesis/unary nesting allowed
+
+// Why and where a compile failed.
+struct CompileError
+{
+	size_t iPosition;		// Offset into the line
+	const char* sMessage;
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+bool compile_Line( const char* sLine, size_t iLength,
+				   Calculator* const m_Calculator,
+				   Program& oProgram, CompileError& oError );
+bool compile_Expression( const char* sExpression, size_t iLength,
+						 Calculator* const m_Calculator,
+						 Program& oProgram, CompileError& oError );
+
+#endif
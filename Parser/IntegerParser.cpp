@@ -0,0 +1,326 @@
+// Name: IntegerParser.cpp
+// Description: Parses and evaluates integer mode script lines.  Plain
+//				"(operator) (digits)" lines are read directly; anything
+//				else goes through a precedence climbing evaluator with the
+//				same grammar and messages as ExprCompiler.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "IntegerParser.h"
+#include <cstring>
+
+/////////////
+// Defines //
+/////////////
+#define MEM_TRIGGER		"mem"
+#define VALUE_TRIGGER	"ans"
+
+// Holds the state of evaluating a single line.
+struct IntegerState
+{
+	const char* sLine;
+	size_t iLength;
+	size_t iPosition;
+	const IntegerCalculator* pCalculator;
+	CompileError* pError;
+	unsigned int iNesting;		// Current recursion depth
+};
+
+static bool parse_Expression( IntegerState& oState, int iMinPrecedence, ExactInteger& oValue );
+
+static inline bool is_Blank( char c )
+{
+	return c == ' ' || c == '\t';
+}
+
+static inline bool is_Digit( char c )
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline bool is_Identifier_Start( char c )
+{
+	return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || c == '_';
+}
+
+static inline bool is_Identifier_Char( char c )
+{
+	return is_Identifier_Start( c ) || is_Digit( c );
+}
+
+// Records the first error of a line.
+static bool fail( IntegerState& oState, size_t iPosition, const char* sMessage )
+{
+	oState.pError->iPosition = iPosition;
+	oState.pError->sMessage = sMessage;
+	return false;
+}
+
+static void skip_Blanks( IntegerState& oState )
+{
+	while( oState.iPosition < oState.iLength && is_Blank( oState.sLine[ oState.iPosition ] ) )
+		++oState.iPosition;
+}
+
+// Returns the binding strength of a binary operator, 0 if the character
+// isn't one of the calculator's operators.
+static int get_Precedence( char cOperator, const IntegerCalculator* pCalculator )
+{
+	if( !pCalculator->isValidOperand( cOperator ) )
+		return 0;
+
+	return cOperator == '*' || cOperator == '/' ? 2 : 1;
+}
+
+// primary := digits | "mem" | "ans" | '(' expression ')'
+static bool parse_Primary( IntegerState& oState, ExactInteger& oValue )
+{
+	size_t iStart = 0;
+	char c = 0;
+
+	skip_Blanks( oState );
+	iStart = oState.iPosition;
+
+	if( iStart >= oState.iLength )
+		return fail( oState, iStart, "expected a value" );
+
+	c = oState.sLine[ iStart ];
+
+	if( is_Digit( c ) )
+	{
+		while( oState.iPosition < oState.iLength && is_Digit( oState.sLine[ oState.iPosition ] ) )
+			++oState.iPosition;
+
+		// "1.5", "1e3", "0x10" are not whole decimal numbers.
+		if( oState.iPosition < oState.iLength &&
+			( is_Identifier_Char( oState.sLine[ oState.iPosition ] ) || oState.sLine[ oState.iPosition ] == '.' ) )
+			return fail( oState, oState.iPosition, "expected a whole number" );
+
+		ExactInteger::parse_Decimal( oState.sLine + iStart, oState.iPosition - iStart, oValue );
+		return true;
+	}
+
+	if( is_Identifier_Start( c ) )
+	{
+		while( oState.iPosition < oState.iLength && is_Identifier_Char( oState.sLine[ oState.iPosition ] ) )
+			++oState.iPosition;
+
+		if( oState.iPosition - iStart == 3 && !strncmp( oState.sLine + iStart, MEM_TRIGGER, 3 ) )
+			oValue = oState.pCalculator->pull_Mem( );
+		else if( oState.iPosition - iStart == 3 && !strncmp( oState.sLine + iStart, VALUE_TRIGGER, 3 ) )
+			oValue = oState.pCalculator->read_Value( );
+		else
+			return fail( oState, iStart, "unknown name" );
+
+		return true;
+	}
+
+	if( c == '(' )
+	{
+		++oState.iPosition;
+
+		if( !parse_Expression( oState, 1, oValue ) )
+			return false;
+
+		skip_Blanks( oState );
+
+		if( oState.iPosition >= oState.iLength || oState.sLine[ oState.iPosition ] != ')' )
+			return fail( oState, oState.iPosition, "expected ')'" );
+
+		++oState.iPosition;
+		return true;
+	}
+
+	if( c == '.' )
+		return fail( oState, iStart, "expected a whole number" );
+
+	return fail( oState, iStart, "unexpected character" );
+}
+
+// unary := [ '-' | '+' ] primary.  One sign per operand, as in the double
+// mode's expressions.
+static bool parse_Unary( IntegerState& oState, ExactInteger& oValue )
+{
+	bool bResult = false;
+	char c = 0;
+
+	skip_Blanks( oState );
+
+	if( ++oState.iNesting > EXPR_MAX_NESTING )
+		return fail( oState, oState.iPosition, "expression is nested too deeply" );
+
+	c = oState.iPosition < oState.iLength ? oState.sLine[ oState.iPosition ] : 0;
+
+	if( c == '-' || c == '+' )
+	{
+		++oState.iPosition;
+		skip_Blanks( oState );
+
+		if( oState.iPosition < oState.iLength &&
+			( oState.sLine[ oState.iPosition ] == '-' || oState.sLine[ oState.iPosition ] == '+' ) )
+			return fail( oState, oState.iPosition, "only one sign is allowed" );
+	}
+
+	bResult = parse_Primary( oState, oValue );
+
+	if( bResult && c == '-' )
+		oValue.negate( );
+
+	--oState.iNesting;
+	return bResult;
+}
+
+// expression := unary ( operator expression )*, where each operator binds
+// at least as tightly as iMinPrecedence.  All operators are left
+// associative.
+static bool parse_Expression( IntegerState& oState, int iMinPrecedence, ExactInteger& oValue )
+{
+	if( !parse_Unary( oState, oValue ) )
+		return false;
+
+	for( ;; )
+	{
+		ExactInteger oRight;
+		eIntegerStatus eStatus = INTEGER_OK;
+		size_t iOperator = 0;
+		int iPrecedence = 0;
+		char c = 0;
+
+		skip_Blanks( oState );
+
+		if( oState.iPosition >= oState.iLength )
+			return true;
+
+		iOperator = oState.iPosition;
+		c = oState.sLine[ iOperator ];
+
+		// Not an operator; the caller decides whether that's an error.
+		if( is_Identifier_Char( c ) || c == '(' || c == ')' || c == '.' )
+			return true;
+
+		iPrecedence = get_Precedence( c, oState.pCalculator );
+
+		if( iPrecedence == 0 )
+			return fail( oState, iOperator, "unknown operator" );
+
+		if( iPrecedence < iMinPrecedence )
+			return true;
+
+		++oState.iPosition;
+
+		if( !parse_Expression( oState, iPrecedence + 1, oRight ) )
+			return false;
+
+		switch( c )
+		{
+		case '+':
+			oValue.add( oRight );
+			break;
+		case '-':
+			oValue.subtract( oRight );
+			break;
+		case '*':
+			oValue.multiply( oRight );
+			break;
+		default:
+			eStatus = oValue.divide( oRight, oState.pCalculator->get_Division( ) );
+			break;
+		}
+
+		if( eStatus != INTEGER_OK )
+			return fail( oState, iOperator, get_Integer_Error( eStatus ) );
+	}
+}
+
+// Parses a line of an integer mode script and evaluates its operand
+// against the calculator's current value and memory.
+//	Parameters:
+//		sLine : String - The line to parse.
+//		iLength : size_t - Length of the line.
+//		oCalculator : IntegerCalculator - Calculator for "mem" and "ans".
+//		oStatement : IntegerStatement - The parsed line for the caller.
+//		oError : CompileError - Where and why the line is invalid.
+//	Returns:
+//		The type of line read in.  oStatement is only set for
+//		LINE_OPERATION, oError only for LINE_INVALID.
+//////////////////////////////////////////////////////////////////////////////
+eLineType parse_Integer_Line( const char* sLine, size_t iLength,
+							  const IntegerCalculator& oCalculator,
+							  IntegerStatement& oStatement,
+							  CompileError& oError )
+{
+	IntegerState oState = { sLine, iLength, 0, &oCalculator, &oError, 0 };
+	size_t iDigits = 0;
+	char cFirst = 0;
+
+	while( oState.iLength > 0 && is_Blank( sLine[ oState.iLength - 1 ] ) )
+		--oState.iLength;
+
+	skip_Blanks( oState );
+
+	if( oState.iPosition == oState.iLength || sLine[ oState.iPosition ] == LINE_COMMENT )
+		return LINE_BLANK;
+
+	cFirst = sLine[ oState.iPosition++ ];
+
+	// Single character menu commands.
+	if( oState.iPosition == oState.iLength )
+	{
+		switch( cFirst )
+		{
+		case 'S':
+		case 's':
+			oStatement.cOperator = OP_CODE_STORE;
+			return LINE_OPERATION;
+		case 'R':
+		case 'r':
+			oStatement.cOperator = OP_CODE_RESET;
+			return LINE_OPERATION;
+		case 'Q':
+		case 'q':
+			return LINE_QUIT;
+		default:
+			break;
+		}
+	}
+
+	if( cFirst != BC_ASSIGN && !oCalculator.isValidOperand( cFirst ) )
+	{
+		fail( oState, oState.iPosition - 1, "unknown operator" );
+		return LINE_INVALID;
+	}
+
+	// Keep the original "(operator) (value)" form: a space must follow.
+	if( cFirst != BC_ASSIGN && oState.iPosition < oState.iLength && !is_Blank( sLine[ oState.iPosition ] ) )
+	{
+		fail( oState, oState.iPosition, "expected a space after the operator" );
+		return LINE_INVALID;
+	}
+
+	oStatement.cOperator = cFirst;
+	skip_Blanks( oState );
+
+	// Plain whole numbers skip the evaluator.
+	while( oState.iPosition + iDigits < oState.iLength && is_Digit( sLine[ oState.iPosition + iDigits ] ) )
+		++iDigits;
+
+	if( iDigits > 0 && oState.iPosition + iDigits == oState.iLength )
+	{
+		ExactInteger::parse_Decimal( sLine + oState.iPosition, iDigits, oStatement.oOperand );
+		return LINE_OPERATION;
+	}
+
+	if( !parse_Expression( oState, 1, oStatement.oOperand ) )
+		return LINE_INVALID;
+
+	if( oState.iPosition < oState.iLength )
+	{
+		fail( oState, oState.iPosition, sLine[ oState.iPosition ] == ')' ? "unmatched ')'" : "expected an operator" );
+		return LINE_INVALID;
+	}
+
+	return LINE_OPERATION;
+}
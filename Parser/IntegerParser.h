@@ -0,0 +1,35 @@
+#ifndef _INTEGERPARSER_H
+#define _INTEGERPARSER_H
+
+// Name: IntegerParser.h
+// Description: Script lines for the integer mode.  The syntax is the same
+//				as LineParser and ExprCompiler accept, but every number
+//				must be a whole decimal number, of any length, and
+//				expressions are evaluated exactly, as the line is parsed.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "LineParser.h"
+#include "ExprCompiler.h"
+#include "../Calculator/IntegerCalculator.h"
+#include <cstddef>
+
+// An integer script line with its operand worked out.
+struct IntegerStatement
+{
+	char cOperator;				// An operator, '=', OP_CODE_STORE or OP_CODE_RESET
+	ExactInteger oOperand;		// Only meaningful for operators and '='
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+eLineType parse_Integer_Line( const char* sLine, size_t iLength,
+							  const IntegerCalculator& oCalculator,
+							  IntegerStatement& oStatement,
+							  CompileError& oError );
+
+#endif
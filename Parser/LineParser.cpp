@@ -0,0 +1,163 @@
+// Name: LineParser.cpp
+// Description: Script line parser.  Accepts the same commands as the
+//				interactive menu:
+//					(operator) (value)	- perform a calculation, value may be "mem"
+//										  or a variable
+//					(operator)			- apply a unary operator
+//					s					- store the current working value
+//					s (name)			- store the current working value in a
+//										  variable
+//					r					- reset the current working value
+//					q					- stop processing the script
+//				Blank lines and lines starting with '#' are ignored.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "LineParser.h"
+#include "NumberParser.h"
+#include <cstring>
+
+/////////////
+// Defines //
+/////////////
+#define MEM_TRIGGER "mem"
+#define MEM_TRIGGER_LENGTH 3
+#define VALUE_TRIGGER "ans"
+#define VALUE_TRIGGER_LENGTH 3
+
+// Returns true for the whitespace allowed between and around tokens.
+static inline bool is_Blank( char c )
+{
+	return c == ' ' || c == '\t';
+}
+
+// Returns true for characters that may start a variable name.
+static inline bool is_Name_Start( char c )
+{
+	return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || c == '_';
+}
+
+// Returns true if [pStart, pEnd) is a name, spelled as Tokenizer reads
+// identifiers.
+static bool is_Name( const char* pStart, const char* pEnd )
+{
+	if( pStart == pEnd || !is_Name_Start( *pStart ) )
+		return false;
+
+	while( ++pStart < pEnd )
+	{
+		if( !is_Name_Start( *pStart ) && !( *pStart >= '0' && *pStart <= '9' ) )
+			return false;
+	}
+
+	return true;
+}
+
+// Parses a line of a calculation script.
+//	Parameters:
+//		sLine : String - The line to parse.
+//		iLength : size_t - Length of the line.
+//		m_Calculator : Calculator - Calculator object for referencing operands.
+//		oOperation : Operation - The parsed operation to return to the caller.
+//	Returns:
+//		The type of line read in.  oOperation is only set for LINE_OPERATION.
+//////////////////////////////////////////////////////////////////////////////
+eLineType parse_Line( const char* sLine, size_t iLength,
+					  Calculator* const m_Calculator,
+					  Operation& oOperation )
+{
+	const char* pCurr = sLine;
+	const char* pEnd = sLine + iLength;
+	NumberResult oNumber;
+	char cFirst = 0;
+
+	while( pCurr < pEnd && is_Blank( *pCurr ) )
+		++pCurr;
+
+	while( pEnd > pCurr && is_Blank( pEnd[ -1 ] ) )
+		--pEnd;
+
+	if( pCurr == pEnd || *pCurr == LINE_COMMENT )
+		return LINE_BLANK;
+
+	cFirst = *pCurr++;
+
+	// Single character menu commands.
+	if( pCurr == pEnd )
+	{
+		switch( cFirst )
+		{
+		case 'S':
+		case 's':
+			oOperation.cOpCode = OP_CODE_STORE;
+			oOperation.dValue = 0.0;
+			return LINE_OPERATION;
+		case 'R':
+		case 'r':
+			oOperation.cOpCode = OP_CODE_RESET;
+			oOperation.dValue = 0.0;
+			return LINE_OPERATION;
+		case 'Q':
+		case 'q':
+			return LINE_QUIT;
+		default:
+			if( get_Operator( cFirst ).iArity != 1 )
+				return LINE_INVALID;
+
+			oOperation.cOpCode = (unsigned char) cFirst;
+			oOperation.dValue = 0.0;
+			return LINE_OPERATION;
+		}
+	}
+
+	if( !is_Blank( *pCurr ) )
+		return LINE_INVALID;
+
+	while( is_Blank( *pCurr ) )
+		++pCurr;
+
+	oOperation.dValue = 0.0;
+
+	// s (name).  The variable gets its slot now; "s mem" is a plain store.
+	if( cFirst == 's' || cFirst == 'S' )
+	{
+		if( !is_Name( pCurr, pEnd ) || is_Special_Number( pCurr, pEnd ) ||
+			( pEnd - pCurr == VALUE_TRIGGER_LENGTH && !strncmp( pCurr, VALUE_TRIGGER, VALUE_TRIGGER_LENGTH ) ) )
+			return LINE_INVALID;
+
+		oOperation.iSlot = m_Calculator->intern_Variable( pCurr, (size_t)( pEnd - pCurr ) );
+		oOperation.cOpCode = oOperation.iSlot == VARIABLE_MEMORY_SLOT ? OP_CODE_STORE : OP_CODE_STORE_VAR;
+		return LINE_OPERATION;
+	}
+
+	// (operator) (value)
+	if( get_Operator( cFirst ).iArity != 2 )
+		return LINE_INVALID;
+
+	oOperation.cOpCode = (unsigned char) cFirst;
+
+	if( pEnd - pCurr == MEM_TRIGGER_LENGTH && !strncmp( pCurr, MEM_TRIGGER, MEM_TRIGGER_LENGTH ) )
+	{
+		oOperation.cOpCode |= OP_CODE_MEM_FLAG;
+		return LINE_OPERATION;
+	}
+
+	if( is_Name( pCurr, pEnd ) && !is_Special_Number( pCurr, pEnd ) )
+	{
+		if( !m_Calculator->find_Variable( pCurr, (size_t)( pEnd - pCurr ), oOperation.iSlot ) )
+			return LINE_INVALID;
+
+		oOperation.cOpCode |= OP_CODE_MEM_FLAG | OP_CODE_VAR_FLAG;
+		return LINE_OPERATION;
+	}
+
+	oNumber = parse_Double( pCurr, pEnd, oOperation.dValue );
+
+	if( oNumber.eError != NUMBER_OK || oNumber.pEnd != pEnd )
+		return LINE_INVALID;
+
+	return LINE_OPERATION;
+}
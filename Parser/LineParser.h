@@ -0,0 +1,37 @@
+#ifndef _LINEPARSER_H
+#define _LINEPARSER_H
+
+// Name: LineParser.h
+// Description: Parses a single line of a calculation script into an
+//				Operation without copying it out of the caller's buffer.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "../Calculator/Calculator.h"
+#include <cstddef>
+
+/////////////
+// Defines //
+/////////////
+#define LINE_COMMENT	'#'
+
+// What a script line turned out to be.
+enum eLineType
+{
+	LINE_OPERATION,		// Operation was filled in
+	LINE_BLANK,			// Empty line or comment, nothing to do
+	LINE_QUIT,			// Script asked to stop
+	LINE_INVALID		// Line could not be parsed
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+eLineType parse_Line( const char* sLine, size_t iLength,
+					  Calculator* const m_Calculator,
+					  Operation& oOperation );
+
+#endif
@@ -0,0 +1,319 @@
+// Name: MatrixParser.cpp
+// Description: Parses matrix mode script lines, loading any matrix files
+//				they name as they are parsed.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "MatrixParser.h"
+#include "NumberParser.h"
+#include "../IO/MatrixFile.h"
+#include <cstring>
+#include <vector>
+
+/////////////
+// Defines //
+/////////////
+#define MEM_TRIGGER		"mem"
+#define VALUE_TRIGGER	"ans"
+
+// Holds the state of parsing a single line.
+struct MatrixState
+{
+	const char* sLine;
+	size_t iLength;
+	size_t iPosition;
+	CompileError* pError;
+};
+
+static inline bool is_Blank( char c )
+{
+	return c == ' ' || c == '\t';
+}
+
+static inline bool is_Identifier_Start( char c )
+{
+	return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || c == '_';
+}
+
+static inline bool is_Identifier_Char( char c )
+{
+	return is_Identifier_Start( c ) || ( c >= '0' && c <= '9' );
+}
+
+// Records the first error of a line.
+static bool fail( MatrixState& oState, size_t iPosition, const char* sMessage )
+{
+	oState.pError->iPosition = iPosition;
+	oState.pError->sMessage = sMessage;
+	return false;
+}
+
+static void skip_Blanks( MatrixState& oState )
+{
+	while( oState.iPosition < oState.iLength && is_Blank( oState.sLine[ oState.iPosition ] ) )
+		++oState.iPosition;
+}
+
+// number, as NumberParser reads it.
+static bool parse_Number( MatrixState& oState, double& dValue )
+{
+	NumberResult oNumber = parse_Double( oState.sLine + oState.iPosition, oState.sLine + oState.iLength, dValue );
+
+	if( oNumber.eError != NUMBER_OK )
+		return fail( oState, (size_t)( oNumber.pEnd - oState.sLine ), get_Number_Error( oNumber.eError ) );
+
+	oState.iPosition = (size_t)( oNumber.pEnd - oState.sLine );
+	return true;
+}
+
+// path := '"' characters '"'
+static bool parse_Path( MatrixState& oState, std::string& sPath )
+{
+	const char* pStart = oState.sLine + oState.iPosition;
+	const char* pClose = NULL;
+
+	if( oState.iPosition >= oState.iLength || *pStart != '"' )
+		return fail( oState, oState.iPosition, "expected a quoted file name" );
+
+	pClose = (const char*) memchr( pStart + 1, '"', oState.iLength - oState.iPosition - 1 );
+
+	if( pClose == NULL )
+		return fail( oState, oState.iLength, "expected '\"'" );
+
+	if( pClose == pStart + 1 )
+		return fail( oState, oState.iPosition + 1, "expected a file name" );
+
+	sPath.assign( pStart + 1, pClose );
+	oState.iPosition = (size_t)( pClose + 1 - oState.sLine );
+	return true;
+}
+
+// literal := '[' row { ';' row } ']'
+// row := number { [ ',' ] number }
+static bool parse_Literal( MatrixState& oState, Matrix& oValue )
+{
+	std::vector< double > vValues;
+	size_t iRows = 0;
+	size_t iColumns = 0;
+	size_t iCount = 0;
+	bool bNeedNumber = false;
+	eMatrixStatus eStatus = MATRIX_OK;
+
+	++oState.iPosition;
+
+	for( ;; )
+	{
+		char c = 0;
+
+		skip_Blanks( oState );
+
+		if( oState.iPosition >= oState.iLength )
+			return fail( oState, oState.iPosition, "expected ']'" );
+
+		c = oState.sLine[ oState.iPosition ];
+
+		if( c == ';' || c == ']' )
+		{
+			if( iCount == 0 || bNeedNumber )
+				return fail( oState, oState.iPosition, "expected a number" );
+
+			if( iRows == 0 )
+				iColumns = iCount;
+			else if( iCount != iColumns )
+				return fail( oState, oState.iPosition, "rows have different lengths" );
+
+			++iRows;
+			iCount = 0;
+			++oState.iPosition;
+
+			if( c == ']' )
+				break;
+
+			continue;
+		}
+
+		if( c == ',' && iCount > 0 && !bNeedNumber )
+		{
+			bNeedNumber = true;
+			++oState.iPosition;
+			continue;
+		}
+
+		double dValue = 0.0;
+
+		if( !parse_Number( oState, dValue ) )
+			return false;
+
+		// "[1 2x]", "[1 2[3]"
+		if( oState.iPosition < oState.iLength && !is_Blank( oState.sLine[ oState.iPosition ] ) &&
+			oState.sLine[ oState.iPosition ] != ',' && oState.sLine[ oState.iPosition ] != ';' &&
+			oState.sLine[ oState.iPosition ] != ']' )
+			return fail( oState, oState.iPosition, "malformed number" );
+
+		vValues.push_back( dValue );
+		++iCount;
+		bNeedNumber = false;
+	}
+
+	eStatus = oValue.resize( iRows, iColumns );
+
+	if( eStatus != MATRIX_OK )
+		return fail( oState, oState.iPosition, get_Matrix_Error( eStatus ) );
+
+	memcpy( oValue.data( ), vValues.data( ), vValues.size( ) * sizeof( double ) );
+	return true;
+}
+
+// operand := number | "mem" | "ans" | literal | path
+static bool parse_Operand( MatrixState& oState, const MatrixCalculator& oCalculator, Matrix& oValue )
+{
+	size_t iStart = 0;
+	char c = 0;
+
+	skip_Blanks( oState );
+	iStart = oState.iPosition;
+
+	if( iStart >= oState.iLength )
+		return fail( oState, iStart, "expected a value" );
+
+	c = oState.sLine[ iStart ];
+
+	if( c == '[' )
+		return parse_Literal( oState, oValue );
+
+	if( c == '"' )
+	{
+		std::string sPath;
+		eMatrixStatus eStatus = MATRIX_OK;
+
+		if( !parse_Path( oState, sPath ) )
+			return false;
+
+		eStatus = load_Matrix( sPath.c_str( ), oValue );
+
+		if( eStatus != MATRIX_OK )
+			return fail( oState, iStart, get_Matrix_Error( eStatus ) );
+
+		return true;
+	}
+
+	if( is_Identifier_Start( c ) )
+	{
+		while( oState.iPosition < oState.iLength && is_Identifier_Char( oState.sLine[ oState.iPosition ] ) )
+			++oState.iPosition;
+
+		if( oState.iPosition - iStart == 3 && !strncmp( oState.sLine + iStart, MEM_TRIGGER, 3 ) )
+			oValue = oCalculator.pull_Mem( );
+		else if( oState.iPosition - iStart == 3 && !strncmp( oState.sLine + iStart, VALUE_TRIGGER, 3 ) )
+			oValue = oCalculator.read_Value( );
+		else
+			return fail( oState, iStart, "unknown name" );
+
+		return true;
+	}
+
+	double dValue = 0.0;
+
+	if( !parse_Number( oState, dValue ) )
+		return false;
+
+	// Reuse the operand's storage, most lines are scalars.
+	oValue.resize( 1, 1 );
+	oValue.data( )[ 0 ] = dValue;
+	return true;
+}
+
+// Parses a line of a matrix mode script, loading its operand.
+//	Parameters:
+//		sLine : String - The line to parse.
+//		iLength : size_t - Length of the line.
+//		oCalculator : MatrixCalculator - Calculator for "mem" and "ans".
+//		oStatement : MatrixStatement - The parsed line for the caller.
+//		oError : CompileError - Where and why the line is invalid.
+//	Returns:
+//		The type of line read in.  oStatement is only set for
+//		LINE_OPERATION, oError only for LINE_INVALID.
+//////////////////////////////////////////////////////////////////////////////
+eLineType parse_Matrix_Line( const char* sLine, size_t iLength,
+							 const MatrixCalculator& oCalculator,
+							 MatrixStatement& oStatement,
+							 CompileError& oError )
+{
+	MatrixState oState = { sLine, iLength, 0, &oError };
+	char cFirst = 0;
+
+	while( oState.iLength > 0 && is_Blank( sLine[ oState.iLength - 1 ] ) )
+		--oState.iLength;
+
+	skip_Blanks( oState );
+
+	if( oState.iPosition == oState.iLength || sLine[ oState.iPosition ] == LINE_COMMENT )
+		return LINE_BLANK;
+
+	cFirst = sLine[ oState.iPosition++ ];
+
+	// Single character menu commands.
+	if( oState.iPosition == oState.iLength )
+	{
+		switch( cFirst )
+		{
+		case 'S':
+		case 's':
+			oStatement.cOperator = OP_CODE_STORE;
+			return LINE_OPERATION;
+		case 'R':
+		case 'r':
+			oStatement.cOperator = OP_CODE_RESET;
+			return LINE_OPERATION;
+		case 'Q':
+		case 'q':
+			return LINE_QUIT;
+		default:
+			if( get_Operator( cFirst ).iArity == 1 )
+			{
+				oStatement.cOperator = cFirst;
+				oStatement.oOperand.resize( 1, 1 );
+				oStatement.oOperand.data( )[ 0 ] = 0.0;
+				return LINE_OPERATION;
+			}
+			break;
+		}
+	}
+
+	if( cFirst != BC_ASSIGN && cFirst != MATRIX_OP_WRITE && !oCalculator.isValidOperand( cFirst ) )
+	{
+		fail( oState, oState.iPosition - 1, "unknown operator" );
+		return LINE_INVALID;
+	}
+
+	// Keep the original "(operator) (value)" form: a space must follow.
+	if( cFirst != BC_ASSIGN && oState.iPosition < oState.iLength && !is_Blank( sLine[ oState.iPosition ] ) )
+	{
+		fail( oState, oState.iPosition, "expected a space after the operator" );
+		return LINE_INVALID;
+	}
+
+	oStatement.cOperator = cFirst;
+	skip_Blanks( oState );
+
+	if( cFirst == MATRIX_OP_WRITE )
+	{
+		if( !parse_Path( oState, oStatement.sPath ) )
+			return LINE_INVALID;
+	}
+	else if( !parse_Operand( oState, oCalculator, oStatement.oOperand ) )
+		return LINE_INVALID;
+
+	skip_Blanks( oState );
+
+	if( oState.iPosition < oState.iLength )
+	{
+		fail( oState, oState.iPosition, "expected the end of the line" );
+		return LINE_INVALID;
+	}
+
+	return LINE_OPERATION;
+}
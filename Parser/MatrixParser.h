@@ -0,0 +1,49 @@
+#ifndef _MATRIXPARSER_H
+#define _MATRIXPARSER_H
+
+// Name: MatrixParser.h
+// Description: Script lines for the matrix mode.  The commands are those
+//				of LineParser, plus '@' for the matrix product and
+//				"w (file)" to save the working value.  An operand is a
+//				single value:
+//					number			- a scalar, used on every element
+//					mem, ans		- memory or the working value
+//					[1 2; 3 4]		- a matrix, rows separated by ';' and
+//									  values by blanks or commas
+//					"file"			- a matrix loaded with MatrixFile
+//				There are no expressions; a line applies one operand.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "LineParser.h"
+#include "ExprCompiler.h"
+#include "../Calculator/MatrixCalculator.h"
+#include <cstddef>
+#include <string>
+
+/////////////
+// Defines //
+/////////////
+#define MATRIX_OP_WRITE 'w'		// Save the working value to sPath
+
+// A matrix script line with its operand worked out.
+struct MatrixStatement
+{
+	char cOperator;				// An operator, MATRIX_PRODUCT, '=', MATRIX_OP_WRITE,
+								// OP_CODE_STORE or OP_CODE_RESET
+	Matrix oOperand;			// Only meaningful for operators and '='
+	std::string sPath;			// Only meaningful for MATRIX_OP_WRITE
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+eLineType parse_Matrix_Line( const char* sLine, size_t iLength,
+							 const MatrixCalculator& oCalculator,
+							 MatrixStatement& oStatement,
+							 CompileError& oError );
+
+#endif
@@ -0,0 +1,357 @@
+//////////////
+// Includes //
+//////////////
+#include "NumberParser.h"
+#include <charconv>
+#include <cstring>
+#include <system_error>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define NUMBER_HAS_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if ( defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ) || defined( _WIN32 )
+#define NUMBER_LITTLE_ENDIAN 1
+#endif
+
+/////////////
+// Defines //
+/////////////
+#define MAX_FAST_DIGITS		19						// Always fits in 64 bits
+#define MAX_EXACT_MANTISSA	( 1ULL << 53 )			// Largest exactly representable run
+#define MAX_EXACT_POWER		22						// 10^22 is the largest exact power of ten
+#define MAX_EXPONENT		100000					// Exponents are clamped here while reading
+
+// Powers of ten that are exact doubles.
+static const double dEXACT_POWERS[ MAX_EXACT_POWER + 1 ] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Returns true for '0' through '9'.
+static inline bool is_Digit( char c )
+{
+	return c >= '0' && c <= '9';
+}
+
+// Returns the end of the run of digits starting at pBegin.  Long runs are
+// checked 16 characters at a time.
+static const char* skip_Digits( const char* pBegin, const char* pEnd )
+{
+	const char* pCurr = pBegin;
+
+#ifdef NUMBER_HAS_SSE2
+	const __m128i vBelow = _mm_set1_epi8( '0' - 1 );
+	const __m128i vAbove = _mm_set1_epi8( '9' + 1 );
+
+	while( pEnd - pCurr >= 16 )
+	{
+		__m128i vChars = _mm_loadu_si128( (const __m128i*) pCurr );
+		__m128i vDigits = _mm_and_si128( _mm_cmpgt_epi8( vChars, vBelow ), _mm_cmplt_epi8( vChars, vAbove ) );
+		unsigned int iMask = (unsigned int) _mm_movemask_epi8( vDigits );
+
+		if( iMask != 0xFFFF )
+		{
+#ifdef _MSC_VER
+			unsigned long iFirst = 0;
+			_BitScanForward( &iFirst, ~iMask );
+			return pCurr + iFirst;
+#else
+			return pCurr + __builtin_ctz( ~iMask );
+#endif
+		}
+
+		pCurr += 16;
+	}
+#endif
+
+	while( pCurr < pEnd && is_Digit( *pCurr ) )
+		++pCurr;
+
+	return pCurr;
+}
+
+// Converts exactly 8 digit characters to their value without a loop.
+static inline unsigned long long parse_Eight_Digits( const char* pDigits )
+{
+#ifdef NUMBER_LITTLE_ENDIAN
+	unsigned long long iChunk = 0;
+
+	memcpy( &iChunk, pDigits, 8 );
+	iChunk = ( ( iChunk & 0x0F0F0F0F0F0F0F0FULL ) * 2561 ) >> 8;
+	iChunk = ( ( iChunk & 0x00FF00FF00FF00FFULL ) * 6553601 ) >> 16;
+	iChunk = ( ( iChunk & 0x0000FFFF0000FFFFULL ) * 42949672960001ULL ) >> 32;
+	return iChunk;
+#else
+	unsigned long long iValue = 0;
+
+	for( int i = 0; i < 8; ++i )
+		iValue = iValue * 10 + (unsigned long long)( pDigits[ i ] - '0' );
+
+	return iValue;
+#endif
+}
+
+// Appends a run of digits to a mantissa.  The caller makes sure the result
+// fits in MAX_FAST_DIGITS.
+static unsigned long long accumulate_Digits( unsigned long long iMantissa, const char* pBegin, const char* pEnd )
+{
+	while( pEnd - pBegin >= 8 )
+	{
+		iMantissa = iMantissa * 100000000ULL + parse_Eight_Digits( pBegin );
+		pBegin += 8;
+	}
+
+	while( pBegin < pEnd )
+		iMantissa = iMantissa * 10 + (unsigned long long)( *pBegin++ - '0' );
+
+	return iMantissa;
+}
+
+// Returns the decimal exponent of the leading non-zero digit of a number,
+// which tells a number from_chars found out of range too large from too
+// small.  The number has at least one non-zero digit.
+static long get_Leading_Exponent( const char* pInteger, const char* pIntegerEnd,
+								  const char* pFraction, const char* pFractionEnd, long iExponent )
+{
+	while( pInteger < pIntegerEnd && *pInteger == '0' )
+		++pInteger;
+
+	if( pInteger < pIntegerEnd )
+		return iExponent + (long)( pIntegerEnd - pInteger ) - 1;
+
+	const char* pDigit = pFraction;
+
+	while( pDigit < pFractionEnd && *pDigit == '0' )
+		++pDigit;
+
+	return iExponent - (long)( pDigit - pFraction ) - 1;
+}
+
+// Parses a floating point number:
+//	[+-] ( digits [ '.' digits* ] | '.' digits ) [ ( 'e' | 'E' ) [+-] digits ]
+// or "inf", "infinity", "nan" in any case, always in the C locale.
+//	Parameters:
+//		sBegin, sEnd : const char* - The characters to parse from.  Parsing
+//									 stops at the first character that
+//									 can't continue the number.
+//		dValue : double - Receives the correctly rounded value.  Numbers
+//						  too small for a subnormal round to a signed
+//						  zero, as with from_chars' rounding.
+//	Returns:
+//		Where the number ended, or where and why it failed.
+//////////////////////////////////////////////////////////////////////
+NumberResult parse_Double( const char* sBegin, const char* sEnd, double& dValue )
+{
+	NumberResult oResult = { NUMBER_OK, sBegin };
+	const char* pCurr = sBegin;
+	const char* pNumber = NULL;
+	const char* pIntegerEnd = NULL;
+	const char* pFraction = NULL;
+	const char* pFractionEnd = NULL;
+	bool bNegative = false;
+	long iExponent = 0;
+
+	if( pCurr < sEnd && ( *pCurr == '-' || *pCurr == '+' ) )
+		bNegative = ( *pCurr++ == '-' );
+
+	pNumber = pCurr;
+
+	// from_chars would take a second sign, so the number must start here.
+	if( pCurr >= sEnd || !( is_Digit( *pCurr ) || *pCurr == '.' || *pCurr == 'i' || *pCurr == 'I' ||
+							*pCurr == 'n' || *pCurr == 'N' ) )
+	{
+		oResult.eError = NUMBER_NO_DIGITS;
+		oResult.pEnd = pNumber;
+		return oResult;
+	}
+
+	pIntegerEnd = skip_Digits( pCurr, sEnd );
+	pFraction = pFractionEnd = pIntegerEnd;
+
+	if( pIntegerEnd < sEnd && *pIntegerEnd == '.' )
+	{
+		pFraction = pIntegerEnd + 1;
+		pFractionEnd = skip_Digits( pFraction, sEnd );
+	}
+
+	size_t iIntegerDigits = (size_t)( pIntegerEnd - pNumber );
+	size_t iFractionDigits = (size_t)( pFractionEnd - pFraction );
+
+	if( iIntegerDigits + iFractionDigits > 0 )
+	{
+		pCurr = pFractionEnd;
+
+		// The exponent only counts if it has digits, "1e" is just "1".
+		if( pCurr < sEnd && ( *pCurr == 'e' || *pCurr == 'E' ) )
+		{
+			const char* pExponent = pCurr + 1;
+			bool bNegativeExponent = false;
+
+			if( pExponent < sEnd && ( *pExponent == '-' || *pExponent == '+' ) )
+				bNegativeExponent = ( *pExponent++ == '-' );
+
+			if( pExponent < sEnd && is_Digit( *pExponent ) )
+			{
+				while( pExponent < sEnd && is_Digit( *pExponent ) )
+				{
+					if( iExponent < MAX_EXPONENT )
+						iExponent = iExponent * 10 + ( *pExponent - '0' );
+
+					++pExponent;
+				}
+
+				iExponent = bNegativeExponent ? -iExponent : iExponent;
+				pCurr = pExponent;
+			}
+		}
+
+		// Fast path: the digits and the power of ten are both exact, so
+		// one multiply or divide rounds correctly.
+		if( iIntegerDigits + iFractionDigits <= MAX_FAST_DIGITS )
+		{
+			unsigned long long iMantissa = accumulate_Digits( 0, pNumber, pIntegerEnd );
+			long iPower = iExponent - (long) iFractionDigits;
+
+			iMantissa = accumulate_Digits( iMantissa, pFraction, pFractionEnd );
+
+			if( iMantissa <= MAX_EXACT_MANTISSA && iPower >= -MAX_EXACT_POWER && iPower <= MAX_EXACT_POWER )
+			{
+				double dResult = (double) iMantissa;
+
+				dResult = iPower < 0 ? dResult / dEXACT_POWERS[ -iPower ] : dResult * dEXACT_POWERS[ iPower ];
+				dValue = bNegative ? -dResult : dResult;
+				oResult.pEnd = pCurr;
+				return oResult;
+			}
+		}
+	}
+
+	// Everything else, including inf and nan, is left to from_chars.
+	double dResult = 0.0;
+	std::from_chars_result oConverted = std::from_chars( pNumber, sEnd, dResult );
+
+	if( oConverted.ec == std::errc::invalid_argument )
+	{
+		oResult.eError = NUMBER_NO_DIGITS;
+		oResult.pEnd = pNumber;
+	}
+	else if( oConverted.ec == std::errc::result_out_of_range &&
+			 get_Leading_Exponent( pNumber, pIntegerEnd, pFraction, pFractionEnd, iExponent ) < 0 )
+	{
+		// from_chars reports underflow as out of range too.
+		dValue = bNegative ? -0.0 : 0.0;
+		oResult.pEnd = oConverted.ptr;
+	}
+	else if( oConverted.ec == std::errc::result_out_of_range )
+	{
+		oResult.eError = NUMBER_OUT_OF_RANGE;
+		oResult.pEnd = sBegin;
+	}
+	else
+	{
+		dValue = bNegative ? -dResult : dResult;
+		oResult.pEnd = oConverted.ptr;
+	}
+
+	return oResult;
+}
+
+// Parses an integer: [+-] digits.  A base of 0 picks the base from the
+// prefix the way strtol does: "0x" for 16, a leading "0" for 8, else 10.
+//	Parameters:
+//		sBegin, sEnd : const char* - The characters to parse from.
+//		iValue : long long - Receives the value.
+//		iBase : int - 0, or a base from 2 to 36.
+//	Returns:
+//		Where the number ended, or where and why it failed.
+//////////////////////////////////////////////////////////////////////
+NumberResult parse_Integer( const char* sBegin, const char* sEnd, long long& iValue, int iBase )
+{
+	NumberResult oResult = { NUMBER_OK, sBegin };
+	const char* pCurr = sBegin;
+	bool bNegative = false;
+	unsigned long long iMagnitude = 0;
+
+	if( iBase != 0 && ( iBase < 2 || iBase > 36 ) )
+	{
+		oResult.eError = NUMBER_BAD_BASE;
+		return oResult;
+	}
+
+	if( pCurr < sEnd && ( *pCurr == '-' || *pCurr == '+' ) )
+		bNegative = ( *pCurr++ == '-' );
+
+	if( ( iBase == 0 || iBase == 16 ) && sEnd - pCurr > 2 && pCurr[ 0 ] == '0' &&
+		( pCurr[ 1 ] == 'x' || pCurr[ 1 ] == 'X' ) )
+	{
+		pCurr += 2;
+		iBase = 16;
+	}
+	else if( iBase == 0 )
+		iBase = ( pCurr < sEnd && *pCurr == '0' ) ? 8 : 10;
+
+	// Parse the magnitude unsigned so the most negative value still fits.
+	std::from_chars_result oConverted = std::from_chars( pCurr, sEnd, iMagnitude, iBase );
+
+	if( oConverted.ec == std::errc::invalid_argument )
+	{
+		oResult.eError = NUMBER_NO_DIGITS;
+		oResult.pEnd = pCurr;
+	}
+	else if( oConverted.ec == std::errc::result_out_of_range ||
+			 iMagnitude > ( bNegative ? 9223372036854775808ULL : 9223372036854775807ULL ) )
+	{
+		oResult.eError = NUMBER_OUT_OF_RANGE;
+	}
+	else
+	{
+		iValue = bNegative ? (long long)( 0 - iMagnitude ) : (long long) iMagnitude;
+		oResult.pEnd = oConverted.ptr;
+	}
+
+	return oResult;
+}
+
+// Returns true if the characters are exactly "nan", "inf" or "infinity"
+// in any case, the names parse_Double reads as numbers.  Parsers that
+// take names check this first, so these are never taken for variables.
+bool is_Special_Number( const char* sBegin, const char* sEnd )
+{
+	static const char* const aNames[] = { "nan", "inf", "infinity" };
+	size_t iLength = (size_t)( sEnd - sBegin );
+
+	for( size_t i = 0; i < sizeof( aNames ) / sizeof( aNames[ 0 ] ); ++i )
+	{
+		size_t j = 0;
+
+		if( strlen( aNames[ i ] ) != iLength )
+			continue;
+
+		while( j < iLength && ( sBegin[ j ] | 0x20 ) == aNames[ i ][ j ] )
+			++j;
+
+		if( j == iLength )
+			return true;
+	}
+
+	return false;
+}
+
+// Returns a message describing a parse error.
+const char* get_Number_Error( eNumberError eError )
+{
+	switch( eError )
+	{
+	case NUMBER_OK:				return "no error";
+	case NUMBER_NO_DIGITS:		return "expected a number";
+	case NUMBER_OUT_OF_RANGE:	return "number out of range";
+	case NUMBER_BAD_BASE:		return "unsupported base";
+	default:					return "invalid number";
+	}
+}
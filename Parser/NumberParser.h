@@ -0,0 +1,44 @@
+#ifndef _NUMBERPARSER_H
+#define _NUMBERPARSER_H
+
+// Name: NumberParser.h
+// Description: Locale-free number parsing shared by every parser in the
+//				calculator.  Doubles are correctly rounded: plain decimals
+//				with few enough digits are converted exactly on a fast
+//				path, and everything else goes through std::from_chars.
+//				Unlike atof/strtol, nothing is skipped silently and a
+//				failed parse reports where it went wrong.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstddef>
+
+// Why a number failed to parse.
+enum eNumberError
+{
+	NUMBER_OK,
+	NUMBER_NO_DIGITS,		// Nothing that looks like a number
+	NUMBER_OUT_OF_RANGE,	// Too large for the type; doubles too small round to zero
+	NUMBER_BAD_BASE			// Unsupported integer base
+};
+
+// Outcome of a parse.  On success pEnd is one past the last character of
+// the number; on failure it points at the offending character.
+struct NumberResult
+{
+	eNumberError eError;
+	const char* pEnd;
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+NumberResult parse_Double( const char* sBegin, const char* sEnd, double& dValue );
+NumberResult parse_Integer( const char* sBegin, const char* sEnd, long long& iValue, int iBase );
+bool is_Special_Number( const char* sBegin, const char* sEnd );
+const char* get_Number_Error( eNumberError eError );
+
+#endif
@@ -0,0 +1,129 @@
+//////////////
+// Includes //
+//////////////
+#include "Tokenizer.h"
+#include "NumberParser.h"
+
+// Returns true for characters that may start an identifier.
+static inline bool is_Identifier_Start( char c )
+{
+	return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || c == '_';
+}
+
+// Returns true for characters that may continue an identifier.
+static inline bool is_Identifier_Char( char c )
+{
+	return is_Identifier_Start( c ) || ( c >= '0' && c <= '9' );
+}
+
+// Returns true for characters that may start a numeric literal.  Signs are
+// left to the parser as unary operators.
+static inline bool is_Number_Start( char c )
+{
+	return ( c >= '0' && c <= '9' ) || c == '.';
+}
+
+// Creates a tokenizer positioned on the first token of the input.
+Tokenizer::Tokenizer( const char* sInput, size_t iLength )
+{
+	m_sInput = sInput;
+	m_iLength = iLength;
+	m_iPosition = 0;
+	advance( );
+}
+
+// Returns the current token.
+const Token& Tokenizer::peek( ) const
+{
+	return m_oCurrent;
+}
+
+// Moves on to the next token.
+void Tokenizer::advance( )
+{
+	const char* pInputEnd = m_sInput + m_iLength;
+	NumberResult oNumber;
+	char c = 0;
+
+	while( m_iPosition < m_iLength && ( m_sInput[ m_iPosition ] == ' ' || m_sInput[ m_iPosition ] == '\t' ) )
+		++m_iPosition;
+
+	m_oCurrent.iPosition = m_iPosition;
+	m_oCurrent.sText = m_sInput + m_iPosition;
+	m_oCurrent.iLength = 0;
+	m_oCurrent.dValue = 0.0;
+	m_oCurrent.cOperator = 0;
+	m_oCurrent.sError = "unexpected character";
+
+	if( m_iPosition >= m_iLength )
+	{
+		m_oCurrent.eType = TOKEN_END;
+		return;
+	}
+
+	c = m_sInput[ m_iPosition ];
+
+	if( is_Number_Start( c ) )
+	{
+		oNumber = parse_Double( m_oCurrent.sText, pInputEnd, m_oCurrent.dValue );
+
+		if( oNumber.eError != NUMBER_OK )
+		{
+			// Point the token at the offending character.
+			m_oCurrent.eType = TOKEN_INVALID;
+			m_oCurrent.sError = get_Number_Error( oNumber.eError );
+			m_oCurrent.iPosition = (size_t)( oNumber.pEnd - m_sInput );
+			m_oCurrent.sText = oNumber.pEnd;
+			m_oCurrent.iLength = 1;
+			m_iPosition = m_oCurrent.iPosition;
+		}
+		else if( oNumber.pEnd < pInputEnd && ( is_Identifier_Char( *oNumber.pEnd ) || *oNumber.pEnd == '.' ) )
+		{
+			// "12abc", "1e5e", "1.2.3"
+			m_oCurrent.eType = TOKEN_INVALID;
+			m_oCurrent.sError = "malformed number";
+			m_oCurrent.iPosition = (size_t)( oNumber.pEnd - m_sInput );
+			m_oCurrent.sText = oNumber.pEnd;
+			m_oCurrent.iLength = 1;
+			m_iPosition = m_oCurrent.iPosition;
+		}
+		else
+		{
+			m_oCurrent.eType = TOKEN_NUMBER;
+			m_oCurrent.iLength = (size_t)( oNumber.pEnd - m_oCurrent.sText );
+		}
+	}
+	else if( is_Identifier_Start( c ) )
+	{
+		m_oCurrent.eType = TOKEN_IDENTIFIER;
+
+		while( m_iPosition + m_oCurrent.iLength < m_iLength &&
+			   is_Identifier_Char( m_sInput[ m_iPosition + m_oCurrent.iLength ] ) )
+			++m_oCurrent.iLength;
+
+		// "nan", "inf" and "infinity" are numbers, not names.
+		if( is_Special_Number( m_oCurrent.sText, m_oCurrent.sText + m_oCurrent.iLength ) )
+		{
+			parse_Double( m_oCurrent.sText, m_oCurrent.sText + m_oCurrent.iLength, m_oCurrent.dValue );
+			m_oCurrent.eType = TOKEN_NUMBER;
+		}
+	}
+	else
+	{
+		m_oCurrent.iLength = 1;
+
+		if( c == '(' )
+			m_oCurrent.eType = TOKEN_LEFT_PAREN;
+		else if( c == ')' )
+			m_oCurrent.eType = TOKEN_RIGHT_PAREN;
+		else if( c > ' ' && c < 127 )
+		{
+			m_oCurrent.eType = TOKEN_OPERATOR;
+			m_oCurrent.cOperator = c;
+		}
+		else
+			m_oCurrent.eType = TOKEN_INVALID;
+	}
+
+	m_iPosition += m_oCurrent.iLength;
+}
@@ -0,0 +1,56 @@
+#ifndef _TOKENIZER_H
+#define _TOKENIZER_H
+
+// Name: Tokenizer.h
+// Description: Splits a calculator expression into tokens.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstddef>
+
+// Kinds of token in an expression.
+enum eTokenType
+{
+	TOKEN_NUMBER,		// Numeric literal, dValue is set
+	TOKEN_IDENTIFIER,	// Name such as "mem", sText/iLength are set
+	TOKEN_OPERATOR,		// Any other punctuation, cOperator is set
+	TOKEN_LEFT_PAREN,
+	TOKEN_RIGHT_PAREN,
+	TOKEN_END,			// End of the input
+	TOKEN_INVALID		// Character that can't start a token
+};
+
+struct Token
+{
+	eTokenType eType;
+	size_t iPosition;	// Offset of the token in the input
+	const char* sText;
+	size_t iLength;
+	double dValue;
+	char cOperator;
+	const char* sError;	// Why a TOKEN_INVALID is invalid
+};
+
+////////////////////////////
+// Tokenizer Declaration  //
+////////////////////////////
+// Tokens point into the input, nothing is copied.
+class Tokenizer
+{
+public:
+	Tokenizer( const char* sInput, size_t iLength );
+
+	const Token& peek( ) const;
+	void advance( );
+
+private:
+	const char* m_sInput;
+	size_t m_iLength;
+	size_t m_iPosition;
+	Token m_oCurrent;
+};
+
+#endif
@@ -0,0 +1,396 @@
+// Name: CalcClient.cpp
+// Description: Loopback client and load generator for the daemon.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "CalcClient.h"
+#include <cstdio>
+
+#ifdef __linux__
+
+#include "Protocol.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define CLIENT_READ_SIZE	65536
+
+// Connects to the daemon.
+//	Returns:
+//		The socket, or -1 on failure.
+//////////////////////////////////////////////////////////////////////
+static int connect_Server( const char* sPath )
+{
+	sockaddr_un oAddress;
+	int iFile = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+
+	memset( &oAddress, 0, sizeof( oAddress ) );
+	oAddress.sun_family = AF_UNIX;
+	strncpy( oAddress.sun_path, sPath, sizeof( oAddress.sun_path ) - 1 );
+
+	if( iFile < 0 || connect( iFile, (sockaddr*) &oAddress, sizeof( oAddress ) ) < 0 )
+	{
+		perror( sPath );
+
+		if( iFile >= 0 )
+			close( iFile );
+
+		return -1;
+	}
+
+	return iFile;
+}
+
+// Sends the whole buffer.
+static bool send_All( int iFile, const char* pData, size_t iSize )
+{
+	while( iSize > 0 )
+	{
+		ssize_t iSent = send( iFile, pData, iSize, MSG_NOSIGNAL );
+
+		if( iSent < 0 && errno == EINTR )
+			continue;
+
+		if( iSent <= 0 )
+			return false;
+
+		pData += iSent;
+		iSize -= (size_t) iSent;
+	}
+
+	return true;
+}
+
+/*********************************************************************\
+ *	Loopback Client													 *
+\*********************************************************************/
+
+// Sends every line from stdin to one session and prints the answers.
+//	Parameters:
+//		sSocketPath : String - Daemon socket to connect to.
+//		iSession : unsigned long long - Session to use.
+//	Returns:
+//		0 on success, 1 if the daemon could not be reached.
+//////////////////////////////////////////////////////////////////////
+int run_Client( const char* sSocketPath, unsigned long long iSession )
+{
+	char sLine[ PROTOCOL_MAX_LINE ];
+	char aBuffer[ CLIENT_READ_SIZE ];
+	string sInput;
+	string sRequest;
+	int iFile = connect_Server( sSocketPath );
+
+	if( iFile < 0 )
+		return 1;
+
+	while( fgets( sLine, sizeof( sLine ), stdin ) != NULL )
+	{
+		size_t iEnd = string::npos;
+		size_t iLength = strcspn( sLine, "\r\n" );
+		const char* sAnswer = NULL;
+
+		sRequest = to_string( iSession );
+		sRequest.append( 1, ' ' ).append( sLine, iLength ).append( 1, '\n' );
+
+		if( !send_All( iFile, sRequest.data( ), sRequest.size( ) ) )
+			break;
+
+		while( ( iEnd = sInput.find( '\n' ) ) == string::npos )
+		{
+			ssize_t iRead = recv( iFile, aBuffer, sizeof( aBuffer ), 0 );
+
+			if( iRead < 0 && errno == EINTR )
+				continue;
+
+			if( iRead <= 0 )
+			{
+				fprintf( stderr, "Connection closed by the daemon.\n" );
+				close( iFile );
+				return 1;
+			}
+
+			sInput.append( aBuffer, (size_t) iRead );
+		}
+
+		// Print the answer without the session ID.
+		sAnswer = strchr( sInput.c_str( ), ' ' );
+		printf( "%.*s\n", (int)( iEnd - ( sAnswer != NULL ? sAnswer + 1 - sInput.c_str( ) : 0 ) ),
+				sAnswer != NULL ? sAnswer + 1 : sInput.c_str( ) );
+		fflush( stdout );
+
+		if( iEnd >= 7 && sInput.compare( iEnd - 7, 7, " closed" ) == 0 )
+			break;
+
+		sInput.erase( 0, iEnd + 1 );
+	}
+
+	close( iFile );
+	return 0;
+}
+
+// Asks the daemon for its metrics and prints them.
+//	Parameters:
+//		sSocketPath : String - Daemon socket to connect to.
+//	Returns:
+//		0 on success, 1 if the daemon could not be reached.
+//////////////////////////////////////////////////////////////////////
+int run_Metrics_Query( const char* sSocketPath )
+{
+	static const char sQUERY[] = PROTOCOL_METRICS_QUERY "\n";
+	char aBuffer[ CLIENT_READ_SIZE ];
+	string sInput;
+	int iFile = connect_Server( sSocketPath );
+
+	if( iFile < 0 )
+		return 1;
+
+	if( !send_All( iFile, sQUERY, sizeof( sQUERY ) - 1 ) )
+	{
+		close( iFile );
+		return 1;
+	}
+
+	while( sInput.size( ) < sizeof( PROTOCOL_METRICS_END ) - 1 ||
+		   sInput.compare( sInput.size( ) - ( sizeof( PROTOCOL_METRICS_END ) - 1 ), string::npos, PROTOCOL_METRICS_END ) != 0 )
+	{
+		ssize_t iRead = recv( iFile, aBuffer, sizeof( aBuffer ), 0 );
+
+		if( iRead < 0 && errno == EINTR )
+			continue;
+
+		if( iRead <= 0 )
+		{
+			fprintf( stderr, "Connection closed by the daemon.\n" );
+			close( iFile );
+			return 1;
+		}
+
+		sInput.append( aBuffer, (size_t) iRead );
+	}
+
+	fwrite( sInput.data( ), 1, sInput.size( ) - ( sizeof( PROTOCOL_METRICS_END ) - 1 ), stdout );
+	close( iFile );
+	return 0;
+}
+
+/*********************************************************************\
+ *	Load Generator													 *
+\*********************************************************************/
+
+// What one load generator connection measured.
+struct LoadResult
+{
+	unsigned long long iCompleted;
+	unsigned long long iErrors;
+	vector< double > vLatencies;	// Per request, in microseconds
+	bool bFailed;
+};
+
+// Runs one connection's share of the load.  Every session keeps exactly
+// one request in flight, so an answer's session ID says which request it
+// belongs to even when workers answer out of order.
+//////////////////////////////////////////////////////////////////////
+static void run_Connection( const char* sSocketPath, unsigned long long iFirstSession,
+							unsigned long long iSessions, unsigned long long iRequests,
+							LoadResult& oResult )
+{
+	static const char* sLINES[] =
+	{
+		"+ 1.25", "* 1.0001", "- 0.5", "/ 1.0001", "= ans * 0.5 + 1"
+	};
+	const size_t iLINE_COUNT = sizeof( sLINES ) / sizeof( sLINES[ 0 ] );
+	vector< chrono::steady_clock::time_point > vSent( iSessions );
+	char aBuffer[ CLIENT_READ_SIZE ];
+	string sInput;
+	string sOutput;
+	unsigned long long iSent = 0;
+	int iFile = connect_Server( sSocketPath );
+
+	oResult.iCompleted = 0;
+	oResult.iErrors = 0;
+	oResult.bFailed = iFile < 0;
+	oResult.vLatencies.reserve( (size_t) iRequests );
+
+	if( iFile < 0 )
+		return;
+
+	// Start one request on every session.
+	for( unsigned long long i = 0; i < iSessions && iSent < iRequests; ++i, ++iSent )
+	{
+		sOutput.append( to_string( iFirstSession + i ) ).append( 1, ' ' );
+		sOutput.append( sLINES[ iSent % iLINE_COUNT ] ).append( 1, '\n' );
+		vSent[ i ] = chrono::steady_clock::now( );
+	}
+
+	while( oResult.iCompleted < iRequests )
+	{
+		size_t iStart = 0;
+		size_t iEnd = 0;
+
+		if( !sOutput.empty( ) )
+		{
+			if( !send_All( iFile, sOutput.data( ), sOutput.size( ) ) )
+				break;
+
+			sOutput.clear( );
+		}
+
+		ssize_t iRead = recv( iFile, aBuffer, sizeof( aBuffer ), 0 );
+
+		if( iRead < 0 && errno == EINTR )
+			continue;
+
+		if( iRead <= 0 )
+			break;
+
+		sInput.append( aBuffer, (size_t) iRead );
+		chrono::steady_clock::time_point oNow = chrono::steady_clock::now( );
+
+		while( ( iEnd = sInput.find( '\n', iStart ) ) != string::npos )
+		{
+			unsigned long long iSession = strtoull( sInput.c_str( ) + iStart, NULL, 10 );
+			unsigned long long iIndex = iSession - iFirstSession;
+
+			if( iIndex < iSessions )
+			{
+				oResult.vLatencies.push_back( chrono::duration< double, micro >( oNow - vSent[ iIndex ] ).count( ) );
+
+				if( sInput.find( " error ", iStart ) < iEnd )
+					++oResult.iErrors;
+
+				if( iSent < iRequests )
+				{
+					sOutput.append( to_string( iSession ) ).append( 1, ' ' );
+					sOutput.append( sLINES[ iSent++ % iLINE_COUNT ] ).append( 1, '\n' );
+					vSent[ iIndex ] = oNow;
+				}
+			}
+			else
+				++oResult.iErrors;
+
+			++oResult.iCompleted;
+			iStart = iEnd + 1;
+		}
+
+		sInput.erase( 0, iStart );
+	}
+
+	oResult.bFailed = oResult.iCompleted < iRequests;
+	close( iFile );
+}
+
+// Returns the p'th percentile of sorted latencies.
+static double get_Percentile( const vector< double >& vSorted, double dPercentile )
+{
+	size_t iIndex = 0;
+
+	if( vSorted.empty( ) )
+		return 0.0;
+
+	iIndex = (size_t)( dPercentile / 100.0 * (double)( vSorted.size( ) - 1 ) + 0.5 );
+	return vSorted[ iIndex ];
+}
+
+// Drives the daemon with many sessions over several connections and prints
+// the throughput and latency percentiles.
+//	Parameters:
+//		oOptions : LoadOptions - Where to connect and how much load to send.
+//	Returns:
+//		0 if every request was answered without an error, 1 otherwise.
+//////////////////////////////////////////////////////////////////////
+int run_Load( const LoadOptions& oOptions )
+{
+	unsigned int iConnections = oOptions.iConnections > 0 ? oOptions.iConnections : 1;
+	vector< LoadResult > vResults( iConnections );
+	vector< thread > vThreads;
+	vector< double > vLatencies;
+	unsigned long long iSessionsEach = oOptions.iSessions / iConnections;
+	unsigned long long iCompleted = 0;
+	unsigned long long iErrors = 0;
+	bool bFailed = false;
+	double dSeconds = 0.0;
+
+	if( iSessionsEach == 0 )
+		iSessionsEach = 1;
+
+	chrono::steady_clock::time_point oStart = chrono::steady_clock::now( );
+
+	for( unsigned int c = 0; c < iConnections; ++c )
+	{
+		unsigned long long iRequests = oOptions.iRequests / iConnections +
+									   ( c < oOptions.iRequests % iConnections ? 1 : 0 );
+
+		vThreads.push_back( thread( run_Connection, oOptions.sSocketPath, 1 + c * iSessionsEach,
+									iSessionsEach, iRequests, ref( vResults[ c ] ) ) );
+	}
+
+	for( size_t c = 0; c < vThreads.size( ); ++c )
+		vThreads[ c ].join( );
+
+	dSeconds = chrono::duration< double >( chrono::steady_clock::now( ) - oStart ).count( );
+
+	for( size_t c = 0; c < vResults.size( ); ++c )
+	{
+		iCompleted += vResults[ c ].iCompleted;
+		iErrors += vResults[ c ].iErrors;
+		bFailed |= vResults[ c ].bFailed;
+		vLatencies.insert( vLatencies.end( ), vResults[ c ].vLatencies.begin( ), vResults[ c ].vLatencies.end( ) );
+	}
+
+	sort( vLatencies.begin( ), vLatencies.end( ) );
+
+	printf( "connections=%u sessions=%llu requests=%llu errors=%llu seconds=%.3f rate=%.0f/s "
+			"p50=%.1fus p99=%.1fus p99.9=%.1fus max=%.1fus\n",
+			iConnections, iSessionsEach * iConnections, iCompleted, iErrors, dSeconds,
+			dSeconds > 0.0 ? (double) iCompleted / dSeconds : 0.0,
+			get_Percentile( vLatencies, 50.0 ), get_Percentile( vLatencies, 99.0 ),
+			get_Percentile( vLatencies, 99.9 ), vLatencies.empty( ) ? 0.0 : vLatencies.back( ) );
+
+	if( bFailed )
+		fprintf( stderr, "Some connections failed before all of their requests were answered.\n" );
+
+	return bFailed || iErrors > 0 ? 1 : 0;
+}
+
+#else
+
+// The daemon is Linux only, so are its clients.
+int run_Client( const char* sSocketPath, unsigned long long iSession )
+{
+	(void) sSocketPath;
+	(void) iSession;
+	fprintf( stderr, "The daemon is only available on Linux.\n" );
+	return 1;
+}
+
+int run_Load( const LoadOptions& oOptions )
+{
+	(void) oOptions;
+	fprintf( stderr, "The daemon is only available on Linux.\n" );
+	return 1;
+}
+
+int run_Metrics_Query( const char* sSocketPath )
+{
+	(void) sSocketPath;
+	fprintf( stderr, "The daemon is only available on Linux.\n" );
+	return 1;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef _CALCCLIENT_H
+#define _CALCCLIENT_H
+
+// Name: CalcClient.h
+// Description: Clients for the calculator daemon: an interactive loopback
+//				client and a load generator.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+// Options for the load generator.
+struct LoadOptions
+{
+	const char* sSocketPath;			// Daemon socket to connect to
+	unsigned int iConnections;			// Connections, each on its own thread
+	unsigned long long iSessions;		// Sessions, spread over the connections
+	unsigned long long iRequests;		// Requests to send in total
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+int run_Client( const char* sSocketPath, unsigned long long iSession );
+int run_Load( const LoadOptions& oOptions );
+int run_Metrics_Query( const char* sSocketPath );
+
+#endif
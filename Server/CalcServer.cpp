@@ -0,0 +1,764 @@
+// Name: CalcServer.cpp
+// Description: Multi-session calculator daemon.  The I/O thread splits
+//				incoming data into requests and hands them to the worker
+//				owning each session in batches; workers hand back batches
+//				of responses and wake the I/O thread through an eventfd.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "CalcServer.h"
+#include <cstdio>
+
+#ifdef __linux__
+
+#include "Protocol.h"
+#include "../Calculator/Calculator.h"
+#include "../Metrics/Metrics.h"
+#include "../Parser/ExprCache.h"
+#include "../Parser/LineParser.h"
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define SERVER_READ_SIZE		65536	// Bytes read from a client per call
+#define SERVER_MAX_EVENTS		256		// Events taken per epoll_wait
+#define SERVER_BACKLOG			1024	// Pending connections on the listening socket
+
+// epoll tags for the daemon's own descriptors; connection IDs start above them.
+#define EVENT_LISTEN			0
+#define EVENT_WAKE				1
+#define EVENT_SIGNAL			2
+#define FIRST_CONNECTION_ID		16
+
+/*********************************************************************\
+ *	Work Batches													 *
+\*********************************************************************/
+
+// A request on its way to a worker.  The line lives in the batch text.
+struct Request
+{
+	unsigned long long iConnection;
+	unsigned long long iSession;
+	size_t iOffset;
+	size_t iLength;
+};
+
+struct RequestBatch
+{
+	vector< Request > vRequests;
+	string sText;
+};
+
+// A response on its way back to a connection.
+struct Response
+{
+	unsigned long long iConnection;
+	size_t iOffset;
+	size_t iLength;
+};
+
+struct ResponseBatch
+{
+	vector< Response > vResponses;
+	string sText;
+};
+
+// Moves everything in oFrom onto the end of oTo, leaving oFrom empty.
+static void append_Batch( RequestBatch& oTo, RequestBatch& oFrom )
+{
+	if( oTo.vRequests.empty( ) )
+		swap( oTo, oFrom );
+	else
+	{
+		size_t iBase = oTo.sText.size( );
+
+		oTo.sText.append( oFrom.sText );
+
+		for( size_t i = 0; i < oFrom.vRequests.size( ); ++i )
+		{
+			oTo.vRequests.push_back( oFrom.vRequests[ i ] );
+			oTo.vRequests.back( ).iOffset += iBase;
+		}
+	}
+
+	oFrom.vRequests.clear( );
+	oFrom.sText.clear( );
+}
+
+static void append_Batch( ResponseBatch& oTo, ResponseBatch& oFrom )
+{
+	if( oTo.vResponses.empty( ) )
+		swap( oTo, oFrom );
+	else
+	{
+		size_t iBase = oTo.sText.size( );
+
+		oTo.sText.append( oFrom.sText );
+
+		for( size_t i = 0; i < oFrom.vResponses.size( ); ++i )
+		{
+			oTo.vResponses.push_back( oFrom.vResponses[ i ] );
+			oTo.vResponses.back( ).iOffset += iBase;
+		}
+	}
+
+	oFrom.vResponses.clear( );
+	oFrom.sText.clear( );
+}
+
+/*********************************************************************\
+ *	Session Worker													 *
+\*********************************************************************/
+
+// Owns a shard of the sessions and runs every request for them.
+class SessionWorker
+{
+public:
+	SessionWorker( size_t iCacheBudget, int iWakeFile );
+	~SessionWorker( );
+
+	void submit( RequestBatch& oBatch );
+	void collect( ResponseBatch& oBatch );
+
+private:
+	void run( );
+	void process( const Request& oRequest, const char* sLine, ResponseBatch& oOut );
+
+	// Only touched by the worker thread.
+	unordered_map< unsigned long long, Calculator > m_mSessions;
+	ExprCache m_oCache;
+
+	// Shared with the I/O thread.
+	mutex m_oLock;
+	condition_variable m_oWake;
+	RequestBatch m_oInbox;
+	ResponseBatch m_oOutbox;
+	bool m_bStop;
+	int m_iWakeFile;
+	thread m_oThread;
+};
+
+SessionWorker::SessionWorker( size_t iCacheBudget, int iWakeFile )
+	: m_oCache( iCacheBudget )
+{
+	m_bStop = false;
+	m_iWakeFile = iWakeFile;
+	m_oThread = thread( &SessionWorker::run, this );
+}
+
+SessionWorker::~SessionWorker( )
+{
+	{
+		lock_guard< mutex > oLock( m_oLock );
+		m_bStop = true;
+	}
+
+	m_oWake.notify_one( );
+	m_oThread.join( );
+}
+
+// Queues a batch of requests for this worker.  oBatch is left empty.
+void SessionWorker::submit( RequestBatch& oBatch )
+{
+	{
+		lock_guard< mutex > oLock( m_oLock );
+		append_Batch( m_oInbox, oBatch );
+	}
+
+	m_oWake.notify_one( );
+}
+
+// Takes every response the worker has finished.  oBatch must be empty.
+void SessionWorker::collect( ResponseBatch& oBatch )
+{
+	lock_guard< mutex > oLock( m_oLock );
+
+	swap( oBatch, m_oOutbox );
+}
+
+// Worker thread: takes the whole inbox at once, answers it, and posts the
+// answers back in one go.
+void SessionWorker::run( )
+{
+	RequestBatch oWork;
+	ResponseBatch oDone;
+	unsigned long long iWake = 1;
+
+	while( true )
+	{
+		{
+			unique_lock< mutex > oLock( m_oLock );
+
+			m_oWake.wait( oLock, [ this ] { return m_bStop || !m_oInbox.vRequests.empty( ); } );
+
+			if( m_oInbox.vRequests.empty( ) )
+				break;
+
+			swap( oWork, m_oInbox );
+		}
+
+		for( size_t i = 0; i < oWork.vRequests.size( ); ++i )
+			process( oWork.vRequests[ i ], oWork.sText.data( ) + oWork.vRequests[ i ].iOffset, oDone );
+
+		oWork.vRequests.clear( );
+		oWork.sText.clear( );
+
+		{
+			lock_guard< mutex > oLock( m_oLock );
+			append_Batch( m_oOutbox, oDone );
+		}
+
+		if( write( m_iWakeFile, &iWake, sizeof( iWake ) ) < 0 && errno != EAGAIN )
+			perror( "eventfd" );
+	}
+}
+
+// Applies one request to its session and writes the answer.
+void SessionWorker::process( const Request& oRequest, const char* sLine, ResponseBatch& oOut )
+{
+	Calculator& oCalculator = m_mSessions[ oRequest.iSession ];
+	Response oResponse = { oRequest.iConnection, oOut.sText.size( ), 0 };
+	Operation oOperation;
+	CompileError oError;
+	const Program* pProgram = NULL;
+	char sSession[ 24 ];
+
+	switch( parse_Line( sLine, oRequest.iLength, &oCalculator, oOperation ) )
+	{
+	case LINE_OPERATION:
+		oCalculator.apply_Operation( oOperation );
+		append_Value( oOut.sText, oRequest.iSession, oCalculator.read_Value( ) );
+		break;
+	case LINE_QUIT:
+		m_mSessions.erase( oRequest.iSession );
+		snprintf( sSession, sizeof( sSession ), "%llu", oRequest.iSession );
+		oOut.sText.append( sSession ).append( " closed\n" );
+		break;
+	case LINE_INVALID:
+		pProgram = m_oCache.compile( sLine, oRequest.iLength, &oCalculator, oError );
+
+		if( pProgram == NULL )
+		{
+			METRIC_COUNT_FAILURE( METRIC_SOURCE_SERVER, oError.sMessage );
+			snprintf( sSession, sizeof( sSession ), "%llu", oRequest.iSession );
+			append_Error( oOut.sText, sSession, oError.iPosition + 1, oError.sMessage );
+			break;
+		}
+
+		oCalculator.execute_Program( *pProgram );
+		append_Value( oOut.sText, oRequest.iSession, oCalculator.read_Value( ) );
+		break;
+	case LINE_BLANK:
+	default:
+		append_Value( oOut.sText, oRequest.iSession, oCalculator.read_Value( ) );
+		break;
+	}
+
+	oResponse.iLength = oOut.sText.size( ) - oResponse.iOffset;
+	oOut.vResponses.push_back( oResponse );
+}
+
+/*********************************************************************\
+ *	Connections														 *
+\*********************************************************************/
+
+// A client connection, owned by the I/O thread.
+struct Connection
+{
+	int iFile;
+	string sInput;					// Bytes read but not yet split into requests
+	string sOutput;					// Responses not yet sent
+	size_t iOutputOffset;			// How much of sOutput has been sent
+	unsigned long long iInFlight;	// Requests handed to workers and not answered
+	unsigned int iEvents;			// Events registered with epoll
+	bool bReadClosed;				// Client is done sending
+	bool bTouched;					// Has new output this round
+};
+
+// State of the I/O thread.
+struct ServerState
+{
+	int iPoll;
+	int iListen;
+	int iWake;
+	int iSignal;
+	unsigned long long iNextConnection;
+	unordered_map< unsigned long long, Connection > mConnections;
+	vector< unique_ptr< SessionWorker > > vWorkers;
+	vector< RequestBatch > vStaging;	// Requests read this round, per worker
+	vector< unsigned long long > vTouched;
+	ResponseBatch oResponses;
+};
+
+// Returns the worker that owns a session.
+static inline size_t get_Worker( const ServerState& oState, unsigned long long iSession )
+{
+	return (size_t)( iSession % oState.vWorkers.size( ) );
+}
+
+static void touch( ServerState& oState, unsigned long long iConnection, Connection& oConnection )
+{
+	if( !oConnection.bTouched )
+	{
+		oConnection.bTouched = true;
+		oState.vTouched.push_back( iConnection );
+	}
+}
+
+static void close_Connection( ServerState& oState, unsigned long long iConnection )
+{
+	unordered_map< unsigned long long, Connection >::iterator it = oState.mConnections.find( iConnection );
+
+	if( it == oState.mConnections.end( ) )
+		return;
+
+	epoll_ctl( oState.iPoll, EPOLL_CTL_DEL, it->second.iFile, NULL );
+	close( it->second.iFile );
+	oState.mConnections.erase( it );
+}
+
+// Sends as much pending output as the socket takes.
+//	Returns:
+//		False if the connection failed.
+//////////////////////////////////////////////////////////////////////
+static bool flush_Output( Connection& oConnection )
+{
+	while( oConnection.iOutputOffset < oConnection.sOutput.size( ) )
+	{
+		ssize_t iSent = send( oConnection.iFile, oConnection.sOutput.data( ) + oConnection.iOutputOffset,
+							  oConnection.sOutput.size( ) - oConnection.iOutputOffset,
+							  MSG_NOSIGNAL | MSG_DONTWAIT );
+
+		if( iSent < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+
+		oConnection.iOutputOffset += (size_t) iSent;
+	}
+
+	oConnection.sOutput.clear( );
+	oConnection.iOutputOffset = 0;
+	return true;
+}
+
+// Flushes a connection, then either closes it (when the client is done and
+// every answer is out) or updates what epoll watches for.  A client with
+// too much unsent output isn't read from until it catches up.
+static void update_Connection( ServerState& oState, unsigned long long iConnection )
+{
+	unordered_map< unsigned long long, Connection >::iterator it = oState.mConnections.find( iConnection );
+	unsigned int iEvents = 0;
+
+	if( it == oState.mConnections.end( ) )
+		return;
+
+	Connection& oConnection = it->second;
+
+	oConnection.bTouched = false;
+
+	if( !flush_Output( oConnection ) )
+	{
+		close_Connection( oState, iConnection );
+		return;
+	}
+
+	if( oConnection.bReadClosed && oConnection.iInFlight == 0 && oConnection.sOutput.empty( ) )
+	{
+		close_Connection( oState, iConnection );
+		return;
+	}
+
+	if( !oConnection.bReadClosed && oConnection.sOutput.size( ) < SERVER_MAX_PENDING_OUTPUT )
+		iEvents |= EPOLLIN;
+
+	if( !oConnection.sOutput.empty( ) )
+		iEvents |= EPOLLOUT;
+
+	if( iEvents != oConnection.iEvents )
+	{
+		epoll_event oEvent;
+
+		oEvent.events = iEvents;
+		oEvent.data.u64 = iConnection;
+		epoll_ctl( oState.iPoll, EPOLL_CTL_MOD, oConnection.iFile, &oEvent );
+		oConnection.iEvents = iEvents;
+	}
+}
+
+// Splits the complete lines a connection has sent into requests for the
+// workers.  Lines without a session ID are answered here.
+static void split_Requests( ServerState& oState, unsigned long long iConnection, Connection& oConnection )
+{
+	size_t iStart = 0;
+	size_t iEnd = 0;
+
+	while( ( iEnd = oConnection.sInput.find( '\n', iStart ) ) != string::npos )
+	{
+		const char* sLine = oConnection.sInput.data( ) + iStart;
+		size_t iLength = iEnd - iStart;
+		const char* sBody = NULL;
+		size_t iBodyLength = 0;
+		unsigned long long iSession = 0;
+
+		if( iLength > 0 && sLine[ iLength - 1 ] == '\r' )
+			--iLength;
+
+		if( iLength == sizeof( PROTOCOL_METRICS_QUERY ) - 1 &&
+			!memcmp( sLine, PROTOCOL_METRICS_QUERY, iLength ) )
+		{
+			append_Metrics( oConnection.sOutput );
+			oConnection.sOutput.append( PROTOCOL_METRICS_END );
+			touch( oState, iConnection, oConnection );
+		}
+		else if( parse_Request( sLine, iLength, iSession, sBody, iBodyLength ) )
+		{
+			RequestBatch& oBatch = oState.vStaging[ get_Worker( oState, iSession ) ];
+			Request oRequest = { iConnection, iSession, oBatch.sText.size( ), iBodyLength };
+
+			// Lines are null terminated like the ones BufferedReader hands out.
+			oBatch.sText.append( sBody, iBodyLength ).push_back( '\0' );
+			oBatch.vRequests.push_back( oRequest );
+			++oConnection.iInFlight;
+		}
+		else
+		{
+			append_Error( oConnection.sOutput, PROTOCOL_NO_SESSION, 1, "missing session ID" );
+			touch( oState, iConnection, oConnection );
+		}
+
+		iStart = iEnd + 1;
+	}
+
+	oConnection.sInput.erase( 0, iStart );
+
+	if( oConnection.sInput.size( ) >= PROTOCOL_MAX_LINE )
+	{
+		append_Error( oConnection.sOutput, PROTOCOL_NO_SESSION, PROTOCOL_MAX_LINE, "line too long" );
+		oConnection.sInput.clear( );
+		oConnection.bReadClosed = true;
+		touch( oState, iConnection, oConnection );
+	}
+}
+
+// Reads everything a connection has sent.
+static void read_Connection( ServerState& oState, unsigned long long iConnection )
+{
+	unordered_map< unsigned long long, Connection >::iterator it = oState.mConnections.find( iConnection );
+	char aBuffer[ SERVER_READ_SIZE ];
+
+	if( it == oState.mConnections.end( ) )
+		return;
+
+	Connection& oConnection = it->second;
+
+	while( !oConnection.bReadClosed )
+	{
+		ssize_t iRead = recv( oConnection.iFile, aBuffer, sizeof( aBuffer ), 0 );
+
+		if( iRead > 0 )
+		{
+			oConnection.sInput.append( aBuffer, (size_t) iRead );
+			split_Requests( oState, iConnection, oConnection );
+
+			if( (size_t) iRead < sizeof( aBuffer ) )
+				break;
+		}
+		else if( iRead == 0 )
+		{
+			oConnection.bReadClosed = true;
+			touch( oState, iConnection, oConnection );
+		}
+		else if( errno == EINTR )
+			continue;
+		else if( errno == EAGAIN || errno == EWOULDBLOCK )
+			break;
+		else
+		{
+			close_Connection( oState, iConnection );
+			return;
+		}
+	}
+}
+
+// Accepts every pending connection.
+static void accept_Connections( ServerState& oState )
+{
+	while( true )
+	{
+		int iFile = accept4( oState.iListen, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC );
+		epoll_event oEvent;
+
+		if( iFile < 0 )
+		{
+			if( errno == EINTR || errno == ECONNABORTED )
+				continue;
+
+			if( errno != EAGAIN && errno != EWOULDBLOCK )
+				perror( "accept" );
+
+			return;
+		}
+
+		Connection& oConnection = oState.mConnections[ oState.iNextConnection ];
+
+		oConnection.iFile = iFile;
+		oConnection.iOutputOffset = 0;
+		oConnection.iInFlight = 0;
+		oConnection.iEvents = EPOLLIN;
+		oConnection.bReadClosed = false;
+		oConnection.bTouched = false;
+
+		oEvent.events = EPOLLIN;
+		oEvent.data.u64 = oState.iNextConnection++;
+
+		if( epoll_ctl( oState.iPoll, EPOLL_CTL_ADD, iFile, &oEvent ) < 0 )
+		{
+			perror( "epoll_ctl" );
+			close_Connection( oState, oEvent.data.u64 );
+		}
+	}
+}
+
+// Routes finished responses from every worker to their connections.
+static void collect_Responses( ServerState& oState )
+{
+	unsigned long long iCount = 0;
+
+	while( read( oState.iWake, &iCount, sizeof( iCount ) ) < 0 && errno == EINTR )
+		;
+
+	for( size_t w = 0; w < oState.vWorkers.size( ); ++w )
+	{
+		ResponseBatch& oBatch = oState.oResponses;
+
+		oState.vWorkers[ w ]->collect( oBatch );
+
+		for( size_t i = 0; i < oBatch.vResponses.size( ); ++i )
+		{
+			const Response& oResponse = oBatch.vResponses[ i ];
+			unordered_map< unsigned long long, Connection >::iterator it = oState.mConnections.find( oResponse.iConnection );
+
+			// The client may have gone away in the meantime.
+			if( it == oState.mConnections.end( ) )
+				continue;
+
+			it->second.sOutput.append( oBatch.sText, oResponse.iOffset, oResponse.iLength );
+			--it->second.iInFlight;
+			touch( oState, oResponse.iConnection, it->second );
+		}
+
+		oBatch.vResponses.clear( );
+		oBatch.sText.clear( );
+	}
+}
+
+// Opens the listening socket, refusing to take over a path that another
+// daemon is still serving.
+//	Returns:
+//		The socket, or -1 on failure.
+//////////////////////////////////////////////////////////////////////
+static int open_Listener( const char* sPath )
+{
+	sockaddr_un oAddress;
+	int iFile = -1;
+
+	memset( &oAddress, 0, sizeof( oAddress ) );
+	oAddress.sun_family = AF_UNIX;
+
+	if( strlen( sPath ) >= sizeof( oAddress.sun_path ) )
+	{
+		fprintf( stderr, "Socket path \"%s\" is too long.\n", sPath );
+		return -1;
+	}
+
+	strcpy( oAddress.sun_path, sPath );
+
+	// A stale socket file from a daemon that died is removed; a live one is not.
+	iFile = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+
+	if( iFile >= 0 && connect( iFile, (sockaddr*) &oAddress, sizeof( oAddress ) ) == 0 )
+	{
+		close( iFile );
+		fprintf( stderr, "A daemon is already listening on \"%s\".\n", sPath );
+		return -1;
+	}
+
+	if( iFile >= 0 )
+		close( iFile );
+
+	unlink( sPath );
+	iFile = socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+
+	if( iFile < 0 || bind( iFile, (sockaddr*) &oAddress, sizeof( oAddress ) ) < 0 ||
+		listen( iFile, SERVER_BACKLOG ) < 0 )
+	{
+		perror( sPath );
+
+		if( iFile >= 0 )
+			close( iFile );
+
+		return -1;
+	}
+
+	return iFile;
+}
+
+// Registers one of the daemon's own descriptors with epoll.
+static bool watch( int iPoll, int iFile, unsigned long long iTag )
+{
+	epoll_event oEvent;
+
+	oEvent.events = EPOLLIN;
+	oEvent.data.u64 = iTag;
+
+	return epoll_ctl( iPoll, EPOLL_CTL_ADD, iFile, &oEvent ) == 0;
+}
+
+// Runs the daemon until SIGINT or SIGTERM.
+//	Parameters:
+//		oOptions : ServerOptions - Where to listen and how many workers to run.
+//	Returns:
+//		0 after a clean shutdown, 1 if the daemon could not start.
+//////////////////////////////////////////////////////////////////////
+int run_Server( const ServerOptions& oOptions )
+{
+	ServerState oState;
+	epoll_event aEvents[ SERVER_MAX_EVENTS ];
+	unsigned int iWorkerCount = oOptions.iWorkerCount;
+	sigset_t oSignals;
+	bool bRunning = true;
+
+	// Workers inherit the blocked signals, so only the signalfd sees them.
+	sigemptyset( &oSignals );
+	sigaddset( &oSignals, SIGINT );
+	sigaddset( &oSignals, SIGTERM );
+	pthread_sigmask( SIG_BLOCK, &oSignals, NULL );
+	signal( SIGPIPE, SIG_IGN );
+
+	oState.iPoll = epoll_create1( EPOLL_CLOEXEC );
+	oState.iWake = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+	oState.iSignal = signalfd( -1, &oSignals, SFD_NONBLOCK | SFD_CLOEXEC );
+	oState.iListen = open_Listener( oOptions.sSocketPath );
+	oState.iNextConnection = FIRST_CONNECTION_ID;
+
+	if( oState.iPoll < 0 || oState.iWake < 0 || oState.iSignal < 0 || oState.iListen < 0 ||
+		!watch( oState.iPoll, oState.iListen, EVENT_LISTEN ) ||
+		!watch( oState.iPoll, oState.iWake, EVENT_WAKE ) ||
+		!watch( oState.iPoll, oState.iSignal, EVENT_SIGNAL ) )
+	{
+		fprintf( stderr, "Unable to start the daemon.\n" );
+		return 1;
+	}
+
+	if( iWorkerCount == 0 )
+		iWorkerCount = thread::hardware_concurrency( );
+
+	if( iWorkerCount == 0 )
+		iWorkerCount = 1;
+
+	for( unsigned int i = 0; i < iWorkerCount; ++i )
+		oState.vWorkers.push_back( unique_ptr< SessionWorker >( new SessionWorker( oOptions.iCacheBudget, oState.iWake ) ) );
+
+	oState.vStaging.resize( iWorkerCount );
+	fprintf( stderr, "Listening on \"%s\" with %u workers.\n", oOptions.sSocketPath, iWorkerCount );
+
+	while( bRunning )
+	{
+		int iCount = epoll_wait( oState.iPoll, aEvents, SERVER_MAX_EVENTS, -1 );
+
+		if( iCount < 0 && errno != EINTR )
+		{
+			perror( "epoll_wait" );
+			break;
+		}
+
+		for( int i = 0; i < iCount; ++i )
+		{
+			unsigned long long iTag = aEvents[ i ].data.u64;
+
+			if( iTag == EVENT_LISTEN )
+				accept_Connections( oState );
+			else if( iTag == EVENT_WAKE )
+				collect_Responses( oState );
+			else if( iTag == EVENT_SIGNAL )
+				bRunning = false;
+			else if( aEvents[ i ].events & ( EPOLLHUP | EPOLLERR ) )
+			{
+				// Nothing can be sent back any more.
+				close_Connection( oState, iTag );
+			}
+			else
+			{
+				if( aEvents[ i ].events & EPOLLIN )
+					read_Connection( oState, iTag );
+
+				unordered_map< unsigned long long, Connection >::iterator it = oState.mConnections.find( iTag );
+
+				if( it != oState.mConnections.end( ) )
+					touch( oState, iTag, it->second );
+			}
+		}
+
+		// Hand this round's requests over, one batch per worker.
+		for( size_t w = 0; w < oState.vStaging.size( ); ++w )
+			if( !oState.vStaging[ w ].vRequests.empty( ) )
+				oState.vWorkers[ w ]->submit( oState.vStaging[ w ] );
+
+		for( size_t i = 0; i < oState.vTouched.size( ); ++i )
+			update_Connection( oState, oState.vTouched[ i ] );
+
+		oState.vTouched.clear( );
+	}
+
+	fprintf( stderr, "Shutting down.\n" );
+	oState.vWorkers.clear( );
+
+	while( !oState.mConnections.empty( ) )
+		close_Connection( oState, oState.mConnections.begin( )->first );
+
+	close( oState.iListen );
+	unlink( oOptions.sSocketPath );
+	close( oState.iSignal );
+	close( oState.iWake );
+	close( oState.iPoll );
+
+	return 0;
+}
+
+#else
+
+// epoll, eventfd and signalfd are Linux only.
+int run_Server( const ServerOptions& oOptions )
+{
+	(void) oOptions;
+	fprintf( stderr, "The daemon is only available on Linux.\n" );
+	return 1;
+}
+
+#endif
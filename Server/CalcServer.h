@@ -0,0 +1,39 @@
+#ifndef _CALCSERVER_H
+#define _CALCSERVER_H
+
+// Name: CalcServer.h
+// Description: Daemon mode.  Serves many calculator sessions to local
+//				clients over a Unix domain socket, see Protocol.h.
+//
+//				One thread runs an epoll loop over the listening socket
+//				and every connection.  Sessions are sharded across a fixed
+//				pool of workers by session ID, so a session's Calculator
+//				is only ever touched by the worker that owns it and needs
+//				no locking.  Linux only.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstddef>
+
+/////////////
+// Defines //
+/////////////
+#define SERVER_MAX_PENDING_OUTPUT	( 4 << 20 )	// Stop reading a client with this much unsent
+
+// Options for the daemon.
+struct ServerOptions
+{
+	const char* sSocketPath;	// Path of the Unix domain socket to listen on
+	unsigned int iWorkerCount;	// Worker threads, 0 for one per core
+	size_t iCacheBudget;		// Expression cache budget per worker, in bytes
+};
+
+///////////////////////////
+// Function Declarations //
+///////////////////////////
+int run_Server( const ServerOptions& oOptions );
+
+#endif
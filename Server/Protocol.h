@@ -0,0 +1,103 @@
+#ifndef _PROTOCOL_H
+#define _PROTOCOL_H
+
+// Name: Protocol.h
+// Description: Line protocol spoken over the daemon's Unix domain socket.
+//
+//				Request:	<session> <line>\n
+//				Response:	<session> ok <working value>\n
+//							<session> error <column> <message>\n
+//							<session> closed\n
+//
+//				<session> is any unsigned 64 bit number picked by the
+//				client; the daemon creates a session the first time it
+//				sees one.  <line> is a batch script line: an operation,
+//				an expression, "s", "r", or "q" to end the session.  An
+//				empty line just reads the working value.
+//
+//				Requests for one session are answered in order.  A
+//				connection may mix sessions, and answers for different
+//				sessions may come back in any order.
+//
+//				Query:		metrics\n
+//				Response:	the daemon's metrics, see Metrics.h, then
+//							# end\n
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+/////////////
+// Defines //
+/////////////
+#define PROTOCOL_MAX_LINE		4096	// Longest request line, newline included
+#define PROTOCOL_MAX_RESPONSE	128		// Longest response line
+#define PROTOCOL_NO_SESSION		"-"		// Session field for unparseable requests
+#define PROTOCOL_METRICS_QUERY	"metrics"
+#define PROTOCOL_METRICS_END	"# end\n"
+
+// Splits a request into its session ID and the line for the calculator.
+//	Returns:
+//		False if the line does not start with a session ID.
+//////////////////////////////////////////////////////////////////////
+inline bool parse_Request( const char* sLine, size_t iLength, unsigned long long& iSession,
+						   const char*& sBody, size_t& iBodyLength )
+{
+	size_t i = 0;
+
+	iSession = 0;
+
+	while( i < iLength && sLine[ i ] >= '0' && sLine[ i ] <= '9' )
+	{
+		if( iSession > ( ~0ULL - 9 ) / 10 )
+			return false;
+
+		iSession = iSession * 10 + (unsigned long long)( sLine[ i++ ] - '0' );
+	}
+
+	if( i == 0 || ( i < iLength && sLine[ i ] != ' ' && sLine[ i ] != '\t' ) )
+		return false;
+
+	if( i < iLength )
+		++i;
+
+	sBody = sLine + i;
+	iBodyLength = iLength - i;
+	return true;
+}
+
+// Appends the response for a successful request.
+inline void append_Value( std::string& sOut, unsigned long long iSession, double dValue )
+{
+	char sResponse[ PROTOCOL_MAX_RESPONSE ];
+	int iLength = snprintf( sResponse, sizeof( sResponse ), "%llu ok %.17g\n", iSession, dValue );
+
+	sOut.append( sResponse, (size_t) iLength );
+}
+
+// Appends the response for a request that failed to compile.
+inline void append_Error( std::string& sOut, const char* sSession, size_t iColumn, const char* sMessage )
+{
+	char sResponse[ PROTOCOL_MAX_RESPONSE ];
+	int iLength = snprintf( sResponse, sizeof( sResponse ), "%s error %llu %s\n",
+							sSession, (unsigned long long) iColumn, sMessage );
+
+	if( iLength < 0 )
+		return;
+
+	// Cut overlong messages, keeping the newline.
+	if( iLength >= (int) sizeof( sResponse ) )
+	{
+		iLength = (int) sizeof( sResponse ) - 1;
+		sResponse[ iLength - 1 ] = '\n';
+	}
+
+	sOut.append( sResponse, (size_t) iLength );
+}
+
+#endif
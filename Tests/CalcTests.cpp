@@ -0,0 +1,874 @@
+// Name: CalcTests.cpp
+// Description: Regression tests for the calculator, one named test per
+//				mode or feature.
+//
+//				Usage: CalcTests [test]
+//
+//				Runs every test, or only the one named.  Each failed check
+//				is printed with where it is, and the exit status is 1 if
+//				any check failed.
+// Written By: James Coté
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////
+// Includes //
+//////////////
+#include "../Calculator/Calculator.h"
+#include "../Calculator/DecimalCalculator.h"
+#include "../Calculator/IntegerCalculator.h"
+#include "../Calculator/Optimizer.h"
+#include "../Calculator/ProgramJit.h"
+#include "../Batch/BatchRunner.h"
+#include "../Batch/DecimalRunner.h"
+#include "../Batch/IntegerRunner.h"
+#include "../IO/Journal.h"
+#include "../Parser/ExprCache.h"
+#include "../Parser/ExprCompiler.h"
+#include "../Parser/NumberParser.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+////////////////
+// Namespaces //
+////////////////
+using namespace std;
+
+/////////////
+// Defines //
+/////////////
+#define CHECK( bCondition )		check( ( bCondition ), #bCondition, __FILE__, __LINE__ )
+#define TEST_SEED				88172645463325252ULL
+#define PARALLEL_TEST_LINES		70000		// Enough for the scan to run in parallel
+#define OPTIMIZER_STREAMS		4000		// Random operation streams the optimizer is checked on
+#define OPTIMIZER_MAX_LENGTH	12			// Longest of those streams
+#define JOURNAL_TEST_RECORDS	100
+#define PIPELINE_TEST_LINES		20000
+
+/*********************************************************************\
+ *	Test Harness													 *
+\*********************************************************************/
+
+static unsigned long long iChecks = 0;
+static unsigned long long iFailures = 0;
+
+// Counts a check, printing it if it failed.
+static void check( bool bPassed, const char* sCondition, const char* sFile, int iLine )
+{
+	++iChecks;
+
+	if( !bPassed )
+	{
+		++iFailures;
+		fprintf( stderr, "%s:%d: check failed: %s\n", sFile, iLine, sCondition );
+	}
+}
+
+// A named test.
+struct Test
+{
+	const char* sName;
+	void ( *fRun )( );
+};
+
+// Returns true if two doubles have the same bits, so NaN payloads and
+// signed zeros count.
+static bool same_Bits( double dFirst, double dSecond )
+{
+	return memcmp( &dFirst, &dSecond, sizeof( double ) ) == 0;
+}
+
+// Makes a double from its bits.
+static double from_Bits( unsigned long long iBits )
+{
+	double dValue = 0.0;
+
+	memcpy( &dValue, &iBits, sizeof( double ) );
+	return dValue;
+}
+
+// xorshift64, so every run sees the same random cases.
+static unsigned long long next_Random( unsigned long long& iState )
+{
+	iState ^= iState << 13;
+	iState ^= iState >> 7;
+	iState ^= iState << 17;
+	return iState;
+}
+
+// Returns a path in the temp directory.
+static string get_Temp_Path( const char* sName )
+{
+	return ( filesystem::temp_directory_path( ) / sName ).string( );
+}
+
+// Writes a script to a temp file, runs it with fRun, printing to a
+// temporary file, and returns what was printed.
+//	Parameters:
+//		sScript : String - The script's text.
+//		oOptions : BatchOptions - Options for the run; the script path and
+//								  output are filled in here.
+//		fRun : function - Runs the batch, returning its exit status.
+//		iResult : int - Receives the exit status.
+//	Returns:
+//		Everything the run printed.
+//////////////////////////////////////////////////////////////////////////////
+static string run_Script( const string& sScript, BatchOptions oOptions,
+						  const function< int( const BatchOptions& ) >& fRun, int& iResult )
+{
+	string sPath = get_Temp_Path( "calctests_script.txt" );
+	FILE* pScript = fopen( sPath.c_str( ), "wb" );
+	FILE* pOutput = tmpfile( );
+	string sOutput;
+	char aBuffer[ 4096 ];
+	size_t iRead = 0;
+
+	iResult = -1;
+
+	if( pScript == NULL || pOutput == NULL )
+	{
+		fprintf( stderr, "Unable to write the test script to %s.\n", sPath.c_str( ) );
+		CHECK( pScript != NULL && pOutput != NULL );
+
+		if( pScript != NULL )
+			fclose( pScript );
+
+		if( pOutput != NULL )
+			fclose( pOutput );
+
+		return sOutput;
+	}
+
+	fwrite( sScript.data( ), 1, sScript.size( ), pScript );
+	fclose( pScript );
+
+	oOptions.sScriptPath = sPath.c_str( );
+	oOptions.pOutput = pOutput;
+	iResult = fRun( oOptions );
+
+	rewind( pOutput );
+
+	while( ( iRead = fread( aBuffer, 1, sizeof( aBuffer ), pOutput ) ) > 0 )
+		sOutput.append( aBuffer, iRead );
+
+	fclose( pOutput );
+	remove( sPath.c_str( ) );
+	return sOutput;
+}
+
+// Runs a script through the double calculator.
+static string run_Double( const string& sScript, const BatchOptions& oOptions,
+						  Calculator* const m_Calculator, int& iResult )
+{
+	return run_Script( sScript, oOptions, [ m_Calculator ]( const BatchOptions& oRun )
+		{
+			return run_Batch( oRun, m_Calculator );
+		}, iResult );
+}
+
+/*********************************************************************\
+ *	Tests															 *
+\*********************************************************************/
+
+// Known results of plain lines and expressions in the double calculator.
+static void test_Double( )
+{
+	Calculator oCalculator;
+	BatchOptions oOptions;
+	int iResult = 0;
+
+	CHECK( run_Double( "+ 0.1\n+ 0.2\n= (2 + 3) * 4 - 1\ns x\n/ x * 2\n", oOptions, &oCalculator, iResult ) ==
+		   "0.10000000000000001\n0.30000000000000004\n19\n19\n0.5\n" );
+	CHECK( iResult == 0 );
+
+	oOptions.bFinalOnly = true;
+	CHECK( run_Double( "+ 1\ns\n* 3\n- mem\n/ 4\n", oOptions, &oCalculator, iResult ) == "0.75\n" );
+	CHECK( iResult == 0 );
+
+	// A bad line is reported and skipped, and fails the run.
+	CHECK( run_Double( "r\n+ 2\n+ (\n* 3\n", oOptions, &oCalculator, iResult ) == "6\n" );
+	CHECK( iResult == 1 );
+}
+
+// The parallel scan gives the serial results bit for bit after lines that
+// scale by zero or infinity: a NaN stays a NaN and a zero keeps its sign.
+static void test_Parallel( )
+{
+	static const char* const aCases[][ 2 ] =
+	{
+		// Line before, line repeated after
+		{ "+ 1e308\n* 10\n* 0\n", "+ 1\n" },
+		{ "- 5\n* 0\n", "* 1\n" },
+		{ "- 5\n/ inf\n", "* 3\n/ 3\n" },
+		{ "+ 2\n/ 0\n* 0\n", "- 1\n" },
+		{ "- 1e-300\n* 1e-300\n", "+ 0\n- 0\n" }
+	};
+
+	for( size_t i = 0; i < sizeof( aCases ) / sizeof( aCases[ 0 ] ); ++i )
+	{
+		string sScript = aCases[ i ][ 0 ];
+
+		for( size_t iLine = 0; iLine < PARALLEL_TEST_LINES; ++iLine )
+			sScript += aCases[ i ][ 1 ];
+
+		for( int iFinalOnly = 0; iFinalOnly < 2; ++iFinalOnly )
+		{
+			Calculator oSerial;
+			Calculator oParallel;
+			BatchOptions oOptions;
+			int iResult = 0;
+
+			oOptions.bFinalOnly = iFinalOnly != 0;
+			string sSerial = run_Double( sScript, oOptions, &oSerial, iResult );
+
+			oOptions.bParallel = true;
+			oOptions.iThreadCount = 4;
+			CHECK( run_Double( sScript, oOptions, &oParallel, iResult ) == sSerial );
+			CHECK( same_Bits( oParallel.read_Value( ), oSerial.read_Value( ) ) );
+		}
+	}
+}
+
+// A line compiled for another calculator replaces a pinned entry without
+// freeing it, and every entry the cache drops counts as an eviction.
+static void test_Cache( )
+{
+	ExprCache oCache;
+	Calculator oFirst;
+	Calculator oSecond;
+	CompileError oError;
+	const char* sLine = "+ x * 2";
+
+	oFirst.set_Var( oFirst.intern_Variable( "x", 1 ), 3.0 );
+	oSecond.set_Var( oSecond.intern_Variable( "x", 1 ), 5.0 );
+
+	const Program* pPinned = oCache.compile( sLine, strlen( sLine ), &oFirst, oError );
+	int iPin = oCache.pin_Last( );
+	vector< unsigned char > vCode = pPinned->vCode;
+
+	// The pinned program keeps its code while the other calculator's line
+	// takes its place, and is only evicted once it is unpinned.
+	const Program* pSecond = oCache.compile( sLine, strlen( sLine ), &oSecond, oError );
+
+	CHECK( pSecond != NULL && pSecond != pPinned );
+	CHECK( pPinned->vCode == vCode && oFirst.evaluate_Program( *pPinned ) == 6.0 );
+	CHECK( oSecond.evaluate_Program( *pSecond ) == 10.0 );
+	CHECK( oCache.get_Stats( ).iEvictions == 0 && oCache.get_Stats( ).iEntries == 2 );
+
+	oCache.unpin( iPin );
+	CHECK( oCache.get_Stats( ).iEvictions == 1 && oCache.get_Stats( ).iEntries == 1 );
+	CHECK( oCache.compile( sLine, strlen( sLine ), &oSecond, oError ) == pSecond );
+	CHECK( oCache.get_Stats( ).iHits == 1 );
+
+	// An unpinned entry from the other calculator is evicted straight away.
+	CHECK( oCache.compile( sLine, strlen( sLine ), &oFirst, oError ) != NULL );
+	CHECK( oCache.get_Stats( ).iEvictions == 2 && oCache.get_Stats( ).iEntries == 1 );
+
+	// So is everything over budget.
+	oCache.compile( "+ 1 + 2", 7, &oFirst, oError );
+	oCache.set_Budget( 0 );
+	CHECK( oCache.get_Stats( ).iEvictions == 4 && oCache.get_Stats( ).iEntries == 0 );
+}
+
+// Known results in the exact integer mode, across the 64-bit boundary and
+// for both kinds of division.
+static void test_Integer( )
+{
+	IntegerCalculator oTruncate( INTEGER_DIVISION_TRUNCATE );
+	IntegerCalculator oFloor( INTEGER_DIVISION_FLOOR );
+	IntegerCalculator oExact( INTEGER_DIVISION_EXACT );
+	BatchOptions oOptions;
+	int iResult = 0;
+	auto fTruncate = [ &oTruncate ]( const BatchOptions& oRun ) { return run_Integer_Batch( oRun, oTruncate ); };
+	auto fFloor = [ &oFloor ]( const BatchOptions& oRun ) { return run_Integer_Batch( oRun, oFloor ); };
+	auto fExact = [ &oExact ]( const BatchOptions& oRun ) { return run_Integer_Batch( oRun, oExact ); };
+
+	CHECK( run_Script( "+ 123456789012345678901234567890\n* 987654321\n/ 7\n- 1\n", oOptions, fTruncate, iResult ) ==
+		   "123456789012345678901234567890\n"
+		   "121932631124828532112482853211126352690\n"
+		   "17418947303546933158926121887303764670\n"
+		   "17418947303546933158926121887303764669\n" );
+	CHECK( iResult == 0 );
+
+	oTruncate.clear_Value( );
+	CHECK( run_Script( "+ 9223372036854775807\n+ 1\n- 1\n- 9223372036854775807\n"
+					   "- 9223372036854775807\n- 2\n* -1\n* 18446744073709551616\n",
+					   oOptions, fTruncate, iResult ) ==
+		   "9223372036854775807\n9223372036854775808\n9223372036854775807\n0\n"
+		   "-9223372036854775807\n-9223372036854775809\n9223372036854775809\n"
+		   "170141183460469231750134047789593657344\n" );
+	CHECK( iResult == 0 );
+
+	oOptions.bFinalOnly = true;
+	oTruncate.clear_Value( );
+	CHECK( run_Script( "+ -7\n/ 2\n", oOptions, fTruncate, iResult ) == "-3\n" );
+	CHECK( run_Script( "+ -7\n/ 2\n", oOptions, fFloor, iResult ) == "-4\n" );
+	CHECK( iResult == 0 );
+
+	// Exact division refuses a remainder and keeps the working value.
+	CHECK( run_Script( "+ -7\n/ 2\n", oOptions, fExact, iResult ) == "-7\n" );
+	CHECK( iResult == 1 );
+}
+
+// Known results in the decimal mode, at the default precision and with
+// each way of rounding a tie.
+static void test_Decimal( )
+{
+	DecimalContext oDefault = { DECIMAL_DEFAULT_PRECISION, DECIMAL_ROUND_HALF_EVEN };
+	DecimalContext oHalfEven = { 1, DECIMAL_ROUND_HALF_EVEN };
+	DecimalContext oHalfUp = { 1, DECIMAL_ROUND_HALF_UP };
+	BatchOptions oOptions;
+	int iResult = 0;
+	auto fRun = [ & ]( const DecimalContext& oContext, const char* sScript )
+	{
+		DecimalCalculator oCalculator( oContext );
+
+		return run_Script( sScript, oOptions, [ &oCalculator ]( const BatchOptions& oRun )
+			{
+				return run_Decimal_Batch( oRun, oCalculator );
+			}, iResult );
+	};
+
+	CHECK( fRun( oDefault, "+ 1\n/ 3\n* 3\n+ 0.1\n+ 0.2\n" ) ==
+		   "1\n"
+		   "0.3333333333333333333333333333333333\n"
+		   "0.9999999999999999999999999999999999\n"
+		   "1.100000000000000000000000000000000\n"
+		   "1.300000000000000000000000000000000\n" );
+	CHECK( iResult == 0 );
+
+	CHECK( fRun( oDefault, "+ 0.1\n+ 0.2\n- 0.3\n" ) == "0.1\n0.3\n0.0\n" );
+	CHECK( fRun( oHalfEven, "+ 2.5\n+ 1\n" ) == "2\n3\n" );
+	CHECK( fRun( oHalfUp, "+ 2.5\n+ 1\n" ) == "3\n4\n" );
+	CHECK( iResult == 0 );
+}
+
+// Compiled lines give the same bits once they are native as they did in
+// the interpreter, including which NaN comes out when both operands are
+// NaNs with different payloads.
+static void test_Jit( )
+{
+	static const char* sLINES[] =
+	{
+		"= a + b", "= b + a", "= a - b", "= b - a", "= a * b", "= b * a", "= a / b", "= b / a",
+		"= (a + ans) * (b - mem)", "= -a + b * 2", "= mem / (ans - a) + b"
+	};
+	const double aPairs[][ 2 ] =
+	{
+		{ 1.5, -2.25 },
+		{ from_Bits( 0x7FF8000000000001ULL ), from_Bits( 0xFFF8000000000002ULL ) },
+		{ from_Bits( 0xFFF8000000000003ULL ), 1.0 },
+		{ 1.0, from_Bits( 0x7FF8000000000004ULL ) },
+		{ 1.0 / 0.0, -1.0 / 0.0 },
+		{ 0.0, -0.0 }
+	};
+
+	if( !is_Jit_Enabled( ) )
+	{
+		printf( "jit: the JIT is off in this build or environment, skipped.\n" );
+		return;
+	}
+
+	for( size_t iLine = 0; iLine < sizeof( sLINES ) / sizeof( sLINES[ 0 ] ); ++iLine )
+	{
+		for( size_t iPair = 0; iPair < sizeof( aPairs ) / sizeof( aPairs[ 0 ] ); ++iPair )
+		{
+			Calculator oCalculator;
+			Program oProgram;
+			CompileError oError;
+			double dInterpreted = 0.0;
+			double dNative = 0.0;
+
+			oCalculator.set_Var( oCalculator.intern_Variable( "a", 1 ), aPairs[ iPair ][ 0 ] );
+			oCalculator.set_Var( oCalculator.intern_Variable( "b", 1 ), aPairs[ iPair ][ 1 ] );
+			oCalculator.set_Value( aPairs[ iPair ][ 1 ] );
+			oCalculator.set_Mem( aPairs[ iPair ][ 0 ] );
+
+			CHECK( compile_Line( sLINES[ iLine ], strlen( sLINES[ iLine ] ), &oCalculator, oProgram, oError ) );
+			dInterpreted = oCalculator.evaluate_Program( oProgram );
+
+			for( unsigned int iRun = 1; iRun <= JIT_HOT_RUNS; ++iRun )
+				dNative = oCalculator.evaluate_Program( oProgram );
+
+			CHECK( oProgram.oTier.pNative != NULL );
+
+			if( !same_Bits( dInterpreted, dNative ) )
+				fprintf( stderr, "jit: \"%s\" with a = %.17g, b = %.17g\n", sLINES[ iLine ],
+						 aPairs[ iPair ][ 0 ], aPairs[ iPair ][ 1 ] );
+
+			CHECK( same_Bits( dInterpreted, dNative ) );
+		}
+	}
+}
+
+// Runs operations on a calculator from a working value and memory.
+static void run_Operations( const Operation* pOperations, size_t iCount, double dValue, double dMemory,
+							double& dFinal, double& dFinalMemory )
+{
+	Calculator oCalculator;
+
+	oCalculator.set_Value( dValue );
+	oCalculator.set_Mem( dMemory );
+
+	for( size_t i = 0; i < iCount; ++i )
+		oCalculator.apply_Operation( pOperations[ i ] );
+
+	dFinal = oCalculator.read_Value( );
+	dFinalMemory = oCalculator.pull_Mem( );
+}
+
+// The exact optimizer keeps every bit of the working value and memory,
+// for any working value, and says which rewrites may round differently.
+static void test_Optimizer( )
+{
+	static const unsigned char cOPS[] =
+	{
+		'+', '-', '*', '/', '+', '-', '*', '/', OP_CODE_SET, OP_CODE_RESET, OP_CODE_STORE,
+		'+' | OP_CODE_MEM_FLAG, '*' | OP_CODE_MEM_FLAG
+	};
+	const double aValues[] =
+	{
+		0.0, -0.0, 1.0, -1.0, 2.0, 0.5, 4.0, 0.25, 3.0, 0.1, 1e308, 5e-324, 1.0 / 0.0,
+		from_Bits( 0x7FF8000000000001ULL )
+	};
+	const size_t iValueCount = sizeof( aValues ) / sizeof( aValues[ 0 ] );
+	unsigned long long iState = TEST_SEED;
+	vector< Operation > vInput;
+	vector< Operation > vOutput;
+	vector< Rewrite > vRewrites;
+
+	for( unsigned int iStream = 0; iStream < OPTIMIZER_STREAMS; ++iStream )
+	{
+		size_t iLength = 1 + (size_t)( next_Random( iState ) % OPTIMIZER_MAX_LENGTH );
+
+		vInput.resize( iLength );
+
+		for( size_t i = 0; i < iLength; ++i )
+		{
+			vInput[ i ].cOpCode = cOPS[ next_Random( iState ) % sizeof( cOPS ) ];
+			vInput[ i ].dValue = aValues[ next_Random( iState ) % iValueCount ];
+			vInput[ i ].iSlot = 0;
+		}
+
+		optimize_Operations( vInput.data( ), vInput.size( ), OPTIMIZE_EXACT, vOutput, vRewrites );
+
+		for( size_t i = 0; i < vRewrites.size( ); ++i )
+			CHECK( vRewrites[ i ].bExact );
+
+		for( size_t iStart = 0; iStart < iValueCount; ++iStart )
+		{
+			double dExpected = 0.0, dExpectedMemory = 0.0;
+			double dOptimized = 0.0, dOptimizedMemory = 0.0;
+			double dMemory = aValues[ ( iStart + 3 ) % iValueCount ];
+
+			run_Operations( vInput.data( ), vInput.size( ), aValues[ iStart ], dMemory, dExpected, dExpectedMemory );
+			run_Operations( vOutput.data( ), vOutput.size( ), aValues[ iStart ], dMemory, dOptimized, dOptimizedMemory );
+
+			if( !same_Bits( dExpected, dOptimized ) || !same_Bits( dExpectedMemory, dOptimizedMemory ) )
+			{
+				fprintf( stderr, "optimizer: from %.17g, memory %.17g, got %.17g, %.17g instead of %.17g, %.17g for:\n",
+						 aValues[ iStart ], dMemory, dOptimized, dOptimizedMemory, dExpected, dExpectedMemory );
+				print_Operations( stderr, vInput.data( ), vInput.size( ) );
+				fputc( '\n', stderr );
+			}
+
+			CHECK( same_Bits( dExpected, dOptimized ) && same_Bits( dExpectedMemory, dOptimizedMemory ) );
+		}
+	}
+
+	// Division by a power of two is exact as a multiplication, by anything
+	// else only under fast math.
+	Operation oDivide;
+
+	oDivide.cOpCode = '/';
+	oDivide.dValue = 4.0;
+	oDivide.iSlot = 0;
+	optimize_Operations( &oDivide, 1, OPTIMIZE_EXACT, vOutput, vRewrites );
+	CHECK( vOutput.size( ) == 1 && vOutput[ 0 ].cOpCode == '*' && vOutput[ 0 ].dValue == 0.25 );
+	CHECK( vRewrites.size( ) == 1 && vRewrites[ 0 ].iKinds == REWRITE_RECIPROCAL && vRewrites[ 0 ].bExact );
+
+	oDivide.dValue = 3.0;
+	optimize_Operations( &oDivide, 1, OPTIMIZE_EXACT, vOutput, vRewrites );
+	CHECK( vOutput.size( ) == 1 && vOutput[ 0 ].cOpCode == '/' && vRewrites.empty( ) );
+
+	optimize_Operations( &oDivide, 1, OPTIMIZE_FAST_MATH, vOutput, vRewrites );
+	CHECK( vOutput.size( ) == 1 && vOutput[ 0 ].cOpCode == '*' );
+	CHECK( vRewrites.size( ) == 1 && !vRewrites[ 0 ].bExact );
+
+	// Compiled lines have their constants folded, exactly.
+	Calculator oCalculator;
+	Program oProgram;
+	CompileError oError;
+	ProgramRewrite oRewrite;
+
+	CHECK( compile_Line( "+ (2 * 3) / 8 + ans", 19, &oCalculator, oProgram, oError ) );
+	oRewrite = optimize_Program( oProgram, OPTIMIZE_EXACT );
+	CHECK( ( oRewrite.iKinds & REWRITE_FOLD ) != 0 && oRewrite.bExact );
+	oCalculator.set_Value( 0.5 );
+	CHECK( oCalculator.evaluate_Program( oProgram ) == 1.25 );
+}
+
+// Writes a session of JOURNAL_TEST_RECORDS operations into a fresh
+// session directory, returning the working value and memory after each.
+static bool write_Session( const string& sDirectory, vector< double >& vValues, vector< double >& vMemory )
+{
+	Calculator oCalculator;
+	Journal oJournal;
+	Operation oOperation;
+
+	filesystem::remove_all( sDirectory );
+	vValues.clear( );
+	vMemory.clear( );
+
+	if( !oJournal.open( sDirectory.c_str( ), &oCalculator ) )
+	{
+		fprintf( stderr, "journal: %s.\n", oJournal.get_Error( ) );
+		return false;
+	}
+
+	for( unsigned int i = 0; i < JOURNAL_TEST_RECORDS; ++i )
+	{
+		oOperation.cOpCode = i % 10 == 9 ? OP_CODE_STORE : "+-*/"[ i % 4 ];
+		oOperation.dValue = 1.0 + i * 0.125;
+		oOperation.iSlot = 0;
+
+		oCalculator.apply_Operation( oOperation );
+		oJournal.append( oOperation );
+		vValues.push_back( oCalculator.read_Value( ) );
+		vMemory.push_back( oCalculator.pull_Mem( ) );
+	}
+
+	return oJournal.close( );
+}
+
+// Recovers the session, checking that exactly iRecords records came back
+// and the calculator is where it was after the last of them.
+static void check_Recovery( const string& sDirectory, unsigned long long iRecords,
+							const vector< double >& vValues, const vector< double >& vMemory )
+{
+	Calculator oCalculator;
+	Journal oJournal;
+
+	CHECK( oJournal.open( sDirectory.c_str( ), &oCalculator ) );
+	CHECK( oJournal.get_Recovered( ) == iRecords );
+	CHECK( iRecords > 0 && same_Bits( oCalculator.read_Value( ), vValues[ iRecords - 1 ] ) );
+	CHECK( iRecords > 0 && same_Bits( oCalculator.pull_Mem( ), vMemory[ iRecords - 1 ] ) );
+	oJournal.close( );
+}
+
+// A journal cut off in the middle of a record, at a record boundary or
+// with a damaged record recovers everything before the damage.
+static void test_Journal( )
+{
+	string sDirectory = get_Temp_Path( "calctests_session" );
+	string sJournal = sDirectory + "/journal";
+	vector< double > vValues;
+	vector< double > vMemory;
+	uintmax_t iSize = 0;
+
+	CHECK( write_Session( sDirectory, vValues, vMemory ) );
+	iSize = filesystem::file_size( sJournal );
+	CHECK( iSize == JOURNAL_HEADER_SIZE + (uintmax_t) JOURNAL_TEST_RECORDS * JOURNAL_RECORD_SIZE );
+	check_Recovery( sDirectory, JOURNAL_TEST_RECORDS, vValues, vMemory );
+
+	// Torn in the middle of the last record.
+	CHECK( write_Session( sDirectory, vValues, vMemory ) );
+	filesystem::resize_file( sJournal, iSize - 5 );
+	check_Recovery( sDirectory, JOURNAL_TEST_RECORDS - 1, vValues, vMemory );
+
+	// Cut at a record boundary.
+	CHECK( write_Session( sDirectory, vValues, vMemory ) );
+	filesystem::resize_file( sJournal, iSize - 3 * JOURNAL_RECORD_SIZE );
+	check_Recovery( sDirectory, JOURNAL_TEST_RECORDS - 3, vValues, vMemory );
+
+	// A damaged operand ends recovery at the record before it.
+	CHECK( write_Session( sDirectory, vValues, vMemory ) );
+	FILE* pJournal = fopen( sJournal.c_str( ), "r+b" );
+
+	CHECK( pJournal != NULL );
+
+	if( pJournal != NULL )
+	{
+		fseek( pJournal, JOURNAL_HEADER_SIZE + 50 * JOURNAL_RECORD_SIZE + 12, SEEK_SET );
+		fputc( 0x5A, pJournal );
+		fclose( pJournal );
+	}
+
+	check_Recovery( sDirectory, 50, vValues, vMemory );
+
+	// The recovered session goes on from there.
+	CHECK( write_Session( sDirectory, vValues, vMemory ) );
+	filesystem::resize_file( sJournal, iSize - 5 );
+	{
+		Calculator oCalculator;
+		Journal oJournal;
+		Operation oOperation;
+
+		CHECK( oJournal.open( sDirectory.c_str( ), &oCalculator ) );
+		oOperation.cOpCode = '+';
+		oOperation.dValue = 1.0;
+		oOperation.iSlot = 0;
+		oCalculator.apply_Operation( oOperation );
+		oJournal.append( oOperation );
+		CHECK( oJournal.close( ) );
+	}
+	{
+		Calculator oCalculator;
+		Journal oJournal;
+
+		CHECK( oJournal.open( sDirectory.c_str( ), &oCalculator ) );
+		CHECK( same_Bits( oCalculator.read_Value( ), vValues[ JOURNAL_TEST_RECORDS - 2 ] + 1.0 ) );
+		oJournal.close( );
+	}
+
+	filesystem::remove_all( sDirectory );
+}
+
+// Checked runs reject a script that divides by zero or overflows, even
+// when the offending line's result is overwritten, and leave the
+// calculator as it was.
+static void test_Checked( )
+{
+	BatchOptions oOptions;
+	int iResult = 0;
+
+	oOptions.bChecked = true;
+	oOptions.bFinalOnly = true;
+
+	for( int iMode = 0; iMode < 3; ++iMode )
+	{
+		Calculator oCalculator;
+
+		oOptions.bPipelined = iMode == 1;
+		oOptions.bParallel = iMode == 2;
+
+		CHECK( run_Double( "+ 5\n/ 2\n", oOptions, &oCalculator, iResult ) == "2.5\n" );
+		CHECK( iResult == 0 );
+
+		CHECK( run_Double( "+ 5\n/ 0\nr\n+ 1\n", oOptions, &oCalculator, iResult ) == "" );
+		CHECK( iResult == 1 );
+		CHECK( oCalculator.read_Value( ) == 2.5 );
+
+		CHECK( run_Double( "r\n+ 1e308\n* 10\nr\n", oOptions, &oCalculator, iResult ) == "" );
+		CHECK( iResult == 1 );
+		CHECK( oCalculator.read_Value( ) == 2.5 );
+
+		// The memory and variables come back too, and the script is checked
+		// against the variables it started with.
+		unsigned int iKept = oCalculator.intern_Variable( "kept", 4 );
+		unsigned int iZero = oCalculator.intern_Variable( "zero", 4 );
+		unsigned int iAdded = 0;
+
+		oCalculator.set_Var( iKept, 4.0 );
+		oCalculator.set_Var( iZero, 0.0 );
+		oCalculator.set_Mem( 7.0 );
+
+		CHECK( run_Double( "s kept\ns added\ns\n+ 1\n/ zero\nr\n", oOptions, &oCalculator, iResult ) == "" );
+		CHECK( iResult == 1 );
+		CHECK( oCalculator.read_Value( ) == 2.5 && oCalculator.pull_Mem( ) == 7.0 );
+		CHECK( oCalculator.pull_Var( iKept ) == 4.0 && oCalculator.pull_Var( iZero ) == 0.0 );
+		CHECK( !oCalculator.find_Variable( "added", 5, iAdded ) || oCalculator.pull_Var( iAdded ) == 0.0 );
+	}
+}
+
+// Writes a script of plain lines, stores, variables and expressions, with
+// few enough distinct lines that they all get hot enough for the JIT.
+static string make_Pipeline_Script( )
+{
+	static const char* sLINES[] =
+	{
+		"+ 3", "* 1.0001", "- x%u * 0.001", "= (ans + x%u) / 2", "+ (2 * 3) / 7",
+		"s x%u", "/ (x%u + 1) * 0.5 + mem", "s", "+ mem", "- 1e-3"
+	};
+	unsigned long long iState = TEST_SEED;
+	string sScript = "+ pre\n";
+	char sLine[ 64 ];
+
+	for( unsigned int i = 0; i < 7; ++i )
+	{
+		snprintf( sLine, sizeof( sLine ), "+ 1\ns x%u\n", i );
+		sScript += sLine;
+	}
+
+	for( unsigned int i = 0; i < PIPELINE_TEST_LINES; ++i )
+	{
+		snprintf( sLine, sizeof( sLine ), sLINES[ next_Random( iState ) % 10 ], (unsigned int)( i % 7 ) );
+		sScript += sLine;
+		sScript += '\n';
+	}
+
+	return sScript;
+}
+
+// Sets up a calculator the way the pipeline tests start from: with a
+// variable from before the script.
+static void prepare_Calculator( Calculator& oCalculator )
+{
+	oCalculator.set_Var( oCalculator.intern_Variable( "pre", 3 ), 0.25 );
+}
+
+// The pipelined mode prints the same values as the serial one, with any
+// batch size and depth, and leaves the same variables behind.
+static void test_Pipeline( )
+{
+	static const unsigned int aBatchSizes[] = { 1, 7, PIPELINE_DEFAULT_BATCH };
+	string sScript = make_Pipeline_Script( );
+	Calculator oSerial;
+	BatchOptions oOptions;
+	string sExpected;
+	int iResult = 0;
+
+	prepare_Calculator( oSerial );
+	sExpected = run_Double( sScript, oOptions, &oSerial, iResult );
+	CHECK( iResult == 0 );
+	CHECK( !sExpected.empty( ) );
+
+	oOptions.bPipelined = true;
+
+	for( size_t i = 0; i < sizeof( aBatchSizes ) / sizeof( aBatchSizes[ 0 ] ); ++i )
+	{
+		for( unsigned int iDepth = 2; iDepth <= PIPELINE_DEFAULT_DEPTH; iDepth *= 4 )
+		{
+			Calculator oCalculator;
+
+			oOptions.iBatchSize = aBatchSizes[ i ];
+			oOptions.iPipelineDepth = iDepth;
+			prepare_Calculator( oCalculator );
+
+			CHECK( run_Double( sScript, oOptions, &oCalculator, iResult ) == sExpected );
+			CHECK( iResult == 0 );
+			CHECK( same_Bits( oCalculator.pull_Mem( ), oSerial.pull_Mem( ) ) );
+			CHECK( oCalculator.get_Variables( ).size( ) == oSerial.get_Variables( ).size( ) );
+
+			for( unsigned int iSlot = 0; iSlot < oSerial.get_Variables( ).size( ); ++iSlot )
+			{
+				const char* sName = oSerial.get_Variables( ).get_Name( iSlot );
+				unsigned int iFound = 0;
+
+				CHECK( oCalculator.find_Variable( sName, strlen( sName ), iFound ) && iFound == iSlot );
+				CHECK( same_Bits( oCalculator.pull_Var( iSlot ), oSerial.pull_Var( iSlot ) ) );
+			}
+		}
+	}
+
+	// A small cache keeps evicting while lines are in flight.
+	Calculator oCalculator;
+
+	oOptions.iCacheBudget = 600;
+	oOptions.iBatchSize = 7;
+	prepare_Calculator( oCalculator );
+	CHECK( run_Double( sScript, oOptions, &oCalculator, iResult ) == sExpected );
+	CHECK( iResult == 0 );
+}
+
+// Numbers the parsers share: special values, underflow and overflow.
+static void test_Numbers( )
+{
+	const char* sNumbers[] = { "nan", "-NaN", "inf", "-Infinity", "1e-400", "-1e-400", "4e-324", "1e-310", "1e400" };
+	double dValue = 0.0;
+	NumberResult oResult;
+
+	for( size_t i = 0; i < sizeof( sNumbers ) / sizeof( sNumbers[ 0 ] ); ++i )
+	{
+		dValue = 12.0;
+		oResult = parse_Double( sNumbers[ i ], sNumbers[ i ] + strlen( sNumbers[ i ] ), dValue );
+
+		if( i == 8 )
+			CHECK( oResult.eError == NUMBER_OUT_OF_RANGE && dValue == 12.0 );
+		else
+			CHECK( oResult.eError == NUMBER_OK && oResult.pEnd == sNumbers[ i ] + strlen( sNumbers[ i ] ) );
+
+		if( i == 0 || i == 1 )
+			CHECK( dValue != dValue );
+		else if( i == 2 || i == 3 )
+			CHECK( dValue == ( i == 2 ? 1.0 : -1.0 ) / 0.0 );
+		else if( i == 4 )
+			CHECK( same_Bits( dValue, 0.0 ) );
+		else if( i == 5 )
+			CHECK( same_Bits( dValue, -0.0 ) );
+		else if( i == 6 )
+			CHECK( same_Bits( dValue, from_Bits( 1 ) ) );
+		else if( i == 7 )
+			CHECK( dValue == 1e-310 );
+	}
+
+	// One sign, and only where the number starts.
+	const char* sSigned[] = { "--5", "+-5", "-+2", "++1", "-", "+", "-e5", "- 5" };
+
+	for( size_t i = 0; i < sizeof( sSigned ) / sizeof( sSigned[ 0 ] ); ++i )
+	{
+		dValue = 12.0;
+		oResult = parse_Double( sSigned[ i ], sSigned[ i ] + strlen( sSigned[ i ] ), dValue );
+		CHECK( oResult.eError == NUMBER_NO_DIGITS && oResult.pEnd == sSigned[ i ] + 1 && dValue == 12.0 );
+	}
+
+	CHECK( is_Special_Number( "INF", "INF" + 3 ) );
+	CHECK( !is_Special_Number( "info", "info" + 4 ) );
+
+	Calculator oCalculator;
+	BatchOptions oOptions;
+	int iResult = 0;
+
+	CHECK( run_Double( "+ inf\nr\n- -INF\nr\n+ 2 * infinity\nr\n+ 1e-400\n* -1e-400\n+ nan\n",
+					   oOptions, &oCalculator, iResult ) == "inf\n0\ninf\n0\ninf\n0\n0\n-0\nnan\n" );
+	CHECK( iResult == 0 );
+
+	// Lines and expressions take one sign per number too.
+	CHECK( run_Double( "r\n+ --5\n+ +-5\n- -+2\n= 1 - --2\n+ -.5\n= 2 - -(-3)\n", oOptions, &oCalculator, iResult ) ==
+		   "0\n-0.5\n-1\n" );
+	CHECK( iResult == 1 );
+}
+
+/*********************************************************************\
+ *	Main															 *
+\*********************************************************************/
+
+int main( int argc, char* argv[] )
+{
+	static const Test aTests[] =
+	{
+		{ "double", test_Double },
+		{ "parallel", test_Parallel },
+		{ "cache", test_Cache },
+		{ "integer", test_Integer },
+		{ "decimal", test_Decimal },
+		{ "jit", test_Jit },
+		{ "optimizer", test_Optimizer },
+		{ "journal", test_Journal },
+		{ "checked", test_Checked },
+		{ "pipeline", test_Pipeline },
+		{ "numbers", test_Numbers }
+	};
+	bool bFound = false;
+
+	if( argc > 2 )
+	{
+		fprintf( stderr, "Usage: %s [test]\n", argv[ 0 ] );
+		return 1;
+	}
+
+	for( size_t i = 0; i < sizeof( aTests ) / sizeof( aTests[ 0 ] ); ++i )
+	{
+		if( argc == 2 && strcmp( argv[ 1 ], aTests[ i ].sName ) )
+			continue;
+
+		unsigned long long iBefore = iFailures;
+
+		bFound = true;
+		aTests[ i ].fRun( );
+		printf( "%s: %s\n", aTests[ i ].sName, iFailures == iBefore ? "passed" : "FAILED" );
+	}
+
+	if( !bFound )
+	{
+		fprintf( stderr, "No test is named \"%s\".\n", argv[ 1 ] );
+		return 1;
+	}
+
+	printf( "%llu checks, %llu failed.\n", iChecks, iFailures );
+	return iFailures == 0 ? 0 : 1;
+}